@@ -0,0 +1,40 @@
+#define HLSL
+#include "RaytracingHlslCompat.h"
+#include "AdaptiveSampling.hlsli"
+
+RWTexture2D<float4> gMoments : register(u0);
+RWBuffer<uint> gTileActive : register(u1);
+ConstantBuffer<PerFrameConstants> perFrameConstants : register(b0);
+
+groupshared float gSquaredErrors[ADAPTIVE_TILE_SIZE * ADAPTIVE_TILE_SIZE];
+
+// One group per tile. A tile stays active while the root mean square of its pixel errors is above the
+// threshold, converged tiles are skipped by the ray generation shader.
+[numthreads(ADAPTIVE_TILE_SIZE, ADAPTIVE_TILE_SIZE, 1)]
+void main(uint3 dispatchID : SV_DispatchThreadID, uint3 groupID : SV_GroupID, uint groupIndex : SV_GroupIndex)
+{
+    uint2 dims;
+    gMoments.GetDimensions(dims.x, dims.y);
+
+    float error = 0.0;
+    if (all(dispatchID.xy < dims)) {
+        error = estimatePixelError(gMoments[dispatchID.xy]);
+    }
+    gSquaredErrors[groupIndex] = error * error;
+    GroupMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint stride = ADAPTIVE_TILE_SIZE * ADAPTIVE_TILE_SIZE / 2; stride > 0; stride >>= 1) {
+        if (groupIndex < stride) {
+            gSquaredErrors[groupIndex] += gSquaredErrors[groupIndex + stride];
+        }
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    if (groupIndex == 0) {
+        uint2 tileStart = groupID.xy * ADAPTIVE_TILE_SIZE;
+        uint2 tileSize = min(ADAPTIVE_TILE_SIZE, dims - tileStart);
+        float tileError = sqrt(gSquaredErrors[0] / float(tileSize.x * tileSize.y));
+        gTileActive[getAdaptiveTileIndex(tileStart, dims)] = tileError > perFrameConstants.options.adaptiveErrorThreshold ? 1 : 0;
+    }
+}
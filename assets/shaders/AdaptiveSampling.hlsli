@@ -0,0 +1,43 @@
+#ifndef ADAPTIVE_SAMPLING_HLSLI
+#define ADAPTIVE_SAMPLING_HLSLI
+
+// Pixels per side of the tiles that are sampled or skipped together, the tile size of the CPU backend as well
+#define ADAPTIVE_TILE_SIZE 16
+
+// Noise in dark pixels is measured against at least this much luminance, it is invisible on screen
+#define ADAPTIVE_ERROR_BIAS 0.05
+
+float adaptiveLuminance(float3 color)
+{
+    return dot(color, float3(0.2126, 0.7152, 0.0722));
+}
+
+// Moments are the mean luminance, the sum of squared deviations from it and the sample count, updated
+// with Welford's method so the variance of bright converged pixels does not cancel out
+float4 accumulateMoments(float4 moments, float3 color)
+{
+    float luminance = adaptiveLuminance(color);
+    float n = moments.z + 1.0;
+    float delta = luminance - moments.x;
+    float mean = moments.x + delta / n;
+    return float4(mean, moments.y + delta * (luminance - mean), n, 0.0);
+}
+
+// Standard error of the mean luminance relative to the mean
+float estimatePixelError(float4 moments)
+{
+    float n = moments.z;
+    if (n < 2.0) {
+        return 1.0e+6;
+    }
+    float variance = moments.y / (n - 1.0);
+    return sqrt(variance / n) / (moments.x + ADAPTIVE_ERROR_BIAS);
+}
+
+uint getAdaptiveTileIndex(uint2 pixel, uint2 dims)
+{
+    uint tilesX = (dims.x + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE;
+    return (pixel.y / ADAPTIVE_TILE_SIZE) * tilesX + pixel.x / ADAPTIVE_TILE_SIZE;
+}
+
+#endif // ADAPTIVE_SAMPLING_HLSLI
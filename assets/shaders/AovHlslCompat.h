@@ -0,0 +1,73 @@
+#ifndef AOVHLSLCOMPAT_H
+#define AOVHLSLCOMPAT_H
+
+// AOVs of the realtime pipeline's primary hits, written by the ray generation of RealtimeRaytracing.hlsl
+// and read by temporal accumulation and the denoiser. Shared with the pipeline and the CPU tests. Written
+// in the common subset of HLSL and C++.
+//
+// Every AOV is stored in the smallest format its consumers tolerate:
+//     AOV_DEPTH        R16_FLOAT        view depth, negative for misses
+//     AOV_NORMAL       R16G16_SNORM     world space normal, octahedral
+//     AOV_ALBEDO       R8G8B8A8_UNORM   albedo with the roughness in alpha, white for misses
+//     AOV_MOTION       R16G16_FLOAT     pixels from the position in this frame to that in the last
+//     AOV_INSTANCE_ID  R16_UINT         InstanceIndex() of the hit, AOV_INSTANCE_ID_MISS for misses
+// DebugOptions::aovMask selects the AOVs the ray generation writes.
+
+#ifdef HLSL
+#define AOV_FUNCTION
+#else
+#include "Cpu/CpuMath.h"
+#include <cmath>
+#include <cstdint>
+
+namespace Aov
+{
+    using namespace DXRFramework::CpuMath;
+
+    inline float abs(float x) { return std::fabs(x); }
+
+#define AOV_FUNCTION inline
+#endif
+
+#define AOV_DEPTH 0
+#define AOV_NORMAL 1
+#define AOV_ALBEDO 2
+#define AOV_MOTION 3
+#define AOV_INSTANCE_ID 4
+#define AOV_COUNT 5
+
+#define AOV_BIT(aov) (1u << (aov))
+// Temporal accumulation finds the surfaces of its history by depth and normal
+#define AOV_TEMPORAL_MASK (AOV_BIT(AOV_DEPTH) | AOV_BIT(AOV_NORMAL))
+#define AOV_ALL_MASK ((1u << AOV_COUNT) - 1u)
+
+#define AOV_INSTANCE_ID_MISS 0xffffu
+
+// Octahedral mapping of a unit vector to [-1, 1]^2 (Cigolle et al. 2014, "A survey of efficient
+// representations for independent unit vectors")
+AOV_FUNCTION float2 aovEncodeNormal(float3 n)
+{
+    n = n / (abs(n.x) + abs(n.y) + abs(n.z));
+    if (n.z >= 0.0f) {
+        return float2(n.x, n.y);
+    }
+    return float2((1.0f - abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f), (1.0f - abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+}
+
+AOV_FUNCTION float3 aovDecodeNormal(float2 p)
+{
+    float3 n = float3(p.x, p.y, 1.0f - abs(p.x) - abs(p.y));
+    float t = n.z < 0.0f ? -n.z : 0.0f;
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return normalize(n);
+}
+
+#ifndef HLSL
+    // Bytes per pixel of the formats above, for the bandwidth the AOVs cost
+    const uint32_t kAovBytesPerPixel[AOV_COUNT] = { 2, 4, 4, 4, 2 };
+    const char *const kAovNames[AOV_COUNT] = { "Depth", "Normal", "Albedo", "Motion", "Instance ID" };
+}
+#endif
+
+#endif // AOVHLSLCOMPAT_H
@@ -0,0 +1,88 @@
+#ifndef ATROUSHLSLCOMPAT_H
+#define ATROUSHLSLCOMPAT_H
+
+// Edge-avoiding a-trous wavelet filter of the denoiser, shared by DenoiseCompositorAtrous.hlsl and the
+// CPU tests. Written in the common subset of HLSL and C++.
+//
+// Every iteration convolves the image with a 5x5 B3 spline kernel whose taps are 2^i pixels apart, so
+// five iterations cover 125x125 pixels with 25 taps each (Dammertz et al. 2010, "Edge-avoiding a-trous
+// wavelet transform for fast global illumination filtering"). Taps are weighted down across depth and
+// normal edges and where their luminance differs from the pixel's by more than its standard deviation
+// allows. The variance of a pixel comes from the temporal moments of its luminance and is filtered
+// along with the color, so later iterations blur less where the earlier ones removed the noise (Schied
+// et al. 2017, "Spatiotemporal variance-guided filtering").
+
+#ifdef HLSL
+#define ATROUS_FUNCTION
+#else
+#include "Cpu/CpuMath.h"
+#include <cmath>
+
+namespace Atrous
+{
+    using namespace DXRFramework::CpuMath;
+
+    inline float abs(float x) { return std::fabs(x); }
+    inline float exp(float x) { return std::exp(x); }
+    inline float pow(float x, float y) { return std::pow(x, y); }
+    inline float sqrt(float x) { return std::sqrt(x); }
+
+#define ATROUS_FUNCTION inline
+#endif
+
+#define ATROUS_KERNEL_RADIUS 2
+#define ATROUS_MAX_ITERATIONS 5
+
+// Weight of a tap of the B3 spline kernel along one axis, d in [-2, 2]
+ATROUS_FUNCTION float atrousKernelWeight(int d)
+{
+    return d == 0 ? 0.375f : (d == 1 || d == -1 ? 0.25f : 0.0625f);
+}
+
+// Weight of a tap of the 3x3 Gaussian that smooths the variance before the luminance test
+ATROUS_FUNCTION float atrousVarianceKernelWeight(int dx, int dy)
+{
+    return (dx == 0 ? 0.5f : 0.25f) * (dy == 0 ? 0.5f : 0.25f);
+}
+
+ATROUS_FUNCTION float atrousLuminance(float3 color)
+{
+    return dot(color, float3(0.2126f, 0.7152f, 0.0722f));
+}
+
+// Edge-stopping weight of a tap. depthGradient is the change of view depth per pixel at the pixel,
+// offsetLength the distance of the tap in pixels and luminanceSigma the smoothed standard deviation of
+// the pixel's luminance. The phis set how sharply each term falls off, larger is sharper for normals
+// and softer for depth and luminance.
+ATROUS_FUNCTION float atrousEdgeWeight(float3 normal, float3 tapNormal, float depth, float tapDepth, float depthGradient, float offsetLength,
+                                       float luminance, float tapLuminance, float luminanceSigma, float phiNormal, float phiDepth, float phiLuminance)
+{
+    float NoN = dot(normal, tapNormal);
+    float normalWeight = NoN > 0.0f ? pow(NoN, phiNormal) : 0.0f;
+    float depthTerm = abs(depth - tapDepth) / (phiDepth * depthGradient * offsetLength + 1.0e-3f * depth + 1.0e-6f);
+    float luminanceTerm = abs(luminance - tapLuminance) / (phiLuminance * luminanceSigma + 1.0e-6f);
+    return normalWeight * exp(-depthTerm - luminanceTerm);
+}
+
+// The direct lighting is filtered divided by the albedo of the primary hits, so texture detail is not
+// mistaken for noise. Channels darker than this are divided by it instead.
+#define ATROUS_MIN_ALBEDO 0.01f
+
+ATROUS_FUNCTION float3 atrousDemodulationFactor(float3 albedo)
+{
+    return float3(albedo.x > ATROUS_MIN_ALBEDO ? albedo.x : ATROUS_MIN_ALBEDO, albedo.y > ATROUS_MIN_ALBEDO ? albedo.y : ATROUS_MIN_ALBEDO,
+                  albedo.z > ATROUS_MIN_ALBEDO ? albedo.z : ATROUS_MIN_ALBEDO);
+}
+
+// Variance of a sample from moments of its luminance, the mean and the mean of squares
+ATROUS_FUNCTION float varianceFromMoments(float mean, float meanOfSquares)
+{
+    float variance = meanOfSquares - mean * mean;
+    return variance > 0.0f ? variance : 0.0f;
+}
+
+#ifndef HLSL
+}
+#endif
+
+#endif // ATROUSHLSLCOMPAT_H
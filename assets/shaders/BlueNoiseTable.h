@@ -0,0 +1,526 @@
+#ifndef BLUENOISETABLE_H
+#define BLUENOISETABLE_H
+
+// 64x64 blue noise masks made with the void-and-cluster method (Ulichney 1993) on a torus, with a
+// Gaussian of sigma 1.9 texels. Every texel holds its rank 0..4095 in two independent masks, the first
+// in the low 16 bits. Included by SamplingHlslCompat.h and valid as both HLSL and C++.
+
+#define BLUE_NOISE_SIZE 64
+
+static const uint BLUE_NOISE_RANKS[BLUE_NOISE_SIZE * BLUE_NOISE_SIZE] =
+{
+    0x0a8102a3u, 0x08f105e7u, 0x0edb0950u, 0x0707038du, 0x04880e06u, 0x06310262u, 0x011c0497u, 0x056206ecu,
+    0x071a0966u, 0x0bdf0b7fu, 0x0f9301d6u, 0x06ab08bcu, 0x023b0bedu, 0x08ea0d1du, 0x0e050512u, 0x03aa0242u,
+    0x08360f72u, 0x09b2044du, 0x0e740348u, 0x00590d6eu, 0x0bd8087du, 0x04ee0653u, 0x093e0410u, 0x01a70a35u,
+    0x07bc0333u, 0x0c600697u, 0x022701a8u, 0x056005c9u, 0x0a4b02f7u, 0x045d03d4u, 0x0e200d87u, 0x00d50603u,
+    0x0d3801c6u, 0x0b060a0bu, 0x04fc0427u, 0x0e270bd7u, 0x02f60375u, 0x003c09b4u, 0x0a530f12u, 0x05a70c0cu,
+    0x076a02dfu, 0x0eba0af4u, 0x0982099fu, 0x029d07cfu, 0x07090b83u, 0x017c08ccu, 0x0cdb09d8u, 0x0b4a0dadu,
+    0x021c01ecu, 0x003e0a46u, 0x053f0627u, 0x0878036fu, 0x03b20036u, 0x0e9f0471u, 0x08210a56u, 0x057c05a9u,
+    0x04190f39u, 0x0014096bu, 0x02a7052cu, 0x0bd0000bu, 0x044a0c61u, 0x0a13060fu, 0x0e4e0afdu, 0x0293008eu,
+    0x01390dcdu, 0x0b4f04e4u, 0x02f40ba0u, 0x08590f69u, 0x0c14066eu, 0x0f9c0ae5u, 0x03490f22u, 0x0afb0cf6u,
+    0x0e510e4au, 0x099100f5u, 0x07f90a92u, 0x01520387u, 0x0d3709a2u, 0x053200cfu, 0x07080e7fu, 0x0c2d067au,
+    0x01290917u, 0x048a0a50u, 0x0da20c39u, 0x05db0554u, 0x0a3601cdu, 0x02e20fcdu, 0x0b4c0e41u, 0x0dfd07adu,
+    0x00040918u, 0x04120f6du, 0x09670aefu, 0x0bac0c2bu, 0x008e0971u, 0x079d06cdu, 0x0bf70b82u, 0x059904bau,
+    0x08aa006fu, 0x0fab0cd4u, 0x07840573u, 0x0b8208d3u, 0x043c0037u, 0x08db0d3bu, 0x0f48078fu, 0x0beb05d8u,
+    0x03340e52u, 0x00fd0cd3u, 0x0ac5038eu, 0x0e5f0f78u, 0x0bb00d46u, 0x03ba0143u, 0x0fea0c8cu, 0x04930516u,
+    0x095f07fdu, 0x0d910121u, 0x031204ceu, 0x0c860b2bu, 0x00a7076au, 0x0b640d52u, 0x06fd0c71u, 0x0c400877u,
+    0x0ffa03e6u, 0x09ca01e0u, 0x07630eb5u, 0x05a608c5u, 0x01a90456u, 0x07f50199u, 0x063909ffu, 0x0f6b06eeu,
+    0x077e0896u, 0x0d840151u, 0x03c707c1u, 0x0e290c6bu, 0x004e001cu, 0x09ae0901u, 0x07b601aau, 0x0cf305f1u,
+    0x01f6041fu, 0x04bc07c6u, 0x05f40661u, 0x03680f44u, 0x0b3c0750u, 0x09fb02d4u, 0x00330841u, 0x02cc0b77u,
+    0x0f0d003eu, 0x0b0f0194u, 0x024407f2u, 0x079e06cau, 0x0fd40b27u, 0x044109cau, 0x0cba002eu, 0x085b0be0u,
+    0x0f51013du, 0x0ada0459u, 0x05fd088eu, 0x0ff00092u, 0x0cf00d00u, 0x0284021cu, 0x0eef0e51u, 0x0ab20834u,
+    0x030f0341u, 0x06930fabu, 0x01690ad8u, 0x099a0e0au, 0x06180657u, 0x0de701cbu, 0x04d50a89u, 0x01a103e2u,
+    0x0d5f00a2u, 0x07d808ddu, 0x0548050au, 0x0453021fu, 0x08a20748u, 0x0a24060eu, 0x00cd03c0u, 0x060706f2u,
+    0x0ab10fc2u, 0x0ed6094cu, 0x07880df4u, 0x0faa08a3u, 0x05f70f08u, 0x09fd020cu, 0x04b0067du, 0x02160114u,
+    0x0db70d95u, 0x0646074eu, 0x0b400cd6u, 0x0f570694u, 0x0e0a0bcfu, 0x03250e4fu, 0x0c1f0fe8u, 0x052f034eu,
+    0x09c30cddu, 0x06790ee3u, 0x01c6023du, 0x058b0416u, 0x0acc0570u, 0x02650a2fu, 0x0454034au, 0x08e30898u,
+    0x00ab029cu, 0x0ed20c1eu, 0x0c530df0u, 0x086d04b4u, 0x0dc90ce5u, 0x0ff80ac0u, 0x07960439u, 0x0cb80d86u,
+    0x08c205edu, 0x065e0e26u, 0x0d260f4cu, 0x0926029bu, 0x01c00d11u, 0x06e70396u, 0x00f404f6u, 0x066605efu,
+    0x050f0cc6u, 0x03050e16u, 0x08c50746u, 0x013a055eu, 0x03ae0fd8u, 0x06770a7au, 0x0936010cu, 0x048e091au,
+    0x00660c32u, 0x0c8106efu, 0x0ea6024eu, 0x024907d8u, 0x0c270491u, 0x00ca0b85u, 0x0aea0fbfu, 0x08710265u,
+    0x09f00a16u, 0x0fb50698u, 0x0c730eb0u, 0x01e000e3u, 0x06750a49u, 0x0d510effu, 0x03230b06u, 0x0c3f0011u,
+    0x06de0be4u, 0x013202c5u, 0x043b0ca5u, 0x0a6700b9u, 0x028e0569u, 0x0d3a09a8u, 0x08c90307u, 0x034e0b00u,
+    0x012704e0u, 0x094009edu, 0x03c6033cu, 0x009b0aa3u, 0x0a690271u, 0x08d207a8u, 0x0d3c0543u, 0x002c0b54u,
+    0x0fe30648u, 0x0c9209acu, 0x09330ab8u, 0x0f13072fu, 0x074a0d7au, 0x0c6d0fbbu, 0x0df90cb7u, 0x068d0b4au,
+    0x0b5e0ec6u, 0x02e409e8u, 0x09d00034u, 0x00ec0213u, 0x047005b8u, 0x01d2011fu, 0x05b90f91u, 0x03f509beu,
+    0x0a620384u, 0x05020bc4u, 0x009204aau, 0x039000d4u, 0x0c3b08f9u, 0x0a970755u, 0x0ecf0ebbu, 0x02700abbu,
+    0x09fa02ecu, 0x0d4a01d8u, 0x0e570a27u, 0x070b0371u, 0x0b3707e0u, 0x0dd30431u, 0x01d10662u, 0x08220524u,
+    0x0d6b0eb2u, 0x0a0809dbu, 0x054600aau, 0x03df0eebu, 0x07e7032au, 0x0ee20937u, 0x07020c65u, 0x02760561u,
+    0x064f081fu, 0x039b0da4u, 0x00750b57u, 0x09540c27u, 0x0f2004a6u, 0x07ac026bu, 0x0e1e0897u, 0x086a0e4cu,
+    0x023e05bfu, 0x05310438u, 0x090506abu, 0x0bf60a80u, 0x017d03b4u, 0x0e2d0bd5u, 0x074d0e1eu, 0x0edc0faeu,
+    0x0be90800u, 0x08410059u, 0x0cfe0f49u, 0x04df05b0u, 0x023a00e4u, 0x06f40976u, 0x0b0703ffu, 0x04680050u,
+    0x080b01dbu, 0x0288049fu, 0x0ba20df6u, 0x048f02d6u, 0x00f00104u, 0x0a2807f3u, 0x038304adu, 0x0fc4017eu,
+    0x05ac070du, 0x0d610549u, 0x074c082cu, 0x0f430b0fu, 0x06780929u, 0x09480c43u, 0x0bb807b0u, 0x0e80025au,
+    0x015a070fu, 0x0df008a6u, 0x0b620aa1u, 0x0f4005c0u, 0x05960de6u, 0x08910c41u, 0x0daf0226u, 0x07900863u,
+    0x0b9e0f56u, 0x01b7066bu, 0x04730b9cu, 0x08030dcfu, 0x09a90270u, 0x05170ef5u, 0x0c290b35u, 0x0f860d57u,
+    0x03640156u, 0x06f603c8u, 0x08e405d2u, 0x0dac0cbfu, 0x0a420854u, 0x0330010du, 0x0d0006f7u, 0x04860e40u,
+    0x0b800452u, 0x0dc3017du, 0x05c30334u, 0x0b2007aeu, 0x027d0958u, 0x04f20d61u, 0x0008035fu, 0x0b7a0a06u,
+    0x0e7f07dau, 0x0d200214u, 0x0f4b0d84u, 0x07dc0f73u, 0x03bc018du, 0x05b70730u, 0x003b08f6u, 0x0ae705f7u,
+    0x05590240u, 0x02b50b84u, 0x0e520dfau, 0x07b2089au, 0x0f230c90u, 0x05e20d76u, 0x01860e99u, 0x037b0831u,
+    0x0a490c53u, 0x00ad0f30u, 0x061408c9u, 0x08ad05dbu, 0x0d680be3u, 0x05530978u, 0x017e0679u, 0x0828009au,
+    0x00050dbfu, 0x0a7f039bu, 0x03e40fecu, 0x024b0d35u, 0x0af306b1u, 0x0cdf0346u, 0x032e0e9du, 0x08550538u,
+    0x027b01b8u, 0x06b30cb2u, 0x07e50edbu, 0x09980314u, 0x02cd0a1fu, 0x04b90169u, 0x0051044fu, 0x03b006ddu,
+    0x05da099bu, 0x0c780076u, 0x00b904ebu, 0x0f39090du, 0x02d30c40u, 0x003d0002u, 0x0a6309abu, 0x05e602c0u,
+    0x01150783u, 0x0baa0befu, 0x01f20a55u, 0x0fe10da7u, 0x00110508u, 0x059a0f5cu, 0x09640ab6u, 0x0f5a0019u,
+    0x00f20d02u, 0x08af0923u, 0x0ebb05e5u, 0x07250fedu, 0x0cb50062u, 0x0a880565u, 0x04030c5bu, 0x05d3015au,
+    0x09ab0ecbu, 0x033b0b76u, 0x008c097au, 0x068a0845u, 0x0b5f04a8u, 0x09830cc4u, 0x0f6700dbu, 0x04520449u,
+    0x09e70d0eu, 0x069c06fdu, 0x00d6039fu, 0x0c5e04b3u, 0x094f015eu, 0x0b920715u, 0x0d9b02eeu, 0x0e8d0a40u,
+    0x06df06c5u, 0x0cf80381u, 0x0ed30085u, 0x031d0b15u, 0x0b0c0e7du, 0x0f3b03bau, 0x07010f0eu, 0x09790aa9u,
+    0x0c280c60u, 0x04e908c7u, 0x08be0274u, 0x0e310451u, 0x05390e31u, 0x009d007du, 0x071c0a02u, 0x09cb0b46u,
+    0x0fb00d62u, 0x0bfd00acu, 0x043203feu, 0x010a067fu, 0x0e3507c8u, 0x0cb40fa2u, 0x0b040b3eu, 0x09800d73u,
+    0x0fc303a1u, 0x08660e7eu, 0x0a9e0ce0u, 0x05a00182u, 0x0d07070eu, 0x0e9c05abu, 0x04180864u, 0x07b00e1fu,
+    0x0e42049cu, 0x0abf08e1u, 0x049906a6u, 0x0654017fu, 0x0c9c02a5u, 0x018309a3u, 0x0c0b0630u, 0x07c103a7u,
+    0x020e0b2cu, 0x0a3b0f15u, 0x043a0278u, 0x02fe0706u, 0x015c0aedu, 0x0fce0e11u, 0x08e20681u, 0x01b90483u,
+    0x072f0738u, 0x0ac9009du, 0x04970319u, 0x0c8a0614u, 0x0dce0e49u, 0x02090ae8u, 0x080c02ccu, 0x0cea0ed7u,
+    0x018e0a6du, 0x0fca01a1u, 0x0aa509aau, 0x041f0656u, 0x030d0aeau, 0x01120bf8u, 0x08720f85u, 0x05660589u,
+    0x01ce0b8bu, 0x03d30d49u, 0x099c0761u, 0x07a6018cu, 0x0213050bu, 0x042f0cd5u, 0x0e1c02a0u, 0x02bc07b4u,
+    0x0d1c05cbu, 0x0ef101b5u, 0x01230bc6u, 0x0bde0a7eu, 0x07f40166u, 0x0d7e0609u, 0x0ee108d7u, 0x04c6046eu,
+    0x001c0fcbu, 0x05b2080du, 0x0d530980u, 0x0a510c05u, 0x074b0022u, 0x06370537u, 0x014f0925u, 0x0e700106u,
+    0x06dc05b9u, 0x02070a47u, 0x0354081eu, 0x0bd30444u, 0x07620ae0u, 0x06820f4bu, 0x022c039au, 0x09110c7au,
+    0x0cd301feu, 0x02b70ff4u, 0x08840b07u, 0x077b0e7au, 0x0b170434u, 0x041a0bc0u, 0x0e2a078eu, 0x06b90219u,
+    0x052c0873u, 0x0d630510u, 0x0bed0a33u, 0x08260c9du, 0x09e803edu, 0x06650203u, 0x0de30868u, 0x0c040f92u,
+    0x0ee40a9cu, 0x08380d0au, 0x01160540u, 0x0a000c34u, 0x02df0042u, 0x050d0796u, 0x06ed0968u, 0x0c020564u,
+    0x03870862u, 0x08ef0c14u, 0x059e0fd9u, 0x07550e3eu, 0x0e0f0250u, 0x09f508d1u, 0x047e0455u, 0x0c110119u,
+    0x0ad7028bu, 0x0e00095du, 0x05040fdfu, 0x004a084fu, 0x0c990a44u, 0x087701f0u, 0x0b9508feu, 0x06430470u,
+    0x01e30f75u, 0x078f09b8u, 0x03790741u, 0x0a1b0523u, 0x05e507fcu, 0x01c20f57u, 0x03d40c17u, 0x0aab06c6u,
+    0x0c9402eau, 0x08d70580u, 0x035c0ae7u, 0x01f10252u, 0x0f920d0cu, 0x09040e43u, 0x029202fdu, 0x04550c88u,
+    0x0d4e077cu, 0x05340258u, 0x093c0fc5u, 0x0e0e0309u, 0x00ee0d3eu, 0x0b440651u, 0x09ec012au, 0x0f1f0a67u,
+    0x053a0577u, 0x00d00045u, 0x0d830353u, 0x035107beu, 0x0ef80ca4u, 0x0919011eu, 0x029e0edcu, 0x0a920d90u,
+    0x038b0c2cu, 0x0047008fu, 0x0e630e65u, 0x058507f9u, 0x00e30124u, 0x0d4509b9u, 0x03690b9au, 0x05380293u,
+    0x02910915u, 0x0ccd03d5u, 0x0fad0ef7u, 0x061c0a10u, 0x0e600260u, 0x089a0fa4u, 0x00770673u, 0x0e9d0dd6u,
+    0x027a03fau, 0x0b750073u, 0x0d3d031eu, 0x0019052eu, 0x0f3a0784u, 0x066d003bu, 0x029009efu, 0x0f890de3u,
+    0x08f704efu, 0x07530ab2u, 0x0bc6040eu, 0x0fd2060bu, 0x0a500e28u, 0x057a06eau, 0x01190d7du, 0x0a050b24u,
+    0x047d0049u, 0x0b2d0e67u, 0x069b030au, 0x0fdd0dacu, 0x02d50cb0u, 0x096303a5u, 0x0b8c0239u, 0x06530a54u,
+    0x023900f1u, 0x07990df1u, 0x0ecd0f02u, 0x0b420728u, 0x051a049bu, 0x0c460884u, 0x082e062fu, 0x0b8f0ef0u,
+    0x0a110ab1u, 0x00160c15u, 0x0f6c050fu, 0x040608f1u, 0x08a400c5u, 0x04da0ba7u, 0x01490e8du, 0x03a20731u,
+    0x0c4a0951u, 0x06e00d4fu, 0x0e8b063cu, 0x09b908adu, 0x00850a17u, 0x05ce05aau, 0x084204bdu, 0x0fc00955u,
+    0x0b6506c1u, 0x098d034fu, 0x0711061cu, 0x0f610490u, 0x04820f42u, 0x0b340cffu, 0x07d30591u, 0x004f00cbu,
+    0x06d30db7u, 0x03f6063eu, 0x092b0135u, 0x017a0892u, 0x0b1b0b65u, 0x03c40388u, 0x0a750c93u, 0x0d820115u,
+    0x06440b45u, 0x07c607e1u, 0x04bf0d67u, 0x0203093bu, 0x0b140ce9u, 0x0ca70ebeu, 0x07cb062eu, 0x008607ebu,
+    0x035701e8u, 0x062a0d19u, 0x014b0010u, 0x02d8031bu, 0x06900ba9u, 0x0e5900e0u, 0x0399057au, 0x0f7d036eu,
+    0x09180c85u, 0x0db1064eu, 0x0041012bu, 0x0c5f0940u, 0x0e690b0eu, 0x086b0007u, 0x00c40e7cu, 0x0f80079fu,
+    0x0d950c8bu, 0x0a070904u, 0x00e70185u, 0x06bb037eu, 0x03ef0a41u, 0x00a80b89u, 0x0f0f01bdu, 0x0322040cu,
+    0x07a80055u, 0x062006a0u, 0x0a7701ddu, 0x025e0e03u, 0x0c8c09d2u, 0x0d7c07e3u, 0x0fbd04d9u, 0x07db02b1u,
+    0x0a6e0f68u, 0x06020b3au, 0x01e8022fu, 0x0bdd0e01u, 0x04dc007au, 0x0d0f0f8du, 0x012402cdu, 0x0c5b0aadu,
+    0x062301a4u, 0x019b0ddfu, 0x02ad0b52u, 0x08d308f5u, 0x0c7c02e7u, 0x02280754u, 0x097f0ea5u, 0x0aa7036au,
+    0x0e1507e8u, 0x0b9b0bf4u, 0x04eb06f1u, 0x079c044bu, 0x0c420d56u, 0x0f330515u, 0x056d01e6u, 0x09430722u,
+    0x015009e0u, 0x0a0c0f19u, 0x0ec905ccu, 0x08b201b9u, 0x033e0426u, 0x097d0b10u, 0x05ab035bu, 0x0d760f37u,
+    0x0eb708dau, 0x046f069au, 0x0cda0e8au, 0x093f0c72u, 0x0812093au, 0x0d500f9cu, 0x009e0798u, 0x0c4709feu,
+    0x05aa086cu, 0x0801043cu, 0x02420efbu, 0x052606d6u, 0x044704b1u, 0x0d0208a2u, 0x075a05e3u, 0x05550412u,
+    0x030e0b78u, 0x048d04e3u, 0x087d064fu, 0x0e040d48u, 0x0cf600d1u, 0x0aad0ffdu, 0x05a307d3u, 0x0dbe0989u,
+    0x01b20d5cu, 0x0c070891u, 0x0ed80f1fu, 0x0816059cu, 0x06e30ac7u, 0x05ca03e9u, 0x02d001bfu, 0x0b860cacu,
+    0x00280839u, 0x08e5042cu, 0x04090527u, 0x0ace0c00u, 0x0f8703c2u, 0x075c073au, 0x02370d29u, 0x04330837u,
+    0x0e0b043bu, 0x07ad0fc9u, 0x0d0909f5u, 0x03c900b6u, 0x06960c02u, 0x0e940667u, 0x05d90a71u, 0x0f6e04beu,
+    0x088a0af9u, 0x00ea0fe1u, 0x0d5d01c7u, 0x03370e54u, 0x022b0948u, 0x070d0816u, 0x00c50aa0u, 0x04660e97u,
+    0x0fa9047cu, 0x0c840281u, 0x03da0bc2u, 0x06e406d3u, 0x0dd90a64u, 0x04e400c2u, 0x00f70c8du, 0x0a8c0b9du,
+    0x020f0149u, 0x09d809dfu, 0x0f240545u, 0x0b3907fbu, 0x0253048du, 0x04d102bfu, 0x0aae0181u, 0x06fb0de7u,
+    0x02fb0bf1u, 0x0ef7024bu, 0x09940a9bu, 0x0a7a0d0bu, 0x06d102bau, 0x016a0f40u, 0x0b1a09e6u, 0x09100d9du,
+    0x0bfa01f7u, 0x0e810f8cu, 0x0175083au, 0x05eb09c0u, 0x09410c47u, 0x024705afu, 0x073102e1u, 0x09920ea9u,
+    0x04b204b5u, 0x0d140bc9u, 0x00be035cu, 0x034d0751u, 0x0af80075u, 0x01a40daeu, 0x09690be6u, 0x047a09a7u,
+    0x0ee80695u, 0x0ded00abu, 0x08110f0fu, 0x02de0a86u, 0x067d092au, 0x0dc2066fu, 0x0a550b7bu, 0x088500efu,
+    0x04f10c96u, 0x0ee3076du, 0x0adf0256u, 0x09df053eu, 0x00760d51u, 0x0bcd01adu, 0x018a0964u, 0x046e005du,
+    0x026d0ca3u, 0x0a2c026fu, 0x05a109e2u, 0x0e4905d1u, 0x09a60006u, 0x0cf10f7fu, 0x08580318u, 0x0bc40619u,
+    0x02aa08efu, 0x05d500adu, 0x00690cbcu, 0x0ba60f6au, 0x01660866u, 0x0ff202b5u, 0x0c4f0592u, 0x085e0739u,
+    0x06fe0f8fu, 0x05420386u, 0x00120ad5u, 0x03cf0204u, 0x077c0ed2u, 0x0f5d0b50u, 0x01940663u, 0x08a704fau,
+    0x041c0f4eu, 0x0d340069u, 0x00ae05adu, 0x0bc007e9u, 0x0e190191u, 0x02940bd3u, 0x0f2e00e1u, 0x03dd06afu,
+    0x003f02ffu, 0x07150ac4u, 0x0a650039u, 0x0b980402u, 0x03780dedu, 0x0ff6020fu, 0x00600af0u, 0x0e6a0719u,
+    0x03d70154u, 0x06b809e9u, 0x090d026eu, 0x05110cc1u, 0x0dd50f90u, 0x0e93061au, 0x07780313u, 0x0c660edeu,
+    0x022d0147u, 0x05710ce6u, 0x0cb70773u, 0x00f6031cu, 0x093d0175u, 0x03960e37u, 0x0b9c026cu, 0x002f0ebau,
+    0x095805d7u, 0x032908c6u, 0x011b03bbu, 0x05690e69u, 0x0dd80812u, 0x083e0f6eu, 0x03420406u, 0x07740e0eu,
+    0x0cb20879u, 0x0680052fu, 0x0fec0342u, 0x002207a5u, 0x0ae50ce1u, 0x06320128u, 0x036e0bfcu, 0x0df10e0du,
+    0x07810b0bu, 0x0abb07c5u, 0x0e560377u, 0x07fe04deu, 0x0a1d0ddeu, 0x06490992u, 0x04020e75u, 0x0b83047du,
+    0x0e75006eu, 0x0dc10c08u, 0x089e0e00u, 0x0c7706e4u, 0x05f000b7u, 0x0bd60a48u, 0x09bb0d07u, 0x0e0c0962u,
+    0x0b480397u, 0x01e2071cu, 0x07920b73u, 0x05c20987u, 0x03710e23u, 0x0849052au, 0x0a2e0777u, 0x063d0ccau,
+    0x0d4d08cdu, 0x0f6a058eu, 0x02b20e64u, 0x07cf07a6u, 0x04e806b8u, 0x0c1b0933u, 0x083b051eu, 0x0a450ceau,
+    0x0b610e2bu, 0x02220645u, 0x0fa30b3cu, 0x09ff0467u, 0x0bca094bu, 0x007307b5u, 0x065c050eu, 0x038508afu,
+    0x09db0a2bu, 0x06ee05a4u, 0x0b460da2u, 0x0f190872u, 0x01b80c6au, 0x05510557u, 0x0ce009aeu, 0x0f4d04a7u,
+    0x05fe0a77u, 0x0b4b0072u, 0x072e0c31u, 0x0fc80ae9u, 0x049c06dfu, 0x0a5f02c4u, 0x0d400bb3u, 0x0ee705f4u,
+    0x0b12071au, 0x03bf0f3cu, 0x08f30da5u, 0x07c00b92u, 0x04a50a45u, 0x018706b2u, 0x0f5b0425u, 0x09dc0230u,
+    0x050c0556u, 0x020c0d91u, 0x090c0a34u, 0x030800f0u, 0x0d60061du, 0x01cd0208u, 0x07aa07b6u, 0x02c30d53u,
+    0x00e2084cu, 0x06760297u, 0x0a8005e9u, 0x01c408b9u, 0x031a0d8fu, 0x0e8c031fu, 0x007207c7u, 0x052000f9u,
+    0x065a088au, 0x0f8a0e91u, 0x0c330d6cu, 0x08d60310u, 0x0ebf0422u, 0x04f00fe3u, 0x00cc0a7bu, 0x0c6403b9u,
+    0x096e0ee5u, 0x057b0c30u, 0x01bf0150u, 0x0cd40b5au, 0x0e3d033au, 0x01300f3au, 0x062900c6u, 0x02ea087cu,
+    0x0c7a03bcu, 0x078c0012u, 0x05b407ffu, 0x01360e87u, 0x042900fcu, 0x08370229u, 0x0aac0b7eu, 0x0d690e20u,
+    0x0ff103c9u, 0x00a60b22u, 0x049801eeu, 0x0a300458u, 0x0e1b0fd7u, 0x082c004cu, 0x070407f5u, 0x029a0354u,
+    0x0e450f38u, 0x01d50db4u, 0x0c0c0641u, 0x08c0015fu, 0x026004d3u, 0x06d80a3cu, 0x00a008e5u, 0x0937021du,
+    0x0519010fu, 0x01260ab4u, 0x0c3403f7u, 0x02c70189u, 0x0ec304dcu, 0x0b6b0888u, 0x08cf0f23u, 0x00fa098bu,
+    0x0d480066u, 0x06b40690u, 0x0f910ff1u, 0x045808d6u, 0x05670c4fu, 0x0ed40afau, 0x0b0503ccu, 0x0d040a30u,
+    0x038d0cceu, 0x097b04ddu, 0x0fb90984u, 0x04620f4au, 0x0d57041au, 0x06dd057fu, 0x083d0c9au, 0x039d0fb7u,
+    0x0a380469u, 0x028a0202u, 0x04810a3fu, 0x010500a1u, 0x0ad90678u, 0x0d730860u, 0x0780022au, 0x0251005eu,
+    0x04640967u, 0x082d04d5u, 0x0b230282u, 0x06c009f1u, 0x03e20d80u, 0x08de0479u, 0x0f420c0au, 0x051e0a6bu,
+    0x01800f9du, 0x0eb30c5fu, 0x089b0548u, 0x0d290a37u, 0x02a90d3du, 0x0f1006d0u, 0x04f90c8au, 0x01420030u,
+    0x08b80290u, 0x07bb0f5du, 0x033806d7u, 0x05ef095bu, 0x0c210abfu, 0x03f7064bu, 0x00c60d5fu, 0x09d90b67u,
+    0x04760704u, 0x0800021bu, 0x0d6d0939u, 0x03b10fbcu, 0x0c9e0cc7u, 0x0f360024u, 0x06210e8bu, 0x0b940d69u,
+    0x01f80c42u, 0x0de2097du, 0x09d30677u, 0x06ba0ec2u, 0x0d6c0283u, 0x02240c33u, 0x05df0729u, 0x04230d43u,
+    0x0be10b60u, 0x008903e0u, 0x0b1801e7u, 0x0ca2075du, 0x099b02fbu, 0x004c0f05u, 0x08bf0157u, 0x04db067eu,
+    0x016e0fceu, 0x0bc201c0u, 0x05610b2fu, 0x07bd0040u, 0x0af1077bu, 0x095d0bc8u, 0x0154019au, 0x0c800adeu,
+    0x0d960612u, 0x07430c49u, 0x0946053fu, 0x0cd10907u, 0x06a80c06u, 0x01b50d3cu, 0x0f990b17u, 0x0ba505fbu,
+    0x0e760db8u, 0x034a0721u, 0x0dc00f77u, 0x09d60634u, 0x0002082eu, 0x0ac301a2u, 0x0cfb05bcu, 0x096d02b2u,
+    0x0ddc073fu, 0x039a01efu, 0x0a6a08dbu, 0x07000306u, 0x0c3603fcu, 0x09520febu, 0x0612098cu, 0x01f304b2u,
+    0x0bd1062bu, 0x0cd5081bu, 0x0ea20be1u, 0x023d00eau, 0x08dd0e61u, 0x0adb02b6u, 0x0fbb0c3eu, 0x0c7d0129u,
+    0x068e09fdu, 0x0a7d0453u, 0x005f02f6u, 0x059f0842u, 0x016d05bau, 0x09bc0390u, 0x02fd0764u, 0x04380494u,
+    0x085c030du, 0x0e9707e4u, 0x057e0058u, 0x03a108deu, 0x08300e19u, 0x0a680578u, 0x0cbe0142u, 0x07660323u,
+    0x0f03080bu, 0x038e0e81u, 0x08230cfeu, 0x06350bceu, 0x026f04c8u, 0x073d0e13u, 0x0f6f0571u, 0x0a5e0b9bu,
+    0x081e0733u, 0x0d9d0358u, 0x024a0d33u, 0x00950a26u, 0x0ee50247u, 0x02b90eedu, 0x05bc06c3u, 0x0fff09b5u,
+    0x0b1302d2u, 0x004b0e1bu, 0x0f010707u, 0x03140f5bu, 0x03f2012eu, 0x09ba048bu, 0x05e30ec4u, 0x0a760326u,
+    0x00930809u, 0x08fb0b97u, 0x01780423u, 0x0fbc009eu, 0x048b0cc2u, 0x07790b14u, 0x021e0e6fu, 0x06aa099au,
+    0x00b40664u, 0x0b210d7cu, 0x04a40ee6u, 0x00380b1fu, 0x0dc705ebu, 0x03520187u, 0x0aed086bu, 0x0e300accu,
+    0x04160e93u, 0x09aa0cfdu, 0x06b00367u, 0x000a0519u, 0x0d580797u, 0x074f0408u, 0x015e08dfu, 0x0536058cu,
+    0x034307c0u, 0x0f000d13u, 0x09280bb7u, 0x0e280e18u, 0x0ad40afcu, 0x07e0099cu, 0x0da90f11u, 0x0c710b68u,
+    0x0752057eu, 0x0a890fd1u, 0x00e60d21u, 0x0fa00b31u, 0x005503a2u, 0x04e709d6u, 0x0e660fa6u, 0x02d70abcu,
+    0x08b004a3u, 0x0a440928u, 0x01a805b6u, 0x0eab0127u, 0x0bf909cbu, 0x03d0083eu, 0x05d60082u, 0x0c7f092du,
+    0x06cd0e83u, 0x0f2a0477u, 0x09030801u, 0x06300e47u, 0x0ce50532u, 0x0be303b3u, 0x04aa08abu, 0x08b40d4bu,
+    0x01fc0015u, 0x062d0821u, 0x04fe03aeu, 0x0b720acbu, 0x0dec0294u, 0x088307b1u, 0x029b09b2u, 0x072a00f4u,
+    0x054b0cf1u, 0x0ca801e9u, 0x066c0a97u, 0x0c120ea4u, 0x05b30906u, 0x0e830778u, 0x033203cdu, 0x0bec0077u,
+    0x08190bbau, 0x0603048eu, 0x0fda011du, 0x023c078cu, 0x05650e07u, 0x07e10c25u, 0x0f8b02d1u, 0x0733070cu,
+    0x02b600a8u, 0x055009d4u, 0x0b3d01b2u, 0x0f590f41u, 0x04c20a61u, 0x02c80dceu, 0x09860206u, 0x0d990f7bu,
+    0x0b910e82u, 0x02230079u, 0x076e0530u, 0x042706ccu, 0x0bc1010bu, 0x04f6025eu, 0x00130883u, 0x0f8500c4u,
+    0x05e70a07u, 0x027501beu, 0x0cf50457u, 0x0b570600u, 0x07360771u, 0x0c2000b0u, 0x096f0c9eu, 0x012e0655u,
+    0x058a026du, 0x0db6001au, 0x04d60a68u, 0x0d360f3fu, 0x00b506ceu, 0x0a060405u, 0x0e170aafu, 0x02ed02b7u,
+    0x003105bbu, 0x0ac200d9u, 0x041108fbu, 0x0346062cu, 0x09c00c26u, 0x01130a84u, 0x0e7200e8u, 0x03c504b7u,
+    0x07830bb2u, 0x0a090ee0u, 0x0e4a01c2u, 0x07fa0cc5u, 0x016505b2u, 0x0c5c0e04u, 0x048706c2u, 0x0d920536u,
+    0x0f340fc3u, 0x03ab08acu, 0x0802059au, 0x02bd0355u, 0x0b38022du, 0x08960501u, 0x0d790fddu, 0x042e0cfcu,
+    0x0efa084eu, 0x09ed0359u, 0x0c8b0a8cu, 0x08fe0943u, 0x0b7e0068u, 0x01250513u, 0x0a210f2du, 0x00700420u,
+    0x0d7a0d8bu, 0x08530584u, 0x019508c8u, 0x0a3f0c75u, 0x0c00061bu, 0x081f0026u, 0x05dc0b3bu, 0x0e9b06a2u,
+    0x08880382u, 0x00e50a9du, 0x063c01deu, 0x0ff50f3eu, 0x02b40424u, 0x06c60c24u, 0x08e00629u, 0x01430dd7u,
+    0x037506f6u, 0x09840c81u, 0x048502bbu, 0x08c30a75u, 0x01dc0dbcu, 0x03e50218u, 0x0657085eu, 0x0fdf0eb1u,
+    0x0ade0bb5u, 0x06fc074du, 0x02ac0de4u, 0x09160376u, 0x07c9021eu, 0x0b510cb3u, 0x01e10d9bu, 0x04920be8u,
+    0x0d2d0a0au, 0x078d0f63u, 0x0e430ca2u, 0x0b7f0196u, 0x06f902e8u, 0x08050dc6u, 0x0a780fe7u, 0x0db305d5u,
+    0x02f10760u, 0x0c100977u, 0x00bf044cu, 0x05970a04u, 0x0a990875u, 0x0fd50b55u, 0x0025037cu, 0x09320c64u,
+    0x0ae60a36u, 0x00eb0016u, 0x0ead06ebu, 0x0a270de8u, 0x01cb0c46u, 0x007f0a08u, 0x0989069du, 0x056a0197u,
+    0x01170df5u, 0x02bf0588u, 0x07490f88u, 0x040c0292u, 0x0e880643u, 0x06480d23u, 0x0cbb0a12u, 0x04b60b6au,
+    0x090e07a1u, 0x0ece025cu, 0x03730ba6u, 0x0652045eu, 0x0e2502fau, 0x03c209a4u, 0x007a0cdau, 0x0afe04a5u,
+    0x045f0949u, 0x0caa0824u, 0x0a520c84u, 0x0d2209e1u, 0x01b60758u, 0x0eae0d2au, 0x09f104f1u, 0x0b1e034bu,
+    0x0e5d0ecfu, 0x0bfe091bu, 0x06a0082du, 0x0f380f3du, 0x0d740b88u, 0x0a3104d7u, 0x02780961u, 0x0c7e03eau,
+    0x0001054eu, 0x0bad0cdeu, 0x04070899u, 0x0f500b3fu, 0x067005fdu, 0x053b0fb2u, 0x0fc2077du, 0x097101b1u,
+    0x05e406a9u, 0x012803e8u, 0x04ec0b28u, 0x01ba071du, 0x0f77098fu, 0x054907dcu, 0x001e0155u, 0x06830afeu,
+    0x0ca9032cu, 0x08f60d88u, 0x0f4f0658u, 0x02670faau, 0x06bd0053u, 0x036b016eu, 0x07a90e76u, 0x0bda0236u,
+    0x0212046du, 0x043f0bf3u, 0x06e20f14u, 0x0e0107ddu, 0x04d7011bu, 0x0f7c0ae2u, 0x0ca502e3u, 0x06d90957u,
+    0x0ba30b34u, 0x0e2b0701u, 0x01910c83u, 0x0d4107fau, 0x08460baeu, 0x01ea01d4u, 0x03a6089fu, 0x0b550352u,
+    0x05be00fbu, 0x0c4c0e25u, 0x00df0efcu, 0x079806d9u, 0x020d0861u, 0x0ce60fe6u, 0x0f8f0752u, 0x070e027eu,
+    0x029f013fu, 0x051f0d99u, 0x096b05e0u, 0x038602d8u, 0x084f08ebu, 0x0c2a0fc1u, 0x04040a3au, 0x055801fbu,
+    0x0d520bbdu, 0x07e90013u, 0x0173054bu, 0x0318013au, 0x05370365u, 0x081706e2u, 0x0e340e0fu, 0x04ad0183u,
+    0x07940f86u, 0x0df802f4u, 0x09d400e7u, 0x010c0481u, 0x0c98094fu, 0x036a0057u, 0x088704f4u, 0x0c0e08bau,
+    0x0ef20295u, 0x0a020d74u, 0x0c6f0027u, 0x08bd0e62u, 0x0d0d04fdu, 0x027203d1u, 0x0edf0cb6u, 0x0b30090au,
+    0x01990e9cu, 0x04c100d7u, 0x0401027fu, 0x09a10bfau, 0x0ce70504u, 0x0e790d12u, 0x04f4077eu, 0x0642092cu,
+    0x0d2a0669u, 0x09bf02c7u, 0x08ba099eu, 0x0c3903f5u, 0x060e0d4au, 0x07a405eau, 0x025804a1u, 0x0a5d0e85u,
+    0x08800031u, 0x03810221u, 0x0ad0041bu, 0x052509c4u, 0x09a70e90u, 0x0f7004bfu, 0x071906a1u, 0x0e060f9bu,
+    0x02610932u, 0x099705e8u, 0x0fe20a90u, 0x0ac10195u, 0x049000cdu, 0x09000dbau, 0x09de0546u, 0x01a60c19u,
+    0x0e100eceu, 0x07c20b05u, 0x0f1603bdu, 0x00500e55u, 0x05bf0041u, 0x0dd00173u, 0x07890b26u, 0x021903eeu,
+    0x00a407a4u, 0x06280e3au, 0x0aa4066au, 0x0eaa0d16u, 0x005d09cfu, 0x0b2f0c5cu, 0x0930007bu, 0x019c0adcu,
+    0x03590676u, 0x087009ebu, 0x05af07f7u, 0x021b0ea1u, 0x0e850c6du, 0x0af50a5eu, 0x00c00345u, 0x02a30eeeu,
+    0x08180acfu, 0x03b4057du, 0x06980857u, 0x02fa0257u, 0x0a410bc3u, 0x04450f32u, 0x094506b3u, 0x05ba0200u,
+    0x08470562u, 0x0d800844u, 0x07450a5fu, 0x0ba7070au, 0x00fc08e8u, 0x089d0404u, 0x0a560ab5u, 0x02db0f64u,
+    0x0eeb0d8au, 0x055f051du, 0x01370b30u, 0x032700bbu, 0x0b1008d5u, 0x03cd0f52u, 0x0dcf0765u, 0x00c30cc8u,
+    0x04a808a0u, 0x0fb1053cu, 0x05fb0f35u, 0x001700d5u, 0x0c170383u, 0x02e60db0u, 0x0a9b0018u, 0x00940b0au,
+    0x07e80ccbu, 0x041e04e9u, 0x06c8037bu, 0x0d940d26u, 0x05830b51u, 0x0b7c03f6u, 0x033a0a3du, 0x0c5608beu,
+    0x05f90098u, 0x0a85068cu, 0x0bb304cfu, 0x01680bafu, 0x06a60805u, 0x0ad80585u, 0x02e106a8u, 0x0efc0d92u,
+    0x08ae0994u, 0x04600499u, 0x09610ac5u, 0x0c3a0231u, 0x07170fffu, 0x05d107bcu, 0x0f8c05c8u, 0x0ce108e4u,
+    0x06b50c2fu, 0x0f270d94u, 0x0aaa0254u, 0x0d4306f5u, 0x076c014cu, 0x04650e3bu, 0x06c207c3u, 0x0ddd0c1du,
+    0x01f50974u, 0x0b2c047bu, 0x0fe40fa1u, 0x00880a32u, 0x079b0613u, 0x0bce0090u, 0x0e2409deu, 0x035a0489u,
+    0x0fba0b63u, 0x008f0c86u, 0x0aa90374u, 0x0f0c0dbbu, 0x05d70ea7u, 0x01ee01d7u, 0x0def05b7u, 0x006c008cu,
+    0x0b53084bu, 0x0734019cu, 0x0fb40ed5u, 0x0d5e06c9u, 0x002a0273u, 0x094d0ba8u, 0x0f090172u, 0x06690372u,
+    0x0ce20a38u, 0x09170bd9u, 0x07be0d4du, 0x0eb105fcu, 0x06ae0759u, 0x044b0a5du, 0x08d90829u, 0x0f0e02d7u,
+    0x0d1001f2u, 0x01720740u, 0x0bc509e4u, 0x02d20804u, 0x003a0e9bu, 0x083c0205u, 0x06a20608u, 0x0eb80330u,
+    0x00cb07b7u, 0x03ce0fa5u, 0x0d6209a6u, 0x08e1024au, 0x0f790cf9u, 0x04d40eeau, 0x0cc708c3u, 0x0a2d02a4u,
+    0x0baf0f5eu, 0x0fdc00f2u, 0x02890bdau, 0x0dea0895u, 0x039f041cu, 0x012202ddu, 0x04400ec0u, 0x0bcc01f1u,
+    0x098e03b7u, 0x008004f7u, 0x04e10f33u, 0x030105a3u, 0x08f00b74u, 0x0a4f0421u, 0x0bc90626u, 0x055d00b3u,
+    0x095b0cb9u, 0x047901bbu, 0x0e4b073bu, 0x05f80d27u, 0x0d8d0360u, 0x013d080eu, 0x06e60e14u, 0x02140d47u,
+    0x09d7075bu, 0x066e0f84u, 0x02af0065u, 0x03a00604u, 0x09270b1du, 0x048302ebu, 0x07cd09d0u, 0x0c9f0bc1u,
+    0x03e903b5u, 0x08670c57u, 0x02560a57u, 0x0a7e05aeu, 0x04bd0e42u, 0x082f0448u, 0x0b6a0827u, 0x02d90fc0u,
+    0x0bff065du, 0x013302a6u, 0x02340916u, 0x0b3e0af5u, 0x0de10140u, 0x01020c98u, 0x0c6a055cu, 0x054a0ea8u,
+    0x061e0bddu, 0x0a160de0u, 0x088e0078u, 0x0e39047eu, 0x0f580691u, 0x01460941u, 0x0d1a0f47u, 0x04d20ca7u,
+    0x089f0aa5u, 0x028101d0u, 0x07290df7u, 0x044f0737u, 0x01e9043fu, 0x09550a7fu, 0x007d00a5u, 0x03a70c20u,
+    0x06c505feu, 0x010e037au, 0x05100735u, 0x0cf40e70u, 0x07af0579u, 0x08da0a8bu, 0x0a6b0cdbu, 0x02ce0749u,
+    0x02080b93u, 0x0e41003cu, 0x0c490aacu, 0x06360320u, 0x01700d5du, 0x0fa208d2u, 0x0064023cu, 0x0cc40deau,
+    0x0746039cu, 0x01470b4cu, 0x08dc08f4u, 0x0a8700f6u, 0x05060ed1u, 0x08730ab3u, 0x0c9a0178u, 0x0ad202aeu,
+    0x04e303e4u, 0x0d240972u, 0x080f01a9u, 0x0e4f04ccu, 0x0c37080au, 0x0adc0ff8u, 0x06940ce4u, 0x0f650696u,
+    0x015b07aau, 0x09700ddbu, 0x0c6e0316u, 0x06b7091du, 0x0e8f0c9bu, 0x05ae09bfu, 0x01600084u, 0x07580d97u,
+    0x040e04d8u, 0x0a1e07d1u, 0x0d7101cfu, 0x03410e09u, 0x04e50450u, 0x0a470ff9u, 0x07770986u, 0x028d03d2u,
+    0x0e7c0640u, 0x038408d4u, 0x04cb0fb0u, 0x0a7c0c7eu, 0x077202a9u, 0x04100baau, 0x09b00004u, 0x0ae00430u,
+    0x0fa40d59u, 0x0c350575u, 0x0a1800bfu, 0x0dfc0902u, 0x0b3f0c67u, 0x0e78031au, 0x076f051cu, 0x059307d6u,
+    0x0daa0d34u, 0x083f01d5u, 0x09ee0942u, 0x01d80d66u, 0x0b600067u, 0x0e87016du, 0x067f0997u, 0x0d7b046fu,
+    0x05820fb5u, 0x07b70878u, 0x0b0d096eu, 0x04140779u, 0x0d8701a3u, 0x07dd09f7u, 0x03a40feeu, 0x0ed506e1u,
+    0x02d10f0bu, 0x0b9d05f2u, 0x0d2b02deu, 0x037e0c4bu, 0x025c044eu, 0x0f35058bu, 0x040d0c03u, 0x005308e6u,
+    0x0e9e064au, 0x0bf10eb7u, 0x01a30a2eu, 0x05720c5au, 0x010b06dbu, 0x0d460109u, 0x03210480u, 0x09d5024fu,
+    0x05050f2eu, 0x05dd04dau, 0x0e030033u, 0x03550720u, 0x01af01e1u, 0x09e10550u, 0x0d0b0b6bu, 0x0e3b0a8au,
+    0x052d010eu, 0x0f680c68u, 0x05cd0f1du, 0x0985033fu, 0x085f088cu, 0x0fd906aeu, 0x01c50248u, 0x0b780b56u,
+    0x095600e9u, 0x00830522u, 0x0c740186u, 0x06580ad6u, 0x0246077au, 0x0bdb0e34u, 0x05c50507u, 0x01da085du,
+    0x07d106f3u, 0x000f02c1u, 0x05520b7cu, 0x03260606u, 0x06170e74u, 0x08250158u, 0x02950fdbu, 0x0c9b0b58u,
+    0x0ed00a1du, 0x0af40ef9u, 0x034804c4u, 0x06040665u, 0x0f740b40u, 0x008b07f6u, 0x04ab0e2fu, 0x085d06a5u,
+    0x0ff3012cu, 0x011d0d28u, 0x09210616u, 0x0f080e72u, 0x09cd048au, 0x02430bb0u, 0x05c80531u, 0x0a29082fu,
+    0x04f80145u, 0x067304c3u, 0x000c0e60u, 0x0e8207ccu, 0x075d098du, 0x0b4506cfu, 0x09760f5fu, 0x05ee007fu,
+    0x08e80b39u, 0x07240529u, 0x0456023fu, 0x0a390e27u, 0x0fe608a7u, 0x07590d8cu, 0x021a0a96u, 0x0eb20952u,
+    0x0b6d0138u, 0x00d20890u, 0x07fb0b0du, 0x0be80fa7u, 0x04480d39u, 0x0ffb034cu, 0x089006a4u, 0x00820ee9u,
+    0x0ae103ecu, 0x080a072du, 0x06c10597u, 0x00570a15u, 0x0cd20c21u, 0x03f30051u, 0x065d07c4u, 0x0d780d75u,
+    0x08080efdu, 0x0f940a13u, 0x01960836u, 0x0dd40347u, 0x08b905c4u, 0x0eed09c5u, 0x0d56012du, 0x035f0ee2u,
+    0x0e500c35u, 0x06840a22u, 0x0ce40f53u, 0x015d0380u, 0x0fd10840u, 0x0c0d09b0u, 0x0a6106d1u, 0x01b103dbu,
+    0x04770046u, 0x0020087au, 0x0c2b029au, 0x074e0c7bu, 0x094b0f99u, 0x026b0340u, 0x0c63051fu, 0x03930c13u,
+    0x0b870291u, 0x06f20394u, 0x02f00b20u, 0x002700c8u, 0x06a40c91u, 0x0c9302ceu, 0x0886004du, 0x0dd20aa7u,
+    0x0f4c093fu, 0x0c440d4eu, 0x08240a51u, 0x09e30020u, 0x056c0215u, 0x01040cd8u, 0x0dbd038cu, 0x0313085fu,
+    0x0f760d65u, 0x026307a7u, 0x0b560bd8u, 0x086c0339u, 0x0021000eu, 0x05fc03efu, 0x040b0b90u, 0x08bb0586u,
+    0x0ccf0e77u, 0x02be0633u, 0x0f3f0c04u, 0x07390428u, 0x0acb07bfu, 0x02380e58u, 0x065b08b1u, 0x038a025fu,
+    0x0c1e0963u, 0x02a80dbeu, 0x01d60b25u, 0x0ba00168u, 0x0e8604f2u, 0x012b0e3du, 0x0acf0aa6u, 0x02e80303u,
+    0x045706fcu, 0x07100cf3u, 0x05920419u, 0x0b270f67u, 0x02ff0d9fu, 0x005e01fau, 0x07050b2du, 0x092403b0u,
+    0x046908eau, 0x0b5900fdu, 0x09a204c9u, 0x088f0d70u, 0x03fb0af2u, 0x00c9020du, 0x05090d01u, 0x097505cdu,
+    0x06620769u, 0x08d40deeu, 0x0f150ad0u, 0x03fd040au, 0x054c09dau, 0x0e2301f6u, 0x0ab00900u, 0x01820dcau,
+    0x09b30a59u, 0x0d470f03u, 0x05290563u, 0x0bfc0811u, 0x0ea40f74u, 0x049506bbu, 0x0b5c0dc5u, 0x018c0c0du,
+    0x0ab70744u, 0x041d0264u, 0x020b0637u, 0x0cca0fc8u, 0x0fb60b8eu, 0x06a504f9u, 0x0c0f0e78u, 0x07d40a78u,
+    0x00d800ebu, 0x0cb60443u, 0x037d0fb3u, 0x0da4092eu, 0x09570654u, 0x0be00ef4u, 0x0e3c0763u, 0x0aaf02d5u,
+    0x06810d2bu, 0x04ae09c9u, 0x0a23018au, 0x004502a2u, 0x0db20aaau, 0x092000d2u, 0x04ed05bdu, 0x0cbc0cd1u,
+    0x0996001fu, 0x0eee080cu, 0x0dd102c3u, 0x04b1068fu, 0x075e0f60u, 0x08f90945u, 0x057305ceu, 0x0ecb0488u,
+    0x0bfb01c3u, 0x0a1c08ffu, 0x0d060c07u, 0x03e70044u, 0x099d06d2u, 0x052b0cbdu, 0x0ab807d5u, 0x010f0647u,
+    0x0f4e0dd8u, 0x029c0245u, 0x0dbc079cu, 0x0768068bu, 0x0ad1008du, 0x0e58046cu, 0x07060e57u, 0x0f5202c2u,
+    0x0d4b0c5eu, 0x02d401a0u, 0x0dcb056fu, 0x012f00dcu, 0x0a0b06f4u, 0x0cf90ef2u, 0x078505ecu, 0x05e90008u,
+    0x0e640859u, 0x04220714u, 0x082b020bu, 0x0a4a09ddu, 0x01ec03e5u, 0x035d08f0u, 0x072105beu, 0x00ce036du,
+    0x07b10caeu, 0x05c0041du, 0x091a0851u, 0x02e30d98u, 0x049e0311u, 0x01ad0766u, 0x03cb019du, 0x0ac005ffu,
+    0x09c102c9u, 0x05a80703u, 0x06c90ab7u, 0x0f37055du, 0x049f01f5u, 0x02e009f8u, 0x07c50c80u, 0x009700a6u,
+    0x01d303b8u, 0x0d6607f8u, 0x0881051bu, 0x058d0f48u, 0x032c0930u, 0x0bae04a0u, 0x0f290bf2u, 0x00b60fdeu,
+    0x072709e7u, 0x0421047au, 0x08b60ea2u, 0x0a6f0d15u, 0x033603beu, 0x0c8e0107u, 0x09b60c87u, 0x00070b6du,
+    0x021d0e89u, 0x086e0628u, 0x00dc0277u, 0x0e530a6cu, 0x07a104afu, 0x0ffe0924u, 0x0cc202f0u, 0x084c0ff2u,
+    0x0bf3055au, 0x059c0abeu, 0x00aa0c9cu, 0x04c8097bu, 0x02310f94u, 0x0d150bb4u, 0x035607e7u, 0x0b500a4eu,
+    0x07ba0f6cu, 0x0211096au, 0x0b890bd6u, 0x08290e6au, 0x06a907b9u, 0x031e0cccu, 0x00420b4eu, 0x08d103ddu,
+    0x024804cbu, 0x0f310bd2u, 0x00c20ceeu, 0x0611011cu, 0x0e110e39u, 0x08cb0a76u, 0x0fac01ceu, 0x09a50ed8u,
+    0x03970b19u, 0x0eda09c2u, 0x0e1a0131u, 0x0b88056au, 0x0a590adfu, 0x08a908f8u, 0x0ec709f0u, 0x0d280dafu,
+    0x04c90c12u, 0x0e5e0edfu, 0x01d00141u, 0x0a7b0cc9u, 0x01480dd3u, 0x0d310460u, 0x053c086eu, 0x09bd0f93u,
+    0x0f9b0ad2u, 0x03cc0e35u, 0x0c0a0c69u, 0x0e680687u, 0x06ce0d72u, 0x0193015cu, 0x07f00711u, 0x0a3c0392u,
+    0x05940636u, 0x015701edu, 0x0d080b99u, 0x05f508c2u, 0x02400742u, 0x0fae028fu, 0x068c0823u, 0x0df209dcu,
+    0x0503009cu, 0x0f6607a0u, 0x06640f2au, 0x02830574u, 0x0c1c0e3cu, 0x04800bd0u, 0x020a0190u, 0x062c09fbu,
+    0x03af0437u, 0x0a43004eu, 0x0ec40ea6u, 0x0c750312u, 0x08f20590u, 0x063408edu, 0x09f4011au, 0x006d0500u,
+    0x0428038au, 0x05b00672u, 0x0a5a08a5u, 0x04a70493u, 0x0ea3030eu, 0x0bd40a88u, 0x0f9d0188u, 0x04f50d83u,
+    0x0b3a0f5au, 0x0c55095fu, 0x07500328u, 0x0aef0639u, 0x0cfd0b8du, 0x056407b3u, 0x029704f8u, 0x0d5c006au,
+    0x0c610de5u, 0x004806acu, 0x06cc0f16u, 0x01810c66u, 0x0d9f00c1u, 0x076503e7u, 0x06050f7du, 0x024e04abu,
+    0x0040088fu, 0x083a0985u, 0x0c3203abu, 0x078e07d2u, 0x064a0b37u, 0x0ea506bcu, 0x0b16015du, 0x0c6505dcu,
+    0x071e0234u, 0x02730726u, 0x095a005cu, 0x011a033du, 0x0b090a1bu, 0x045e0b69u, 0x0d35085cu, 0x0e330e0bu,
+    0x030b0a8eu, 0x0f7a0ca8u, 0x0b7b0576u, 0x0834005fu, 0x00f30acau, 0x0b320dd5u, 0x03d60fd4u, 0x07de040bu,
+    0x0b8b0d0du, 0x0347035eu, 0x0aa30aebu, 0x09140853u, 0x013e03cfu, 0x06d500c9u, 0x09c90f01u, 0x0de80d2eu,
+    0x015f06fbu, 0x07e60c1bu, 0x06bc0865u, 0x03330165u, 0x0f8203ebu, 0x01a50dc1u, 0x054d06e9u, 0x0c590b1cu,
+    0x08a80023u, 0x0fe80ed4u, 0x0cac0249u, 0x00a30d93u, 0x01f900a7u, 0x092e08ecu, 0x03d20684u, 0x0d700287u,
+    0x068b0785u, 0x03450093u, 0x01710e95u, 0x094e0473u, 0x03e00d77u, 0x008402adu, 0x0b770f98u, 0x065108b8u,
+    0x04c3032fu, 0x0aff01f8u, 0x084a049au, 0x054107d0u, 0x00af0e38u, 0x0c91064du, 0x032b0cc0u, 0x090f004au,
+    0x0fcb0243u, 0x0b7605a8u, 0x03ff0e50u, 0x02b000ccu, 0x08fd02abu, 0x00e00f36u, 0x03630c1fu, 0x08540981u,
+    0x060c04bcu, 0x0ec10bb1u, 0x050108cfu, 0x07860edau, 0x0fb30596u, 0x05ea0267u, 0x025d0f20u, 0x08df009bu,
+    0x0ad50308u, 0x06a70795u, 0x00390f82u, 0x0e9209b7u, 0x04ca04c0u, 0x072001b0u, 0x0d320699u, 0x01610553u,
+    0x09730bdeu, 0x0cd80160u, 0x05bb0d8du, 0x0d77020au, 0x0eb409bdu, 0x0b690776u, 0x031c05d6u, 0x0f2208b3u,
+    0x0d190288u, 0x0b000e2au, 0x097c0624u, 0x00290a6fu, 0x0b730f1au, 0x07970bffu, 0x0dcd028eu, 0x0ecc0d3au,
+    0x01100818u, 0x096c0cb5u, 0x07160a00u, 0x0df505a5u, 0x061f0b8fu, 0x0ae20fb8u, 0x07ca04fcu, 0x00db09d3u,
+    0x0a350c28u, 0x086f05c5u, 0x0fd8086du, 0x04cd0af1u, 0x0ed106edu, 0x080600f7u, 0x0a1f0c55u, 0x01de05f6u,
+    0x09080bd4u, 0x03150a91u, 0x0ffd0919u, 0x09f202b8u, 0x03f90b72u, 0x0f0501c4u, 0x0b2806fau, 0x06ea0815u,
+    0x09ad0aceu, 0x051c0d42u, 0x0e210686u, 0x0cf20a52u, 0x0a3304ffu, 0x0f7208f7u, 0x045a0350u, 0x01ae0d6du,
+    0x0d980a6eu, 0x000b03f0u, 0x0a820de2u, 0x0ca101dfu, 0x038907b8u, 0x09c70414u, 0x0c160c4eu, 0x01a00528u,
+    0x051b0926u, 0x03c80164u, 0x0c5003dau, 0x09e90d5au, 0x0dbf0c18u, 0x08e60331u, 0x02870eaau, 0x0eac096cu,
+    0x048408b0u, 0x009c0713u, 0x07690f9fu, 0x03c10642u, 0x081c0b95u, 0x00440cdcu, 0x05770337u, 0x08cc0ad9u,
+    0x04360123u, 0x026804a4u, 0x05240b5du, 0x0e380757u, 0x03e601dau, 0x0a6409d7u, 0x025f0602u, 0x06950fe4u,
+    0x03190466u, 0x0b1c0174u, 0x03b50756u, 0x028603d3u, 0x0f2f0e8fu, 0x05350814u, 0x0c760364u, 0x02b30e17u,
+    0x0e160a99u, 0x05ad016au, 0x0cce0fe0u, 0x0230022bu, 0x0be40936u, 0x06f70a2cu, 0x0dbb0409u, 0x0f530802u,
+    0x077500bau, 0x0ccc0d1fu, 0x02570ffeu, 0x0be205acu, 0x07c30a31u, 0x0595039eu, 0x01c30f06u, 0x0dc50bdfu,
+    0x0108030cu, 0x03580fd5u, 0x05e00447u, 0x00650ba2u, 0x06d00825u, 0x0bdc0e8cu, 0x05780032u, 0x0988077fu,
+    0x0b580fefu, 0x03070105u, 0x08ac0650u, 0x0de90cf7u, 0x00d30b02u, 0x083909bcu, 0x0eec067cu, 0x073e0dc0u,
+    0x0e080b4du, 0x09500ebdu, 0x07b506e3u, 0x01d7088bu, 0x035005c6u, 0x058007edu, 0x0aec0b38u, 0x0a340253u,
+    0x064c000fu, 0x0bf404e7u, 0x01fa0a3eu, 0x0f440441u, 0x04d9006bu, 0x0a260ecau, 0x0c9504f5u, 0x0748098eu,
+    0x00bb0fbau, 0x0fc607f4u, 0x0c310351u, 0x06000d6bu, 0x0d5a0541u, 0x088d0086u, 0x0489089cu, 0x0bee032du,
+    0x07f1095eu, 0x05230ad3u, 0x0d270c38u, 0x087f063du, 0x09b501c9u, 0x01550cf0u, 0x06f30048u, 0x0f6d06f9u,
+    0x0459042bu, 0x09990d20u, 0x001d054fu, 0x0abe03a8u, 0x03000cadu, 0x05860e5au, 0x0121052du, 0x042b0ef3u,
+    0x0e8a075fu, 0x060103d6u, 0x00ed06e0u, 0x08c80003u, 0x0e5b0d8eu, 0x0a460889u, 0x047b09a0u, 0x0c220539u,
+    0x07f6018bu, 0x0abc0782u, 0x0f250099u, 0x08990c82u, 0x020601ebu, 0x0df6061eu, 0x07d60ccdu, 0x0d17057bu,
+    0x0fee02cfu, 0x06910835u, 0x04b80956u, 0x01ff04d1u, 0x0b960005u, 0x067c0f89u, 0x04440132u, 0x0091082au,
+    0x0cb00478u, 0x02b10a5au, 0x0fe90299u, 0x06380087u, 0x0bb40e1cu, 0x0f170130u, 0x005a0a74u, 0x08480d38u,
+    0x0fc90f07u, 0x02ee0c78u, 0x0de502acu, 0x08eb0e02u, 0x0b2e08f3u, 0x028f06bfu, 0x0e540224u, 0x06270d9eu,
+    0x0bb70becu, 0x07cc001bu, 0x09130935u, 0x00f80e86u, 0x07220442u, 0x01670c6eu, 0x0f9a078au, 0x09cc0e5fu,
+    0x01b00509u, 0x0e8e00c7u, 0x00030f43u, 0x0c2302c6u, 0x043d0a4du, 0x0da5094eu, 0x0a790b41u, 0x08430259u,
+    0x01b40f00u, 0x0b97090eu, 0x077d0799u, 0x06600bb9u, 0x0e6b0038u, 0x087c068du, 0x0c2e01d9u, 0x099009a5u,
+    0x0aa60e1au, 0x050a0180u, 0x0d6f04eau, 0x03670c45u, 0x069a0e98u, 0x00100269u, 0x02c6045bu, 0x0f7e0cedu,
+    0x06500dfdu, 0x024508f2u, 0x0c960a01u, 0x09e40f21u, 0x04bb03c4u, 0x0aee0991u, 0x02a20adau, 0x00a50198u,
+    0x03ea0b70u, 0x07640ef1u, 0x0a140c8fu, 0x0f1e0379u, 0x05790e5eu, 0x02ec0712u, 0x0d8102fcu, 0x0a0a0d06u,
+    0x05c601fdu, 0x0b240623u, 0x04720bbeu, 0x00e10cb1u, 0x0d3f0f58u, 0x06f8044au, 0x040a0660u, 0x0cc50770u,
+    0x052703dcu, 0x07a205e6u, 0x09d2081cu, 0x06a10b03u, 0x0106014au, 0x0d440c51u, 0x039407bdu, 0x01aa03e1u,
+    0x0a8d05c1u, 0x04b306a3u, 0x02f80cbeu, 0x0efe0279u, 0x0ae40a3bu, 0x03620f80u, 0x0cb90b1au, 0x05e10207u,
+    0x0da00dabu, 0x0a6c06d4u, 0x066308bbu, 0x075f0e1du, 0x0b700454u, 0x00bc0781u, 0x03700534u, 0x06190c6cu,
+    0x0ea1065eu, 0x0d1b00deu, 0x03bb02feu, 0x092a0ec3u, 0x0d650849u, 0x01c10d68u, 0x03a302dau, 0x006e0b5cu,
+    0x0b7d05d0u, 0x01fd0aeeu, 0x0740095cu, 0x0f3d0830u, 0x0afa013bu, 0x0d2f0632u, 0x09780b2eu, 0x087b00ecu,
+    0x0d8b05e1u, 0x04260362u, 0x072806bau, 0x01450285u, 0x0e650db1u, 0x03a80747u, 0x06470476u, 0x09070dfbu,
+    0x0c1d06c8u, 0x0e4c09f6u, 0x0120024cu, 0x0ceb05d9u, 0x093a08d0u, 0x0af00a7cu, 0x0f8e0be5u, 0x0876059fu,
+    0x01620973u, 0x0eb60fccu, 0x08cd037fu, 0x0a8608e3u, 0x08070525u, 0x026209e3u, 0x094c02e6u, 0x018b0b86u,
+    0x0b1900ceu, 0x00bd0e48u, 0x0c6909b6u, 0x04460370u, 0x059d054au, 0x0f9e0f8eu, 0x08520a09u, 0x097700cau,
+    0x0ebd0eadu, 0x0d9e0aabu, 0x01fb019eu, 0x0ced08b7u, 0x098a05a0u, 0x0530012fu, 0x0058065au, 0x08ee03f1u,
+    0x03d50998u, 0x02350be9u, 0x0fc7058du, 0x02f9014fu, 0x058f0d3fu, 0x0f040f9au, 0x09090110u, 0x0c3c087bu,
+    0x02800db2u, 0x053e09d1u, 0x00de0b12u, 0x0f5c05cau, 0x04a00a70u, 0x0a4e0496u, 0x0eff0fadu, 0x069208a8u,
+    0x0ddf0244u, 0x04710ce2u, 0x09350f61u, 0x0c480344u, 0x01880bcdu, 0x04e20723u, 0x05c90fa9u, 0x0b4e07d7u,
+    0x009f0a85u, 0x0ec60e6du, 0x055e0b59u, 0x0bbe0567u, 0x07ae089du, 0x0f5f0083u, 0x0caf0f76u, 0x01770332u,
+    0x0aa20526u, 0x05cb00afu, 0x028b0c10u, 0x08100792u, 0x03b301bcu, 0x00300d89u, 0x077a03deu, 0x025000eeu,
+    0x0bf00dd2u, 0x06bf0767u, 0x03650177u, 0x0dd60addu, 0x050007c9u, 0x0c250210u, 0x0e7b0dc2u, 0x05f20920u,
+    0x0d890ff6u, 0x039801dcu, 0x0f060c0bu, 0x01df073cu, 0x0ab50d44u, 0x0c050284u, 0x06ff0886u, 0x000d0b80u,
+    0x040f0301u, 0x06ac04d2u, 0x05bd0f46u, 0x082a0705u, 0x0ba803a4u, 0x06ca0c09u, 0x0f450843u, 0x077f0d2cu,
+    0x0b5402f5u, 0x04c40035u, 0x08610af7u, 0x098c0832u, 0x0e1d036bu, 0x02040625u, 0x04d30b9eu, 0x0b0102bdu,
+    0x06db04acu, 0x09e50f81u, 0x081403f9u, 0x0b2501c8u, 0x026e072eu, 0x05c70118u, 0x0cc10c1cu, 0x07ce0399u,
+    0x09c80a4cu, 0x0f95065fu, 0x02bb0080u, 0x081d0485u, 0x03eb0a0fu, 0x0e3e0d63u, 0x076102d0u, 0x01f0091fu,
+    0x0395002fu, 0x0a580492u, 0x09220c3au, 0x02fc014eu, 0x00230cf2u, 0x09b10a1au, 0x04fa0bdbu, 0x085a080fu,
+    0x0ee00927u, 0x046b0e73u, 0x0bb1043du, 0x06c70fbdu, 0x0e140b1eu, 0x0c7004eeu, 0x04fb0f27u, 0x0417087eu,
+    0x0d210a39u, 0x056b04d0u, 0x00520e92u, 0x09c60683u, 0x019f002bu, 0x0fa60f25u, 0x03240c3du, 0x0a15056du,
+    0x089c0876u, 0x072304c2u, 0x0e3a0674u, 0x095e0081u, 0x07ee0f1cu, 0x03090474u, 0x05140610u, 0x0cb10e29u,
+    0x0b71078du, 0x0a200990u, 0x00cf0d04u, 0x0e7d0b61u, 0x04490de1u, 0x02850060u, 0x0c4d0f17u, 0x012c0a25u,
+    0x0eb9075au, 0x0d0a0fcfu, 0x009904cdu, 0x0c6c0c7cu, 0x0a4d01f3u, 0x07e309a1u, 0x0d3b0e5bu, 0x00430aa8u,
+    0x0feb001du, 0x0dba07ceu, 0x01890c3bu, 0x0c570e6cu, 0x072b0d08u, 0x08f40995u, 0x03060558u, 0x015107dfu,
+    0x057f01a7u, 0x00490eccu, 0x0a9c0772u, 0x06330df3u, 0x00f50593u, 0x09f901d2u, 0x0ce903d8u, 0x0fe50c73u,
+    0x0bf80ef6u, 0x07ec022eu, 0x0d13081du, 0x060a0fc7u, 0x0db00418u, 0x0b490635u, 0x06e10238u, 0x032a0d71u,
+    0x0d640179u, 0x00610a83u, 0x09a00d17u, 0x0faf067bu, 0x01cf004fu, 0x060f099du, 0x0a4c027au, 0x096806b0u,
+    0x0e40008au, 0x07ed0c4du, 0x0f6402f1u, 0x0b8e0d36u, 0x07670b5eu, 0x065f03a9u, 0x046d06d8u, 0x001a0122u,
+    0x0bc70ac9u, 0x04f30324u, 0x02a10cf5u, 0x06410b32u, 0x00980931u, 0x0dfb0a66u, 0x0ef40162u, 0x02150c70u,
+    0x088c0201u, 0x0fe00415u, 0x037400b8u, 0x0ab307eau, 0x017602dcu, 0x0dde093eu, 0x09fc0498u, 0x033505dau,
+    0x0a9101bau, 0x06080e45u, 0x07140680u, 0x04510a5cu, 0x016b0ef8u, 0x0672072cu, 0x03ad03cau, 0x08b30598u,
+    0x02eb0d58u, 0x044e06bdu, 0x062e0246u, 0x0e3208c1u, 0x005c0356u, 0x0fb20054u, 0x0bba0f3bu, 0x04000d85u,
+    0x0d540910u, 0x06ef0b98u, 0x0ca60296u, 0x0ec0088du, 0x0b990b09u, 0x088b0e9fu, 0x02f309bau, 0x067e0533u,
+    0x04b50649u, 0x01000ac6u, 0x025206f8u, 0x0f300975u, 0x043e02f8u, 0x019a0ec7u, 0x0fd00b01u, 0x02260710u,
+    0x079305b1u, 0x0a5b03b1u, 0x053d08a9u, 0x08d002efu, 0x03440806u, 0x0b4d05c2u, 0x0f1a0cd2u, 0x00b70b6fu,
+    0x03040e44u, 0x0ab90433u, 0x0221093cu, 0x03fc058fu, 0x08ec0a0eu, 0x0cef082bu, 0x0af20472u, 0x07c80d7bu,
+    0x0f4709ccu, 0x01410ec1u, 0x0a570790u, 0x0d0e0237u, 0x0b330e66u, 0x045003afu, 0x0a0306dau, 0x061b0da3u,
+    0x02cf0535u, 0x078b0feau, 0x0d490644u, 0x04ff0a87u, 0x090a055bu, 0x06400eb8u, 0x07ef0241u, 0x05700cd9u,
+    0x08b10ba3u, 0x01e508cbu, 0x0db40400u, 0x02da02aau, 0x0f490088u, 0x0bf20cebu, 0x0e9a08e0u, 0x0a98017bu,
+    0x07730f0cu, 0x0ba9096du, 0x094a0502u, 0x03920b91u, 0x051805f5u, 0x0a2f0ad1u, 0x085606b4u, 0x0ea90435u,
+    0x0b0300a4u, 0x08ca052bu, 0x035b03a6u, 0x02020cbau, 0x05280692u, 0x0f1d005bu, 0x0036079du, 0x09600d0fu,
+    0x0add08b4u, 0x0e950373u, 0x07030e32u, 0x085100c0u, 0x0ab60547u, 0x057d07c2u, 0x09420017u, 0x0bc80495u,
+    0x0e440f65u, 0x03fe0c5du, 0x0d1f00f3u, 0x00d40f0au, 0x07560bc5u, 0x0d970ddcu, 0x08320389u, 0x0185079au,
+    0x06e901abu, 0x0c520856u, 0x06060f6fu, 0x0d8e0255u, 0x00fe00beu, 0x02ca0eddu, 0x0e550c74u, 0x022e029eu,
+    0x0c8f0617u, 0x05d0003au, 0x03de042du, 0x0fb7084au, 0x08bc0595u, 0x073a00feu, 0x012d0bbcu, 0x0da3090bu,
+    0x09590ae1u, 0x005b0852u, 0x0c190e5cu, 0x070a0192u, 0x0f730c4cu, 0x0cc306e5u, 0x00630ad7u, 0x0e460378u,
+    0x03be07cbu, 0x0fa70148u, 0x0b8a0dcbu, 0x07a30959u, 0x09310bdcu, 0x054404e8u, 0x00ff0803u, 0x05d80b6cu,
+    0x0ce30327u, 0x01f70a79u, 0x0f4100e5u, 0x0abd0ff0u, 0x0d2307a9u, 0x013b0decu, 0x064502cbu, 0x023f0c92u,
+    0x00b20e36u, 0x04910a95u, 0x09870fdau, 0x0db9096fu, 0x072c017cu, 0x04200463u, 0x0c670f7au, 0x05b60102u,
+    0x0dee0b66u, 0x03b701acu, 0x0c410d50u, 0x09e00bd1u, 0x00b10a53u, 0x0ccb0ca1u, 0x038f0dc9u, 0x066f098au,
+    0x01310b71u, 0x05ed0286u, 0x0aeb073du, 0x0ef00a1cu, 0x024c0482u, 0x049a0125u, 0x0ca40a9au, 0x05870fe9u,
+    0x09230517u, 0x0e910af3u, 0x04ba0bfeu, 0x0a22064cu, 0x0ef60dccu, 0x054e0762u, 0x09b40193u, 0x06e508c0u,
+    0x091e0fa8u, 0x0e070be7u, 0x081b0dc3u, 0x01f40a23u, 0x0c3d0c9fu, 0x05450f83u, 0x037707cdu, 0x0b850009u,
+    0x0f3c035du, 0x0581028cu, 0x03f409e5u, 0x022003d9u, 0x0b5a0d5eu, 0x02f70882u, 0x049d00d6u, 0x0ae809b1u,
+    0x0c380f4fu, 0x098f0572u, 0x04f70b21u, 0x00260700u, 0x0af605f8u, 0x0d7f0fb9u, 0x02640251u, 0x09ce0debu,
+    0x049b062du, 0x00b30c8eu, 0x07f80429u, 0x02b80d37u, 0x070f0152u, 0x046104b6u, 0x0deb09eeu, 0x079a0848u,
+    0x0bd70717u, 0x0fd70601u, 0x05fa0211u, 0x016407dbu, 0x0b430da8u, 0x0a190c1au, 0x07da0a43u, 0x022502e2u,
+    0x014404e5u, 0x08f50f29u, 0x051205deu, 0x02cb042fu, 0x0d9a0209u, 0x07b80880u, 0x0ea80366u, 0x08a3013cu,
+    0x0c890620u, 0x02c40e10u, 0x081308fau, 0x0bf50542u, 0x06990e96u, 0x09fe0220u, 0x03e30947u, 0x0ff90622u,
+    0x0bb5031du, 0x03720734u, 0x006b0116u, 0x074403fdu, 0x083508fdu, 0x0c150a81u, 0x03a504b8u, 0x007b0b42u,
+    0x04b4035au, 0x0b6706feu, 0x03200518u, 0x06b601b4u, 0x003402e0u, 0x0ebe063bu, 0x0cfa048fu, 0x07eb0ebcu,
+    0x0a9a0d22u, 0x018d0bfbu, 0x0e4d0743u, 0x09a80089u, 0x083304e1u, 0x01010f9eu, 0x0efb0659u, 0x07420e12u,
+    0x02710461u, 0x01340021u, 0x063b0cb4u, 0x0e6d0336u, 0x037a0e63u, 0x084b0113u, 0x0718045cu, 0x0f810996u,
+    0x0de60095u, 0x08e9073eu, 0x0c240871u, 0x058c0298u, 0x0e7e094au, 0x09950ee7u, 0x0c6201e3u, 0x032d0bf6u,
+    0x055a010au, 0x0a5c0eb4u, 0x0d1104a2u, 0x081a0b43u, 0x0e710357u, 0x02c5059du, 0x0f5606e8u, 0x0d4c0e08u,
+    0x06c3083du, 0x0bb209c8u, 0x0f980745u, 0x063e0922u, 0x01c90e84u, 0x04a60689u, 0x0b0a0ff7u, 0x002d0786u,
+    0x09f30a8du, 0x0f7b0411u, 0x04ef0061u, 0x01740c7fu, 0x0915069eu, 0x0e5a0d2du, 0x00060874u, 0x0a830014u,
+    0x01db0da9u, 0x08950caau, 0x0cd009afu, 0x0b2a0f13u, 0x014c02e4u, 0x06560cfau, 0x0fd605b3u, 0x0a600e4bu,
+    0x0d390108u, 0x011e0969u, 0x0f260adbu, 0x09dd0efau, 0x0ae908b5u, 0x09340b53u, 0x021009b3u, 0x067401eau,
+    0x046306aau, 0x08c605b4u, 0x0ca30f28u, 0x05ec0913u, 0x0a660b44u, 0x0dae02e5u, 0x067b01aeu, 0x091d0bcau,
+    0x0d5b076cu, 0x08270a6au, 0x0a72087fu, 0x0cc901e5u, 0x04740a11u, 0x01ab07a3u, 0x0c4e0d41u, 0x0b110af8u,
+    0x03c30f55u, 0x069e0544u, 0x0ef30e9au, 0x01900c11u, 0x0b3b0682u, 0x001b0b29u, 0x08b5058au, 0x0ed90335u,
+    0x06da0905u, 0x02a60d1eu, 0x01030a18u, 0x03c000b1u, 0x06850f24u, 0x0074091cu, 0x04af0233u, 0x0a940bbfu,
+    0x034b03c7u, 0x080e002au, 0x004d0b16u, 0x0e6702afu, 0x0a5400edu, 0x06f00bfdu, 0x0f1804cau, 0x024f0cdfu,
+    0x042a01ccu, 0x072d0f31u, 0x0da107f1u, 0x0391030fu, 0x0d030affu, 0x05d203d7u, 0x02ba0ee8u, 0x079f0a2au,
+    0x06860475u, 0x0df40232u, 0x027e0e5du, 0x0f54053bu, 0x044d0043u, 0x0da60babu, 0x020106c7u, 0x08790223u,
+    0x05980808u, 0x07700d4cu, 0x043703f8u, 0x0dad00d0u, 0x05f30727u, 0x04be0cf4u, 0x02d60391u, 0x0e7a0e24u,
+    0x008a0aa2u, 0x06ec0137u, 0x0f96043eu, 0x034f0de9u, 0x04ea0a29u, 0x0c0807deu, 0x03d10cf8u, 0x01bd05e2u,
+    0x0590027bu, 0x0ede0d78u, 0x03020506u, 0x06c40ec8u, 0x0fcc03c5u, 0x099f0c36u, 0x05f6068au, 0x02dd08aeu,
+    0x0056036cu, 0x052101c1u, 0x0a3a0a03u, 0x036d03c3u, 0x0cff000cu, 0x06090774u, 0x03f00f8bu, 0x01dd040fu,
+    0x0b630c2eu, 0x0dfe07a2u, 0x093902b9u, 0x0c300646u, 0x0897085bu, 0x0cd70d03u, 0x05de0136u, 0x099e0fc4u,
+    0x0e2c0652u, 0x0b1d0d64u, 0x04390c79u, 0x0c7b0f59u, 0x09510566u, 0x03280ac8u, 0x0ba10300u, 0x05760953u,
+    0x0e09059eu, 0x09620b8au, 0x0aa00d6au, 0x009609c3u, 0x0b790144u, 0x0869075eu, 0x0f2b056bu, 0x0b0b0c3cu,
+    0x052a07d9u, 0x03f80b49u, 0x09c50671u, 0x05c4089bu, 0x09290789u, 0x03160fdcu, 0x0acd03b6u, 0x0c5a0a42u,
+    0x0e980ebfu, 0x0298062au, 0x0bd20c29u, 0x08450289u, 0x01590587u, 0x0fe70fb6u, 0x0c540070u, 0x0a120511u,
+    0x0ba40793u, 0x0d5908aau, 0x02820ca6u, 0x014a0222u, 0x07870583u, 0x00180393u, 0x0ff70efeu, 0x09d1097fu,
+    0x0c6b03f2u, 0x04250ff5u, 0x007100a9u, 0x0bbb0b75u, 0x08a10934u, 0x00e80560u, 0x0e470047u, 0x07b30280u,
+    0x0d1d0e3fu, 0x0bc30b87u, 0x0865060du, 0x024d0db5u, 0x07470cecu, 0x0a930894u, 0x0f550a82u, 0x08040dd9u,
+    0x09ef005au, 0x0478051au, 0x0eb50b7au, 0x05430e94u, 0x0ac70401u, 0x0fbe0ac3u, 0x01ca050cu, 0x07300787u,
+    0x00ef0a2du, 0x056301e2u, 0x026a048cu, 0x08940822u, 0x05d40716u, 0x0d4f0e56u, 0x0158003fu, 0x0868086au,
+    0x0c2f0e8eu, 0x0613026au, 0x01fe049eu, 0x0fbf060au, 0x06d40f6bu, 0x046c0bcbu, 0x00f102beu, 0x0d8600b5u,
+    0x0c260facu, 0x0e99038fu, 0x008d01b7u, 0x06fa0abau, 0x0bcf0d79u, 0x07a50167u, 0x04d00982u, 0x017b0c99u,
+    0x068700b2u, 0x095c04a9u, 0x00900911u, 0x0cdd0defu, 0x03820a4bu, 0x073f0828u, 0x08820c58u, 0x0522095au,
+    0x03ac02c8u, 0x07d70b9fu, 0x0b080fd2u, 0x093b002du, 0x0e020708u, 0x0aa10c50u, 0x08620159u, 0x02c90893u,
+    0x0b310ae6u, 0x07bf06c0u, 0x0dfa0807u, 0x0a100621u, 0x025502d9u, 0x056e0f7cu, 0x0aa80abdu, 0x0f2c0cc3u,
+    0x092f076bu, 0x01380487u, 0x0dd70820u, 0x0ff400dfu, 0x095302f9u, 0x04dd04dfu, 0x0d8f01b6u, 0x00c7065bu,
+    0x05cf09c7u, 0x07760fb1u, 0x022f0170u, 0x00a20725u, 0x031f0c94u, 0x0bbf0052u, 0x04050e59u, 0x08ff0338u,
+    0x0ee6089eu, 0x0cfc05c3u, 0x078a0df8u, 0x0fde038bu, 0x009a0146u, 0x03ee09d5u, 0x076d0d82u, 0x0f6203cbu,
+    0x00e906cbu, 0x033d0a5bu, 0x07f2008bu, 0x054708dcu, 0x0c900dfcu, 0x0a3701f4u, 0x034c0983u, 0x094706c4u,
+    0x01a20dddu, 0x07f70909u, 0x0a6d04dbu, 0x0d2c0c44u, 0x011102a7u, 0x0f1b0464u, 0x0e2e0850u, 0x09e60568u,
+    0x03ca0317u, 0x0f970f87u, 0x05400775u, 0x0a740b36u, 0x0e37015bu, 0x0b36045fu, 0x00da022cu, 0x0dca0f04u,
+    0x01bb0dc8u, 0x05a40618u, 0x0ec503c6u, 0x0c79083bu, 0x06a30b11u, 0x056f0e2eu, 0x0e9004c6u, 0x04ac00d3u,
+    0x00f90e68u, 0x062b0216u, 0x0f4a0c63u, 0x04cc0d31u, 0x07600171u, 0x0d750dc4u, 0x03e10407u, 0x01e7097eu,
+    0x04a30117u, 0x06f50fd0u, 0x05cc0a73u, 0x04130eacu, 0x007c0960u, 0x0c720b5bu, 0x02f50f0du, 0x0be70276u,
+    0x03800d54u, 0x0fa108bdu, 0x0d2e0363u, 0x069d0599u, 0x0a1709ecu, 0x07c7025bu, 0x0d930944u, 0x02a40c16u,
+    0x0c090ed0u, 0x09da00aeu, 0x018f0a98u, 0x0b810914u, 0x0dc60bbbu, 0x0ad6061fu, 0x09b70c62u, 0x04c0018fu,
+    0x0cdc07b2u, 0x0b2b0fbeu, 0x0e6f0ca9u, 0x08f803a0u, 0x027907e5u, 0x0e3f04f0u, 0x07570d14u, 0x061a0a94u,
+    0x04de05d4u, 0x02540101u, 0x0fcd0ed3u, 0x03a909d9u, 0x05560607u, 0x02ae0f2bu, 0x084d0e15u, 0x00460acdu,
+    0x0d670bccu, 0x0b6c0688u, 0x07e20029u, 0x01d403a3u, 0x06160e9eu, 0x027c05eeu, 0x096506d5u, 0x0f070b0cu,
+    0x066700a3u, 0x09ea04d4u, 0x007809eau, 0x04670d32u, 0x03760266u, 0x0200066cu, 0x0cf70a4au, 0x071d0bf7u,
+    0x0da7056cu, 0x08d50325u, 0x01c808fcu, 0x0cab0486u, 0x03310a60u, 0x0b6606ffu, 0x06880858u, 0x0c4505a7u,
+    0x0a250be2u, 0x031006b5u, 0x0b5b023eu, 0x0ea0055fu, 0x07b90c56u, 0x068f0709u, 0x017903f3u, 0x08d807feu,
+    0x0b020ae4u, 0x012a0484u, 0x0c510dfeu, 0x08640bb6u, 0x0f1407eeu, 0x04940daau, 0x00370446u, 0x065506b9u,
+    0x05160b33u, 0x038802bcu, 0x06b20ce3u, 0x04a10fd3u, 0x02e90217u, 0x0624046bu, 0x0e960eefu, 0x025b0aecu,
+    0x06af04fbu, 0x0a0f0bacu, 0x006a0111u, 0x042c068eu, 0x0be60b2au, 0x016c0eafu, 0x0d420413u, 0x0f60083fu,
+    0x0b900322u, 0x08a00b81u, 0x0c85074au, 0x064e0cefu, 0x098b0064u, 0x0b4106e7u, 0x0cae0133u, 0x05f107acu,
+    0x071b025du, 0x02f20d9au, 0x08fa09ceu, 0x047c08b2u, 0x0f5e0d10u, 0x06f10bf5u, 0x04080a14u, 0x0cd60361u,
+    0x0ad308d9u, 0x02c1075cu, 0x08980126u, 0x0f780eb6u, 0x0b74091eu, 0x00b8034du, 0x091f0fa0u, 0x0bb9072au,
+    0x027f0d55u, 0x03bd09c1u, 0x0af70f66u, 0x09720794u, 0x00c100bdu, 0x0eea0f09u, 0x08c401ffu, 0x00150e2du,
+    0x0f750321u, 0x08090d05u, 0x0cd903ceu, 0x021808cau, 0x0ac80184u, 0x09cf0e0cu, 0x0f0b05b5u, 0x0e1f0cabu,
+    0x063f069bu, 0x0431021au, 0x096a0096u, 0x055c0f62u, 0x0198063au, 0x0b6e019bu, 0x0e180555u, 0x0aba0f8au,
+    0x0f71013eu, 0x0844076fu, 0x0e6104e6u, 0x0a480693u, 0x08c707e6u, 0x01cc030bu, 0x0c0308d8u, 0x092d05c7u,
+    0x03b6027du, 0x0d900965u, 0x07910d96u, 0x0ee902f3u, 0x066109f2u, 0x09ac018eu, 0x00a90094u, 0x03dc0c77u,
+    0x0a960f54u, 0x030a0227u, 0x001f0432u, 0x0dda0887u, 0x075b0302u, 0x01ac0b3du, 0x04350954u, 0x0a9d0403u,
+    0x0e0d0ccfu, 0x00c801a5u, 0x0c1a0f1bu, 0x0d2504feu, 0x0a0102b3u, 0x0bab07e2u, 0x0000017au, 0x07ff0d81u,
+    0x04c50c7du, 0x0c3e0f7eu, 0x07350a8fu, 0x0d85059bu, 0x0a3e045au, 0x07ea0074u, 0x0f2107ecu, 0x05b801d3u,
+    0x09f7042eu, 0x0fb80001u, 0x06b105dfu, 0x052e0b08u, 0x0e220385u, 0x07c40c2au, 0x05b50503u, 0x028c09f9u,
+    0x0dcc0028u, 0x096607d4u, 0x010d0b04u, 0x055b0f26u, 0x0db8007eu, 0x03d80a0cu, 0x050b032bu, 0x08200112u,
+    0x00090ec9u, 0x0a730780u, 0x02960a62u, 0x0e6208e2u, 0x036c0305u, 0x07130d18u, 0x08c10a24u, 0x021f084du,
+    0x0c970398u, 0x014d09bbu, 0x00870dd4u, 0x0d160056u, 0x0f2d0a63u, 0x07d50e33u, 0x000e0d30u, 0x0584007cu,
+    0x0f880f34u, 0x0197041eu, 0x0508076eu, 0x02dc0e6eu, 0x087a05ddu, 0x0afd0fa3u, 0x05a2072bu, 0x07d9092bu,
+    0x0e12053au, 0x06ad0da6u, 0x09f60a28u, 0x04750ea3u, 0x0eca0594u, 0x08b70c2du, 0x0fa80fb4u, 0x02320514u,
+    0x04fd0870u, 0x0edd060cu, 0x039e0aaeu, 0x0135071bu, 0x055400ffu, 0x0eb00ff3u, 0x032f0582u, 0x0902043au,
+    0x0fc5020eu, 0x02170685u, 0x010702e9u, 0x051d0c22u, 0x062f0df2u, 0x02e70ce7u, 0x04300b4fu, 0x014e08ceu,
+    0x0cbf0ee1u, 0x00320badu, 0x08500e21u, 0x0c13023au, 0x01630d09u, 0x041b0668u, 0x0d0c08b6u, 0x0b0e0b64u,
+    0x04cf0f97u, 0x03b90615u, 0x066b0d7fu, 0x0c0604b9u, 0x08ab078bu, 0x02ab0bf9u, 0x01b30fe2u, 0x0c9d0946u,
+    0x0d720b6eu, 0x0f4603c1u, 0x07a00c6fu, 0x0bd504edu, 0x0d3e0ee4u, 0x09e20af6u, 0x05a90000u, 0x042d0cafu,
+    0x097a0e79u, 0x077105a6u, 0x0bea0c52u, 0x0557040du, 0x04150b79u, 0x06d7016cu, 0x0ddb071fu, 0x0c8709fau,
+    0x08630833u, 0x0a8f0c23u, 0x0bb601e4u, 0x0d180520u, 0x0fed08a1u, 0x04a90beau, 0x0cb3028au, 0x02290afbu,
+    0x0f0a069cu, 0x0192004bu, 0x053307cau, 0x0c2c01afu, 0x00e40d60u, 0x033903aau, 0x0bbc00a0u, 0x0a0e0a21u,
+    0x07d00e80u, 0x097e02f2u, 0x06590468u, 0x08740c59u, 0x07510df9u, 0x0d8c0b47u, 0x019e09adu, 0x05e80881u,
+    0x0e130e2cu, 0x0b350b7du, 0x03d90817u, 0x0993016fu, 0x0e5c0999u, 0x0c820638u, 0x0ac40521u, 0x0de40a19u,
+    0x079502d3u, 0x048c06a7u, 0x0e77083cu, 0x02a504b0u, 0x0a710979u, 0x09a40ec5u, 0x0fdb0161u, 0x019d042au,
+    0x073702a8u, 0x0a8b094du, 0x0ef501b3u, 0x00540a65u, 0x076b0675u, 0x0fcf0268u, 0x0b680847u, 0x070c050du,
+    0x090b0605u, 0x01ed0d45u, 0x04c70272u, 0x062200e2u, 0x007e06f0u, 0x014003f4u, 0x0fef07abu, 0x02c0029du,
+    0x0d8a0b96u, 0x061501fcu, 0x0360092fu, 0x0ae30869u, 0x09c20f79u, 0x0277053du, 0x0b1f0c89u, 0x03530369u,
+    0x00dd065cu, 0x06100ad4u, 0x07320cfbu, 0x0205000au, 0x00350a58u, 0x03660462u, 0x09490d40u, 0x0b9f0368u,
+    0x07260e4eu, 0x08fc0c0fu, 0x0d7d04c7u, 0x0aca0ac2u, 0x07fc090cu, 0x0d3006beu, 0x05b10225u, 0x06cb0dd0u,
+    0x01840753u, 0x0cc60bc7u, 0x0f90006du, 0x0b2208e7u, 0x026903d0u, 0x0a8a0666u, 0x045c000du, 0x09be0ecdu,
+    0x06be0505u, 0x0d0100c3u, 0x07ab03e3u, 0x0ef90f51u, 0x0062074bu, 0x022a024du, 0x08930e53u, 0x067103b2u,
+    0x033c0176u, 0x0b6f0c76u, 0x05a50a7du, 0x0ce800fau, 0x06eb0304u, 0x035e07bau, 0x061d0db6u, 0x0889070bu,
+    0x0c830c37u, 0x0e2f056eu, 0x03170e6bu, 0x091c0349u, 0x0cee0cd0u, 0x046a0417u, 0x0a2b0db3u, 0x0575002cu,
+    0x0e6e09f3u, 0x031b0e46u, 0x0af9086fu, 0x087e0993u, 0x0ca00bebu, 0x0e840e22u, 0x0a8e090fu, 0x07fd04c5u,
+    0x0b5d066du, 0x0f3e0f2cu, 0x01ef00e6u, 0x0e36033eu, 0x0118063fu, 0x0fd30261u, 0x04d80eb9u, 0x0974049du,
+    0x0ed700d8u, 0x04430fe5u, 0x091b0903u, 0x0e26039du, 0x0a2a0dffu, 0x068907f0u, 0x0ea700f8u, 0x00d90611u,
+    0x043409a9u, 0x02ef014bu, 0x0fc10ffbu, 0x05ff02cau, 0x026c05f0u, 0x03ec0f18u, 0x0e730819u, 0x002e0b18u,
+    0x0db50163u, 0x02e50988u, 0x04420f96u, 0x00810d2fu, 0x0c880228u, 0x0e6c07afu, 0x07d20329u, 0x0c180a69u,
+    0x013f0724u, 0x03110d24u, 0x058808eeu, 0x08ed0b13u, 0x0bd904d6u, 0x071f0097u, 0x04e00bf0u, 0x0f9f0fd6u,
+    0x0981079bu, 0x01eb0552u, 0x0f020dd1u, 0x08e70f71u, 0x006805d3u, 0x0df70ae3u, 0x0be50071u, 0x00b00a1eu,
+    0x02410f1eu, 0x05890867u, 0x09f8009fu, 0x017f0ba1u, 0x060b08e9u, 0x0df30eb3u, 0x03610ac1u, 0x00d101c5u,
+    0x0668032eu, 0x09b806b7u, 0x0fa50f95u, 0x04240559u, 0x075401d1u, 0x037f05f9u, 0x05070ffau, 0x0697014du,
+    0x00240ab9u, 0x04960736u, 0x09060da1u, 0x073b0a20u, 0x084e0b23u, 0x0cc007bbu, 0x064d097cu, 0x07a70bb8u,
+    0x0d880db9u, 0x029902dbu, 0x0c680702u, 0x054f05fau, 0x07f30f10u, 0x0b2901f9u, 0x0da80aa4u, 0x05740f50u,
+    0x084008c4u, 0x0c0103dfu, 0x00670718u, 0x09a30c97u, 0x073c0b94u, 0x0b52045du, 0x09010d1au, 0x04ce0551u,
+    0x0a95037du, 0x0bef0670u, 0x058e04c1u, 0x09120a4fu, 0x063a05a2u, 0x037c0f4du, 0x05130cbbu, 0x00a10ba5u,
+    0x0f280263u, 0x0a7005f3u, 0x01d90a05u, 0x0b150343u, 0x039c0d7eu, 0x0d6a0838u, 0x00d70a9fu, 0x0c43093du,
+    0x0a840d1cu, 0x01140063u, 0x07df08bfu, 0x044c03fbu, 0x0b260ba4u, 0x050e0ce8u, 0x078204f3u, 0x0f1c0395u,
+    0x047f0212u, 0x0b840d1bu, 0x07e4046au, 0x0f8306deu, 0x0afc0120u, 0x02330581u, 0x0860074fu, 0x0c5d0c01u,
+    0x07b40810u, 0x016f0139u, 0x0dc40440u, 0x02590b48u, 0x0b8d0d25u, 0x09380315u, 0x01c709fcu, 0x0c4b0d6fu,
+    0x0dff03adu, 0x0a0d0826u, 0x0d050c95u, 0x059b047fu, 0x030c0025u, 0x0bcb0e05u, 0x007901a6u, 0x01e40885u,
+    0x0b9305a1u, 0x0ab40153u, 0x01560a0du, 0x0f840b8cu, 0x03fa04bbu, 0x011f0c48u, 0x0274074cu, 0x09eb054cu,
+    0x0d1e0cd7u, 0x0a90023bu, 0x04b70846u, 0x015309f4u, 0x0f12001eu, 0x0c8d0134u, 0x01be0938u, 0x0f69027cu,
+    0x080d0c3fu, 0x07120eaeu, 0x0ec800dau, 0x0a1a0813u, 0x01e60b1bu, 0x0ffc016bu, 0x0b470921u, 0x092c0436u,
+    0x0dab0ddau, 0x08570fcau, 0x04a201cau, 0x0f8d0c54u, 0x060d0e88u, 0x0a0406adu, 0x02c20103u, 0x0ec205e4u,
+    0x03f10465u, 0x0626071eu, 0x0d330275u, 0x026609c6u, 0x0f7f019fu, 0x0a40069fu, 0x03030908u, 0x09250e30u,
+    0x0cde079eu, 0x069f0631u, 0x038c0a93u, 0x00fb0fafu, 0x051509cdu, 0x06e80235u, 0x0f110f45u, 0x0b9a04aeu,
+    0x04e60ca0u, 0x0cc80eabu, 0x05c10a72u, 0x00ac00bcu, 0x0a3d0768u, 0x0d550855u, 0x0efd0c0eu, 0x0892006cu,
+    0x02a0054du, 0x03db0ed6u, 0x00ba02b4u, 0x0ac605cfu, 0x0eaf0fc6u, 0x045b06e6u, 0x0a3203bfu, 0x0f630ab0u,
+    0x05910cb8u, 0x06cf0788u, 0x03400ea0u, 0x08a60091u, 0x0cec0970u, 0x073802b0u, 0x0f320d9cu, 0x062500b4u,
+    0x036f0b62u, 0x0ebc0e7bu, 0x06d604e2u, 0x0dc80dbdu, 0x08750eecu, 0x033f0791u, 0x064b0a9eu, 0x09c40f70u,
+    0x025a08a4u, 0x03b80732u, 0x01090da0u, 0x0cbd02a1u, 0x08310e71u, 0x06d206b6u, 0x0d1204ecu, 0x02360100u,
+    0x03ed085au, 0x066a06dcu, 0x0c58003du, 0x002b057cu, 0x0de00445u, 0x0815028du, 0x05680f2fu, 0x08ce033bu,
+    0x07410b5fu, 0x0e480ed9u, 0x0bbd0c4au, 0x09af0e4du, 0x067a081au, 0x013c0ffcu, 0x0d6e029fu, 0x01bc0beeu,
+    0x0a9f00ddu, 0x0e890b4bu, 0x08a502edu, 0x0d9c0dc7u, 0x0cad07efu, 0x094403acu, 0x006f0d5bu, 0x03e80912u
+};
+
+#endif // BLUENOISETABLE_H
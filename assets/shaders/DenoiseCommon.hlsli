@@ -16,15 +16,7 @@ Texture2D<float4> gDirectLighting : register(t0);
 Texture2D<float4> gInput : register(t1);
 RWTexture2D<float4> gOutput : register(u0);
 
-cbuffer Params : register(b0)
-{
-    float gExposure;
-    float gGamma;
-    uint gTonemap;
-    uint gGammaCorrect;
-    int gMaxKernelSize;
-    uint gDebugVisualize;
-}
+#include "DenoiseParams.hlsli"
 
 float calcLuminance(float3 color)
 {
@@ -47,13 +39,18 @@ float3 linearToSRGB(float3 color)
 void main(uint3 dispatchID : SV_DispatchThreadID, uint3 threadID : SV_GroupThreadID, uint3 groupID : SV_GroupID)
 {
     float3 color;
+#if PASS == 2
+    // Both inputs come filtered from DenoiseCompositorAtrous.hlsl
+    color = gInput[dispatchID.xy].rgb;
+#else
     if (gDebugVisualize == 2) {
         color = gInput[dispatchID.xy].rgb;
     } else {
         color = filterKernel(gMaxKernelSize, float(gMaxKernelSize), dispatchID.xy, gInput, gDirectLighting, threadID.xy, dispatchID.xy).rgb;
     }
+#endif
 
-#if PASS == 1
+#if PASS >= 1
     if (gDebugVisualize == 0) {
         color += gDirectLighting[dispatchID.xy].rgb;
     } else if (gDebugVisualize == 1) {
@@ -0,0 +1,142 @@
+#define HLSL
+#include "AtrousHlslCompat.h"
+#include "AovHlslCompat.h"
+#include "DenoiseParams.hlsli"
+
+// Outputs of the realtime pipeline, or of the previous iteration with the filtered variance in alpha
+Texture2D<float4> gDirectLighting : register(t0);
+Texture2D<float4> gIndirectSpecular : register(t1);
+// AOVs of the primary hits, see AovHlslCompat.h, and the luminance variance of both outputs from
+// TemporalAccumulation.hlsl. Albedo and instance ID are only read with gDemodulateAlbedo and gInstanceEdges.
+Texture2D<float> gDepth : register(t2);
+Texture2D<float2> gNormal : register(t3);
+Texture2D<float2> gVariance : register(t4);
+Texture2D<float4> gAlbedo : register(t5);
+Texture2D<uint> gInstanceId : register(t6);
+RWTexture2D<float4> gDirectLightingOutput : register(u0);
+RWTexture2D<float4> gIndirectSpecularOutput : register(u1);
+
+cbuffer AtrousConstants : register(b1)
+{
+    uint gIteration;
+    uint gIterationCount;
+    uint gDemodulateAlbedo;
+    uint gInstanceEdges;
+}
+
+#define ATROUS_GROUP_SIZE 8
+
+float3 demodulationFactor(int2 pixel)
+{
+    return gDemodulateAlbedo ? atrousDemodulationFactor(gAlbedo[pixel].rgb) : 1.0;
+}
+
+// The signals with their variance in alpha, the first iteration divides the direct lighting by the albedo
+float4 loadDirectLighting(int2 pixel)
+{
+    if (gIteration > 0) {
+        return gDirectLighting[pixel];
+    }
+    float3 factor = demodulationFactor(pixel);
+    float luminanceFactor = atrousLuminance(factor);
+    return float4(gDirectLighting[pixel].rgb / factor, gVariance[pixel].x / (luminanceFactor * luminanceFactor));
+}
+
+float4 loadIndirectSpecular(int2 pixel)
+{
+    return gIteration > 0 ? gIndirectSpecular[pixel] : float4(gIndirectSpecular[pixel].rgb, gVariance[pixel].y);
+}
+
+float loadDepth(int2 pixel, int2 dims)
+{
+    return gDepth[clamp(pixel, 0, dims - 1)];
+}
+
+// The last iteration multiplies the albedo back in
+float4 storeDirectLighting(int2 pixel, float4 direct)
+{
+    if (gIteration + 1 < gIterationCount) {
+        return direct;
+    }
+    float3 factor = demodulationFactor(pixel);
+    float luminanceFactor = atrousLuminance(factor);
+    return float4(direct.rgb * factor, direct.a * luminanceFactor * luminanceFactor);
+}
+
+[numthreads(ATROUS_GROUP_SIZE, ATROUS_GROUP_SIZE, 1)]
+void main(uint3 dispatchID : SV_DispatchThreadID)
+{
+    int2 dims;
+    gDirectLighting.GetDimensions(dims.x, dims.y);
+    int2 pixel = int2(dispatchID.xy);
+    if (any(pixel >= dims)) {
+        return;
+    }
+
+    float4 direct = loadDirectLighting(pixel);
+    float4 specular = loadIndirectSpecular(pixel);
+    float depth = gDepth[pixel];
+
+    // Misses show the environment, there is no surface to filter along
+    if (depth <= 0.0) {
+        gDirectLightingOutput[pixel] = storeDirectLighting(pixel, direct);
+        gIndirectSpecularOutput[pixel] = specular;
+        return;
+    }
+
+    float3 normal = aovDecodeNormal(gNormal[pixel]);
+    uint instanceId = gInstanceEdges ? gInstanceId[pixel] : 0;
+
+    // The luminance test is against the smoothed variance, a single pixel's estimate is too noisy
+    float2 smoothedVariance = 0.0;
+    for (int vy = -1; vy <= 1; ++vy) {
+        for (int vx = -1; vx <= 1; ++vx) {
+            int2 tap = clamp(pixel + int2(vx, vy), 0, dims - 1);
+            smoothedVariance += atrousVarianceKernelWeight(vx, vy) * float2(loadDirectLighting(tap).a, loadIndirectSpecular(tap).a);
+        }
+    }
+    float2 luminanceSigma = sqrt(smoothedVariance);
+
+    // The smaller of the one-sided differences, so a silhouette next to the pixel does not count as slope
+    float depthGradient = max(min(abs(loadDepth(pixel + int2(1, 0), dims) - depth), abs(depth - loadDepth(pixel - int2(1, 0), dims))),
+                              min(abs(loadDepth(pixel + int2(0, 1), dims) - depth), abs(depth - loadDepth(pixel - int2(0, 1), dims))));
+
+    float2 luminance = float2(atrousLuminance(direct.rgb), atrousLuminance(specular.rgb));
+    int step = 1 << gIteration;
+
+    float3 directSum = 0.0, specularSum = 0.0;
+    float2 weightSum = 0.0, varianceSum = 0.0;
+    for (int y = -ATROUS_KERNEL_RADIUS; y <= ATROUS_KERNEL_RADIUS; ++y) {
+        for (int x = -ATROUS_KERNEL_RADIUS; x <= ATROUS_KERNEL_RADIUS; ++x) {
+            int2 tap = pixel + int2(x, y) * step;
+            if (any(tap < 0) || any(tap >= dims)) {
+                continue;
+            }
+            float tapDepth = gDepth[tap];
+            if (tapDepth <= 0.0 || (gInstanceEdges && gInstanceId[tap] != instanceId)) {
+                continue;
+            }
+
+            float3 tapNormal = aovDecodeNormal(gNormal[tap]);
+            float4 tapDirect = loadDirectLighting(tap);
+            float4 tapSpecular = loadIndirectSpecular(tap);
+
+            float kernel = atrousKernelWeight(x) * atrousKernelWeight(y);
+            float offsetLength = length(float2(x, y)) * step;
+            float2 weight;
+            weight.x = kernel * atrousEdgeWeight(normal, tapNormal, depth, tapDepth, depthGradient, offsetLength,
+                                                 luminance.x, atrousLuminance(tapDirect.rgb), luminanceSigma.x, gPhiNormal, gPhiDepth, gPhiLuminance);
+            weight.y = kernel * atrousEdgeWeight(normal, tapNormal, depth, tapDepth, depthGradient, offsetLength,
+                                                 luminance.y, atrousLuminance(tapSpecular.rgb), luminanceSigma.y, gPhiNormal, gPhiDepth, gPhiLuminance);
+
+            directSum += tapDirect.rgb * weight.x;
+            specularSum += tapSpecular.rgb * weight.y;
+            weightSum += weight;
+            varianceSum += float2(tapDirect.a, tapSpecular.a) * weight * weight;
+        }
+    }
+
+    // The pixel itself always passes its own edge test, so the sums are never empty
+    gDirectLightingOutput[pixel] = storeDirectLighting(pixel, float4(directSum / weightSum.x, varianceSum.x / (weightSum.x * weightSum.x)));
+    gIndirectSpecularOutput[pixel] = float4(specularSum / weightSum.y, varianceSum.y / (weightSum.y * weightSum.y));
+}
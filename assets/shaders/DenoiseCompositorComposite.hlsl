@@ -0,0 +1,2 @@
+#define PASS 2
+#include "DenoiseCommon.hlsli"
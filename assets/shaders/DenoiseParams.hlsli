@@ -0,0 +1,18 @@
+#ifndef DENOISE_PARAMS_HLSLI
+#define DENOISE_PARAMS_HLSLI
+
+// DenoiseCompositor::DenoiserParams
+cbuffer Params : register(b0)
+{
+    float gExposure;
+    float gGamma;
+    uint gTonemap;
+    uint gGammaCorrect;
+    int gMaxKernelSize;
+    uint gDebugVisualize;
+    float gPhiNormal;
+    float gPhiDepth;
+    float gPhiLuminance;
+}
+
+#endif // DENOISE_PARAMS_HLSLI
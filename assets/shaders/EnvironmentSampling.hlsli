@@ -0,0 +1,76 @@
+#ifndef ENVIRONMENT_SAMPLING_HLSLI
+#define ENVIRONMENT_SAMPLING_HLSLI
+
+#include "RaytracingUtils.hlsli"
+
+// Importance sampling of the environment by the alias tables of RtEnvironmentSampler, which also has
+// the CPU version of these functions. The table holds tableSize.y marginal entries to draw a row, then
+// tableSize.x conditional entries for every row to draw a texel of it.
+struct EnvironmentAliasEntry
+{
+    float threshold;
+    uint alias;
+    float pdf;
+};
+
+EnvironmentAliasEntry loadEnvironmentAliasEntry(ByteAddressBuffer table, uint index)
+{
+    uint3 words = table.Load3(index * 12);
+    EnvironmentAliasEntry entry;
+    entry.threshold = asfloat(words.x);
+    entry.alias = words.y;
+    entry.pdf = asfloat(words.z);
+    return entry;
+}
+
+// Draws one of count entries from first on. The fraction of u left over is returned in u, it places
+// the sample inside the chosen texel.
+uint sampleEnvironmentAliasTable(ByteAddressBuffer table, uint first, uint count, inout float u)
+{
+    float scaled = u * count;
+    uint index = min(uint(scaled), count - 1);
+    float fraction = scaled - float(index);
+
+    EnvironmentAliasEntry entry = loadEnvironmentAliasEntry(table, first + index);
+    if (fraction < entry.threshold) {
+        u = min(fraction / entry.threshold, 0.99999994);
+        return index;
+    }
+    u = min((fraction - entry.threshold) / (1.0 - entry.threshold), 0.99999994);
+    return entry.alias;
+}
+
+// Solid angle pdf of a direction in texel (x, y). The map from lat-long uv to directions stretches
+// areas by 2 pi^2 sin(theta).
+float environmentTexelPdf(ByteAddressBuffer table, uint2 tableSize, uint x, uint y, float3 direction)
+{
+    float sinTheta = sqrt(max(1.0 - direction.y * direction.y, 0.0));
+    float texelPdf = loadEnvironmentAliasEntry(table, tableSize.y + y * tableSize.x + x).pdf;
+    return sinTheta > 0.0 ? texelPdf / (2.0 * M_PI * M_PI * sinTheta) : 0.0;
+}
+
+float3 sampleEnvironmentDirection(ByteAddressBuffer table, uint2 tableSize, float2 u, out float pdf)
+{
+    uint y = sampleEnvironmentAliasTable(table, 0, tableSize.y, u.y);
+    uint x = sampleEnvironmentAliasTable(table, tableSize.y + y * tableSize.x, tableSize.x, u.x);
+
+    float3 direction = latLongToWsVector((float2(x, y) + u) / float2(tableSize));
+    pdf = environmentTexelPdf(table, tableSize, x, y, direction);
+    return direction;
+}
+
+float evaluateEnvironmentPdf(ByteAddressBuffer table, uint2 tableSize, float3 direction)
+{
+    float2 uv = wsVectorToLatLong(direction);
+    uint2 texel = min(uint2(uv * float2(tableSize)), tableSize - 1);
+    return environmentTexelPdf(table, tableSize, texel.x, texel.y, normalize(direction));
+}
+
+// Weight of a sample drawn with pdf against another strategy that could have drawn it with otherPdf
+float powerHeuristic(float pdf, float otherPdf)
+{
+    float pdf2 = pdf * pdf;
+    return pdf2 > 0.0 ? pdf2 / (pdf2 + otherPdf * otherPdf) : 0.0;
+}
+
+#endif // ENVIRONMENT_SAMPLING_HLSLI
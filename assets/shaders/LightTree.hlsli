@@ -0,0 +1,154 @@
+#ifndef LIGHT_TREE_HLSLI
+#define LIGHT_TREE_HLSLI
+
+#include "RaytracingUtils.hlsli"
+
+// Sampling of many lights by the light BVH of RtLightTree, which also has the CPU version of these
+// functions. Nodes and lights are read in the layout of RtLightTree::Node and RtLightTree::Light.
+#define LIGHT_TREE_OMNI_LIGHT 0
+#define LIGHT_TREE_COSINE_LIGHT 1
+
+struct LightTreeLight
+{
+    float3 position;
+    uint type;
+    float3 intensity;
+    float3 direction;
+};
+
+struct LightTreeNode
+{
+    float3 boundsMin;
+    float power;
+    float3 boundsMax;
+    float cosThetaO;
+    float3 axis;
+    float cosThetaE;
+    uint secondChild;
+    uint firstLight;
+    uint lightCount;
+};
+
+LightTreeLight loadLightTreeLight(ByteAddressBuffer lights, uint index)
+{
+    uint4 words0 = lights.Load4(index * 48);
+    uint4 words1 = lights.Load4(index * 48 + 16);
+    uint3 words2 = lights.Load3(index * 48 + 32);
+    LightTreeLight light;
+    light.position = asfloat(words0.xyz);
+    light.type = words0.w;
+    light.intensity = asfloat(words1.xyz);
+    light.direction = asfloat(words2);
+    return light;
+}
+
+LightTreeNode loadLightTreeNode(ByteAddressBuffer nodes, uint index)
+{
+    uint4 words0 = nodes.Load4(index * 64);
+    uint4 words1 = nodes.Load4(index * 64 + 16);
+    uint4 words2 = nodes.Load4(index * 64 + 32);
+    uint3 words3 = nodes.Load3(index * 64 + 48);
+    LightTreeNode node;
+    node.boundsMin = asfloat(words0.xyz);
+    node.power = asfloat(words0.w);
+    node.boundsMax = asfloat(words1.xyz);
+    node.cosThetaO = asfloat(words1.w);
+    node.axis = asfloat(words2.xyz);
+    node.cosThetaE = asfloat(words2.w);
+    node.secondChild = words3.x;
+    node.firstLight = words3.y;
+    node.lightCount = words3.z;
+    return node;
+}
+
+// cos(max(0, a - b)) and sin(max(0, a - b)) from the sines and cosines of a and b
+float cosSubClamped(float sinA, float cosA, float sinB, float cosB)
+{
+    return cosA > cosB ? 1.0 : cosA * cosB + sinA * sinB;
+}
+
+float sinSubClamped(float sinA, float cosA, float sinB, float cosB)
+{
+    return cosA > cosB ? 0.0 : sinA * cosB - cosA * sinB;
+}
+
+// Bound of the contribution of a node's lights to a point with the given normal
+float lightTreeImportance(LightTreeNode node, float3 position, float3 normal)
+{
+    float3 center = (node.boundsMin + node.boundsMax) * 0.5;
+    float3 diagonal = node.boundsMax - node.boundsMin;
+    float radius2 = dot(diagonal, diagonal) * 0.25;
+    float3 toPoint = position - center;
+    float distance2 = dot(toPoint, toPoint);
+
+    float3 wi = distance2 > 0.0 ? toPoint * rsqrt(distance2) : float3(0.0, 0.0, 1.0);
+    float clampedDistance2 = max(max(distance2, radius2), 1e-8);
+
+    float cosThetaB = distance2 > radius2 ? sqrt(max(1.0 - radius2 / distance2, 0.0)) : -1.0;
+    float sinThetaB = sqrt(max(1.0 - cosThetaB * cosThetaB, 0.0));
+
+    float cosThetaW = dot(node.axis, wi);
+    float sinThetaW = sqrt(max(1.0 - cosThetaW * cosThetaW, 0.0));
+    float sinThetaO = sqrt(max(1.0 - node.cosThetaO * node.cosThetaO, 0.0));
+    float cosThetaX = cosSubClamped(sinThetaW, cosThetaW, sinThetaO, node.cosThetaO);
+    float sinThetaX = sinSubClamped(sinThetaW, cosThetaW, sinThetaO, node.cosThetaO);
+    float cosThetaP = cosSubClamped(sinThetaX, cosThetaX, sinThetaB, cosThetaB);
+    if (cosThetaP <= node.cosThetaE) {
+        return 0.0;
+    }
+
+    float cosThetaI = -dot(normal, wi);
+    float sinThetaI = sqrt(max(1.0 - cosThetaI * cosThetaI, 0.0));
+    float cosThetaPI = cosSubClamped(sinThetaI, cosThetaI, sinThetaB, cosThetaB);
+
+    return node.power * cosThetaP * max(cosThetaPI, 0.0) / clampedDistance2;
+}
+
+// Walks from the root to a leaf, choosing a child in proportion to its importance. Returns the light
+// index in the order of the light buffer, or 0xffffffff with a pdf of 0 when no light reaches the point.
+uint sampleLightTree(ByteAddressBuffer nodes, float3 position, float3 normal, float u, out float pdf)
+{
+    pdf = 0.0;
+    LightTreeNode node = loadLightTreeNode(nodes, 0);
+    if (lightTreeImportance(node, position, normal) <= 0.0) {
+        return 0xffffffff;
+    }
+
+    uint nodeIndex = 0;
+    float probability = 1.0;
+    while (node.lightCount > 1) {
+        LightTreeNode first = loadLightTreeNode(nodes, nodeIndex + 1);
+        LightTreeNode second = loadLightTreeNode(nodes, node.secondChild);
+        float firstImportance = lightTreeImportance(first, position, normal);
+        float secondImportance = lightTreeImportance(second, position, normal);
+        if (firstImportance + secondImportance <= 0.0) {
+            return 0xffffffff;
+        }
+
+        float firstProbability = firstImportance / (firstImportance + secondImportance);
+        if (u < firstProbability) {
+            nodeIndex = nodeIndex + 1;
+            node = first;
+            u = min(u / firstProbability, 0.99999994);
+            probability *= firstProbability;
+        } else {
+            nodeIndex = node.secondChild;
+            node = second;
+            u = min((u - firstProbability) / (1.0 - firstProbability), 0.99999994);
+            probability *= 1.0 - firstProbability;
+        }
+    }
+
+    pdf = probability;
+    return node.firstLight;
+}
+
+// Radiant intensity of the light towards a point in direction L from it, like evaluatePointLight without
+// the falloff
+float3 lightTreeIntensity(LightTreeLight light, float3 L)
+{
+    float emission = light.type == LIGHT_TREE_COSINE_LIGHT ? saturate(dot(light.direction, -L)) : 1.0;
+    return light.intensity * emission;
+}
+
+#endif // LIGHT_TREE_HLSLI
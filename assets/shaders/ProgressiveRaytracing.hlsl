@@ -1,11 +1,33 @@
 ﻿#include "RaytracingCommon.hlsli"
+#include "AdaptiveSampling.hlsli"
+#include "EnvironmentSampling.hlsli"
+#include "LightTree.hlsli"
 
 RWTexture2D<float4> gOutput : register(u0);
+// Luminance moments of the accumulated samples, see AdaptiveSampling.hlsli
+RWTexture2D<float4> gMoments : register(u1);
+// Written by AdaptiveSampling.hlsl after every frame, 0 for converged tiles
+RWBuffer<uint> gTileActive : register(u2);
+// Samples per path length, with DebugOptions::pathLengthHistogram. Cleared before every frame.
+RWBuffer<uint> gPathLengthHistogram : register(u3);
+// Alias table of RtEnvironmentSampler over the environment cubemap, which is bound again here because
+// the miss shader's copy is not visible to hit shaders
+ByteAddressBuffer gEnvironmentAliasTable : register(t1);
+TextureCube gEnvironmentCubemap : register(t2);
+// Nodes and lights of RtLightTree, see LightTree.hlsli
+ByteAddressBuffer gLightTreeNodes : register(t3);
+ByteAddressBuffer gLightTreeLights : register(t4);
 
 struct SimplePayload
 {
     XMFLOAT4 colorAndDistance;
     UINT depth;
+    // Prefiltered environment roughness of the lobe the ray was drawn from, see environmentLod
+    float lobeRoughness;
+    // Largest component of the weight of the path up to and including the ray, for Russian roulette
+    float throughput;
+    // Returned: surface hits along the longest branch of the path from the ray on, counted from the camera
+    UINT pathLength;
 };
 
 [shader("raygeneration")] 
@@ -17,11 +39,20 @@ void RayGen()
 
     uint2 launchIndex = DispatchRaysIndex().xy;
     float2 dims = float2(DispatchRaysDimensions().xy);
+
+    // The tile states are used once every pixel has enough samples for its error estimate
+    if (perFrameConstants.options.adaptiveSampling && perFrameConstants.cameraParams.accumCount >= perFrameConstants.options.adaptiveMinSamples &&
+        !gTileActive[getAdaptiveTileIndex(launchIndex, DispatchRaysDimensions().xy)]) {
+        return;
+    }
     float2 d = (((launchIndex.xy + 0.5f) / dims.xy) * 2.f - 1.f);
  
     SimplePayload payload;
     payload.colorAndDistance = float4(0, 0, 0, 0);
     payload.depth = 0;
+    payload.lobeRoughness = 0.0;
+    payload.throughput = 1.0;
+    payload.pathLength = 0;
 
     float2 jitter = perFrameConstants.cameraParams.jitters * 30.0;
 
@@ -33,15 +64,45 @@ void RayGen()
 
     TraceRay(SceneBVH, RAY_FLAG_CULL_BACK_FACING_TRIANGLES, 0xFF, 0, 0, 0, ray, payload);
 
+    // Pixels of skipped tiles have fewer samples than accumCount
+    float4 moments = perFrameConstants.cameraParams.accumCount > 0 ? gMoments[launchIndex] : float4(0, 0, 0, 0);
+    float sampleCount = moments.z;
+
     float4 prevColor = gOutput[launchIndex];
     float4 curColor = float4(max(payload.colorAndDistance.rgb, 0.0), 1.0f);
-    gOutput[launchIndex] = (perFrameConstants.cameraParams.accumCount * prevColor + curColor) / (perFrameConstants.cameraParams.accumCount + 1);
+    gOutput[launchIndex] = (sampleCount * prevColor + curColor) / (sampleCount + 1);
+    gMoments[launchIndex] = accumulateMoments(moments, curColor.rgb);
+
+    if (perFrameConstants.options.pathLengthHistogram) {
+        InterlockedAdd(gPathLengthHistogram[min(payload.pathLength, PATH_LENGTH_HISTOGRAM_SIZE - 1)], 1);
+    }
+}
+
+// From russianRouletteDepth on, a ray continues the path with probability throughput, the largest
+// component of the path weight, and at least 5% so that the weight of the survivors stays bounded.
+// Returns the factor that keeps the survivors unbiased, 0 for a path that ends. The random number is
+// only drawn where the roulette applies, shallower bounces keep the sample dimensions of fixed depth.
+float russianRoulette(float throughput, uint depth, inout SampleGenerator sampleGenerator)
+{
+    if (!perFrameConstants.options.russianRoulette || depth < perFrameConstants.options.russianRouletteDepth) {
+        return 1.0;
+    }
+    float survival = clamp(throughput, 0.05, 1.0);
+    return throughput > 0.0 && nextSample1D(sampleGenerator) < survival ? 1.0 / survival : 0.0;
 }
 
-float3 shootSecondaryRay(float3 orig, float3 dir, float minT, uint currentDepth)
+// Returns the radiance and the hit distance, which is negative for rays that escaped to the environment.
+// throughput is the path weight including the ray's, pathLength is raised to that of the ray's path.
+float4 traceSecondaryRay(float3 orig, float3 dir, float minT, uint currentDepth, float lobeRoughness, float throughput,
+                         inout SampleGenerator sampleGenerator, inout uint pathLength)
 {
-    if (currentDepth >= MAX_RADIANCE_RAY_DEPTH) {
-        return float3(0.0, 0.0, 0.0);
+    if (currentDepth >= perFrameConstants.options.maxBounces) {
+        return float4(0.0, 0.0, 0.0, 0.0);
+    }
+
+    float survivorWeight = russianRoulette(throughput, currentDepth + 1, sampleGenerator);
+    if (survivorWeight == 0.0) {
+        return float4(0.0, 0.0, 0.0, 0.0);
     }
 
     RayDesc ray = { orig, minT, dir, RAY_MAX_T };
@@ -49,51 +110,119 @@ float3 shootSecondaryRay(float3 orig, float3 dir, float minT, uint currentDepth)
     SimplePayload payload;
     payload.colorAndDistance = float4(0, 0, 0, 0);
     payload.depth = currentDepth + 1;
+    payload.lobeRoughness = lobeRoughness;
+    payload.throughput = throughput * survivorWeight;
+    payload.pathLength = 0;
 
     TraceRay(SceneBVH, 0, 0xFF, 0, 0, 0, ray, payload);
-    return payload.colorAndDistance.rgb;
+    pathLength = max(pathLength, payload.pathLength);
+    return float4(payload.colorAndDistance.rgb * survivorWeight, payload.colorAndDistance.w);
 }
 
-float3 evaluateIndirectDiffuse(float3 position, float3 normal, inout uint randSeed, uint currentDepth)
+float3 shootSecondaryRay(float3 orig, float3 dir, float minT, uint currentDepth, float lobeRoughness, float throughput,
+                         inout SampleGenerator sampleGenerator, inout uint pathLength)
+{
+    return traceSecondaryRay(orig, dir, minT, currentDepth, lobeRoughness, throughput, sampleGenerator, pathLength).rgb;
+}
+
+// With environment importance sampling the environment is reached by two strategies, the BSDF sample
+// escaping the scene and a direction drawn from the alias table, combined by multiple importance sampling.
+// throughput is the path weight times the BRDF without the cosine, the ray's weight is applied here.
+float3 evaluateIndirectDiffuse(float3 position, float3 normal, inout SampleGenerator sampleGenerator, uint currentDepth, float throughput, inout uint pathLength)
 {
     float3 color = 0.0;
     const int rayCount = 1;
 
+    uint2 tableSize = uint2(perFrameConstants.environmentSampling.tableWidth, perFrameConstants.environmentSampling.tableHeight);
+    bool environmentSampling = perFrameConstants.options.environmentImportanceSampling && tableSize.x > 0;
+
     for (int i = 0; i < rayCount; ++i) {
+        float3 sampleDir;
+        float pdf;
+        float weight;
         if (perFrameConstants.options.cosineHemisphereSampling) {
-            float3 sampleDir = getCosHemisphereSample(randSeed, normal);
-            // float NoL = saturate(dot(normal, sampleDir));
-            // float pdf = NoL / M_PI;
-            // color += shootSecondaryRay(position, sampleDir, RAY_EPSILON, currentDepth) * NoL / pdf; 
-            color += shootSecondaryRay(position, sampleDir, RAY_EPSILON, currentDepth) * M_PI; // term canceled
+            sampleDir = getCosHemisphereSample(nextSample2D(sampleGenerator), normal);
+            pdf = saturate(dot(normal, sampleDir)) / M_PI;
+            weight = M_PI; // NoL / pdf, term canceled
         } else {
-            float3 sampleDir = getUniformHemisphereSample(randSeed, normal);
-            float NoL = saturate(dot(normal, sampleDir));
-            float pdf = 1.0 / (2.0 * M_PI); 
-            color += shootSecondaryRay(position, sampleDir, RAY_EPSILON, currentDepth) * NoL / pdf;
+            sampleDir = getUniformHemisphereSample(nextSample2D(sampleGenerator), normal);
+            pdf = 1.0 / (2.0 * M_PI);
+            weight = saturate(dot(normal, sampleDir)) / pdf;
+        }
+
+        float4 radiance = traceSecondaryRay(position, sampleDir, RAY_EPSILON, currentDepth, 0.0, throughput * weight, sampleGenerator, pathLength);
+        if (environmentSampling && radiance.w < 0.0) {
+            weight *= powerHeuristic(pdf, evaluateEnvironmentPdf(gEnvironmentAliasTable, tableSize, sampleDir));
+        }
+        color += radiance.rgb * weight;
+
+        if (environmentSampling) {
+            float envPdf;
+            float3 envDir = sampleEnvironmentDirection(gEnvironmentAliasTable, tableSize, nextSample2D(sampleGenerator), envPdf);
+            float NoL = dot(normal, envDir);
+            if (NoL > 0.0 && envPdf > 0.0) {
+                float bsdfPdf = perFrameConstants.options.cosineHemisphereSampling ? NoL / M_PI : 1.0 / (2.0 * M_PI);
+                float visible = shootShadowRay(position, envDir, RAY_EPSILON, RAY_MAX_T, currentDepth);
+                color += visible * evaluateEnvironment(gEnvironmentCubemap, envDir, 0.0) * NoL / envPdf * powerHeuristic(envPdf, bsdfPdf);
+            }
         }
     }
 
     return color / float(rayCount);
 }
 
-float3 shade(float3 position, float3 normal, uint currentDepth)
+// One of the light tree's lights with one shadow ray, drawn uniformly or by the importance of the tree's
+// nodes and weighted by the probability of drawing it. The lights fall off like evaluatePointLight.
+float3 evaluateManyLights(float3 position, float3 normal, uint currentDepth, float u)
+{
+    uint lightCount = perFrameConstants.lightTree.lightCount;
+    uint index;
+    float pdf;
+    if (perFrameConstants.options.manyLightSampling == 2) {
+        index = sampleLightTree(gLightTreeNodes, position, normal, u, pdf);
+    } else {
+        index = min(uint(u * lightCount), lightCount - 1);
+        pdf = 1.0 / float(lightCount);
+    }
+    if (pdf <= 0.0) {
+        return 0.0;
+    }
+
+    LightTreeLight light = loadLightTreeLight(gLightTreeLights, index);
+    float3 lightPath = light.position - position;
+    float lightDistance = length(lightPath);
+    float3 L = lightPath / lightDistance;
+    float NoL = saturate(dot(normal, L));
+    float3 intensity = lightTreeIntensity(light, L);
+    // No shadow ray for lights facing away
+    if (NoL <= 0.0 || maxComponent(intensity) <= 0.0) {
+        return 0.0;
+    }
+
+    float visible = shootShadowRay(position, L, RAY_EPSILON, lightDistance - RAY_EPSILON, currentDepth);
+
+    float falloff = 1.0 / (2 * M_PI * lightDistance * lightDistance);
+    return intensity * NoL * visible * falloff / pdf;
+}
+
+float3 shade(float3 position, float3 normal, uint currentDepth, float throughput, inout uint pathLength)
 {
     if (perFrameConstants.options.showAmbientOcclusionOnly) {
         return evaluateAO(position, normal);
     }
 
-    // Set up random seeed
+    // Set up the sample sequence, every bounce draws its own dimensions
     uint2 pixIdx = DispatchRaysIndex().xy;
     uint2 numPix = DispatchRaysDimensions().xy;
-    uint randSeed = initRand(pixIdx.x + pixIdx.y * numPix.x, perFrameConstants.cameraParams.frameCount);
+    SampleGenerator sampleGenerator = initSampleGenerator(perFrameConstants.options.sampleSequence, pixIdx, numPix, perFrameConstants.cameraParams.frameCount,
+                                                          perFrameConstants.cameraParams.accumCount, SAMPLE_DIMENSION_FIRST_BOUNCE + currentDepth * SAMPLE_DIMENSIONS_PER_BOUNCE);
 
     // Calculate direct diffuse lighting
     float3 directContrib = 0.0;
     if (perFrameConstants.options.debug == 2) {
         const int numLights = 2;
         // Select light to evaluate in this iteration
-        if (nextRand(randSeed) < 0.5) {
+        if (nextSample1D(sampleGenerator) < 0.5) {
             directContrib += evaluateDirectionalLight(position, normal, currentDepth) * numLights;
         } else {
             directContrib += evaluatePointLight(position, normal, currentDepth) * numLights;
@@ -102,11 +231,15 @@ float3 shade(float3 position, float3 normal, uint currentDepth)
         directContrib += evaluateDirectionalLight(position, normal, currentDepth);
         directContrib += evaluatePointLight(position, normal, currentDepth);
     }
+    if (perFrameConstants.options.manyLightSampling && perFrameConstants.lightTree.lightCount > 0) {
+        directContrib += evaluateManyLights(position, normal, currentDepth, nextSample1D(sampleGenerator));
+    }
 
     // Calculate indirect diffuse
     float3 indirectContrib = 0.0;
-    if (currentDepth < 1 && !perFrameConstants.options.noIndirectDiffuse) {
-        indirectContrib += evaluateIndirectDiffuse(position, normal, randSeed, currentDepth);
+    if (currentDepth < perFrameConstants.options.maxBounces && !perFrameConstants.options.noIndirectDiffuse) {
+        float diffuseThroughput = throughput * maxComponent(materialParams.albedo.rgb) / M_PI;
+        indirectContrib += evaluateIndirectDiffuse(position, normal, sampleGenerator, currentDepth, diffuseThroughput, pathLength);
     }
 
     float3 diffuseComponent = (directContrib + indirectContrib) / M_PI;
@@ -120,12 +253,18 @@ float3 shade(float3 position, float3 normal, uint currentDepth)
             float pdf;
             float brdf;
             float3 mirrorDir = reflect(WorldRayDirection(), normal);
-            float3 sampleDir = samplePhongLobe(randSeed, mirrorDir, exponent, pdf, brdf);
-            float3 reflectionColor = shootSecondaryRay(position, sampleDir, RAY_EPSILON, currentDepth);
-            specularComponent += reflectionColor * brdf / pdf;
+            float3 sampleDir = samplePhongLobe(nextSample2D(sampleGenerator), mirrorDir, exponent, pdf, brdf);
 
             // Equivalent to: fresnel = FresnelReflectanceSchlick(-V, H, materialParams.specular.rgb);
             fresnel = FresnelReflectanceSchlick(WorldRayDirection(), normal, materialParams.specular.rgb);
+
+            // The lobe sample for a random number of 0 underflows both terms to 0
+            float reflectionThroughput = pdf > 0.0 ? throughput * materialParams.reflectivity * maxComponent(fresnel) * brdf / pdf : 0.0;
+            float3 reflectionColor = shootSecondaryRay(position, sampleDir, RAY_EPSILON, currentDepth, phongLobeEnvironmentRoughness(exponent),
+                                                       reflectionThroughput, sampleGenerator, pathLength);
+            if (pdf > 0.0) {
+                specularComponent += reflectionColor * brdf / pdf;
+            }
         }
     }
  
@@ -153,14 +292,17 @@ void PrimaryClosestHit(inout SimplePayload payload, Attributes attrib)
     float3 vertPosition, vertNormal;
     interpolateVertexAttributes(attrib.bary, vertPosition, vertNormal);
 
-    float3 color = shade(HitWorldPosition(), normalize(vertNormal), payload.depth);
+    uint pathLength = payload.depth + 1;
+    float3 color = shade(HitWorldPosition(), normalize(vertNormal), payload.depth, payload.throughput, pathLength);
     payload.colorAndDistance = float4(color, RayTCurrent());
+    payload.pathLength = pathLength;
 }
 
 [shader("miss")]
 void PrimaryMiss(inout SimplePayload payload)
 {
-    payload.colorAndDistance = float4(sampleEnvironment(), -1.0);
+    payload.colorAndDistance = float4(sampleEnvironment(environmentLod(payload.lobeRoughness, payload.depth)), -1.0);
+    payload.pathLength = payload.depth;
 }
 
 [shader("closesthit")]
@@ -4,13 +4,11 @@
 #define HLSL
 #include "RaytracingHlslCompat.h"
 #include "RaytracingUtils.hlsli"
+#include "Sampling.hlsli"
 
 #define RAY_MAX_T 1.0e+38f
 #define RAY_EPSILON 0.0001
 
-#define MAX_RADIANCE_RAY_DEPTH 1
-#define MAX_SHADOW_RAY_DEPTH 2
-
 ////////////////////////////////////////////////////////////////////////////////
 // Global root signature
 ////////////////////////////////////////////////////////////////////////////////
@@ -102,18 +100,19 @@ float evaluateAO(float3 position, float3 normal)
 
     uint2 pixIdx = DispatchRaysIndex().xy;
     uint2 numPix = DispatchRaysDimensions().xy;
-    uint randSeed = initRand(pixIdx.x + pixIdx.y * numPix.x, perFrameConstants.cameraParams.frameCount);
+    SampleGenerator sampleGenerator = initSampleGenerator(perFrameConstants.options.sampleSequence, pixIdx, numPix, perFrameConstants.cameraParams.frameCount,
+                                                          perFrameConstants.cameraParams.accumCount, SAMPLE_DIMENSION_FIRST_BOUNCE);
 
     for (int i = 0; i < aoRayCount; ++i) {
         float3 sampleDir;
         float NoL;
         float pdf;
         if (perFrameConstants.options.cosineHemisphereSampling) {
-            sampleDir = getCosHemisphereSample(randSeed, normal);
+            sampleDir = getCosHemisphereSample(nextSample2D(sampleGenerator), normal);
             NoL = saturate(dot(normal, sampleDir));
             pdf = NoL / M_PI;
         } else {
-            sampleDir = getUniformHemisphereSample(randSeed, normal);
+            sampleDir = getUniformHemisphereSample(nextSample2D(sampleGenerator), normal);
             NoL = saturate(dot(normal, sampleDir));
             pdf = 1.0 / (2.0 * M_PI);
         }
@@ -146,16 +145,58 @@ float3 evaluatePointLight(float3 position, float3 normal, uint currentDepth)
     return perFrameConstants.pointLight.color.rgb * perFrameConstants.pointLight.color.a * NoL * visible * falloff;
 }
 
-float3 sampleEnvironment()
+float3 evaluateEnvironment(TextureCube cubemap, float3 direction, float lod)
+{
+    float4 envSample = cubemap.SampleLevel(defaultSampler, direction, lod);
+    return envSample.rgb * perFrameConstants.options.environmentStrength;
+}
+
+// Roughness of the prefiltered environment mip whose GGX lobe is about as wide as a Phong lobe of the
+// exponent. Exponent n matches a half vector lobe of alpha^2 = 2 / (n + 2), and the reflected lobe
+// around the mirror direction is twice as wide as the half vector lobe.
+float phongLobeEnvironmentRoughness(float exponent)
+{
+    return sqrt(sqrt(2.0 / (4.0 * exponent + 2.0)));
+}
+
+// Mip of the prefiltered environment read by a miss: the mip of the lobe the ray was drawn from, and at
+// least half of the roughest mip per bounce after the first, since the bounces before a deep miss
+// average it over a wide footprint anyway
+float environmentLod(float lobeRoughness, uint depth)
+{
+    uint mipCount = perFrameConstants.environmentLighting.radianceMipCount;
+    if (!perFrameConstants.options.prefilteredEnvironmentMisses || mipCount < 2) {
+        return 0.0;
+    }
+    float roughness = max(lobeRoughness, saturate(0.5 * (float(depth) - 1.0)));
+    return roughness * float(mipCount - 1);
+}
+
+float3 sampleEnvironment(float lod)
 {
     // cubemap
-    float4 envSample = envCubemap.SampleLevel(defaultSampler, WorldRayDirection().xyz, 0.0);
+    return evaluateEnvironment(envCubemap, WorldRayDirection().xyz, lod);
 
     // lat-long environment map
     // float2 uv = wsVectorToLatLong(WorldRayDirection().xyz);
-    // float4 envSample = envMap.SampleLevel(defaultSampler, uv, 0.0);
+    // float4 envSample = envMap.SampleLevel(defaultSampler, uv, lod);
+    // return envSample.rgb * perFrameConstants.options.environmentStrength;
+}
 
-    return envSample.rgb * perFrameConstants.options.environmentStrength;
+// Irradiance from the SH coefficients of RtEnvironmentPrefilter, E(n) = sum c_i Y_i(n)
+float3 evaluateIrradianceSH(float3 n)
+{
+    float basis[9] = {
+        0.282095,
+        0.488603 * n.y, 0.488603 * n.z, 0.488603 * n.x,
+        1.092548 * n.x * n.y, 1.092548 * n.y * n.z, 0.315392 * (3.0 * n.z * n.z - 1.0), 1.092548 * n.x * n.z, 0.546274 * (n.x * n.x - n.y * n.y)
+    };
+
+    float3 irradiance = 0.0;
+    for (int i = 0; i < 9; ++i) {
+        irradiance += perFrameConstants.environmentLighting.irradianceSH[i].rgb * basis[i];
+    }
+    return max(irradiance, 0.0) * perFrameConstants.options.environmentStrength;
 }
 
 #endif // RAYTRACING_COMMON_HLSLI
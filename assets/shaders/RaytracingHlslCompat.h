@@ -21,6 +21,12 @@ using namespace DirectX;
 typedef UINT16 Index;
 #endif
 
+// Bound of DebugOptions::maxBounces. Hit shaders trace the next bounce and their shadow rays
+// recursively, so a pipeline needs a recursion depth of MAX_RADIANCE_RAY_DEPTH + 2.
+#define MAX_RADIANCE_RAY_DEPTH 8
+#define MAX_SHADOW_RAY_DEPTH (MAX_RADIANCE_RAY_DEPTH + 1)
+// Bins of DebugOptions::pathLengthHistogram, for paths of 0 to MAX_RADIANCE_RAY_DEPTH + 1 surface hits
+#define PATH_LENGTH_HISTOGRAM_SIZE (MAX_RADIANCE_RAY_DEPTH + 2)
 
 struct ShadowPayload
 {
@@ -61,6 +67,41 @@ struct PointLightParams
     XMFLOAT4 color;
 };
 
+// Size of the alias table of RtEnvironmentSampler, 0 without one
+struct EnvironmentSamplingParams
+{
+    UINT tableWidth;
+    UINT tableHeight;
+    XMFLOAT2 padding;
+};
+
+// Prefiltered environment of RtEnvironmentPrefilter: mip m of the environment cubemap is filtered with
+// the GGX lobe of roughness m / (radianceMipCount - 1), irradianceSH holds its irradiance in rgb.
+// radianceMipCount is 0 without it.
+struct EnvironmentLightingParams
+{
+    XMFLOAT4 irradianceSH[9];
+    UINT radianceMipCount;
+    XMFLOAT3 padding;
+};
+
+// Light BVH of RtLightTree over many lights, 0 lights without one
+struct LightTreeParams
+{
+    UINT lightCount;
+    UINT nodeCount;
+    XMFLOAT2 padding;
+};
+
+// Matrices of Math::Camera for reprojection, by rows in DirectXMath's row vector convention:
+// clip = mul(float4(world, 1), viewProj) and the clip position of the previous frame is
+// mul(clip, reprojection), see Camera::GetReprojectionMatrix
+struct ReprojectionParams
+{
+    XMFLOAT4 viewProj[4];
+    XMFLOAT4 reprojection[4];
+};
+
 struct DebugOptions
 {
     UINT maxIterations;
@@ -74,6 +115,28 @@ struct DebugOptions
     UINT noIndirectDiffuse;
     float environmentStrength;
     UINT debug;
+    UINT adaptiveSampling;
+    UINT adaptiveMinSamples;
+    float adaptiveErrorThreshold; // relative standard error of a tile's luminance
+    UINT sampleSequence; // SAMPLE_SEQUENCE_* in SamplingHlslCompat.h
+    UINT environmentImportanceSampling;
+    UINT prefilteredEnvironmentMisses;
+    UINT environmentIrradiance; // 0: none, 1: SH, 2: irradiance cubemap
+    UINT maxBounces; // 1 to MAX_RADIANCE_RAY_DEPTH
+    UINT russianRoulette;
+    UINT russianRouletteDepth; // first bounce Russian roulette may end a path at
+    UINT pathLengthHistogram; // count the surface hits of the longest branch of every sample
+    UINT manyLightSampling; // 0: off, 1: one light drawn uniformly, 2: one light drawn by the light tree
+    UINT restirCandidates; // lights drawn per pixel for the realtime pipeline's reservoirs, see ReservoirHlslCompat.h
+    UINT restirTemporalReuse;
+    UINT restirSpatialSamples; // neighbours merged by the spatial pass, 0 for none
+    float restirSpatialRadius; // in pixels
+    float restirHistoryLimit; // candidates the previous frame's reservoir stands for, in multiples of restirCandidates
+    UINT temporalAccumulation; // blend the realtime pipeline's outputs with their reprojected history
+    UINT temporalHistoryValid; // 0 while the history holds no frame, after enabling or resizing
+    float temporalMinAlpha; // weight of the new sample once the history is long enough, see TemporalAccumulationHlslCompat.h
+    float temporalClampGamma; // standard deviations of the neighbourhood the history is clamped to, 0 disables clamping
+    UINT aovMask; // AOV_BIT of the AOVs the realtime pipeline writes, see AovHlslCompat.h
 };
 
 struct PerFrameConstants
@@ -81,6 +144,10 @@ struct PerFrameConstants
     CameraParams cameraParams;
     DirectionalLightParams directionalLight;
     PointLightParams pointLight;
+    EnvironmentSamplingParams environmentSampling;
+    EnvironmentLightingParams environmentLighting;
+    LightTreeParams lightTree;
+    ReprojectionParams reprojection;
     DebugOptions options;
 };
 
@@ -19,6 +19,8 @@
 #ifndef RAYTRACING_UTILS_HLSLI
 #define RAYTRACING_UTILS_HLSLI
 
+#include "AovHlslCompat.h"
+
 #define M_PI 3.1415927
 #define M_1_PI (1.0 / M_PI)
 
@@ -44,6 +46,11 @@ float nextRand(inout uint s)
     return float(s & 0x00FFFFFF) / float(0x01000000);
 }
 
+float maxComponent(float3 v)
+{
+    return max(max(v.r, v.g), v.b);
+}
+
 // Utility function to get a vector perpendicular to an input vector 
 //    (from "Efficient Construction of Perpendicular Vectors Without Branching")
 float3 getPerpendicularVector(float3 u)
@@ -56,11 +63,8 @@ float3 getPerpendicularVector(float3 u)
 }
 
 // Get a cosine-weighted random vector centered around a specified normal direction.
-float3 getCosHemisphereSample(inout uint randSeed, float3 hitNorm)
+float3 getCosHemisphereSample(float2 randVal, float3 hitNorm)
 {
-    // Get 2 random numbers to select our sample with
-    float2 randVal = float2(nextRand(randSeed), nextRand(randSeed));
-
     float3 bitangent = getPerpendicularVector(hitNorm);
     float3 tangent = cross(bitangent, hitNorm);
 
@@ -79,11 +83,8 @@ float3 getCosHemisphereSample(inout uint randSeed, float3 hitNorm)
 }
 
 // http://www.rorydriscoll.com/2009/01/07/better-sampling/
-float3 getUniformHemisphereSample(inout uint randSeed, float3 hitNorm)
+float3 getUniformHemisphereSample(float2 randVal, float3 hitNorm)
 {
-    // Get 2 random numbers to select our sample with
-    float2 randVal = float2(nextRand(randSeed), nextRand(randSeed));
-
     float3 bitangent = getPerpendicularVector(hitNorm);
     float3 tangent = cross(bitangent, hitNorm);
 
@@ -98,13 +99,10 @@ float3 getUniformHemisphereSample(inout uint randSeed, float3 hitNorm)
 }
 
 // From OptiX helpers.h
-float3 samplePhongLobe(inout uint randSeed, float3 mirrorDir, float exponent, inout float pdf, inout float brdf)
+float3 samplePhongLobe(float2 randVal, float3 mirrorDir, float exponent, inout float pdf, inout float brdf)
 {
     const float pi = 3.14159265f;
 
-    // Get 2 random numbers to select our sample with
-    float2 randVal = float2(nextRand(randSeed), nextRand(randSeed));
-
     float3 bitangent = getPerpendicularVector(mirrorDir);
     float3 tangent = cross(bitangent, mirrorDir);
 
@@ -219,4 +217,37 @@ float2 wsVectorToLatLong(float3 dir)
     return float2(u, v);
 }
 
+// Inverse of wsVectorToLatLong
+float3 latLongToWsVector(float2 uv)
+{
+    float phi = (2.f * uv.x - 1.f) * M_PI;
+    float theta = uv.y * M_PI;
+    return float3(sin(theta) * sin(phi), cos(theta), -sin(theta) * cos(phi));
+}
+
+// Unit vector in 32 bits, two 16 bit coordinates of its octahedral map
+uint packNormal(float3 n)
+{
+    float2 p = aovEncodeNormal(n);
+    uint2 q = uint2(round(saturate(p * 0.5 + 0.5) * 65535.0));
+    return q.x | (q.y << 16);
+}
+
+float3 unpackNormal(uint packed)
+{
+    return aovDecodeNormal(float2(packed & 0xffff, packed >> 16) / 65535.0 * 2.0 - 1.0);
+}
+
+// Color in [0, 1] in 32 bits, 10 bits per channel
+uint packUnorm10(float3 c)
+{
+    uint3 q = uint3(round(saturate(c) * 1023.0));
+    return q.x | (q.y << 10) | (q.z << 20);
+}
+
+float3 unpackUnorm10(uint packed)
+{
+    return float3(packed & 0x3ff, (packed >> 10) & 0x3ff, (packed >> 20) & 0x3ff) / 1023.0;
+}
+
 #endif // RAYTRACING_UTILS_HLSLI
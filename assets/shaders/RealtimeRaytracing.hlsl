@@ -1,7 +1,34 @@
 ﻿#include "RaytracingCommon.hlsli"
+#include "LightTree.hlsli"
+#include "ReservoirHlslCompat.h"
+#include "TemporalAccumulationHlslCompat.h"
 
 RWTexture2D<float4> gDirectLightingOutput : register(u0);
 RWTexture2D<float4> gIndirectSpecularOutput : register(u1);
+// Per pixel reservoirs of the light tree's lights, see RestirPixel. The first pass writes the reservoirs
+// of the frame to gReservoirs, the second merges their neighbours into gHistoryReservoirs, which the
+// first pass of the next frame reuses.
+RWByteAddressBuffer gReservoirs : register(u2);
+RWByteAddressBuffer gHistoryReservoirs : register(u3);
+// AOVs of the primary hits in the formats of AovHlslCompat.h, written when DebugOptions::aovMask has them
+RWTexture2D<float> gAovDepth : register(u4);
+RWTexture2D<float2> gAovNormal : register(u5);
+RWTexture2D<float4> gAovAlbedo : register(u6);
+RWTexture2D<float2> gAovMotion : register(u7);
+RWTexture2D<uint> gAovInstanceId : register(u8);
+// Irradiance of the environment divided by pi, for the ambient term with environmentIrradiance 2
+TextureCube gEnvironmentIrradiance : register(t1);
+ByteAddressBuffer gLightTreeNodes : register(t2);
+ByteAddressBuffer gLightTreeLights : register(t3);
+
+// RESTIR_PASS_*, the pipeline dispatches the program twice a frame when it resamples many lights
+cbuffer RestirPassConstants : register(b1)
+{
+    uint gRestirPass;
+}
+
+#define RESTIR_PASS_PRIMARY 0   // primary rays, the AOVs and the reservoirs of new and reprojected candidates
+#define RESTIR_PASS_SPATIAL 1   // spatial reuse and the direct lighting of the final reservoirs
 
 struct ShadingAOV
 {
@@ -17,37 +44,317 @@ struct RealtimePayload
     float distance;
     ShadingAOV aov;
     uint depth;
+    // Prefiltered environment roughness of the lobe the ray was drawn from, see environmentLod
+    float lobeRoughness;
+};
+
+// A reservoir with the surface it was resampled for, 32 bytes per pixel
+struct RestirPixel
+{
+    Reservoir reservoir;
+    float3 normal;
+    float hitDistance; // along the primary ray, negative where it missed
+    float3 albedo;
+    float viewDepth;
 };
 
+RestirPixel loadRestirPixel(RWByteAddressBuffer buffer, uint index)
+{
+    uint4 words0 = buffer.Load4(index * 32);
+    uint4 words1 = buffer.Load4(index * 32 + 16);
+    RestirPixel pixel;
+    pixel.reservoir.lightIndex = words0.x;
+    pixel.reservoir.weightSum = asfloat(words0.y);
+    pixel.reservoir.M = asfloat(words0.z);
+    pixel.reservoir.W = asfloat(words0.w);
+    pixel.normal = unpackNormal(words1.x);
+    pixel.hitDistance = asfloat(words1.y);
+    pixel.albedo = unpackUnorm10(words1.z);
+    pixel.viewDepth = asfloat(words1.w);
+    return pixel;
+}
+
+void storeRestirPixel(RWByteAddressBuffer buffer, uint index, RestirPixel pixel)
+{
+    buffer.Store4(index * 32, uint4(pixel.reservoir.lightIndex, asuint(pixel.reservoir.weightSum), asuint(pixel.reservoir.M), asuint(pixel.reservoir.W)));
+    buffer.Store4(index * 32 + 16, uint4(packNormal(pixel.normal), asuint(pixel.hitDistance), packUnorm10(pixel.albedo), asuint(pixel.viewDepth)));
+}
+
+bool restirEnabled()
+{
+    return perFrameConstants.options.manyLightSampling && perFrameConstants.lightTree.lightCount > 0;
+}
+
+float4x4 viewProjMatrix()
+{
+    return float4x4(perFrameConstants.reprojection.viewProj[0], perFrameConstants.reprojection.viewProj[1],
+                    perFrameConstants.reprojection.viewProj[2], perFrameConstants.reprojection.viewProj[3]);
+}
+
+float4x4 reprojectionMatrix()
+{
+    return float4x4(perFrameConstants.reprojection.reprojection[0], perFrameConstants.reprojection.reprojection[1],
+                    perFrameConstants.reprojection.reprojection[2], perFrameConstants.reprojection.reprojection[3]);
+}
+
+RayDesc cameraRay(uint2 launchIndex, float2 dims)
+{
+    float2 d = (((launchIndex.xy + 0.5f) / dims.xy) * 2.f - 1.f);
+    float2 jitter = perFrameConstants.cameraParams.jitters * 10.0;
+
+    RayDesc ray;
+    ray.Origin = perFrameConstants.cameraParams.worldEyePos.xyz + float3(jitter.x, jitter.y, 0.0f);
+    ray.Direction = normalize(d.x * perFrameConstants.cameraParams.U + (-d.y) * perFrameConstants.cameraParams.V + perFrameConstants.cameraParams.W).xyz;
+    ray.TMin = 0;
+    ray.TMax = RAY_MAX_T;
+    return ray;
+}
+
+// Target pdf of resampling at a surface, zero for the invalid light
+float restirTargetPdf(uint lightIndex, float3 position, float3 normal)
+{
+    if (lightIndex == RESERVOIR_INVALID_LIGHT) {
+        return 0.0;
+    }
+    LightTreeLight light = loadLightTreeLight(gLightTreeLights, lightIndex);
+    float3 lightPath = light.position - position;
+    float distance2 = dot(lightPath, lightPath);
+    float3 L = lightPath * rsqrt(distance2);
+    float intensity = dot(lightTreeIntensity(light, L), float3(0.2126, 0.7152, 0.0722));
+    return reservoirTargetPdf(intensity, dot(normal, L), distance2);
+}
+
+// Direct lighting of the light a reservoir kept, weighted by its contribution weight, with one shadow ray
+float3 shadeReservoir(Reservoir r, float3 position, float3 normal, float3 albedo)
+{
+    if (r.W <= 0.0) {
+        return 0.0;
+    }
+
+    LightTreeLight light = loadLightTreeLight(gLightTreeLights, r.lightIndex);
+    float3 lightPath = light.position - position;
+    float lightDistance = length(lightPath);
+    float3 L = lightPath / lightDistance;
+    float NoL = saturate(dot(normal, L));
+    float visible = shootShadowRay(position, L, RAY_EPSILON, lightDistance - RAY_EPSILON, 0);
+
+    float falloff = 1.0 / (2 * M_PI * lightDistance * lightDistance);
+    return albedo / M_PI * lightTreeIntensity(light, L) * NoL * visible * falloff * r.W;
+}
+
+// Resamples restirCandidates lights drawn uniformly or by the light tree, then merges the reservoir
+// the previous frame ended with at the reprojected position if its surface matches. clip is the clip
+// space position of the surface.
+Reservoir resampleInitialAndTemporal(float3 position, float3 normal, float4 clip)
+{
+    uint2 launchIndex = DispatchRaysIndex().xy;
+    uint2 dims = DispatchRaysDimensions().xy;
+    uint seed = initRand(launchIndex.x + launchIndex.y * dims.x, perFrameConstants.cameraParams.frameCount * 2 + RESTIR_PASS_PRIMARY);
+
+    uint lightCount = perFrameConstants.lightTree.lightCount;
+    Reservoir current = emptyReservoir();
+    float currentTargetPdf = 0.0;
+    for (uint i = 0; i < perFrameConstants.options.restirCandidates; ++i) {
+        float u = nextRand(seed);
+        uint index;
+        float pdf;
+        if (perFrameConstants.options.manyLightSampling == 2) {
+            index = sampleLightTree(gLightTreeNodes, position, normal, u, pdf);
+        } else {
+            index = min(uint(u * lightCount), lightCount - 1);
+            pdf = 1.0 / float(lightCount);
+        }
+        float targetPdf = pdf > 0.0 ? restirTargetPdf(index, position, normal) : 0.0;
+        if (updateReservoir(current, index, pdf > 0.0 ? targetPdf / pdf : 0.0, 1.0, nextRand(seed))) {
+            currentTargetPdf = targetPdf;
+        }
+    }
+    finalizeReservoir(current, currentTargetPdf);
+
+    // Occluded candidates are dropped before reuse, so neighbours do not inherit them
+    if (current.W > 0.0) {
+        LightTreeLight light = loadLightTreeLight(gLightTreeLights, current.lightIndex);
+        float3 lightPath = light.position - position;
+        float lightDistance = length(lightPath);
+        if (shootShadowRay(position, lightPath / lightDistance, RAY_EPSILON, lightDistance - RAY_EPSILON, 0) <= 0.0) {
+            current.W = 0.0;
+        }
+    }
+
+    if (!perFrameConstants.options.restirTemporalReuse) {
+        return current;
+    }
+
+    float4 previousClip = mul(clip, reprojectionMatrix());
+    float2 previousNdc = previousClip.xy / previousClip.w;
+    int2 previousPixel = int2(floor(float2(previousNdc.x * 0.5 + 0.5, 0.5 - previousNdc.y * 0.5) * float2(dims)));
+    if (previousClip.w <= 0.0 || any(previousPixel < 0) || any(previousPixel >= int2(dims))) {
+        return current;
+    }
+
+    // The depth of the surface in the previous view is the w of its previous clip position
+    RestirPixel previous = loadRestirPixel(gHistoryReservoirs, previousPixel.x + previousPixel.y * dims.x);
+    if (previous.hitDistance < 0.0 || dot(previous.normal, normal) < 0.9 || abs(previous.viewDepth - previousClip.w) > 0.1 * previousClip.w) {
+        return current;
+    }
+    limitReservoir(previous.reservoir, perFrameConstants.options.restirHistoryLimit * perFrameConstants.options.restirCandidates);
+
+    // The previous surface is taken to be this one, which leaves MIS weights by candidate counts
+    float count = current.M + previous.reservoir.M;
+    Reservoir combined = emptyReservoir();
+    float combinedTargetPdf = 0.0;
+    if (mergeReservoir(combined, current, currentTargetPdf, current.M / count, nextRand(seed))) {
+        combinedTargetPdf = currentTargetPdf;
+    }
+    float previousTargetPdf = restirTargetPdf(previous.reservoir.lightIndex, position, normal);
+    if (mergeReservoir(combined, previous.reservoir, previousTargetPdf, previous.reservoir.M / count, nextRand(seed))) {
+        combinedTargetPdf = previousTargetPdf;
+    }
+    finalizeMergedReservoir(combined, combinedTargetPdf);
+    return combined;
+}
+
+#define RESTIR_MAX_SPATIAL_SAMPLES 8
+
+// Merges the reservoirs of random neighbours with matching surfaces into the reservoir of the pixel.
+// The MIS weight of every light needs its target pdf at the surfaces of all merged reservoirs.
+Reservoir resampleSpatial(RestirPixel pixel, float3 position, inout uint seed)
+{
+    uint2 launchIndex = DispatchRaysIndex().xy;
+    uint2 dims = DispatchRaysDimensions().xy;
+
+    Reservoir reservoirs[RESTIR_MAX_SPATIAL_SAMPLES + 1];
+    float3 positions[RESTIR_MAX_SPATIAL_SAMPLES + 1];
+    float3 normals[RESTIR_MAX_SPATIAL_SAMPLES + 1];
+    reservoirs[0] = pixel.reservoir;
+    positions[0] = position;
+    normals[0] = pixel.normal;
+    uint count = 1;
+
+    uint spatialSamples = min(perFrameConstants.options.restirSpatialSamples, RESTIR_MAX_SPATIAL_SAMPLES);
+    for (uint i = 0; i < spatialSamples; ++i) {
+        float radius = perFrameConstants.options.restirSpatialRadius * sqrt(nextRand(seed));
+        float angle = 2.0 * M_PI * nextRand(seed);
+        int2 neighbour = int2(launchIndex) + int2(round(float2(cos(angle), sin(angle)) * radius));
+        if (any(neighbour < 0) || any(neighbour >= int2(dims)) || all(neighbour == int2(launchIndex))) {
+            continue;
+        }
+
+        RestirPixel other = loadRestirPixel(gReservoirs, neighbour.x + neighbour.y * dims.x);
+        if (other.hitDistance < 0.0 || dot(other.normal, pixel.normal) < 0.9 || abs(other.viewDepth - pixel.viewDepth) > 0.1 * pixel.viewDepth) {
+            continue;
+        }
+
+        RayDesc ray = cameraRay(uint2(neighbour), float2(dims));
+        reservoirs[count] = other.reservoir;
+        positions[count] = ray.Origin + ray.Direction * other.hitDistance;
+        normals[count] = other.normal;
+        ++count;
+    }
+
+    Reservoir combined = emptyReservoir();
+    float combinedTargetPdf = 0.0;
+    for (uint i = 0; i < count; ++i) {
+        float weightedTargetPdfSum = 0.0;
+        float ownTargetPdf = 0.0;
+        for (uint j = 0; j < count; ++j) {
+            float targetPdf = restirTargetPdf(reservoirs[i].lightIndex, positions[j], normals[j]);
+            weightedTargetPdfSum += reservoirs[j].M * targetPdf;
+            ownTargetPdf = i == j ? targetPdf : ownTargetPdf;
+        }
+
+        float targetPdf = restirTargetPdf(reservoirs[i].lightIndex, position, pixel.normal);
+        float misWeight = reservoirMisWeight(reservoirs[i].M, ownTargetPdf, weightedTargetPdfSum);
+        if (mergeReservoir(combined, reservoirs[i], targetPdf, misWeight, nextRand(seed))) {
+            combinedTargetPdf = targetPdf;
+        }
+    }
+    finalizeMergedReservoir(combined, combinedTargetPdf);
+    return combined;
+}
+
+void spatialRayGen(uint2 launchIndex, float2 dims)
+{
+    uint index = launchIndex.x + launchIndex.y * uint(dims.x);
+    RestirPixel pixel = loadRestirPixel(gReservoirs, index);
+    if (pixel.hitDistance >= 0.0) {
+        RayDesc ray = cameraRay(launchIndex, dims);
+        float3 position = ray.Origin + ray.Direction * pixel.hitDistance;
+
+        uint seed = initRand(index, perFrameConstants.cameraParams.frameCount * 2 + RESTIR_PASS_SPATIAL);
+        pixel.reservoir = resampleSpatial(pixel, position, seed);
+
+        float3 lighting = shadeReservoir(pixel.reservoir, position, pixel.normal, pixel.albedo);
+        gDirectLightingOutput[launchIndex] = gDirectLightingOutput[launchIndex] + float4(lighting, 0.0);
+    }
+    storeRestirPixel(gHistoryReservoirs, index, pixel);
+}
+
+bool aovEnabled(uint aov)
+{
+    return (perFrameConstants.options.aovMask & AOV_BIT(aov)) != 0;
+}
+
+void writeAovs(uint2 pixel, float viewDepth, float3 normal, float4 albedoRoughness, float2 motion, uint instanceId)
+{
+    if (aovEnabled(AOV_DEPTH)) {
+        gAovDepth[pixel] = viewDepth;
+    }
+    if (aovEnabled(AOV_NORMAL)) {
+        gAovNormal[pixel] = aovEncodeNormal(normal);
+    }
+    if (aovEnabled(AOV_ALBEDO)) {
+        gAovAlbedo[pixel] = albedoRoughness;
+    }
+    if (aovEnabled(AOV_MOTION)) {
+        gAovMotion[pixel] = motion;
+    }
+    if (aovEnabled(AOV_INSTANCE_ID)) {
+        gAovInstanceId[pixel] = instanceId;
+    }
+}
+
 [shader("raygeneration")] 
 void RayGen() 
 {
     uint2 launchIndex = DispatchRaysIndex().xy;
     float2 dims = float2(DispatchRaysDimensions().xy);
-    float2 d = (((launchIndex.xy + 0.5f) / dims.xy) * 2.f - 1.f);
+    if (gRestirPass == RESTIR_PASS_SPATIAL) {
+        spatialRayGen(launchIndex, dims);
+        return;
+    }
  
     RealtimePayload payload;
     payload.color = float3(0, 0, 0);
     payload.distance = 0.0;
     payload.depth = 0;
+    payload.lobeRoughness = 0.0;
 
-    float2 jitter = perFrameConstants.cameraParams.jitters * 10.0;
-
-    RayDesc ray;
-    ray.Origin = perFrameConstants.cameraParams.worldEyePos.xyz + float3(jitter.x, jitter.y, 0.0f);
-    ray.Direction = normalize(d.x * perFrameConstants.cameraParams.U + (-d.y) * perFrameConstants.cameraParams.V + perFrameConstants.cameraParams.W).xyz;
-    ray.TMin = 0;
-    ray.TMax = RAY_MAX_T;
+    RayDesc ray = cameraRay(launchIndex, dims);
 
     TraceRay(SceneBVH, RAY_FLAG_CULL_BACK_FACING_TRIANGLES, 0xFF, 0, 0, 0, ray, payload);
 
     gDirectLightingOutput[launchIndex] = float4(max(payload.aov.directLighting, 0.0), 1.0f);
     gIndirectSpecularOutput[launchIndex] = float4(max(payload.aov.indirectSpecular, 0.0), 1.0f);
+
+    // The closest hit shader wrote the AOVs and the reservoir of surfaces
+    if (payload.distance < 0.0) {
+        writeAovs(launchIndex, -1.0, float3(0.0, 0.0, 1.0), float4(1.0, 1.0, 1.0, 0.0), 0.0, AOV_INSTANCE_ID_MISS);
+    }
+    if (restirEnabled() && payload.distance < 0.0) {
+        RestirPixel pixel;
+        pixel.reservoir = emptyReservoir();
+        pixel.normal = float3(0.0, 0.0, 1.0);
+        pixel.hitDistance = -1.0;
+        pixel.albedo = 0.0;
+        pixel.viewDepth = 0.0;
+        storeRestirPixel(gReservoirs, launchIndex.x + launchIndex.y * uint(dims.x), pixel);
+    }
 }
 
-float3 shootSecondaryRay(float3 orig, float3 dir, float minT, uint currentDepth)
+float3 shootSecondaryRay(float3 orig, float3 dir, float minT, uint currentDepth, float lobeRoughness)
 {
-    if (currentDepth >= MAX_RADIANCE_RAY_DEPTH) {
+    if (currentDepth >= perFrameConstants.options.maxBounces) {
         return float3(0.0, 0.0, 0.0);
     }
 
@@ -57,22 +364,36 @@ float3 shootSecondaryRay(float3 orig, float3 dir, float minT, uint currentDepth)
     payload.color = float3(0, 0, 0);
     payload.distance = 0.0;
     payload.depth = currentDepth + 1;
+    payload.lobeRoughness = lobeRoughness;
 
     TraceRay(SceneBVH, 0, 0xFF, 0, 0, 0, ray, payload);
     return payload.color;
 }
 
+// Unshadowed diffuse lighting of the environment, from its SH projection or its irradiance cubemap
+float3 evaluateAmbientIrradiance(float3 normal)
+{
+    if (perFrameConstants.options.environmentIrradiance == 1 && perFrameConstants.environmentLighting.radianceMipCount > 0) {
+        return evaluateIrradianceSH(normal);
+    } else if (perFrameConstants.options.environmentIrradiance == 2) {
+        return gEnvironmentIrradiance.SampleLevel(defaultSampler, normal, 0.0).rgb * M_PI * perFrameConstants.options.environmentStrength;
+    }
+    return 0.0;
+}
+
 float3 shadeAOV(float3 position, float3 normal, uint currentDepth, out ShadingAOV aov)
 {
-    // Set up random seeed
+    // Set up the sample sequence, indexed by frame since the denoiser filters single samples
     uint2 pixIdx = DispatchRaysIndex().xy;
     uint2 numPix = DispatchRaysDimensions().xy;
-    uint randSeed = initRand(pixIdx.x + pixIdx.y * numPix.x, perFrameConstants.cameraParams.frameCount);
+    SampleGenerator sampleGenerator = initSampleGenerator(SAMPLE_SEQUENCE_BLUE_NOISE_SOBOL, pixIdx, numPix, perFrameConstants.cameraParams.frameCount,
+                                                          perFrameConstants.cameraParams.frameCount, SAMPLE_DIMENSION_FIRST_BOUNCE + currentDepth * SAMPLE_DIMENSIONS_PER_BOUNCE);
 
     // Calculate direct diffuse lighting
     float3 directContrib = 0.0;
     directContrib += evaluateDirectionalLight(position, normal, currentDepth);
     directContrib += evaluatePointLight(position, normal, currentDepth);
+    directContrib += evaluateAmbientIrradiance(normal);
 
     // Accumulate indirect specular
     float3 fresnel = 0.0;
@@ -83,8 +404,8 @@ float3 shadeAOV(float3 position, float3 normal, uint currentDepth, out ShadingAO
             float pdf;
             float brdf;
             float3 mirrorDir = reflect(WorldRayDirection(), normal);
-            float3 sampleDir = samplePhongLobe(randSeed, mirrorDir, exponent, pdf, brdf);
-            float3 reflectionColor = shootSecondaryRay(position, sampleDir, RAY_EPSILON, currentDepth);
+            float3 sampleDir = samplePhongLobe(nextSample2D(sampleGenerator), mirrorDir, exponent, pdf, brdf);
+            float3 reflectionColor = shootSecondaryRay(position, sampleDir, RAY_EPSILON, currentDepth, phongLobeEnvironmentRoughness(exponent));
             specularComponent += reflectionColor * brdf / pdf;
 
             // Equivalent to: fresnel = FresnelReflectanceSchlick(-V, H, materialParams.specular.rgb);
@@ -92,6 +413,26 @@ float3 shadeAOV(float3 position, float3 normal, uint currentDepth, out ShadingAO
         }
     }
 
+    if (currentDepth == 0) {
+        float4 clip = mul(float4(position, 1.0), viewProjMatrix());
+
+        // Motion of the camera only, the instances do not keep their previous transforms
+        ReprojectionParams reprojection = perFrameConstants.reprojection;
+        float4 previousClip = reprojectClip(clip, reprojection.reprojection[0], reprojection.reprojection[1], reprojection.reprojection[2], reprojection.reprojection[3]);
+        float2 motion = clipToPixel(previousClip, float2(numPix)) - clipToPixel(clip, float2(numPix));
+        writeAovs(pixIdx, clip.w, normal, float4(saturate(materialParams.albedo.rgb), materialParams.roughness), motion, min(InstanceIndex(), AOV_INSTANCE_ID_MISS - 1));
+
+        if (restirEnabled()) {
+            RestirPixel pixel;
+            pixel.reservoir = resampleInitialAndTemporal(position, normal, clip);
+            pixel.normal = normal;
+            pixel.hitDistance = RayTCurrent();
+            pixel.albedo = materialParams.albedo.rgb;
+            pixel.viewDepth = clip.w;
+            storeRestirPixel(gReservoirs, pixIdx.x + pixIdx.y * numPix.x, pixel);
+        }
+    }
+
     if (currentDepth == 0) {
         aov.albedo = materialParams.albedo.rgb;
         aov.roughness = materialParams.roughness;
@@ -119,7 +460,7 @@ void PrimaryClosestHit(inout RealtimePayload payload, Attributes attrib)
 [shader("miss")]
 void PrimaryMiss(inout RealtimePayload payload)
 {
-    payload.color = sampleEnvironment();
+    payload.color = sampleEnvironment(environmentLod(payload.lobeRoughness, payload.depth));
     payload.distance = -1.0;
     payload.aov.directLighting = payload.color;
     payload.aov.indirectSpecular = 0.0;
@@ -0,0 +1,116 @@
+#ifndef RESERVOIRHLSLCOMPAT_H
+#define RESERVOIRHLSLCOMPAT_H
+
+// Weighted reservoir resampling of direct lighting, shared by the ReSTIR passes of
+// RealtimeRaytracing.hlsl and the CPU tests. Written in the common subset of HLSL and C++.
+//
+// A reservoir streams candidate lights and keeps one of them with probability proportional to its
+// resampling weight, which is the target pdf of the candidate over the pdf it was drawn with. The
+// kept light is the result of resampled importance sampling (Talbot et al. 2005), so it is
+// distributed close to the target pdf for many candidates. Reservoirs of the previous frame and of
+// neighbouring pixels merge as a stream of their kept lights, each standing for all the candidates of
+// its reservoir (Bitterli et al. 2020, "Spatiotemporal reservoir resampling for real-time ray tracing
+// with dynamic direct lighting").
+
+#ifdef HLSL
+#define RESERVOIR_FUNCTION
+#define RESERVOIR_INOUT(type) inout type
+#else
+#include <cstdint>
+
+namespace Reservoirs
+{
+    typedef uint32_t uint;
+
+#define RESERVOIR_FUNCTION inline
+#define RESERVOIR_INOUT(type) type &
+#endif
+
+#define RESERVOIR_INVALID_LIGHT 0xffffffffu
+
+struct Reservoir
+{
+    uint lightIndex;
+    float weightSum;
+    // Candidates seen, a float as reused reservoirs are scaled down to a limit
+    float M;
+    // Contribution weight of the kept light, see finalizeReservoir and finalizeMergedReservoir.
+    // Replaces one over the pdf in the estimator f / pdf of the light.
+    float W;
+};
+
+RESERVOIR_FUNCTION Reservoir emptyReservoir()
+{
+    Reservoir r;
+    r.lightIndex = RESERVOIR_INVALID_LIGHT;
+    r.weightSum = 0.0f;
+    r.M = 0.0f;
+    r.W = 0.0f;
+    return r;
+}
+
+// Target pdf of the resampling, the unshadowed luminance a light adds to a diffuse surface up to a
+// constant. intensity is the luminance of its intensity towards the surface.
+RESERVOIR_FUNCTION float reservoirTargetPdf(float intensity, float NoL, float distance2)
+{
+    return NoL > 0.0f && distance2 > 0.0f ? intensity * NoL / distance2 : 0.0f;
+}
+
+// Streams a candidate standing for count candidates with the given resampling weight, u uniform in
+// [0, 1). Returns true when it became the kept light.
+RESERVOIR_FUNCTION bool updateReservoir(RESERVOIR_INOUT(Reservoir) r, uint lightIndex, float weight, float count, float u)
+{
+    r.weightSum += weight;
+    r.M += count;
+    if (weight > 0.0f && u * r.weightSum < weight) {
+        r.lightIndex = lightIndex;
+        return true;
+    }
+    return false;
+}
+
+// Sets the contribution weight of a reservoir of candidates drawn at its surface from the target pdf
+// of the kept light
+RESERVOIR_FUNCTION void finalizeReservoir(RESERVOIR_INOUT(Reservoir) r, float targetPdf)
+{
+    r.W = targetPdf > 0.0f && r.M > 0.0f ? r.weightSum / (r.M * targetPdf) : 0.0f;
+}
+
+// Generalized balance heuristic of merging reservoirs (Lin et al. 2022, "Generalized resampled
+// importance sampling"): the share of a light drawn by a reservoir of M candidates, whose surface has
+// the target pdf targetPdf for it, among the merged reservoirs. weightedTargetPdfSum is the sum of M
+// times the target pdf of the light over all merged reservoirs. Unlike weights by candidate counts
+// alone it stays bounded where the light matters more here than to the neighbour that drew it.
+RESERVOIR_FUNCTION float reservoirMisWeight(float M, float targetPdf, float weightedTargetPdfSum)
+{
+    return weightedTargetPdfSum > 0.0f ? M * targetPdf / weightedTargetPdfSum : 0.0f;
+}
+
+// Streams the kept light of a finalized reservoir with its MIS weight. targetPdf is the target pdf of
+// the light at the surface of r, zero when the light does not reach it.
+RESERVOIR_FUNCTION bool mergeReservoir(RESERVOIR_INOUT(Reservoir) r, Reservoir other, float targetPdf, float misWeight, float u)
+{
+    return updateReservoir(r, other.lightIndex, targetPdf * other.W * misWeight, other.M, u);
+}
+
+// Sets the contribution weight of merged reservoirs, whose MIS weights already normalize weightSum
+RESERVOIR_FUNCTION void finalizeMergedReservoir(RESERVOIR_INOUT(Reservoir) r, float targetPdf)
+{
+    r.W = targetPdf > 0.0f ? r.weightSum / targetPdf : 0.0f;
+}
+
+// Bounds the candidates a reservoir stands for, so reused history cannot outweigh fresh candidates
+// for ever and adapts to changes in the lighting. Keeps its contribution weight.
+RESERVOIR_FUNCTION void limitReservoir(RESERVOIR_INOUT(Reservoir) r, float maxM)
+{
+    if (r.M > maxM) {
+        r.weightSum *= maxM / r.M;
+        r.M = maxM;
+    }
+}
+
+#ifndef HLSL
+}
+#endif
+
+#endif // RESERVOIRHLSLCOMPAT_H
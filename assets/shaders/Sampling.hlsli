@@ -0,0 +1,63 @@
+#ifndef SAMPLING_HLSLI
+#define SAMPLING_HLSLI
+
+#include "RaytracingUtils.hlsli"
+#include "SamplingHlslCompat.h"
+
+// Draws the dimensions of one pixel's sample in order, see SamplingHlslCompat.h
+struct SampleGenerator
+{
+    uint sequence;
+    uint index;
+    uint dimension;
+    // Owen scrambling seed, or the state of nextRand for SAMPLE_SEQUENCE_RANDOM
+    uint seed;
+    uint2 pixel;
+};
+
+// The accumulation index drives the Sobol sequences, the random sequence is seeded by the frame count
+// and ignores the dimensions like it always did
+SampleGenerator initSampleGenerator(uint sequence, uint2 pixel, uint2 dims, uint frameCount, uint sampleIndex, uint firstDimension)
+{
+    SampleGenerator generator;
+    generator.sequence = sequence;
+    generator.index = sampleIndex;
+    generator.dimension = firstDimension;
+    generator.pixel = pixel;
+    if (sequence == SAMPLE_SEQUENCE_RANDOM) {
+        generator.seed = initRand(pixel.x + pixel.y * dims.x, frameCount);
+        // The first two bounces share the seed as they always did, deeper ones would repeat their directions
+        if (firstDimension >= SAMPLE_DIMENSION_FIRST_BOUNCE + 2 * SAMPLE_DIMENSIONS_PER_BOUNCE) {
+            generator.seed = initRand(generator.seed, (firstDimension - SAMPLE_DIMENSION_FIRST_BOUNCE) / SAMPLE_DIMENSIONS_PER_BOUNCE);
+        }
+    } else {
+        generator.seed = sampleSequenceSeed(sequence, pixel.x, pixel.y);
+    }
+    return generator;
+}
+
+float2 nextSample2D(inout SampleGenerator generator)
+{
+    if (generator.sequence == SAMPLE_SEQUENCE_RANDOM) {
+        float x = nextRand(generator.seed);
+        float y = nextRand(generator.seed);
+        return float2(x, y);
+    }
+
+    float2 value;
+    value.x = sampleSequenceDimension(generator.sequence, generator.index, generator.dimension, generator.seed, generator.pixel.x, generator.pixel.y);
+    value.y = sampleSequenceDimension(generator.sequence, generator.index, generator.dimension + 1, generator.seed, generator.pixel.x, generator.pixel.y);
+    generator.dimension += 2;
+    return value;
+}
+
+// Takes a whole pattern as well, so later 2D samples stay on pattern boundaries
+float nextSample1D(inout SampleGenerator generator)
+{
+    if (generator.sequence == SAMPLE_SEQUENCE_RANDOM) {
+        return nextRand(generator.seed);
+    }
+    return nextSample2D(generator).x;
+}
+
+#endif // SAMPLING_HLSLI
@@ -0,0 +1,147 @@
+#ifndef SAMPLINGHLSLCOMPAT_H
+#define SAMPLINGHLSLCOMPAT_H
+
+// Sample sequences shared by the shaders, the CPU ray tracer and the pipelines' camera jitter. Written
+// in the common subset of HLSL and C++ on scalar integers, so both sides produce the same bits.
+//
+// A sequence is a set of independent 2D patterns, one for every pair of dimensions, indexed by the
+// accumulation index. Each pattern is the first two dimensions of the Sobol sequence, a (0, 2)-sequence,
+// randomized with hash based Owen scrambling and shuffled in index order (Burley 2020, "Practical
+// Hash-based Owen Scrambling"). With blue noise dithering all pixels of a 64x64 block share the scrambles
+// and the pattern is toroidally shifted per pixel by blue noise masks (Georgiev and Fajardo 2016,
+// "Blue-noise Dithered Sampling"), which leaves the error of neighbouring pixels anticorrelated.
+
+#ifdef HLSL
+#define SAMPLING_FUNCTION
+#else
+#include <cstdint>
+
+namespace Sampling
+{
+    typedef uint32_t uint;
+
+    inline uint reversebits(uint x)
+    {
+        x = (x << 16) | (x >> 16);
+        x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+        x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+        x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+        x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+        return x;
+    }
+
+#define SAMPLING_FUNCTION inline
+#endif
+
+#include "BlueNoiseTable.h"
+
+// DebugOptions::sampleSequence
+#define SAMPLE_SEQUENCE_RANDOM 0            // initRand and nextRand of RaytracingUtils.hlsli, seeded per frame
+#define SAMPLE_SEQUENCE_SOBOL 1             // Owen-scrambled Sobol, scrambled per pixel
+#define SAMPLE_SEQUENCE_BLUE_NOISE_SOBOL 2  // Owen-scrambled Sobol, scrambled per block and dithered per pixel
+
+// Dimensions 0 and 1 jitter the camera, every bounce owns the next SAMPLE_DIMENSIONS_PER_BOUNCE
+#define SAMPLE_DIMENSION_CAMERA 0
+#define SAMPLE_DIMENSION_FIRST_BOUNCE 2
+#define SAMPLE_DIMENSIONS_PER_BOUNCE 16
+
+// PCG hash, from Jarzynski and Olano 2020, "Hash Functions for GPU Rendering"
+SAMPLING_FUNCTION uint samplingHash(uint v)
+{
+    uint state = v * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+SAMPLING_FUNCTION uint samplingHashCombine(uint seed, uint v)
+{
+    return samplingHash(seed ^ (v + 0x9e3779b9u + (seed << 6u) + (seed >> 2u)));
+}
+
+// Scrambles every bit by the bits below it
+SAMPLING_FUNCTION uint laineKarrasPermutation(uint x, uint seed)
+{
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+// Owen scrambling in base 2: every bit is flipped by a hash of the bits above it
+SAMPLING_FUNCTION uint nestedUniformScramble(uint x, uint seed)
+{
+    return reversebits(laineKarrasPermutation(reversebits(x), seed));
+}
+
+// Dimension 0 or 1 of the Sobol sequence. The second dimension's direction numbers follow from the
+// primitive polynomial x + 1, v[i] = v[i - 1] ^ (v[i - 1] >> 1).
+SAMPLING_FUNCTION uint sobol2D(uint index, uint dimension)
+{
+    if (dimension == 0u) {
+        return reversebits(index);
+    }
+    uint result = 0u;
+    uint v = 1u << 31u;
+    for (; index != 0u; index >>= 1u) {
+        if ((index & 1u) != 0u) {
+            result ^= v;
+        }
+        v ^= v >> 1u;
+    }
+    return result;
+}
+
+// 32-bit fixed point sample of the given dimension. The index shuffle uses the same seed for both
+// dimensions of a pattern, so they stay paired.
+SAMPLING_FUNCTION uint sobolOwen(uint index, uint dimension, uint seed)
+{
+    uint patternSeed = samplingHashCombine(seed, dimension >> 1u);
+    uint shuffledIndex = nestedUniformScramble(index, patternSeed);
+    return nestedUniformScramble(sobol2D(shuffledIndex, dimension & 1u), samplingHashCombine(patternSeed, 1u + (dimension & 1u)));
+}
+
+// Rank 0..4095 of the pixel in the given mask, each pattern reading both masks at its own offset
+SAMPLING_FUNCTION uint blueNoiseRank(uint x, uint y, uint dimension)
+{
+    // R2 sequence (Roberts 2018) in 6-bit fixed point
+    uint pattern = dimension >> 1u;
+    uint offsetX = (pattern * 0xc13fa9a9u) >> 26u;
+    uint offsetY = (pattern * 0x91e10da5u) >> 26u;
+    uint texel = BLUE_NOISE_RANKS[((y + offsetY) % BLUE_NOISE_SIZE) * BLUE_NOISE_SIZE + (x + offsetX) % BLUE_NOISE_SIZE];
+    return (dimension & 1u) != 0u ? texel >> 16u : texel & 0xffffu;
+}
+
+// Seed of the Owen scrambles of a pixel, shared by the block for blue noise dithering
+SAMPLING_FUNCTION uint sampleSequenceSeed(uint sequence, uint x, uint y)
+{
+    if (sequence == SAMPLE_SEQUENCE_BLUE_NOISE_SOBOL) {
+        x /= BLUE_NOISE_SIZE;
+        y /= BLUE_NOISE_SIZE;
+    }
+    return samplingHashCombine(samplingHash(x), y);
+}
+
+SAMPLING_FUNCTION float sampleToUnitFloat(uint x)
+{
+    // 24 bits, so the result stays below 1
+    return float(x >> 8u) * (1.0f / 16777216.0f);
+}
+
+// Sample in [0, 1) of a Sobol sequence, the seed from sampleSequenceSeed
+SAMPLING_FUNCTION float sampleSequenceDimension(uint sequence, uint index, uint dimension, uint seed, uint x, uint y)
+{
+    uint value = sobolOwen(index, dimension, seed);
+    if (sequence == SAMPLE_SEQUENCE_BLUE_NOISE_SOBOL) {
+        // Toroidal shift by the center of the rank's interval, wrapping around in fixed point
+        value += (blueNoiseRank(x, y, dimension) << 20u) + (1u << 19u);
+    }
+    return sampleToUnitFloat(value);
+}
+
+#ifndef HLSL
+}
+#endif
+
+#endif // SAMPLINGHLSLCOMPAT_H
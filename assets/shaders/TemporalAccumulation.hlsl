@@ -0,0 +1,138 @@
+#define HLSL
+#include "RaytracingHlslCompat.h"
+#include "TemporalAccumulationHlslCompat.h"
+#include "AtrousHlslCompat.h"
+#include "AovHlslCompat.h"
+
+// New samples of the frame, the outputs of RealtimeRaytracing.hlsl
+RWTexture2D<float4> gDirectLighting : register(u0);
+RWTexture2D<float4> gIndirectSpecular : register(u1);
+// Accumulated colors with the history length in alpha, written for this frame and read from the last
+RWTexture2D<float4> gAccumulatedDirectLighting : register(u2);
+RWTexture2D<float4> gAccumulatedIndirectSpecular : register(u3);
+RWTexture2D<float4> gHistoryDirectLighting : register(u4);
+RWTexture2D<float4> gHistoryIndirectSpecular : register(u5);
+// Depth and normal AOVs of the primary hits of this frame and the last, negative depth for misses
+Texture2D<float> gDepth : register(t0);
+Texture2D<float2> gNormal : register(t1);
+Texture2D<float> gPreviousDepth : register(t2);
+Texture2D<float2> gPreviousNormal : register(t3);
+// Luminance moments of direct lighting in xy and of indirect specular in zw, see blendMoments, and the
+// variance of both that guides the a-trous filter of the denoiser
+RWTexture2D<float4> gMoments : register(u6);
+RWTexture2D<float4> gHistoryMoments : register(u7);
+RWTexture2D<float2> gVariance : register(u8);
+ConstantBuffer<PerFrameConstants> perFrameConstants : register(b0);
+
+#define TEMPORAL_GROUP_SIZE 8
+
+// World position of the primary hit of a pixel at the given view depth, along the unjittered camera
+// ray of RealtimeRaytracing.hlsl
+float3 reconstructPosition(uint2 pixel, float2 dims, float viewDepth)
+{
+    CameraParams camera = perFrameConstants.cameraParams;
+    float2 d = ((pixel + 0.5) / dims) * 2.0 - 1.0;
+    float3 direction = normalize(d.x * camera.U.xyz - d.y * camera.V.xyz + camera.W.xyz);
+    return camera.worldEyePos.xyz + direction * (viewDepth / dot(direction, normalize(camera.W.xyz)));
+}
+
+[numthreads(TEMPORAL_GROUP_SIZE, TEMPORAL_GROUP_SIZE, 1)]
+void main(uint3 dispatchID : SV_DispatchThreadID)
+{
+    uint2 dims;
+    gDirectLighting.GetDimensions(dims.x, dims.y);
+    if (any(dispatchID.xy >= dims)) {
+        return;
+    }
+    uint2 pixel = dispatchID.xy;
+
+    float3 direct = gDirectLighting[pixel].rgb;
+    float3 specular = gIndirectSpecular[pixel].rgb;
+    float4 guide = float4(aovDecodeNormal(gNormal[pixel]), gDepth[pixel]);
+
+    // Moments of the new samples in the 3x3 neighbourhood for clamping the history, and of their
+    // luminance for the variance of short histories
+    float3 directMean = 0.0, directMeanOfSquares = 0.0;
+    float3 specularMean = 0.0, specularMeanOfSquares = 0.0;
+    float4 spatialMoments = 0.0;
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            uint2 tap = uint2(clamp(int2(pixel) + int2(x, y), 0, int2(dims) - 1));
+            float3 directTap = gDirectLighting[tap].rgb;
+            float3 specularTap = gIndirectSpecular[tap].rgb;
+            directMean += directTap / 9.0;
+            directMeanOfSquares += directTap * directTap / 9.0;
+            specularMean += specularTap / 9.0;
+            specularMeanOfSquares += specularTap * specularTap / 9.0;
+            float2 luminance = float2(atrousLuminance(directTap), atrousLuminance(specularTap));
+            spatialMoments += float4(luminance.x, luminance.x * luminance.x, luminance.y, luminance.y * luminance.y) / 9.0;
+        }
+    }
+
+    // Bilinear history of the taps around the reprojected position that show the same surface
+    float historyLength = 0.0;
+    float3 directHistory = 0.0;
+    float3 specularHistory = 0.0;
+    float4 momentsHistory = 0.0;
+    if (perFrameConstants.options.temporalHistoryValid && guide.w > 0.0) {
+        ReprojectionParams reprojection = perFrameConstants.reprojection;
+        float4 clip = mul(float4(reconstructPosition(pixel, float2(dims), guide.w), 1.0),
+                          float4x4(reprojection.viewProj[0], reprojection.viewProj[1], reprojection.viewProj[2], reprojection.viewProj[3]));
+        float4 previousClip = reprojectClip(clip, reprojection.reprojection[0], reprojection.reprojection[1], reprojection.reprojection[2], reprojection.reprojection[3]);
+
+        if (previousClip.w > 0.0) {
+            float2 previousPixel = clipToPixel(previousClip, float2(dims)) - 0.5;
+            int2 base = int2(floor(previousPixel));
+            float4 weights = temporalBilinearWeights(previousPixel - float2(base));
+
+            float weightSum = 0.0;
+            [unroll]
+            for (uint i = 0; i < 4; ++i) {
+                int2 tap = base + int2(i & 1, i >> 1);
+                if (any(tap < 0) || any(tap >= int2(dims))) {
+                    continue;
+                }
+                float4 tapGuide = float4(aovDecodeNormal(gPreviousNormal[tap]), gPreviousDepth[tap]);
+                if (temporalSurfaceMatches(guide.xyz, tapGuide.xyz, previousClip.w, tapGuide.w)) {
+                    float4 directTap = gHistoryDirectLighting[tap];
+                    directHistory += directTap.rgb * weights[i];
+                    specularHistory += gHistoryIndirectSpecular[tap].rgb * weights[i];
+                    momentsHistory += gHistoryMoments[tap] * weights[i];
+                    historyLength += directTap.a * weights[i];
+                    weightSum += weights[i];
+                }
+            }
+
+            // A sliver of a matching tap is not enough history to trust
+            if (weightSum > 0.01) {
+                directHistory /= weightSum;
+                specularHistory /= weightSum;
+                momentsHistory /= weightSum;
+                historyLength /= weightSum;
+            } else {
+                historyLength = 0.0;
+            }
+        }
+    }
+
+    float gamma = perFrameConstants.options.temporalClampGamma;
+    if (gamma > 0.0) {
+        directHistory = clampToNeighbourhood(directHistory, directMean, directMeanOfSquares, gamma);
+        specularHistory = clampToNeighbourhood(specularHistory, specularMean, specularMeanOfSquares, gamma);
+    }
+
+    float minAlpha = perFrameConstants.options.temporalMinAlpha;
+    float3 accumulatedDirect, accumulatedSpecular;
+    float accumulatedLength = blendHistory(accumulatedDirect, directHistory, direct, historyLength, minAlpha);
+    blendHistory(accumulatedSpecular, specularHistory, specular, historyLength, minAlpha);
+
+    gAccumulatedDirectLighting[pixel] = float4(accumulatedDirect, accumulatedLength);
+    gAccumulatedIndirectSpecular[pixel] = float4(accumulatedSpecular, accumulatedLength);
+
+    float2 luminance = float2(atrousLuminance(direct), atrousLuminance(specular));
+    float4 moments = blendMoments(momentsHistory, float4(luminance.x, luminance.x * luminance.x, luminance.y, luminance.y * luminance.y), historyLength, minAlpha);
+    gMoments[pixel] = moments;
+    float4 varianceMoments = accumulatedLength < TEMPORAL_MIN_MOMENTS_LENGTH ? spatialMoments : moments;
+    gVariance[pixel] = float2(accumulatedVariance(varianceFromMoments(varianceMoments.x, varianceMoments.y), accumulatedLength),
+                              accumulatedVariance(varianceFromMoments(varianceMoments.z, varianceMoments.w), accumulatedLength));
+}
@@ -0,0 +1,113 @@
+#ifndef TEMPORALACCUMULATIONHLSLCOMPAT_H
+#define TEMPORALACCUMULATIONHLSLCOMPAT_H
+
+// Reprojection and exponential moving average of the realtime pipeline's outputs, shared by
+// TemporalAccumulation.hlsl and the CPU tests. Written in the common subset of HLSL and C++.
+//
+// Every pixel finds its surface in the previous frame through Camera::GetReprojectionMatrix and blends
+// the bilinear history of the taps whose surface matches in depth and normal with the new sample. The
+// history is clamped to the mean and standard deviation of the new samples around the pixel first, so
+// it follows changes in the lighting instead of ghosting (Salvi 2016, "An excursion in temporal
+// supersampling").
+
+#ifdef HLSL
+#define TEMPORAL_FUNCTION
+#define TEMPORAL_OUT(type) out type
+#else
+#include "Cpu/CpuMath.h"
+#include <cmath>
+
+namespace TemporalAccumulation
+{
+    using namespace DXRFramework::CpuMath;
+
+    inline float abs(float x) { return std::fabs(x); }
+    inline float3 sqrt(const float3 &a) { return float3(std::sqrt(a.x), std::sqrt(a.y), std::sqrt(a.z)); }
+    inline float3 clamp(const float3 &a, const float3 &lo, const float3 &hi) { return (min)((max)(a, lo), hi); }
+
+#define TEMPORAL_FUNCTION inline
+#define TEMPORAL_OUT(type) type &
+#endif
+
+// A tap of the history is the same surface when the normals are within 25 degrees and the depth of
+// the surface in the previous view is within this share of the depth the tap stored
+#define TEMPORAL_NORMAL_THRESHOLD 0.9f
+#define TEMPORAL_DEPTH_TOLERANCE 0.05f
+
+// Clip space position in the previous frame of a clip space position of this frame. The rows are those
+// of Camera::GetReprojectionMatrix in DirectXMath's row vector convention, see ReprojectionParams.
+TEMPORAL_FUNCTION float4 reprojectClip(float4 clip, float4 row0, float4 row1, float4 row2, float4 row3)
+{
+    return row0 * clip.x + row1 * clip.y + row2 * clip.z + row3 * clip.w;
+}
+
+// Continuous pixel coordinates of a clip space position, pixel centres at half integers
+TEMPORAL_FUNCTION float2 clipToPixel(float4 clip, float2 dims)
+{
+    return float2((clip.x / clip.w * 0.5f + 0.5f) * dims.x, (0.5f - clip.y / clip.w * 0.5f) * dims.y);
+}
+
+// Whether a history tap with the given normal and view depth, negative for a miss, shows the surface
+// whose depth in the previous view is expectedDepth
+TEMPORAL_FUNCTION bool temporalSurfaceMatches(float3 normal, float3 historyNormal, float expectedDepth, float historyDepth)
+{
+    return historyDepth > 0.0f && expectedDepth > 0.0f && dot(normal, historyNormal) > TEMPORAL_NORMAL_THRESHOLD &&
+           abs(historyDepth - expectedDepth) < TEMPORAL_DEPTH_TOLERANCE * historyDepth;
+}
+
+// Bilinear weights of the four taps around a continuous pixel position, in the order (0, 0), (1, 0),
+// (0, 1), (1, 1) from the tap at floor(pixel - 0.5). fraction is the offset from that tap.
+TEMPORAL_FUNCTION float4 temporalBilinearWeights(float2 fraction)
+{
+    return float4((1.0f - fraction.x) * (1.0f - fraction.y), fraction.x * (1.0f - fraction.y),
+                  (1.0f - fraction.x) * fraction.y, fraction.x * fraction.y);
+}
+
+// Clamps the history color to the box of gamma standard deviations around the mean of the new samples
+// in the neighbourhood of the pixel, given their mean and mean of squares
+TEMPORAL_FUNCTION float3 clampToNeighbourhood(float3 history, float3 mean, float3 meanOfSquares, float gamma)
+{
+    float3 sigma = sqrt(clamp(meanOfSquares - mean * mean, float3(0.0f, 0.0f, 0.0f), float3(1.0e+30f, 1.0e+30f, 1.0e+30f)));
+    return clamp(history, mean - sigma * gamma, mean + sigma * gamma);
+}
+
+// Weight of a new sample blended into the history of historyLength samples, a running mean until one
+// over the length drops below minAlpha and an exponential moving average with weight minAlpha after that
+TEMPORAL_FUNCTION float temporalBlendAlpha(float historyLength, float minAlpha)
+{
+    float alpha = 1.0f / (historyLength + 1.0f);
+    return alpha > minAlpha ? alpha : minAlpha;
+}
+
+// Blends a new sample into the history. Returns the length of the blended history, capped where the
+// moving average takes over.
+TEMPORAL_FUNCTION float blendHistory(TEMPORAL_OUT(float3) color, float3 history, float3 newSample, float historyLength, float minAlpha)
+{
+    color = lerp(history, newSample, temporalBlendAlpha(historyLength, minAlpha));
+    float blendedLength = historyLength + 1.0f;
+    float maxLength = 1.0f / minAlpha;
+    return blendedLength < maxLength ? blendedLength : maxLength;
+}
+
+// Moments of the luminance of the new samples, the mean and the mean of squares of each output, blended
+// like their colors. Below this history length the variance the denoiser is guided by comes from the
+// new samples around the pixel instead.
+#define TEMPORAL_MIN_MOMENTS_LENGTH 4.0f
+
+TEMPORAL_FUNCTION float4 blendMoments(float4 history, float4 moments, float historyLength, float minAlpha)
+{
+    return lerp(history, moments, temporalBlendAlpha(historyLength, minAlpha));
+}
+
+// Variance of the accumulated color from the variance of the samples it averages. The denoiser's
+// luminance test needs the noise left in the color, not that of a single sample.
+TEMPORAL_FUNCTION float accumulatedVariance(float sampleVariance, float historyLength)
+{
+    return sampleVariance / (historyLength > 1.0f ? historyLength : 1.0f);
+}
+
+#ifndef HLSL
+}
+#endif
+
+#endif // TEMPORALACCUMULATIONHLSLCOMPAT_H
@@ -5,8 +5,10 @@
 #include "RtScene.h"
 #include "RaytracingPipeline.h"
 #include "DenoiseCompositor.h"
+#include "TextureCache.h"
 #include "Camera.h"
 #include "CameraController.h"
+#include <functional>
 
 class DXRExperimentsApp : public DXSample
 {
@@ -35,15 +37,29 @@ private:
 
     DXRFramework::RtContext::SharedPtr mRtContext;
     DXRFramework::RtScene::SharedPtr mRtScene;
+    TextureCache::SharedPtr mTextureCache;
     
+    std::vector<RaytracingPipeline::Material> mMaterials;
+
+    // Pipelines are registered as factories and instantiated on first activation
+    std::vector<std::function<RaytracingPipeline::SharedPtr()>> mPipelineFactories;
     std::vector<RaytracingPipeline::SharedPtr> mRaytracingPipelines;
+    std::vector<double> mPipelineLastActiveTime;
     RaytracingPipeline *mActiveRaytracingPipeline;
     int mActivePipelineIndex;
     std::vector<const char *> mPipelineNames;
 
+    bool mReleaseIdleOutputs;
+    float mIdleOutputTimeout;
+
     DenoiseCompositor::SharedPtr mDenoiser;
 
+    std::string mStartupTimeline;
+
     void InitRaytracing();
+    void BindPipelineScene(RaytracingPipeline *pipeline);
+    void ActivatePipeline(int index);
+    void ReleaseIdlePipelineOutputs();
     void BlitToBackbuffer(
         ID3D12Resource *textureResource, 
         D3D12_RESOURCE_STATES fromState = D3D12_RESOURCE_STATE_UNORDERED_ACCESS, 
@@ -16,6 +16,15 @@ public:
     {
         D3D12_GPU_DESCRIPTOR_HANDLE directLightingSrv;
         D3D12_GPU_DESCRIPTOR_HANDLE indirectSpecularSrv;
+        // AOVs of the primary hits, see AovHlslCompat.h, and the luminance variance of both signals from
+        // temporal accumulation. The a-trous filter needs depth, normal and variance and the denoiser
+        // falls back to the joint bilateral filter without them. With the albedo it filters the direct
+        // lighting divided by it, with the instance IDs it stops at the edges of instances.
+        D3D12_GPU_DESCRIPTOR_HANDLE depthSrv;
+        D3D12_GPU_DESCRIPTOR_HANDLE normalSrv;
+        D3D12_GPU_DESCRIPTOR_HANDLE varianceSrv;
+        D3D12_GPU_DESCRIPTOR_HANDLE albedoSrv;
+        D3D12_GPU_DESCRIPTOR_HANDLE instanceIdSrv;
     };
     void dispatch(ID3D12GraphicsCommandList *commandList, InputComponents inputs, UINT frameIndex, UINT width, UINT height);
 
@@ -29,8 +38,12 @@ public:
 private:
     DenoiseCompositor(DXRFramework::RtContext::SharedPtr context);
 
+    void dispatchAtrous(ID3D12GraphicsCommandList *commandList, const InputComponents &inputs, UINT frameIndex, UINT width, UINT height);
+
     ComPtr<ID3D12RootSignature> mComputeRootSignature;
-    ComPtr<ID3D12PipelineState> mComputeState[2];
+    ComPtr<ID3D12PipelineState> mComputeState[3];
+    ComPtr<ID3D12RootSignature> mAtrousRootSignature;
+    ComPtr<ID3D12PipelineState> mAtrousState;
 
     DXRFramework::RtContext::SharedPtr mRtContext;
 
@@ -41,6 +54,23 @@ private:
     D3D12_GPU_DESCRIPTOR_HANDLE mOutputUavGpuHandle[2];
     D3D12_GPU_DESCRIPTOR_HANDLE mOutputSrvGpuHandle[2];
 
+    // Iterations of the a-trous filter ping-pong between two sets of both signals, the variance in alpha
+    ComPtr<ID3D12Resource> mAtrousResource[2][2];
+    UINT mAtrousUavHeapIndex[2][2] = { { UINT_MAX, UINT_MAX }, { UINT_MAX, UINT_MAX } };
+    UINT mAtrousSrvHeapIndex[2][2] = { { UINT_MAX, UINT_MAX }, { UINT_MAX, UINT_MAX } };
+    D3D12_GPU_DESCRIPTOR_HANDLE mAtrousUavGpuHandle[2][2];
+    D3D12_GPU_DESCRIPTOR_HANDLE mAtrousSrvGpuHandle[2][2];
+
+    enum Filter
+    {
+        JointBilateral = 0,
+        Atrous,
+    };
+    int mFilter = Atrous;
+    int mAtrousIterations = 5;
+    bool mDemodulateAlbedo = true;
+    bool mInstanceEdges = true;
+
     struct DenoiserParams
     {
         float exposure;
@@ -49,6 +79,9 @@ private:
         UINT gammaCorrect;
         int maxKernelSize;
         UINT debugVisualize; // 0: composite, 1: show denoised, 2: show input, 3: show joint
+        float phiNormal;
+        float phiDepth;
+        float phiLuminance;
     };
 
     ConstantBuffer<DenoiserParams> mConstantBuffer;
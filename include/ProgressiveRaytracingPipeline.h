@@ -3,6 +3,8 @@
 #include "RaytracingPipeline.h"
 #include "RtBindings.h"
 #include "RtContext.h"
+#include "RtEnvironmentSampler.h"
+#include "RtLightTree.h"
 #include "RtProgram.h"
 #include "RtScene.h"
 #include "RtState.h"
@@ -10,6 +12,7 @@
 #include "Camera.h"
 #include <vector>
 #include <random>
+#include <future>
 
 class ProgressiveRaytracingPipeline : public RaytracingPipeline
 {
@@ -23,8 +26,9 @@ public:
     virtual void update(float elAapsedTime, UINT elapsedFrames, UINT prevFrameIndex, UINT frameIndex, UINT width, UINT height) override;
     virtual void render(ID3D12GraphicsCommandList *commandList, UINT frameIndex, UINT width, UINT height) override;
 
-    virtual void loadResources(ID3D12CommandQueue *uploadCommandQueue, UINT frameCount) override;
+    virtual void loadResources(TextureCache::SharedPtr textureCache, UINT frameCount) override;
     virtual void createOutputResource(DXGI_FORMAT format, UINT width, UINT height) override;
+    virtual void releaseOutputResource() override;
     virtual void buildAccelerationStructures() override;
 
     virtual void addMaterial(Material material) override { mMaterials.push_back(material); }
@@ -41,6 +45,38 @@ public:
 private:
     ProgressiveRaytracingPipeline(DXRFramework::RtContext::SharedPtr context);
 
+    void readBackTileStates(UINT frameIndex);
+    void readBackPathLengths(UINT frameIndex);
+
+    // Alias table of RtEnvironmentSampler in a raw buffer, see EnvironmentSampling.hlsli
+    struct EnvironmentTable
+    {
+        ComPtr<ID3D12Resource> buffer;
+        D3D12_GPU_DESCRIPTOR_HANDLE srvGpuHandle;
+        UINT width = 0;
+        UINT height = 0;
+        double buildTimeMs = 0.0;
+    };
+    // Runs in the background, the view is written to the srvHeapIndex the caller reserved
+    static EnvironmentTable createEnvironmentTable(DXRFramework::RtContext::SharedPtr context, TextureCache::TextureHandle environment, UINT srvHeapIndex);
+
+    // RtLightTree over lights scattered through the scene, nodes and lights in raw buffers, see LightTree.hlsli
+    struct LightTreeBuffers
+    {
+        ComPtr<ID3D12Resource> nodes;
+        ComPtr<ID3D12Resource> lights;
+        UINT nodesSrvHeapIndex = UINT_MAX;
+        UINT lightsSrvHeapIndex = UINT_MAX;
+        D3D12_GPU_DESCRIPTOR_HANDLE nodesSrvGpuHandle;
+        D3D12_GPU_DESCRIPTOR_HANDLE lightsSrvGpuHandle;
+        UINT lightCount = 0;
+        UINT nodeCount = 0;
+        UINT depth = 0;
+        float totalIntensity = 0.0f;
+        double buildTimeMs = 0.0;
+    };
+    void createLightTree(LightTreeBuffers &buffers, UINT lightCount, float totalIntensity);
+
     // Pipeline components
     DXRFramework::RtContext::SharedPtr mRtContext;
     DXRFramework::RtProgram::SharedPtr mRtProgram;
@@ -61,12 +97,55 @@ private:
 
     ConstantBuffer<PerFrameConstants> mConstantBuffer;
 
-    std::vector<ComPtr<ID3D12Resource>> mTextureResources;
-    std::vector<D3D12_GPU_DESCRIPTOR_HANDLE> mTextureSrvGpuHandles;
+    // Adaptive sampling: per pixel luminance moments, per tile states written by a compute pass and
+    // copied to a readback buffer per frame in flight
+    ComPtr<ID3D12Resource> mMomentsResource;
+    UINT mMomentsUavHeapIndex = UINT_MAX;
+    D3D12_GPU_DESCRIPTOR_HANDLE mMomentsUavGpuHandle;
+    ComPtr<ID3D12Resource> mTileActiveResource;
+    UINT mTileActiveUavHeapIndex = UINT_MAX;
+    D3D12_GPU_DESCRIPTOR_HANDLE mTileActiveUavGpuHandle;
+    ComPtr<ID3D12Resource> mTileActiveReadback;
+    ComPtr<ID3D12RootSignature> mAdaptiveRootSignature;
+    ComPtr<ID3D12PipelineState> mAdaptiveState;
+    UINT mTilesX = 0;
+    UINT mTilesY = 0;
+    UINT mFrameCount = 0;
+
+    // DebugOptions::pathLengthHistogram: samples per path length of every frame, read back like the
+    // tile states and summed over the accumulation
+    ComPtr<ID3D12Resource> mPathLengthResource;
+    UINT mPathLengthUavHeapIndex = UINT_MAX;
+    D3D12_GPU_DESCRIPTOR_HANDLE mPathLengthUavGpuHandle;
+    ComPtr<ID3D12Resource> mPathLengthZeros;
+    ComPtr<ID3D12Resource> mPathLengthReadback;
+    std::vector<UINT> mPathLengthReadbackGeneration;
+    std::vector<UINT64> mPathLengthExpectedSamples; // per frame, UINT64_MAX when adaptive sampling skips tiles
+    std::vector<UINT64> mPathLengthCounts;
+
+    std::vector<TextureCache::PendingTexture> mPendingTextures;
+    std::vector<TextureCache::TextureHandle> mTextures;
+
+    // Built in the background once the environment cubemap has loaded
+    std::future<EnvironmentTable> mPendingEnvironmentTable;
+    EnvironmentTable mEnvironmentTable;
+
+    // Two sets, a rebuild fills the one no frame in flight reads and swaps them
+    LightTreeBuffers mLightTrees[2];
+    UINT mLightTreeIndex = 0;
+    UINT mFramesSinceLightTreeSwap = 0;
+    UINT mLightCount = 1000;
+    float mLightIntensity = 100.0f;
 
     // Rendering states
     bool mActive;
     UINT mAccumCount;
+    // Incremented whenever accumulation restarts or the threshold changes, tile states read back from before are stale
+    UINT mAccumGeneration = 0;
+    std::vector<UINT> mReadbackGeneration;
+    std::vector<UINT> mReadbackAccumCount;
+    UINT mActiveTileCount = 0;
+    bool mConverged = false;
     bool mFrameAccumulationEnabled;
     bool mAnimationPaused;
     DebugOptions mShaderDebugOptions;
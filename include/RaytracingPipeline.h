@@ -2,6 +2,7 @@
 
 #include "RtContext.h"
 #include "RtScene.h"
+#include "TextureCache.h"
 #include "RaytracingHlslCompat.h"
 #include "Camera.h"
 
@@ -15,8 +16,10 @@ public:
     virtual void update(float elapsedTime, UINT elapsedFrames, UINT prevFrameIndex, UINT frameIndex, UINT width, UINT height) = 0;
     virtual void render(ID3D12GraphicsCommandList *commandList, UINT frameIndex, UINT width, UINT height) = 0;
 
-    virtual void loadResources(ID3D12CommandQueue *uploadCommandQueue, UINT frameCount) = 0;
+    virtual void loadResources(TextureCache::SharedPtr textureCache, UINT frameCount) = 0;
     virtual void createOutputResource(DXGI_FORMAT format, UINT width, UINT height) = 0;
+    // Frees output textures while keeping their descriptor slots; getOutputResource() returns null until recreated
+    virtual void releaseOutputResource() = 0;
     virtual void buildAccelerationStructures() = 0;
 
     struct Material 
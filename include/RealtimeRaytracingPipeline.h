@@ -6,10 +6,11 @@
 #include "RtProgram.h"
 #include "RtScene.h"
 #include "RtState.h"
+#include "RtLightTree.h"
 #include "RaytracingHlslCompat.h"
+#include "AovHlslCompat.h"
 #include "Camera.h"
 #include <vector>
-#include <random>
 
 class RealtimeRaytracingPipeline : public RaytracingPipeline
 {
@@ -23,18 +24,28 @@ public:
     virtual void update(float elapsedTime, UINT elapsedFrames, UINT prevFrameIndex, UINT frameIndex, UINT width, UINT height) override;
     virtual void render(ID3D12GraphicsCommandList *commandList, UINT frameIndex, UINT width, UINT height) override;
 
-    virtual void loadResources(ID3D12CommandQueue *uploadCommandQueue, UINT frameCount) override;
+    virtual void loadResources(TextureCache::SharedPtr textureCache, UINT frameCount) override;
     virtual void createOutputResource(DXGI_FORMAT format, UINT width, UINT height) override;
+    virtual void releaseOutputResource() override;
     virtual void buildAccelerationStructures() override;
 
     virtual void addMaterial(Material material) override { mMaterials.push_back(material); }
     virtual void setCamera(std::shared_ptr<Math::Camera> camera) override { mCamera = camera; }
     virtual void setScene(DXRFramework::RtScene::SharedPtr scene) override;
 
+    // The accumulated outputs of the last frame when it ran temporal accumulation, its samples otherwise
     virtual int getNumOutputs() override { return kNumOutputResources; }
-    virtual ID3D12Resource *getOutputResource(UINT id) override { return mOutputResource[id].Get(); }
-    virtual D3D12_GPU_DESCRIPTOR_HANDLE getOutputUavHandle(UINT id) override { return mOutputUavGpuHandle[id]; }
-    virtual D3D12_GPU_DESCRIPTOR_HANDLE getOutputSrvHandle(UINT id) override { return mOutputSrvGpuHandle[id]; }
+    virtual ID3D12Resource *getOutputResource(UINT id) override { return mOutputsAccumulated ? mAccumulationResource[mHistoryIndex][id].Get() : mOutputResource[id].Get(); }
+    virtual D3D12_GPU_DESCRIPTOR_HANDLE getOutputUavHandle(UINT id) override { return mOutputsAccumulated ? mAccumulationUavGpuHandle[mHistoryIndex][id] : mOutputUavGpuHandle[id]; }
+    virtual D3D12_GPU_DESCRIPTOR_HANDLE getOutputSrvHandle(UINT id) override { return mOutputsAccumulated ? mAccumulationSrvGpuHandle[mHistoryIndex][id] : mOutputSrvGpuHandle[id]; }
+
+    // AOVs of the primary hits of the last frame, see AovHlslCompat.h, null for those it did not write
+    ID3D12Resource *getAovResource(UINT aov) { return (mAovsWritten & AOV_BIT(aov)) ? mAovResource[mHistoryIndex][aov].Get() : nullptr; }
+    D3D12_GPU_DESCRIPTOR_HANDLE getAovSrvHandle(UINT aov) { return mAovSrvGpuHandle[mHistoryIndex][aov]; }
+    // Luminance variance of both outputs that guides the denoiser's a-trous filter, null unless the last
+    // frame ran temporal accumulation
+    ID3D12Resource *getVarianceResource() { return mOutputsAccumulated ? mVarianceResource.Get() : nullptr; }
+    D3D12_GPU_DESCRIPTOR_HANDLE getVarianceSrvHandle() { return mVarianceSrvGpuHandle; }
 
     virtual bool *isActive() override { return &mActive; }
     virtual const char *getName() override { return "Realtime Ray Tracing Pipeline"; }
@@ -60,15 +71,72 @@ private:
     D3D12_GPU_DESCRIPTOR_HANDLE mOutputUavGpuHandle[2];
     D3D12_GPU_DESCRIPTOR_HANDLE mOutputSrvGpuHandle[2];
 
+    // Reservoirs of ReSTIR direct lighting, RestirPixel in RealtimeRaytracing.hlsl. The first holds
+    // the reservoirs of the current frame, the second those after spatial reuse, the history of the next.
+    const int kNumReservoirResources = 2;
+    ComPtr<ID3D12Resource> mReservoirResource[2];
+    UINT mReservoirUavHeapIndex[2] = { UINT_MAX, UINT_MAX };
+    D3D12_GPU_DESCRIPTOR_HANDLE mReservoirUavGpuHandle;
+
+    // AOVs of the primary hits, written by the ray generation. Depth and normal alternate between frames
+    // for the history of temporal accumulation, the other AOVs have one resource both sets share. The
+    // views of a set are a range of the heap in AOV order.
+    ComPtr<ID3D12Resource> mAovResource[2][AOV_COUNT];
+    UINT mAovUavHeapIndex[2][AOV_COUNT] = { { UINT_MAX, UINT_MAX, UINT_MAX, UINT_MAX, UINT_MAX }, { UINT_MAX, UINT_MAX, UINT_MAX, UINT_MAX, UINT_MAX } };
+    UINT mAovSrvHeapIndex[2][AOV_COUNT] = { { UINT_MAX, UINT_MAX, UINT_MAX, UINT_MAX, UINT_MAX }, { UINT_MAX, UINT_MAX, UINT_MAX, UINT_MAX, UINT_MAX } };
+    D3D12_GPU_DESCRIPTOR_HANDLE mAovUavGpuHandle[2];
+    D3D12_GPU_DESCRIPTOR_HANDLE mAovSrvGpuHandle[2][AOV_COUNT];
+    UINT mAovsWritten = 0; // AOV_BIT of the AOVs of the last frame
+    UINT64 mOutputPixelCount = 0;
+
+    // Temporal accumulation of the outputs, TemporalAccumulation.hlsl. The accumulated outputs alternate
+    // between frames like the depth and normal AOVs, the set of the last frame is the history.
+    ComPtr<ID3D12Resource> mAccumulationResource[2][2];
+    UINT mAccumulationUavHeapIndex[2][2] = { { UINT_MAX, UINT_MAX }, { UINT_MAX, UINT_MAX } };
+    UINT mAccumulationSrvHeapIndex[2][2] = { { UINT_MAX, UINT_MAX }, { UINT_MAX, UINT_MAX } };
+    D3D12_GPU_DESCRIPTOR_HANDLE mAccumulationUavGpuHandle[2][2];
+    D3D12_GPU_DESCRIPTOR_HANDLE mAccumulationSrvGpuHandle[2][2];
+    // Luminance moments alternate like the accumulated outputs, the variance they give is that of the frame
+    ComPtr<ID3D12Resource> mMomentsResource[2];
+    UINT mMomentsUavHeapIndex[2] = { UINT_MAX, UINT_MAX };
+    D3D12_GPU_DESCRIPTOR_HANDLE mMomentsUavGpuHandle[2];
+    ComPtr<ID3D12Resource> mVarianceResource;
+    UINT mVarianceUavHeapIndex = UINT_MAX;
+    UINT mVarianceSrvHeapIndex = UINT_MAX;
+    D3D12_GPU_DESCRIPTOR_HANDLE mVarianceUavGpuHandle;
+    D3D12_GPU_DESCRIPTOR_HANDLE mVarianceSrvGpuHandle;
+    ComPtr<ID3D12RootSignature> mTemporalRootSignature;
+    ComPtr<ID3D12PipelineState> mTemporalState;
+    UINT mHistoryIndex = 0;
+    bool mHistoryValid = false;
+    bool mOutputsAccumulated = false;
+
+    // The lights of the progressive pipeline's default light tree, built once
+    DXRFramework::RtLightTree::SharedPtr mLightTree;
+    ComPtr<ID3D12Resource> mLightTreeNodes;
+    ComPtr<ID3D12Resource> mLightTreeLights;
+    D3D12_GPU_DESCRIPTOR_HANDLE mLightTreeNodesSrvGpuHandle;
+    D3D12_GPU_DESCRIPTOR_HANDLE mLightTreeLightsSrvGpuHandle;
+    double mLightTreeBuildTimeMs = 0.0;
+
     ConstantBuffer<PerFrameConstants> mConstantBuffer;
 
-    std::vector<ComPtr<ID3D12Resource>> mTextureResources;
-    std::vector<D3D12_GPU_DESCRIPTOR_HANDLE> mTextureSrvGpuHandles;
+    std::vector<TextureCache::PendingTexture> mPendingTextures;
+    std::vector<TextureCache::TextureHandle> mTextures;
 
     // Rendering states
     bool mActive;
     bool mAnimationPaused;
-
-    std::mt19937 mRng;
-    std::uniform_real_distribution<float> mRngDist;     
+    bool mPrefilteredEnvironmentMisses = true;
+    int mEnvironmentIrradiance = 1; // DebugOptions::environmentIrradiance, SH by default
+    int mManyLightSampling = 0; // DebugOptions::manyLightSampling, the source of ReSTIR's candidates
+    int mRestirCandidates = 8;
+    bool mRestirTemporalReuse = true;
+    int mRestirSpatialSamples = 5;
+    float mRestirSpatialRadius = 30.0f;
+    float mRestirHistoryLimit = 20.0f;
+    bool mTemporalAccumulation = true;
+    float mTemporalMinAlpha = 0.1f;
+    float mTemporalClampGamma = 1.25f;
+    UINT mAovMask = AOV_ALL_MASK; // temporal accumulation adds AOV_TEMPORAL_MASK
 };
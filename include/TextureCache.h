@@ -0,0 +1,87 @@
+#pragma once
+
+#include "RtContext.h"
+#include "Cpu/CpuMath.h"
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Reference counted cache of GPU textures keyed by file path. Each file is decoded and uploaded once
+// on a background thread; every requester shares the same resource and SRV. Uploads go through the
+// context's copy queue, except for textures that need mips generated, which use the given queue.
+class TextureCache
+{
+public:
+    using SharedPtr = std::shared_ptr<TextureCache>;
+
+    struct Texture
+    {
+        ComPtr<ID3D12Resource> resource;
+        D3D12_GPU_DESCRIPTOR_HANDLE srvGpuHandle;
+        UINT srvHeapIndex;
+        UINT64 sizeInBytes;
+        double loadTimeMs;
+        bool converted;
+
+        // Top mip in float RGBA, faces one after another, for textures loaded with KeepCpuCopy.
+        // Empty for block compressed formats and textures with generated mips.
+        std::vector<DXRFramework::CpuMath::float4> cpuTexels;
+        UINT cpuWidth = 0;
+        UINT cpuHeight = 0;
+
+        // For float cubemaps loaded with PrefilterEnvironment, mips from 1 on hold the GGX prefiltered
+        // radiance of RtEnvironmentPrefilter instead of the box filtered mips of the file, and
+        // irradianceSH its irradiance in rgb. prefilteredMipCount is 0 for other textures.
+        UINT prefilteredMipCount = 0;
+        DirectX::XMFLOAT4 irradianceSH[9] = {};
+        double prefilterTimeMs = 0.0;
+    };
+    using TextureHandle = std::shared_ptr<const Texture>;
+    using PendingTexture = std::shared_future<TextureHandle>;
+
+    enum LoadFlags
+    {
+        None = 0,
+        GenerateMips = 0x1,
+        Cubemap = 0x2,
+        KeepCpuCopy = 0x4,
+        PrefilterEnvironment = 0x8
+    };
+
+    static SharedPtr create(DXRFramework::RtContext::SharedPtr context, ID3D12CommandQueue *mipGenerationQueue) { return SharedPtr(new TextureCache(context, mipGenerationQueue)); }
+    ~TextureCache() = default;
+
+    // Returns immediately. The first request for a path starts the decode and upload in the background,
+    // later requests share the same pending texture, so the flags of the first request apply.
+    // Load errors are rethrown from get().
+    // An up to date "<name>.bc.dds" produced by tools/TextureConverter is loaded instead of the source,
+    // unless KeepCpuCopy or PrefilterEnvironment ask for the texels on the CPU.
+    PendingTexture loadAsync(const std::wstring &path, UINT flags = None);
+    TextureHandle load(const std::wstring &path, UINT flags = None) { return loadAsync(path, flags).get(); }
+
+    // Drops loaded textures that are no longer referenced outside the cache and recycles their
+    // descriptor slots. The caller must make sure the GPU is no longer using them.
+    void releaseUnused();
+
+    UINT64 getResidentBytes() const;
+    std::string report() const;
+
+private:
+    TextureCache(DXRFramework::RtContext::SharedPtr context, ID3D12CommandQueue *mipGenerationQueue);
+
+    TextureHandle loadTexture(const std::wstring &path, UINT flags, UINT srvHeapIndex);
+
+    struct Entry
+    {
+        PendingTexture texture;
+        UINT requests;
+    };
+
+    DXRFramework::RtContext::SharedPtr mRtContext;
+    ID3D12CommandQueue *mMipGenerationQueue;
+
+    mutable std::mutex mMutex;
+    std::map<std::wstring, Entry> mEntries;
+    std::vector<UINT> mFreeSrvHeapIndices;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace DXRFramework
+{
+    class RtJobSystem;
+}
+
+// Small dependency graph of CPU tasks executed on a job system.
+// Every task is timed so the graph can report a timeline and its critical path.
+class TaskGraph
+{
+public:
+    using TaskId = size_t;
+    using Clock = std::chrono::high_resolution_clock;
+
+    TaskGraph();
+
+    // Dependencies must refer to tasks that were added earlier.
+    TaskId addTask(const std::string &name, std::function<void()> function, std::vector<TaskId> dependencies = {});
+
+    // Blocks until every task has finished. The first exception thrown by a task is rethrown here
+    // after the remaining in-flight tasks are drained; tasks that depend on a failed task are skipped.
+    // A task becomes a job as soon as its last dependency finishes, so tasks can run parallel loops
+    // on the same job system without blocking its threads.
+    void run(DXRFramework::RtJobSystem &jobSystem);
+
+    // Same on a job system of its own with the given number of threads, 0 for one per hardware thread
+    void run(UINT maxWorkerThreads = 0);
+
+    // Record work executed outside of the graph (e.g. on the main thread) so it shows up in the timeline.
+    void recordExternal(const std::string &name, Clock::time_point start, Clock::time_point end);
+
+    // Human readable timeline sorted by start time. Tasks on the critical path are marked with '*'.
+    std::string report() const;
+
+    double getWallTimeMs() const;
+    double getCriticalPathMs() const;
+
+private:
+    struct Task
+    {
+        std::string name;
+        std::function<void()> function;
+        std::vector<TaskId> dependencies;
+        std::vector<TaskId> dependents;
+        UINT threadIndex = 0;
+        Clock::time_point start;
+        Clock::time_point end;
+        bool external = false;
+    };
+
+    std::vector<Task> mTasks;
+    Clock::time_point mOrigin;
+
+    double toMs(Clock::time_point t) const { return std::chrono::duration<double, std::milli>(t - mOrigin).count(); }
+    std::vector<TaskId> computeCriticalPath(double *lengthMs) const;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "CpuProgram.h"
+#include "CpuScene.h"
+#include <cstring>
+
+namespace DXRFramework
+{
+    // CPU counterpart of RtParams. Root constants are packed the same way; descriptors become shared
+    // pointers to whatever object the shader reads (a CpuTexture, an RtGeometry, ...).
+    class CpuParams
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CpuParams>;
+
+        static SharedPtr create() { return SharedPtr(new CpuParams()); }
+
+        void append32BitConstants(const void *constants, uint32_t num32BitConstants)
+        {
+            size_t offset = mConstants.size();
+            mConstants.resize(offset + num32BitConstants * 4);
+            memcpy(mConstants.data() + offset, constants, num32BitConstants * 4);
+        }
+        void appendResource(std::shared_ptr<const void> resource) { mResources.push_back(resource); }
+        void clear() { mConstants.clear(); mResources.clear(); }
+
+        template <typename T>
+        const T &getConstants(uint32_t byteOffset = 0) const { return *reinterpret_cast<const T*>(mConstants.data() + byteOffset); }
+
+        template <typename T>
+        const T *getResource(uint32_t slot) const { return slot < mResources.size() ? static_cast<const T*>(mResources[slot].get()) : nullptr; }
+
+    private:
+        CpuParams() = default;
+
+        std::vector<uint8_t> mConstants;
+        std::vector<std::shared_ptr<const void>> mResources;
+    };
+
+    // CPU counterpart of RtBindings: one set of parameters per shader table record. Shaders read
+    // the parameters directly so there is nothing to apply.
+    class CpuBindings
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CpuBindings>;
+
+        static SharedPtr create(CpuProgram::SharedPtr program, CpuScene::SharedPtr scene) { return SharedPtr(new CpuBindings(program, scene)); }
+
+        uint32_t getHitProgramsCount() const { return mProgram->getHitProgramCount(); }
+        uint32_t getMissProgramsCount() const { return mProgram->getMissProgramCount(); }
+
+        const CpuParams::SharedPtr& getHitVars(uint32_t rayID, uint32_t meshID) { return mHitParams[rayID][meshID]; }
+        const CpuParams::SharedPtr& getRayGenVars() { return mRayGenParams; }
+        const CpuParams::SharedPtr& getMissVars(uint32_t rayID) { return mMissParams[rayID]; }
+        const CpuParams::SharedPtr& getGlobalVars() { return mGlobalParams; }
+
+        // Hit record index as computed by TraceRay
+        const CpuParams &getHitRecord(uint32_t recordIndex) const
+        {
+            uint32_t hitCount = mProgram->getHitProgramCount();
+            return *mHitParams[recordIndex % hitCount][recordIndex / hitCount];
+        }
+
+        const CpuProgram::SharedPtr& getProgram() const { return mProgram; }
+        const CpuScene::SharedPtr& getScene() const { return mScene; }
+
+    private:
+        CpuBindings(CpuProgram::SharedPtr program, CpuScene::SharedPtr scene) : mProgram(program), mScene(scene)
+        {
+            mGlobalParams = CpuParams::create();
+            mRayGenParams = CpuParams::create();
+            for (uint32_t i = 0; i < program->getMissProgramCount(); ++i) {
+                mMissParams.push_back(CpuParams::create());
+            }
+            mHitParams.resize(program->getHitProgramCount());
+            for (auto &rayParams : mHitParams) {
+                for (uint32_t i = 0; i < scene->getNumInstances(); ++i) {
+                    rayParams.push_back(CpuParams::create());
+                }
+            }
+        }
+
+        CpuProgram::SharedPtr mProgram;
+        CpuScene::SharedPtr mScene;
+
+        CpuParams::SharedPtr mGlobalParams;
+        CpuParams::SharedPtr mRayGenParams;
+        std::vector<std::vector<CpuParams::SharedPtr>> mHitParams;
+        std::vector<CpuParams::SharedPtr> mMissParams;
+    };
+}
@@ -0,0 +1,652 @@
+#include "CpuBvh.h"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+
+namespace DXRFramework
+{
+    using namespace CpuMath;
+
+    namespace
+    {
+        // Primitives are moved around during the build instead of indices, so partitioning and binning
+        // stream through contiguous memory
+        struct PrimitiveRef
+        {
+            CpuAabb bounds;
+            uint32_t index;
+
+            float3 center() const { return bounds.center(); }
+        };
+
+        struct Bin
+        {
+            CpuAabb bounds;
+            uint32_t count;
+
+            void clear()
+            {
+                bounds = CpuAabb::empty();
+                count = 0;
+            }
+
+            void add(const Bin &other)
+            {
+                bounds.grow(other.bounds);
+                count += other.count;
+            }
+        };
+
+        // Counts references by the slab their primitive enters and exits in, so that a straddling
+        // reference counts for both sides of the planes in between
+        struct SpatialBin
+        {
+            CpuAabb bounds;
+            uint32_t enter;
+            uint32_t exit;
+
+            void clear()
+            {
+                bounds = CpuAabb::empty();
+                enter = 0;
+                exit = 0;
+            }
+        };
+
+        struct SpatialSplit
+        {
+            float cost = 1e30f; // same units as the object split cost
+            int axis = -1;
+            float position = 0.0f;
+            CpuAabb leftBounds;
+            CpuAabb rightBounds;
+            uint32_t leftCount = 0;
+            uint32_t rightCount = 0;
+        };
+
+        // Bounds of a range of primitives and of their centers
+        struct RangeInfo
+        {
+            CpuAabb bounds = CpuAabb::empty();
+            CpuAabb centerBounds = CpuAabb::empty();
+
+            void grow(const PrimitiveRef &ref)
+            {
+                bounds.grow(ref.bounds);
+                centerBounds.grow(ref.center());
+            }
+        };
+
+        const uint32_t kMaxBins = 32;
+        const uint32_t kMedianSplitDepth = CpuBvh::kMaxDepth / 2;
+        const uint32_t kParallelBinningThreshold = 1 << 16;
+
+        // Only the bins in use are cleared, small nodes would otherwise spend most of their time here
+        struct BinSet
+        {
+            Bin bins[3][kMaxBins];
+
+            void clear(uint32_t binCount)
+            {
+                for (int axis = 0; axis < 3; ++axis) {
+                    for (uint32_t b = 0; b < binCount; ++b) {
+                        bins[axis][b].clear();
+                    }
+                }
+            }
+        };
+
+        uint32_t expandBits(uint32_t v)
+        {
+            v = (v * 0x00010001u) & 0xFF0000FFu;
+            v = (v * 0x00000101u) & 0x0F00F00Fu;
+            v = (v * 0x00000011u) & 0xC30C30C3u;
+            v = (v * 0x00000005u) & 0x49249249u;
+            return v;
+        }
+
+        // 30-bit Morton code of a point normalized to the unit cube
+        uint32_t mortonCode(const float3 &p)
+        {
+            uint32_t x = static_cast<uint32_t>((std::min)((std::max)(p.x * 1024.0f, 0.0f), 1023.0f));
+            uint32_t y = static_cast<uint32_t>((std::min)((std::max)(p.y * 1024.0f, 0.0f), 1023.0f));
+            uint32_t z = static_cast<uint32_t>((std::min)((std::max)(p.z * 1024.0f, 0.0f), 1023.0f));
+            return (expandBits(x) << 2) | (expandBits(y) << 1) | expandBits(z);
+        }
+
+        class Builder
+        {
+        public:
+            Builder(std::vector<PrimitiveRef> &refs, std::vector<CpuBvh::Node> &nodes, const CpuBvh::BuildOptions &options, const CpuBvh::SplitPrimitive &splitPrimitive)
+                : mRefs(refs), mNodes(nodes), mOptions(options), mSplitPrimitive(splitPrimitive), mRootArea(0.0f), mNodeCount(1), mBusyThreads(1)
+            {
+                mBinCount = (std::min)((std::max)(options.binCount, 2u), kMaxBins);
+                mThreadCount = options.threadCount ? options.threadCount : (std::max)(1u, std::thread::hardware_concurrency());
+                mSpatialSplits = options.splitMethod == CpuBvh::SplitMethod::SpatialSah && splitPrimitive;
+            }
+
+            // The first primitiveCount references are the input, the rest of the array is room for the
+            // references spatial splits add
+            void buildRoot(uint32_t primitiveCount, const RangeInfo &info)
+            {
+                mRootArea = info.bounds.surfaceArea();
+                buildNode(0, 0, primitiveCount, static_cast<uint32_t>(mRefs.size()), info, 0);
+            }
+
+            uint32_t getNodeCount() const { return mNodeCount; }
+
+        private:
+            RangeInfo computeRangeInfo(uint32_t begin, uint32_t end) const
+            {
+                RangeInfo info;
+                for (uint32_t i = begin; i < end; ++i) {
+                    info.grow(mRefs[i]);
+                }
+                return info;
+            }
+
+            uint32_t binIndex(const float3 &center, int axis, const CpuAabb &centerBounds, float scale) const
+            {
+                int bin = static_cast<int>((center[axis] - centerBounds.lower[axis]) * scale);
+                return static_cast<uint32_t>((std::min)((std::max)(bin, 0), static_cast<int>(mBinCount) - 1));
+            }
+
+            void binRange(uint32_t begin, uint32_t end, const CpuAabb &centerBounds, const float3 &scale, BinSet &binSet) const
+            {
+                for (uint32_t i = begin; i < end; ++i) {
+                    const PrimitiveRef &ref = mRefs[i];
+                    float3 center = ref.center();
+                    for (int axis = 0; axis < 3; ++axis) {
+                        Bin &bin = binSet.bins[axis][binIndex(center, axis, centerBounds, scale[axis])];
+                        bin.bounds.grow(ref.bounds);
+                        bin.count++;
+                    }
+                }
+            }
+
+            void makeLeaf(uint32_t nodeIndex, uint32_t begin, uint32_t end)
+            {
+                mNodes[nodeIndex].offset = begin;
+                mNodes[nodeIndex].count = end - begin;
+            }
+
+            // Object median along the largest axis. Always splits the range in half, which bounds the depth.
+            uint32_t medianSplit(uint32_t begin, uint32_t end, const RangeInfo &info)
+            {
+                float3 extent = info.centerBounds.extent();
+                int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+                uint32_t middle = begin + (end - begin) / 2;
+                std::nth_element(mRefs.begin() + begin, mRefs.begin() + middle, mRefs.begin() + end,
+                    [&](const PrimitiveRef &a, const PrimitiveRef &b) { return a.center()[axis] < b.center()[axis]; });
+                return middle;
+            }
+
+            // Returns false to make a leaf. Otherwise the children are [begin, middle) and [middle, rightEnd),
+            // where rightEnd is past end when a spatial split added references. Child range infos are filled
+            // in when the split comes from the bins; the caller computes them otherwise.
+            bool sahSplit(uint32_t begin, uint32_t end, uint32_t capacityEnd, const RangeInfo &info, RangeInfo &leftInfo, RangeInfo &rightInfo,
+                          uint32_t &middle, uint32_t &rightEnd)
+            {
+                uint32_t count = end - begin;
+                float3 extent = info.centerBounds.extent();
+                float3 scale;
+                for (int axis = 0; axis < 3; ++axis) {
+                    scale[axis] = extent[axis] > 0.0f ? mBinCount / extent[axis] : 0.0f;
+                }
+
+                BinSet binSet;
+                binSet.clear(mBinCount);
+                auto &bins = binSet.bins;
+                if (count >= kParallelBinningThreshold && mThreadCount > 1) {
+                    // The top of the tree is a serial bottleneck, so bin large ranges in parallel chunks
+                    uint32_t chunkCount = (std::min)(mThreadCount, count / (kParallelBinningThreshold / 4));
+                    std::vector<std::future<void>> tasks;
+                    std::vector<BinSet> chunkBins(chunkCount);
+                    for (auto &chunk : chunkBins) {
+                        chunk.clear(mBinCount);
+                    }
+                    for (uint32_t c = 0; c < chunkCount; ++c) {
+                        uint32_t chunkBegin = begin + uint32_t(uint64_t(count) * c / chunkCount);
+                        uint32_t chunkEnd = begin + uint32_t(uint64_t(count) * (c + 1) / chunkCount);
+                        tasks.push_back(std::async(std::launch::async, [&, c, chunkBegin, chunkEnd] {
+                            binRange(chunkBegin, chunkEnd, info.centerBounds, scale, chunkBins[c]);
+                        }));
+                    }
+                    for (uint32_t c = 0; c < chunkCount; ++c) {
+                        tasks[c].get();
+                        for (int axis = 0; axis < 3; ++axis) {
+                            for (uint32_t b = 0; b < mBinCount; ++b) {
+                                bins[axis][b].add(chunkBins[c].bins[axis][b]);
+                            }
+                        }
+                    }
+                } else {
+                    binRange(begin, end, info.centerBounds, scale, binSet);
+                }
+
+                // Sweep the bins from both sides. Costs are relative to the node's surface area.
+                float bestCost = 1e30f;
+                int bestAxis = -1;
+                uint32_t bestBin = 0;
+                CpuAabb bestLeftBounds, bestRightBounds;
+                for (int axis = 0; axis < 3; ++axis) {
+                    if (scale[axis] == 0.0f) {
+                        continue;
+                    }
+                    CpuAabb rightBounds[kMaxBins];
+                    uint32_t rightCount[kMaxBins];
+                    Bin right;
+                    right.clear();
+                    for (uint32_t b = mBinCount - 1; b > 0; --b) {
+                        right.add(bins[axis][b]);
+                        rightBounds[b] = right.bounds;
+                        rightCount[b] = right.count;
+                    }
+                    Bin left;
+                    left.clear();
+                    for (uint32_t b = 1; b < mBinCount; ++b) {
+                        left.add(bins[axis][b - 1]);
+                        if (left.count == 0 || rightCount[b] == 0) {
+                            continue;
+                        }
+                        float cost = left.bounds.surfaceArea() * left.count + rightBounds[b].surfaceArea() * rightCount[b];
+                        if (cost < bestCost) {
+                            bestCost = cost;
+                            bestAxis = axis;
+                            bestBin = b;
+                            bestLeftBounds = left.bounds;
+                            bestRightBounds = rightBounds[b];
+                        }
+                    }
+                }
+
+                rightEnd = end;
+                if (bestAxis < 0) {
+                    // All centers coincide, any split is as good as another
+                    middle = begin + count / 2;
+                    return count > mOptions.maxLeafSize;
+                }
+
+                // Object splits whose children overlap a lot leave room for a spatial split, as long as
+                // this subtree has budget left
+                SpatialSplit spatial;
+                if (mSpatialSplits && capacityEnd > end && mRootArea > 0.0f &&
+                    CpuAabb::overlap(bestLeftBounds, bestRightBounds).surfaceArea() > mOptions.spatialSplitOverlap * mRootArea) {
+                    spatial = findSpatialSplit(begin, end, info.bounds);
+                }
+
+                float nodeArea = info.bounds.surfaceArea();
+                float leafCost = static_cast<float>(count);
+                float splitCost = mOptions.traversalCost + (nodeArea > 0.0f ? (std::min)(bestCost, spatial.cost) / nodeArea : leafCost);
+                if (count <= mOptions.maxLeafSize && leafCost <= splitCost) {
+                    return false;
+                }
+                if (spatial.cost < bestCost) {
+                    spatialPartition(begin, end, capacityEnd, spatial, middle, rightEnd);
+                    if (middle > begin && middle < rightEnd) {
+                        leftInfo = computeRangeInfo(begin, middle);
+                        rightInfo = computeRangeInfo(middle, rightEnd);
+                        return true;
+                    }
+                    // Unsplitting emptied a side, so nothing was split and the object split still applies
+                    rightEnd = end;
+                }
+
+                // In-place partition that also computes the bounds of both children
+                float axisScale = scale[bestAxis];
+                auto isLeft = [&](const PrimitiveRef &ref) { return binIndex(ref.center(), bestAxis, info.centerBounds, axisScale) < bestBin; };
+                uint32_t left = begin, right = end;
+                for (;;) {
+                    while (left < right && isLeft(mRefs[left])) {
+                        leftInfo.grow(mRefs[left++]);
+                    }
+                    while (left < right && !isLeft(mRefs[right - 1])) {
+                        rightInfo.grow(mRefs[--right]);
+                    }
+                    if (left >= right) {
+                        break;
+                    }
+                    std::swap(mRefs[left], mRefs[right - 1]);
+                }
+                middle = left;
+                return true;
+            }
+
+            // Bins the references by the parts of their primitives inside equal slabs of the node bounds:
+            // a reference counts as entering its first and exiting its last slab, and its clipped bounds
+            // grow every slab it overlaps
+            SpatialSplit findSpatialSplit(uint32_t begin, uint32_t end, const CpuAabb &bounds) const
+            {
+                SpatialSplit best;
+                float3 extent = bounds.extent();
+                for (int axis = 0; axis < 3; ++axis) {
+                    if (extent[axis] <= 0.0f) {
+                        continue;
+                    }
+                    float binWidth = extent[axis] / mBinCount;
+                    float scale = mBinCount / extent[axis];
+                    SpatialBin bins[kMaxBins];
+                    for (uint32_t b = 0; b < mBinCount; ++b) {
+                        bins[b].clear();
+                    }
+
+                    for (uint32_t i = begin; i < end; ++i) {
+                        const PrimitiveRef &ref = mRefs[i];
+                        uint32_t firstBin = spatialBinIndex(ref.bounds.lower[axis], bounds.lower[axis], scale);
+                        uint32_t lastBin = spatialBinIndex(ref.bounds.upper[axis], bounds.lower[axis], scale);
+                        bins[firstBin].enter++;
+                        bins[lastBin].exit++;
+                        CpuAabb remaining = ref.bounds;
+                        for (uint32_t b = firstBin; b < lastBin; ++b) {
+                            CpuAabb left, right;
+                            mSplitPrimitive(ref.index, axis, bounds.lower[axis] + binWidth * (b + 1), remaining, left, right);
+                            bins[b].bounds.grow(left);
+                            remaining = right;
+                        }
+                        bins[lastBin].bounds.grow(remaining);
+                    }
+
+                    CpuAabb rightBounds[kMaxBins];
+                    uint32_t rightCount[kMaxBins];
+                    CpuAabb right = CpuAabb::empty();
+                    uint32_t exits = 0;
+                    for (uint32_t b = mBinCount - 1; b > 0; --b) {
+                        right.grow(bins[b].bounds);
+                        exits += bins[b].exit;
+                        rightBounds[b] = right;
+                        rightCount[b] = exits;
+                    }
+                    CpuAabb left = CpuAabb::empty();
+                    uint32_t enters = 0;
+                    for (uint32_t b = 1; b < mBinCount; ++b) {
+                        left.grow(bins[b - 1].bounds);
+                        enters += bins[b - 1].enter;
+                        if (enters == 0 || rightCount[b] == 0) {
+                            continue;
+                        }
+                        float cost = left.surfaceArea() * enters + rightBounds[b].surfaceArea() * rightCount[b];
+                        if (cost < best.cost) {
+                            best.cost = cost;
+                            best.axis = axis;
+                            best.position = bounds.lower[axis] + binWidth * b;
+                            best.leftBounds = left;
+                            best.rightBounds = rightBounds[b];
+                            best.leftCount = enters;
+                            best.rightCount = rightCount[b];
+                        }
+                    }
+                }
+                return best;
+            }
+
+            uint32_t spatialBinIndex(float coordinate, float lower, float scale) const
+            {
+                int bin = static_cast<int>((coordinate - lower) * scale);
+                return static_cast<uint32_t>((std::min)((std::max)(bin, 0), static_cast<int>(mBinCount) - 1));
+            }
+
+            // Moves the references left of the plane to the front and those right of it to the back. A
+            // reference straddling the plane is split in two, with the right half appended past end, unless
+            // moving it whole to one side is cheaper ("unsplitting") or the subtree has no room left.
+            void spatialPartition(uint32_t begin, uint32_t end, uint32_t capacityEnd, const SpatialSplit &split, uint32_t &middle, uint32_t &rightEnd)
+            {
+                int axis = split.axis;
+                float position = split.position;
+                auto first = mRefs.begin();
+                auto leftEnd = std::partition(first + begin, first + end, [&](const PrimitiveRef &ref) { return ref.bounds.upper[axis] <= position; });
+                auto straddleEnd = std::partition(leftEnd, first + end, [&](const PrimitiveRef &ref) { return ref.bounds.lower[axis] < position; });
+
+                float leftArea = split.leftBounds.surfaceArea(), rightArea = split.rightBounds.surfaceArea();
+                float leftCount = static_cast<float>(split.leftCount), rightCount = static_cast<float>(split.rightCount);
+                float splitCost = leftArea * leftCount + rightArea * rightCount;
+
+                rightEnd = end;
+                uint32_t straddleBegin = static_cast<uint32_t>(leftEnd - first);
+                uint32_t straddleCount = static_cast<uint32_t>(straddleEnd - leftEnd);
+                uint32_t keepLeft = straddleBegin;
+                for (uint32_t i = straddleBegin; i < straddleBegin + straddleCount; ++i) {
+                    PrimitiveRef ref = mRefs[i];
+                    CpuAabb left, right;
+                    mSplitPrimitive(ref.index, axis, position, ref.bounds, left, right);
+
+                    CpuAabb wholeLeft = split.leftBounds, wholeRight = split.rightBounds;
+                    wholeLeft.grow(ref.bounds);
+                    wholeRight.grow(ref.bounds);
+                    float leftOnlyCost = wholeLeft.surfaceArea() * leftCount + rightArea * (rightCount - 1.0f);
+                    float rightOnlyCost = leftArea * (leftCount - 1.0f) + wholeRight.surfaceArea() * rightCount;
+
+                    bool toLeft = right.isEmpty(), toRight = left.isEmpty();
+                    if (!toLeft && !toRight && (rightEnd == capacityEnd || (std::min)(leftOnlyCost, rightOnlyCost) < splitCost)) {
+                        toLeft = leftOnlyCost <= rightOnlyCost;
+                        toRight = !toLeft;
+                    }
+                    if (toRight) {
+                        continue;
+                    }
+                    if (!toLeft) {
+                        mRefs[rightEnd++] = { right, ref.index };
+                        ref.bounds = left;
+                    }
+                    // Keeps the references that stay on the left in front of the straddling range
+                    mRefs[i] = mRefs[keepLeft];
+                    mRefs[keepLeft++] = ref;
+                }
+                middle = keepLeft;
+            }
+
+            // References [begin, end) belong to the node, [end, capacityEnd) is the room its subtree has for
+            // references added by spatial splits
+            void buildNode(uint32_t nodeIndex, uint32_t begin, uint32_t end, uint32_t capacityEnd, const RangeInfo &info, uint32_t depth)
+            {
+                mNodes[nodeIndex].bounds = info.bounds;
+                uint32_t count = end - begin;
+                if (count == 1) {
+                    makeLeaf(nodeIndex, begin, end);
+                    return;
+                }
+
+                RangeInfo leftInfo, rightInfo;
+                uint32_t middle = end, rightEnd = end;
+                bool split;
+                if (mOptions.splitMethod == CpuBvh::SplitMethod::Median || depth >= kMedianSplitDepth) {
+                    split = count > mOptions.maxLeafSize;
+                    if (split) {
+                        middle = medianSplit(begin, end, info);
+                    }
+                } else {
+                    split = sahSplit(begin, end, capacityEnd, info, leftInfo, rightInfo, middle, rightEnd);
+                }
+                if (!split) {
+                    makeLeaf(nodeIndex, begin, end);
+                    return;
+                }
+                if (leftInfo.bounds.isEmpty()) {
+                    leftInfo = computeRangeInfo(begin, middle);
+                    rightInfo = computeRangeInfo(middle, rightEnd);
+                }
+
+                // The remaining room is shared in proportion to the reference counts, which moves the right
+                // child's references up
+                uint32_t room = capacityEnd - rightEnd;
+                uint32_t leftRoom = static_cast<uint32_t>(uint64_t(room) * (middle - begin) / (rightEnd - begin));
+                if (leftRoom > 0) {
+                    std::move_backward(mRefs.begin() + middle, mRefs.begin() + rightEnd, mRefs.begin() + rightEnd + leftRoom);
+                }
+                uint32_t rightBegin = middle + leftRoom;
+                rightEnd += leftRoom;
+
+                // Children are allocated next to each other. The node array is sized for the worst case,
+                // so concurrent subtree builds never reallocate it.
+                uint32_t leftChild = mNodeCount.fetch_add(2);
+                mNodes[nodeIndex].offset = leftChild;
+                mNodes[nodeIndex].count = 0;
+
+                // Hand the left subtree to another thread while there are idle threads
+                if ((std::min)(middle - begin, rightEnd - rightBegin) >= mOptions.parallelThreshold && tryAcquireThread()) {
+                    auto leftTask = std::async(std::launch::async, [&] {
+                        buildNode(leftChild, begin, middle, rightBegin, leftInfo, depth + 1);
+                    });
+                    buildNode(leftChild + 1, rightBegin, rightEnd, capacityEnd, rightInfo, depth + 1);
+                    leftTask.get();
+                    mBusyThreads--;
+                } else {
+                    buildNode(leftChild, begin, middle, rightBegin, leftInfo, depth + 1);
+                    buildNode(leftChild + 1, rightBegin, rightEnd, capacityEnd, rightInfo, depth + 1);
+                }
+            }
+
+            bool tryAcquireThread()
+            {
+                uint32_t busy = mBusyThreads.load();
+                while (busy < mThreadCount) {
+                    if (mBusyThreads.compare_exchange_weak(busy, busy + 1)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            std::vector<PrimitiveRef> &mRefs;
+            std::vector<CpuBvh::Node> &mNodes;
+            const CpuBvh::BuildOptions &mOptions;
+            const CpuBvh::SplitPrimitive &mSplitPrimitive;
+            bool mSpatialSplits;
+            float mRootArea;
+            uint32_t mBinCount;
+            uint32_t mThreadCount;
+            std::atomic<uint32_t> mNodeCount;
+            std::atomic<uint32_t> mBusyThreads; // including the thread that started the build
+        };
+
+        // Copies the subtree in depth first order, so that traversal walks forward through memory
+        void flattenDepthFirst(const std::vector<CpuBvh::Node> &source, uint32_t sourceIndex, std::vector<CpuBvh::Node> &destination, uint32_t destinationIndex)
+        {
+            const CpuBvh::Node &node = source[sourceIndex];
+            destination[destinationIndex] = node;
+            if (!node.isLeaf()) {
+                uint32_t leftChild = static_cast<uint32_t>(destination.size());
+                destination[destinationIndex].offset = leftChild;
+                destination.resize(destination.size() + 2);
+                flattenDepthFirst(source, node.offset, destination, leftChild);
+                flattenDepthFirst(source, node.offset + 1, destination, leftChild + 1);
+            }
+        }
+    }
+
+    void CpuBvh::build(const std::vector<CpuAabb> &primitiveBounds, const BuildOptions &options, const SplitPrimitive &splitPrimitive)
+    {
+        mNodes.clear();
+        mPrimitiveIndices.clear();
+        if (primitiveBounds.empty()) {
+            return;
+        }
+
+        std::vector<PrimitiveRef> refs(primitiveBounds.size());
+        RangeInfo info;
+        for (size_t i = 0; i < primitiveBounds.size(); ++i) {
+            refs[i].bounds = primitiveBounds[i];
+            refs[i].index = static_cast<uint32_t>(i);
+            info.bounds.grow(primitiveBounds[i]);
+            info.centerBounds.grow(refs[i].center());
+        }
+
+        // Spatially coherent input keeps the partitions of the top levels close together in memory and
+        // puts nearby primitives next to each other in the leaves
+        if (refs.size() >= options.mortonPresortThreshold) {
+            float3 scale = float3(1.0f) / (max)(info.centerBounds.extent(), 1e-30f);
+            std::vector<std::pair<uint32_t, uint32_t>> codes(refs.size());
+            for (size_t i = 0; i < refs.size(); ++i) {
+                codes[i] = std::make_pair(mortonCode((refs[i].center() - info.centerBounds.lower) * scale), static_cast<uint32_t>(i));
+            }
+            std::sort(codes.begin(), codes.end());
+            std::vector<PrimitiveRef> sorted(refs.size());
+            for (size_t i = 0; i < refs.size(); ++i) {
+                sorted[i] = refs[codes[i].second];
+            }
+            refs.swap(sorted);
+        }
+
+        // Spatial splits add references up to the budget
+        uint32_t primitiveCount = static_cast<uint32_t>(refs.size());
+        if (options.splitMethod == SplitMethod::SpatialSah && splitPrimitive) {
+            refs.resize(primitiveCount + static_cast<size_t>(primitiveCount * (std::max)(options.spatialSplitBudget, 0.0f)));
+        }
+
+        // A binary tree with at least one reference per leaf has at most 2n - 1 nodes
+        std::vector<Node> nodes(2 * refs.size() - 1);
+        Builder builder(refs, nodes, options, splitPrimitive);
+        builder.buildRoot(primitiveCount, info);
+        nodes.resize(builder.getNodeCount());
+
+        // Parallel subtrees interleave their allocations
+        mNodes.reserve(nodes.size());
+        mNodes.resize(1);
+        flattenDepthFirst(nodes, 0, mNodes, 0);
+
+        // Leaves may be separated by unused room, they are packed in depth first order
+        mPrimitiveIndices.reserve(refs.size());
+        for (Node &node : mNodes) {
+            if (node.isLeaf()) {
+                uint32_t offset = static_cast<uint32_t>(mPrimitiveIndices.size());
+                for (uint32_t i = 0; i < node.count; ++i) {
+                    mPrimitiveIndices.push_back(refs[node.offset + i].index);
+                }
+                node.offset = offset;
+            }
+        }
+        mPrimitiveIndices.shrink_to_fit();
+    }
+
+    float CpuBvh::getSahCost(float traversalCost) const
+    {
+        if (mNodes.empty()) {
+            return 0.0f;
+        }
+
+        float cost = 0.0f;
+        for (const Node &node : mNodes) {
+            float area = node.bounds.surfaceArea();
+            cost += node.isLeaf() ? area * node.count : area * traversalCost;
+        }
+        float rootArea = mNodes[0].bounds.surfaceArea();
+        return rootArea > 0.0f ? cost / rootArea : cost;
+    }
+
+    float CpuBvh::getOverlap() const
+    {
+        if (mNodes.empty()) {
+            return 0.0f;
+        }
+
+        float overlap = 0.0f;
+        for (const Node &node : mNodes) {
+            if (!node.isLeaf()) {
+                overlap += CpuAabb::overlap(mNodes[node.offset].bounds, mNodes[node.offset + 1].bounds).surfaceArea();
+            }
+        }
+        float rootArea = mNodes[0].bounds.surfaceArea();
+        return rootArea > 0.0f ? overlap / rootArea : overlap;
+    }
+
+    uint32_t CpuBvh::getMaxDepth() const
+    {
+        if (mNodes.empty()) {
+            return 0;
+        }
+
+        uint32_t maxDepth = 0;
+        std::vector<std::pair<uint32_t, uint32_t>> stack = { { 0, 1 } };
+        while (!stack.empty()) {
+            auto entry = stack.back();
+            stack.pop_back();
+            const Node &node = mNodes[entry.first];
+            maxDepth = (std::max)(maxDepth, entry.second);
+            if (!node.isLeaf()) {
+                stack.push_back({ node.offset, entry.second + 1 });
+                stack.push_back({ node.offset + 1, entry.second + 1 });
+            }
+        }
+        return maxDepth;
+    }
+}
@@ -0,0 +1,533 @@
+#pragma once
+
+#include "CpuMath.h"
+#include <functional>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define CPU_BVH_SSE 1
+#include <emmintrin.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#endif
+
+namespace DXRFramework
+{
+    // Mirrors HLSL RayDesc
+    struct CpuRay
+    {
+        CpuMath::float3 origin;
+        float tMin;
+        CpuMath::float3 direction;
+        float tMax;
+    };
+
+    // The box tests scale the far slab distances by 1 + 2 gamma(3), so that rounding in the slab
+    // distances never culls a box the ray touches (Ize, "Robust BVH Ray Traversal", JCGT 2013).
+    // Without it rays through shared vertices can slip past the boxes of all adjacent triangles.
+    const float kCpuSlabFarScale = 1.0000004f;
+
+    struct CpuAabb
+    {
+        CpuMath::float3 lower;
+        CpuMath::float3 upper;
+
+        static CpuAabb empty() { return { CpuMath::float3(1e30f), CpuMath::float3(-1e30f) }; }
+
+        void grow(const CpuMath::float3 &p) { lower = (CpuMath::min)(lower, p); upper = (CpuMath::max)(upper, p); }
+        void grow(const CpuAabb &b) { lower = (CpuMath::min)(lower, b.lower); upper = (CpuMath::max)(upper, b.upper); }
+
+        CpuMath::float3 center() const { return (lower + upper) * 0.5f; }
+        CpuMath::float3 extent() const { return upper - lower; }
+        bool isEmpty() const { return lower.x > upper.x || lower.y > upper.y || lower.z > upper.z; }
+
+        // Empty if the boxes don't touch
+        static CpuAabb overlap(const CpuAabb &a, const CpuAabb &b)
+        {
+            CpuAabb result = { (CpuMath::max)(a.lower, b.lower), (CpuMath::min)(a.upper, b.upper) };
+            return result.isEmpty() ? empty() : result;
+        }
+
+        float surfaceArea() const
+        {
+            if (isEmpty()) {
+                return 0.0f;
+            }
+            CpuMath::float3 e = extent();
+            return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+        }
+    };
+
+    // Ray data precomputed once per traversal
+    struct CpuRayTraversal
+    {
+        CpuMath::float3 origin;
+        CpuMath::float3 invDirection;
+
+        explicit CpuRayTraversal(const CpuRay &ray)
+            : origin(ray.origin), invDirection(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z) {}
+        CpuRayTraversal(const CpuMath::float3 &origin, const CpuMath::float3 &invDirection) : origin(origin), invDirection(invDirection) {}
+
+        // Slab test against the [tMin, tMax] interval, also returns the entry distance
+        bool intersect(const CpuAabb &box, float tMin, float tMax, float &tEntry) const
+        {
+            float t0x = (box.lower.x - origin.x) * invDirection.x, t1x = (box.upper.x - origin.x) * invDirection.x;
+            float t0y = (box.lower.y - origin.y) * invDirection.y, t1y = (box.upper.y - origin.y) * invDirection.y;
+            float t0z = (box.lower.z - origin.z) * invDirection.z, t1z = (box.upper.z - origin.z) * invDirection.z;
+            float tNear = (std::max)((std::max)((std::min)(t0x, t1x), (std::min)(t0y, t1y)), (std::max)((std::min)(t0z, t1z), tMin));
+            float tFar = (std::min)((std::min)((std::min)((std::max)(t0x, t1x), (std::max)(t0y, t1y)), (std::max)(t0z, t1z)) * kCpuSlabFarScale, tMax);
+            tEntry = tNear;
+            return tNear <= tFar;
+        }
+    };
+
+    // Rays traced together through the hierarchies, stored as structure of arrays so that one SIMD
+    // instruction processes four lanes. Lanes outside activeMask are ignored and may hold anything.
+    template <uint32_t Size>
+    struct CpuRayPacket
+    {
+        static_assert(Size == 4 || Size == 8 || Size == 16, "4, 8 or 16 rays per packet");
+
+        // Once fewer lanes than this are active in a subtree, traversal continues one ray at a time.
+        // Higher thresholds only pay off with wide nodes, whose single ray traversal is fast.
+        static const uint32_t kDefaultMinActiveLanes = 2;
+
+        float origin[3][Size];
+        float direction[3][Size];
+        float tMin[Size];
+        float tMax[Size];
+        uint32_t activeMask;
+
+        void setRay(uint32_t lane, const CpuRay &ray)
+        {
+            for (int axis = 0; axis < 3; ++axis) {
+                origin[axis][lane] = ray.origin[axis];
+                direction[axis][lane] = ray.direction[axis];
+            }
+            tMin[lane] = ray.tMin;
+            tMax[lane] = ray.tMax;
+        }
+
+        CpuRay getRay(uint32_t lane) const
+        {
+            CpuRay ray;
+            ray.origin = CpuMath::float3(origin[0][lane], origin[1][lane], origin[2][lane]);
+            ray.direction = CpuMath::float3(direction[0][lane], direction[1][lane], direction[2][lane]);
+            ray.tMin = tMin[lane];
+            ray.tMax = tMax[lane];
+            return ray;
+        }
+    };
+
+    // Packet data precomputed once per traversal. When the active rays agree on the direction sign of
+    // every axis, the interval bounds of their origins and reciprocal directions give a conservative
+    // slab test for the whole packet, which rejects boxes that all rays miss without testing each ray.
+    template <uint32_t Size>
+    struct CpuPacketTraversal
+    {
+        float origin[3][Size];
+        float invDirection[3][Size];
+        float tMin[Size];
+
+        bool hasFrustum;
+        bool negative[3];
+        CpuMath::float3 originLower, originUpper;
+        CpuMath::float3 invLower, invUpper;
+        float tMinLower, tMaxUpper;
+
+        explicit CpuPacketTraversal(const CpuRayPacket<Size> &packet);
+
+        CpuRayTraversal getLane(uint32_t lane) const
+        {
+            return CpuRayTraversal(CpuMath::float3(origin[0][lane], origin[1][lane], origin[2][lane]),
+                                   CpuMath::float3(invDirection[0][lane], invDirection[1][lane], invDirection[2][lane]));
+        }
+
+        // False if no ray of the packet can hit the box
+        bool intersectFrustum(const CpuAabb &box) const;
+
+        // Slab test of the rays in mask against their [tMin, tMax] intervals. Returns the rays that hit
+        // and the smallest entry distance among them.
+        uint32_t intersect(const CpuAabb &box, const float (&tMax)[Size], uint32_t mask, float &tEntry) const;
+
+        // Cheaper test for inner nodes of coherent packets: stops at the first group of four rays with
+        // a hit and conservatively returns every ray of mask from the first hit on. Rays that actually
+        // miss are removed by the exact test before leaves.
+        uint32_t intersectFirst(const CpuAabb &box, const float (&tMax)[Size], uint32_t mask, float &tEntry) const;
+
+    private:
+        uint32_t intersectGroup(const CpuAabb &box, const float (&tMax)[Size], uint32_t group, float *tNear) const;
+    };
+
+    enum class CpuBvhSplitMethod
+    {
+        Median,    // object median along the largest axis, cheap to build but slow to trace
+        BinnedSah, // surface area heuristic evaluated on a fixed number of bins per axis
+        SpatialSah // binned SAH that may also split primitives straddling a plane (SBVH, Stich et al. 2009),
+                   // which references them from both children. Needs a SplitPrimitive, BinnedSah without one.
+    };
+
+    struct CpuBvhBuildOptions
+    {
+        CpuBvhSplitMethod splitMethod = CpuBvhSplitMethod::BinnedSah;
+        uint32_t maxLeafSize = 4;
+        uint32_t binCount = 16;
+        float traversalCost = 1.0f; // relative to one primitive intersection
+        uint32_t threadCount = 0; // 0 uses all hardware threads
+        uint32_t parallelThreshold = 4096; // smaller subtrees are built by the thread that split them
+        uint32_t mortonPresortThreshold = 65536; // larger inputs are sorted along a Morton curve first
+        float spatialSplitBudget = 0.3f; // extra references spatial splits may add, relative to the primitive count
+        float spatialSplitOverlap = 1e-5f; // spatial splits are tried where the best object split's children
+                                           // overlap by more than this fraction of the root surface area
+    };
+
+    // Binary bounding volume hierarchy over an abstract set of primitives, used both for the triangles
+    // of a model (bottom level) and for the instances of a scene (top level). Nodes are stored depth
+    // first in one flat array with the two children of a node next to each other.
+    class CpuBvh
+    {
+    public:
+        struct Node
+        {
+            CpuAabb bounds;
+            uint32_t offset; // first primitive for leaves, first of the two adjacent children otherwise
+            uint32_t count;  // primitive count, zero for inner nodes
+
+            bool isLeaf() const { return count > 0; }
+        };
+        static_assert(sizeof(Node) == 32, "two nodes per cache line");
+
+        using SplitMethod = CpuBvhSplitMethod;
+        using BuildOptions = CpuBvhBuildOptions;
+
+        // splitPrimitive(primitiveIndex, axis, position, bounds, left, right) returns the bounds of the parts
+        // of a primitive on either side of an axis aligned plane, clipped to the bounds of the reference
+        using SplitPrimitive = std::function<void(uint32_t, int, float, const CpuAabb &, CpuAabb &, CpuAabb &)>;
+
+        // With spatial splits a primitive may appear in several leaves of the primitive index list
+        void build(const std::vector<CpuAabb> &primitiveBounds, const BuildOptions &options = BuildOptions(),
+                   const SplitPrimitive &splitPrimitive = nullptr);
+
+        const std::vector<Node> &getNodes() const { return mNodes; }
+        const std::vector<uint32_t> &getPrimitiveIndices() const { return mPrimitiveIndices; }
+        const CpuAabb &getBounds() const { return mNodes[0].bounds; }
+        bool isEmpty() const { return mNodes.empty(); }
+
+        // Expected cost of a random ray hitting the root, in units of primitive intersections
+        float getSahCost(float traversalCost = 1.0f) const;
+        uint32_t getMaxDepth() const;
+        // Surface area shared by the two children of each inner node, summed and relative to the root.
+        // Rays entering the overlap have to visit both subtrees.
+        float getOverlap() const;
+
+        // Visits leaf primitives front to back. intersectPrimitive(primitiveIndex, tMax) may shorten tMax
+        // and returns true to end the traversal. Starting at another node than the root traverses only
+        // its subtree.
+        template <typename IntersectPrimitive>
+        void traverse(const CpuRay &ray, float &tMax, IntersectPrimitive &&intersectPrimitive, uint32_t rootIndex = 0) const;
+
+        // Traverses the active rays of a packet together, visiting nodes in the order of the nearest
+        // ray. intersectPrimitive(primitiveIndex, laneMask, tMax) tests the primitive against the rays
+        // in laneMask, may shorten their tMax and returns the lanes that end their traversal. Subtrees
+        // entered by fewer than minActiveLanes rays are finished one ray at a time.
+        template <uint32_t Size, typename IntersectPrimitive>
+        void traversePacket(const CpuRayPacket<Size> &packet, float (&tMax)[Size], IntersectPrimitive &&intersectPrimitive,
+                            uint32_t minActiveLanes = CpuRayPacket<Size>::kDefaultMinActiveLanes, uint32_t rootIndex = 0) const;
+
+        // Depth of the traversal stack; builds fall back to median splits before reaching it
+        static const uint32_t kMaxDepth = 64;
+
+    private:
+        // Single ray traversal below a node the ray is known to hit, returns true if it was ended early
+        template <typename IntersectPrimitive>
+        bool traverseSubtree(uint32_t nodeIndex, const CpuRayTraversal &traversal, float tMin, float &tMax, IntersectPrimitive &&intersectPrimitive) const;
+
+        std::vector<Node> mNodes;
+        std::vector<uint32_t> mPrimitiveIndices;
+    };
+
+    template <uint32_t Size>
+    CpuPacketTraversal<Size>::CpuPacketTraversal(const CpuRayPacket<Size> &packet)
+    {
+        using namespace CpuMath;
+
+        for (uint32_t lane = 0; lane < Size; ++lane) {
+            for (int axis = 0; axis < 3; ++axis) {
+                origin[axis][lane] = packet.origin[axis][lane];
+                invDirection[axis][lane] = 1.0f / packet.direction[axis][lane];
+            }
+            tMin[lane] = packet.tMin[lane];
+        }
+
+        hasFrustum = packet.activeMask != 0;
+        originLower = invLower = float3(1e30f);
+        originUpper = invUpper = float3(-1e30f);
+        tMinLower = 1e30f;
+        tMaxUpper = -1e30f;
+        uint32_t positiveAxes = 0, negativeAxes = 0;
+        for (uint32_t bits = packet.activeMask; bits; bits &= bits - 1) {
+            uint32_t lane = firstbitlow(bits);
+            for (int axis = 0; axis < 3; ++axis) {
+                float inv = invDirection[axis][lane];
+                if (!(std::fabs(inv) < 1e30f)) {
+                    hasFrustum = false;
+                }
+                (inv < 0.0f ? negativeAxes : positiveAxes) |= 1u << axis;
+                originLower[axis] = (std::min)(originLower[axis], origin[axis][lane]);
+                originUpper[axis] = (std::max)(originUpper[axis], origin[axis][lane]);
+                invLower[axis] = (std::min)(invLower[axis], inv);
+                invUpper[axis] = (std::max)(invUpper[axis], inv);
+            }
+            tMinLower = (std::min)(tMinLower, packet.tMin[lane]);
+            tMaxUpper = (std::max)(tMaxUpper, packet.tMax[lane]);
+        }
+        if (positiveAxes & negativeAxes) {
+            hasFrustum = false;
+        }
+        for (int axis = 0; axis < 3; ++axis) {
+            negative[axis] = (negativeAxes >> axis) & 1;
+        }
+    }
+
+    template <uint32_t Size>
+    inline bool CpuPacketTraversal<Size>::intersectFrustum(const CpuAabb &box) const
+    {
+        if (!hasFrustum) {
+            return true;
+        }
+
+        // Bounds of (plane - origin) * invDirection over the intervals, the near and far planes
+        // depend on the shared direction sign
+        float nearLower = tMinLower, farUpper = tMaxUpper;
+        for (int axis = 0; axis < 3; ++axis) {
+            float nearPlane = negative[axis] ? box.upper[axis] : box.lower[axis];
+            float farPlane = negative[axis] ? box.lower[axis] : box.upper[axis];
+            float n0 = nearPlane - originUpper[axis], n1 = nearPlane - originLower[axis];
+            float f0 = farPlane - originUpper[axis], f1 = farPlane - originLower[axis];
+            nearLower = (std::max)(nearLower, (std::min)((std::min)(n0 * invLower[axis], n0 * invUpper[axis]), (std::min)(n1 * invLower[axis], n1 * invUpper[axis])));
+            farUpper = (std::min)(farUpper, (std::max)((std::max)(f0 * invLower[axis], f0 * invUpper[axis]), (std::max)(f1 * invLower[axis], f1 * invUpper[axis])) * kCpuSlabFarScale);
+        }
+        return nearLower <= farUpper;
+    }
+
+    // Tests lanes [group, group + 4), returns their hits in the low four bits
+    template <uint32_t Size>
+    inline uint32_t CpuPacketTraversal<Size>::intersectGroup(const CpuAabb &box, const float (&tMax)[Size], uint32_t group, float *tNear) const
+    {
+#ifdef CPU_BVH_SSE
+        __m128 groupNear = _mm_loadu_ps(tMin + group);
+        __m128 groupFar = _mm_loadu_ps(tMax + group);
+        for (int axis = 0; axis < 3; ++axis) {
+            __m128 o = _mm_loadu_ps(origin[axis] + group);
+            __m128 inv = _mm_loadu_ps(invDirection[axis] + group);
+            __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.lower[axis]), o), inv);
+            __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.upper[axis]), o), inv);
+            groupNear = _mm_max_ps(groupNear, _mm_min_ps(t0, t1));
+            groupFar = _mm_min_ps(groupFar, _mm_mul_ps(_mm_max_ps(t0, t1), _mm_set1_ps(kCpuSlabFarScale)));
+        }
+        _mm_storeu_ps(tNear + group, groupNear);
+        return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(groupNear, groupFar)));
+#else
+        uint32_t hits = 0;
+        for (uint32_t lane = group; lane < group + 4; ++lane) {
+            float laneNear = tMin[lane], laneFar = tMax[lane];
+            for (int axis = 0; axis < 3; ++axis) {
+                float t0 = (box.lower[axis] - origin[axis][lane]) * invDirection[axis][lane];
+                float t1 = (box.upper[axis] - origin[axis][lane]) * invDirection[axis][lane];
+                laneNear = (std::max)(laneNear, (std::min)(t0, t1));
+                laneFar = (std::min)(laneFar, (std::max)(t0, t1) * kCpuSlabFarScale);
+            }
+            tNear[lane] = laneNear;
+            hits |= (laneNear <= laneFar ? 1u : 0u) << (lane - group);
+        }
+        return hits;
+#endif
+    }
+
+    template <uint32_t Size>
+    inline uint32_t CpuPacketTraversal<Size>::intersect(const CpuAabb &box, const float (&tMax)[Size], uint32_t mask, float &tEntry) const
+    {
+        tEntry = 1e30f;
+
+        // The frustum test only pays off when it can save testing several groups
+        uint32_t groups = 0;
+        for (uint32_t group = 0; group < Size; group += 4) {
+            groups += ((mask >> group) & 0xf) ? 1 : 0;
+        }
+        if (groups > 1 && !intersectFrustum(box)) {
+            return 0;
+        }
+
+        float tNear[Size];
+        uint32_t hits = 0;
+        for (uint32_t group = 0; group < Size; group += 4) {
+            if ((mask >> group) & 0xf) {
+                hits |= intersectGroup(box, tMax, group, tNear) << group;
+            }
+        }
+        hits &= mask;
+        for (uint32_t bits = hits; bits; bits &= bits - 1) {
+            tEntry = (std::min)(tEntry, tNear[CpuMath::firstbitlow(bits)]);
+        }
+        return hits;
+    }
+
+    template <uint32_t Size>
+    inline uint32_t CpuPacketTraversal<Size>::intersectFirst(const CpuAabb &box, const float (&tMax)[Size], uint32_t mask, float &tEntry) const
+    {
+        tEntry = 1e30f;
+
+        float tNear[Size];
+        uint32_t testedGroups = 0;
+        for (uint32_t group = 0; group < Size; group += 4) {
+            if (!((mask >> group) & 0xf)) {
+                continue;
+            }
+            // Once the first group misses, the frustum decides whether the others need testing
+            if (testedGroups++ == 1 && !intersectFrustum(box)) {
+                return 0;
+            }
+
+            uint32_t hits = (intersectGroup(box, tMax, group, tNear) << group) & mask;
+            if (hits) {
+                for (uint32_t bits = hits; bits; bits &= bits - 1) {
+                    tEntry = (std::min)(tEntry, tNear[CpuMath::firstbitlow(bits)]);
+                }
+                return mask & ~((1u << CpuMath::firstbitlow(hits)) - 1);
+            }
+        }
+        return 0;
+    }
+
+    template <typename IntersectPrimitive>
+    void CpuBvh::traverse(const CpuRay &ray, float &tMax, IntersectPrimitive &&intersectPrimitive, uint32_t rootIndex) const
+    {
+        if (mNodes.empty()) {
+            return;
+        }
+
+        CpuRayTraversal traversal(ray);
+        float tEntry;
+        if (traversal.intersect(mNodes[rootIndex].bounds, ray.tMin, tMax, tEntry)) {
+            traverseSubtree(rootIndex, traversal, ray.tMin, tMax, intersectPrimitive);
+        }
+    }
+
+    template <typename IntersectPrimitive>
+    bool CpuBvh::traverseSubtree(uint32_t nodeIndex, const CpuRayTraversal &traversal, float tMin, float &tMax, IntersectPrimitive &&intersectPrimitive) const
+    {
+        uint32_t stack[kMaxDepth];
+        uint32_t stackSize = 0;
+        float tEntry;
+
+        for (;;) {
+            const Node &node = mNodes[nodeIndex];
+            if (node.isLeaf()) {
+                for (uint32_t i = 0; i < node.count; ++i) {
+                    if (intersectPrimitive(mPrimitiveIndices[node.offset + i], tMax)) {
+                        return true;
+                    }
+                }
+            } else {
+                float tLeft, tRight;
+                bool hitLeft = traversal.intersect(mNodes[node.offset].bounds, tMin, tMax, tLeft);
+                bool hitRight = traversal.intersect(mNodes[node.offset + 1].bounds, tMin, tMax, tRight);
+                if (hitLeft && hitRight) {
+                    // Descend into the nearer child first
+                    bool leftFirst = tLeft <= tRight;
+                    stack[stackSize++] = node.offset + (leftFirst ? 1 : 0);
+                    nodeIndex = node.offset + (leftFirst ? 0 : 1);
+                    continue;
+                } else if (hitLeft || hitRight) {
+                    nodeIndex = node.offset + (hitLeft ? 0 : 1);
+                    continue;
+                }
+            }
+
+            // Nodes are culled against the current tMax again when popped
+            do {
+                if (stackSize == 0) {
+                    return false;
+                }
+                nodeIndex = stack[--stackSize];
+            } while (!traversal.intersect(mNodes[nodeIndex].bounds, tMin, tMax, tEntry));
+        }
+    }
+
+    template <uint32_t Size, typename IntersectPrimitive>
+    void CpuBvh::traversePacket(const CpuRayPacket<Size> &packet, float (&tMax)[Size], IntersectPrimitive &&intersectPrimitive, uint32_t minActiveLanes, uint32_t rootIndex) const
+    {
+        if (mNodes.empty()) {
+            return;
+        }
+
+        CpuPacketTraversal<Size> traversal(packet);
+        float tEntry;
+        uint32_t mask = traversal.intersect(mNodes[rootIndex].bounds, tMax, packet.activeMask, tEntry);
+        uint32_t ended = 0;
+
+        struct StackEntry
+        {
+            uint32_t nodeIndex;
+            uint32_t mask;
+            float tEntry;
+        };
+        StackEntry stack[kMaxDepth];
+        uint32_t stackSize = 0;
+        uint32_t nodeIndex = rootIndex;
+
+        for (;;) {
+            mask &= ~ended;
+            if (mask && CpuMath::countbits(mask) < minActiveLanes) {
+                for (uint32_t bits = mask; bits; bits &= bits - 1) {
+                    uint32_t lane = CpuMath::firstbitlow(bits);
+                    uint32_t laneMask = 1u << lane;
+                    traverseSubtree(nodeIndex, traversal.getLane(lane), traversal.tMin[lane], tMax[lane], [&](uint32_t primitive, float &) {
+                        return (intersectPrimitive(primitive, laneMask, tMax) & laneMask) != 0;
+                    });
+                }
+            } else if (mask) {
+                const Node &node = mNodes[nodeIndex];
+                if (node.isLeaf()) {
+                    for (uint32_t i = 0; i < node.count && (mask & ~ended); ++i) {
+                        ended |= intersectPrimitive(mPrimitiveIndices[node.offset + i], mask & ~ended, tMax);
+                    }
+                } else {
+                    float tLeft, tRight;
+                    const Node &left = mNodes[node.offset], &right = mNodes[node.offset + 1];
+                    uint32_t leftMask = left.isLeaf() ? traversal.intersect(left.bounds, tMax, mask, tLeft) : traversal.intersectFirst(left.bounds, tMax, mask, tLeft);
+                    uint32_t rightMask = right.isLeaf() ? traversal.intersect(right.bounds, tMax, mask, tRight) : traversal.intersectFirst(right.bounds, tMax, mask, tRight);
+                    if (leftMask && rightMask) {
+                        bool leftFirst = tLeft <= tRight;
+                        stack[stackSize++] = leftFirst ? StackEntry{ node.offset + 1, rightMask, tRight } : StackEntry{ node.offset, leftMask, tLeft };
+                        nodeIndex = node.offset + (leftFirst ? 0 : 1);
+                        mask = leftFirst ? leftMask : rightMask;
+                        continue;
+                    } else if (leftMask || rightMask) {
+                        nodeIndex = node.offset + (leftMask ? 0 : 1);
+                        mask = leftMask | rightMask;
+                        continue;
+                    }
+                }
+            }
+
+            // Skip entries that every remaining ray has found a closer hit than
+            for (;;) {
+                if (stackSize == 0) {
+                    return;
+                }
+                const StackEntry &entry = stack[--stackSize];
+                nodeIndex = entry.nodeIndex;
+                mask = entry.mask & ~ended;
+                float tLimit = -1e30f;
+                for (uint32_t bits = mask; bits; bits &= bits - 1) {
+                    tLimit = (std::max)(tLimit, tMax[CpuMath::firstbitlow(bits)]);
+                }
+                if (entry.tEntry <= tLimit) {
+                    break;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,272 @@
+#include "CpuContext.h"
+#include <chrono>
+
+namespace DXRFramework
+{
+    using namespace CpuMath;
+
+    void CpuShaderContext::traceRayErased(uint32_t rayFlags, uint32_t rayContribution, uint32_t missIndex, const CpuRay &ray, void *payload)
+    {
+        ++mRayCount;
+
+        CpuHit hit;
+        bool found = mScene.traceRay(ray, rayFlags, hit);
+
+        RayState callerState = mState;
+        mState.ray = ray;
+
+        const CpuProgram &program = *mBindings.getProgram();
+        if (found) {
+            if (!(rayFlags & CpuRayFlagSkipClosestHitShader)) {
+                const CpuScene::Instance &instance = mScene.getInstance(hit.instanceIndex);
+                uint32_t recordIndex = rayContribution + instance.hitGroupOffset;
+                const auto &closestHit = program.getHitProgram(recordIndex % program.getHitProgramCount());
+                if (closestHit) {
+                    mState.ray.tMax = hit.t;
+                    mState.instanceIndex = hit.instanceIndex;
+                    mState.primitiveIndex = hit.primitiveIndex;
+                    mState.frontFace = hit.frontFace;
+                    mState.localParams = &mBindings.getHitRecord(recordIndex);
+                    closestHit(*this, payload, hit);
+                }
+            }
+        } else {
+            const auto &miss = program.getMissProgram(missIndex);
+            if (miss) {
+                mState.localParams = const_cast<CpuBindings&>(mBindings).getMissVars(missIndex).get();
+                miss(*this, payload);
+            }
+        }
+
+        mState = callerState;
+    }
+
+    CpuContext::CpuContext(uint32_t threadCount)
+    {
+        if (threadCount == 0) {
+            threadCount = (std::max)(1u, std::thread::hardware_concurrency());
+        }
+        // The calling thread works on the dispatch as well
+        for (uint32_t i = 1; i < threadCount; ++i) {
+            mThreads.emplace_back(&CpuContext::workerLoop, this);
+        }
+    }
+
+    CpuContext::~CpuContext()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mShutdown = true;
+        }
+        mWorkAvailable.notify_all();
+        for (auto &thread : mThreads) {
+            thread.join();
+        }
+    }
+
+    void CpuContext::workerLoop()
+    {
+        uint64_t seenDispatch = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mWorkAvailable.wait(lock, [&] { return mShutdown || mDispatchIndex != seenDispatch; });
+                if (mShutdown) {
+                    return;
+                }
+                seenDispatch = mDispatchIndex;
+                ++mBusyWorkers;
+            }
+
+            runTiles();
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                --mBusyWorkers;
+            }
+            mWorkDone.notify_one();
+        }
+    }
+
+    void CpuContext::runTiles()
+    {
+        // Every tile that is taken is finished, so the tiles done always form one range of the order
+        while (!mStopped) {
+            if (mHasDeadline && Clock::now() >= mDeadline) {
+                mStopped = true;
+                break;
+            }
+            if (mCancel && *mCancel && (*mCancel)()) {
+                mCancelled = true;
+                mStopped = true;
+                break;
+            }
+            uint32_t tile = mNextTile++;
+            if (tile >= mTileCount) {
+                break;
+            }
+            mTileFunction(tile);
+        }
+
+        if (!mIdle.exchange(true)) {
+            mFirstIdleTime = Clock::now();
+        }
+    }
+
+    void CpuContext::parallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t begin, uint32_t end)> &function)
+    {
+        grainSize = (std::max)(grainSize, 1u);
+        uint32_t rangeCount = (count + grainSize - 1) / grainSize;
+        if (rangeCount <= 1 || mThreads.empty()) {
+            if (count > 0) {
+                function(0, count);
+            }
+            return;
+        }
+
+        auto rangeFunction = [&](uint32_t range) {
+            uint32_t begin = range * grainSize;
+            function(begin, (std::min)(begin + grainSize, count));
+        };
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWorkDone.wait(lock, [&] { return mBusyWorkers == 0; });
+            mHasDeadline = false;
+            mCancel = nullptr;
+            mStopped = false;
+            mTileFunction = rangeFunction;
+            mTileCount = rangeCount;
+            mNextTile = 0;
+            mIdle = false;
+            ++mDispatchIndex;
+        }
+        mWorkAvailable.notify_all();
+
+        runTiles();
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mWorkDone.wait(lock, [&] { return mBusyWorkers == 0; });
+        mTileCount = 0;
+        mStopped = true;
+    }
+
+    const std::vector<uint32_t> &CpuContext::getTileOrder(uint32_t tilesX, uint32_t tilesY)
+    {
+        if (mTileOrderX != tilesX || mTileOrderY != tilesY) {
+            // Walks the Z curve over the power of two square that covers the grid and skips the
+            // codes outside of it
+            auto compact = [](uint32_t code) {
+                code &= 0x55555555u;
+                code = (code | (code >> 1)) & 0x33333333u;
+                code = (code | (code >> 2)) & 0x0f0f0f0fu;
+                code = (code | (code >> 4)) & 0x00ff00ffu;
+                code = (code | (code >> 8)) & 0x0000ffffu;
+                return code;
+            };
+            uint32_t side = 1;
+            while (side < (std::max)(tilesX, tilesY)) {
+                side *= 2;
+            }
+
+            mTileOrder.clear();
+            mTileOrder.reserve(size_t(tilesX) * tilesY);
+            for (uint64_t code = 0; code < uint64_t(side) * side; ++code) {
+                uint32_t x = compact(static_cast<uint32_t>(code));
+                uint32_t y = compact(static_cast<uint32_t>(code >> 1));
+                if (x < tilesX && y < tilesY) {
+                    mTileOrder.push_back(y * tilesX + x);
+                }
+            }
+            mTileOrderX = tilesX;
+            mTileOrderY = tilesY;
+        }
+        return mTileOrder;
+    }
+
+    bool CpuContext::raytrace(CpuBindings::SharedPtr bindings, uint32_t width, uint32_t height, uint32_t depth, const DispatchOptions &options)
+    {
+        const CpuProgram::RayGenShader &rayGen = bindings->getProgram()->getRayGenProgram();
+        uint32_t tilesX = (width + kTileSize - 1) / kTileSize;
+        uint32_t tilesY = (height + kTileSize - 1) / kTileSize;
+        uint32_t sliceTileCount = tilesX * tilesY;
+        const std::vector<uint32_t> &tileOrder = getTileOrder(tilesX, tilesY);
+
+        auto start = Clock::now();
+        mLastDispatchStats = Stats();
+        mLastDispatchStats.tileCount = sliceTileCount * depth;
+        mLastDispatchStats.firstTile = (std::min)(options.firstTile, mLastDispatchStats.tileCount);
+        {
+            // A worker that woke up late for the previous dispatch may still be looking at its state
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWorkDone.wait(lock, [&] { return mBusyWorkers == 0; });
+            mHasDeadline = options.timeBudget > 0.0;
+            mDeadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.timeBudget));
+            mCancel = &options.cancel;
+            mRayCount = 0;
+            mStopped = false;
+            mCancelled = false;
+        }
+
+        // Depth slices run one after another, matching DispatchRaysIndex().z being ignored by 2D shaders
+        uint32_t nextTile = mLastDispatchStats.firstTile;
+        while (nextTile < mLastDispatchStats.tileCount && !mStopped) {
+            uint32_t sliceStart = nextTile / sliceTileCount * sliceTileCount;
+            uint32_t sliceEnd = sliceStart + sliceTileCount;
+
+            auto tileFunction = [&](uint32_t index) {
+                uint32_t tile = tileOrder[index - sliceStart];
+                if (!options.tileMask.empty() && !options.tileMask[tile]) {
+                    return;
+                }
+                uint32_t x0 = (tile % tilesX) * kTileSize;
+                uint32_t y0 = (tile / tilesX) * kTileSize;
+                uint32_t x1 = (std::min)(x0 + kTileSize, width);
+                uint32_t y1 = (std::min)(y0 + kTileSize, height);
+
+                uint64_t rays = 0;
+                for (uint32_t y = y0; y < y1; ++y) {
+                    for (uint32_t x = x0; x < x1; ++x) {
+                        CpuShaderContext context(*bindings, uint2(x, y), uint2(width, height));
+                        rayGen(context);
+                        rays += context.getRayCount();
+                    }
+                }
+                mRayCount += rays;
+            };
+
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mWorkDone.wait(lock, [&] { return mBusyWorkers == 0; });
+                mTileFunction = tileFunction;
+                mTileCount = sliceEnd;
+                mNextTile = nextTile;
+                mIdle = false;
+                ++mDispatchIndex;
+            }
+            mWorkAvailable.notify_all();
+
+            runTiles();
+
+            // Workers that wake up after the last tile was taken find nothing left and return immediately
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWorkDone.wait(lock, [&] { return mBusyWorkers == 0; });
+            mLastDispatchStats.tailSeconds += std::chrono::duration<double>(Clock::now() - mFirstIdleTime).count();
+            nextTile = (std::min)(mNextTile.load(), sliceEnd);
+            // The tile function goes out of scope, late workers must not find a tile to run
+            mTileCount = 0;
+        }
+
+        auto end = Clock::now();
+        mLastDispatchStats.rays = mRayCount;
+        mLastDispatchStats.seconds = std::chrono::duration<double>(end - start).count();
+        mLastDispatchStats.nextTile = nextTile;
+        mLastDispatchStats.cancelled = mCancelled;
+        {
+            // Nor call the cancel function of options that are about to go away
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopped = true;
+        }
+        return mLastDispatchStats.isComplete();
+    }
+}
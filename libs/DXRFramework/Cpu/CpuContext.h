@@ -0,0 +1,175 @@
+#pragma once
+
+#include "CpuBindings.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace DXRFramework
+{
+    // What the HLSL intrinsics return for the shader being executed. A new ray state is pushed for
+    // every TraceRay so hit and miss shaders see their own ray while the caller's state is kept.
+    class CpuShaderContext
+    {
+    public:
+        CpuShaderContext(const CpuBindings &bindings, CpuMath::uint2 dispatchIndex, CpuMath::uint2 dispatchDimensions)
+            : mBindings(bindings), mScene(*bindings.getScene()), mDispatchIndex(dispatchIndex), mDispatchDimensions(dispatchDimensions), mRayCount(0)
+        {
+            mState.localParams = const_cast<CpuBindings&>(bindings).getRayGenVars().get();
+        }
+
+        CpuMath::uint2 dispatchRaysIndex() const { return mDispatchIndex; }
+        CpuMath::uint2 dispatchRaysDimensions() const { return mDispatchDimensions; }
+
+        const CpuMath::float3 &worldRayOrigin() const { return mState.ray.origin; }
+        const CpuMath::float3 &worldRayDirection() const { return mState.ray.direction; }
+        float rayTMin() const { return mState.ray.tMin; }
+        float rayTCurrent() const { return mState.ray.tMax; }
+        uint32_t instanceIndex() const { return mState.instanceIndex; }
+        uint32_t primitiveIndex() const { return mState.primitiveIndex; }
+        bool isFrontFace() const { return mState.frontFace; }
+        const CpuScene::Instance &getInstance() const { return mScene.getInstance(mState.instanceIndex); }
+
+        // Parameters of the shader record being executed and the global root signature
+        const CpuParams &getLocalVars() const { return *mState.localParams; }
+        const CpuParams &getGlobalVars() const { return *const_cast<CpuBindings&>(mBindings).getGlobalVars(); }
+
+        template <typename Payload>
+        void traceRay(uint32_t rayFlags, uint32_t /* instanceInclusionMask */, uint32_t rayContributionToHitGroupIndex,
+                      uint32_t /* multiplierForGeometryContributionToHitGroupIndex */, uint32_t missShaderIndex, const CpuRay &ray, Payload &payload)
+        {
+            traceRayErased(rayFlags, rayContributionToHitGroupIndex, missShaderIndex, ray, &payload);
+        }
+
+        uint64_t getRayCount() const { return mRayCount; }
+
+    private:
+        struct RayState
+        {
+            CpuRay ray;
+            uint32_t instanceIndex = 0;
+            uint32_t primitiveIndex = 0;
+            bool frontFace = false;
+            const CpuParams *localParams = nullptr;
+        };
+
+        // Instance masks are ignored, every instance uses 0xFF. With a single geometry per instance the
+        // geometry multiplier does not change the record index.
+        void traceRayErased(uint32_t rayFlags, uint32_t rayContribution, uint32_t missIndex, const CpuRay &ray, void *payload);
+
+        const CpuBindings &mBindings;
+        const CpuScene &mScene;
+        CpuMath::uint2 mDispatchIndex;
+        CpuMath::uint2 mDispatchDimensions;
+        RayState mState;
+        uint64_t mRayCount;
+    };
+
+    // How much of a dispatch to run. Tiles are numbered in Morton order over every depth slice, so a
+    // dispatch that stops early is resumed by starting the next one at the tile it reached.
+    struct CpuDispatchOptions
+    {
+        uint32_t firstTile = 0;
+
+        // Seconds after which no new tile is started, tiles in flight still finish. 0 runs every tile.
+        double timeBudget = 0.0;
+
+        // Polled by every thread before it starts a tile, the dispatch stops once it returns true. It is
+        // called concurrently, e.g. reading a flag set by another thread.
+        std::function<bool()> cancel;
+
+        // Tiles, numbered y * tilesX + x, whose entry is 0 are skipped. Empty runs every tile.
+        std::vector<uint8_t> tileMask;
+    };
+
+    // CPU counterpart of RtContext. raytrace() runs the ray generation shader over the dispatch in
+    // tiles pulled by a persistent pool of worker threads and returns when the dispatch is complete.
+    // Tiles are handed out along a Morton curve, so the tiles in flight at any time are close to
+    // each other on screen and share the upper levels of the scene hierarchy in the caches.
+    class CpuContext
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CpuContext>;
+        using DispatchOptions = CpuDispatchOptions;
+
+        // threadCount 0 uses one thread per hardware thread
+        static SharedPtr create(uint32_t threadCount = 0) { return SharedPtr(new CpuContext(threadCount)); }
+        ~CpuContext();
+
+        struct Stats
+        {
+            uint64_t rays = 0;
+            double seconds = 0.0;
+
+            // Time from the first thread running out of tiles to the end of the dispatch, summed over
+            // the depth slices. Tiles that take much longer than the others show up here.
+            double tailSeconds = 0.0;
+
+            uint32_t tileCount = 0;
+            uint32_t firstTile = 0;
+            // Where the next dispatch continues, tileCount once every tile is done
+            uint32_t nextTile = 0;
+            bool cancelled = false;
+
+            double getRaysPerSecond() const { return seconds > 0.0 ? rays / seconds : 0.0; }
+            bool isComplete() const { return nextTile == tileCount; }
+        };
+
+        // Returns true when the last tile of the dispatch was traced
+        bool raytrace(CpuBindings::SharedPtr bindings, uint32_t width, uint32_t height, uint32_t depth = 1,
+                      const DispatchOptions &options = DispatchOptions());
+
+        // Calls function(begin, end) for ranges of [0, count) of at most grainSize items on the pool and
+        // returns when all are done. Used by stages that do not map to a ray generation shader. Neither
+        // this nor raytrace() may be called from inside a range or a tile.
+        void parallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t begin, uint32_t end)> &function);
+
+        // Tile indices of a grid of tilesX by tilesY tiles in dispatch order. Only valid until the next
+        // dispatch of a different size.
+        const std::vector<uint32_t> &getTileOrder(uint32_t tilesX, uint32_t tilesY);
+
+        uint32_t getThreadCount() const { return static_cast<uint32_t>(mThreads.size()) + 1; }
+        const Stats &getLastDispatchStats() const { return mLastDispatchStats; }
+
+        static const uint32_t kTileSize = 16;
+
+    private:
+        CpuContext(uint32_t threadCount);
+
+        using Clock = std::chrono::high_resolution_clock;
+
+        void workerLoop();
+        void runTiles();
+
+
+        std::vector<std::thread> mThreads;
+        std::mutex mMutex;
+        std::condition_variable mWorkAvailable;
+        std::condition_variable mWorkDone;
+        uint64_t mDispatchIndex = 0;
+        uint32_t mBusyWorkers = 0;
+        bool mShutdown = false;
+
+        // Current dispatch
+        std::function<void(uint32_t tile)> mTileFunction;
+        uint32_t mTileCount = 0;
+        std::atomic<uint32_t> mNextTile;
+        std::atomic<uint64_t> mRayCount;
+        std::atomic<bool> mStopped;
+        std::atomic<bool> mCancelled;
+        std::atomic<bool> mIdle;
+        Clock::time_point mFirstIdleTime;
+        Clock::time_point mDeadline;
+        bool mHasDeadline = false;
+        const std::function<bool()> *mCancel = nullptr;  // the dispatch's options outlive the workers' use
+
+        std::vector<uint32_t> mTileOrder;
+        uint32_t mTileOrderX = 0;
+        uint32_t mTileOrderY = 0;
+
+        Stats mLastDispatchStats;
+    };
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+// Small HLSL flavoured vector library for the CPU ray tracing backend, so that shader ports read like
+// their HLSL originals. Also makes RaytracingHlslCompat.h usable on platforms without DirectXMath.
+// min/max are parenthesized so the header survives the Windows min/max macros.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Same definitions as the Windows headers, repeating them is harmless
+typedef unsigned short UINT16;
+typedef unsigned int UINT;
+
+#ifdef _WIN32
+#include <DirectXMath.h>
+#include <intrin.h>
+#else
+namespace DirectX
+{
+    struct XMFLOAT2 { float x, y; XMFLOAT2() = default; XMFLOAT2(float x, float y) : x(x), y(y) {} };
+    struct XMFLOAT3 { float x, y, z; XMFLOAT3() = default; XMFLOAT3(float x, float y, float z) : x(x), y(y), z(z) {} };
+    struct XMFLOAT4 { float x, y, z, w; XMFLOAT4() = default; XMFLOAT4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {} };
+}
+#endif
+
+namespace DXRFramework
+{
+    namespace CpuMath
+    {
+        struct uint2
+        {
+            uint32_t x, y;
+            uint2() = default;
+            uint2(uint32_t x, uint32_t y) : x(x), y(y) {}
+        };
+
+        struct float2
+        {
+            float x, y;
+            float2() = default;
+            float2(float x, float y) : x(x), y(y) {}
+            explicit float2(float s) : x(s), y(s) {}
+        };
+
+        struct float3
+        {
+            float x, y, z;
+            float3() = default;
+            float3(float x, float y, float z) : x(x), y(y), z(z) {}
+            explicit float3(float s) : x(s), y(s), z(s) {}
+            explicit float3(const DirectX::XMFLOAT3 &v) : x(v.x), y(v.y), z(v.z) {}
+            explicit float3(const DirectX::XMFLOAT4 &v) : x(v.x), y(v.y), z(v.z) {}
+
+            float operator[](int i) const { return (&x)[i]; }
+            float &operator[](int i) { return (&x)[i]; }
+        };
+
+        struct float4
+        {
+            float x, y, z, w;
+            float4() = default;
+            float4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+            float4(const float3 &v, float w) : x(v.x), y(v.y), z(v.z), w(w) {}
+            explicit float4(float s) : x(s), y(s), z(s), w(s) {}
+            explicit float4(const DirectX::XMFLOAT4 &v) : x(v.x), y(v.y), z(v.z), w(v.w) {}
+
+            float3 xyz() const { return float3(x, y, z); }
+            float3 rgb() const { return float3(x, y, z); }
+        };
+
+        inline float2 operator+(const float2 &a, const float2 &b) { return float2(a.x + b.x, a.y + b.y); }
+        inline float2 operator-(const float2 &a, const float2 &b) { return float2(a.x - b.x, a.y - b.y); }
+        inline float2 operator*(const float2 &a, float s) { return float2(a.x * s, a.y * s); }
+
+        inline float3 operator+(const float3 &a, const float3 &b) { return float3(a.x + b.x, a.y + b.y, a.z + b.z); }
+        inline float3 operator-(const float3 &a, const float3 &b) { return float3(a.x - b.x, a.y - b.y, a.z - b.z); }
+        inline float3 operator*(const float3 &a, const float3 &b) { return float3(a.x * b.x, a.y * b.y, a.z * b.z); }
+        inline float3 operator/(const float3 &a, const float3 &b) { return float3(a.x / b.x, a.y / b.y, a.z / b.z); }
+        inline float3 operator*(const float3 &a, float s) { return float3(a.x * s, a.y * s, a.z * s); }
+        inline float3 operator*(float s, const float3 &a) { return a * s; }
+        inline float3 operator/(const float3 &a, float s) { return a * (1.0f / s); }
+        inline float3 operator-(const float3 &a) { return float3(-a.x, -a.y, -a.z); }
+        inline float3 &operator+=(float3 &a, const float3 &b) { return a = a + b; }
+        inline float3 &operator*=(float3 &a, float s) { return a = a * s; }
+
+        inline float4 operator+(const float4 &a, const float4 &b) { return float4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w); }
+        inline float4 operator-(const float4 &a, const float4 &b) { return float4(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w); }
+        inline float4 operator*(const float4 &a, float s) { return float4(a.x * s, a.y * s, a.z * s, a.w * s); }
+        inline float4 operator*(float s, const float4 &a) { return a * s; }
+        inline float4 operator/(const float4 &a, float s) { return a * (1.0f / s); }
+
+        inline float dot(const float3 &a, const float3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+        inline float3 cross(const float3 &a, const float3 &b) { return float3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x); }
+        inline float length(const float3 &a) { return std::sqrt(dot(a, a)); }
+        inline float3 normalize(const float3 &a) { return a / length(a); }
+
+        inline float3 (min)(const float3 &a, const float3 &b) { return float3((std::min)(a.x, b.x), (std::min)(a.y, b.y), (std::min)(a.z, b.z)); }
+        inline float3 (max)(const float3 &a, const float3 &b) { return float3((std::max)(a.x, b.x), (std::max)(a.y, b.y), (std::max)(a.z, b.z)); }
+        inline float3 abs(const float3 &a) { return float3(std::fabs(a.x), std::fabs(a.y), std::fabs(a.z)); }
+        inline float3 (max)(const float3 &a, float s) { return (max)(a, float3(s)); }
+
+        inline float saturate(float x) { return (std::min)(1.0f, (std::max)(0.0f, x)); }
+        inline float3 saturate(const float3 &a) { return float3(saturate(a.x), saturate(a.y), saturate(a.z)); }
+        inline float lerp(float a, float b, float t) { return a + (b - a) * t; }
+        inline float3 lerp(const float3 &a, const float3 &b, float t) { return a + (b - a) * t; }
+        inline float4 lerp(const float4 &a, const float4 &b, float t) { return a + (b - a) * t; }
+        inline float3 reflect(const float3 &i, const float3 &n) { return i - 2.0f * dot(n, i) * n; }
+        inline float luminance(const float3 &c) { return dot(c, float3(0.2126f, 0.7152f, 0.0722f)); }
+
+        inline uint32_t countbits(uint32_t x)
+        {
+            uint32_t count = 0;
+            for (; x; x &= x - 1) {
+                ++count;
+            }
+            return count;
+        }
+
+        // Index of the lowest set bit, x must not be zero
+        inline uint32_t firstbitlow(uint32_t x)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, x);
+            return index;
+#else
+            return static_cast<uint32_t>(__builtin_ctz(x));
+#endif
+        }
+
+        inline float maxComponent(const float3 &a) { return (std::max)(a.x, (std::max)(a.y, a.z)); }
+        inline float minComponent(const float3 &a) { return (std::min)(a.x, (std::min)(a.y, a.z)); }
+
+        // Row-major affine transform, the same layout as D3D12_RAYTRACING_INSTANCE_DESC::Transform
+        struct float3x4
+        {
+            float m[3][4];
+
+            static float3x4 identity()
+            {
+                float3x4 t = {};
+                t.m[0][0] = t.m[1][1] = t.m[2][2] = 1.0f;
+                return t;
+            }
+
+            float3 transformPoint(const float3 &p) const
+            {
+                return float3(m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+                              m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+                              m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3]);
+            }
+
+            float3 transformVector(const float3 &v) const
+            {
+                return float3(m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+                              m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+                              m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z);
+            }
+
+            float3x4 inverse() const
+            {
+                const float (&a)[3][4] = m;
+                float det = a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1])
+                          - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0])
+                          + a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+                float invDet = 1.0f / det;
+
+                float3x4 r;
+                r.m[0][0] = (a[1][1] * a[2][2] - a[1][2] * a[2][1]) * invDet;
+                r.m[0][1] = (a[0][2] * a[2][1] - a[0][1] * a[2][2]) * invDet;
+                r.m[0][2] = (a[0][1] * a[1][2] - a[0][2] * a[1][1]) * invDet;
+                r.m[1][0] = (a[1][2] * a[2][0] - a[1][0] * a[2][2]) * invDet;
+                r.m[1][1] = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) * invDet;
+                r.m[1][2] = (a[0][2] * a[1][0] - a[0][0] * a[1][2]) * invDet;
+                r.m[2][0] = (a[1][0] * a[2][1] - a[1][1] * a[2][0]) * invDet;
+                r.m[2][1] = (a[0][1] * a[2][0] - a[0][0] * a[2][1]) * invDet;
+                r.m[2][2] = (a[0][0] * a[1][1] - a[0][1] * a[1][0]) * invDet;
+
+                float3 t = r.transformVector(float3(a[0][3], a[1][3], a[2][3]));
+                r.m[0][3] = -t.x;
+                r.m[1][3] = -t.y;
+                r.m[2][3] = -t.z;
+                return r;
+            }
+        };
+    }
+}
@@ -0,0 +1,338 @@
+#include "CpuModel.h"
+#include <algorithm>
+
+namespace DXRFramework
+{
+    using namespace CpuMath;
+
+    // Bounds of the parts of a triangle on either side of an axis aligned plane, clipped to the bounds
+    // of the reference being split
+    static void splitTriangle(const float3 &v0, const float3 &v1, const float3 &v2, int axis, float position, const CpuAabb &bounds,
+                              CpuAabb &left, CpuAabb &right)
+    {
+        const float3 *vertices[] = { &v0, &v1, &v2 };
+        left = CpuAabb::empty();
+        right = CpuAabb::empty();
+        for (int i = 0; i < 3; ++i) {
+            const float3 &a = *vertices[i], &b = *vertices[(i + 1) % 3];
+            if (a[axis] <= position) {
+                left.grow(a);
+            }
+            if (a[axis] >= position) {
+                right.grow(a);
+            }
+            if ((a[axis] < position && b[axis] > position) || (a[axis] > position && b[axis] < position)) {
+                float3 p = a + (b - a) * ((position - a[axis]) / (b[axis] - a[axis]));
+                p[axis] = position;
+                left.grow(p);
+                right.grow(p);
+            }
+        }
+        left = CpuAabb::overlap(left, bounds);
+        right = CpuAabb::overlap(right, bounds);
+    }
+
+    void CpuModel::build(const CpuBvh::BuildOptions &options, CpuBvhLayout layout, CpuTriangleTest triangleTest)
+    {
+        const auto &vertices = mGeometry->vertices;
+        const auto &indices = mGeometry->indices;
+
+        std::vector<CpuAabb> triangleBounds(mGeometry->getTriangleCount());
+        for (size_t i = 0; i < triangleBounds.size(); ++i) {
+            triangleBounds[i] = CpuAabb::empty();
+            for (int v = 0; v < 3; ++v) {
+                triangleBounds[i].grow(vertices[indices[i * 3 + v]].position);
+            }
+        }
+        mBvh.build(triangleBounds, options, [&](uint32_t triangle, int axis, float position, const CpuAabb &bounds, CpuAabb &left, CpuAabb &right) {
+            splitTriangle(vertices[indices[triangle * 3 + 0]].position, vertices[indices[triangle * 3 + 1]].position,
+                          vertices[indices[triangle * 3 + 2]].position, axis, position, bounds, left, right);
+        });
+        mBounds = mBvh.getBounds();
+
+        mLayout = layout;
+        mTriangleTest = triangleTest;
+        mBvh4 = CpuBvh4();
+        mBvh8 = CpuBvh8();
+        mTriangles.clear();
+        mTriangleVertices.clear();
+        if (layout == CpuBvhLayout::Wide4) {
+            mBvh4.build(mBvh, 4);
+            buildTriangles(mBvh4);
+            mBvh = CpuBvh();
+        } else if (layout == CpuBvhLayout::Wide8) {
+            mBvh8.build(mBvh, 4);
+            buildTriangles(mBvh8);
+            mBvh = CpuBvh();
+        }
+        mBuilt = true;
+    }
+
+    template <typename Bvh>
+    void CpuModel::buildTriangles(const Bvh &bvh)
+    {
+        const auto &vertices = mGeometry->vertices;
+        const auto &indices = mGeometry->indices;
+        const auto &primitiveIndices = bvh.getPrimitiveIndices();
+
+        // Padding entries stay zero and never hit
+        size_t blockCount = (primitiveIndices.size() + 3) / 4;
+        if (mTriangleTest == CpuTriangleTest::Watertight) {
+            mTriangleVertices.assign(blockCount, CpuTriangleVertices4());
+        } else {
+            mTriangles.assign(blockCount, CpuTriangle4());
+        }
+        for (size_t i = 0; i < primitiveIndices.size(); ++i) {
+            uint32_t triangle = primitiveIndices[i];
+            if (triangle == Bvh::kInvalidPrimitive) {
+                continue;
+            }
+            const float3 &v0 = vertices[indices[triangle * 3 + 0]].position;
+            const float3 &v1 = vertices[indices[triangle * 3 + 1]].position;
+            const float3 &v2 = vertices[indices[triangle * 3 + 2]].position;
+            if (mTriangleTest == CpuTriangleTest::Watertight) {
+                mTriangleVertices[i / 4].set(i % 4, v0, v1, v2);
+            } else {
+                mTriangles[i / 4].set(i % 4, v0, v1, v2);
+            }
+        }
+    }
+
+    size_t CpuModel::getBvhMemoryUsage() const
+    {
+        switch (mLayout) {
+        case CpuBvhLayout::Wide4:
+            return mBvh4.getMemoryUsage();
+        case CpuBvhLayout::Wide8:
+            return mBvh8.getMemoryUsage();
+        default:
+            return mBvh.getNodes().size() * sizeof(CpuBvh::Node) + mBvh.getPrimitiveIndices().size() * sizeof(uint32_t);
+        }
+    }
+
+    const uint32_t CpuModel::kRootNode;
+    const uint32_t CpuModel::kMaxNodeChildren;
+
+    uint32_t CpuModel::getNodeChildren(uint32_t node, uint32_t (&children)[kMaxNodeChildren], CpuAabb (&bounds)[kMaxNodeChildren]) const
+    {
+        switch (mLayout) {
+        case CpuBvhLayout::Wide4:
+            return getWideNodeChildren(mBvh4, node, children, bounds);
+        case CpuBvhLayout::Wide8:
+            return getWideNodeChildren(mBvh8, node, children, bounds);
+        default:
+            if (mBvh.isEmpty() || mBvh.getNodes()[node].isLeaf()) {
+                return 0;
+            }
+            for (uint32_t i = 0; i < 2; ++i) {
+                children[i] = mBvh.getNodes()[node].offset + i;
+                bounds[i] = mBvh.getNodes()[children[i]].bounds;
+            }
+            return 2;
+        }
+    }
+
+    template <typename Bvh>
+    uint32_t CpuModel::getWideNodeChildren(const Bvh &bvh, uint32_t node, uint32_t (&children)[kMaxNodeChildren], CpuAabb (&bounds)[kMaxNodeChildren])
+    {
+        if (bvh.isEmpty()) {
+            return 0;
+        }
+        uint32_t wideChildren[Bvh::kWidth];
+        CpuAabb wideBounds[Bvh::kWidth];
+        uint32_t count = bvh.getChildren(node, wideChildren, wideBounds);
+        std::copy(wideChildren, wideChildren + count, children);
+        std::copy(wideBounds, wideBounds + count, bounds);
+        return count;
+    }
+
+    bool CpuModel::intersect(const CpuRay &ray, uint32_t rayFlags, CpuHit &hit, uint32_t node) const
+    {
+        switch (mLayout) {
+        case CpuBvhLayout::Wide4:
+            return intersectWide(mBvh4, ray, rayFlags, hit, node);
+        case CpuBvhLayout::Wide8:
+            return intersectWide(mBvh8, ray, rayFlags, hit, node);
+        default:
+            return intersectBinary(ray, rayFlags, hit, node);
+        }
+    }
+
+    bool CpuModel::intersectBinary(const CpuRay &ray, uint32_t rayFlags, CpuHit &hit, uint32_t node) const
+    {
+        const auto &vertices = mGeometry->vertices;
+        const auto &indices = mGeometry->indices;
+        bool acceptFirstHit = (rayFlags & CpuRayFlagAcceptFirstHitAndEndSearch) != 0;
+        bool found = false;
+
+        float tMax = ray.tMax;
+        mBvh.traverse(ray, tMax, [&](uint32_t triangle, float &t) {
+            const float3 &v0 = vertices[indices[triangle * 3 + 0]].position;
+            const float3 &v1 = vertices[indices[triangle * 3 + 1]].position;
+            const float3 &v2 = vertices[indices[triangle * 3 + 2]].position;
+            if (intersectTriangle(ray, v0, v1, v2, rayFlags, t, hit)) {
+                hit.primitiveIndex = triangle;
+                t = hit.t;
+                found = true;
+                return acceptFirstHit;
+            }
+            return false;
+        }, node);
+        return found;
+    }
+
+    // Leaves start on a block boundary and cover count slots from there
+    static uint32_t blockLaneMask(uint32_t first, uint32_t count, uint32_t block)
+    {
+        uint32_t remaining = first + count - block * 4;
+        return remaining >= 4 ? 0xfu : (1u << remaining) - 1;
+    }
+
+    template <typename Bvh>
+    bool CpuModel::intersectWide(const Bvh &bvh, const CpuRay &ray, uint32_t rayFlags, CpuHit &hit, uint32_t node) const
+    {
+        const auto &primitiveIndices = bvh.getPrimitiveIndices();
+        bool acceptFirstHit = (rayFlags & CpuRayFlagAcceptFirstHitAndEndSearch) != 0;
+        bool watertight = mTriangleTest == CpuTriangleTest::Watertight;
+        CpuWatertightRay watertightRay(ray);
+        bool found = false;
+
+        float tMax = ray.tMax;
+        bvh.traverseLeaves(ray, tMax, [&](uint32_t first, uint32_t count, float &t) {
+            for (uint32_t block = first / 4; block * 4 < first + count; ++block) {
+                CpuTriangleHit4 blockHit;
+                uint32_t laneMask = blockLaneMask(first, count, block);
+                uint32_t hits = watertight ? intersectTriangles(mTriangleVertices[block], watertightRay, rayFlags, t, laneMask, blockHit)
+                                           : intersectTriangles(mTriangles[block], ray, rayFlags, t, laneMask, blockHit);
+                if (hits) {
+                    uint32_t lane = blockHit.closest(hits);
+                    blockHit.getHit(lane, hit);
+                    hit.primitiveIndex = primitiveIndices[block * 4 + lane];
+                    t = hit.t;
+                    found = true;
+                    if (acceptFirstHit) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }, node);
+        return found;
+    }
+
+    template <uint32_t Size>
+    uint32_t CpuModel::intersectPacket(const CpuRayPacket<Size> &packet, uint32_t rayFlags, CpuHit (&hits)[Size], uint32_t minActiveLanes, uint32_t node) const
+    {
+        switch (mLayout) {
+        case CpuBvhLayout::Wide4:
+            return intersectPacketWide(mBvh4, packet, rayFlags, hits, minActiveLanes, node);
+        case CpuBvhLayout::Wide8:
+            return intersectPacketWide(mBvh8, packet, rayFlags, hits, minActiveLanes, node);
+        default:
+            return intersectPacketBinary(packet, rayFlags, hits, minActiveLanes, node);
+        }
+    }
+
+    template <uint32_t Size>
+    uint32_t CpuModel::intersectPacketBinary(const CpuRayPacket<Size> &packet, uint32_t rayFlags, CpuHit (&hits)[Size], uint32_t minActiveLanes, uint32_t node) const
+    {
+        const auto &vertices = mGeometry->vertices;
+        const auto &indices = mGeometry->indices;
+        bool acceptFirstHit = (rayFlags & CpuRayFlagAcceptFirstHitAndEndSearch) != 0;
+        uint32_t found = 0;
+
+        CpuRay rays[Size];
+        float tMax[Size] = {};
+        for (uint32_t bits = packet.activeMask; bits; bits &= bits - 1) {
+            uint32_t lane = firstbitlow(bits);
+            rays[lane] = packet.getRay(lane);
+            tMax[lane] = packet.tMax[lane];
+        }
+
+        mBvh.traversePacket(packet, tMax, [&](uint32_t triangle, uint32_t mask, float (&t)[Size]) {
+            const float3 &v0 = vertices[indices[triangle * 3 + 0]].position;
+            const float3 &v1 = vertices[indices[triangle * 3 + 1]].position;
+            const float3 &v2 = vertices[indices[triangle * 3 + 2]].position;
+            uint32_t hitMask = 0;
+            for (uint32_t bits = mask; bits; bits &= bits - 1) {
+                uint32_t lane = firstbitlow(bits);
+                if (intersectTriangle(rays[lane], v0, v1, v2, rayFlags, t[lane], hits[lane])) {
+                    hits[lane].primitiveIndex = triangle;
+                    t[lane] = hits[lane].t;
+                    hitMask |= 1u << lane;
+                }
+            }
+            found |= hitMask;
+            return acceptFirstHit ? hitMask : 0u;
+        }, minActiveLanes, node);
+        return found;
+    }
+
+    template <uint32_t Size, typename Bvh>
+    uint32_t CpuModel::intersectPacketWide(const Bvh &bvh, const CpuRayPacket<Size> &packet, uint32_t rayFlags, CpuHit (&hits)[Size], uint32_t minActiveLanes, uint32_t node) const
+    {
+        const auto &primitiveIndices = bvh.getPrimitiveIndices();
+        bool acceptFirstHit = (rayFlags & CpuRayFlagAcceptFirstHitAndEndSearch) != 0;
+        bool watertight = mTriangleTest == CpuTriangleTest::Watertight;
+        uint32_t found = 0;
+
+        float tMax[Size] = {};
+        for (uint32_t bits = packet.activeMask; bits; bits &= bits - 1) {
+            uint32_t lane = firstbitlow(bits);
+            tMax[lane] = packet.tMax[lane];
+        }
+
+        bvh.traversePacketLeaves(packet, tMax, [&](uint32_t first, uint32_t count, uint32_t mask, float (&t)[Size]) {
+            uint32_t hitMask = 0;
+            if (watertight) {
+                // The shear depends on the ray, so each ray takes the blocks four triangles at a time
+                for (uint32_t bits = mask; bits; bits &= bits - 1) {
+                    uint32_t lane = firstbitlow(bits);
+                    CpuRay ray = packet.getRay(lane);
+                    CpuWatertightRay watertightRay(ray);
+                    for (uint32_t block = first / 4; block * 4 < first + count; ++block) {
+                        CpuTriangleHit4 blockHit;
+                        uint32_t blockHits = intersectTriangles(mTriangleVertices[block], watertightRay, rayFlags, t[lane], blockLaneMask(first, count, block), blockHit);
+                        if (blockHits) {
+                            uint32_t slot = blockHit.closest(blockHits);
+                            blockHit.getHit(slot, hits[lane]);
+                            hits[lane].primitiveIndex = primitiveIndices[block * 4 + slot];
+                            t[lane] = hits[lane].t;
+                            hitMask |= 1u << lane;
+                            if (acceptFirstHit) {
+                                break;
+                            }
+                        }
+                    }
+                }
+            } else {
+                // Each triangle against four rays at a time
+                for (uint32_t slot = first; slot < first + count; ++slot) {
+                    const CpuTriangle4 &block = mTriangles[slot / 4];
+                    for (uint32_t group = 0; group < Size; group += 4) {
+                        uint32_t groupMask = ((mask & ~(acceptFirstHit ? hitMask : 0u)) >> group) & 0xf;
+                        if (!groupMask) {
+                            continue;
+                        }
+                        CpuTriangleHit4 groupHit;
+                        uint32_t groupHits = intersectTriangle(packet, group, block, slot % 4, rayFlags, t, groupHit) & groupMask;
+                        for (uint32_t bits = groupHits; bits; bits &= bits - 1) {
+                            uint32_t i = firstbitlow(bits), lane = group + i;
+                            groupHit.getHit(i, hits[lane]);
+                            hits[lane].primitiveIndex = primitiveIndices[slot];
+                            t[lane] = hits[lane].t;
+                        }
+                        hitMask |= groupHits << group;
+                    }
+                }
+            }
+            found |= hitMask;
+            return acceptFirstHit ? hitMask : 0u;
+        }, minActiveLanes, node);
+        return found;
+    }
+
+    template uint32_t CpuModel::intersectPacket<4>(const CpuRayPacket<4> &, uint32_t, CpuHit (&)[4], uint32_t, uint32_t) const;
+    template uint32_t CpuModel::intersectPacket<8>(const CpuRayPacket<8> &, uint32_t, CpuHit (&)[8], uint32_t, uint32_t) const;
+    template uint32_t CpuModel::intersectPacket<16>(const CpuRayPacket<16> &, uint32_t, CpuHit (&)[16], uint32_t, uint32_t) const;
+}
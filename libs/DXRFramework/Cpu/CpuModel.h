@@ -0,0 +1,100 @@
+#pragma once
+
+#include "CpuTriangle.h"
+#include "CpuWideBvh.h"
+#include "RtGeometry.h"
+#include <memory>
+
+namespace DXRFramework
+{
+    // Node layout traversed by CpuModel. The wide layouts are collapsed from the binary hierarchy,
+    // which is released afterwards.
+    enum class CpuBvhLayout
+    {
+        Binary,
+        Wide4,
+        Wide8
+    };
+
+    // CPU counterpart of RtModel: the triangles of an RtGeometry and their bottom level hierarchy.
+    // Geometry is always opaque, any-hit shaders are not supported. With the wide layouts the leaves
+    // start on blocks of four triangles stored in the layout of the selected intersection test, in the
+    // order of the hierarchy's primitive index list.
+    class CpuModel
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CpuModel>;
+
+        // Node handles name a subtree of the hierarchy of the built layout and stay valid until the
+        // next build. Top level builders use them to open instances.
+        static const uint32_t kRootNode = 0;
+        static const uint32_t kMaxNodeChildren = 8;
+
+        static SharedPtr create(RtGeometry::SharedPtr geometry) { return SharedPtr(new CpuModel(geometry)); }
+        static SharedPtr create(const std::string &filePath) { return create(RtGeometry::import(filePath)); }
+        ~CpuModel() = default;
+
+        RtGeometry::SharedPtr getGeometry() const { return mGeometry; }
+        uint32_t getTriangleCount() const { return mGeometry->getTriangleCount(); }
+        const CpuAabb &getBounds() const { return mBounds; }
+
+        // Only the hierarchy of the layout the model was built with is kept
+        const CpuBvh &getBvh() const { return mBvh; }
+        const CpuBvh4 &getBvh4() const { return mBvh4; }
+        const CpuBvh8 &getBvh8() const { return mBvh8; }
+        CpuBvhLayout getLayout() const { return mLayout; }
+        CpuTriangleTest getTriangleTest() const { return mTriangleTest; }
+        size_t getBvhMemoryUsage() const;
+        size_t getTriangleMemoryUsage() const { return mTriangles.size() * sizeof(CpuTriangle4) + mTriangleVertices.size() * sizeof(CpuTriangleVertices4); }
+
+        // The binary layout always tests the indexed triangles with the reference Moller-Trumbore. With
+        // spatial splits a triangle can be referenced by several leaves, hits still report its index.
+        void build(const CpuBvh::BuildOptions &options = CpuBvh::BuildOptions(), CpuBvhLayout layout = CpuBvhLayout::Wide4,
+                   CpuTriangleTest triangleTest = CpuTriangleTest::MollerTrumbore);
+        bool isBuilt() const { return mBuilt; }
+
+        // Children of a node and their object space bounds, zero for leaves
+        uint32_t getNodeChildren(uint32_t node, uint32_t (&children)[kMaxNodeChildren], CpuAabb (&bounds)[kMaxNodeChildren]) const;
+
+        // Finds the closest hit in (ray.tMin, ray.tMax), or any hit with CpuRayFlagAcceptFirstHitAndEndSearch.
+        // Only the t, bary, primitiveIndex and frontFace fields of the hit are written. Below the root
+        // the search is limited to the subtree of the node, whose bounds the ray is assumed to hit.
+        bool intersect(const CpuRay &ray, uint32_t rayFlags, CpuHit &hit, uint32_t node = kRootNode) const;
+
+        // Same for the active rays of a packet, returns the lanes that found a hit. Instantiated for
+        // packets of 4, 8 and 16 rays.
+        template <uint32_t Size>
+        uint32_t intersectPacket(const CpuRayPacket<Size> &packet, uint32_t rayFlags, CpuHit (&hits)[Size],
+                                 uint32_t minActiveLanes = CpuRayPacket<Size>::kDefaultMinActiveLanes, uint32_t node = kRootNode) const;
+
+    private:
+        CpuModel(RtGeometry::SharedPtr geometry)
+            : mGeometry(geometry), mLayout(CpuBvhLayout::Binary), mTriangleTest(CpuTriangleTest::MollerTrumbore), mBuilt(false) {}
+
+        template <typename Bvh>
+        void buildTriangles(const Bvh &bvh);
+
+        template <typename Bvh>
+        static uint32_t getWideNodeChildren(const Bvh &bvh, uint32_t node, uint32_t (&children)[kMaxNodeChildren], CpuAabb (&bounds)[kMaxNodeChildren]);
+
+        bool intersectBinary(const CpuRay &ray, uint32_t rayFlags, CpuHit &hit, uint32_t node) const;
+        template <typename Bvh>
+        bool intersectWide(const Bvh &bvh, const CpuRay &ray, uint32_t rayFlags, CpuHit &hit, uint32_t node) const;
+
+        template <uint32_t Size>
+        uint32_t intersectPacketBinary(const CpuRayPacket<Size> &packet, uint32_t rayFlags, CpuHit (&hits)[Size], uint32_t minActiveLanes, uint32_t node) const;
+        template <uint32_t Size, typename Bvh>
+        uint32_t intersectPacketWide(const Bvh &bvh, const CpuRayPacket<Size> &packet, uint32_t rayFlags, CpuHit (&hits)[Size], uint32_t minActiveLanes, uint32_t node) const;
+
+        RtGeometry::SharedPtr mGeometry;
+        CpuAabb mBounds;
+        CpuBvh mBvh;
+        CpuBvh4 mBvh4;
+        CpuBvh8 mBvh8;
+        std::vector<CpuTriangle4> mTriangles;
+        std::vector<CpuTriangleVertices4> mTriangleVertices;
+        CpuBvhLayout mLayout;
+        CpuTriangleTest mTriangleTest;
+        bool mBuilt;
+    };
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace DXRFramework
+{
+    class CpuShaderContext;
+    struct CpuHit;
+
+    // CPU counterpart of RtProgram. Shaders are C++ functions; payloads are passed type erased, the
+    // same way TraceRay hands an arbitrary payload struct to the hit and miss shaders.
+    class CpuProgram
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CpuProgram>;
+
+        using RayGenShader = std::function<void(CpuShaderContext &context)>;
+        using ClosestHitShader = std::function<void(CpuShaderContext &context, void *payload, const CpuHit &hit)>;
+        using MissShader = std::function<void(CpuShaderContext &context, void *payload)>;
+
+        class Desc
+        {
+        public:
+            Desc &setRayGen(const RayGenShader &rayGen) { mRayGen = rayGen; return *this; }
+            Desc &addMiss(uint32_t missIndex, const MissShader &miss);
+            Desc &addHitGroup(uint32_t hitIndex, const ClosestHitShader &closestHit);
+        private:
+            friend class CpuProgram;
+
+            RayGenShader mRayGen;
+            std::vector<MissShader> mMiss;
+            std::vector<ClosestHitShader> mHit;
+        };
+
+        static SharedPtr create(const Desc &desc) { return SharedPtr(new CpuProgram(desc)); }
+
+        const RayGenShader &getRayGenProgram() const { return mDesc.mRayGen; }
+
+        uint32_t getHitProgramCount() const { return static_cast<uint32_t>(mDesc.mHit.size()); }
+        const ClosestHitShader &getHitProgram(uint32_t rayIndex) const { return mDesc.mHit[rayIndex]; }
+
+        uint32_t getMissProgramCount() const { return static_cast<uint32_t>(mDesc.mMiss.size()); }
+        const MissShader &getMissProgram(uint32_t rayIndex) const { return mDesc.mMiss[rayIndex]; }
+
+    private:
+        CpuProgram(const Desc &desc) : mDesc(desc) {}
+
+        Desc mDesc;
+    };
+
+    inline CpuProgram::Desc &CpuProgram::Desc::addMiss(uint32_t missIndex, const MissShader &miss)
+    {
+        if (mMiss.size() <= missIndex) {
+            mMiss.resize(missIndex + 1);
+        }
+        mMiss[missIndex] = miss;
+        return *this;
+    }
+
+    inline CpuProgram::Desc &CpuProgram::Desc::addHitGroup(uint32_t hitIndex, const ClosestHitShader &closestHit)
+    {
+        if (mHit.size() <= hitIndex) {
+            mHit.resize(hitIndex + 1);
+        }
+        mHit[hitIndex] = closestHit;
+        return *this;
+    }
+}
@@ -0,0 +1,197 @@
+#include "CpuScene.h"
+#include <queue>
+
+namespace DXRFramework
+{
+    using namespace CpuMath;
+
+    void CpuScene::addModel(CpuModel::SharedPtr model, const float3x4 &transform)
+    {
+        Instance instance;
+        instance.model = model;
+        instance.objectToWorld = transform;
+        instance.worldToObject = transform.inverse();
+        instance.hitGroupOffset = 0;
+        mInstances.push_back(instance);
+    }
+
+    static CpuAabb transformBounds(const float3x4 &transform, const CpuAabb &bounds)
+    {
+        CpuAabb result = CpuAabb::empty();
+        for (int corner = 0; corner < 8; ++corner) {
+            float3 p((corner & 1) ? bounds.upper.x : bounds.lower.x, (corner & 2) ? bounds.upper.y : bounds.lower.y, (corner & 4) ? bounds.upper.z : bounds.lower.z);
+            result.grow(transform.transformPoint(p));
+        }
+        return result;
+    }
+
+    void CpuScene::build(uint32_t hitGroupCount, const BuildOptions &options)
+    {
+        std::vector<CpuAabb> instanceBounds(mInstances.size());
+        for (size_t i = 0; i < mInstances.size(); ++i) {
+            Instance &instance = mInstances[i];
+            if (!instance.model->isBuilt()) {
+                instance.model->build();
+            }
+            instance.hitGroupOffset = static_cast<uint32_t>(i) * hitGroupCount;
+            instanceBounds[i] = transformBounds(instance.objectToWorld, instance.model->getBounds());
+        }
+
+        mInstanceRefs.resize(mInstances.size());
+        for (uint32_t i = 0; i < mInstances.size(); ++i) {
+            mInstanceRefs[i] = { i, CpuModel::kRootNode };
+        }
+        std::vector<CpuAabb> refBounds = instanceBounds;
+        if (options.rebraid) {
+            rebraid(options, instanceBounds, refBounds);
+        }
+
+        CpuBvh::BuildOptions tlasOptions;
+        tlasOptions.maxLeafSize = 1;
+        mTlas.build(refBounds, tlasOptions);
+    }
+
+    void CpuScene::rebraid(const BuildOptions &options, const std::vector<CpuAabb> &instanceBounds, std::vector<CpuAabb> &refBounds)
+    {
+        // Overlapping instances, found by brute force since scenes have few instances compared to triangles
+        std::vector<uint8_t> overlapping(mInstances.size(), 0);
+        for (size_t i = 0; i < mInstances.size(); ++i) {
+            for (size_t j = i + 1; j < mInstances.size(); ++j) {
+                CpuAabb overlap = CpuAabb::overlap(instanceBounds[i], instanceBounds[j]);
+                if (overlap.isEmpty()) {
+                    continue;
+                }
+                float area = overlap.surfaceArea();
+                overlapping[i] |= area >= options.rebraidOverlap * instanceBounds[i].surfaceArea() ? 1 : 0;
+                overlapping[j] |= area >= options.rebraidOverlap * instanceBounds[j].surfaceArea() ? 1 : 0;
+            }
+        }
+
+        using Candidate = std::pair<float, uint32_t>;
+        std::priority_queue<Candidate> candidates;
+        for (uint32_t i = 0; i < mInstances.size(); ++i) {
+            if (overlapping[i]) {
+                candidates.push({ instanceBounds[i].surfaceArea(), i });
+            }
+        }
+
+        size_t maxRefs = static_cast<size_t>(options.rebraidBudget * mInstances.size());
+        while (!candidates.empty()) {
+            uint32_t refIndex = candidates.top().second;
+            candidates.pop();
+
+            InstanceRef ref = mInstanceRefs[refIndex];
+            const Instance &instance = mInstances[ref.instanceIndex];
+            uint32_t children[CpuModel::kMaxNodeChildren];
+            CpuAabb childBounds[CpuModel::kMaxNodeChildren];
+            uint32_t childCount = instance.model->getNodeChildren(ref.node, children, childBounds);
+            if (childCount == 0) {
+                continue;
+            }
+            if (mInstanceRefs.size() + childCount - 1 > maxRefs) {
+                break;
+            }
+
+            float childArea = 0.0f;
+            for (uint32_t i = 0; i < childCount; ++i) {
+                childBounds[i] = transformBounds(instance.objectToWorld, childBounds[i]);
+                childArea += childBounds[i].surfaceArea();
+            }
+            if (childArea > options.rebraidAreaRatio * refBounds[refIndex].surfaceArea()) {
+                continue;
+            }
+
+            // The first child takes the place of the opened reference
+            for (uint32_t i = 0; i < childCount; ++i) {
+                uint32_t childIndex = i == 0 ? refIndex : static_cast<uint32_t>(mInstanceRefs.size());
+                if (i > 0) {
+                    mInstanceRefs.push_back(InstanceRef());
+                    refBounds.push_back(CpuAabb());
+                }
+                mInstanceRefs[childIndex] = { ref.instanceIndex, children[i] };
+                refBounds[childIndex] = childBounds[i];
+                candidates.push({ childBounds[i].surfaceArea(), childIndex });
+            }
+        }
+    }
+
+    bool CpuScene::traceRay(const CpuRay &ray, uint32_t rayFlags, CpuHit &hit) const
+    {
+        bool acceptFirstHit = (rayFlags & CpuRayFlagAcceptFirstHitAndEndSearch) != 0;
+        bool found = false;
+
+        float tMax = ray.tMax;
+        mTlas.traverse(ray, tMax, [&](uint32_t refIndex, float &t) {
+            const InstanceRef &ref = mInstanceRefs[refIndex];
+            const Instance &instance = mInstances[ref.instanceIndex];
+
+            // Affine transforms keep the ray parameterization, so t is the same in both spaces
+            CpuRay objectRay;
+            objectRay.origin = instance.worldToObject.transformPoint(ray.origin);
+            objectRay.direction = instance.worldToObject.transformVector(ray.direction);
+            objectRay.tMin = ray.tMin;
+            objectRay.tMax = t;
+
+            if (instance.model->intersect(objectRay, rayFlags, hit, ref.node)) {
+                hit.instanceIndex = ref.instanceIndex;
+                t = hit.t;
+                found = true;
+                return acceptFirstHit;
+            }
+            return false;
+        });
+        return found;
+    }
+
+    template <uint32_t Size>
+    uint32_t CpuScene::tracePacket(const CpuRayPacket<Size> &packet, uint32_t rayFlags, CpuHit (&hits)[Size], uint32_t minActiveLanes) const
+    {
+        bool acceptFirstHit = (rayFlags & CpuRayFlagAcceptFirstHitAndEndSearch) != 0;
+        uint32_t found = 0;
+
+        // Sparse packets are cheaper to trace one ray at a time
+        if (countbits(packet.activeMask) < minActiveLanes) {
+            for (uint32_t bits = packet.activeMask; bits; bits &= bits - 1) {
+                uint32_t lane = firstbitlow(bits);
+                found |= traceRay(packet.getRay(lane), rayFlags, hits[lane]) ? 1u << lane : 0u;
+            }
+            return found;
+        }
+
+        float tMax[Size];
+        for (uint32_t bits = packet.activeMask; bits; bits &= bits - 1) {
+            uint32_t lane = firstbitlow(bits);
+            tMax[lane] = packet.tMax[lane];
+        }
+
+        mTlas.traversePacket(packet, tMax, [&](uint32_t refIndex, uint32_t mask, float (&t)[Size]) {
+            const InstanceRef &ref = mInstanceRefs[refIndex];
+            const Instance &instance = mInstances[ref.instanceIndex];
+
+            CpuRayPacket<Size> objectPacket = {};
+            objectPacket.activeMask = mask;
+            for (uint32_t bits = mask; bits; bits &= bits - 1) {
+                uint32_t lane = firstbitlow(bits);
+                CpuRay objectRay = packet.getRay(lane);
+                objectRay.origin = instance.worldToObject.transformPoint(objectRay.origin);
+                objectRay.direction = instance.worldToObject.transformVector(objectRay.direction);
+                objectRay.tMax = t[lane];
+                objectPacket.setRay(lane, objectRay);
+            }
+
+            uint32_t hitMask = instance.model->intersectPacket(objectPacket, rayFlags, hits, minActiveLanes, ref.node);
+            for (uint32_t bits = hitMask; bits; bits &= bits - 1) {
+                uint32_t lane = firstbitlow(bits);
+                hits[lane].instanceIndex = ref.instanceIndex;
+                t[lane] = hits[lane].t;
+            }
+            found |= hitMask;
+            return acceptFirstHit ? hitMask : 0u;
+        }, minActiveLanes);
+        return found;
+    }
+
+    template uint32_t CpuScene::tracePacket<4>(const CpuRayPacket<4> &, uint32_t, CpuHit (&)[4], uint32_t) const;
+    template uint32_t CpuScene::tracePacket<8>(const CpuRayPacket<8> &, uint32_t, CpuHit (&)[8], uint32_t) const;
+    template uint32_t CpuScene::tracePacket<16>(const CpuRayPacket<16> &, uint32_t, CpuHit (&)[16], uint32_t) const;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CpuModel.h"
+
+namespace DXRFramework
+{
+    struct CpuSceneBuildOptions
+    {
+        // Rebraiding opens instances whose world bounds overlap those of other instances and lifts
+        // the upper nodes of their bottom level hierarchy into the top level one, largest first. The
+        // top level then culls and orders the parts of overlapping instances like their triangles.
+        bool rebraid = false;
+        // Top level references per instance at most, on average
+        float rebraidBudget = 8.0f;
+        // An instance qualifies when its overlap with another instance's bounds has at least this
+        // fraction of its own surface area
+        float rebraidOverlap = 0.1f;
+        // A node is opened only while the world bounds of its children have at most this much surface
+        // area in total relative to its own, the cost of testing and transforming into each of them
+        float rebraidAreaRatio = 1.5f;
+    };
+
+    // CPU counterpart of RtScene: instances of models with a top level hierarchy over them
+    class CpuScene
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CpuScene>;
+        using BuildOptions = CpuSceneBuildOptions;
+
+        static SharedPtr create() { return SharedPtr(new CpuScene()); }
+        ~CpuScene() = default;
+
+        struct Instance
+        {
+            CpuModel::SharedPtr model;
+            CpuMath::float3x4 objectToWorld;
+            CpuMath::float3x4 worldToObject;
+            uint32_t hitGroupOffset; // InstanceContributionToHitGroupIndex
+        };
+
+        // Primitive of the top level hierarchy: the subtree of an instance's model below a node
+        struct InstanceRef
+        {
+            uint32_t instanceIndex;
+            uint32_t node;
+        };
+
+        void addModel(CpuModel::SharedPtr model, const CpuMath::float3x4 &transform);
+        CpuModel::SharedPtr getModel(uint32_t index) const { return mInstances[index].model; }
+        const Instance &getInstance(uint32_t index) const { return mInstances[index]; }
+        uint32_t getNumInstances() const { return static_cast<uint32_t>(mInstances.size()); }
+        const CpuAabb &getBounds() const { return mTlas.getBounds(); }
+
+        // Builds the bottom level hierarchies that are missing and the top level one. Like RtScene,
+        // instance i uses the hit group records starting at i * hitGroupCount. Rebuilding a model
+        // invalidates the top level hierarchy until the scene is built again.
+        void build(uint32_t hitGroupCount, const BuildOptions &options = BuildOptions());
+
+        const CpuBvh &getTlas() const { return mTlas; }
+        const std::vector<InstanceRef> &getInstanceRefs() const { return mInstanceRefs; }
+
+        // World space ray query, fills in all fields of the hit
+        bool traceRay(const CpuRay &ray, uint32_t rayFlags, CpuHit &hit) const;
+
+        // Traces the active rays of a packet together, for example camera rays of a pixel block or their
+        // shadow rays. Returns the lanes that found a hit. Packets and subtrees with fewer than
+        // minActiveLanes active rays are traced one ray at a time, zero always traces packets.
+        // Instantiated for 4, 8 and 16 rays.
+        template <uint32_t Size>
+        uint32_t tracePacket(const CpuRayPacket<Size> &packet, uint32_t rayFlags, CpuHit (&hits)[Size],
+                             uint32_t minActiveLanes = CpuRayPacket<Size>::kDefaultMinActiveLanes) const;
+
+    private:
+        CpuScene() = default;
+
+        void rebraid(const BuildOptions &options, const std::vector<CpuAabb> &instanceBounds, std::vector<CpuAabb> &refBounds);
+
+        std::vector<Instance> mInstances;
+        std::vector<InstanceRef> mInstanceRefs;
+        CpuBvh mTlas;
+    };
+}
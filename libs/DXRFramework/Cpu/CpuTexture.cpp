@@ -0,0 +1,80 @@
+#include "CpuTexture.h"
+#include <cstring>
+
+namespace DXRFramework
+{
+    using namespace CpuMath;
+
+    float4 CpuTexture::sample(float2 uv, uint32_t face) const
+    {
+        float x = uv.x * mWidth - 0.5f;
+        float y = uv.y * mHeight - 0.5f;
+        float fx = std::floor(x), fy = std::floor(y);
+        float wx = x - fx, wy = y - fy;
+
+        int maxX = static_cast<int>(mWidth) - 1, maxY = static_cast<int>(mHeight) - 1;
+        int x0 = (std::min)((std::max)(static_cast<int>(fx), 0), maxX), x1 = (std::min)((std::max)(static_cast<int>(fx) + 1, 0), maxX);
+        int y0 = (std::min)((std::max)(static_cast<int>(fy), 0), maxY), y1 = (std::min)((std::max)(static_cast<int>(fy) + 1, 0), maxY);
+
+        float4 top = lerp(load(x0, y0, face), load(x1, y0, face), wx);
+        float4 bottom = lerp(load(x0, y1, face), load(x1, y1, face), wx);
+        return lerp(top, bottom, wy);
+    }
+
+    float4 CpuTexture::sampleCube(const float3 &direction) const
+    {
+        // Major axis selection as in the D3D cube addressing rules
+        float3 a = abs(direction);
+        uint32_t face;
+        float ma, sc, tc;
+        if (a.x >= a.y && a.x >= a.z) {
+            face = direction.x >= 0.0f ? 0 : 1;
+            ma = a.x;
+            sc = direction.x >= 0.0f ? -direction.z : direction.z;
+            tc = -direction.y;
+        } else if (a.y >= a.z) {
+            face = direction.y >= 0.0f ? 2 : 3;
+            ma = a.y;
+            sc = direction.x;
+            tc = direction.y >= 0.0f ? direction.z : -direction.z;
+        } else {
+            face = direction.z >= 0.0f ? 4 : 5;
+            ma = a.z;
+            sc = direction.z >= 0.0f ? direction.x : -direction.x;
+            tc = -direction.y;
+        }
+        if (!mCubemap) {
+            face = 0;
+        }
+        return sample(float2(0.5f * (sc / ma + 1.0f), 0.5f * (tc / ma + 1.0f)), face);
+    }
+
+    CpuTileBuffer::CpuTileBuffer(uint32_t width, uint32_t height, uint32_t tileSize)
+        : mWidth(width), mHeight(height), mTileSize(tileSize), mTilesX((width + tileSize - 1) / tileSize)
+    {
+        const size_t texelsPerLine = kCacheLineSize / sizeof(float4);
+        uint32_t tilesY = (height + tileSize - 1) / tileSize;
+        mTileStride = (size_t(tileSize) * tileSize + texelsPerLine - 1) / texelsPerLine * texelsPerLine;
+
+        // The vector only guarantees the alignment of a float, the slack moves the first tile to a line
+        mStorage.resize(mTileStride * mTilesX * tilesY + texelsPerLine, float4(0.0f));
+        uintptr_t address = reinterpret_cast<uintptr_t>(mStorage.data());
+        uintptr_t aligned = (address + kCacheLineSize - 1) & ~uintptr_t(kCacheLineSize - 1);
+        mTiles = reinterpret_cast<float4*>(aligned);
+    }
+
+    void CpuTileBuffer::clear()
+    {
+        std::fill(mStorage.begin(), mStorage.end(), float4(0.0f));
+    }
+
+    void CpuTileBuffer::resolve(CpuTexture &target) const
+    {
+        for (uint32_t y = 0; y < mHeight; ++y) {
+            for (uint32_t x0 = 0; x0 < mWidth; x0 += mTileSize) {
+                uint32_t count = (std::min)(mTileSize, mWidth - x0);
+                memcpy(&target.getData()[size_t(y) * mWidth + x0], &at(x0, y), count * sizeof(float4));
+            }
+        }
+    }
+}
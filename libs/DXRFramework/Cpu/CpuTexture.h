@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CpuMath.h"
+#include <memory>
+#include <vector>
+
+namespace DXRFramework
+{
+    // RGBA float texture for the CPU backend. A cubemap stores its six faces one after another in the
+    // D3D face order (+X, -X, +Y, -Y, +Z, -Z). Only the top mip is kept.
+    class CpuTexture
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CpuTexture>;
+
+        static SharedPtr create(uint32_t width, uint32_t height, bool cubemap = false) { return SharedPtr(new CpuTexture(width, height, cubemap)); }
+
+        uint32_t getWidth() const { return mWidth; }
+        uint32_t getHeight() const { return mHeight; }
+        bool isCubemap() const { return mCubemap; }
+        CpuMath::float4 *getData(uint32_t face = 0) { return &mTexels[size_t(face) * mWidth * mHeight]; }
+        const CpuMath::float4 *getData(uint32_t face = 0) const { return &mTexels[size_t(face) * mWidth * mHeight]; }
+
+        // Texture2D/RWTexture2D operator[]
+        const CpuMath::float4 &load(uint32_t x, uint32_t y, uint32_t face = 0) const { return getData(face)[size_t(y) * mWidth + x]; }
+        void store(uint32_t x, uint32_t y, const CpuMath::float4 &value) { getData()[size_t(y) * mWidth + x] = value; }
+
+        // Bilinear, clamped to the face edges
+        CpuMath::float4 sample(CpuMath::float2 uv, uint32_t face = 0) const;
+        CpuMath::float4 sampleCube(const CpuMath::float3 &direction) const;
+
+    private:
+        CpuTexture(uint32_t width, uint32_t height, bool cubemap)
+            : mWidth(width), mHeight(height), mCubemap(cubemap), mTexels(size_t(width) * height * (cubemap ? 6 : 1), CpuMath::float4(0.0f)) {}
+
+        uint32_t mWidth;
+        uint32_t mHeight;
+        bool mCubemap;
+        std::vector<CpuMath::float4> mTexels;
+    };
+
+    // RGBA float image stored tile by tile, every tile in its own block of cache lines. A thread
+    // accumulating into the tile it works on never writes to a line of a neighbouring tile, which
+    // with row-major storage is shared at the tile edges.
+    class CpuTileBuffer
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CpuTileBuffer>;
+
+        static SharedPtr create(uint32_t width, uint32_t height, uint32_t tileSize) { return SharedPtr(new CpuTileBuffer(width, height, tileSize)); }
+
+        uint32_t getWidth() const { return mWidth; }
+        uint32_t getHeight() const { return mHeight; }
+        uint32_t getTileSize() const { return mTileSize; }
+
+        CpuMath::float4 &at(uint32_t x, uint32_t y) { return mTiles[getIndex(x, y)]; }
+        const CpuMath::float4 &at(uint32_t x, uint32_t y) const { return mTiles[getIndex(x, y)]; }
+
+        void clear();
+        // Copies the image into a row-major texture of the same size
+        void resolve(CpuTexture &target) const;
+
+    private:
+        static const size_t kCacheLineSize = 64;
+
+        CpuTileBuffer(uint32_t width, uint32_t height, uint32_t tileSize);
+
+        size_t getIndex(uint32_t x, uint32_t y) const
+        {
+            size_t tile = size_t(y / mTileSize) * mTilesX + x / mTileSize;
+            return tile * mTileStride + (y % mTileSize) * mTileSize + x % mTileSize;
+        }
+
+        uint32_t mWidth;
+        uint32_t mHeight;
+        uint32_t mTileSize;
+        uint32_t mTilesX;
+        size_t mTileStride;
+        std::vector<CpuMath::float4> mStorage;
+        CpuMath::float4 *mTiles;
+    };
+}
@@ -0,0 +1,458 @@
+#pragma once
+
+#include "CpuBvh.h"
+
+namespace DXRFramework
+{
+    // Same values as D3D12_RAY_FLAGS
+    enum CpuRayFlags
+    {
+        CpuRayFlagNone = 0x0,
+        CpuRayFlagForceOpaque = 0x1,
+        CpuRayFlagAcceptFirstHitAndEndSearch = 0x4,
+        CpuRayFlagSkipClosestHitShader = 0x8,
+        CpuRayFlagCullBackFacingTriangles = 0x10,
+        CpuRayFlagCullFrontFacingTriangles = 0x20
+    };
+
+    struct CpuHit
+    {
+        float t;
+        CpuMath::float2 bary; // weights of the second and third vertex, like the HLSL built-in attributes
+        uint32_t instanceIndex;
+        uint32_t primitiveIndex;
+        bool frontFace;
+    };
+
+    enum class CpuTriangleTest
+    {
+        MollerTrumbore, // on precomputed edges and normal, fastest
+        Watertight      // Woop et al. 2013, rays through shared edges and vertices never slip through
+    };
+
+    // Four triangles in structure of arrays layout for the Moller-Trumbore kernels: the first vertex, the
+    // edges to the other two and their cross product. Unused lanes are zero, which never hits.
+    struct CpuTriangle4
+    {
+        float v0[3][4];
+        float e1[3][4];
+        float e2[3][4];
+        float normal[3][4];
+
+        void set(uint32_t lane, const CpuMath::float3 &p0, const CpuMath::float3 &p1, const CpuMath::float3 &p2)
+        {
+            CpuMath::float3 edge1 = p1 - p0, edge2 = p2 - p0, n = CpuMath::cross(edge1, edge2);
+            for (int axis = 0; axis < 3; ++axis) {
+                v0[axis][lane] = p0[axis];
+                e1[axis][lane] = edge1[axis];
+                e2[axis][lane] = edge2[axis];
+                normal[axis][lane] = n[axis];
+            }
+        }
+    };
+
+    // Four triangles for the watertight kernel. It needs the exact vertex positions: a vertex rebuilt from
+    // an edge can differ in the last bit from the same vertex of the neighbouring triangle.
+    struct CpuTriangleVertices4
+    {
+        float v[3][3][4]; // vertex, axis, lane
+
+        void set(uint32_t lane, const CpuMath::float3 &p0, const CpuMath::float3 &p1, const CpuMath::float3 &p2)
+        {
+            for (int axis = 0; axis < 3; ++axis) {
+                v[0][axis][lane] = p0[axis];
+                v[1][axis][lane] = p1[axis];
+                v[2][axis][lane] = p2[axis];
+            }
+        }
+    };
+
+    // Per lane results of the four wide kernels, u and v follow the CpuHit::bary convention
+    struct CpuTriangleHit4
+    {
+        float t[4];
+        float u[4];
+        float v[4];
+        uint32_t frontFace; // bit per lane
+
+        uint32_t closest(uint32_t mask) const
+        {
+            uint32_t best = CpuMath::firstbitlow(mask);
+            for (uint32_t bits = mask & (mask - 1); bits; bits &= bits - 1) {
+                uint32_t lane = CpuMath::firstbitlow(bits);
+                best = t[lane] < t[best] ? lane : best;
+            }
+            return best;
+        }
+
+        void getHit(uint32_t lane, CpuHit &hit) const
+        {
+            hit.t = t[lane];
+            hit.bary = CpuMath::float2(u[lane], v[lane]);
+            hit.frontFace = ((frontFace >> lane) & 1) != 0;
+        }
+    };
+
+    // Per ray setup of the watertight test: the axis permutation and shear that turn the ray direction
+    // into +z, so that the test reduces to 2D edge functions around the origin
+    struct CpuWatertightRay
+    {
+        int kx, ky, kz;
+        float sx, sy, sz;
+        CpuMath::float3 origin;
+        float tMin;
+
+        explicit CpuWatertightRay(const CpuRay &ray) : origin(ray.origin), tMin(ray.tMin)
+        {
+            CpuMath::float3 d = CpuMath::abs(ray.direction);
+            kz = d.x > d.y ? (d.x > d.z ? 0 : 2) : (d.y > d.z ? 1 : 2);
+            kx = (kz + 1) % 3;
+            ky = (kx + 1) % 3;
+            // Keeps the winding, so the sign of the determinant means the same as in Moller-Trumbore
+            if (ray.direction[kz] < 0.0f) {
+                std::swap(kx, ky);
+            }
+            sx = ray.direction[kx] / ray.direction[kz];
+            sy = ray.direction[ky] / ray.direction[kz];
+            sz = 1.0f / ray.direction[kz];
+        }
+    };
+
+    // Moller-Trumbore on one indexed triangle, the reference the wide kernels are checked against.
+    // D3D12 treats triangles that appear clockwise from the ray origin as front facing, which is a
+    // positive determinant with this edge order.
+    inline bool intersectTriangle(const CpuRay &ray, const CpuMath::float3 &v0, const CpuMath::float3 &v1, const CpuMath::float3 &v2,
+                                  uint32_t rayFlags, float tMax, CpuHit &hit)
+    {
+        using namespace CpuMath;
+
+        float3 e1 = v1 - v0;
+        float3 e2 = v2 - v0;
+        float3 p = cross(ray.direction, e2);
+        float det = dot(e1, p);
+
+        bool frontFace = det > 0.0f;
+        if ((rayFlags & CpuRayFlagCullBackFacingTriangles) && !frontFace) {
+            return false;
+        }
+        if ((rayFlags & CpuRayFlagCullFrontFacingTriangles) && frontFace) {
+            return false;
+        }
+        if (det == 0.0f) {
+            return false;
+        }
+
+        float invDet = 1.0f / det;
+        float3 s = ray.origin - v0;
+        float u = dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f) {
+            return false;
+        }
+
+        float3 q = cross(s, e1);
+        float v = dot(ray.direction, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f) {
+            return false;
+        }
+
+        float t = dot(e2, q) * invDet;
+        if (t <= ray.tMin || t >= tMax) {
+            return false;
+        }
+
+        hit.t = t;
+        hit.bary = float2(u, v);
+        hit.frontFace = frontFace;
+        return true;
+    }
+
+    // One ray against four triangles, lanes outside laneMask are ignored. Returns the lanes hit within
+    // (ray.tMin, tMax). Moller-Trumbore in terms of the normal n = e1 x e2 and c = (o - v0) x d:
+    //     det = -d.n, u = e2.c / det, v = -e1.c / det, t = (o - v0).n / det
+    // which saves the second cross product per ray and triangle.
+    inline uint32_t intersectTriangles(const CpuTriangle4 &tri, const CpuRay &ray, uint32_t rayFlags, float tMax, uint32_t laneMask, CpuTriangleHit4 &hit)
+    {
+#ifdef CPU_BVH_SSE
+        __m128 dx = _mm_set1_ps(ray.direction.x), dy = _mm_set1_ps(ray.direction.y), dz = _mm_set1_ps(ray.direction.z);
+        __m128 nx = _mm_loadu_ps(tri.normal[0]), ny = _mm_loadu_ps(tri.normal[1]), nz = _mm_loadu_ps(tri.normal[2]);
+        __m128 det = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, nx), _mm_mul_ps(dy, ny)), _mm_mul_ps(dz, nz)));
+
+        __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+        __m128 front = _mm_cmpgt_ps(det, zero);
+        __m128 valid = _mm_cmpneq_ps(det, zero);
+        if (rayFlags & CpuRayFlagCullBackFacingTriangles) {
+            valid = _mm_and_ps(valid, front);
+        }
+        if (rayFlags & CpuRayFlagCullFrontFacingTriangles) {
+            valid = _mm_andnot_ps(front, valid);
+        }
+        if (!(_mm_movemask_ps(valid) & laneMask)) {
+            return 0;
+        }
+
+        __m128 sx = _mm_sub_ps(_mm_set1_ps(ray.origin.x), _mm_loadu_ps(tri.v0[0]));
+        __m128 sy = _mm_sub_ps(_mm_set1_ps(ray.origin.y), _mm_loadu_ps(tri.v0[1]));
+        __m128 sz = _mm_sub_ps(_mm_set1_ps(ray.origin.z), _mm_loadu_ps(tri.v0[2]));
+        __m128 cx = _mm_sub_ps(_mm_mul_ps(sy, dz), _mm_mul_ps(sz, dy));
+        __m128 cy = _mm_sub_ps(_mm_mul_ps(sz, dx), _mm_mul_ps(sx, dz));
+        __m128 cz = _mm_sub_ps(_mm_mul_ps(sx, dy), _mm_mul_ps(sy, dx));
+        __m128 invDet = _mm_div_ps(one, det);
+
+        __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(tri.e2[0]), cx), _mm_mul_ps(_mm_loadu_ps(tri.e2[1]), cy)), _mm_mul_ps(_mm_loadu_ps(tri.e2[2]), cz)), invDet);
+        __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(tri.e1[0]), cx), _mm_mul_ps(_mm_loadu_ps(tri.e1[1]), cy)), _mm_mul_ps(_mm_loadu_ps(tri.e1[2]), cz)), invDet);
+        v = _mm_sub_ps(zero, v);
+        valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero)));
+        valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u, v), one));
+
+        __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, nx), _mm_mul_ps(sy, ny)), _mm_mul_ps(sz, nz)), invDet);
+        valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpgt_ps(t, _mm_set1_ps(ray.tMin)), _mm_cmplt_ps(t, _mm_set1_ps(tMax))));
+
+        _mm_storeu_ps(hit.t, t);
+        _mm_storeu_ps(hit.u, u);
+        _mm_storeu_ps(hit.v, v);
+        hit.frontFace = static_cast<uint32_t>(_mm_movemask_ps(front));
+        return static_cast<uint32_t>(_mm_movemask_ps(valid)) & laneMask;
+#else
+        using namespace CpuMath;
+
+        uint32_t hits = 0;
+        hit.frontFace = 0;
+        for (uint32_t bits = laneMask; bits; bits &= bits - 1) {
+            uint32_t lane = firstbitlow(bits);
+            float3 n(tri.normal[0][lane], tri.normal[1][lane], tri.normal[2][lane]);
+            float det = -dot(ray.direction, n);
+            bool frontFace = det > 0.0f;
+            if (det == 0.0f || ((rayFlags & CpuRayFlagCullBackFacingTriangles) && !frontFace) || ((rayFlags & CpuRayFlagCullFrontFacingTriangles) && frontFace)) {
+                continue;
+            }
+
+            float3 s = ray.origin - float3(tri.v0[0][lane], tri.v0[1][lane], tri.v0[2][lane]);
+            float3 c = cross(s, ray.direction);
+            float invDet = 1.0f / det;
+            float u = dot(float3(tri.e2[0][lane], tri.e2[1][lane], tri.e2[2][lane]), c) * invDet;
+            float v = -(dot(float3(tri.e1[0][lane], tri.e1[1][lane], tri.e1[2][lane]), c) * invDet);
+            float t = dot(s, n) * invDet;
+            if (u < 0.0f || v < 0.0f || u + v > 1.0f || t <= ray.tMin || t >= tMax) {
+                continue;
+            }
+
+            hit.t[lane] = t;
+            hit.u[lane] = u;
+            hit.v[lane] = v;
+            hit.frontFace |= (frontFace ? 1u : 0u) << lane;
+            hits |= 1u << lane;
+        }
+        return hits;
+#endif
+    }
+
+    namespace CpuTriangleDetail
+    {
+        // Edge functions of the sheared triangle. Float rounding can turn a value that is not zero
+        // into zero, which would let a ray through a shared edge miss both triangles, so those are
+        // recomputed in double precision.
+        inline void watertightEdges(float ax, float ay, float bx, float by, float cx, float cy, float &u, float &v, float &w)
+        {
+            u = cx * by - cy * bx;
+            v = ax * cy - ay * cx;
+            w = bx * ay - by * ax;
+            if (u == 0.0f || v == 0.0f || w == 0.0f) {
+                u = static_cast<float>(static_cast<double>(cx) * by - static_cast<double>(cy) * bx);
+                v = static_cast<float>(static_cast<double>(ax) * cy - static_cast<double>(ay) * cx);
+                w = static_cast<float>(static_cast<double>(bx) * ay - static_cast<double>(by) * ax);
+            }
+        }
+    }
+
+    // The same for the watertight test: Woop, Benthin and Wald, "Watertight Ray/Triangle Intersection",
+    // JCGT 2013. The barycentrics are the scaled edge functions, so u weights the second and v the third
+    // vertex as in Moller-Trumbore.
+    inline uint32_t intersectTriangles(const CpuTriangleVertices4 &tri, const CpuWatertightRay &ray, uint32_t rayFlags, float tMax, uint32_t laneMask, CpuTriangleHit4 &hit)
+    {
+        const int kx = ray.kx, ky = ray.ky, kz = ray.kz;
+#ifdef CPU_BVH_SSE
+        __m128 ox = _mm_set1_ps(ray.origin[kx]), oy = _mm_set1_ps(ray.origin[ky]), oz = _mm_set1_ps(ray.origin[kz]);
+        __m128 sx = _mm_set1_ps(ray.sx), sy = _mm_set1_ps(ray.sy), sz = _mm_set1_ps(ray.sz);
+
+        // Vertices relative to the ray origin, sheared so the ray runs along +z
+        __m128 x[3], y[3], z[3];
+        for (int i = 0; i < 3; ++i) {
+            __m128 relZ = _mm_sub_ps(_mm_loadu_ps(tri.v[i][kz]), oz);
+            x[i] = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(tri.v[i][kx]), ox), _mm_mul_ps(sx, relZ));
+            y[i] = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(tri.v[i][ky]), oy), _mm_mul_ps(sy, relZ));
+            z[i] = _mm_mul_ps(sz, relZ);
+        }
+
+        __m128 u = _mm_sub_ps(_mm_mul_ps(x[2], y[1]), _mm_mul_ps(y[2], x[1]));
+        __m128 v = _mm_sub_ps(_mm_mul_ps(x[0], y[2]), _mm_mul_ps(y[0], x[2]));
+        __m128 w = _mm_sub_ps(_mm_mul_ps(x[1], y[0]), _mm_mul_ps(y[1], x[0]));
+
+        __m128 zero = _mm_setzero_ps();
+        uint32_t zeroLanes = static_cast<uint32_t>(_mm_movemask_ps(_mm_or_ps(_mm_or_ps(_mm_cmpeq_ps(u, zero), _mm_cmpeq_ps(v, zero)), _mm_cmpeq_ps(w, zero)))) & laneMask;
+        if (zeroLanes) {
+            float xs[3][4], ys[3][4], us[4], vs[4], ws[4];
+            for (int i = 0; i < 3; ++i) {
+                _mm_storeu_ps(xs[i], x[i]);
+                _mm_storeu_ps(ys[i], y[i]);
+            }
+            _mm_storeu_ps(us, u);
+            _mm_storeu_ps(vs, v);
+            _mm_storeu_ps(ws, w);
+            for (uint32_t bits = zeroLanes; bits; bits &= bits - 1) {
+                uint32_t lane = CpuMath::firstbitlow(bits);
+                CpuTriangleDetail::watertightEdges(xs[0][lane], ys[0][lane], xs[1][lane], ys[1][lane], xs[2][lane], ys[2][lane], us[lane], vs[lane], ws[lane]);
+            }
+            u = _mm_loadu_ps(us);
+            v = _mm_loadu_ps(vs);
+            w = _mm_loadu_ps(ws);
+        }
+
+        __m128 anyNegative = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(u, zero), _mm_cmplt_ps(v, zero)), _mm_cmplt_ps(w, zero));
+        __m128 anyPositive = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(u, zero), _mm_cmpgt_ps(v, zero)), _mm_cmpgt_ps(w, zero));
+        __m128 det = _mm_add_ps(_mm_add_ps(u, v), w);
+        __m128 front = _mm_cmpgt_ps(det, zero);
+        __m128 valid = _mm_andnot_ps(_mm_and_ps(anyNegative, anyPositive), _mm_cmpneq_ps(det, zero));
+        if (rayFlags & CpuRayFlagCullBackFacingTriangles) {
+            valid = _mm_and_ps(valid, front);
+        }
+        if (rayFlags & CpuRayFlagCullFrontFacingTriangles) {
+            valid = _mm_andnot_ps(front, valid);
+        }
+        if (!(_mm_movemask_ps(valid) & laneMask)) {
+            return 0;
+        }
+
+        __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+        __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(u, z[0]), _mm_mul_ps(v, z[1])), _mm_mul_ps(w, z[2])), invDet);
+        valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpgt_ps(t, _mm_set1_ps(ray.tMin)), _mm_cmplt_ps(t, _mm_set1_ps(tMax))));
+
+        _mm_storeu_ps(hit.t, t);
+        _mm_storeu_ps(hit.u, _mm_mul_ps(v, invDet));
+        _mm_storeu_ps(hit.v, _mm_mul_ps(w, invDet));
+        hit.frontFace = static_cast<uint32_t>(_mm_movemask_ps(front));
+        return static_cast<uint32_t>(_mm_movemask_ps(valid)) & laneMask;
+#else
+        uint32_t hits = 0;
+        hit.frontFace = 0;
+        for (uint32_t bits = laneMask; bits; bits &= bits - 1) {
+            uint32_t lane = CpuMath::firstbitlow(bits);
+            float x[3], y[3], z[3];
+            for (int i = 0; i < 3; ++i) {
+                float relZ = tri.v[i][kz][lane] - ray.origin[kz];
+                x[i] = (tri.v[i][kx][lane] - ray.origin[kx]) - ray.sx * relZ;
+                y[i] = (tri.v[i][ky][lane] - ray.origin[ky]) - ray.sy * relZ;
+                z[i] = ray.sz * relZ;
+            }
+
+            float u, v, w;
+            CpuTriangleDetail::watertightEdges(x[0], y[0], x[1], y[1], x[2], y[2], u, v, w);
+            if ((u < 0.0f || v < 0.0f || w < 0.0f) && (u > 0.0f || v > 0.0f || w > 0.0f)) {
+                continue;
+            }
+            float det = u + v + w;
+            bool frontFace = det > 0.0f;
+            if (det == 0.0f || ((rayFlags & CpuRayFlagCullBackFacingTriangles) && !frontFace) || ((rayFlags & CpuRayFlagCullFrontFacingTriangles) && frontFace)) {
+                continue;
+            }
+
+            float invDet = 1.0f / det;
+            float t = (u * z[0] + v * z[1] + w * z[2]) * invDet;
+            if (t <= ray.tMin || t >= tMax) {
+                continue;
+            }
+
+            hit.t[lane] = t;
+            hit.u[lane] = v * invDet;
+            hit.v[lane] = w * invDet;
+            hit.frontFace |= (frontFace ? 1u : 0u) << lane;
+            hits |= 1u << lane;
+        }
+        return hits;
+#endif
+    }
+
+    // Four rays of a packet, starting at lane group, against one triangle of a block. Returns the rays
+    // that hit within their (tMin, tMax) interval.
+    template <uint32_t Size>
+    inline uint32_t intersectTriangle(const CpuRayPacket<Size> &packet, uint32_t group, const CpuTriangle4 &tri, uint32_t lane,
+                                      uint32_t rayFlags, const float *tMax, CpuTriangleHit4 &hit)
+    {
+#ifdef CPU_BVH_SSE
+        __m128 dx = _mm_loadu_ps(packet.direction[0] + group);
+        __m128 dy = _mm_loadu_ps(packet.direction[1] + group);
+        __m128 dz = _mm_loadu_ps(packet.direction[2] + group);
+        __m128 nx = _mm_set1_ps(tri.normal[0][lane]), ny = _mm_set1_ps(tri.normal[1][lane]), nz = _mm_set1_ps(tri.normal[2][lane]);
+        __m128 det = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, nx), _mm_mul_ps(dy, ny)), _mm_mul_ps(dz, nz)));
+
+        __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+        __m128 front = _mm_cmpgt_ps(det, zero);
+        __m128 valid = _mm_cmpneq_ps(det, zero);
+        if (rayFlags & CpuRayFlagCullBackFacingTriangles) {
+            valid = _mm_and_ps(valid, front);
+        }
+        if (rayFlags & CpuRayFlagCullFrontFacingTriangles) {
+            valid = _mm_andnot_ps(front, valid);
+        }
+        if (!_mm_movemask_ps(valid)) {
+            return 0;
+        }
+
+        __m128 sx = _mm_sub_ps(_mm_loadu_ps(packet.origin[0] + group), _mm_set1_ps(tri.v0[0][lane]));
+        __m128 sy = _mm_sub_ps(_mm_loadu_ps(packet.origin[1] + group), _mm_set1_ps(tri.v0[1][lane]));
+        __m128 sz = _mm_sub_ps(_mm_loadu_ps(packet.origin[2] + group), _mm_set1_ps(tri.v0[2][lane]));
+        __m128 cx = _mm_sub_ps(_mm_mul_ps(sy, dz), _mm_mul_ps(sz, dy));
+        __m128 cy = _mm_sub_ps(_mm_mul_ps(sz, dx), _mm_mul_ps(sx, dz));
+        __m128 cz = _mm_sub_ps(_mm_mul_ps(sx, dy), _mm_mul_ps(sy, dx));
+        __m128 invDet = _mm_div_ps(one, det);
+
+        __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.e2[0][lane]), cx), _mm_mul_ps(_mm_set1_ps(tri.e2[1][lane]), cy)), _mm_mul_ps(_mm_set1_ps(tri.e2[2][lane]), cz)), invDet);
+        __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.e1[0][lane]), cx), _mm_mul_ps(_mm_set1_ps(tri.e1[1][lane]), cy)), _mm_mul_ps(_mm_set1_ps(tri.e1[2][lane]), cz)), invDet);
+        v = _mm_sub_ps(zero, v);
+        valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero)));
+        valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u, v), one));
+
+        __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, nx), _mm_mul_ps(sy, ny)), _mm_mul_ps(sz, nz)), invDet);
+        valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpgt_ps(t, _mm_loadu_ps(packet.tMin + group)), _mm_cmplt_ps(t, _mm_loadu_ps(tMax + group))));
+
+        _mm_storeu_ps(hit.t, t);
+        _mm_storeu_ps(hit.u, u);
+        _mm_storeu_ps(hit.v, v);
+        hit.frontFace = static_cast<uint32_t>(_mm_movemask_ps(front));
+        return static_cast<uint32_t>(_mm_movemask_ps(valid));
+#else
+        using namespace CpuMath;
+
+        float3 n(tri.normal[0][lane], tri.normal[1][lane], tri.normal[2][lane]);
+        float3 v0(tri.v0[0][lane], tri.v0[1][lane], tri.v0[2][lane]);
+        float3 e1(tri.e1[0][lane], tri.e1[1][lane], tri.e1[2][lane]);
+        float3 e2(tri.e2[0][lane], tri.e2[1][lane], tri.e2[2][lane]);
+        uint32_t hits = 0;
+        hit.frontFace = 0;
+        for (uint32_t i = 0; i < 4; ++i) {
+            CpuRay ray = packet.getRay(group + i);
+            float det = -dot(ray.direction, n);
+            bool frontFace = det > 0.0f;
+            if (det == 0.0f || ((rayFlags & CpuRayFlagCullBackFacingTriangles) && !frontFace) || ((rayFlags & CpuRayFlagCullFrontFacingTriangles) && frontFace)) {
+                continue;
+            }
+
+            float3 s = ray.origin - v0;
+            float3 c = cross(s, ray.direction);
+            float invDet = 1.0f / det;
+            float u = dot(e2, c) * invDet;
+            float v = -(dot(e1, c) * invDet);
+            float t = dot(s, n) * invDet;
+            if (u < 0.0f || v < 0.0f || u + v > 1.0f || t <= ray.tMin || t >= tMax[group + i]) {
+                continue;
+            }
+
+            hit.t[i] = t;
+            hit.u[i] = u;
+            hit.v[i] = v;
+            hit.frontFace |= (frontFace ? 1u : 0u) << i;
+            hits |= 1u << i;
+        }
+        return hits;
+#endif
+    }
+}
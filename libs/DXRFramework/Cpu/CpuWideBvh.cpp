@@ -0,0 +1,127 @@
+#include "CpuWideBvh.h"
+#include <cassert>
+
+namespace DXRFramework
+{
+    using namespace CpuMath;
+
+    template <uint32_t Width>
+    const uint32_t CpuWideBvh<Width>::kInvalidPrimitive;
+
+    template <uint32_t Width>
+    void CpuWideBvh<Width>::build(const CpuBvh &binary, uint32_t leafAlignment)
+    {
+        mNodes.clear();
+        mPrimitiveIndices.clear();
+        if (binary.isEmpty()) {
+            return;
+        }
+
+        mBounds = binary.getBounds();
+        mNodes.reserve(binary.getNodes().size() / (Width - 1) + 1);
+        mPrimitiveIndices.reserve(binary.getPrimitiveIndices().size() + (leafAlignment > 1 ? binary.getNodes().size() / 2 * (leafAlignment - 1) : 0));
+        collapse(binary, 0, leafAlignment);
+        mPrimitiveIndices.shrink_to_fit();
+    }
+
+    // Grid exponent such that 255 steps cover the extent, with a little headroom for rounding
+    static int8_t gridExponent(float extent)
+    {
+        if (extent <= 0.0f) {
+            return -100;
+        }
+        int exponent;
+        std::frexp(extent * 1.0001f / 255.0f, &exponent);
+        return static_cast<int8_t>((std::max)(exponent, -100));
+    }
+
+    template <uint32_t Width>
+    uint32_t CpuWideBvh<Width>::collapse(const CpuBvh &binary, uint32_t binaryIndex, uint32_t leafAlignment)
+    {
+        const auto &binaryNodes = binary.getNodes();
+
+        // Open the child with the largest surface area until the node is full, which keeps the
+        // children of a wide node as likely to be hit as possible
+        uint32_t slots[Width];
+        uint32_t slotCount = 0;
+        if (binaryNodes[binaryIndex].isLeaf()) {
+            slots[slotCount++] = binaryIndex;
+        } else {
+            slots[slotCount++] = binaryNodes[binaryIndex].offset;
+            slots[slotCount++] = binaryNodes[binaryIndex].offset + 1;
+        }
+        while (slotCount < Width) {
+            int largest = -1;
+            float largestArea = -1.0f;
+            for (uint32_t i = 0; i < slotCount; ++i) {
+                const CpuBvh::Node &node = binaryNodes[slots[i]];
+                if (!node.isLeaf() && node.bounds.surfaceArea() > largestArea) {
+                    largest = static_cast<int>(i);
+                    largestArea = node.bounds.surfaceArea();
+                }
+            }
+            if (largest < 0) {
+                break;
+            }
+            uint32_t firstChild = binaryNodes[slots[largest]].offset;
+            slots[largest] = firstChild;
+            slots[slotCount++] = firstChild + 1;
+        }
+
+        uint32_t nodeIndex = static_cast<uint32_t>(mNodes.size());
+        mNodes.emplace_back();
+
+        Node node = {};
+        const CpuAabb &bounds = binaryNodes[binaryIndex].bounds;
+        float3 extent = bounds.extent();
+        float scale[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            node.origin[axis] = bounds.lower[axis];
+            node.exponent[axis] = gridExponent(extent[axis]);
+            scale[axis] = CpuWideBvhDetail::exponentToScale(node.exponent[axis]);
+        }
+        node.childCount = static_cast<uint8_t>(slotCount);
+
+        for (uint32_t i = 0; i < slotCount; ++i) {
+            const CpuAabb &child = binaryNodes[slots[i]].bounds;
+            for (int axis = 0; axis < 3; ++axis) {
+                // Round outwards, then correct for rounding in the float math traversal uses to decode
+                float lower = std::floor((child.lower[axis] - node.origin[axis]) / scale[axis]);
+                float upper = std::ceil((child.upper[axis] - node.origin[axis]) / scale[axis]);
+                int q0 = static_cast<int>((std::min)((std::max)(lower, 0.0f), 255.0f));
+                int q1 = static_cast<int>((std::min)((std::max)(upper, 0.0f), 255.0f));
+                while (q0 > 0 && node.origin[axis] + q0 * scale[axis] > child.lower[axis]) {
+                    --q0;
+                }
+                while (q1 < 255 && node.origin[axis] + q1 * scale[axis] < child.upper[axis]) {
+                    ++q1;
+                }
+                node.lower[axis][i] = static_cast<uint8_t>(q0);
+                node.upper[axis][i] = static_cast<uint8_t>(q1);
+            }
+        }
+
+        for (uint32_t i = 0; i < slotCount; ++i) {
+            const CpuBvh::Node &child = binaryNodes[slots[i]];
+            if (child.isLeaf()) {
+                // Leaves are copied in depth first order, padded to the alignment
+                while (mPrimitiveIndices.size() % leafAlignment) {
+                    mPrimitiveIndices.push_back(kInvalidPrimitive);
+                }
+                uint32_t offset = static_cast<uint32_t>(mPrimitiveIndices.size());
+                assert(child.count <= kMaxLeafSize && offset < (1u << kLeafCountShift));
+                const auto &binaryIndices = binary.getPrimitiveIndices();
+                mPrimitiveIndices.insert(mPrimitiveIndices.end(), binaryIndices.begin() + child.offset, binaryIndices.begin() + child.offset + child.count);
+                node.children[i] = kLeafFlag | (child.count << kLeafCountShift) | offset;
+            } else {
+                node.children[i] = collapse(binary, slots[i], leafAlignment);
+            }
+        }
+
+        mNodes[nodeIndex] = node;
+        return nodeIndex;
+    }
+
+    template class CpuWideBvh<4>;
+    template class CpuWideBvh<8>;
+}
@@ -0,0 +1,367 @@
+#pragma once
+
+#include "CpuBvh.h"
+#include <cstring>
+
+namespace DXRFramework
+{
+    // Bounding volume hierarchy with Width (4 or 8) children per node, collapsed from a binary CpuBvh.
+    // Child bounds are stored as 8-bit offsets on a power of two grid spanning the node, so a node
+    // takes 56 (BVH4) or 96 (BVH8) bytes instead of 32 per binary node, and all children of a node
+    // are tested against the ray at once with SIMD.
+    template <uint32_t Width>
+    class CpuWideBvh
+    {
+        static_assert(Width == 4 || Width == 8, "4 or 8 children per node");
+
+    public:
+        struct Node
+        {
+            float origin[3];               // lower corner of the node bounds
+            int8_t exponent[3];            // the grid spacing on each axis is 2^exponent
+            uint8_t childCount;            // children occupy the first slots
+            uint8_t lower[3][Width];       // conservative child bounds in grid units
+            uint8_t upper[3][Width];
+            uint32_t children[Width];      // inner node index or leaf encoding
+        };
+
+        static const uint32_t kWidth = Width;
+
+        // Leaves reference at most kMaxLeafSize consecutive entries of the primitive index list
+        static const uint32_t kLeafFlag = 0x80000000u;
+        static const uint32_t kLeafCountShift = 27;
+        static const uint32_t kMaxLeafSize = 15;
+
+        // Fills the gaps in the primitive index list when leaves are aligned
+        static const uint32_t kInvalidPrimitive = ~0u;
+
+        // With leafAlignment > 1 every leaf starts at a multiple of it in the primitive index list, so
+        // per primitive data stored in the same order can be loaded in aligned SIMD blocks.
+        void build(const CpuBvh &binary, uint32_t leafAlignment = 1);
+
+        const std::vector<Node> &getNodes() const { return mNodes; }
+        const std::vector<uint32_t> &getPrimitiveIndices() const { return mPrimitiveIndices; }
+        const CpuAabb &getBounds() const { return mBounds; }
+        bool isEmpty() const { return mNodes.empty(); }
+        size_t getMemoryUsage() const { return mNodes.size() * sizeof(Node) + mPrimitiveIndices.size() * sizeof(uint32_t); }
+
+        // Children of a node, given as the node index (the root is 0) or a leaf encoding like the
+        // children themselves. Returns their count, zero for leaves.
+        uint32_t getChildren(uint32_t child, uint32_t (&children)[Width], CpuAabb (&bounds)[Width]) const;
+
+        // Same contracts as CpuBvh::traverse and CpuBvh::traversePacket. The root may also be any child
+        // from getChildren, whose bounds the rays are then assumed to hit.
+        template <typename IntersectPrimitive>
+        void traverse(const CpuRay &ray, float &tMax, IntersectPrimitive &&intersectPrimitive, uint32_t root = 0) const;
+
+        template <uint32_t Size, typename IntersectPrimitive>
+        void traversePacket(const CpuRayPacket<Size> &packet, float (&tMax)[Size], IntersectPrimitive &&intersectPrimitive,
+                            uint32_t minActiveLanes = CpuRayPacket<Size>::kDefaultMinActiveLanes, uint32_t root = 0) const;
+
+        // Variants that hand whole leaves to the callback: intersectLeaf(first, count, tMax) and
+        // intersectLeaf(first, count, laneMask, tMax) receive a range of the primitive index list
+        template <typename IntersectLeaf>
+        void traverseLeaves(const CpuRay &ray, float &tMax, IntersectLeaf &&intersectLeaf, uint32_t root = 0) const;
+
+        template <uint32_t Size, typename IntersectLeaf>
+        void traversePacketLeaves(const CpuRayPacket<Size> &packet, float (&tMax)[Size], IntersectLeaf &&intersectLeaf,
+                                  uint32_t minActiveLanes = CpuRayPacket<Size>::kDefaultMinActiveLanes, uint32_t root = 0) const;
+
+    private:
+        struct StackEntry
+        {
+            uint32_t child;
+            float tEntry;
+        };
+
+        // Returns a bit per hit child and the entry distances
+        uint32_t intersectChildren(const Node &node, const CpuRayTraversal &ray, float tMin, float tMax, float (&tEntry)[Width]) const;
+        static CpuAabb getChildBounds(const Node &node, uint32_t slot);
+
+        template <typename IntersectLeaf>
+        bool traverseSubtree(uint32_t child, const CpuRayTraversal &ray, float tMin, float &tMax, IntersectLeaf &&intersectLeaf) const;
+
+        uint32_t collapse(const CpuBvh &binary, uint32_t binaryIndex, uint32_t leafAlignment);
+
+        std::vector<Node> mNodes;
+        std::vector<uint32_t> mPrimitiveIndices;
+        CpuAabb mBounds;
+    };
+
+    using CpuBvh4 = CpuWideBvh<4>;
+    using CpuBvh8 = CpuWideBvh<8>;
+
+    namespace CpuWideBvhDetail
+    {
+        inline float exponentToScale(int8_t exponent)
+        {
+            uint32_t bits = static_cast<uint32_t>(exponent + 127) << 23;
+            float scale;
+            memcpy(&scale, &bits, sizeof(float));
+            return scale;
+        }
+
+#ifdef CPU_BVH_SSE
+        // Four 8-bit grid coordinates to floats
+        inline __m128 loadQuantized4(const uint8_t *q)
+        {
+            int32_t packed;
+            memcpy(&packed, q, sizeof(packed));
+            __m128i zero = _mm_setzero_si128();
+            __m128i bytes = _mm_cvtsi32_si128(packed);
+            return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+        }
+#endif
+    }
+
+    template <uint32_t Width>
+    inline uint32_t CpuWideBvh<Width>::intersectChildren(const Node &node, const CpuRayTraversal &ray, float tMin, float tMax, float (&tEntry)[Width]) const
+    {
+        using namespace CpuWideBvhDetail;
+
+        // In grid units the slab distances are q * a + b, no dequantization needed
+        float a[3], b[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            a[axis] = exponentToScale(node.exponent[axis]) * ray.invDirection[axis];
+            b[axis] = (node.origin[axis] - ray.origin[axis]) * ray.invDirection[axis];
+        }
+
+#if defined(CPU_BVH_SSE) && defined(__AVX2__)
+        if (Width == 8) {
+            __m256 tNear = _mm256_set1_ps(tMin);
+            __m256 tFar = _mm256_set1_ps(tMax);
+            for (int axis = 0; axis < 3; ++axis) {
+                __m256 scale = _mm256_set1_ps(a[axis]);
+                __m256 offset = _mm256_set1_ps(b[axis]);
+                __m256 t0 = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(node.lower[axis])))), scale), offset);
+                __m256 t1 = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(node.upper[axis])))), scale), offset);
+                tNear = _mm256_max_ps(tNear, _mm256_min_ps(t0, t1));
+                tFar = _mm256_min_ps(tFar, _mm256_mul_ps(_mm256_max_ps(t0, t1), _mm256_set1_ps(kCpuSlabFarScale)));
+            }
+            _mm256_storeu_ps(tEntry, tNear);
+            return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ)));
+        }
+#endif
+
+#ifdef CPU_BVH_SSE
+        uint32_t mask = 0;
+        for (uint32_t lane = 0; lane < Width; lane += 4) {
+            __m128 tNear = _mm_set1_ps(tMin);
+            __m128 tFar = _mm_set1_ps(tMax);
+            for (int axis = 0; axis < 3; ++axis) {
+                __m128 scale = _mm_set1_ps(a[axis]);
+                __m128 offset = _mm_set1_ps(b[axis]);
+                __m128 t0 = _mm_add_ps(_mm_mul_ps(loadQuantized4(node.lower[axis] + lane), scale), offset);
+                __m128 t1 = _mm_add_ps(_mm_mul_ps(loadQuantized4(node.upper[axis] + lane), scale), offset);
+                tNear = _mm_max_ps(tNear, _mm_min_ps(t0, t1));
+                tFar = _mm_min_ps(tFar, _mm_mul_ps(_mm_max_ps(t0, t1), _mm_set1_ps(kCpuSlabFarScale)));
+            }
+            _mm_storeu_ps(tEntry + lane, tNear);
+            mask |= static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(tNear, tFar))) << lane;
+        }
+        return mask;
+#else
+        uint32_t mask = 0;
+        for (uint32_t lane = 0; lane < Width; ++lane) {
+            float tNear = tMin, tFar = tMax;
+            for (int axis = 0; axis < 3; ++axis) {
+                float t0 = node.lower[axis][lane] * a[axis] + b[axis];
+                float t1 = node.upper[axis][lane] * a[axis] + b[axis];
+                tNear = (std::max)(tNear, (std::min)(t0, t1));
+                tFar = (std::min)(tFar, (std::max)(t0, t1) * kCpuSlabFarScale);
+            }
+            tEntry[lane] = tNear;
+            mask |= (tNear <= tFar ? 1u : 0u) << lane;
+        }
+        return mask;
+#endif
+    }
+
+    template <uint32_t Width>
+    inline uint32_t CpuWideBvh<Width>::getChildren(uint32_t child, uint32_t (&children)[Width], CpuAabb (&bounds)[Width]) const
+    {
+        if (child & kLeafFlag) {
+            return 0;
+        }
+        const Node &node = mNodes[child];
+        for (uint32_t slot = 0; slot < node.childCount; ++slot) {
+            children[slot] = node.children[slot];
+            bounds[slot] = getChildBounds(node, slot);
+        }
+        return node.childCount;
+    }
+
+    template <uint32_t Width>
+    inline CpuAabb CpuWideBvh<Width>::getChildBounds(const Node &node, uint32_t slot)
+    {
+        CpuAabb bounds;
+        for (int axis = 0; axis < 3; ++axis) {
+            float scale = CpuWideBvhDetail::exponentToScale(node.exponent[axis]);
+            bounds.lower[axis] = node.origin[axis] + node.lower[axis][slot] * scale;
+            bounds.upper[axis] = node.origin[axis] + node.upper[axis][slot] * scale;
+        }
+        return bounds;
+    }
+
+    template <uint32_t Width>
+    template <typename IntersectPrimitive>
+    void CpuWideBvh<Width>::traverse(const CpuRay &ray, float &tMax, IntersectPrimitive &&intersectPrimitive, uint32_t root) const
+    {
+        traverseLeaves(ray, tMax, [&](uint32_t first, uint32_t count, float &t) {
+            for (uint32_t i = first; i < first + count; ++i) {
+                if (intersectPrimitive(mPrimitiveIndices[i], t)) {
+                    return true;
+                }
+            }
+            return false;
+        }, root);
+    }
+
+    template <uint32_t Width>
+    template <typename IntersectLeaf>
+    void CpuWideBvh<Width>::traverseLeaves(const CpuRay &ray, float &tMax, IntersectLeaf &&intersectLeaf, uint32_t root) const
+    {
+        if (mNodes.empty()) {
+            return;
+        }
+
+        CpuRayTraversal traversal(ray);
+        float tEntry;
+        if (root != 0 || traversal.intersect(mBounds, ray.tMin, tMax, tEntry)) {
+            traverseSubtree(root, traversal, ray.tMin, tMax, intersectLeaf);
+        }
+    }
+
+    template <uint32_t Width>
+    template <typename IntersectLeaf>
+    bool CpuWideBvh<Width>::traverseSubtree(uint32_t child, const CpuRayTraversal &ray, float tMin, float &tMax, IntersectLeaf &&intersectLeaf) const
+    {
+        StackEntry stack[CpuBvh::kMaxDepth * (Width - 1) + 1];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = { child, tMin };
+
+        while (stackSize > 0) {
+            StackEntry entry = stack[--stackSize];
+            if (entry.tEntry > tMax) {
+                continue;
+            }
+
+            if (entry.child & kLeafFlag) {
+                uint32_t offset = entry.child & ((1u << kLeafCountShift) - 1);
+                uint32_t count = (entry.child & ~kLeafFlag) >> kLeafCountShift;
+                if (intersectLeaf(offset, count, tMax)) {
+                    return true;
+                }
+                continue;
+            }
+
+            const Node &node = mNodes[entry.child];
+            float childEntry[Width];
+            uint32_t mask = intersectChildren(node, ray, tMin, tMax, childEntry) & ((1u << node.childCount) - 1);
+
+            // Push the hit children far to near so the nearest is visited next
+            uint32_t first = stackSize;
+            for (uint32_t lane = 0; lane < Width; ++lane) {
+                if (!(mask & (1u << lane))) {
+                    continue;
+                }
+                StackEntry child = { node.children[lane], childEntry[lane] };
+                uint32_t i = stackSize++;
+                while (i > first && stack[i - 1].tEntry < child.tEntry) {
+                    stack[i] = stack[i - 1];
+                    --i;
+                }
+                stack[i] = child;
+            }
+        }
+        return false;
+    }
+
+    template <uint32_t Width>
+    template <uint32_t Size, typename IntersectPrimitive>
+    void CpuWideBvh<Width>::traversePacket(const CpuRayPacket<Size> &packet, float (&tMax)[Size], IntersectPrimitive &&intersectPrimitive, uint32_t minActiveLanes, uint32_t root) const
+    {
+        traversePacketLeaves(packet, tMax, [&](uint32_t first, uint32_t count, uint32_t mask, float (&t)[Size]) {
+            uint32_t ended = 0;
+            for (uint32_t i = first; i < first + count && (mask & ~ended); ++i) {
+                ended |= intersectPrimitive(mPrimitiveIndices[i], mask & ~ended, t);
+            }
+            return ended;
+        }, minActiveLanes, root);
+    }
+
+    template <uint32_t Width>
+    template <uint32_t Size, typename IntersectLeaf>
+    void CpuWideBvh<Width>::traversePacketLeaves(const CpuRayPacket<Size> &packet, float (&tMax)[Size], IntersectLeaf &&intersectLeaf, uint32_t minActiveLanes, uint32_t root) const
+    {
+        if (mNodes.empty()) {
+            return;
+        }
+
+        CpuPacketTraversal<Size> traversal(packet);
+        float tEntry = -1e30f;
+        uint32_t rootMask = root != 0 ? packet.activeMask : traversal.intersect(mBounds, tMax, packet.activeMask, tEntry);
+        uint32_t ended = 0;
+
+        struct PacketEntry
+        {
+            uint32_t child;
+            uint32_t mask;
+            float tEntry;
+        };
+        PacketEntry stack[CpuBvh::kMaxDepth * (Width - 1) + 1];
+        uint32_t stackSize = 0;
+        if (rootMask) {
+            stack[stackSize++] = { root, rootMask, tEntry };
+        }
+
+        while (stackSize > 0) {
+            PacketEntry entry = stack[--stackSize];
+            uint32_t mask = entry.mask & ~ended;
+            float tLimit = -1e30f;
+            for (uint32_t bits = mask; bits; bits &= bits - 1) {
+                tLimit = (std::max)(tLimit, tMax[CpuMath::firstbitlow(bits)]);
+            }
+            if (!mask || entry.tEntry > tLimit) {
+                continue;
+            }
+
+            if (CpuMath::countbits(mask) < minActiveLanes) {
+                for (uint32_t bits = mask; bits; bits &= bits - 1) {
+                    uint32_t lane = CpuMath::firstbitlow(bits);
+                    uint32_t laneMask = 1u << lane;
+                    traverseSubtree(entry.child, traversal.getLane(lane), traversal.tMin[lane], tMax[lane], [&](uint32_t first, uint32_t count, float &) {
+                        return (intersectLeaf(first, count, laneMask, tMax) & laneMask) != 0;
+                    });
+                }
+                continue;
+            }
+
+            if (entry.child & kLeafFlag) {
+                uint32_t offset = entry.child & ((1u << kLeafCountShift) - 1);
+                uint32_t count = (entry.child & ~kLeafFlag) >> kLeafCountShift;
+                ended |= intersectLeaf(offset, count, mask, tMax);
+                continue;
+            }
+
+            // Children are visited in the order of their nearest ray. Only leaves get the exact per ray test.
+            const Node &node = mNodes[entry.child];
+            uint32_t first = stackSize;
+            for (uint32_t slot = 0; slot < node.childCount; ++slot) {
+                PacketEntry child = { node.children[slot], 0, 0.0f };
+                CpuAabb bounds = getChildBounds(node, slot);
+                child.mask = (child.child & kLeafFlag) ? traversal.intersect(bounds, tMax, mask, child.tEntry)
+                                                       : traversal.intersectFirst(bounds, tMax, mask, child.tEntry);
+                if (!child.mask) {
+                    continue;
+                }
+                uint32_t i = stackSize++;
+                while (i > first && stack[i - 1].tEntry < child.tEntry) {
+                    stack[i] = stack[i - 1];
+                    --i;
+                }
+                stack[i] = child;
+            }
+        }
+    }
+}
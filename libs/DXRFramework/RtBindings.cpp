@@ -69,29 +69,28 @@ namespace DXRFramework
         return true;
     }
 
-    void RtBindings::applyRtProgramVars(uint8_t *record, RtShader::SharedPtr shader, ID3D12RaytracingFallbackStateObject *rtso, RtParams::SharedPtr params)
+    void *RtBindings::getShaderIdentifier(ID3D12RaytracingFallbackStateObject *rtso, const std::string &exportName)
     {
         std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-        std::wstring entryPoint = converter.from_bytes(shader->getEntryPoint());
+        std::wstring entryPoint = converter.from_bytes(exportName);
         void *id = rtso->GetShaderIdentifier(entryPoint.c_str());
         if (!id) {
-            throw std::logic_error("Unknown shader identifier used in the SBT: " + shader->getEntryPoint());
+            throw std::logic_error("Unknown shader identifier used in the SBT: " + exportName);
         }
-        memcpy(record, id, mProgramIdentifierSize);
+        return id;
+    }
+
+    void RtBindings::applyRtProgramVars(uint8_t *record, RtShader::SharedPtr shader, const void *shaderIdentifier, RtParams::SharedPtr params)
+    {
+        memcpy(record, shaderIdentifier, mProgramIdentifierSize);
         record += mProgramIdentifierSize;
 
         params->applyRootParams(shader, record);
     }
     
-    void RtBindings::applyRtProgramVars(uint8_t *record, const RtProgram::HitGroup &hitGroup, ID3D12RaytracingFallbackStateObject *rtso, RtParams::SharedPtr params)
+    void RtBindings::applyRtProgramVars(uint8_t *record, const RtProgram::HitGroup &hitGroup, const void *shaderIdentifier, RtParams::SharedPtr params)
     {
-        std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-        std::wstring entryPoint = converter.from_bytes(hitGroup.mExportName);
-        void *id = rtso->GetShaderIdentifier(entryPoint.c_str());
-        if (!id) {
-            throw std::logic_error("Unknown shader identifier used in the SBT: " + hitGroup.mExportName);
-        }
-        memcpy(record, id, mProgramIdentifierSize);
+        memcpy(record, shaderIdentifier, mProgramIdentifierSize);
         record += mProgramIdentifierSize;
 
         params->applyRootParams(hitGroup, record);
@@ -101,21 +100,32 @@ namespace DXRFramework
     {
         auto rtso = state->getFallbackRtso();
 
+        auto rayGenProgram = mProgram->getRayGenProgram();
         uint8_t *rayGenRecord = getRayGenRecordPtr();
-        applyRtProgramVars(rayGenRecord, mProgram->getRayGenProgram(), rtso, mRayGenParams);
+        applyRtProgramVars(rayGenRecord, rayGenProgram, getShaderIdentifier(rtso, rayGenProgram->getEntryPoint()), mRayGenParams);
 
+        // Identifiers are looked up once per program, the per instance hit records are filled in
+        // parallel since every record has its own params and its own slot in the table
         UINT hitCount = mProgram->getHitProgramCount();
+        std::vector<RtProgram::HitGroup> hitGroups(hitCount);
+        std::vector<void *> hitIdentifiers(hitCount);
         for (UINT h = 0; h < hitCount; h++) {
-            UINT geometryCount = mScene->getNumInstances();
-            for (UINT i = 0; i < geometryCount; i++) {
-                uint8_t *pHitRecord = getHitRecordPtr(h, i);
-                applyRtProgramVars(pHitRecord, mProgram->getHitProgram(h), rtso, mHitParams[h][i]);
-            }
+            hitGroups[h] = mProgram->getHitProgram(h);
+            hitIdentifiers[h] = getShaderIdentifier(rtso, hitGroups[h].mExportName);
         }
+        context->getJobSystem()->parallelFor(0, mScene->getNumInstances(), 64, [&](uint32_t begin, uint32_t end) {
+            for (UINT i = begin; i < end; i++) {
+                for (UINT h = 0; h < hitCount; h++) {
+                    uint8_t *pHitRecord = getHitRecordPtr(h, i);
+                    applyRtProgramVars(pHitRecord, hitGroups[h], hitIdentifiers[h], mHitParams[h][i]);
+                }
+            }
+        });
 
         for (UINT m = 0; m < mProgram->getMissProgramCount(); m++) {
+            auto missProgram = mProgram->getMissProgram(m);
             uint8_t *pMissRecord = getMissRecordPtr(m);
-            applyRtProgramVars(pMissRecord, mProgram->getMissProgram(m), rtso, mMissParams[m]);
+            applyRtProgramVars(pMissRecord, missProgram, getShaderIdentifier(rtso, missProgram->getEntryPoint()), mMissParams[m]);
         }
 
         // Update shader table
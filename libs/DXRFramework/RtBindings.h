@@ -38,8 +38,9 @@ namespace DXRFramework
         RtBindings(RtContext::SharedPtr context, RtProgram::SharedPtr program, RtScene::SharedPtr scene); 
         bool init(RtContext::SharedPtr context);
 
-        void applyRtProgramVars(uint8_t *record, RtShader::SharedPtr shader, ID3D12RaytracingFallbackStateObject *rtso, RtParams::SharedPtr params);
-        void applyRtProgramVars(uint8_t *record, const RtProgram::HitGroup &hitGroup, ID3D12RaytracingFallbackStateObject *rtso, RtParams::SharedPtr params);
+        void *getShaderIdentifier(ID3D12RaytracingFallbackStateObject *rtso, const std::string &exportName);
+        void applyRtProgramVars(uint8_t *record, RtShader::SharedPtr shader, const void *shaderIdentifier, RtParams::SharedPtr params);
+        void applyRtProgramVars(uint8_t *record, const RtProgram::HitGroup &hitGroup, const void *shaderIdentifier, RtParams::SharedPtr params);
 
         RtProgram::SharedPtr mProgram;
         RtScene::SharedPtr mScene;
@@ -1,16 +1,17 @@
 #include "RtContext.h"
 #include "RtBindings.h"
 #include "RtState.h"
+#include <stdexcept>
 
 namespace DXRFramework
 {
-    RtContext::SharedPtr RtContext::create(ID3D12Device *device, ID3D12GraphicsCommandList *commandList, bool forceComputeFallback)
+    RtContext::SharedPtr RtContext::create(ID3D12Device *device, ID3D12GraphicsCommandList *commandList, ID3D12CommandQueue *commandQueue, bool forceComputeFallback)
     {
-        return SharedPtr(new RtContext(device, commandList, forceComputeFallback));
+        return SharedPtr(new RtContext(device, commandList, commandQueue, forceComputeFallback));
     }
 
-    RtContext::RtContext(ID3D12Device *device, ID3D12GraphicsCommandList *commandList, bool forceComputeFallback)
-        : mDevice(device), mCommandList(commandList)
+    RtContext::RtContext(ID3D12Device *device, ID3D12GraphicsCommandList *commandList, ID3D12CommandQueue *commandQueue, bool forceComputeFallback)
+        : mDevice(device), mCommandList(commandList), mCommandQueue(commandQueue), mDescriptorsAllocated(0)
     {
         // TODO: try enable experimental feature and query DXR interface
         bool isDXRDriverSupported = false;
@@ -24,14 +25,19 @@ namespace DXRFramework
             mFallbackDevice->QueryRaytracingCommandList(commandList, IID_PPV_ARGS(&mFallbackCommandList));
         }
 
-        // TODO: decide descriptor heap size
         createDescriptorHeap();
+
+        mUploadQueue = RtUploadQueue::create(device);
+        mJobSystem = RtJobSystem::create();
     }
 
     void RtContext::createDescriptorHeap()
     {
         D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc = {};
-        descriptorHeapDesc.NumDescriptors = 256;
+        // The pipelines and the denoiser take about 70 descriptors. Each model adds two for its vertex and
+        // index buffers and one for its acceleration structure on the compute fallback, the texture cache
+        // one per resident texture.
+        descriptorHeapDesc.NumDescriptors = 1024;
         descriptorHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
         descriptorHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
         descriptorHeapDesc.NodeMask = 0;
@@ -121,12 +127,12 @@ namespace DXRFramework
         return mFallbackDevice->GetWrappedPointerSimple(descriptorHeapIndex, resource->GetGPUVirtualAddress());
     }
 
-    D3D12_GPU_DESCRIPTOR_HANDLE RtContext::createBufferSRVHandle(ID3D12Resource* resource, bool rawBuffer, UINT structureStride)
+    D3D12_GPU_DESCRIPTOR_HANDLE RtContext::createBufferSRVHandle(ID3D12Resource* resource, bool rawBuffer, UINT structureStride, UINT descriptorHeapIndex)
     {
         D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = createBufferSRVDesc(resource, rawBuffer, structureStride);
 
         D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle;
-        UINT descriptorHeapIndex = allocateDescriptor(&cpuDescriptorHandle);
+        descriptorHeapIndex = allocateDescriptor(&cpuDescriptorHandle, descriptorHeapIndex);
         mDevice->CreateShaderResourceView(resource, &srvDesc, cpuDescriptorHandle);
         return getDescriptorGPUHandle(descriptorHeapIndex);
     }
@@ -171,12 +177,30 @@ namespace DXRFramework
     {
         auto descriptorHeapCpuBase = mDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
         if (descriptorIndexToUse >= mDescriptorHeap->GetDesc().NumDescriptors) {
+            std::lock_guard<std::mutex> lock(mDescriptorAllocationMutex);
+            if (mDescriptorsAllocated >= mDescriptorHeap->GetDesc().NumDescriptors) {
+                throw std::length_error("RtContext: descriptor heap is full");
+            }
             descriptorIndexToUse = mDescriptorsAllocated++;
         }
         *cpuDescriptor = CD3DX12_CPU_DESCRIPTOR_HANDLE(descriptorHeapCpuBase, descriptorIndexToUse, mDescriptorSize);
         return descriptorIndexToUse;
     }
 
+    UINT RtContext::allocateDescriptorRange(UINT count, UINT* descriptorIndices)
+    {
+        if (descriptorIndices[0] >= mDescriptorHeap->GetDesc().NumDescriptors) {
+            std::lock_guard<std::mutex> lock(mDescriptorAllocationMutex);
+            if (count > mDescriptorHeap->GetDesc().NumDescriptors - mDescriptorsAllocated) {
+                throw std::length_error("RtContext: descriptor heap is full");
+            }
+            for (UINT i = 0; i < count; ++i) {
+                descriptorIndices[i] = mDescriptorsAllocated++;
+            }
+        }
+        return descriptorIndices[0];
+    }
+
     void RtContext::transitionResource(ID3D12Resource *resource, D3D12_RESOURCE_STATES fromState, D3D12_RESOURCE_STATES toState)
     {
         D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(resource, fromState, toState);
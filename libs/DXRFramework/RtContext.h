@@ -1,6 +1,9 @@
 #pragma once
 
 #include "RtPrefix.h"
+#include "RtUploadQueue.h"
+#include "RtJobSystem.h"
+#include <mutex>
 
 namespace DXRFramework
 {
@@ -12,24 +15,38 @@ namespace DXRFramework
     public:
         using SharedPtr = std::shared_ptr<RtContext>;
 
-        static SharedPtr create(ID3D12Device *device, ID3D12GraphicsCommandList *commandList, bool forceComputeFallback);
+        static SharedPtr create(ID3D12Device *device, ID3D12GraphicsCommandList *commandList, ID3D12CommandQueue *commandQueue, bool forceComputeFallback);
         ~RtContext();
 
         ID3D12Device *getDevice() const { return mDevice; }
         ID3D12GraphicsCommandList *getCommandList() const { return mCommandList; }
+        ID3D12CommandQueue *getCommandQueue() const { return mCommandQueue; }
         ID3D12RaytracingFallbackDevice *getFallbackDevice() const { return mFallbackDevice.Get(); }
         ID3D12RaytracingFallbackCommandList *getFallbackCommandList() const { return mFallbackCommandList.Get(); }
 
         bool isUsingNativeDxr() const { return mFallbackDevice->UsingRaytracingDriver(); }
 
+        // Static resource data goes through the copy queue. Work submitted to the command queue after
+        // waitForUploads only starts once the uploads up to the fence value have landed.
+        RtUploadQueue::SharedPtr getUploadQueue() const { return mUploadQueue; }
+        void waitForUploads(UINT64 fenceValue) { mUploadQueue->waitOnQueue(mCommandQueue, fenceValue); }
+
+        // Worker threads shared by the framework's CPU work: model import, acceleration structure
+        // setup and shader table filling. Applications can run their own jobs on it as well.
+        RtJobSystem::SharedPtr getJobSystem() const { return mJobSystem; }
+
         void raytrace(std::shared_ptr<RtBindings> bindings, std::shared_ptr<RtState> state, uint32_t width, uint32_t height, uint32_t depth);
 
         void bindDescriptorHeap();
         D3D12_GPU_DESCRIPTOR_HANDLE getDescriptorGPUHandle(UINT heapIndex);
 
-        // Allocate a descriptor and return its index. 
+        // Allocate a descriptor and return its index. Safe to call from multiple threads.
+        // Throws std::length_error when the heap is full.
         // If the passed descriptorIndexToUse is valid, it will be used instead of allocating a new one.
         UINT allocateDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE* cpuDescriptor, UINT descriptorIndexToUse = UINT_MAX);
+        // Allocate count adjacent descriptors for a descriptor table and write their indices to descriptorIndices.
+        // Safe to call from multiple threads. If descriptorIndices[0] is valid, the range is reused as it is.
+        UINT allocateDescriptorRange(UINT count, UINT* descriptorIndices);
 
         // Create a wrapped pointer for the Fallback Layer path.
         WRAPPED_GPU_POINTER createBufferUAVWrappedPointer(ID3D12Resource* resource);
@@ -37,16 +54,19 @@ namespace DXRFramework
         WRAPPED_GPU_POINTER createTextureSRVWrappedPointer(ID3D12Resource* resource, bool cubemap = false);
 
         D3D12_GPU_DESCRIPTOR_HANDLE createBufferUAVHandle(ID3D12Resource* resource);
-        D3D12_GPU_DESCRIPTOR_HANDLE createBufferSRVHandle(ID3D12Resource* resource, bool rawBuffer = true, UINT structureStride = 4);
+        D3D12_GPU_DESCRIPTOR_HANDLE createBufferSRVHandle(ID3D12Resource* resource, bool rawBuffer = true, UINT structureStride = 4, UINT descriptorHeapIndex = UINT_MAX);
         D3D12_GPU_DESCRIPTOR_HANDLE createTextureSRVHandle(ID3D12Resource* resource, bool cubemap = false, UINT descriptorHeapIndex = UINT_MAX);
 
         void transitionResource(ID3D12Resource *resource, D3D12_RESOURCE_STATES fromState, D3D12_RESOURCE_STATES toState);
         void insertUAVBarrier(ID3D12Resource *resource);
     private:
-        RtContext(ID3D12Device *device, ID3D12GraphicsCommandList *commandList, bool forceComputeFallback);
+        RtContext(ID3D12Device *device, ID3D12GraphicsCommandList *commandList, ID3D12CommandQueue *commandQueue, bool forceComputeFallback);
 
         ID3D12Device *mDevice;
         ID3D12GraphicsCommandList *mCommandList;
+        ID3D12CommandQueue *mCommandQueue;
+        RtUploadQueue::SharedPtr mUploadQueue;
+        RtJobSystem::SharedPtr mJobSystem;
 
         ComPtr<ID3D12RaytracingFallbackDevice> mFallbackDevice;
         ComPtr<ID3D12RaytracingFallbackCommandList> mFallbackCommandList;
@@ -55,6 +75,7 @@ namespace DXRFramework
         ComPtr<ID3D12DescriptorHeap> mDescriptorHeap;
         UINT mDescriptorsAllocated;
         UINT mDescriptorSize;
+        std::mutex mDescriptorAllocationMutex;
 
         void createDescriptorHeap();
     };
@@ -0,0 +1,394 @@
+#include "RtEnvironmentPrefilter.h"
+#include "RtJobSystem.h"
+#include <functional>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define RT_ENVIRONMENT_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace DXRFramework
+{
+    using namespace CpuMath;
+
+    namespace
+    {
+        const float kPi = 3.14159265f;
+
+        // Rows processed by one job
+        const uint32_t kRowGrainSize = 4;
+
+        // SH basis constants of bands 0 to 2, and the clamped cosine convolution of each band
+        const float kSH0 = 0.282095f;
+        const float kSH1 = 0.488603f;
+        const float kSH2 = 1.092548f;
+        const float kSH20 = 0.315392f;
+        const float kSH22 = 0.546274f;
+        const float kBandScale[9] = { kPi, 2.0f * kPi / 3.0f, 2.0f * kPi / 3.0f, 2.0f * kPi / 3.0f,
+                                      kPi / 4.0f, kPi / 4.0f, kPi / 4.0f, kPi / 4.0f, kPi / 4.0f };
+
+        // Direction through (s, t) in [-1, 1] of a face, the inverse of the face selection of
+        // CpuTexture::sampleCube. Each component is s * x + t * y + z of one row.
+        const float kFaceAxes[6][3][3] = {
+            { { 0.0f, 0.0f, 1.0f }, { 0.0f, -1.0f, 0.0f }, { -1.0f, 0.0f, 0.0f } },
+            { { 0.0f, 0.0f, -1.0f }, { 0.0f, -1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f } },
+            { { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f } },
+            { { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, -1.0f, 0.0f } },
+            { { 1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+            { { -1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } },
+        };
+
+        float3 faceDirection(uint32_t face, float s, float t)
+        {
+            const float (*axes)[3] = kFaceAxes[face];
+            return float3(s * axes[0][0] + t * axes[0][1] + axes[0][2],
+                          s * axes[1][0] + t * axes[1][1] + axes[1][2],
+                          s * axes[2][0] + t * axes[2][1] + axes[2][2]);
+        }
+
+        // Face selection of CpuTexture::sampleCube, s and t are in [0, 1]
+        uint32_t directionToFace(const float3 &direction, float &s, float &t)
+        {
+            float3 a = abs(direction);
+            uint32_t face;
+            float ma, sc, tc;
+            if (a.x >= a.y && a.x >= a.z) {
+                face = direction.x >= 0.0f ? 0 : 1;
+                ma = a.x;
+                sc = direction.x >= 0.0f ? -direction.z : direction.z;
+                tc = -direction.y;
+            } else if (a.y >= a.z) {
+                face = direction.y >= 0.0f ? 2 : 3;
+                ma = a.y;
+                sc = direction.x;
+                tc = direction.y >= 0.0f ? direction.z : -direction.z;
+            } else {
+                face = direction.z >= 0.0f ? 4 : 5;
+                ma = a.z;
+                sc = direction.z >= 0.0f ? direction.x : -direction.x;
+                tc = -direction.y;
+            }
+            s = 0.5f * (sc / ma + 1.0f);
+            t = 0.5f * (tc / ma + 1.0f);
+            return face;
+        }
+
+        // Bilinear lookup in one level of six faces, clamped at the face edges like CpuTexture
+        float4 sampleLevel(const std::vector<float4> &faces, uint32_t size, const float3 &direction)
+        {
+            float s, t;
+            uint32_t face = directionToFace(direction, s, t);
+            float x = s * size - 0.5f;
+            float y = t * size - 0.5f;
+            float fx = std::floor(x), fy = std::floor(y);
+            float wx = x - fx, wy = y - fy;
+            int maxIndex = static_cast<int>(size) - 1;
+            uint32_t x0 = static_cast<uint32_t>((std::min)((std::max)(static_cast<int>(fx), 0), maxIndex));
+            uint32_t x1 = static_cast<uint32_t>((std::min)((std::max)(static_cast<int>(fx) + 1, 0), maxIndex));
+            uint32_t y0 = static_cast<uint32_t>((std::min)((std::max)(static_cast<int>(fy), 0), maxIndex));
+            uint32_t y1 = static_cast<uint32_t>((std::min)((std::max)(static_cast<int>(fy) + 1, 0), maxIndex));
+
+            const float4 *texels = &faces[size_t(face) * size * size];
+            float4 top = lerp(texels[y0 * size + x0], texels[y0 * size + x1], wx);
+            float4 bottom = lerp(texels[y1 * size + x0], texels[y1 * size + x1], wx);
+            return lerp(top, bottom, wy);
+        }
+
+        float4 sampleLevels(const std::vector<std::vector<float4>> &levels, uint32_t size, const float3 &direction, float lod)
+        {
+            lod = (std::min)((std::max)(lod, 0.0f), float(levels.size() - 1));
+            uint32_t level = static_cast<uint32_t>(lod);
+            float4 color = sampleLevel(levels[level], (std::max)(size >> level, 1u), direction);
+            float blend = lod - float(level);
+            if (blend > 0.0f && level + 1 < levels.size()) {
+                color = lerp(color, sampleLevel(levels[level + 1], (std::max)(size >> (level + 1), 1u), direction), blend);
+            }
+            return color;
+        }
+
+        // 2x2 box filter of every face
+        std::vector<float4> downsample(const std::vector<float4> &faces, uint32_t size)
+        {
+            uint32_t half = (std::max)(size / 2, 1u);
+            uint32_t step = size > 1 ? 2 : 1;
+            std::vector<float4> result(size_t(6) * half * half);
+            for (uint32_t face = 0; face < 6; ++face) {
+                const float4 *source = &faces[size_t(face) * size * size];
+                float4 *target = &result[size_t(face) * half * half];
+                for (uint32_t y = 0; y < half; ++y) {
+                    for (uint32_t x = 0; x < half; ++x) {
+                        uint32_t sx = x * step, sy = y * step;
+                        uint32_t nx = (std::min)(sx + 1, size - 1), ny = (std::min)(sy + 1, size - 1);
+                        target[y * half + x] = (source[sy * size + sx] + source[sy * size + nx] + source[ny * size + sx] + source[ny * size + nx]) * 0.25f;
+                    }
+                }
+            }
+            return result;
+        }
+
+        float radicalInverse(uint32_t bits)
+        {
+            bits = (bits << 16u) | (bits >> 16u);
+            bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+            bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+            bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+            bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+            return float(bits) * 2.3283064365386963e-10f;
+        }
+
+        // Light direction of a GGX sample with N = V = R, in the tangent space of N, and the source
+        // level its solid angle covers
+        struct PrefilterSample
+        {
+            float3 direction;
+            float weight;
+            float lod;
+        };
+
+        std::vector<PrefilterSample> generateSamples(float roughness, uint32_t sourceSize, uint32_t sourceLevels)
+        {
+            float alpha = (std::max)(roughness * roughness, 1e-4f);
+            float alpha2 = alpha * alpha;
+            float texelSolidAngle = 4.0f * kPi / (6.0f * sourceSize * sourceSize);
+
+            std::vector<PrefilterSample> samples;
+            for (uint32_t i = 0; i < RtEnvironmentPrefilter::kSampleCount; ++i) {
+                float u = (i + 0.5f) / RtEnvironmentPrefilter::kSampleCount;
+                float v = radicalInverse(i);
+                float phi = 2.0f * kPi * v;
+                float cosTheta = std::sqrt((1.0f - u) / (1.0f + (alpha2 - 1.0f) * u));
+                float sinTheta = std::sqrt((std::max)(1.0f - cosTheta * cosTheta, 0.0f));
+                float3 h(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+                float3 l = 2.0f * cosTheta * h - float3(0.0f, 0.0f, 1.0f);
+                if (l.z <= 0.0f) {
+                    continue;
+                }
+
+                // pdf of l is D * NoH / (4 VoH), which is D / 4 as V = N
+                float d = cosTheta * cosTheta * (alpha2 - 1.0f) + 1.0f;
+                float pdf = alpha2 / (kPi * d * d) * 0.25f;
+                float sampleSolidAngle = 1.0f / (RtEnvironmentPrefilter::kSampleCount * pdf);
+                float lod = 0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f;
+                samples.push_back({ l, l.z, (std::min)((std::max)(lod, 0.0f), float(sourceLevels - 1)) });
+            }
+            return samples;
+        }
+
+        void evaluateBasis(const float3 &n, float basis[9])
+        {
+            basis[0] = kSH0;
+            basis[1] = kSH1 * n.y;
+            basis[2] = kSH1 * n.z;
+            basis[3] = kSH1 * n.x;
+            basis[4] = kSH2 * n.x * n.y;
+            basis[5] = kSH2 * n.y * n.z;
+            basis[6] = kSH20 * (3.0f * n.z * n.z - 1.0f);
+            basis[7] = kSH2 * n.x * n.z;
+            basis[8] = kSH22 * (n.x * n.x - n.y * n.y);
+        }
+
+        // Radiance times solid angle of one row of a face added to sums, 27 colors then the solid angle
+        void projectRowScalar(const float4 *row, uint32_t size, uint32_t face, float t, uint32_t first, double sums[28])
+        {
+            float texelArea = (2.0f / size) * (2.0f / size);
+            for (uint32_t x = first; x < size; ++x) {
+                float s = 2.0f * (x + 0.5f) / size - 1.0f;
+                float3 direction = faceDirection(face, s, t);
+                float invLength = 1.0f / length(direction);
+                float solidAngle = texelArea * invLength * invLength * invLength;
+
+                float basis[9];
+                evaluateBasis(direction * invLength, basis);
+                float3 color = row[x].rgb() * solidAngle;
+                for (uint32_t i = 0; i < 9; ++i) {
+                    sums[i * 3 + 0] += basis[i] * color.x;
+                    sums[i * 3 + 1] += basis[i] * color.y;
+                    sums[i * 3 + 2] += basis[i] * color.z;
+                }
+                sums[27] += solidAngle;
+            }
+        }
+
+#ifdef RT_ENVIRONMENT_SSE
+        // Four texels of a row at a time, returns the first texel left for projectRowScalar
+        uint32_t projectRowSimd(const float4 *row, uint32_t size, uint32_t face, float t, double sums[28])
+        {
+            const float (*axes)[3] = kFaceAxes[face];
+            __m128 dirX0 = _mm_set1_ps(t * axes[0][1] + axes[0][2]);
+            __m128 dirY0 = _mm_set1_ps(t * axes[1][1] + axes[1][2]);
+            __m128 dirZ0 = _mm_set1_ps(t * axes[2][1] + axes[2][2]);
+            __m128 sAxisX = _mm_set1_ps(axes[0][0]), sAxisY = _mm_set1_ps(axes[1][0]), sAxisZ = _mm_set1_ps(axes[2][0]);
+            __m128 texelArea = _mm_set1_ps((2.0f / size) * (2.0f / size));
+            __m128 sStep = _mm_set1_ps(2.0f / size);
+            __m128 sOffset = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+            __m128 one = _mm_set1_ps(1.0f), three = _mm_set1_ps(3.0f);
+
+            __m128 accumulators[28];
+            for (__m128 &accumulator : accumulators) {
+                accumulator = _mm_setzero_ps();
+            }
+
+            uint32_t x = 0;
+            for (; x + 4 <= size; x += 4) {
+                __m128 s = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(_mm_set1_ps(float(x)), sOffset), sStep), one);
+                __m128 dx = _mm_add_ps(_mm_mul_ps(s, sAxisX), dirX0);
+                __m128 dy = _mm_add_ps(_mm_mul_ps(s, sAxisY), dirY0);
+                __m128 dz = _mm_add_ps(_mm_mul_ps(s, sAxisZ), dirZ0);
+                __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                __m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+                __m128 solidAngle = _mm_mul_ps(texelArea, _mm_mul_ps(invLength, _mm_mul_ps(invLength, invLength)));
+                dx = _mm_mul_ps(dx, invLength);
+                dy = _mm_mul_ps(dy, invLength);
+                dz = _mm_mul_ps(dz, invLength);
+
+                __m128 r = _mm_loadu_ps(&row[x].x);
+                __m128 g = _mm_loadu_ps(&row[x + 1].x);
+                __m128 b = _mm_loadu_ps(&row[x + 2].x);
+                __m128 a = _mm_loadu_ps(&row[x + 3].x);
+                _MM_TRANSPOSE4_PS(r, g, b, a);
+                r = _mm_mul_ps(r, solidAngle);
+                g = _mm_mul_ps(g, solidAngle);
+                b = _mm_mul_ps(b, solidAngle);
+
+                __m128 basis[9];
+                basis[0] = _mm_set1_ps(kSH0);
+                basis[1] = _mm_mul_ps(_mm_set1_ps(kSH1), dy);
+                basis[2] = _mm_mul_ps(_mm_set1_ps(kSH1), dz);
+                basis[3] = _mm_mul_ps(_mm_set1_ps(kSH1), dx);
+                basis[4] = _mm_mul_ps(_mm_set1_ps(kSH2), _mm_mul_ps(dx, dy));
+                basis[5] = _mm_mul_ps(_mm_set1_ps(kSH2), _mm_mul_ps(dy, dz));
+                basis[6] = _mm_mul_ps(_mm_set1_ps(kSH20), _mm_sub_ps(_mm_mul_ps(three, _mm_mul_ps(dz, dz)), one));
+                basis[7] = _mm_mul_ps(_mm_set1_ps(kSH2), _mm_mul_ps(dx, dz));
+                basis[8] = _mm_mul_ps(_mm_set1_ps(kSH22), _mm_sub_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+                for (uint32_t i = 0; i < 9; ++i) {
+                    accumulators[i * 3 + 0] = _mm_add_ps(accumulators[i * 3 + 0], _mm_mul_ps(basis[i], r));
+                    accumulators[i * 3 + 1] = _mm_add_ps(accumulators[i * 3 + 1], _mm_mul_ps(basis[i], g));
+                    accumulators[i * 3 + 2] = _mm_add_ps(accumulators[i * 3 + 2], _mm_mul_ps(basis[i], b));
+                }
+                accumulators[27] = _mm_add_ps(accumulators[27], solidAngle);
+            }
+
+            for (uint32_t i = 0; i < 28; ++i) {
+                float lanes[4];
+                _mm_storeu_ps(lanes, accumulators[i]);
+                sums[i] += double(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+            }
+            return x;
+        }
+#endif
+    }
+
+    RtEnvironmentPrefilter::SharedPtr RtEnvironmentPrefilter::build(const float4 *faces, uint32_t size, uint32_t mipCount, RtJobSystem *jobSystem)
+    {
+        std::shared_ptr<RtEnvironmentPrefilter> prefilter(new RtEnvironmentPrefilter(size));
+
+        auto parallelFor = [&](uint32_t count, const std::function<void(uint32_t, uint32_t)> &function) {
+            if (jobSystem) {
+                jobSystem->parallelFor(0, count, kRowGrainSize, function);
+            } else {
+                function(0, count);
+            }
+        };
+
+        // Samples of wide lobes read coarse levels of a box filtered pyramid of the source, which
+        // keeps the sample count low without aliasing
+        std::vector<std::vector<float4>> source;
+        source.emplace_back(faces, faces + size_t(6) * size * size);
+        for (uint32_t levelSize = size; levelSize > 1; levelSize /= 2) {
+            source.push_back(downsample(source.back(), levelSize));
+        }
+        uint32_t sourceLevels = static_cast<uint32_t>(source.size());
+
+        mipCount = (std::min)((std::max)(mipCount, 1u), sourceLevels);
+        prefilter->mMips.resize(mipCount);
+        prefilter->mMips[0] = source[0];
+        for (uint32_t mip = 1; mip < mipCount; ++mip) {
+            uint32_t mipSize = prefilter->getMipSize(mip);
+            std::vector<float4> &target = prefilter->mMips[mip];
+            target.resize(size_t(6) * mipSize * mipSize);
+
+            std::vector<PrefilterSample> samples = generateSamples(getMipRoughness(mip, mipCount), size, sourceLevels);
+            parallelFor(6 * mipSize, [&](uint32_t rowBegin, uint32_t rowEnd) {
+                for (uint32_t row = rowBegin; row < rowEnd; ++row) {
+                    uint32_t face = row / mipSize, y = row % mipSize;
+                    float t = 2.0f * (y + 0.5f) / mipSize - 1.0f;
+                    for (uint32_t x = 0; x < mipSize; ++x) {
+                        float3 n = normalize(faceDirection(face, 2.0f * (x + 0.5f) / mipSize - 1.0f, t));
+                        float3 up = std::fabs(n.z) < 0.999f ? float3(0.0f, 0.0f, 1.0f) : float3(1.0f, 0.0f, 0.0f);
+                        float3 tangentX = normalize(cross(up, n));
+                        float3 tangentY = cross(n, tangentX);
+
+                        float4 sum(0.0f);
+                        float weight = 0.0f;
+                        for (const PrefilterSample &sample : samples) {
+                            float3 l = tangentX * sample.direction.x + tangentY * sample.direction.y + n * sample.direction.z;
+                            sum = sum + sampleLevels(source, size, l, sample.lod) * sample.weight;
+                            weight += sample.weight;
+                        }
+                        target[(size_t(face) * mipSize + y) * mipSize + x] = weight > 0.0f ? sum / weight : float4(0.0f);
+                    }
+                }
+            });
+        }
+
+        projectIrradiance(faces, size, prefilter->mIrradiance, jobSystem);
+        return prefilter;
+    }
+
+    void RtEnvironmentPrefilter::projectIrradiance(const float4 *faces, uint32_t size, float3 coefficients[9], RtJobSystem *jobSystem, bool simd)
+    {
+        // Sums of every face are kept apart and added in a fixed order, so the result does not depend
+        // on the thread count
+        double faceSums[6][28] = {};
+        auto projectFaces = [&](uint32_t faceBegin, uint32_t faceEnd) {
+            for (uint32_t face = faceBegin; face < faceEnd; ++face) {
+                for (uint32_t y = 0; y < size; ++y) {
+                    const float4 *row = &faces[(size_t(face) * size + y) * size];
+                    float t = 2.0f * (y + 0.5f) / size - 1.0f;
+                    uint32_t first = 0;
+#ifdef RT_ENVIRONMENT_SSE
+                    if (simd) {
+                        first = projectRowSimd(row, size, face, t, faceSums[face]);
+                    }
+#endif
+                    projectRowScalar(row, size, face, t, first, faceSums[face]);
+                }
+            }
+        };
+        if (jobSystem) {
+            jobSystem->parallelFor(0, 6, 1, projectFaces);
+        } else {
+            projectFaces(0, 6);
+        }
+
+        double sums[28] = {};
+        for (uint32_t face = 0; face < 6; ++face) {
+            for (uint32_t i = 0; i < 28; ++i) {
+                sums[i] += faceSums[face][i];
+            }
+        }
+
+        // The texel solid angles add up to 4 pi up to discretization, normalizing by their sum removes it
+        double normalization = sums[27] > 0.0 ? 4.0 * kPi / sums[27] : 0.0;
+        for (uint32_t i = 0; i < 9; ++i) {
+            float scale = static_cast<float>(normalization * kBandScale[i]);
+            coefficients[i] = float3(float(sums[i * 3 + 0]), float(sums[i * 3 + 1]), float(sums[i * 3 + 2])) * scale;
+        }
+    }
+
+    float3 RtEnvironmentPrefilter::evaluateIrradiance(const float3 &normal) const
+    {
+        float basis[9];
+        evaluateBasis(normal, basis);
+        float3 irradiance(0.0f);
+        for (uint32_t i = 0; i < 9; ++i) {
+            irradiance += mIrradiance[i] * basis[i];
+        }
+        return (max)(irradiance, 0.0f);
+    }
+
+    float4 RtEnvironmentPrefilter::sample(const float3 &direction, float lod) const
+    {
+        return sampleLevels(mMips, mSize, direction, lod);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Cpu/CpuMath.h"
+#include <memory>
+#include <vector>
+
+namespace DXRFramework
+{
+    class RtJobSystem;
+
+    // Preprocessed lighting of a cubemap environment: a radiance mip chain where mip m is prefiltered
+    // with the GGX lobe of roughness getMipRoughness(m), so a miss of a rough lobe reads one texel of a
+    // low mip instead of many of the top one, and the 9 coefficient spherical harmonics of its irradiance
+    // for diffuse ambient. Shared by the GPU path, which replaces the mips of the environment texture
+    // with the chain and passes the coefficients in EnvironmentLightingParams, and the CPU backend, so
+    // it has no D3D12 dependency.
+    class RtEnvironmentPrefilter
+    {
+    public:
+        using SharedPtr = std::shared_ptr<const RtEnvironmentPrefilter>;
+
+        // GGX samples per prefiltered texel. They are drawn from a box filtered pyramid of the source at
+        // the level of their solid angle, so few are needed for a smooth result.
+        static const uint32_t kSampleCount = 64;
+
+        // faces holds the six faces of a cubemap of size x size in the D3D face order. Mip 0 is a copy of
+        // them, mips down to mipCount - 1 are prefiltered in parallel over their rows on the job system.
+        static SharedPtr build(const CpuMath::float4 *faces, uint32_t size, uint32_t mipCount, RtJobSystem *jobSystem = nullptr);
+
+        // Projects the irradiance of a cubemap on the 9 SH basis functions, convolved with the clamped
+        // cosine so that E(n) = sum c_i Y_i(n). Faces are projected in parallel, four texels at a time
+        // with SSE. The scalar path is kept as the reference of --prefilter-bench.
+        static void projectIrradiance(const CpuMath::float4 *faces, uint32_t size, CpuMath::float3 coefficients[9], RtJobSystem *jobSystem = nullptr, bool simd = true);
+
+        static float getMipRoughness(uint32_t mip, uint32_t mipCount) { return mipCount > 1 ? float(mip) / float(mipCount - 1) : 0.0f; }
+
+        uint32_t getSize() const { return mSize; }
+        uint32_t getMipCount() const { return static_cast<uint32_t>(mMips.size()); }
+        uint32_t getMipSize(uint32_t mip) const { return (std::max)(mSize >> mip, 1u); }
+        // The six faces of a mip one after another
+        const std::vector<CpuMath::float4> &getMip(uint32_t mip) const { return mMips[mip]; }
+        const CpuMath::float3 *getIrradianceCoefficients() const { return mIrradiance; }
+
+        // CPU versions of evaluateIrradianceSH and of a trilinear SampleLevel of the chain
+        CpuMath::float3 evaluateIrradiance(const CpuMath::float3 &normal) const;
+        CpuMath::float4 sample(const CpuMath::float3 &direction, float lod) const;
+
+    private:
+        RtEnvironmentPrefilter(uint32_t size) : mSize(size) {}
+
+        uint32_t mSize;
+        std::vector<std::vector<CpuMath::float4>> mMips;
+        CpuMath::float3 mIrradiance[9];
+    };
+}
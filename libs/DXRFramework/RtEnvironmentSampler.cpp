@@ -0,0 +1,249 @@
+#include "RtEnvironmentSampler.h"
+#include "RtJobSystem.h"
+#include <functional>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define RT_ENVIRONMENT_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace DXRFramework
+{
+    using namespace CpuMath;
+
+    namespace
+    {
+        const float kPi = 3.14159265f;
+
+        // Rows processed by one job
+        const uint32_t kRowGrainSize = 8;
+
+        float nonNegative(float x)
+        {
+            // Also drops NaNs
+            return x > 0.0f ? x : 0.0f;
+        }
+
+        // Mean luminance of a block of a lat-long map. Texels are added as whole RGBA vectors.
+        float blockLuminance(const float4 *texels, uint32_t width, uint32_t x0, uint32_t x1, uint32_t y0, uint32_t y1)
+        {
+#ifdef RT_ENVIRONMENT_SSE
+            __m128 sum = _mm_setzero_ps();
+            for (uint32_t y = y0; y < y1; ++y) {
+                const float *row = &texels[size_t(y) * width].x;
+                for (uint32_t x = x0; x < x1; ++x) {
+                    sum = _mm_add_ps(sum, _mm_loadu_ps(row + x * 4));
+                }
+            }
+            float rgba[4];
+            _mm_storeu_ps(rgba, sum);
+            float3 color(rgba[0], rgba[1], rgba[2]);
+#else
+            float3 color(0.0f);
+            for (uint32_t y = y0; y < y1; ++y) {
+                for (uint32_t x = x0; x < x1; ++x) {
+                    color += texels[size_t(y) * width + x].rgb();
+                }
+            }
+#endif
+            return nonNegative(luminance(color) / float((x1 - x0) * (y1 - y0)));
+        }
+
+        // Nearest texel of a cubemap, with the face selection of CpuTexture::sampleCube
+        float cubeLuminance(const float4 *texels, uint32_t size, const float3 &direction)
+        {
+            float3 a = abs(direction);
+            uint32_t face;
+            float ma, sc, tc;
+            if (a.x >= a.y && a.x >= a.z) {
+                face = direction.x >= 0.0f ? 0 : 1;
+                ma = a.x;
+                sc = direction.x >= 0.0f ? -direction.z : direction.z;
+                tc = -direction.y;
+            } else if (a.y >= a.z) {
+                face = direction.y >= 0.0f ? 2 : 3;
+                ma = a.y;
+                sc = direction.x;
+                tc = direction.y >= 0.0f ? direction.z : -direction.z;
+            } else {
+                face = direction.z >= 0.0f ? 4 : 5;
+                ma = a.z;
+                sc = direction.z >= 0.0f ? direction.x : -direction.x;
+                tc = -direction.y;
+            }
+            uint32_t x = (std::min)(static_cast<uint32_t>(0.5f * (sc / ma + 1.0f) * size), size - 1);
+            uint32_t y = (std::min)(static_cast<uint32_t>(0.5f * (tc / ma + 1.0f) * size), size - 1);
+            return nonNegative(luminance(texels[(size_t(face) * size + y) * size + x].rgb()));
+        }
+
+        // Inverse of wsVectorToLatLong
+        float3 latLongToDirection(float2 uv)
+        {
+            float phi = (2.0f * uv.x - 1.0f) * kPi;
+            float theta = uv.y * kPi;
+            float sinTheta = std::sin(theta);
+            return float3(sinTheta * std::sin(phi), std::cos(theta), -sinTheta * std::cos(phi));
+        }
+
+        // Vose's method: items below the average probability are filled up to it by one item above it.
+        // small and large are scratch space.
+        void buildAliasTable(const float *weights, uint32_t count, double sum, float pdfScale, RtEnvironmentSampler::Entry *entries,
+                             std::vector<float> &scaled, std::vector<uint32_t> &small, std::vector<uint32_t> &large)
+        {
+            if (sum <= 0.0) {
+                for (uint32_t i = 0; i < count; ++i) {
+                    entries[i] = { 1.0f, i, 0.0f };
+                }
+                return;
+            }
+
+            scaled.resize(count);
+            small.clear();
+            large.clear();
+            float scale = static_cast<float>(count / sum);
+            for (uint32_t i = 0; i < count; ++i) {
+                scaled[i] = weights[i] * scale;
+                entries[i].pdf = weights[i] * pdfScale;
+                (scaled[i] < 1.0f ? small : large).push_back(i);
+            }
+
+            while (!small.empty() && !large.empty()) {
+                uint32_t less = small.back();
+                uint32_t more = large.back();
+                small.pop_back();
+                entries[less].threshold = scaled[less];
+                entries[less].alias = more;
+
+                scaled[more] = (scaled[more] + scaled[less]) - 1.0f;
+                if (scaled[more] < 1.0f) {
+                    large.pop_back();
+                    small.push_back(more);
+                }
+            }
+            // Left over by rounding, they are all close to the average
+            for (uint32_t i : small) {
+                entries[i].threshold = 1.0f;
+                entries[i].alias = i;
+            }
+            for (uint32_t i : large) {
+                entries[i].threshold = 1.0f;
+                entries[i].alias = i;
+            }
+        }
+    }
+
+    RtEnvironmentSampler::SharedPtr RtEnvironmentSampler::build(const float4 *texels, uint32_t width, uint32_t height, bool cubemap, RtJobSystem *jobSystem)
+    {
+        uint32_t tableWidth = cubemap ? (std::min)(4 * width, kMaxWidth) : (std::min)(width, kMaxWidth);
+        uint32_t tableHeight = cubemap ? tableWidth / 2 : (std::min)(height, kMaxWidth / 2);
+        std::shared_ptr<RtEnvironmentSampler> sampler(new RtEnvironmentSampler(tableWidth, tableHeight));
+
+        auto parallelFor = [&](uint32_t count, const std::function<void(uint32_t, uint32_t)> &function) {
+            if (jobSystem) {
+                jobSystem->parallelFor(0, count, kRowGrainSize, function);
+            } else {
+                function(0, count);
+            }
+        };
+
+        // Weights of the table texels, the sin(theta) of their center accounts for their solid angle
+        std::vector<float> weights(size_t(tableWidth) * tableHeight);
+        std::vector<double> rowSums(tableHeight);
+        parallelFor(tableHeight, [&](uint32_t rowBegin, uint32_t rowEnd) {
+            for (uint32_t y = rowBegin; y < rowEnd; ++y) {
+                float sinTheta = std::sin((y + 0.5f) / tableHeight * kPi);
+                float *rowWeights = &weights[size_t(y) * tableWidth];
+                for (uint32_t x = 0; x < tableWidth; ++x) {
+                    float texelLuminance = 0.0f;
+                    if (cubemap) {
+                        // 2x2 directions per texel
+                        for (uint32_t s = 0; s < 4; ++s) {
+                            float2 uv((x + 0.25f + 0.5f * (s & 1)) / tableWidth, (y + 0.25f + 0.5f * (s >> 1)) / tableHeight);
+                            texelLuminance += 0.25f * cubeLuminance(texels, width, latLongToDirection(uv));
+                        }
+                    } else {
+                        uint32_t x0 = uint32_t(uint64_t(x) * width / tableWidth), x1 = uint32_t(uint64_t(x + 1) * width / tableWidth);
+                        uint32_t y0 = uint32_t(uint64_t(y) * height / tableHeight), y1 = uint32_t(uint64_t(y + 1) * height / tableHeight);
+                        texelLuminance = blockLuminance(texels, width, x0, x1, y0, y1);
+                    }
+                    rowWeights[x] = texelLuminance * sinTheta;
+                }
+
+                double sum = 0.0;
+                for (uint32_t x = 0; x < tableWidth; ++x) {
+                    sum += rowWeights[x];
+                }
+                rowSums[y] = sum;
+            }
+        });
+
+        double totalWeight = 0.0;
+        for (double sum : rowSums) {
+            totalWeight += sum;
+        }
+        if (!(totalWeight > 0.0)) {
+            return nullptr;
+        }
+
+        // Rows are independent, each range of rows has its own scratch space
+        Entry *conditional = &sampler->mTable[tableHeight];
+        float texelPdfScale = static_cast<float>(double(tableWidth) * tableHeight / totalWeight);
+        parallelFor(tableHeight, [&](uint32_t rowBegin, uint32_t rowEnd) {
+            std::vector<float> scaled;
+            std::vector<uint32_t> small, large;
+            for (uint32_t y = rowBegin; y < rowEnd; ++y) {
+                size_t offset = size_t(y) * tableWidth;
+                buildAliasTable(&weights[offset], tableWidth, rowSums[y], texelPdfScale, &conditional[offset], scaled, small, large);
+            }
+        });
+
+        std::vector<float> rowWeights(rowSums.begin(), rowSums.end());
+        std::vector<float> scaled;
+        std::vector<uint32_t> small, large;
+        buildAliasTable(rowWeights.data(), tableHeight, totalWeight, static_cast<float>(tableHeight / totalWeight), sampler->mTable.data(), scaled, small, large);
+
+        return sampler;
+    }
+
+    uint32_t RtEnvironmentSampler::sampleAliasTable(uint32_t first, uint32_t count, float &u) const
+    {
+        float scaled = u * count;
+        uint32_t index = (std::min)(static_cast<uint32_t>(scaled), count - 1);
+        float fraction = scaled - float(index);
+
+        // The fraction is reused for the position inside the chosen texel
+        const Entry &entry = mTable[first + index];
+        if (fraction < entry.threshold) {
+            u = (std::min)(fraction / entry.threshold, 0.99999994f);
+            return index;
+        }
+        u = (std::min)((fraction - entry.threshold) / (1.0f - entry.threshold), 0.99999994f);
+        return entry.alias;
+    }
+
+    float3 RtEnvironmentSampler::sample(float2 u, float &pdf) const
+    {
+        uint32_t y = sampleAliasTable(0, mHeight, u.y);
+        uint32_t x = sampleAliasTable(mHeight + y * mWidth, mWidth, u.x);
+
+        float2 uv((x + u.x) / mWidth, (y + u.y) / mHeight);
+        float3 direction = latLongToDirection(uv);
+
+        // The map from uv to directions stretches areas by 2 pi^2 sin(theta)
+        float sinTheta = std::sqrt((std::max)(1.0f - direction.y * direction.y, 0.0f));
+        pdf = sinTheta > 0.0f ? mTable[mHeight + y * mWidth + x].pdf / (2.0f * kPi * kPi * sinTheta) : 0.0f;
+        return direction;
+    }
+
+    float RtEnvironmentSampler::evaluatePdf(const float3 &direction) const
+    {
+        float3 p = normalize(direction);
+        float u = (1.0f + std::atan2(p.x, -p.z) / kPi) * 0.5f;
+        float v = std::acos((std::min)((std::max)(p.y, -1.0f), 1.0f)) / kPi;
+        uint32_t x = (std::min)(static_cast<uint32_t>(u * mWidth), mWidth - 1);
+        uint32_t y = (std::min)(static_cast<uint32_t>(v * mHeight), mHeight - 1);
+
+        float sinTheta = std::sqrt((std::max)(1.0f - p.y * p.y, 0.0f));
+        return sinTheta > 0.0f ? mTable[mHeight + y * mWidth + x].pdf / (2.0f * kPi * kPi * sinTheta) : 0.0f;
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Cpu/CpuMath.h"
+#include <memory>
+#include <vector>
+
+namespace DXRFramework
+{
+    class RtJobSystem;
+
+    // Importance sampling table of an environment map over the lat-long parameterization of
+    // wsVectorToLatLong. A row is drawn from a marginal alias table, then a texel of the row from its
+    // conditional alias table, both in constant time. Texels are weighted by luminance times sin(theta),
+    // so directions are drawn in proportion to the radiance they receive. Shared by the GPU path, which
+    // uploads the table as is for EnvironmentSampling.hlsli, and the CPU backend, so it has no D3D12
+    // dependency.
+    class RtEnvironmentSampler
+    {
+    public:
+        using SharedPtr = std::shared_ptr<const RtEnvironmentSampler>;
+
+        // Same layout as the entries read by EnvironmentSampling.hlsli
+        struct Entry
+        {
+            // An item is kept for the fractions of its slot below the threshold, the rest goes to the alias
+            float threshold;
+            uint32_t alias;
+            // Of the row relative to a uniform choice for marginal entries, of the texel in lat-long uv
+            // space for conditional ones
+            float pdf;
+        };
+
+        static const uint32_t kMaxWidth = 1024;
+
+        // texels holds a lat-long map of width x height, or the six faces of a cubemap of that size in the
+        // D3D face order. Lat-long maps wider than kMaxWidth are box filtered down, cubemaps are resampled
+        // at four times their face size. The weights are computed with SSE and the rows are built in
+        // parallel on the job system. Returns null for an environment without any radiance.
+        static SharedPtr build(const CpuMath::float4 *texels, uint32_t width, uint32_t height, bool cubemap, RtJobSystem *jobSystem = nullptr);
+
+        uint32_t getWidth() const { return mWidth; }
+        uint32_t getHeight() const { return mHeight; }
+        // getHeight() marginal entries, then getWidth() conditional entries for every row
+        const std::vector<Entry> &getTable() const { return mTable; }
+
+        // CPU versions of sampleEnvironmentDirection and evaluateEnvironmentPdf, pdfs are per solid angle
+        CpuMath::float3 sample(CpuMath::float2 u, float &pdf) const;
+        float evaluatePdf(const CpuMath::float3 &direction) const;
+
+    private:
+        RtEnvironmentSampler(uint32_t width, uint32_t height) : mWidth(width), mHeight(height), mTable(size_t(width + 1) * height) {}
+
+        uint32_t sampleAliasTable(uint32_t first, uint32_t count, float &u) const;
+
+        uint32_t mWidth;
+        uint32_t mHeight;
+        std::vector<Entry> mTable;
+    };
+}
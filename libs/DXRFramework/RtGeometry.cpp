@@ -0,0 +1,77 @@
+#include "RtGeometry.h"
+#include "RtJobSystem.h"
+#include "assimp/cimport.h"
+#include "assimp/scene.h"
+#include "assimp/postprocess.h"
+#include <cassert>
+
+namespace DXRFramework
+{
+    using namespace CpuMath;
+
+    RtGeometry::SharedPtr RtGeometry::import(const std::string &filePath, RtJobSystem *jobSystem)
+    {
+        auto flags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices | aiProcess_PreTransformVertices;
+        const aiScene *scene = aiImportFile(filePath.c_str(), flags);
+
+        auto geometry = std::make_shared<RtGeometry>();
+        auto &vertices = geometry->vertices;
+        auto &indices = geometry->indices;
+
+        if (scene) {
+            // Every mesh writes its own range of the flattened arrays
+            std::vector<uint32_t> baseVertices(scene->mNumMeshes + 1, 0);
+            std::vector<uint32_t> baseIndices(scene->mNumMeshes + 1, 0);
+            for (unsigned int meshId = 0; meshId < scene->mNumMeshes; ++meshId) {
+                baseVertices[meshId + 1] = baseVertices[meshId] + scene->mMeshes[meshId]->mNumVertices;
+                baseIndices[meshId + 1] = baseIndices[meshId] + scene->mMeshes[meshId]->mNumFaces * 3;
+            }
+            vertices.resize(baseVertices.back());
+            indices.resize(baseIndices.back());
+
+            auto flattenMeshes = [&](uint32_t meshBegin, uint32_t meshEnd) {
+                for (uint32_t meshId = meshBegin; meshId < meshEnd; ++meshId) {
+                    const auto &mesh = scene->mMeshes[meshId];
+                    uint32_t baseVertex = baseVertices[meshId];
+
+                    for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
+                        aiVector3D &position = mesh->mVertices[i];
+                        Vertex &vertex = vertices[baseVertex + i];
+                        vertex.position = float3(position.x, position.y, position.z);
+                        vertex.normal = float3(0.0f, 0.0f, 0.0f);
+                        if (mesh->HasNormals()) {
+                            aiVector3D &normal = mesh->mNormals[i];
+                            vertex.normal = float3(normal.x, normal.y, normal.z);
+                        }
+                    }
+
+                    uint32_t *meshIndices = indices.data() + baseIndices[meshId];
+                    for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
+                        const aiFace &face = mesh->mFaces[i];
+                        assert(face.mNumIndices == 3);
+                        meshIndices[i * 3 + 0] = baseVertex + face.mIndices[0];
+                        meshIndices[i * 3 + 1] = baseVertex + face.mIndices[1];
+                        meshIndices[i * 3 + 2] = baseVertex + face.mIndices[2];
+                    }
+                }
+            };
+
+            if (jobSystem) {
+                jobSystem->parallelFor(0, scene->mNumMeshes, 1, flattenMeshes);
+            } else {
+                flattenMeshes(0, scene->mNumMeshes);
+            }
+            aiReleaseImport(scene);
+        } else {
+            vertices =
+            {
+                { { 0.0f, 0.25f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+                { { 0.25f, -0.25f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+                { { -0.25f, -0.25f, 0.0f }, { 0.0f, 0.0f, 1.0f } }
+            };
+            indices = { 0, 2, 1 };
+        }
+
+        return geometry;
+    }
+}
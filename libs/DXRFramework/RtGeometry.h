@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Cpu/CpuMath.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace DXRFramework
+{
+    class RtJobSystem;
+
+    // Triangle geometry of a model file, flattened into one indexed triangle list. Shared by the GPU
+    // path (RtModel uploads it as is) and the CPU backend, so it has no D3D12 dependency.
+    struct RtGeometry
+    {
+        using SharedPtr = std::shared_ptr<const RtGeometry>;
+
+        // Same layout as the vertex buffer read by the hit shaders
+        struct Vertex
+        {
+            CpuMath::float3 position;
+            CpuMath::float3 normal;
+        };
+
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+
+        uint32_t getTriangleCount() const { return static_cast<uint32_t>(indices.size() / 3); }
+
+        // Imports all meshes of the file with pre-transformed vertices. A single triangle is returned
+        // when the file cannot be read. With a job system the meshes are flattened in parallel.
+        static SharedPtr import(const std::string &filePath, RtJobSystem *jobSystem = nullptr);
+    };
+}
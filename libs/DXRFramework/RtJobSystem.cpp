@@ -0,0 +1,216 @@
+#include "RtJobSystem.h"
+#include <chrono>
+
+namespace DXRFramework
+{
+    // Worker identity of the current thread, set for the lifetime of the worker
+    static thread_local const RtJobSystem *tJobSystem = nullptr;
+    static thread_local uint32_t tThreadIndex = 0;
+
+    RtTaskGroup::~RtTaskGroup()
+    {
+        try {
+            wait();
+        } catch (...) {
+        }
+    }
+
+    void RtTaskGroup::run(std::function<void()> job)
+    {
+        mPending.fetch_add(1);
+        mRunning.fetch_add(1);
+        mJobSystem.push({ std::move(job), this });
+    }
+
+    void RtTaskGroup::then(std::function<void()> continuation)
+    {
+        mPending.fetch_add(1);
+        std::vector<std::function<void()>> released;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mContinuations.push_back(std::move(continuation));
+            // A job that finished before the lock was taken saw no continuation
+            if (mRunning.load() == 0) {
+                released.swap(mContinuations);
+                mRunning.fetch_add(static_cast<uint32_t>(released.size()));
+            }
+        }
+        for (auto &function : released) {
+            mJobSystem.push({ std::move(function), this });
+        }
+    }
+
+    void RtTaskGroup::finishJob(std::exception_ptr exception)
+    {
+        std::vector<std::function<void()>> released;
+        if (mRunning.fetch_sub(1) == 1 || exception) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (exception && !mException) {
+                mException = exception;
+            }
+            if (mRunning.load() == 0 && !mContinuations.empty()) {
+                released.swap(mContinuations);
+                mRunning.fetch_add(static_cast<uint32_t>(released.size()));
+            }
+        }
+        for (auto &function : released) {
+            mJobSystem.push({ std::move(function), this });
+        }
+
+        // Waiters may destroy the group as soon as this reaches zero
+        mPending.fetch_sub(1);
+    }
+
+    void RtTaskGroup::wait()
+    {
+        uint32_t threadIndex = mJobSystem.getCurrentThreadIndex();
+        uint32_t idleRounds = 0;
+        while (mPending.load() != 0) {
+            if (mJobSystem.runJob(threadIndex)) {
+                idleRounds = 0;
+            } else if (++idleRounds < 64) {
+                std::this_thread::yield();
+            } else {
+                // The remaining jobs run elsewhere, possibly for a long time
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+
+        std::exception_ptr exception;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            exception = mException;
+            mException = nullptr;
+        }
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    RtJobSystem::RtJobSystem(uint32_t threadCount)
+        : mQueuedJobs(0), mSleepingThreads(0), mJobCount(0), mStealCount(0), mShutdown(false)
+    {
+        if (threadCount == 0) {
+            threadCount = (std::max)(1u, std::thread::hardware_concurrency());
+        }
+        for (uint32_t i = 0; i < threadCount; ++i) {
+            mQueues.emplace_back(new Queue());
+        }
+        for (uint32_t i = 1; i < threadCount; ++i) {
+            mThreads.emplace_back(&RtJobSystem::workerLoop, this, i);
+        }
+    }
+
+    RtJobSystem::~RtJobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            mShutdown = true;
+        }
+        mWakeup.notify_all();
+        for (auto &thread : mThreads) {
+            thread.join();
+        }
+    }
+
+    uint32_t RtJobSystem::getCurrentThreadIndex() const
+    {
+        return tJobSystem == this ? tThreadIndex : 0;
+    }
+
+    RtJobSystem::Stats RtJobSystem::getStats() const
+    {
+        Stats stats;
+        stats.jobs = mJobCount.load();
+        stats.steals = mStealCount.load();
+        return stats;
+    }
+
+    void RtJobSystem::push(Job job)
+    {
+        Queue &queue = *mQueues[getCurrentThreadIndex()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(std::move(job));
+        }
+
+        // Pairs with the sleeping thread checking mQueuedJobs after announcing itself
+        mQueuedJobs.fetch_add(1);
+        if (mSleepingThreads.load() > 0) {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            mWakeup.notify_one();
+        }
+    }
+
+    bool RtJobSystem::runJob(uint32_t threadIndex)
+    {
+        Job job;
+        bool found = false;
+        {
+            Queue &queue = *mQueues[threadIndex];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.jobs.empty()) {
+                job = std::move(queue.jobs.back());
+                queue.jobs.pop_back();
+                found = true;
+            }
+        }
+
+        // Steal from the front of the other queues, starting at a different victim on every thread
+        uint32_t queueCount = static_cast<uint32_t>(mQueues.size());
+        for (uint32_t i = 1; i < queueCount && !found; ++i) {
+            Queue &queue = *mQueues[(threadIndex + i) % queueCount];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.jobs.empty()) {
+                job = std::move(queue.jobs.front());
+                queue.jobs.pop_front();
+                found = true;
+                mStealCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if (!found) {
+            return false;
+        }
+
+        mQueuedJobs.fetch_sub(1);
+        mJobCount.fetch_add(1, std::memory_order_relaxed);
+        std::exception_ptr exception;
+        try {
+            job.function();
+        } catch (...) {
+            exception = std::current_exception();
+        }
+        job.group->finishJob(exception);
+        return true;
+    }
+
+    void RtJobSystem::workerLoop(uint32_t threadIndex)
+    {
+        tJobSystem = this;
+        tThreadIndex = threadIndex;
+
+        for (;;) {
+            if (runJob(threadIndex)) {
+                continue;
+            }
+
+            // Spin briefly, most gaps between jobs are short
+            bool found = false;
+            for (int i = 0; i < 32 && !found; ++i) {
+                std::this_thread::yield();
+                found = mQueuedJobs.load() > 0;
+            }
+            if (found) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mSleepMutex);
+            mSleepingThreads.fetch_add(1);
+            mWakeup.wait(lock, [this] { return mQueuedJobs.load() > 0 || mShutdown; });
+            mSleepingThreads.fetch_sub(1);
+            if (mShutdown) {
+                return;
+            }
+        }
+    }
+}
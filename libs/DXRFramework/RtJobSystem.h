@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DXRFramework
+{
+    class RtJobSystem;
+
+    // Jobs that are waited on together. Jobs may add more jobs to their own group or start groups of
+    // their own. The first exception thrown by a job is rethrown from wait(); the other jobs still run.
+    class RtTaskGroup
+    {
+    public:
+        explicit RtTaskGroup(RtJobSystem &jobSystem) : mJobSystem(jobSystem), mRunning(0), mPending(0) {}
+        RtTaskGroup(const RtTaskGroup &) = delete;
+        RtTaskGroup &operator=(const RtTaskGroup &) = delete;
+
+        // Waits for the jobs that are still running, exceptions are dropped
+        ~RtTaskGroup();
+
+        void run(std::function<void()> job);
+
+        // Starts the continuation as a job of the group once every job of the group has finished,
+        // including the ones they add, without blocking a thread until then.
+        void then(std::function<void()> continuation);
+
+        // Runs queued jobs of any group on the calling thread until this group is done, so waiting
+        // inside a job does not take a thread away from the pool.
+        void wait();
+        bool isDone() const { return mPending.load() == 0; }
+
+    private:
+        friend class RtJobSystem;
+
+        void finishJob(std::exception_ptr exception);
+
+        RtJobSystem &mJobSystem;
+        std::atomic<uint32_t> mRunning;  // queued and executing jobs
+        std::atomic<uint32_t> mPending;  // the same plus continuations that have not finished yet
+        std::mutex mMutex;
+        std::vector<std::function<void()>> mContinuations;
+        std::exception_ptr mException;
+    };
+
+    // Pool of worker threads that share jobs by work stealing. Every worker has its own deque; it
+    // pushes and pops jobs at the back, which keeps recently split work in its cache, while idle
+    // workers steal the oldest and usually largest jobs from the front of the others. Threads outside
+    // the pool share one more deque and take part in the work while they wait on a group. Idle workers
+    // sleep until new jobs are pushed.
+    class RtJobSystem
+    {
+    public:
+        using SharedPtr = std::shared_ptr<RtJobSystem>;
+
+        // threadCount counts the thread that waits, 0 uses one thread per hardware thread and 1 runs
+        // every job inside wait() on the calling thread
+        static SharedPtr create(uint32_t threadCount = 0) { return SharedPtr(new RtJobSystem(threadCount)); }
+
+        // All groups must be done
+        ~RtJobSystem();
+
+        uint32_t getThreadCount() const { return static_cast<uint32_t>(mThreads.size()) + 1; }
+
+        // 1 to getThreadCount() - 1 on the workers of this job system, 0 on any other thread
+        uint32_t getCurrentThreadIndex() const;
+
+        // Calls function(rangeBegin, rangeEnd) on subranges of [begin, end) of at most grainSize items
+        // in parallel and returns when all are done. Ranges are split in halves, so stolen work stays
+        // large and contiguous.
+        template <typename Function>
+        void parallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, const Function &function);
+
+        // Jobs executed and stolen since the job system was created
+        struct Stats
+        {
+            uint64_t jobs = 0;
+            uint64_t steals = 0;
+        };
+        Stats getStats() const;
+
+    private:
+        friend class RtTaskGroup;
+
+        struct Job
+        {
+            std::function<void()> function;
+            RtTaskGroup *group;
+        };
+
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+
+        RtJobSystem(uint32_t threadCount);
+
+        void push(Job job);
+        bool runJob(uint32_t threadIndex);
+        void workerLoop(uint32_t threadIndex);
+
+        // Queue 0 is shared by the threads outside the pool, queue i belongs to worker i
+        std::vector<std::unique_ptr<Queue>> mQueues;
+        std::vector<std::thread> mThreads;
+
+        std::atomic<uint32_t> mQueuedJobs;
+        std::atomic<uint32_t> mSleepingThreads;
+        std::atomic<uint64_t> mJobCount;
+        std::atomic<uint64_t> mStealCount;
+        std::mutex mSleepMutex;
+        std::condition_variable mWakeup;
+        bool mShutdown;
+    };
+
+    template <typename Function>
+    void RtJobSystem::parallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, const Function &function)
+    {
+        grainSize = (std::max)(grainSize, 1u);
+        if (end <= begin) {
+            return;
+        }
+        if (end - begin <= grainSize || mThreads.empty()) {
+            function(begin, end);
+            return;
+        }
+
+        // Hands the upper halves to the pool and keeps the lowest range
+        RtTaskGroup group(*this);
+        std::function<void(uint32_t, uint32_t)> split = [&](uint32_t first, uint32_t last) {
+            while (last - first > grainSize) {
+                uint32_t middle = first + (last - first) / 2;
+                group.run([&split, middle, last] { split(middle, last); });
+                last = middle;
+            }
+            function(first, last);
+        };
+        split(begin, end);
+        group.wait();
+    }
+}
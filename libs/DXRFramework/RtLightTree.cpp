@@ -0,0 +1,434 @@
+#include "RtLightTree.h"
+#include "RtJobSystem.h"
+#include <algorithm>
+#include <cfloat>
+#include <random>
+
+namespace DXRFramework
+{
+    using namespace CpuMath;
+
+    namespace
+    {
+        const float kPi = 3.14159265f;
+
+        const uint32_t kBinCount = 12;
+
+        // Subtrees with at most this many lights are built by one job
+        const uint32_t kMinParallelLights = 1024;
+
+        float safeSqrt(float x) { return std::sqrt((std::max)(x, 0.0f)); }
+        float safeAcos(float x) { return std::acos((std::min)((std::max)(x, -1.0f), 1.0f)); }
+
+        // cos(max(0, a - b)) and sin(max(0, a - b)) from the sines and cosines of a and b
+        float cosSubClamped(float sinA, float cosA, float sinB, float cosB)
+        {
+            return cosA > cosB ? 1.0f : cosA * cosB + sinA * sinB;
+        }
+
+        float sinSubClamped(float sinA, float cosA, float sinB, float cosB)
+        {
+            return cosA > cosB ? 0.0f : sinA * cosB - cosA * sinB;
+        }
+
+        float3 rotate(const float3 &v, const float3 &axis, float angle)
+        {
+            float c = std::cos(angle), s = std::sin(angle);
+            return v * c + cross(axis, v) * s + axis * (dot(axis, v) * (1.0f - c));
+        }
+
+        // Bounds of a set of lights while the tree is built
+        struct LightBounds
+        {
+            float3 boundsMin = float3(FLT_MAX);
+            float3 boundsMax = float3(-FLT_MAX);
+            float power = 0.0f;
+            float3 axis = float3(0.0f, 0.0f, 1.0f);
+            float cosThetaO = 2.0f; // empty cone
+            float cosThetaE = 1.0f;
+
+            bool empty() const { return cosThetaO > 1.0f; }
+        };
+
+        LightBounds lightBounds(const RtLightTree::Light &light)
+        {
+            LightBounds bounds;
+            bounds.boundsMin = light.position;
+            bounds.boundsMax = light.position;
+            // The largest intensity over all directions times 4 pi for both types, so that the
+            // importance of a leaf is proportional to the light it sends to the point
+            bounds.power = 4.0f * kPi * (std::max)(luminance(light.intensity), 0.0f);
+            if (light.type == RtLightTree::CosineLight) {
+                bounds.axis = normalize(light.direction);
+                bounds.cosThetaO = 1.0f;
+            } else {
+                bounds.cosThetaO = -1.0f;
+            }
+            bounds.cosThetaE = 0.0f;
+            return bounds;
+        }
+
+        // Smallest cone around both cones, from pbrt-v4's DirectionCone
+        void unionCone(const LightBounds &a, const LightBounds &b, float3 &axis, float &cosTheta)
+        {
+            if (a.empty() || b.empty()) {
+                axis = a.empty() ? b.axis : a.axis;
+                cosTheta = a.empty() ? b.cosThetaO : a.cosThetaO;
+                return;
+            }
+            // Cones of every direction, as soon as omni lights are among them
+            if (a.cosThetaO <= -1.0f || b.cosThetaO <= -1.0f) {
+                axis = a.axis;
+                cosTheta = -1.0f;
+                return;
+            }
+
+            float thetaA = safeAcos(a.cosThetaO);
+            float thetaB = safeAcos(b.cosThetaO);
+            float thetaD = safeAcos(dot(a.axis, b.axis));
+            if ((std::min)(thetaD + thetaB, kPi) <= thetaA) {
+                axis = a.axis;
+                cosTheta = a.cosThetaO;
+                return;
+            }
+            if ((std::min)(thetaD + thetaA, kPi) <= thetaB) {
+                axis = b.axis;
+                cosTheta = b.cosThetaO;
+                return;
+            }
+
+            float thetaO = (thetaA + thetaD + thetaB) * 0.5f;
+            float3 rotationAxis = cross(a.axis, b.axis);
+            if (thetaO >= kPi || dot(rotationAxis, rotationAxis) == 0.0f) {
+                axis = a.axis;
+                cosTheta = -1.0f;
+                return;
+            }
+            axis = normalize(rotate(a.axis, normalize(rotationAxis), thetaO - thetaA));
+            cosTheta = std::cos(thetaO);
+        }
+
+        LightBounds unionBounds(const LightBounds &a, const LightBounds &b)
+        {
+            LightBounds result;
+            result.boundsMin = (min)(a.boundsMin, b.boundsMin);
+            result.boundsMax = (max)(a.boundsMax, b.boundsMax);
+            result.power = a.power + b.power;
+            unionCone(a, b, result.axis, result.cosThetaO);
+            result.cosThetaE = (std::min)(a.cosThetaE, b.cosThetaE);
+            return result;
+        }
+
+        // Surface area orientation heuristic of Conty Estevez and Kulla, with pbrt-v4's measure of the
+        // solid angle of the cone and the regularization of thin boxes
+        float splitCost(const LightBounds &bounds, float regularization)
+        {
+            if (bounds.empty()) {
+                return 0.0f;
+            }
+            float thetaO = safeAcos(bounds.cosThetaO);
+            float thetaE = safeAcos(bounds.cosThetaE);
+            float thetaW = (std::min)(thetaO + thetaE, kPi);
+            float sinThetaO = safeSqrt(1.0f - bounds.cosThetaO * bounds.cosThetaO);
+            float orientation = 2.0f * kPi * (1.0f - bounds.cosThetaO) +
+                                kPi / 2.0f * (2.0f * thetaW * sinThetaO - std::cos(thetaO - 2.0f * thetaW) - 2.0f * thetaO * sinThetaO + bounds.cosThetaO);
+            float3 d = bounds.boundsMax - bounds.boundsMin;
+            float area = 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+            return bounds.power * orientation * area * regularization;
+        }
+
+        struct Builder
+        {
+            const std::vector<RtLightTree::Light> &lights;
+            std::vector<LightBounds> bounds;
+            std::vector<uint32_t> order;
+            std::vector<RtLightTree::Node> &nodes;
+
+            struct Task
+            {
+                uint32_t begin, end, node, depth;
+            };
+
+            Builder(const std::vector<RtLightTree::Light> &lights, std::vector<RtLightTree::Node> &nodes) : lights(lights), nodes(nodes) {}
+
+            // Builds the subtree of order[begin, end) at nodes[node]. Subtrees of up to parallelLights
+            // lights are left to the tasks. Returns the depth of the deepest leaf built.
+            uint32_t build(uint32_t begin, uint32_t end, uint32_t node, uint32_t depth, uint32_t parallelLights, std::vector<Task> *tasks)
+            {
+                if (tasks && end - begin <= parallelLights) {
+                    tasks->push_back({ begin, end, node, depth });
+                    return depth;
+                }
+
+                LightBounds total;
+                float3 centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+                for (uint32_t i = begin; i < end; ++i) {
+                    const LightBounds &b = bounds[order[i]];
+                    total = unionBounds(total, b);
+                    float3 centroid = (b.boundsMin + b.boundsMax) * 0.5f;
+                    centroidMin = (min)(centroidMin, centroid);
+                    centroidMax = (max)(centroidMax, centroid);
+                }
+
+                RtLightTree::Node &result = nodes[node];
+                result.boundsMin = total.boundsMin;
+                result.power = total.power;
+                result.boundsMax = total.boundsMax;
+                result.cosThetaO = total.cosThetaO;
+                result.axis = total.axis;
+                result.cosThetaE = total.cosThetaE;
+                result.secondChild = 0;
+                result.firstLight = begin;
+                result.lightCount = end - begin;
+                result.padding = 0;
+                if (end - begin == 1) {
+                    return depth;
+                }
+
+                uint32_t middle = split(begin, end, total, centroidMin, centroidMax);
+                uint32_t secondChild = node + 2 * (middle - begin);
+                nodes[node].secondChild = secondChild;
+                uint32_t leftDepth = build(begin, middle, node + 1, depth + 1, parallelLights, tasks);
+                uint32_t rightDepth = build(middle, end, secondChild, depth + 1, parallelLights, tasks);
+                return (std::max)(leftDepth, rightDepth);
+            }
+
+            // Partitions order[begin, end) at the cheapest bin boundary of any axis and returns the first
+            // light of the second half, or halves the range of lights that share a centroid
+            uint32_t split(uint32_t begin, uint32_t end, const LightBounds &total, const float3 &centroidMin, const float3 &centroidMax)
+            {
+                float3 extent = total.boundsMax - total.boundsMin;
+                float maxExtent = maxComponent(extent);
+                float3 centroidExtent = centroidMax - centroidMin;
+
+                float bestCost = FLT_MAX;
+                int bestAxis = -1;
+                uint32_t bestBin = 0;
+                for (int axis = 0; axis < 3; ++axis) {
+                    if (!(centroidExtent[axis] > 0.0f)) {
+                        continue;
+                    }
+
+                    LightBounds bins[kBinCount];
+                    uint32_t counts[kBinCount] = {};
+                    for (uint32_t i = begin; i < end; ++i) {
+                        const LightBounds &b = bounds[order[i]];
+                        uint32_t bin = binIndex(b, axis, centroidMin, centroidExtent);
+                        bins[bin] = unionBounds(bins[bin], b);
+                        ++counts[bin];
+                    }
+
+                    // Costs of the splits after every bin, summed from both ends
+                    LightBounds below[kBinCount];
+                    uint32_t countBelow[kBinCount];
+                    LightBounds accumulated;
+                    uint32_t count = 0;
+                    for (uint32_t bin = 0; bin < kBinCount; ++bin) {
+                        accumulated = unionBounds(accumulated, bins[bin]);
+                        count += counts[bin];
+                        below[bin] = accumulated;
+                        countBelow[bin] = count;
+                    }
+                    float regularization = extent[axis] > 0.0f ? maxExtent / extent[axis] : 1.0f;
+                    accumulated = LightBounds();
+                    for (uint32_t bin = kBinCount - 1; bin > 0; --bin) {
+                        accumulated = unionBounds(accumulated, bins[bin]);
+                        if (countBelow[bin - 1] == 0 || countBelow[bin - 1] == end - begin) {
+                            continue;
+                        }
+                        float cost = splitCost(below[bin - 1], regularization) + splitCost(accumulated, regularization);
+                        if (cost < bestCost) {
+                            bestCost = cost;
+                            bestAxis = axis;
+                            bestBin = bin;
+                        }
+                    }
+                }
+
+                if (bestAxis < 0) {
+                    return begin + (end - begin) / 2;
+                }
+                auto first = order.begin() + begin, last = order.begin() + end;
+                auto middle = std::partition(first, last, [&](uint32_t light) {
+                    return binIndex(bounds[light], bestAxis, centroidMin, centroidExtent) < bestBin;
+                });
+                return static_cast<uint32_t>(middle - order.begin());
+            }
+
+            static uint32_t binIndex(const LightBounds &b, int axis, const float3 &centroidMin, const float3 &centroidExtent)
+            {
+                float centroid = (b.boundsMin[axis] + b.boundsMax[axis]) * 0.5f;
+                uint32_t bin = static_cast<uint32_t>(kBinCount * ((centroid - centroidMin[axis]) / centroidExtent[axis]));
+                return (std::min)(bin, kBinCount - 1);
+            }
+        };
+    }
+
+    RtLightTree::SharedPtr RtLightTree::build(const std::vector<Light> &lights, RtJobSystem *jobSystem)
+    {
+        if (lights.empty()) {
+            return nullptr;
+        }
+
+        auto tree = std::shared_ptr<RtLightTree>(new RtLightTree());
+        uint32_t lightCount = static_cast<uint32_t>(lights.size());
+        tree->mNodes.resize(size_t(2) * lightCount - 1);
+
+        Builder builder(lights, tree->mNodes);
+        builder.bounds.resize(lightCount);
+        builder.order.resize(lightCount);
+        for (uint32_t i = 0; i < lightCount; ++i) {
+            builder.bounds[i] = lightBounds(lights[i]);
+            builder.order[i] = i;
+        }
+
+        // Every subtree owns a known range of nodes, 2 n - 1 for n lights, so the subtrees below the
+        // top levels are independent jobs
+        uint32_t depth;
+        if (jobSystem && lightCount > kMinParallelLights) {
+            uint32_t parallelLights = (std::max)(lightCount / (jobSystem->getThreadCount() * 8), kMinParallelLights);
+            std::vector<Builder::Task> tasks;
+            depth = builder.build(0, lightCount, 0, 0, parallelLights, &tasks);
+            std::vector<uint32_t> taskDepths(tasks.size());
+            jobSystem->parallelFor(0, static_cast<uint32_t>(tasks.size()), 1, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t i = begin; i < end; ++i) {
+                    const Builder::Task &task = tasks[i];
+                    taskDepths[i] = builder.build(task.begin, task.end, task.node, task.depth, 0, nullptr);
+                }
+            });
+            for (uint32_t taskDepth : taskDepths) {
+                depth = (std::max)(depth, taskDepth);
+            }
+        } else {
+            depth = builder.build(0, lightCount, 0, 0, 0, nullptr);
+        }
+        tree->mDepth = depth + 1;
+
+        tree->mLights.resize(lightCount);
+        for (uint32_t i = 0; i < lightCount; ++i) {
+            tree->mLights[i] = lights[builder.order[i]];
+        }
+        return tree;
+    }
+
+    std::vector<RtLightTree::Light> RtLightTree::scatter(uint32_t count, const float3 &boundsMin, const float3 &boundsMax, float totalIntensity, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> dist;
+
+        std::vector<Light> lights(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            Light &light = lights[i];
+            light.position = boundsMin + (boundsMax - boundsMin) * float3(dist(rng), dist(rng), dist(rng));
+            light.type = i % 2 == 0 ? OmniLight : CosineLight;
+
+            // Saturated colors of random hue at a luminance of 1
+            float hue = dist(rng) * 6.0f;
+            float3 color(saturate(std::fabs(hue - 3.0f) - 1.0f), saturate(2.0f - std::fabs(hue - 2.0f)), saturate(2.0f - std::fabs(hue - 4.0f)));
+            color = lerp(float3(1.0f), color, 0.6f);
+            light.intensity = color * (totalIntensity / (float(count) * luminance(color)));
+
+            float z = 1.0f - 2.0f * dist(rng);
+            float phi = 2.0f * kPi * dist(rng);
+            float r = safeSqrt(1.0f - z * z);
+            light.direction = float3(r * std::cos(phi), r * std::sin(phi), z);
+            light.padding0 = 0.0f;
+            light.padding1 = 0.0f;
+        }
+        return lights;
+    }
+
+    float RtLightTree::importance(const Node &node, const float3 &position, const float3 &normal)
+    {
+        float3 center = (node.boundsMin + node.boundsMax) * 0.5f;
+        float3 diagonal = node.boundsMax - node.boundsMin;
+        float radius2 = dot(diagonal, diagonal) * 0.25f;
+        float3 toPoint = position - center;
+        float distance2 = dot(toPoint, toPoint);
+
+        // Closer than the bounds' radius the distance is not a useful bound, every point counts as that far
+        float3 wi = distance2 > 0.0f ? toPoint / std::sqrt(distance2) : float3(0.0f, 0.0f, 1.0f);
+        float clampedDistance2 = (std::max)((std::max)(distance2, radius2), 1e-8f);
+
+        // Bound of the angle subtended by the bounds, every direction from inside them
+        float cosThetaB = -1.0f;
+        if (distance2 > radius2) {
+            cosThetaB = safeSqrt(1.0f - radius2 / distance2);
+        }
+        float sinThetaB = safeSqrt(1.0f - cosThetaB * cosThetaB);
+
+        // Smallest angle between an emission direction of the cone and a direction to the point
+        float cosThetaW = dot(node.axis, wi);
+        float sinThetaW = safeSqrt(1.0f - cosThetaW * cosThetaW);
+        float sinThetaO = safeSqrt(1.0f - node.cosThetaO * node.cosThetaO);
+        float cosThetaX = cosSubClamped(sinThetaW, cosThetaW, sinThetaO, node.cosThetaO);
+        float sinThetaX = sinSubClamped(sinThetaW, cosThetaW, sinThetaO, node.cosThetaO);
+        float cosThetaP = cosSubClamped(sinThetaX, cosThetaX, sinThetaB, cosThetaB);
+        if (cosThetaP <= node.cosThetaE) {
+            return 0.0f;
+        }
+
+        // Smallest angle between the normal and a direction to the bounds
+        float cosThetaI = -dot(normal, wi);
+        float sinThetaI = safeSqrt(1.0f - cosThetaI * cosThetaI);
+        float cosThetaPI = cosSubClamped(sinThetaI, cosThetaI, sinThetaB, cosThetaB);
+
+        return node.power * cosThetaP * (std::max)(cosThetaPI, 0.0f) / clampedDistance2;
+    }
+
+    uint32_t RtLightTree::sample(const float3 &position, const float3 &normal, float u, float &pdf) const
+    {
+        pdf = 0.0f;
+        if (importance(mNodes[0], position, normal) <= 0.0f) {
+            return UINT32_MAX;
+        }
+
+        uint32_t node = 0;
+        float probability = 1.0f;
+        while (mNodes[node].lightCount > 1) {
+            uint32_t first = node + 1, second = mNodes[node].secondChild;
+            float firstImportance = importance(mNodes[first], position, normal);
+            float secondImportance = importance(mNodes[second], position, normal);
+            if (firstImportance + secondImportance <= 0.0f) {
+                return UINT32_MAX;
+            }
+
+            float firstProbability = firstImportance / (firstImportance + secondImportance);
+            if (u < firstProbability) {
+                node = first;
+                u = (std::min)(u / firstProbability, 0.99999994f);
+                probability *= firstProbability;
+            } else {
+                node = second;
+                u = (std::min)((u - firstProbability) / (1.0f - firstProbability), 0.99999994f);
+                probability *= 1.0f - firstProbability;
+            }
+        }
+
+        pdf = probability;
+        return mNodes[node].firstLight;
+    }
+
+    float RtLightTree::evaluatePdf(const float3 &position, const float3 &normal, uint32_t light) const
+    {
+        if (light >= mLights.size() || importance(mNodes[0], position, normal) <= 0.0f) {
+            return 0.0f;
+        }
+
+        uint32_t node = 0;
+        float probability = 1.0f;
+        while (mNodes[node].lightCount > 1) {
+            uint32_t first = node + 1, second = mNodes[node].secondChild;
+            float firstImportance = importance(mNodes[first], position, normal);
+            float secondImportance = importance(mNodes[second], position, normal);
+            if (firstImportance + secondImportance <= 0.0f) {
+                return 0.0f;
+            }
+
+            bool inFirst = light < mNodes[first].firstLight + mNodes[first].lightCount;
+            probability *= (inFirst ? firstImportance : secondImportance) / (firstImportance + secondImportance);
+            node = inFirst ? first : second;
+        }
+        return probability;
+    }
+}
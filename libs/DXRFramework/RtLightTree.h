@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Cpu/CpuMath.h"
+#include <memory>
+#include <vector>
+
+namespace DXRFramework
+{
+    class RtJobSystem;
+
+    // Bounding volume hierarchy over many small emitters for sampling one of them per shading point in
+    // proportion to an estimate of its contribution, after Conty Estevez and Kulla 2018, "Importance
+    // Sampling of Many Lights with Adaptive Tree Splitting". Every node bounds the positions, the
+    // emission directions (an orientation cone) and the power of its lights. A sample walks from the
+    // root to a leaf, choosing a child by the importance of its bounds to the point and its normal, so
+    // it costs O(log n) for n lights. Shared by the GPU path, which uploads the nodes and the lights as
+    // is for LightTree.hlsli, and the CPU backend, so it has no D3D12 dependency.
+    class RtLightTree
+    {
+    public:
+        using SharedPtr = std::shared_ptr<const RtLightTree>;
+
+        enum LightType : uint32_t
+        {
+            // Same intensity in all directions
+            OmniLight = 0,
+            // Intensity times the cosine to direction on one side, a small emissive patch
+            CosineLight = 1,
+        };
+
+        // Same layout as the lights read by LightTree.hlsli. The intensity is scaled like
+        // PointLightParams::color, see evaluatePointLight.
+        struct Light
+        {
+            CpuMath::float3 position;
+            uint32_t type;
+            CpuMath::float3 intensity;
+            float padding0;
+            CpuMath::float3 direction;
+            float padding1;
+        };
+
+        // Same layout as the nodes read by LightTree.hlsli. Nodes are stored depth first, the first
+        // child of an interior node follows it, and every leaf holds one light. The lights of a node
+        // are firstLight to firstLight + lightCount - 1 in the order of getLights().
+        struct Node
+        {
+            CpuMath::float3 boundsMin;
+            float power;
+            CpuMath::float3 boundsMax;
+            // Cone around axis holding every emission direction, cosines of its half angle and of the
+            // angle beyond it light is emitted to
+            float cosThetaO;
+            CpuMath::float3 axis;
+            float cosThetaE;
+            uint32_t secondChild; // 0 for leaves
+            uint32_t firstLight;
+            uint32_t lightCount;
+            uint32_t padding;
+        };
+
+        // Splits are chosen by the surface area orientation heuristic over 12 bins per axis. The top of
+        // the tree is built serially, its subtrees in parallel on the job system. Returns null for an
+        // empty set of lights.
+        static SharedPtr build(const std::vector<Light> &lights, RtJobSystem *jobSystem = nullptr);
+
+        // Lights of random colors scattered uniformly in a box, half of them omni lights and half cosine
+        // lights facing random directions. Their intensities add up to totalIntensity.
+        static std::vector<Light> scatter(uint32_t count, const CpuMath::float3 &boundsMin, const CpuMath::float3 &boundsMax, float totalIntensity, uint32_t seed);
+
+        // In the order of the leaves, which may differ from the order they were built from
+        const std::vector<Light> &getLights() const { return mLights; }
+        const std::vector<Node> &getNodes() const { return mNodes; }
+        uint32_t getDepth() const { return mDepth; }
+
+        // CPU versions of sampleLightTree and of the probability of drawing a light with it. u is
+        // reused at every level. Returns the light index, or UINT32_MAX with a pdf of 0 when no light
+        // can reach the point.
+        uint32_t sample(const CpuMath::float3 &position, const CpuMath::float3 &normal, float u, float &pdf) const;
+        float evaluatePdf(const CpuMath::float3 &position, const CpuMath::float3 &normal, uint32_t light) const;
+
+        // Bound of the contribution of a node's lights to a point with the given normal, the weight of
+        // the node when sampling
+        static float importance(const Node &node, const CpuMath::float3 &position, const CpuMath::float3 &normal);
+
+    private:
+        RtLightTree() = default;
+
+        std::vector<Light> mLights;
+        std::vector<Node> mNodes;
+        uint32_t mDepth = 0;
+    };
+}
@@ -1,96 +1,68 @@
 #include "RtModel.h"
 #include "Helpers/BottomLevelASGenerator.h"
 #include "Helpers/DirectXRaytracingHelper.h"
-#include "assimp/cimport.h"
-#include "assimp/scene.h"
-#include "assimp/postprocess.h"
-#include <DirectXMath.h>
-
-using namespace DirectX;
 
 namespace DXRFramework
 {
-    struct Vertex
-    {
-        XMFLOAT3 position;
-        XMFLOAT3 normal;
-    };
+    using Vertex = RtGeometry::Vertex;
 
     RtModel::SharedPtr RtModel::create(RtContext::SharedPtr context, const std::string &filePath)
     {
-        return SharedPtr(new RtModel(context, filePath));
+        return SharedPtr(new RtModel(context, RtGeometry::import(filePath, context->getJobSystem().get())));
     }
 
-    RtModel::RtModel(RtContext::SharedPtr context, const std::string &filePath)
+    std::vector<RtModel::SharedPtr> RtModel::create(RtContext::SharedPtr context, const std::vector<std::string> &filePaths)
     {
-        auto flags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices | aiProcess_PreTransformVertices;
-        const aiScene *scene = aiImportFile(filePath.c_str(), flags);
-
-        std::vector<Vertex> interleavedVertexData;
-        std::vector<uint32_t> indices;
-        mNumVertices = 0;
-        mNumTriangles = 0;
-
-        if (scene) {
-            for (UINT meshId = 0; meshId < scene->mNumMeshes; ++meshId) {
-                const auto &mesh = scene->mMeshes[meshId];
-
-                for (UINT i = 0; i < mesh->mNumVertices; ++i) {
-                    aiVector3D &position = mesh->mVertices[i];
-                    aiVector3D &normal = mesh->mNormals[i];
-                    Vertex vertex;
-                    vertex.position = XMFLOAT3(position.x, position.y, position.z);
-                    vertex.normal = mesh->HasNormals() ? XMFLOAT3(normal.x, normal.y, normal.z) : XMFLOAT3(0.0f, 0.0f, 0.0f);
-                    interleavedVertexData.emplace_back(vertex);
-                }
-
-                for (UINT i = 0; i < mesh->mNumFaces; ++i) {
-                    const aiFace &face = mesh->mFaces[i];
-                    assert(face.mNumIndices == 3);
-                    indices.push_back(mNumVertices + face.mIndices[0]);
-                    indices.push_back(mNumVertices + face.mIndices[1]);
-                    indices.push_back(mNumVertices + face.mIndices[2]);
-                }
-
-                mNumTriangles += mesh->mNumFaces;
-                mNumVertices += mesh->mNumVertices;
+        // Only the import runs in parallel, the uploads share the context's copy queue
+        auto jobSystem = context->getJobSystem();
+        std::vector<RtGeometry::SharedPtr> geometries(filePaths.size());
+        jobSystem->parallelFor(0, static_cast<uint32_t>(filePaths.size()), 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+                geometries[i] = RtGeometry::import(filePaths[i], jobSystem.get());
             }
-        } else {
-            interleavedVertexData =
-            {
-                { { 0.0f, 0.25f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
-                { { 0.25f, -0.25f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
-                { { -0.25f, -0.25f, 0.0f }, { 0.0f, 0.0f, 1.0f } }
-            };
-            indices = { 0, 2, 1 };
-            mNumTriangles = 1;
-            mNumVertices = static_cast<UINT>(interleavedVertexData.size());
+        });
+
+        std::vector<SharedPtr> models;
+        for (auto &geometry : geometries) {
+            models.push_back(SharedPtr(new RtModel(context, geometry)));
         }
+        return models;
+    }
 
-        mHasIndexBuffer = indices.size() > 0;
+    RtModel::RtModel(RtContext::SharedPtr context, RtGeometry::SharedPtr geometry)
+    {
+        mGeometry = geometry;
+        mNumVertices = static_cast<UINT>(mGeometry->vertices.size());
+        mNumTriangles = mGeometry->getTriangleCount();
+        mHasIndexBuffer = mGeometry->indices.size() > 0;
 
+        // Geometry lives in default heap buffers filled on the copy queue; the acceleration structure
+        // build waits on the GPU for the upload to land
         auto device = context->getDevice();
-        // Note: using upload heaps to transfer static data like vert buffers is not 
-        // recommended. Every time the GPU needs it, the upload heap will be marshalled 
-        // over. Please read up on Default Heap usage. An upload heap is used here for 
-        // code simplicity and because there are very few verts to actually transfer.
-        AllocateUploadBuffer(device, interleavedVertexData.data(), mNumVertices * sizeof(Vertex), &mVertexBuffer);
+        auto uploadQueue = context->getUploadQueue();
+        UINT64 vertexBufferSize = mNumVertices * sizeof(Vertex);
+        mVertexBuffer = CreateBuffer(device, vertexBufferSize, D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_COMMON, kDefaultHeapProps);
+        mUploadFenceValue = uploadQueue->uploadBuffer(mVertexBuffer.Get(), mGeometry->vertices.data(), vertexBufferSize);
 
         if (mHasIndexBuffer) {
-            AllocateUploadBuffer(device, indices.data(), indices.size() * sizeof(uint32_t), &mIndexBuffer);
+            UINT64 indexBufferSize = mGeometry->indices.size() * sizeof(uint32_t);
+            mIndexBuffer = CreateBuffer(device, indexBufferSize, D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_COMMON, kDefaultHeapProps);
+            mUploadFenceValue = uploadQueue->uploadBuffer(mIndexBuffer.Get(), mGeometry->indices.data(), indexBufferSize);
         }
+
+        // Submit right away so the copy overlaps whatever the caller does next
+        uploadQueue->flush();
     }
 
     RtModel::~RtModel() = default;
 
-    void RtModel::build(RtContext::SharedPtr context)
+    void RtModel::prepareBuild(RtContext::SharedPtr context)
     {
         auto device = context->getDevice();
-        auto commandList = context->getCommandList();
         auto fallbackDevice = context->getFallbackDevice();
-        auto fallbackCommandList = context->getFallbackCommandList();
 
-        nv_helpers_dx12::BottomLevelASGenerator blasGenerator;
+        mBlasGenerator.reset(new nv_helpers_dx12::BottomLevelASGenerator());
+        auto &blasGenerator = *mBlasGenerator;
 
         // Just one vertex buffer per blas for now
         if (mHasIndexBuffer) {
@@ -104,16 +76,21 @@ namespace DXRFramework
         UINT64 resultSizeInBytes = 0;
         blasGenerator.ComputeASBufferSizes(fallbackDevice, false, &scratchSizeInBytes, &resultSizeInBytes);
 
-        ComPtr<ID3D12Resource> scratch = CreateBuffer(device, scratchSizeInBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, kDefaultHeapProps);
+        // Kept alive with the model, the build reads it after this function returns
+        mScratchBuffer = CreateBuffer(device, scratchSizeInBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, kDefaultHeapProps);
 
         D3D12_RESOURCE_STATES initialResourceState = fallbackDevice->GetAccelerationStructureResourceState();
         mBlasBuffer = CreateBuffer(device, resultSizeInBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, initialResourceState, kDefaultHeapProps);
 
-        blasGenerator.Generate(commandList, fallbackCommandList, scratch.Get(), mBlasBuffer.Get());
-
         mVertexBufferSrvHandle = context->createBufferSRVHandle(mVertexBuffer.Get(), false, sizeof(Vertex));
         if (mIndexBuffer) {
             mIndexBufferSrvHandle = context->createBufferSRVHandle(mIndexBuffer.Get(), false, sizeof(uint32_t));
         }
     }
+
+    void RtModel::recordBuild(RtContext::SharedPtr context)
+    {
+        mBlasGenerator->Generate(context->getCommandList(), context->getFallbackCommandList(), mScratchBuffer.Get(), mBlasBuffer.Get());
+        mBlasGenerator.reset();
+    }
 }
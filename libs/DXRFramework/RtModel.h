@@ -2,6 +2,12 @@
 
 #include "RtPrefix.h"
 #include "RtContext.h"
+#include "RtGeometry.h"
+
+namespace nv_helpers_dx12
+{
+    class BottomLevelASGenerator;
+}
 
 namespace DXRFramework
 {
@@ -11,27 +17,42 @@ namespace DXRFramework
         using SharedPtr = std::shared_ptr<RtModel>;
         
         static SharedPtr create(RtContext::SharedPtr context, const std::string &filePath);
+        // Imports the files in parallel on the context's job system
+        static std::vector<SharedPtr> create(RtContext::SharedPtr context, const std::vector<std::string> &filePaths);
         ~RtModel();
         
+        // CPU copy of the geometry, e.g. for building CPU acceleration structures
+        RtGeometry::SharedPtr getGeometry() const { return mGeometry; }
+
         ID3D12Resource *getVertexBuffer() const { return mVertexBuffer.Get(); }
         ID3D12Resource *getIndexBuffer() const { return mIndexBuffer.Get(); }
 
         D3D12_GPU_DESCRIPTOR_HANDLE getVertexBufferSrvHandle() const { return mVertexBufferSrvHandle; }
         D3D12_GPU_DESCRIPTOR_HANDLE getIndexBufferSrvHandle() const { return mIndexBufferSrvHandle; }
 
+        // Upload queue fence value at which the vertex and index buffers are filled
+        UINT64 getUploadFenceValue() const { return mUploadFenceValue; }
+
     private:
         friend class RtScene;
-        RtModel(RtContext::SharedPtr context, const std::string &filePath);
+        RtModel(RtContext::SharedPtr context, RtGeometry::SharedPtr geometry);
 
-        void build(RtContext::SharedPtr context);
+        // Creates the acceleration structure buffers and descriptors, safe to call for several models
+        // at once. Recording the build goes to the context's command list and must stay on one thread.
+        void prepareBuild(RtContext::SharedPtr context);
+        void recordBuild(RtContext::SharedPtr context);
 
+        RtGeometry::SharedPtr mGeometry;
         bool mHasIndexBuffer;
         UINT mNumVertices;
         UINT mNumTriangles;
+        UINT64 mUploadFenceValue;
 
         ComPtr<ID3D12Resource> mVertexBuffer;
         ComPtr<ID3D12Resource> mIndexBuffer;
         ComPtr<ID3D12Resource> mBlasBuffer;
+        ComPtr<ID3D12Resource> mScratchBuffer;
+        std::unique_ptr<nv_helpers_dx12::BottomLevelASGenerator> mBlasGenerator;
 
         D3D12_GPU_DESCRIPTOR_HANDLE mVertexBufferSrvHandle;
         D3D12_GPU_DESCRIPTOR_HANDLE mIndexBufferSrvHandle;
@@ -1,6 +1,7 @@
 #include "RtScene.h"
 #include "Helpers/TopLevelASGenerator.h"
 #include "Helpers/DirectXRaytracingHelper.h"
+#include <algorithm>
 
 namespace DXRFramework
 {
@@ -24,8 +25,32 @@ namespace DXRFramework
 
         nv_helpers_dx12::TopLevelASGenerator tlasGenerator;
 
+        // Only the geometry has to be resident before the builds start, texture uploads still in
+        // flight on the copy queue keep overlapping with them
+        UINT64 geometryFenceValue = 0;
+        for (auto &instance : mInstances) {
+            geometryFenceValue = std::max(geometryFenceValue, instance->mModel->getUploadFenceValue());
+        }
+        context->waitForUploads(geometryFenceValue);
+
+        // Instances sharing a model share its bottom level structure. Buffer and descriptor creation
+        // for the models runs on the job system, the builds are recorded in instance order.
+        std::vector<RtModel *> models;
+        for (auto &instance : mInstances) {
+            if (std::find(models.begin(), models.end(), instance->mModel.get()) == models.end()) {
+                models.push_back(instance->mModel.get());
+            }
+        }
+        context->getJobSystem()->parallelFor(0, static_cast<uint32_t>(models.size()), 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+                models[i]->prepareBuild(context);
+            }
+        });
+        for (auto model : models) {
+            model->recordBuild(context);
+        }
+
         for (int i = 0; i < mInstances.size(); ++i) {
-            mInstances[i]->mModel->build(context);
             tlasGenerator.AddInstance(mInstances[i]->mModel->mBlasBuffer.Get(), mInstances[i]->mTransform, i, i * hitGroupCount);
         }
 
@@ -35,17 +60,17 @@ namespace DXRFramework
         tlasGenerator.ComputeASBufferSizes(fallbackDevice, true, &scratchSizeInBytes, &resultSizeInBytes, &instanceDescsSize);
 
         // Allocate on default heap since the build is done on GPU
-        ComPtr<ID3D12Resource> scratch = CreateBuffer(device, scratchSizeInBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, kDefaultHeapProps);
+        mScratchBuffer = CreateBuffer(device, scratchSizeInBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, kDefaultHeapProps);
 
         D3D12_RESOURCE_STATES initialResourceState = fallbackDevice->GetAccelerationStructureResourceState();
         mTlasBuffer = CreateBuffer(device, resultSizeInBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, initialResourceState, kDefaultHeapProps);
 
-        ComPtr<ID3D12Resource> instanceDesc = CreateBuffer(device, instanceDescsSize, D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_GENERIC_READ, kUploadHeapProps); 
+        mInstanceDescBuffer = CreateBuffer(device, instanceDescsSize, D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_GENERIC_READ, kUploadHeapProps); 
 
         // Set the descriptor heaps to be used during acceleration structure build for the Fallback Layer.
         context->bindDescriptorHeap();
 
-        tlasGenerator.Generate(commandList, fallbackCommandList, scratch.Get(), mTlasBuffer.Get(), instanceDesc.Get(), 
+        tlasGenerator.Generate(commandList, fallbackCommandList, mScratchBuffer.Get(), mTlasBuffer.Get(), mInstanceDescBuffer.Get(), 
             [&](ID3D12Resource *resource) -> WRAPPED_GPU_POINTER { return context->createBufferUAVWrappedPointer(resource); });
 
         mTlasWrappedPointer = context->createBufferUAVWrappedPointer(mTlasBuffer.Get());
@@ -41,6 +41,8 @@ namespace DXRFramework
         std::vector<Node::SharedPtr> mInstances;
         
         ComPtr<ID3D12Resource> mTlasBuffer;
+        ComPtr<ID3D12Resource> mScratchBuffer;
+        ComPtr<ID3D12Resource> mInstanceDescBuffer;
         WRAPPED_GPU_POINTER mTlasWrappedPointer;
     };
 }
@@ -0,0 +1,122 @@
+#include "RtStagingPlanner.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace DXRFramework
+{
+    static uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+    }
+
+    RtStagingPlanner::RtStagingPlanner(Queue &queue, uint64_t capacity)
+        : mQueue(queue), mCapacity(capacity), mHead(0), mUsed(0), mPendingUsed(0), mLastSubmittedValue(0)
+    {
+    }
+
+    // Ring space is handed out in order. Allocations that would run past the end of the ring skip the
+    // remaining bytes and start over at zero; the skipped bytes are charged to the batch so they are
+    // reclaimed together with it.
+    bool RtStagingPlanner::tryAllocate(uint64_t size, uint64_t alignment, uint64_t &offset)
+    {
+        uint64_t aligned = alignUp(mHead, alignment);
+        if (aligned + size > mCapacity) {
+            aligned = 0;
+        }
+        uint64_t padding = aligned >= mHead ? aligned - mHead : mCapacity - mHead;
+        if (mUsed + padding + size > mCapacity) {
+            return false;
+        }
+
+        offset = aligned;
+        mHead = aligned + size == mCapacity ? 0 : aligned + size;
+        mUsed += padding + size;
+        mPendingUsed += padding + size;
+        return true;
+    }
+
+    void RtStagingPlanner::retire(uint64_t completedValue)
+    {
+        while (!mInFlight.empty() && mInFlight.front().fenceValue <= completedValue) {
+            mUsed -= mInFlight.front().used;
+            mInFlight.pop_front();
+        }
+        if (mUsed == 0) {
+            mHead = 0;
+        }
+    }
+
+    void RtStagingPlanner::closeBatch(uint64_t fenceValue)
+    {
+        mInFlight.push_back({ mPendingUsed, fenceValue });
+        mPendingUsed = 0;
+        mLastSubmittedValue = fenceValue;
+        mStats.batches++;
+    }
+
+    uint64_t RtStagingPlanner::allocate(uint64_t size, uint64_t alignment)
+    {
+        size = std::max<uint64_t>(size, 1);
+        if (size > mCapacity) {
+            throw std::length_error("staging allocation larger than the ring");
+        }
+
+        uint64_t offset;
+        for (;;) {
+            retire(mQueue.getCompletedValue());
+            if (tryAllocate(size, alignment, offset)) {
+                break;
+            }
+
+            // The GPU can only free space that was submitted
+            if (mPendingUsed > 0) {
+                closeBatch(mQueue.submitBatch());
+            }
+            mStats.stalls++;
+            mQueue.waitForValue(mInFlight.front().fenceValue);
+        }
+
+        mStats.bytesStaged += size;
+        mStats.chunks++;
+        return offset;
+    }
+
+    uint64_t RtStagingPlanner::planRows(uint32_t rowCount, uint64_t rowPitch, uint64_t alignment, const ChunkCallback &copyChunk)
+    {
+        uint64_t maxRowsPerChunk = (mCapacity - (alignment > 1 ? alignment - 1 : 0)) / rowPitch;
+        if (maxRowsPerChunk == 0) {
+            throw std::length_error("staging ring cannot hold a single row");
+        }
+        if (rowCount == 0) {
+            return mLastSubmittedValue;
+        }
+
+        uint32_t firstRow = 0;
+        while (firstRow < rowCount) {
+            uint32_t rows = static_cast<uint32_t>(std::min<uint64_t>(rowCount - firstRow, maxRowsPerChunk));
+
+            // Rather than stall for the full chunk, use whatever contiguous space is free right now
+            retire(mQueue.getCompletedValue());
+            uint64_t aligned = alignUp(mHead, alignment);
+            uint64_t freeAtHead = aligned <= mCapacity && mUsed + (aligned - mHead) <= mCapacity ? std::min(mCapacity - aligned, mCapacity - mUsed - (aligned - mHead)) : 0;
+            uint64_t freeAtStart = mUsed + (mCapacity - mHead) <= mCapacity ? mCapacity - mUsed - (mCapacity - mHead) : 0;
+            uint64_t fittingRows = std::max(freeAtHead, freeAtStart) / rowPitch;
+            if (fittingRows > 0 && fittingRows < rows) {
+                rows = static_cast<uint32_t>(fittingRows);
+            }
+
+            uint64_t offset = allocate(rows * rowPitch, alignment);
+            copyChunk(firstRow, rows, offset);
+            firstRow += rows;
+        }
+        return getPendingFenceValue();
+    }
+
+    uint64_t RtStagingPlanner::submit()
+    {
+        if (mPendingUsed > 0) {
+            closeBatch(mQueue.submitBatch());
+        }
+        return mLastSubmittedValue;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+namespace DXRFramework
+{
+    // Platform independent bookkeeping for a ring of upload staging memory. The planner decides where
+    // each copy goes in the ring, when the current batch has to be submitted and which earlier batches
+    // have to retire before their space can be reused. The queue it talks to is abstract, so the same
+    // logic drives RtUploadQueue and can be exercised against a mock queue.
+    class RtStagingPlanner
+    {
+    public:
+        class Queue
+        {
+        public:
+            virtual ~Queue() = default;
+
+            // Submits everything recorded since the last submission and returns the fence value it
+            // signals. Values start at 1 and increase by one per batch.
+            virtual uint64_t submitBatch() = 0;
+            virtual uint64_t getCompletedValue() = 0;
+            virtual void waitForValue(uint64_t fenceValue) = 0;
+        };
+
+        struct Stats
+        {
+            uint64_t bytesStaged = 0;
+            uint64_t chunks = 0;
+            uint64_t batches = 0;
+            uint64_t stalls = 0; // allocations that had to wait for the GPU to free ring space
+        };
+
+        RtStagingPlanner(Queue &queue, uint64_t capacity);
+
+        // Reserves staging space for a single copy. Submits the current batch and waits for older
+        // batches as needed. Returns the offset into the ring.
+        uint64_t allocate(uint64_t size, uint64_t alignment);
+
+        // Splits a copy of rowCount rows of rowPitch bytes into chunks that fit the ring. The callback
+        // receives the first row, the number of rows and the staging offset of each chunk, in order.
+        // Returns the fence value of the batch holding the last chunk.
+        using ChunkCallback = std::function<void(uint32_t firstRow, uint32_t rowCount, uint64_t stagingOffset)>;
+        uint64_t planRows(uint32_t rowCount, uint64_t rowPitch, uint64_t alignment, const ChunkCallback &copyChunk);
+
+        // Submits the current batch if anything was allocated since the last submission.
+        // Returns the fence value that covers all copies planned so far.
+        uint64_t submit();
+
+        // Fence value the batch currently being recorded will signal
+        uint64_t getPendingFenceValue() const { return mLastSubmittedValue + 1; }
+        uint64_t getLastSubmittedValue() const { return mLastSubmittedValue; }
+        uint64_t getCapacity() const { return mCapacity; }
+        uint64_t getBytesInFlight() const { return mUsed; }
+        const Stats &getStats() const { return mStats; }
+
+    private:
+        struct Batch
+        {
+            uint64_t used;       // bytes it holds, including padding skipped at the end of the ring
+            uint64_t fenceValue;
+        };
+
+        bool tryAllocate(uint64_t size, uint64_t alignment, uint64_t &offset);
+        void retire(uint64_t completedValue);
+        void closeBatch(uint64_t fenceValue);
+
+        Queue &mQueue;
+        uint64_t mCapacity;
+        uint64_t mHead;          // next free byte
+        uint64_t mUsed;          // bytes held by submitted and pending batches
+        uint64_t mPendingUsed;   // bytes held by the batch being recorded
+        uint64_t mLastSubmittedValue;
+        std::deque<Batch> mInFlight;
+        Stats mStats;
+    };
+}
@@ -0,0 +1,179 @@
+#include "RtUploadQueue.h"
+#include "Helpers/DirectXRaytracingHelper.h"
+#include <algorithm>
+
+namespace DXRFramework
+{
+    // Buffers are staged in rows of this size so that large buffers can be split across batches
+    static const UINT64 kBufferRowSize = 64 * 1024;
+
+    RtUploadQueue::SharedPtr RtUploadQueue::create(ID3D12Device *device, UINT64 stagingSize)
+    {
+        return SharedPtr(new RtUploadQueue(device, stagingSize));
+    }
+
+    RtUploadQueue::RtUploadQueue(ID3D12Device *device, UINT64 stagingSize)
+        : mDevice(device), mCurrentAllocator(0), mRecording(false), mNextFenceValue(1), mStagingData(nullptr), mPlanner(*this, stagingSize)
+    {
+        D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+        queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+        queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+        ThrowIfFailed(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&mCommandQueue)));
+        NAME_D3D12_OBJECT(mCommandQueue);
+
+        ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence)));
+        NAME_D3D12_OBJECT(mFence);
+
+        mStagingBuffer = CreateBuffer(device, stagingSize, D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_GENERIC_READ, kUploadHeapProps);
+        NAME_D3D12_OBJECT(mStagingBuffer);
+
+        // Upload heaps can stay mapped for the lifetime of the resource
+        CD3DX12_RANGE readRange(0, 0);
+        ThrowIfFailed(mStagingBuffer->Map(0, &readRange, reinterpret_cast<void**>(&mStagingData)));
+    }
+
+    RtUploadQueue::~RtUploadQueue()
+    {
+        // The staging buffer and command allocators must outlive the copies reading from them
+        waitOnCpu(flush());
+        mStagingBuffer->Unmap(0, nullptr);
+    }
+
+    void RtUploadQueue::beginRecording()
+    {
+        if (mRecording) {
+            return;
+        }
+
+        UINT64 completedValue = mFence->GetCompletedValue();
+        auto it = std::find_if(mAllocators.begin(), mAllocators.end(), [=](const Allocator &a) { return a.fenceValue <= completedValue; });
+        if (it == mAllocators.end()) {
+            Allocator allocator;
+            ThrowIfFailed(mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&allocator.allocator)));
+            allocator.fenceValue = 0;
+            it = mAllocators.insert(mAllocators.end(), allocator);
+        }
+        mCurrentAllocator = it - mAllocators.begin();
+
+        auto commandAllocator = it->allocator.Get();
+        ThrowIfFailed(commandAllocator->Reset());
+        if (!mCommandList) {
+            ThrowIfFailed(mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, commandAllocator, nullptr, IID_PPV_ARGS(&mCommandList)));
+            NAME_D3D12_OBJECT(mCommandList);
+        } else {
+            ThrowIfFailed(mCommandList->Reset(commandAllocator, nullptr));
+        }
+        mRecording = true;
+    }
+
+    uint64_t RtUploadQueue::submitBatch()
+    {
+        UINT64 fenceValue = mNextFenceValue++;
+        if (mRecording) {
+            ThrowIfFailed(mCommandList->Close());
+            ID3D12CommandList *commandLists[] = { mCommandList.Get() };
+            mCommandQueue->ExecuteCommandLists(ARRAYSIZE(commandLists), commandLists);
+            mAllocators[mCurrentAllocator].fenceValue = fenceValue;
+            mRecording = false;
+        }
+        ThrowIfFailed(mCommandQueue->Signal(mFence.Get(), fenceValue));
+        return fenceValue;
+    }
+
+    void RtUploadQueue::waitForValue(uint64_t fenceValue)
+    {
+        // A null event blocks until the fence reaches the value
+        ThrowIfFailed(mFence->SetEventOnCompletion(fenceValue, nullptr));
+    }
+
+    UINT64 RtUploadQueue::uploadBuffer(ID3D12Resource *destination, const void *data, UINT64 size, UINT64 destinationOffset)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        UINT64 rowSize = std::min(size, kBufferRowSize);
+        UINT rowCount = static_cast<UINT>((size + rowSize - 1) / rowSize);
+        auto source = static_cast<const UINT8*>(data);
+
+        return mPlanner.planRows(rowCount, rowSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, [&](uint32_t firstRow, uint32_t rows, uint64_t stagingOffset) {
+            UINT64 begin = firstRow * rowSize;
+            UINT64 bytes = std::min(size, (firstRow + rows) * rowSize) - begin;
+            memcpy(mStagingData + stagingOffset, source + begin, bytes);
+
+            beginRecording();
+            mCommandList->CopyBufferRegion(destination, destinationOffset + begin, mStagingBuffer.Get(), stagingOffset, bytes);
+        });
+    }
+
+    UINT64 RtUploadQueue::uploadTexture(ID3D12Resource *destination, const D3D12_SUBRESOURCE_DATA *subresources, UINT numSubresources)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        D3D12_RESOURCE_DESC desc = destination->GetDesc();
+        UINT64 fenceValue = mPlanner.getLastSubmittedValue();
+
+        for (UINT i = 0; i < numSubresources; ++i) {
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout;
+            UINT numRows;
+            UINT64 rowSizeInBytes, totalBytes;
+            mDevice->GetCopyableFootprints(&desc, i, 1, 0, &layout, &numRows, &rowSizeInBytes, &totalBytes);
+
+            // Rows are rows of blocks for compressed formats, the footprint height is block aligned
+            UINT blockHeight = layout.Footprint.Height / numRows;
+            const D3D12_SUBRESOURCE_DATA &subresource = subresources[i];
+
+            fenceValue = mPlanner.planRows(numRows, layout.Footprint.RowPitch, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, [&](uint32_t firstRow, uint32_t rows, uint64_t stagingOffset) {
+                auto source = static_cast<const UINT8*>(subresource.pData) + firstRow * subresource.RowPitch;
+                for (UINT row = 0; row < rows; ++row) {
+                    memcpy(mStagingData + stagingOffset + row * layout.Footprint.RowPitch, source + row * subresource.RowPitch, rowSizeInBytes);
+                }
+
+                D3D12_PLACED_SUBRESOURCE_FOOTPRINT chunk = layout;
+                chunk.Offset = stagingOffset;
+                chunk.Footprint.Height = rows * blockHeight;
+
+                CD3DX12_TEXTURE_COPY_LOCATION dst(destination, i);
+                CD3DX12_TEXTURE_COPY_LOCATION src(mStagingBuffer.Get(), chunk);
+                beginRecording();
+                mCommandList->CopyTextureRegion(&dst, 0, firstRow * blockHeight, 0, &src, nullptr);
+            });
+        }
+
+        // Everything accessed on a copy queue decays to COMMON when the command list completes,
+        // so no transition is needed before other queues read the texture
+        return fenceValue;
+    }
+
+    UINT64 RtUploadQueue::flush()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mPlanner.submit();
+    }
+
+    void RtUploadQueue::submitUpTo(UINT64 fenceValue)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (fenceValue > mPlanner.getLastSubmittedValue()) {
+            mPlanner.submit();
+        }
+    }
+
+    void RtUploadQueue::waitOnQueue(ID3D12CommandQueue *queue, UINT64 fenceValue)
+    {
+        submitUpTo(fenceValue);
+        ThrowIfFailed(queue->Wait(mFence.Get(), fenceValue));
+    }
+
+    void RtUploadQueue::waitOnCpu(UINT64 fenceValue)
+    {
+        submitUpTo(fenceValue);
+        if (!isComplete(fenceValue)) {
+            waitForValue(fenceValue);
+        }
+    }
+
+    RtStagingPlanner::Stats RtUploadQueue::getStats()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mPlanner.getStats();
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "RtPrefix.h"
+#include "RtStagingPlanner.h"
+#include <mutex>
+#include <vector>
+
+namespace DXRFramework
+{
+    // Uploads static data to default heap resources on a dedicated copy queue. Data is staged through
+    // a persistently mapped ring buffer; every upload returns the value the queue's fence reaches once
+    // the copy has landed, so consumers can wait for exactly the data they need, either on the CPU or
+    // on another queue. Safe to call from multiple threads.
+    class RtUploadQueue : private RtStagingPlanner::Queue
+    {
+    public:
+        using SharedPtr = std::shared_ptr<RtUploadQueue>;
+
+        static SharedPtr create(ID3D12Device *device, UINT64 stagingSize = 64 * 1024 * 1024);
+        ~RtUploadQueue();
+
+        // Copies into a buffer in the COMMON state. It decays back to COMMON once the copy completes and
+        // is implicitly promoted to a read state on first use on another queue.
+        UINT64 uploadBuffer(ID3D12Resource *destination, const void *data, UINT64 size, UINT64 destinationOffset = 0);
+
+        // Copies all subresources of a 2D texture or cubemap created in the COMMON or COPY_DEST state.
+        // Like buffers it is left in COMMON.
+        UINT64 uploadTexture(ID3D12Resource *destination, const D3D12_SUBRESOURCE_DATA *subresources, UINT numSubresources);
+
+        // Submits the copies recorded so far. Returns the fence value that covers every upload issued.
+        UINT64 flush();
+
+        // Both flush first if the fence value belongs to copies that were not submitted yet.
+        // waitOnQueue makes the other queue wait on the GPU, the CPU does not block.
+        void waitOnQueue(ID3D12CommandQueue *queue, UINT64 fenceValue);
+        void waitOnCpu(UINT64 fenceValue);
+        bool isComplete(UINT64 fenceValue) { return mFence->GetCompletedValue() >= fenceValue; }
+
+        ID3D12CommandQueue *getCommandQueue() const { return mCommandQueue.Get(); }
+        RtStagingPlanner::Stats getStats();
+
+    private:
+        RtUploadQueue(ID3D12Device *device, UINT64 stagingSize);
+
+        // RtStagingPlanner::Queue
+        uint64_t submitBatch() override;
+        uint64_t getCompletedValue() override { return mFence->GetCompletedValue(); }
+        void waitForValue(uint64_t fenceValue) override;
+
+        void beginRecording();
+        void submitUpTo(UINT64 fenceValue);
+
+        struct Allocator
+        {
+            ComPtr<ID3D12CommandAllocator> allocator;
+            UINT64 fenceValue;
+        };
+
+        ID3D12Device *mDevice;
+        ComPtr<ID3D12CommandQueue> mCommandQueue;
+        ComPtr<ID3D12GraphicsCommandList> mCommandList;
+        std::vector<Allocator> mAllocators;
+        size_t mCurrentAllocator;
+        bool mRecording;
+
+        ComPtr<ID3D12Fence> mFence;
+        UINT64 mNextFenceValue;
+
+        ComPtr<ID3D12Resource> mStagingBuffer;
+        UINT8 *mStagingData;
+        RtStagingPlanner mPlanner;
+
+        std::mutex mMutex;
+    };
+}
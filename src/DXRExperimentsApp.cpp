@@ -5,6 +5,7 @@
 #include "Helpers/DirectXRaytracingHelper.h"
 #include "ImGuiRendererDX.h"
 #include "GameInput.h"
+#include "TaskGraph.h"
 
 using namespace std;
 using namespace DXRFramework;
@@ -17,6 +18,8 @@ namespace GameCore
 DXRExperimentsApp::DXRExperimentsApp(UINT width, UINT height, std::wstring name) :
     DXSample(width, height, name),
     mBypassRaytracing(false),
+    mReleaseIdleOutputs(false),
+    mIdleOutputTimeout(30.0f),
     mForceComputeFallback(false) // Set this to true if you're running on RTX cards but wants to force compute path
 {
     UpdateForSizeChange(width, height);
@@ -58,7 +61,8 @@ void DXRExperimentsApp::OnInit()
 
     // Setup camera states
     mCamera.reset(new Math::Camera());
-    mCamera->SetAspectRatio(m_aspectRatio);
+    // Math::Camera takes height over width, the projection has to match the rays for reprojection
+    mCamera->SetAspectRatio(1.0f / m_aspectRatio);
     mCamera->SetEyeAtUp(Math::Vector3(8.0, 10.0, 30.0), Math::Vector3(0.0, 1.5, 0.0), Math::Vector3(Math::kYUnitVector));
     mCamera->SetZRange(1.0f, 10000.0f);
     mCamController.reset(new GameCore::CameraController(*mCamera, mCamera->GetUpVec()));
@@ -79,23 +83,16 @@ void DXRExperimentsApp::InitRaytracing()
 {
     auto device = m_deviceResources->GetD3DDevice();
     auto commandList = m_deviceResources->GetCommandList();
+    auto commandQueue = m_deviceResources->GetCommandQueue();
 
-    mRtContext = RtContext::create(device, commandList, mForceComputeFallback);
-
-    // Create scene
+    mRtContext = RtContext::create(device, commandList, commandQueue, mForceComputeFallback);
     mRtScene = RtScene::create();
-    {
-        auto identity = DirectX::XMMatrixIdentity();
-
-        // working directory is "vc2015"
-        mRtScene->addModel(RtModel::create(mRtContext, "..\\assets\\models\\pica\\Machines.fbx"), identity);
-    }
+    mTextureCache = TextureCache::create(mRtContext, commandQueue);
 
     // Create materials
-    std::vector<RaytracingPipeline::Material> materials;
-    materials.resize(1);
+    mMaterials.resize(1);
     {
-        RaytracingPipeline::Material &material1 = materials[0];
+        RaytracingPipeline::Material &material1 = mMaterials[0];
         material1.params.albedo = XMFLOAT4(0.95f, 0.05f, 0.0f, 1.0f);
         material1.params.specular = XMFLOAT4(0.58f, 0.58f, 0.58f, 1.0f);
         material1.params.roughness = 0.5f;
@@ -103,38 +100,128 @@ void DXRExperimentsApp::InitRaytracing()
         material1.params.type = 1;
     }
 
-    // Create raytracing pipelines
-    mRaytracingPipelines.emplace_back(ProgressiveRaytracingPipeline::create(mRtContext));
-    mRaytracingPipelines.emplace_back(RealtimeRaytracingPipeline::create(mRtContext));
+    // Register raytracing pipelines. They are only instantiated when first selected.
+    mPipelineNames = { "Progressive Ray Tracing Pipeline", "Realtime Ray Tracing Pipeline" };
+    mPipelineFactories = {
+        [&] { return ProgressiveRaytracingPipeline::create(mRtContext); },
+        [&] { return RealtimeRaytracingPipeline::create(mRtContext); }
+    };
+    mRaytracingPipelines.resize(mPipelineFactories.size());
+    mPipelineLastActiveTime.resize(mPipelineFactories.size(), 0.0);
+
+    // Startup is expressed as a task graph: model import, program/RTSO creation, texture decode and
+    // acceleration structure recording run on worker threads. GPU work is submitted without waiting
+    // and the main thread waits for the GPU once after the whole graph has finished.
+    TaskGraph startup;
+    const int initialPipeline = 0;
+
+    auto importModels = startup.addTask("Import models", [&] {
+        auto identity = DirectX::XMMatrixIdentity();
+
+        // working directory is "vc2015"
+        mRtScene->addModel(RtModel::create(mRtContext, "..\\assets\\models\\pica\\Machines.fbx"), identity);
+    });
 
-    // Populate raytracing pipelines
-    for (auto pipeline : mRaytracingPipelines) {
-        mPipelineNames.emplace_back(pipeline->getName());
+    auto createPipeline = startup.addTask("Pipeline: create program and RTSO", [&] {
+        mRaytracingPipelines[initialPipeline] = mPipelineFactories[initialPipeline]();
+    });
 
-        pipeline->setScene(mRtScene);
-        for (auto &m : materials) {
-            pipeline->addMaterial(m);
-        }
+    startup.addTask("Pipeline: request textures", [&] {
+        mRaytracingPipelines[initialPipeline]->loadResources(mTextureCache, FrameCount);
+    }, { createPipeline });
 
-        pipeline->setCamera(mCamera);
-        pipeline->loadResources(m_deviceResources->GetCommandQueue(), FrameCount);
-        pipeline->createOutputResource(m_deviceResources->GetBackBufferFormat(), GetWidth(), GetHeight());
+    auto bindScene = startup.addTask("Pipeline: bind scene", [&] {
+        BindPipelineScene(mRaytracingPipelines[initialPipeline].get());
+    }, { createPipeline, importModels });
 
-        // Build acceleration structures
-        if (!mBypassRaytracing) {
+    if (!mBypassRaytracing) {
+        startup.addTask("Record acceleration structure builds", [&] {
+            // The scene is shared by all pipelines and they use the same hit group layout, so it is built once
             commandList->Reset(m_deviceResources->GetCommandAllocator(), nullptr);
-            pipeline->buildAccelerationStructures();
+            mRaytracingPipelines[initialPipeline]->buildAccelerationStructures();
             m_deviceResources->ExecuteCommandList();
-            m_deviceResources->WaitForGpu();
-        }
+        }, { bindScene });
     }
 
-    mActiveRaytracingPipeline = mRaytracingPipelines.front().get();
-    mActivePipelineIndex = 0;
+    auto createDenoiser = startup.addTask("Denoiser: create pipeline states", [&] {
+        mDenoiser = DenoiseCompositor::create(mRtContext);
+    });
+    startup.addTask("Denoiser: load resources", [&] {
+        mDenoiser->loadResources(commandQueue, FrameCount, mBypassRaytracing);
+    }, { createDenoiser });
 
-    mDenoiser = DenoiseCompositor::create(mRtContext);
-    mDenoiser->loadResources(m_deviceResources->GetCommandQueue(), FrameCount, mBypassRaytracing);
+    startup.run(*mRtContext->getJobSystem());
+
+    // Output resources are created once the workers are done; their descriptor tables take ranges of the heap
+    auto mainThreadStart = TaskGraph::Clock::now();
+    mRaytracingPipelines[initialPipeline]->createOutputResource(m_deviceResources->GetBackBufferFormat(), GetWidth(), GetHeight());
     mDenoiser->createOutputResource(m_deviceResources->GetBackBufferFormat(), GetWidth(), GetHeight());
+    startup.recordExternal("Create output resources", mainThreadStart, TaskGraph::Clock::now());
+
+    auto waitStart = TaskGraph::Clock::now();
+    m_deviceResources->WaitForGpu();
+    startup.recordExternal("Wait for GPU", waitStart, TaskGraph::Clock::now());
+
+    ActivatePipeline(initialPipeline);
+
+    mStartupTimeline = startup.report();
+    OutputDebugStringA(("Startup timeline:\n" + mStartupTimeline).c_str());
+}
+
+void DXRExperimentsApp::BindPipelineScene(RaytracingPipeline *pipeline)
+{
+    pipeline->setScene(mRtScene);
+    for (auto &m : mMaterials) {
+        pipeline->addMaterial(m);
+    }
+    pipeline->setCamera(mCamera);
+}
+
+void DXRExperimentsApp::ActivatePipeline(int index)
+{
+    auto &pipeline = mRaytracingPipelines[index];
+
+    if (!pipeline) {
+        pipeline = mPipelineFactories[index]();
+        BindPipelineScene(pipeline.get());
+        pipeline->loadResources(mTextureCache, FrameCount);
+    }
+
+    if (!pipeline->getOutputResource(0)) {
+        pipeline->createOutputResource(m_deviceResources->GetBackBufferFormat(), GetWidth(), GetHeight());
+    }
+
+    mActivePipelineIndex = index;
+    mActiveRaytracingPipeline = pipeline.get();
+    mPipelineLastActiveTime[index] = mTimer.GetTotalSeconds();
+}
+
+void DXRExperimentsApp::ReleaseIdlePipelineOutputs()
+{
+    double now = mTimer.GetTotalSeconds();
+    mPipelineLastActiveTime[mActivePipelineIndex] = now;
+
+    if (!mReleaseIdleOutputs) {
+        return;
+    }
+
+    bool gpuIdle = false;
+    for (size_t i = 0; i < mRaytracingPipelines.size(); ++i) {
+        auto &pipeline = mRaytracingPipelines[i];
+        if (!pipeline || pipeline.get() == mActiveRaytracingPipeline || !pipeline->getOutputResource(0)) {
+            continue;
+        }
+        if (now - mPipelineLastActiveTime[i] < mIdleOutputTimeout) {
+            continue;
+        }
+
+        // Outputs may still be referenced by frames in flight
+        if (!gpuIdle) {
+            m_deviceResources->WaitForGpu();
+            gpuIdle = true;
+        }
+        pipeline->releaseOutputResource();
+    }
 }
 
 void DXRExperimentsApp::OnUpdate()
@@ -151,14 +238,34 @@ void DXRExperimentsApp::OnUpdate()
     mCamController->Update(deltaTime);
 
     {
-        if (ui::Combo("Pipeline Select", &mActivePipelineIndex, mPipelineNames.data(), static_cast<int>(mRaytracingPipelines.size()))) {
-            mActiveRaytracingPipeline = mRaytracingPipelines[mActivePipelineIndex].get();
+        int pipelineIndex = mActivePipelineIndex;
+        if (ui::Combo("Pipeline Select", &pipelineIndex, mPipelineNames.data(), static_cast<int>(mPipelineNames.size()))) {
+            ActivatePipeline(pipelineIndex);
         }
 
         ui::Checkbox(mActiveRaytracingPipeline->getName(), mActiveRaytracingPipeline->isActive());
         ui::Checkbox("Denoise Compositor", &mDenoiser->mActive);
+
+        ui::Checkbox("Release Idle Pipeline Outputs", &mReleaseIdleOutputs);
+        if (mReleaseIdleOutputs) {
+            ui::SliderFloat("Idle Timeout (s)", &mIdleOutputTimeout, 1.0f, 300.0f);
+        }
+
+        if (ui::CollapsingHeader("Startup Timeline")) {
+            ui::TextUnformatted(mStartupTimeline.c_str());
+        }
+        if (ui::CollapsingHeader("Texture Cache")) {
+            ui::TextUnformatted(mTextureCache->report().c_str());
+        }
+        if (ui::CollapsingHeader("Upload Queue")) {
+            auto stats = mRtContext->getUploadQueue()->getStats();
+            ui::Text("%.1f MB staged in %llu chunks", stats.bytesStaged / (1024.0 * 1024.0), stats.chunks);
+            ui::Text("%llu batches, %llu stalls on a full staging ring", stats.batches, stats.stalls);
+        }
     }
 
+    ReleaseIdlePipelineOutputs();
+
     if (*mActiveRaytracingPipeline->isActive()) {
         mActiveRaytracingPipeline->userInterface();
         mActiveRaytracingPipeline->update(elapsedTime, GetFrameCount(), m_deviceResources->GetPreviousFrameIndex(), m_deviceResources->GetCurrentFrameIndex(), GetWidth(), GetHeight());
@@ -193,19 +300,37 @@ void DXRExperimentsApp::OnRender()
     } else {
         mActiveRaytracingPipeline->render(commandList, currentFrame, GetWidth(), GetHeight());
 
-        if (dynamic_cast<RealtimeRaytracingPipeline*>(mActiveRaytracingPipeline) && mDenoiser->mActive) {
+        auto realtimePipeline = dynamic_cast<RealtimeRaytracingPipeline*>(mActiveRaytracingPipeline);
+        if (realtimePipeline && mDenoiser->mActive) {
+            std::vector<ID3D12Resource*> denoiserInputs;
             for (int i = 0; i < mActiveRaytracingPipeline->getNumOutputs(); ++i) {
-                mRtContext->transitionResource(mActiveRaytracingPipeline->getOutputResource(i), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+                denoiserInputs.push_back(mActiveRaytracingPipeline->getOutputResource(i));
             }
 
             DenoiseCompositor::InputComponents inputs = {};
             inputs.directLightingSrv = mActiveRaytracingPipeline->getOutputSrvHandle(0);
             inputs.indirectSpecularSrv = mActiveRaytracingPipeline->getOutputSrvHandle(1);
+            // The AOVs the pipeline did not write are left out, see DenoiseCompositor::InputComponents
+            D3D12_GPU_DESCRIPTOR_HANDLE *aovSrvs[AOV_COUNT] = { &inputs.depthSrv, &inputs.normalSrv, &inputs.albedoSrv, nullptr, &inputs.instanceIdSrv };
+            for (UINT aov = 0; aov < AOV_COUNT; ++aov) {
+                if (aovSrvs[aov] && realtimePipeline->getAovResource(aov)) {
+                    denoiserInputs.push_back(realtimePipeline->getAovResource(aov));
+                    *aovSrvs[aov] = realtimePipeline->getAovSrvHandle(aov);
+                }
+            }
+            if (realtimePipeline->getVarianceResource()) {
+                denoiserInputs.push_back(realtimePipeline->getVarianceResource());
+                inputs.varianceSrv = realtimePipeline->getVarianceSrvHandle();
+            }
+
+            for (auto resource : denoiserInputs) {
+                mRtContext->transitionResource(resource, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+            }
 
             mDenoiser->dispatch(commandList, inputs, currentFrame, GetWidth(), GetHeight());
 
-            for (int i = 0; i < mActiveRaytracingPipeline->getNumOutputs(); ++i) {
-                mRtContext->transitionResource(mActiveRaytracingPipeline->getOutputResource(i), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            for (auto resource : denoiserInputs) {
+                mRtContext->transitionResource(resource, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
             }
 
             BlitToBackbuffer(mDenoiser->getOutputResource());
@@ -230,20 +355,19 @@ void DXRExperimentsApp::OnRender()
 
 void DXRExperimentsApp::OnKeyDown(UINT8 key)
 {
+    int numPipelines = static_cast<int>(mRaytracingPipelines.size());
+
     switch (key) {
     case 'F':
         mCamController->EnableFirstPersonMouse(!mCamController->IsFirstPersonMouseEnabled());
         break;
     case VK_RIGHT:
-        mActivePipelineIndex++;
+        ActivatePipeline((mActivePipelineIndex + 1) % numPipelines);
         break;
     case VK_LEFT:
-        mActivePipelineIndex--;
+        ActivatePipeline((mActivePipelineIndex + numPipelines - 1) % numPipelines);
         break;
     }
-
-    mActivePipelineIndex %= mRaytracingPipelines.size();
-    mActiveRaytracingPipeline = mRaytracingPipelines[mActivePipelineIndex].get();
 }
 
 void DXRExperimentsApp::OnDestroy()
@@ -262,10 +386,13 @@ void DXRExperimentsApp::OnSizeChanged(UINT width, UINT height, bool minimized)
 
     UpdateForSizeChange(width, height);
 
-    mCamera->SetAspectRatio(m_aspectRatio);
+    mCamera->SetAspectRatio(1.0f / m_aspectRatio);
 
+    // Pipelines that were never instantiated or had their outputs released create them on activation
     for (auto pipeline : mRaytracingPipelines) {
-        pipeline->createOutputResource(m_deviceResources->GetBackBufferFormat(), GetWidth(), GetHeight());
+        if (pipeline && pipeline->getOutputResource(0)) {
+            pipeline->createOutputResource(m_deviceResources->GetBackBufferFormat(), GetWidth(), GetHeight());
+        }
     }
     mDenoiser->createOutputResource(m_deviceResources->GetBackBufferFormat(), GetWidth(), GetHeight());
 }
@@ -2,6 +2,8 @@
 #include "DenoiseCompositor.h"
 #include "CompiledShaders/DenoiseCompositorH.hlsl.h"
 #include "CompiledShaders/DenoiseCompositorV.hlsl.h"
+#include "CompiledShaders/DenoiseCompositorComposite.hlsl.h"
+#include "CompiledShaders/DenoiseCompositorAtrous.hlsl.h"
 #include "Helpers/RootSignatureGenerator.h"
 #include "Helpers/DirectXRaytracingHelper.h"
 #include "WICTextureLoader.h"
@@ -12,6 +14,28 @@
 
 using nv_helpers_dx12::RootSignatureGenerator;
 
+namespace AtrousParams
+{
+    enum Value
+    {
+        DirectLightingSlot = 0,
+        IndirectSpecularSlot,
+        DepthSlot,
+        NormalSlot,
+        VarianceSlot,
+        AlbedoSlot,
+        InstanceIdSlot,
+        OutputViewSlot,
+        ConstantsSlot,
+        IterationSlot,
+        Count
+    };
+}
+
+// ATROUS_GROUP_SIZE in DenoiseCompositorAtrous.hlsl and ATROUS_MAX_ITERATIONS in AtrousHlslCompat.h
+static const UINT AtrousGroupSize = 8;
+static const int AtrousMaxIterations = 5;
+
 DenoiseCompositor::DenoiseCompositor(DXRFramework::RtContext::SharedPtr context)
     : mRtContext(context), mActive(true)
 {
@@ -35,6 +59,41 @@ DenoiseCompositor::DenoiseCompositor(DXRFramework::RtContext::SharedPtr context)
     computePsoDesc.CS = CD3DX12_SHADER_BYTECODE(g_pDenoiseCompositorV, ARRAYSIZE(g_pDenoiseCompositorV));
     ThrowIfFailed(device->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(&mComputeState[1])));
     NAME_D3D12_OBJECT(mComputeState[1]);
+
+    computePsoDesc.CS = CD3DX12_SHADER_BYTECODE(g_pDenoiseCompositorComposite, ARRAYSIZE(g_pDenoiseCompositorComposite));
+    ThrowIfFailed(device->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(&mComputeState[2])));
+    NAME_D3D12_OBJECT(mComputeState[2]);
+
+    {
+        RootSignatureGenerator rsConfig;
+        // AtrousParams::DirectLightingSlot
+        rsConfig.AddHeapRangesParameter({ {0 /* t0 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0} });
+        // AtrousParams::IndirectSpecularSlot
+        rsConfig.AddHeapRangesParameter({ {1 /* t1 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0} });
+        // AtrousParams::DepthSlot
+        rsConfig.AddHeapRangesParameter({ {2 /* t2 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0} });
+        // AtrousParams::NormalSlot
+        rsConfig.AddHeapRangesParameter({ {3 /* t3 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0} });
+        // AtrousParams::VarianceSlot
+        rsConfig.AddHeapRangesParameter({ {4 /* t4 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0} });
+        // AtrousParams::AlbedoSlot
+        rsConfig.AddHeapRangesParameter({ {5 /* t5 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0} });
+        // AtrousParams::InstanceIdSlot
+        rsConfig.AddHeapRangesParameter({ {6 /* t6 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0} });
+        // AtrousParams::OutputViewSlot
+        rsConfig.AddHeapRangesParameter({ {0 /* u0-u1 */, 2, 0, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0} });
+        // AtrousParams::ConstantsSlot
+        rsConfig.AddRootParameter(D3D12_ROOT_PARAMETER_TYPE_CBV, 0 /* b0 */, 0, 1);
+        // AtrousParams::IterationSlot, AtrousConstants in DenoiseCompositorAtrous.hlsl
+        rsConfig.AddRootParameter(D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS, 1 /* b1 */, 0, 4);
+        mAtrousRootSignature = rsConfig.Generate(device, false);
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC atrousPsoDesc = {};
+        atrousPsoDesc.pRootSignature = mAtrousRootSignature.Get();
+        atrousPsoDesc.CS = CD3DX12_SHADER_BYTECODE(g_pDenoiseCompositorAtrous, ARRAYSIZE(g_pDenoiseCompositorAtrous));
+        ThrowIfFailed(device->CreateComputePipelineState(&atrousPsoDesc, IID_PPV_ARGS(&mAtrousState)));
+        NAME_D3D12_OBJECT(mAtrousState);
+    }
 }
 
 void DenoiseCompositor::loadResources(ID3D12CommandQueue *uploadCommandQueue, UINT frameCount, bool loadMockResources)
@@ -48,6 +107,9 @@ void DenoiseCompositor::loadResources(ID3D12CommandQueue *uploadCommandQueue, UI
     mConstantBuffer->gammaCorrect = false;
     mConstantBuffer->maxKernelSize = 12;
     mConstantBuffer->debugVisualize = 0;
+    mConstantBuffer->phiNormal = 128.0f;
+    mConstantBuffer->phiDepth = 1.0f;
+    mConstantBuffer->phiLuminance = 4.0f;
 
     if (loadMockResources) {
         mTextureResources.resize(2);
@@ -92,6 +154,29 @@ void DenoiseCompositor::createOutputResource(DXGI_FORMAT format, UINT width, UIN
             mOutputSrvGpuHandle[i] = mRtContext->createTextureSRVHandle(mOutputResource[i].Get(), false, mOutputSrvHeapIndex[i]);
         }
     }
+
+    // The outputs of an iteration are one table, the two signals of a set take a range of the heap
+    for (int set = 0; set < 2; ++set) {
+        mRtContext->allocateDescriptorRange(2, mAtrousUavHeapIndex[set]);
+        for (int i = 0; i < 2; ++i) {
+            AllocateUAVTexture(device, DXGI_FORMAT_R16G16B16A16_FLOAT, width, height, mAtrousResource[set][i].ReleaseAndGetAddressOf(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+            D3D12_CPU_DESCRIPTOR_HANDLE uavCpuHandle;
+            mAtrousUavHeapIndex[set][i] = mRtContext->allocateDescriptor(&uavCpuHandle, mAtrousUavHeapIndex[set][i]);
+
+            D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+            uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+            device->CreateUnorderedAccessView(mAtrousResource[set][i].Get(), nullptr, &uavDesc, uavCpuHandle);
+
+            mAtrousUavGpuHandle[set][i] = mRtContext->getDescriptorGPUHandle(mAtrousUavHeapIndex[set][i]);
+        }
+
+        for (int i = 0; i < 2; ++i) {
+            D3D12_CPU_DESCRIPTOR_HANDLE srvCpuHandle;
+            mAtrousSrvHeapIndex[set][i] = mRtContext->allocateDescriptor(&srvCpuHandle, mAtrousSrvHeapIndex[set][i]);
+            mAtrousSrvGpuHandle[set][i] = mRtContext->createTextureSRVHandle(mAtrousResource[set][i].Get(), false, mAtrousSrvHeapIndex[set][i]);
+        }
+    }
 }
 
 void DenoiseCompositor::userInterface()
@@ -101,7 +186,19 @@ void DenoiseCompositor::userInterface()
     ui::SliderFloat("Gamma", &mConstantBuffer->gamma, 1.0f, 3.0f);
     ui::Checkbox("Tonemap", (bool*)&mConstantBuffer->tonemap);
     ui::Checkbox("Gamma correct", (bool*)&mConstantBuffer->gammaCorrect);
-    ui::SliderInt("Max Kernel Size", &mConstantBuffer->maxKernelSize, 1, 25);
+    // The a-trous filter needs the guides of temporal accumulation, see InputComponents
+    const char *filters[] = { "Joint Bilateral", "A-Trous" };
+    ui::Combo("Filter", &mFilter, filters, ARRAYSIZE(filters));
+    if (mFilter == Atrous) {
+        ui::SliderInt("A-Trous Iterations", &mAtrousIterations, 0, AtrousMaxIterations);
+        ui::SliderFloat("Phi Normal", &mConstantBuffer->phiNormal, 1.0f, 256.0f);
+        ui::SliderFloat("Phi Depth", &mConstantBuffer->phiDepth, 0.1f, 8.0f);
+        ui::SliderFloat("Phi Luminance", &mConstantBuffer->phiLuminance, 0.5f, 16.0f);
+        ui::Checkbox("Demodulate Albedo", &mDemodulateAlbedo);
+        ui::Checkbox("Instance Edges", &mInstanceEdges);
+    } else {
+        ui::SliderInt("Max Kernel Size", &mConstantBuffer->maxKernelSize, 1, 25);
+    }
     ui::SliderInt("Debug Visualize", (int*)&mConstantBuffer->debugVisualize, 0, 3);
     ui::End();
 }
@@ -117,6 +214,11 @@ void DenoiseCompositor::dispatch(ID3D12GraphicsCommandList *commandList, Denoise
 
     mRtContext->bindDescriptorHeap();
 
+    if (mFilter == Atrous && inputs.depthSrv.ptr != 0 && inputs.normalSrv.ptr != 0 && inputs.varianceSrv.ptr != 0) {
+        dispatchAtrous(commandList, inputs, frameIndex, width, height);
+        return;
+    }
+
     commandList->SetComputeRootSignature(mComputeRootSignature.Get());
     commandList->SetComputeRootConstantBufferView(3, mConstantBuffer.GpuVirtualAddress(frameIndex));
 
@@ -146,3 +248,69 @@ void DenoiseCompositor::dispatch(ID3D12GraphicsCommandList *commandList, Denoise
         mRtContext->insertUAVBarrier(mOutputResource[1].Get());
     }
 }
+
+
+void DenoiseCompositor::dispatchAtrous(ID3D12GraphicsCommandList *commandList, const InputComponents &inputs, UINT frameIndex, UINT width, UINT height)
+{
+    D3D12_GPU_DESCRIPTOR_HANDLE directLighting = inputs.directLightingSrv;
+    D3D12_GPU_DESCRIPTOR_HANDLE indirectSpecular = inputs.indirectSpecularSrv;
+    bool setIsShaderResource[2] = { false, false };
+
+    // a-trous iterations, each reads the set the last one wrote and doubles the step between the taps
+    {
+        commandList->SetComputeRootSignature(mAtrousRootSignature.Get());
+        commandList->SetPipelineState(mAtrousState.Get());
+        commandList->SetComputeRootDescriptorTable(AtrousParams::DepthSlot, inputs.depthSrv);
+        commandList->SetComputeRootDescriptorTable(AtrousParams::NormalSlot, inputs.normalSrv);
+        commandList->SetComputeRootDescriptorTable(AtrousParams::VarianceSlot, inputs.varianceSrv);
+        // The depth stands in for the optional AOVs that are missing, the shader does not read them then
+        commandList->SetComputeRootDescriptorTable(AtrousParams::AlbedoSlot, inputs.albedoSrv.ptr ? inputs.albedoSrv : inputs.depthSrv);
+        commandList->SetComputeRootDescriptorTable(AtrousParams::InstanceIdSlot, inputs.instanceIdSrv.ptr ? inputs.instanceIdSrv : inputs.depthSrv);
+        commandList->SetComputeRootConstantBufferView(AtrousParams::ConstantsSlot, mConstantBuffer.GpuVirtualAddress(frameIndex));
+        commandList->SetComputeRoot32BitConstant(AtrousParams::IterationSlot, mAtrousIterations, 1);
+        commandList->SetComputeRoot32BitConstant(AtrousParams::IterationSlot, mDemodulateAlbedo && inputs.albedoSrv.ptr != 0, 2);
+        commandList->SetComputeRoot32BitConstant(AtrousParams::IterationSlot, mInstanceEdges && inputs.instanceIdSrv.ptr != 0, 3);
+
+        for (int iteration = 0; iteration < mAtrousIterations; ++iteration) {
+            int set = iteration % 2;
+            if (setIsShaderResource[set]) {
+                for (int i = 0; i < 2; ++i) {
+                    mRtContext->transitionResource(mAtrousResource[set][i].Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+                }
+            }
+
+            commandList->SetComputeRootDescriptorTable(AtrousParams::DirectLightingSlot, directLighting);
+            commandList->SetComputeRootDescriptorTable(AtrousParams::IndirectSpecularSlot, indirectSpecular);
+            commandList->SetComputeRootDescriptorTable(AtrousParams::OutputViewSlot, mAtrousUavGpuHandle[set][0]);
+            commandList->SetComputeRoot32BitConstant(AtrousParams::IterationSlot, iteration, 0);
+            commandList->Dispatch(Math::DivideByMultiple(width, AtrousGroupSize), Math::DivideByMultiple(height, AtrousGroupSize), 1);
+
+            for (int i = 0; i < 2; ++i) {
+                mRtContext->transitionResource(mAtrousResource[set][i].Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+            }
+            setIsShaderResource[set] = true;
+            directLighting = mAtrousSrvGpuHandle[set][0];
+            indirectSpecular = mAtrousSrvGpuHandle[set][1];
+        }
+    }
+
+    // composite
+    {
+        const UINT DispatchGroupWidth = 64;
+
+        commandList->SetComputeRootSignature(mComputeRootSignature.Get());
+        commandList->SetPipelineState(mComputeState[2].Get());
+        commandList->SetComputeRootDescriptorTable(0, directLighting);
+        commandList->SetComputeRootDescriptorTable(1, indirectSpecular);
+        commandList->SetComputeRootDescriptorTable(2, mOutputUavGpuHandle[1]);
+        commandList->SetComputeRootConstantBufferView(3, mConstantBuffer.GpuVirtualAddress(frameIndex));
+        commandList->Dispatch(width, Math::DivideByMultiple(height, DispatchGroupWidth), 1);
+
+        for (int set = 0; set < 2; ++set) {
+            for (int i = 0; setIsShaderResource[set] && i < 2; ++i) {
+                mRtContext->transitionResource(mAtrousResource[set][i].Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            }
+        }
+        mRtContext->insertUAVBarrier(mOutputResource[1].Get());
+    }
+}
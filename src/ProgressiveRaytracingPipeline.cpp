@@ -1,14 +1,17 @@
 #include "pch.h"
 #include "ProgressiveRaytracingPipeline.h"
 #include "CompiledShaders/ProgressiveRaytracing.hlsl.h"
-#include "WICTextureLoader.h"
-#include "DDSTextureLoader.h"
-#include "ResourceUploadBatch.h"
+#include "CompiledShaders/AdaptiveSampling.hlsl.h"
 #include "Helpers/DirectXRaytracingHelper.h"
+#include "Helpers/RootSignatureGenerator.h"
 #include "ImGuiRendererDX.h"
+#include "Math/Common.h"
+#include "SamplingHlslCompat.h"
+#include <algorithm>
 #include <chrono>
 
 using namespace DXRFramework;
+using nv_helpers_dx12::RootSignatureGenerator;
 
 static XMFLOAT4 pointLightColor = XMFLOAT4(0.2f, 0.8f, 0.6f, 2.0f);
 static XMFLOAT4 dirLightColor = XMFLOAT4(0.9f, 0.9f, 0.9f, 1.0f);
@@ -20,10 +23,31 @@ namespace GlobalRootSignatureParams
         AccelerationStructureSlot = 0,
         OutputViewSlot,
         PerFrameConstantsSlot,
+        MomentsViewSlot,
+        TileActiveViewSlot,
+        EnvironmentAliasTableSlot,
+        EnvironmentCubemapSlot,
+        PathLengthHistogramViewSlot,
+        LightTreeNodesSlot,
+        LightTreeLightsSlot,
         Count 
     };
 }
 
+namespace AdaptiveSamplingParams
+{
+    enum Value
+    {
+        MomentsViewSlot = 0,
+        TileActiveViewSlot,
+        PerFrameConstantsSlot,
+        Count
+    };
+}
+
+// ADAPTIVE_TILE_SIZE in AdaptiveSampling.hlsli
+static const UINT AdaptiveTileSize = 16;
+
 ProgressiveRaytracingPipeline::ProgressiveRaytracingPipeline(RtContext::SharedPtr context) :
     mRtContext(context),
     mFrameAccumulationEnabled(true),
@@ -44,12 +68,26 @@ ProgressiveRaytracingPipeline::ProgressiveRaytracingPipeline(RtContext::SharedPt
             config.AddHeapRangesParameter({{0 /* u0 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0}}); 
             // GlobalRootSignatureParams::PerFrameConstantsSlot
             config.AddRootParameter(D3D12_ROOT_PARAMETER_TYPE_CBV, 0 /* b0 */); 
+            // GlobalRootSignatureParams::MomentsViewSlot
+            config.AddHeapRangesParameter({{1 /* u1 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0}}); 
+            // GlobalRootSignatureParams::TileActiveViewSlot
+            config.AddHeapRangesParameter({{2 /* u2 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0}}); 
+            // GlobalRootSignatureParams::EnvironmentAliasTableSlot
+            config.AddHeapRangesParameter({{1 /* t1 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0}}); 
+            // GlobalRootSignatureParams::EnvironmentCubemapSlot
+            config.AddHeapRangesParameter({{2 /* t2 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0}}); 
+            // GlobalRootSignatureParams::PathLengthHistogramViewSlot
+            config.AddHeapRangesParameter({{3 /* u3 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0}}); 
+            // GlobalRootSignatureParams::LightTreeNodesSlot
+            config.AddHeapRangesParameter({{3 /* t3 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0}}); 
+            // GlobalRootSignatureParams::LightTreeLightsSlot
+            config.AddHeapRangesParameter({{4 /* t4 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0}}); 
 
             D3D12_STATIC_SAMPLER_DESC cubeSampler = {};
             cubeSampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
             cubeSampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
             cubeSampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-            cubeSampler.Filter = D3D12_FILTER_MIN_MAG_LINEAR_MIP_POINT;
+            cubeSampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
             cubeSampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
             cubeSampler.ShaderRegister = 0;
             config.AddStaticSampler(cubeSampler);
@@ -67,9 +105,31 @@ ProgressiveRaytracingPipeline::ProgressiveRaytracingPipeline(RtContext::SharedPt
     mRtProgram = RtProgram::create(context, programDesc);
     mRtState = RtState::create(context); 
     mRtState->setProgram(mRtProgram);
-    mRtState->setMaxTraceRecursionDepth(4);
+    mRtState->setMaxTraceRecursionDepth(MAX_RADIANCE_RAY_DEPTH + 2);
     mRtState->setMaxAttributeSize(8);
-    mRtState->setMaxPayloadSize(20);
+    mRtState->setMaxPayloadSize(32);
+
+    // Create the state object on the constructing thread instead of lazily on the first render
+    mRtState->getFallbackRtso();
+
+    {
+        auto device = context->getDevice();
+
+        RootSignatureGenerator rsConfig;
+        // AdaptiveSamplingParams::MomentsViewSlot
+        rsConfig.AddHeapRangesParameter({ {0 /* u0 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0} });
+        // AdaptiveSamplingParams::TileActiveViewSlot
+        rsConfig.AddHeapRangesParameter({ {1 /* u1 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0} });
+        // AdaptiveSamplingParams::PerFrameConstantsSlot
+        rsConfig.AddRootParameter(D3D12_ROOT_PARAMETER_TYPE_CBV, 0 /* b0 */, 0, 1);
+        mAdaptiveRootSignature = rsConfig.Generate(device, false);
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
+        computePsoDesc.pRootSignature = mAdaptiveRootSignature.Get();
+        computePsoDesc.CS = CD3DX12_SHADER_BYTECODE(g_pAdaptiveSampling, ARRAYSIZE(g_pAdaptiveSampling));
+        ThrowIfFailed(device->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(&mAdaptiveState)));
+        NAME_D3D12_OBJECT(mAdaptiveState);
+    }
 
     mShaderDebugOptions.maxIterations = 1024;
     mShaderDebugOptions.cosineHemisphereSampling = true;
@@ -82,6 +142,20 @@ ProgressiveRaytracingPipeline::ProgressiveRaytracingPipeline(RtContext::SharedPt
     mShaderDebugOptions.noIndirectDiffuse = false;
     mShaderDebugOptions.environmentStrength = 1.0f;
     mShaderDebugOptions.debug = 0;
+    mShaderDebugOptions.adaptiveSampling = false;
+    mShaderDebugOptions.adaptiveMinSamples = 16;
+    mShaderDebugOptions.adaptiveErrorThreshold = 0.01f;
+    mShaderDebugOptions.sampleSequence = SAMPLE_SEQUENCE_BLUE_NOISE_SOBOL;
+    mShaderDebugOptions.environmentImportanceSampling = true;
+    // Off by default, the blurred misses would bias the reference
+    mShaderDebugOptions.prefilteredEnvironmentMisses = false;
+    mShaderDebugOptions.environmentIrradiance = 0;
+    // A single bounce like before, the roulette only applies once more are allowed
+    mShaderDebugOptions.maxBounces = 1;
+    mShaderDebugOptions.russianRoulette = true;
+    mShaderDebugOptions.russianRouletteDepth = 2;
+    mShaderDebugOptions.pathLengthHistogram = false;
+    mShaderDebugOptions.manyLightSampling = 0;
 
     auto now = std::chrono::high_resolution_clock::now();
     auto msTime = std::chrono::time_point_cast<std::chrono::milliseconds>(now);
@@ -101,27 +175,144 @@ void ProgressiveRaytracingPipeline::buildAccelerationStructures()
     mRtScene->build(mRtContext, mRtProgram->getHitProgramCount());
 }
 
-void ProgressiveRaytracingPipeline::loadResources(ID3D12CommandQueue *uploadCommandQueue, UINT frameCount)
-{        
-    mTextureResources.resize(2);
-    mTextureSrvGpuHandles.resize(2);
-
-    // Create and upload global textures
+void ProgressiveRaytracingPipeline::loadResources(TextureCache::SharedPtr textureCache, UINT frameCount)
+{
     auto device = mRtContext->getDevice();
-    ResourceUploadBatch resourceUpload(device);
-    resourceUpload.Begin();
-    {
-        ThrowIfFailed(CreateWICTextureFromFile(device, resourceUpload, L"..\\assets\\textures\\HdrStudioProductNightStyx001_JPG_8K.jpg", &mTextureResources[0], true));
-        ThrowIfFailed(CreateDDSTextureFromFile(device, resourceUpload, L"..\\assets\\textures\\CathedralRadiance.dds", &mTextureResources[1]));
-    }
-    auto uploadResourcesFinished = resourceUpload.End(uploadCommandQueue);
-    uploadResourcesFinished.wait();
 
-    mTextureSrvGpuHandles[0] = mRtContext->createTextureSRVHandle(mTextureResources[0].Get());
-    mTextureSrvGpuHandles[1] = mRtContext->createTextureSRVHandle(mTextureResources[1].Get(), true);
+    // Global textures are shared with other pipelines and decoded in the background
+    mPendingTextures.clear();
+    mPendingTextures.push_back(textureCache->loadAsync(L"..\\assets\\textures\\HdrStudioProductNightStyx001_JPG_8K.jpg", TextureCache::GenerateMips));
+    mPendingTextures.push_back(textureCache->loadAsync(L"..\\assets\\textures\\CathedralRadiance.dds", TextureCache::Cubemap | TextureCache::KeepCpuCopy | TextureCache::PrefilterEnvironment));
+
+    // The alias table over the cubemap the miss shader samples, built as soon as its texels are there.
+    // Its descriptor is allocated on this thread, like every other allocation from the shared heap.
+    auto context = mRtContext;
+    auto environment = mPendingTextures[1];
+    D3D12_CPU_DESCRIPTOR_HANDLE srvCpuHandle;
+    UINT srvHeapIndex = mRtContext->allocateDescriptor(&srvCpuHandle);
+    mPendingEnvironmentTable = std::async(std::launch::async, [context, environment, srvHeapIndex] {
+        return createEnvironmentTable(context, environment.get(), srvHeapIndex);
+    });
 
     // Create per-frame constant buffer
     mConstantBuffer.Create(device, frameCount, L"PerFrameConstantBuffer");
+
+    mFrameCount = frameCount;
+    mReadbackGeneration.assign(frameCount, UINT_MAX);
+    mReadbackAccumCount.assign(frameCount, 0);
+
+    // The path length histogram is cleared from a buffer of zeros before every frame and copied to
+    // the frame's readback range after it
+    const UINT64 histogramSize = PATH_LENGTH_HISTOGRAM_SIZE * sizeof(UINT);
+    AllocateUAVBuffer(device, histogramSize, mPathLengthResource.ReleaseAndGetAddressOf(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    {
+        D3D12_CPU_DESCRIPTOR_HANDLE uavCpuHandle;
+        mPathLengthUavHeapIndex = mRtContext->allocateDescriptor(&uavCpuHandle, mPathLengthUavHeapIndex);
+
+        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+        uavDesc.Format = DXGI_FORMAT_R32_UINT;
+        uavDesc.Buffer.NumElements = PATH_LENGTH_HISTOGRAM_SIZE;
+        device->CreateUnorderedAccessView(mPathLengthResource.Get(), nullptr, &uavDesc, uavCpuHandle);
+
+        mPathLengthUavGpuHandle = mRtContext->getDescriptorGPUHandle(mPathLengthUavHeapIndex);
+    }
+
+    UINT zeros[PATH_LENGTH_HISTOGRAM_SIZE] = {};
+    AllocateUploadBuffer(device, zeros, histogramSize, mPathLengthZeros.ReleaseAndGetAddressOf(), L"PathLengthZeros");
+
+    auto readbackHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
+    auto readbackDesc = CD3DX12_RESOURCE_DESC::Buffer(histogramSize * frameCount);
+    ThrowIfFailed(device->CreateCommittedResource(&readbackHeapProperties, D3D12_HEAP_FLAG_NONE, &readbackDesc, D3D12_RESOURCE_STATE_COPY_DEST,
+                                                  nullptr, IID_PPV_ARGS(mPathLengthReadback.ReleaseAndGetAddressOf())));
+    NAME_D3D12_OBJECT(mPathLengthReadback);
+    mPathLengthReadbackGeneration.assign(frameCount, UINT_MAX);
+    mPathLengthExpectedSamples.assign(frameCount, UINT64_MAX);
+    mPathLengthCounts.assign(PATH_LENGTH_HISTOGRAM_SIZE, 0);
+
+    // Empty until many light sampling is turned on, the first update() may rebuild either set
+    for (auto &lightTree : mLightTrees) {
+        createLightTree(lightTree, 0, mLightIntensity);
+    }
+    mFramesSinceLightTreeSwap = frameCount;
+}
+
+ProgressiveRaytracingPipeline::EnvironmentTable ProgressiveRaytracingPipeline::createEnvironmentTable(RtContext::SharedPtr context, TextureCache::TextureHandle environment, UINT srvHeapIndex)
+{
+    EnvironmentTable table;
+
+    RtEnvironmentSampler::SharedPtr sampler;
+    if (!environment->cpuTexels.empty()) {
+        auto start = std::chrono::high_resolution_clock::now();
+        sampler = RtEnvironmentSampler::build(environment->cpuTexels.data(), environment->cpuWidth, environment->cpuHeight, true, context->getJobSystem().get());
+        table.buildTimeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    } else {
+        OutputDebugStringA("Environment importance sampling falls back to BSDF sampling, the environment has no CPU copy\n");
+    }
+
+    // Without a table the shaders fall back to BSDF sampling, a single entry keeps the view valid
+    RtEnvironmentSampler::Entry dummy = { 1.0f, 0, 0.0f };
+    const void *data = &dummy;
+    UINT64 size = sizeof(dummy);
+    if (sampler) {
+        table.width = sampler->getWidth();
+        table.height = sampler->getHeight();
+        data = sampler->getTable().data();
+        size = sampler->getTable().size() * sizeof(RtEnvironmentSampler::Entry);
+    }
+
+    auto uploadQueue = context->getUploadQueue();
+    table.buffer = CreateBuffer(context->getDevice(), size, D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_COMMON, kDefaultHeapProps);
+    uploadQueue->waitOnCpu(uploadQueue->uploadBuffer(table.buffer.Get(), data, size));
+    table.srvGpuHandle = context->createBufferSRVHandle(table.buffer.Get(), true, 4, srvHeapIndex);
+    return table;
+}
+
+void ProgressiveRaytracingPipeline::createLightTree(LightTreeBuffers &buffers, UINT lightCount, float totalIntensity)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    // Above the floor of Machines.fbx and around its machines
+    auto lights = RtLightTree::scatter(lightCount, CpuMath::float3(-12.0f, 0.2f, -12.0f), CpuMath::float3(12.0f, 6.0f, 12.0f), totalIntensity, 1);
+    auto tree = RtLightTree::build(lights, mRtContext->getJobSystem().get());
+    buffers.buildTimeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    buffers.lightCount = lightCount;
+    buffers.nodeCount = tree ? UINT(tree->getNodes().size()) : 0;
+    buffers.depth = tree ? tree->getDepth() : 0;
+    buffers.totalIntensity = totalIntensity;
+
+    // Without lights the shaders never read the buffers, a single zero node and light keep the views valid
+    RtLightTree::Node dummyNode = {};
+    RtLightTree::Light dummyLight = {};
+    const void *nodeData = tree ? tree->getNodes().data() : &dummyNode;
+    const void *lightData = tree ? tree->getLights().data() : &dummyLight;
+    UINT64 nodesSize = (std::max)(buffers.nodeCount, 1u) * sizeof(RtLightTree::Node);
+    UINT64 lightsSize = (std::max)(buffers.lightCount, 1u) * sizeof(RtLightTree::Light);
+
+    auto device = mRtContext->getDevice();
+    auto uploadQueue = mRtContext->getUploadQueue();
+    buffers.nodes = CreateBuffer(device, nodesSize, D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_COMMON, kDefaultHeapProps);
+    buffers.lights = CreateBuffer(device, lightsSize, D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_COMMON, kDefaultHeapProps);
+    uploadQueue->uploadBuffer(buffers.nodes.Get(), nodeData, nodesSize);
+    uploadQueue->waitOnCpu(uploadQueue->uploadBuffer(buffers.lights.Get(), lightData, lightsSize));
+
+    // The views are rewritten in place, the set is only rebuilt once no frame in flight reads it
+    auto createRawSrv = [&](ID3D12Resource *resource, UINT64 size, UINT &heapIndex, D3D12_GPU_DESCRIPTOR_HANDLE &gpuHandle) {
+        D3D12_CPU_DESCRIPTOR_HANDLE srvCpuHandle;
+        heapIndex = mRtContext->allocateDescriptor(&srvCpuHandle, heapIndex);
+
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+        srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_RAW;
+        srvDesc.Buffer.NumElements = UINT(size / sizeof(UINT));
+        device->CreateShaderResourceView(resource, &srvDesc, srvCpuHandle);
+
+        gpuHandle = mRtContext->getDescriptorGPUHandle(heapIndex);
+    };
+    createRawSrv(buffers.nodes.Get(), nodesSize, buffers.nodesSrvHeapIndex, buffers.nodesSrvGpuHandle);
+    createRawSrv(buffers.lights.Get(), lightsSize, buffers.lightsSrvHeapIndex, buffers.lightsSrvGpuHandle);
 }
 
 void ProgressiveRaytracingPipeline::createOutputResource(DXGI_FORMAT format, UINT width, UINT height)
@@ -146,6 +337,112 @@ void ProgressiveRaytracingPipeline::createOutputResource(DXGI_FORMAT format, UIN
         mOutputSrvHeapIndex = mRtContext->allocateDescriptor(&srvCpuHandle, mOutputSrvHeapIndex);
         mOutputSrvGpuHandle = mRtContext->createTextureSRVHandle(mOutputResource.Get(), false, mOutputSrvHeapIndex);
     }
+
+    // Moments keep full precision, the variance of converged pixels is small against their mean
+    AllocateUAVTexture(device, DXGI_FORMAT_R32G32B32A32_FLOAT, width, height, mMomentsResource.ReleaseAndGetAddressOf(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    {
+        D3D12_CPU_DESCRIPTOR_HANDLE uavCpuHandle;
+        mMomentsUavHeapIndex = mRtContext->allocateDescriptor(&uavCpuHandle, mMomentsUavHeapIndex);
+
+        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+        device->CreateUnorderedAccessView(mMomentsResource.Get(), nullptr, &uavDesc, uavCpuHandle);
+
+        mMomentsUavGpuHandle = mRtContext->getDescriptorGPUHandle(mMomentsUavHeapIndex);
+    }
+
+    mTilesX = Math::DivideByMultiple(width, AdaptiveTileSize);
+    mTilesY = Math::DivideByMultiple(height, AdaptiveTileSize);
+    UINT tileCount = mTilesX * mTilesY;
+    AllocateUAVBuffer(device, tileCount * sizeof(UINT), mTileActiveResource.ReleaseAndGetAddressOf(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    {
+        D3D12_CPU_DESCRIPTOR_HANDLE uavCpuHandle;
+        mTileActiveUavHeapIndex = mRtContext->allocateDescriptor(&uavCpuHandle, mTileActiveUavHeapIndex);
+
+        // Typed, the compute path of the Fallback Layer does not index structured buffers
+        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+        uavDesc.Format = DXGI_FORMAT_R32_UINT;
+        uavDesc.Buffer.NumElements = tileCount;
+        device->CreateUnorderedAccessView(mTileActiveResource.Get(), nullptr, &uavDesc, uavCpuHandle);
+
+        mTileActiveUavGpuHandle = mRtContext->getDescriptorGPUHandle(mTileActiveUavHeapIndex);
+    }
+
+    auto readbackHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
+    auto readbackDesc = CD3DX12_RESOURCE_DESC::Buffer(UINT64(tileCount) * sizeof(UINT) * mFrameCount);
+    ThrowIfFailed(device->CreateCommittedResource(&readbackHeapProperties, D3D12_HEAP_FLAG_NONE, &readbackDesc, D3D12_RESOURCE_STATE_COPY_DEST,
+                                                  nullptr, IID_PPV_ARGS(mTileActiveReadback.ReleaseAndGetAddressOf())));
+    NAME_D3D12_OBJECT(mTileActiveReadback);
+    mReadbackGeneration.assign(mFrameCount, UINT_MAX);
+}
+
+void ProgressiveRaytracingPipeline::releaseOutputResource()
+{
+    mOutputResource.Reset();
+    mMomentsResource.Reset();
+    mTileActiveResource.Reset();
+    mTileActiveReadback.Reset();
+
+    // Accumulated samples are lost with the output texture
+    mAccumCount = 0;
+    ++mAccumGeneration;
+    mConverged = false;
+}
+
+void ProgressiveRaytracingPipeline::readBackTileStates(UINT frameIndex)
+{
+    // The frame that last used this index has finished, so have its copies. Its tile states count once
+    // the ray generation shader starts using them, see ProgressiveRaytracing.hlsl.
+    if (mReadbackGeneration[frameIndex] != mAccumGeneration || mReadbackAccumCount[frameIndex] + 1 < mShaderDebugOptions.adaptiveMinSamples) {
+        return;
+    }
+
+    UINT tileCount = mTilesX * mTilesY;
+    SIZE_T offset = SIZE_T(frameIndex) * tileCount * sizeof(UINT);
+    D3D12_RANGE readRange = { offset, offset + tileCount * sizeof(UINT) };
+    void *data;
+    ThrowIfFailed(mTileActiveReadback->Map(0, &readRange, &data));
+    const UINT *tileActive = reinterpret_cast<const UINT*>(static_cast<const uint8_t*>(data) + offset);
+    mActiveTileCount = 0;
+    for (UINT tile = 0; tile < tileCount; ++tile) {
+        mActiveTileCount += tileActive[tile] ? 1 : 0;
+    }
+    D3D12_RANGE writeRange = { 0, 0 };
+    mTileActiveReadback->Unmap(0, &writeRange);
+
+    mConverged = mActiveTileCount == 0;
+}
+
+void ProgressiveRaytracingPipeline::readBackPathLengths(UINT frameIndex)
+{
+    // Like the tile states, the copy of the frame that last used this index has finished. Each frame's
+    // counts are added once, and only to the accumulation they were rendered for.
+    if (mPathLengthReadbackGeneration[frameIndex] != mAccumGeneration) {
+        return;
+    }
+    mPathLengthReadbackGeneration[frameIndex] = UINT_MAX;
+
+    SIZE_T offset = SIZE_T(frameIndex) * PATH_LENGTH_HISTOGRAM_SIZE * sizeof(UINT);
+    D3D12_RANGE readRange = { offset, offset + PATH_LENGTH_HISTOGRAM_SIZE * sizeof(UINT) };
+    void *data;
+    ThrowIfFailed(mPathLengthReadback->Map(0, &readRange, &data));
+    const UINT *counts = reinterpret_cast<const UINT*>(static_cast<const uint8_t*>(data) + offset);
+    UINT64 samples = 0;
+    for (UINT length = 0; length < PATH_LENGTH_HISTOGRAM_SIZE; ++length) {
+        mPathLengthCounts[length] += counts[length];
+        samples += counts[length];
+    }
+    D3D12_RANGE writeRange = { 0, 0 };
+    mPathLengthReadback->Unmap(0, &writeRange);
+
+    // Every traced pixel counts one path, anything else means pixels were traced more than once or not at all
+    UINT64 expectedSamples = mPathLengthExpectedSamples[frameIndex];
+    if (expectedSamples != UINT64_MAX && samples != expectedSamples) {
+        char message[128];
+        sprintf_s(message, "Path length histogram: %llu samples in a frame that traced %llu pixels\n", samples, expectedSamples);
+        OutputDebugStringA(message);
+    }
 }
 
 inline void calculateCameraVariables(Math::Camera &camera, float aspectRatio, XMFLOAT4 *U, XMFLOAT4 *V, XMFLOAT4 *W)
@@ -180,19 +477,53 @@ void ProgressiveRaytracingPipeline::update(float elapsedTime, UINT elapsedFrames
         elapsedTime = 142.0f;
     }
 
+    if (mShaderDebugOptions.adaptiveSampling) {
+        readBackTileStates(frameIndex);
+    }
+    if (mShaderDebugOptions.pathLengthHistogram) {
+        readBackPathLengths(frameIndex);
+    }
+
+    // Frames in flight may still read the current set of light tree buffers, but no longer the other
+    ++mFramesSinceLightTreeSwap;
+    const LightTreeBuffers &lightTree = mLightTrees[mLightTreeIndex];
+    UINT lightCount = mShaderDebugOptions.manyLightSampling ? mLightCount : 0;
+    if ((lightTree.lightCount != lightCount || lightTree.totalIntensity != mLightIntensity) && mFramesSinceLightTreeSwap >= mFrameCount) {
+        mLightTreeIndex ^= 1;
+        createLightTree(mLightTrees[mLightTreeIndex], lightCount, mLightIntensity);
+        mFramesSinceLightTreeSwap = 0;
+        mLastCameraVPMatrix = Math::Matrix4();
+    }
+
     if (hasCameraMoved(*mCamera, mLastCameraVPMatrix) || !mFrameAccumulationEnabled) {
         mAccumCount = 0;
         mLastCameraVPMatrix = mCamera->GetViewProjMatrix();
+        ++mAccumGeneration;
+        mConverged = false;
+        mActiveTileCount = mTilesX * mTilesY;
+        std::fill(mPathLengthCounts.begin(), mPathLengthCounts.end(), 0);
     }
 
     CameraParams &cameraParams = mConstantBuffer->cameraParams;
     XMStoreFloat4(&cameraParams.worldEyePos, mCamera->GetPosition());
-    calculateCameraVariables(*mCamera, mCamera->GetAspectRatio(), &cameraParams.U, &cameraParams.V, &cameraParams.W);
-    float xJitter = (mRngDist(mRng) - 0.5f) / float(width);
-    float yJitter = (mRngDist(mRng) - 0.5f) / float(height);
+    // Math::Camera keeps height over width
+    calculateCameraVariables(*mCamera, 1.0f / mCamera->GetAspectRatio(), &cameraParams.U, &cameraParams.V, &cameraParams.W);
+    float xJitter, yJitter;
+    if (mShaderDebugOptions.sampleSequence == SAMPLE_SEQUENCE_RANDOM) {
+        xJitter = (mRngDist(mRng) - 0.5f) / float(width);
+        yJitter = (mRngDist(mRng) - 0.5f) / float(height);
+    } else {
+        // The camera dimensions of the sequence, shared by all pixels
+        xJitter = (Sampling::sampleToUnitFloat(Sampling::sobolOwen(mAccumCount, SAMPLE_DIMENSION_CAMERA, 0)) - 0.5f) / float(width);
+        yJitter = (Sampling::sampleToUnitFloat(Sampling::sobolOwen(mAccumCount, SAMPLE_DIMENSION_CAMERA + 1, 0)) - 0.5f) / float(height);
+    }
     cameraParams.jitters = XMFLOAT2(xJitter, yJitter);
     cameraParams.frameCount = elapsedFrames;
-    cameraParams.accumCount = mAccumCount++;
+    cameraParams.accumCount = mAccumCount;
+    // Once every tile has converged the frames render nothing and do not count
+    if (!mConverged) {
+        ++mAccumCount;
+    }
 
     XMVECTOR dirLightVector = XMVectorSet(0.3f, -0.2f, -1.0f, 0.0f);
     XMMATRIX rotation =  XMMatrixRotationY(sin(elapsedTime * 0.2f) * 3.14f * 0.5f);
@@ -207,6 +538,14 @@ void ProgressiveRaytracingPipeline::update(float elapsedTime, UINT elapsedFrames
     XMStoreFloat4(&mConstantBuffer->pointLight.worldPos, pointLightPos);
     mConstantBuffer->pointLight.color = pointLightColor;
 
+    mConstantBuffer->environmentSampling.tableWidth = mEnvironmentTable.width;
+    mConstantBuffer->environmentSampling.tableHeight = mEnvironmentTable.height;
+    if (!mTextures.empty()) {
+        mConstantBuffer->environmentLighting.radianceMipCount = mTextures[1]->prefilteredMipCount;
+        memcpy(mConstantBuffer->environmentLighting.irradianceSH, mTextures[1]->irradianceSH, sizeof(mTextures[1]->irradianceSH));
+    }
+    mConstantBuffer->lightTree.lightCount = mLightTrees[mLightTreeIndex].lightCount;
+    mConstantBuffer->lightTree.nodeCount = mLightTrees[mLightTreeIndex].nodeCount;
     mConstantBuffer->options = mShaderDebugOptions;
 
     mConstantBuffer.CopyStagingToGpu(frameIndex);
@@ -214,22 +553,38 @@ void ProgressiveRaytracingPipeline::update(float elapsedTime, UINT elapsedFrames
 
 void ProgressiveRaytracingPipeline::render(ID3D12GraphicsCommandList *commandList, UINT frameIndex, UINT width, UINT height)
 {
+    if (mConverged) {
+        return;
+    }
+
     // Update shader table root arguments
     auto program = mRtBindings->getProgram();
 
-    for (UINT rayType = 0; rayType < program->getHitProgramCount(); ++rayType) {
-        for (UINT instance = 0; instance < mRtScene->getNumInstances(); ++instance) {
-            auto &hitVars = mRtBindings->getHitVars(rayType, instance);
-            hitVars->appendHeapRanges(mRtScene->getModel(instance)->getVertexBufferSrvHandle().ptr);
-            hitVars->appendHeapRanges(mRtScene->getModel(instance)->getIndexBufferSrvHandle().ptr);
-            hitVars->append32BitConstants((void*)&mMaterials[instance].params, SizeOfInUint32(MaterialParams));
+    // Every instance writes only its own hit records
+    mRtContext->getJobSystem()->parallelFor(0, mRtScene->getNumInstances(), 64, [&](UINT begin, UINT end) {
+        for (UINT instance = begin; instance < end; ++instance) {
+            auto model = mRtScene->getModel(instance);
+            for (UINT rayType = 0; rayType < program->getHitProgramCount(); ++rayType) {
+                auto &hitVars = mRtBindings->getHitVars(rayType, instance);
+                hitVars->appendHeapRanges(model->getVertexBufferSrvHandle().ptr);
+                hitVars->appendHeapRanges(model->getIndexBufferSrvHandle().ptr);
+                hitVars->append32BitConstants((void*)&mMaterials[instance].params, SizeOfInUint32(MaterialParams));
+            }
+        }
+    });
+
+    // Blocks only if the background texture loads have not finished yet
+    if (mTextures.empty()) {
+        for (auto &pending : mPendingTextures) {
+            mTextures.push_back(pending.get());
         }
+        mEnvironmentTable = mPendingEnvironmentTable.get();
     }
 
     for (UINT rayType = 0; rayType < program->getMissProgramCount(); ++rayType) {
         auto &missVars = mRtBindings->getMissVars(rayType);
-        missVars->appendHeapRanges(mTextureSrvGpuHandles[0].ptr);
-        missVars->appendHeapRanges(mTextureSrvGpuHandles[1].ptr);
+        missVars->appendHeapRanges(mTextures[0]->srvGpuHandle.ptr);
+        missVars->appendHeapRanges(mTextures[1]->srvGpuHandle.ptr);
     }
 
     mRtBindings->apply(mRtContext, mRtState);
@@ -239,11 +594,63 @@ void ProgressiveRaytracingPipeline::render(ID3D12GraphicsCommandList *commandLis
     commandList->SetComputeRootSignature(program->getGlobalRootSignature());
     commandList->SetComputeRootConstantBufferView(GlobalRootSignatureParams::PerFrameConstantsSlot, mConstantBuffer.GpuVirtualAddress(frameIndex));
     commandList->SetComputeRootDescriptorTable(GlobalRootSignatureParams::OutputViewSlot, mOutputUavGpuHandle);
+    commandList->SetComputeRootDescriptorTable(GlobalRootSignatureParams::MomentsViewSlot, mMomentsUavGpuHandle);
+    commandList->SetComputeRootDescriptorTable(GlobalRootSignatureParams::TileActiveViewSlot, mTileActiveUavGpuHandle);
+    commandList->SetComputeRootDescriptorTable(GlobalRootSignatureParams::EnvironmentAliasTableSlot, mEnvironmentTable.srvGpuHandle);
+    commandList->SetComputeRootDescriptorTable(GlobalRootSignatureParams::EnvironmentCubemapSlot, mTextures[1]->srvGpuHandle);
+    commandList->SetComputeRootDescriptorTable(GlobalRootSignatureParams::PathLengthHistogramViewSlot, mPathLengthUavGpuHandle);
+    commandList->SetComputeRootDescriptorTable(GlobalRootSignatureParams::LightTreeNodesSlot, mLightTrees[mLightTreeIndex].nodesSrvGpuHandle);
+    commandList->SetComputeRootDescriptorTable(GlobalRootSignatureParams::LightTreeLightsSlot, mLightTrees[mLightTreeIndex].lightsSrvGpuHandle);
     mRtContext->getFallbackCommandList()->SetTopLevelAccelerationStructure(GlobalRootSignatureParams::AccelerationStructureSlot, mRtScene->getTlasWrappedPtr());
 
-    mRtContext->raytrace(mRtBindings, mRtState, width, height, 3);
+    const UINT64 histogramSize = PATH_LENGTH_HISTOGRAM_SIZE * sizeof(UINT);
+    if (mShaderDebugOptions.pathLengthHistogram) {
+        mRtContext->transitionResource(mPathLengthResource.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_DEST);
+        commandList->CopyBufferRegion(mPathLengthResource.Get(), 0, mPathLengthZeros.Get(), 0, histogramSize);
+        mRtContext->transitionResource(mPathLengthResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    }
+
+    // One thread per pixel, the ray generation reads and writes the pixel's moments and output
+    mRtContext->raytrace(mRtBindings, mRtState, width, height, 1);
 
     mRtContext->insertUAVBarrier(mOutputResource.Get());
+    mRtContext->insertUAVBarrier(mMomentsResource.Get());
+
+    if (mShaderDebugOptions.pathLengthHistogram) {
+        mRtContext->transitionResource(mPathLengthResource.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        commandList->CopyBufferRegion(mPathLengthReadback.Get(), frameIndex * histogramSize, mPathLengthResource.Get(), 0, histogramSize);
+        mRtContext->transitionResource(mPathLengthResource.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        mPathLengthReadbackGeneration[frameIndex] = mAccumGeneration;
+
+        // The ray generation skips every pixel past the last iteration, and with adaptive sampling those
+        // of converged tiles, which only the GPU knows about
+        const auto &frameOptions = mConstantBuffer->options;
+        UINT accumCount = mConstantBuffer->cameraParams.accumCount;
+        if (frameOptions.adaptiveSampling && accumCount >= frameOptions.adaptiveMinSamples) {
+            mPathLengthExpectedSamples[frameIndex] = UINT64_MAX;
+        } else {
+            mPathLengthExpectedSamples[frameIndex] = accumCount < frameOptions.maxIterations ? UINT64(width) * height : 0;
+        }
+    }
+
+    // Estimates the error of every tile for the next frame and copies the tile states to this frame's
+    // readback range, which update() reads once the frame index comes around again
+    if (mShaderDebugOptions.adaptiveSampling) {
+        commandList->SetComputeRootSignature(mAdaptiveRootSignature.Get());
+        commandList->SetPipelineState(mAdaptiveState.Get());
+        commandList->SetComputeRootDescriptorTable(AdaptiveSamplingParams::MomentsViewSlot, mMomentsUavGpuHandle);
+        commandList->SetComputeRootDescriptorTable(AdaptiveSamplingParams::TileActiveViewSlot, mTileActiveUavGpuHandle);
+        commandList->SetComputeRootConstantBufferView(AdaptiveSamplingParams::PerFrameConstantsSlot, mConstantBuffer.GpuVirtualAddress(frameIndex));
+        commandList->Dispatch(mTilesX, mTilesY, 1);
+
+        UINT64 size = UINT64(mTilesX) * mTilesY * sizeof(UINT);
+        mRtContext->transitionResource(mTileActiveResource.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        commandList->CopyBufferRegion(mTileActiveReadback.Get(), frameIndex * size, mTileActiveResource.Get(), 0, size);
+        mRtContext->transitionResource(mTileActiveResource.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+        mReadbackGeneration[frameIndex] = mAccumGeneration;
+        mReadbackAccumCount[frameIndex] = mConstantBuffer->cameraParams.accumCount;
+    }
 }
 
 void ProgressiveRaytracingPipeline::userInterface()
@@ -254,6 +661,20 @@ void ProgressiveRaytracingPipeline::userInterface()
     {
         frameDirty |= ui::ColorPicker4("Point Light", (float*)&pointLightColor);
         frameDirty |= ui::ColorPicker4("Directional Light", (float*)&dirLightColor);
+
+        ui::Separator();
+
+        // Changes to the lights restart accumulation once the tree is rebuilt, see update()
+        const char *manyLightModes[] = { "Off", "Uniform", "Light Tree" };
+        frameDirty |= ui::Combo("Many Lights", (int*)&mShaderDebugOptions.manyLightSampling, manyLightModes, ARRAYSIZE(manyLightModes));
+        if (mShaderDebugOptions.manyLightSampling) {
+            ui::SliderInt("Light Count", (int*)&mLightCount, 1, 100000);
+            ui::SliderFloat("Total Intensity", &mLightIntensity, 1.0f, 1000.0f, "%.0f", 2.0f);
+            const LightTreeBuffers &lightTree = mLightTrees[mLightTreeIndex];
+            if (lightTree.lightCount > 0) {
+                ui::Text("%u nodes, depth %u, built in %.1f ms", lightTree.nodeCount, lightTree.depth, lightTree.buildTimeMs);
+            }
+        }
     }
     ui::End();
 
@@ -285,11 +706,59 @@ void ProgressiveRaytracingPipeline::userInterface()
                 mAccumCount = min(mAccumCount, oldMaxIterations);
             }
             ui::ProgressBar(float(currentIterations) / float(mShaderDebugOptions.maxIterations), ImVec2(), std::to_string(currentIterations).c_str());
+
+            frameDirty |= ui::Checkbox("Adaptive Sampling", (bool*)&mShaderDebugOptions.adaptiveSampling);
+            if (mShaderDebugOptions.adaptiveSampling) {
+                frameDirty |= ui::SliderInt("Min Samples", (int*)&mShaderDebugOptions.adaptiveMinSamples, 2, 256);
+                // A new threshold applies to the samples so far, tiles that converged may need more
+                if (ui::SliderFloat("Error Threshold", &mShaderDebugOptions.adaptiveErrorThreshold, 0.001f, 0.1f, "%.3f", 2.0f)) {
+                    ++mAccumGeneration;
+                    mConverged = false;
+                }
+                UINT tileCount = mTilesX * mTilesY;
+                ui::Text("%u of %u tiles active%s", mConverged ? 0 : mActiveTileCount, tileCount, mConverged ? ", converged" : "");
+            }
+        }
+
+        ui::Separator();
+
+        const char *sampleSequences[] = { "Random", "Sobol", "Blue Noise Sobol" };
+        frameDirty |= ui::Combo("Sample Sequence", (int*)&mShaderDebugOptions.sampleSequence, sampleSequences, ARRAYSIZE(sampleSequences));
+
+        ui::Separator();
+
+        frameDirty |= ui::SliderInt("Max Bounces", (int*)&mShaderDebugOptions.maxBounces, 1, MAX_RADIANCE_RAY_DEPTH);
+        frameDirty |= ui::Checkbox("Russian Roulette", (bool*)&mShaderDebugOptions.russianRoulette);
+        if (mShaderDebugOptions.russianRoulette) {
+            frameDirty |= ui::SliderInt("Roulette From Bounce", (int*)&mShaderDebugOptions.russianRouletteDepth, 1, MAX_RADIANCE_RAY_DEPTH);
+        }
+        ui::Checkbox("Path Length Histogram", (bool*)&mShaderDebugOptions.pathLengthHistogram);
+        if (mShaderDebugOptions.pathLengthHistogram) {
+            UINT64 samples = 0;
+            UINT64 hits = 0;
+            for (UINT length = 0; length < PATH_LENGTH_HISTOGRAM_SIZE; ++length) {
+                samples += mPathLengthCounts[length];
+                hits += mPathLengthCounts[length] * length;
+            }
+            float fractions[PATH_LENGTH_HISTOGRAM_SIZE];
+            for (UINT length = 0; length < PATH_LENGTH_HISTOGRAM_SIZE; ++length) {
+                fractions[length] = samples > 0 ? float(double(mPathLengthCounts[length]) / double(samples)) : 0.0f;
+            }
+            ui::PlotHistogram("##PathLengths", fractions, PATH_LENGTH_HISTOGRAM_SIZE, 0, nullptr, 0.0f, 1.0f, ImVec2(0.0f, 60.0f));
+            ui::Text("Surface hits 0 to %u, %.2f on average over %llu samples", PATH_LENGTH_HISTOGRAM_SIZE - 1, samples > 0 ? double(hits) / double(samples) : 0.0, samples);
         }
 
         ui::Separator();
 
         frameDirty |= ui::Checkbox("Cosine Hemisphere Sampling", (bool*)&mShaderDebugOptions.cosineHemisphereSampling);
+        frameDirty |= ui::Checkbox("Environment Importance Sampling", (bool*)&mShaderDebugOptions.environmentImportanceSampling);
+        if (mShaderDebugOptions.environmentImportanceSampling && mEnvironmentTable.width > 0) {
+            ui::Text("Alias table %ux%u, built in %.1f ms", mEnvironmentTable.width, mEnvironmentTable.height, mEnvironmentTable.buildTimeMs);
+        }
+        frameDirty |= ui::Checkbox("Prefiltered Environment Misses", (bool*)&mShaderDebugOptions.prefilteredEnvironmentMisses);
+        if (mShaderDebugOptions.prefilteredEnvironmentMisses && !mTextures.empty() && mTextures[1]->prefilteredMipCount > 0) {
+            ui::Text("%u GGX mips and SH, prefiltered in %.1f ms", mTextures[1]->prefilteredMipCount, mTextures[1]->prefilterTimeMs);
+        }
         frameDirty |= ui::Checkbox("Indirect Diffuse Only", (bool*)&mShaderDebugOptions.showIndirectDiffuseOnly);
         frameDirty |= ui::Checkbox("Indirect Specular Only", (bool*)&mShaderDebugOptions.showIndirectSpecularOnly);
         frameDirty |= ui::Checkbox("Ambient Occlusion Only", (bool*)&mShaderDebugOptions.showAmbientOcclusionOnly);
@@ -1,18 +1,23 @@
 #include "pch.h"
 #include "RealtimeRaytracingPipeline.h"
 #include "CompiledShaders/RealtimeRaytracing.hlsl.h"
-#include "WICTextureLoader.h"
-#include "DDSTextureLoader.h"
-#include "ResourceUploadBatch.h"
+#include "CompiledShaders/TemporalAccumulation.hlsl.h"
 #include "Helpers/DirectXRaytracingHelper.h"
+#include "Helpers/RootSignatureGenerator.h"
 #include "ImGuiRendererDX.h"
+#include "Math/Common.h"
+#include "SamplingHlslCompat.h"
 #include <chrono>
 
 using namespace DXRFramework;
+using nv_helpers_dx12::RootSignatureGenerator;
 
 static XMFLOAT4 pointLightColor = XMFLOAT4(0.2f, 0.8f, 0.6f, 2.0f);
 static XMFLOAT4 dirLightColor = XMFLOAT4(0.9f, 0.0f, 0.0f, 1.0f);
 
+static const UINT kLightCount = 1000;
+static const float kLightIntensity = 100.0f;
+
 namespace GlobalRootSignatureParams 
 {
     enum Value 
@@ -20,10 +25,44 @@ namespace GlobalRootSignatureParams
         AccelerationStructureSlot = 0,
         OutputViewSlot,
         PerFrameConstantsSlot,
+        EnvironmentIrradianceSlot,
+        ReservoirsSlot,
+        LightTreeNodesSlot,
+        LightTreeLightsSlot,
+        RestirPassSlot,
+        AovViewSlot,
         Count 
     };
 }
 
+namespace TemporalAccumulationParams
+{
+    enum Value
+    {
+        SampleViewSlot = 0,
+        AccumulatedViewSlot,
+        HistoryViewSlot,
+        AovSlot,
+        PreviousAovSlot,
+        MomentsViewSlot,
+        HistoryMomentsViewSlot,
+        VarianceViewSlot,
+        PerFrameConstantsSlot,
+        Count
+    };
+}
+
+// TEMPORAL_GROUP_SIZE in TemporalAccumulation.hlsl
+static const UINT TemporalGroupSize = 8;
+
+// Formats of the AOVs, see AovHlslCompat.h
+static const DXGI_FORMAT AovFormats[AOV_COUNT] = { DXGI_FORMAT_R16_FLOAT, DXGI_FORMAT_R16G16_SNORM, DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_R16G16_FLOAT, DXGI_FORMAT_R16_UINT };
+
+inline bool aovHasHistory(UINT aov)
+{
+    return (AOV_TEMPORAL_MASK & AOV_BIT(aov)) != 0;
+}
+
 RealtimeRaytracingPipeline::RealtimeRaytracingPipeline(RtContext::SharedPtr context) :
     mRtContext(context),
     mAnimationPaused(true),
@@ -43,12 +82,24 @@ RealtimeRaytracingPipeline::RealtimeRaytracingPipeline(RtContext::SharedPtr cont
             config.AddHeapRangesParameter({{0 /* u0-u1 */, 2, 0, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0}}); 
             // GlobalRootSignatureParams::PerFrameConstantsSlot
             config.AddRootParameter(D3D12_ROOT_PARAMETER_TYPE_CBV, 0 /* b0 */); 
+            // GlobalRootSignatureParams::EnvironmentIrradianceSlot
+            config.AddHeapRangesParameter({{1 /* t1 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0}}); 
+            // GlobalRootSignatureParams::ReservoirsSlot
+            config.AddHeapRangesParameter({{2 /* u2-u3 */, 2, 0, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0}}); 
+            // GlobalRootSignatureParams::LightTreeNodesSlot
+            config.AddHeapRangesParameter({{2 /* t2 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0}}); 
+            // GlobalRootSignatureParams::LightTreeLightsSlot
+            config.AddHeapRangesParameter({{3 /* t3 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0}}); 
+            // GlobalRootSignatureParams::RestirPassSlot
+            config.AddRootParameter(D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS, 1 /* b1 */, 0, 1); 
+            // GlobalRootSignatureParams::AovViewSlot
+            config.AddHeapRangesParameter({{4 /* u4-u8 */, AOV_COUNT, 0, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0}}); 
 
             D3D12_STATIC_SAMPLER_DESC cubeSampler = {};
             cubeSampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
             cubeSampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
             cubeSampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-            cubeSampler.Filter = D3D12_FILTER_MIN_MAG_LINEAR_MIP_POINT;
+            cubeSampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
             cubeSampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
             cubeSampler.ShaderRegister = 0;
             config.AddStaticSampler(cubeSampler);
@@ -68,11 +119,41 @@ RealtimeRaytracingPipeline::RealtimeRaytracingPipeline(RtContext::SharedPtr cont
     mRtState->setProgram(mRtProgram);
     mRtState->setMaxTraceRecursionDepth(4);
     mRtState->setMaxAttributeSize(8);
-    mRtState->setMaxPayloadSize(60);
+    mRtState->setMaxPayloadSize(64);
+
+    // Create the state object on the constructing thread instead of lazily on the first render
+    mRtState->getFallbackRtso();
 
-    auto now = std::chrono::high_resolution_clock::now();
-    auto msTime = std::chrono::time_point_cast<std::chrono::milliseconds>(now);
-    mRng = std::mt19937(uint32_t(msTime.time_since_epoch().count()));
+    {
+        auto device = context->getDevice();
+
+        RootSignatureGenerator rsConfig;
+        // TemporalAccumulationParams::SampleViewSlot
+        rsConfig.AddHeapRangesParameter({ {0 /* u0-u1 */, 2, 0, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0} });
+        // TemporalAccumulationParams::AccumulatedViewSlot
+        rsConfig.AddHeapRangesParameter({ {2 /* u2-u3 */, 2, 0, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0} });
+        // TemporalAccumulationParams::HistoryViewSlot
+        rsConfig.AddHeapRangesParameter({ {4 /* u4-u5 */, 2, 0, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0} });
+        // TemporalAccumulationParams::AovSlot, the depth and normal AOVs
+        rsConfig.AddHeapRangesParameter({ {0 /* t0-t1 */, 2, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0} });
+        // TemporalAccumulationParams::PreviousAovSlot
+        rsConfig.AddHeapRangesParameter({ {2 /* t2-t3 */, 2, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0} });
+        // TemporalAccumulationParams::MomentsViewSlot
+        rsConfig.AddHeapRangesParameter({ {6 /* u6 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0} });
+        // TemporalAccumulationParams::HistoryMomentsViewSlot
+        rsConfig.AddHeapRangesParameter({ {7 /* u7 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0} });
+        // TemporalAccumulationParams::VarianceViewSlot
+        rsConfig.AddHeapRangesParameter({ {8 /* u8 */, 1, 0, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0} });
+        // TemporalAccumulationParams::PerFrameConstantsSlot
+        rsConfig.AddRootParameter(D3D12_ROOT_PARAMETER_TYPE_CBV, 0 /* b0 */, 0, 1);
+        mTemporalRootSignature = rsConfig.Generate(device, false);
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
+        computePsoDesc.pRootSignature = mTemporalRootSignature.Get();
+        computePsoDesc.CS = CD3DX12_SHADER_BYTECODE(g_pTemporalAccumulation, ARRAYSIZE(g_pTemporalAccumulation));
+        ThrowIfFailed(device->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(&mTemporalState)));
+        NAME_D3D12_OBJECT(mTemporalState);
+    }
 }
 
 RealtimeRaytracingPipeline::~RealtimeRaytracingPipeline() = default;
@@ -88,24 +169,31 @@ void RealtimeRaytracingPipeline::buildAccelerationStructures()
     mRtScene->build(mRtContext, mRtProgram->getHitProgramCount());
 }
 
-void RealtimeRaytracingPipeline::loadResources(ID3D12CommandQueue *uploadCommandQueue, UINT frameCount)
-{        
-    mTextureResources.resize(2);
-    mTextureSrvGpuHandles.resize(2);
-
-    // Create and upload global textures
+void RealtimeRaytracingPipeline::loadResources(TextureCache::SharedPtr textureCache, UINT frameCount)
+{
     auto device = mRtContext->getDevice();
-    ResourceUploadBatch resourceUpload(device);
-    resourceUpload.Begin();
-    {
-        ThrowIfFailed(CreateWICTextureFromFile(device, resourceUpload, L"..\\assets\\textures\\HdrStudioProductNightStyx001_JPG_8K.jpg", &mTextureResources[0], true));
-        ThrowIfFailed(CreateDDSTextureFromFile(device, resourceUpload, L"..\\assets\\textures\\CathedralRadiance.dds", &mTextureResources[1]));
-    }
-    auto uploadResourcesFinished = resourceUpload.End(uploadCommandQueue);
-    uploadResourcesFinished.wait();
 
-    mTextureSrvGpuHandles[0] = mRtContext->createTextureSRVHandle(mTextureResources[0].Get());
-    mTextureSrvGpuHandles[1] = mRtContext->createTextureSRVHandle(mTextureResources[1].Get(), true);
+    // Global textures are shared with other pipelines and decoded in the background
+    mPendingTextures.clear();
+    mPendingTextures.push_back(textureCache->loadAsync(L"..\\assets\\textures\\HdrStudioProductNightStyx001_JPG_8K.jpg", TextureCache::GenerateMips));
+    mPendingTextures.push_back(textureCache->loadAsync(L"..\\assets\\textures\\CathedralRadiance.dds", TextureCache::Cubemap | TextureCache::KeepCpuCopy | TextureCache::PrefilterEnvironment));
+    mPendingTextures.push_back(textureCache->loadAsync(L"..\\assets\\textures\\CathedralIrradiance.dds", TextureCache::Cubemap));
+
+    // Above the floor of Machines.fbx and around its machines, like the progressive pipeline's lights
+    auto start = std::chrono::high_resolution_clock::now();
+    auto lights = RtLightTree::scatter(kLightCount, CpuMath::float3(-12.0f, 0.2f, -12.0f), CpuMath::float3(12.0f, 6.0f, 12.0f), kLightIntensity, 1);
+    mLightTree = RtLightTree::build(lights, mRtContext->getJobSystem().get());
+    mLightTreeBuildTimeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    UINT64 nodesSize = mLightTree->getNodes().size() * sizeof(RtLightTree::Node);
+    UINT64 lightsSize = mLightTree->getLights().size() * sizeof(RtLightTree::Light);
+    auto uploadQueue = mRtContext->getUploadQueue();
+    mLightTreeNodes = CreateBuffer(device, nodesSize, D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_COMMON, kDefaultHeapProps);
+    mLightTreeLights = CreateBuffer(device, lightsSize, D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_COMMON, kDefaultHeapProps);
+    uploadQueue->uploadBuffer(mLightTreeNodes.Get(), mLightTree->getNodes().data(), nodesSize);
+    uploadQueue->waitOnCpu(uploadQueue->uploadBuffer(mLightTreeLights.Get(), mLightTree->getLights().data(), lightsSize));
+    mLightTreeNodesSrvGpuHandle = mRtContext->createBufferSRVHandle(mLightTreeNodes.Get(), true);
+    mLightTreeLightsSrvGpuHandle = mRtContext->createBufferSRVHandle(mLightTreeLights.Get(), true);
 
     // Create per-frame constant buffer
     mConstantBuffer.Create(device, frameCount, L"PerFrameConstantBuffer");
@@ -120,7 +208,8 @@ void RealtimeRaytracingPipeline::createOutputResource(DXGI_FORMAT format, UINT w
         AllocateUAVTexture(device, format, width, height, mOutputResource[i].ReleaseAndGetAddressOf(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
     }
 
-    // Make sure UAV handles are continuous on the descriptor heap for descriptor table binding
+    // The UAVs are bound as one descriptor table, so they take a range of the heap
+    mRtContext->allocateDescriptorRange(kNumOutputResources, mOutputUavHeapIndex);
     for (int i = 0; i < kNumOutputResources; ++i) {
         D3D12_CPU_DESCRIPTOR_HANDLE uavCpuHandle;
         mOutputUavHeapIndex[i] = mRtContext->allocateDescriptor(&uavCpuHandle, mOutputUavHeapIndex[i]);
@@ -137,6 +226,133 @@ void RealtimeRaytracingPipeline::createOutputResource(DXGI_FORMAT format, UINT w
         mOutputSrvHeapIndex[i] = mRtContext->allocateDescriptor(&srvCpuHandle, mOutputSrvHeapIndex[i]);
         mOutputSrvGpuHandle[i] = mRtContext->createTextureSRVHandle(mOutputResource[i].Get(), false, mOutputSrvHeapIndex[i]);
     }
+
+    // Raw, the compute path of the Fallback Layer does not index structured buffers. Committed resources
+    // start zeroed, which the depth test of temporal reuse rejects.
+    const UINT reservoirSize = 32;
+    mRtContext->allocateDescriptorRange(kNumReservoirResources, mReservoirUavHeapIndex);
+    for (int i = 0; i < kNumReservoirResources; ++i) {
+        AllocateUAVBuffer(device, UINT64(width) * height * reservoirSize, mReservoirResource[i].ReleaseAndGetAddressOf(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+        D3D12_CPU_DESCRIPTOR_HANDLE uavCpuHandle;
+        mReservoirUavHeapIndex[i] = mRtContext->allocateDescriptor(&uavCpuHandle, mReservoirUavHeapIndex[i]);
+
+        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+        uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+        uavDesc.Buffer.Flags = D3D12_BUFFER_UAV_FLAG_RAW;
+        uavDesc.Buffer.NumElements = width * height * reservoirSize / sizeof(UINT);
+        device->CreateUnorderedAccessView(mReservoirResource[i].Get(), nullptr, &uavDesc, uavCpuHandle);
+    }
+    mReservoirUavGpuHandle = mRtContext->getDescriptorGPUHandle(mReservoirUavHeapIndex[0]);
+
+    // The two outputs of a set are one table, like the outputs themselves
+    for (int set = 0; set < 2; ++set) {
+        mRtContext->allocateDescriptorRange(kNumOutputResources, mAccumulationUavHeapIndex[set]);
+        for (int i = 0; i < kNumOutputResources; ++i) {
+            AllocateUAVTexture(device, format, width, height, mAccumulationResource[set][i].ReleaseAndGetAddressOf(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+            D3D12_CPU_DESCRIPTOR_HANDLE uavCpuHandle;
+            mAccumulationUavHeapIndex[set][i] = mRtContext->allocateDescriptor(&uavCpuHandle, mAccumulationUavHeapIndex[set][i]);
+
+            D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+            uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+            device->CreateUnorderedAccessView(mAccumulationResource[set][i].Get(), nullptr, &uavDesc, uavCpuHandle);
+
+            mAccumulationUavGpuHandle[set][i] = mRtContext->getDescriptorGPUHandle(mAccumulationUavHeapIndex[set][i]);
+        }
+
+        for (int i = 0; i < kNumOutputResources; ++i) {
+            D3D12_CPU_DESCRIPTOR_HANDLE srvCpuHandle;
+            mAccumulationSrvHeapIndex[set][i] = mRtContext->allocateDescriptor(&srvCpuHandle, mAccumulationSrvHeapIndex[set][i]);
+            mAccumulationSrvGpuHandle[set][i] = mRtContext->createTextureSRVHandle(mAccumulationResource[set][i].Get(), false, mAccumulationSrvHeapIndex[set][i]);
+        }
+    }
+
+    // The ray generation binds the UAVs of a set as one table, temporal accumulation the depth and
+    // normal SRVs, so both take a range of the heap per set
+    for (int set = 0; set < 2; ++set) {
+        mRtContext->allocateDescriptorRange(AOV_COUNT, mAovUavHeapIndex[set]);
+        for (UINT aov = 0; aov < AOV_COUNT; ++aov) {
+            if (set == 0 || aovHasHistory(aov)) {
+                AllocateUAVTexture(device, AovFormats[aov], width, height, mAovResource[set][aov].ReleaseAndGetAddressOf(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            } else {
+                mAovResource[set][aov] = mAovResource[0][aov];
+            }
+
+            D3D12_CPU_DESCRIPTOR_HANDLE uavCpuHandle;
+            mAovUavHeapIndex[set][aov] = mRtContext->allocateDescriptor(&uavCpuHandle, mAovUavHeapIndex[set][aov]);
+
+            D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+            uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+            device->CreateUnorderedAccessView(mAovResource[set][aov].Get(), nullptr, &uavDesc, uavCpuHandle);
+        }
+        mAovUavGpuHandle[set] = mRtContext->getDescriptorGPUHandle(mAovUavHeapIndex[set][0]);
+
+        mRtContext->allocateDescriptorRange(AOV_COUNT, mAovSrvHeapIndex[set]);
+        for (UINT aov = 0; aov < AOV_COUNT; ++aov) {
+            D3D12_CPU_DESCRIPTOR_HANDLE srvCpuHandle;
+            mAovSrvHeapIndex[set][aov] = mRtContext->allocateDescriptor(&srvCpuHandle, mAovSrvHeapIndex[set][aov]);
+            mAovSrvGpuHandle[set][aov] = mRtContext->createTextureSRVHandle(mAovResource[set][aov].Get(), false, mAovSrvHeapIndex[set][aov]);
+        }
+    }
+    mAovsWritten = 0;
+    mOutputPixelCount = UINT64(width) * height;
+
+    // The moments keep full precision, the squares of bright samples overflow half floats
+    for (int set = 0; set < 2; ++set) {
+        AllocateUAVTexture(device, DXGI_FORMAT_R32G32B32A32_FLOAT, width, height, mMomentsResource[set].ReleaseAndGetAddressOf(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+        D3D12_CPU_DESCRIPTOR_HANDLE uavCpuHandle;
+        mMomentsUavHeapIndex[set] = mRtContext->allocateDescriptor(&uavCpuHandle, mMomentsUavHeapIndex[set]);
+
+        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+        device->CreateUnorderedAccessView(mMomentsResource[set].Get(), nullptr, &uavDesc, uavCpuHandle);
+
+        mMomentsUavGpuHandle[set] = mRtContext->getDescriptorGPUHandle(mMomentsUavHeapIndex[set]);
+    }
+
+    {
+        AllocateUAVTexture(device, DXGI_FORMAT_R16G16_FLOAT, width, height, mVarianceResource.ReleaseAndGetAddressOf(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+        D3D12_CPU_DESCRIPTOR_HANDLE uavCpuHandle;
+        mVarianceUavHeapIndex = mRtContext->allocateDescriptor(&uavCpuHandle, mVarianceUavHeapIndex);
+
+        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+        device->CreateUnorderedAccessView(mVarianceResource.Get(), nullptr, &uavDesc, uavCpuHandle);
+
+        mVarianceUavGpuHandle = mRtContext->getDescriptorGPUHandle(mVarianceUavHeapIndex);
+
+        D3D12_CPU_DESCRIPTOR_HANDLE srvCpuHandle;
+        mVarianceSrvHeapIndex = mRtContext->allocateDescriptor(&srvCpuHandle, mVarianceSrvHeapIndex);
+        mVarianceSrvGpuHandle = mRtContext->createTextureSRVHandle(mVarianceResource.Get(), false, mVarianceSrvHeapIndex);
+    }
+    mHistoryValid = false;
+}
+
+void RealtimeRaytracingPipeline::releaseOutputResource()
+{
+    for (int i = 0; i < kNumOutputResources; ++i) {
+        mOutputResource[i].Reset();
+    }
+    for (int i = 0; i < kNumReservoirResources; ++i) {
+        mReservoirResource[i].Reset();
+    }
+    for (int set = 0; set < 2; ++set) {
+        for (int i = 0; i < kNumOutputResources; ++i) {
+            mAccumulationResource[set][i].Reset();
+        }
+        for (UINT aov = 0; aov < AOV_COUNT; ++aov) {
+            mAovResource[set][aov].Reset();
+        }
+        mMomentsResource[set].Reset();
+    }
+    mVarianceResource.Reset();
+    mHistoryValid = false;
+    mOutputsAccumulated = false;
+    mAovsWritten = 0;
 }
 
 inline void calculateCameraVariables(Math::Camera &camera, float aspectRatio, XMFLOAT4 *U, XMFLOAT4 *V, XMFLOAT4 *W)
@@ -173,9 +389,11 @@ void RealtimeRaytracingPipeline::update(float elapsedTime, UINT elapsedFrames, U
 
     CameraParams &cameraParams = mConstantBuffer->cameraParams;
     XMStoreFloat4(&cameraParams.worldEyePos, mCamera->GetPosition());
-    calculateCameraVariables(*mCamera, mCamera->GetAspectRatio(), &cameraParams.U, &cameraParams.V, &cameraParams.W);
-    float xJitter = (mRngDist(mRng) - 0.5f) / float(width);
-    float yJitter = (mRngDist(mRng) - 0.5f) / float(height);
+    // Math::Camera keeps height over width
+    calculateCameraVariables(*mCamera, 1.0f / mCamera->GetAspectRatio(), &cameraParams.U, &cameraParams.V, &cameraParams.W);
+    // The camera dimensions of the shaders' sample sequence, by frame like the rest of it
+    float xJitter = (Sampling::sampleToUnitFloat(Sampling::sobolOwen(elapsedFrames, SAMPLE_DIMENSION_CAMERA, 0)) - 0.5f) / float(width);
+    float yJitter = (Sampling::sampleToUnitFloat(Sampling::sobolOwen(elapsedFrames, SAMPLE_DIMENSION_CAMERA + 1, 0)) - 0.5f) / float(height);
     cameraParams.jitters = XMFLOAT2(xJitter, yJitter);
     cameraParams.frameCount = elapsedFrames;
     cameraParams.accumCount = 0;
@@ -193,29 +411,77 @@ void RealtimeRaytracingPipeline::update(float elapsedTime, UINT elapsedFrames, U
     XMStoreFloat4(&mConstantBuffer->pointLight.worldPos, pointLightPos);
     mConstantBuffer->pointLight.color = pointLightColor;
 
+    // Rows of the camera's matrices, see ReprojectionParams
+    const Math::Matrix4 &viewProj = mCamera->GetViewProjMatrix();
+    const Math::Matrix4 &reprojection = mCamera->GetReprojectionMatrix();
+    XMStoreFloat4(&mConstantBuffer->reprojection.viewProj[0], viewProj.GetX());
+    XMStoreFloat4(&mConstantBuffer->reprojection.viewProj[1], viewProj.GetY());
+    XMStoreFloat4(&mConstantBuffer->reprojection.viewProj[2], viewProj.GetZ());
+    XMStoreFloat4(&mConstantBuffer->reprojection.viewProj[3], viewProj.GetW());
+    XMStoreFloat4(&mConstantBuffer->reprojection.reprojection[0], reprojection.GetX());
+    XMStoreFloat4(&mConstantBuffer->reprojection.reprojection[1], reprojection.GetY());
+    XMStoreFloat4(&mConstantBuffer->reprojection.reprojection[2], reprojection.GetZ());
+    XMStoreFloat4(&mConstantBuffer->reprojection.reprojection[3], reprojection.GetW());
+
+    mConstantBuffer->lightTree.lightCount = mManyLightSampling ? UINT(mLightTree->getLights().size()) : 0;
+    mConstantBuffer->lightTree.nodeCount = UINT(mLightTree->getNodes().size());
+    mConstantBuffer->options.manyLightSampling = mManyLightSampling;
+    mConstantBuffer->options.restirCandidates = mRestirCandidates;
+    mConstantBuffer->options.restirTemporalReuse = mRestirTemporalReuse;
+    mConstantBuffer->options.restirSpatialSamples = mRestirSpatialSamples;
+    mConstantBuffer->options.restirSpatialRadius = mRestirSpatialRadius;
+    mConstantBuffer->options.restirHistoryLimit = mRestirHistoryLimit;
+    mConstantBuffer->options.temporalAccumulation = mTemporalAccumulation;
+    mConstantBuffer->options.temporalHistoryValid = mHistoryValid;
+    mConstantBuffer->options.temporalMinAlpha = mTemporalMinAlpha;
+    mConstantBuffer->options.temporalClampGamma = mTemporalClampGamma;
+    mConstantBuffer->options.aovMask = mAovMask | (mTemporalAccumulation ? AOV_TEMPORAL_MASK : 0);
+
     mConstantBuffer->options.environmentStrength = 1.0f;
+    mConstantBuffer->options.prefilteredEnvironmentMisses = mPrefilteredEnvironmentMisses;
+    mConstantBuffer->options.environmentIrradiance = mEnvironmentIrradiance;
+    // One reflection bounce, the recursion depth of the pipeline leaves no room for more
+    mConstantBuffer->options.maxBounces = 1;
+    if (!mTextures.empty()) {
+        mConstantBuffer->environmentLighting.radianceMipCount = mTextures[1]->prefilteredMipCount;
+        memcpy(mConstantBuffer->environmentLighting.irradianceSH, mTextures[1]->irradianceSH, sizeof(mTextures[1]->irradianceSH));
+    }
 
     mConstantBuffer.CopyStagingToGpu(frameIndex);
 }
 
 void RealtimeRaytracingPipeline::render(ID3D12GraphicsCommandList *commandList, UINT frameIndex, UINT width, UINT height)
 {
+    // This frame writes the other set of accumulated outputs and guides, the last frame's is the history
+    mHistoryIndex ^= 1;
+
     // Update shader table root arguments
     auto program = mRtBindings->getProgram();
 
-    for (UINT rayType = 0; rayType < program->getHitProgramCount(); ++rayType) {
-        for (UINT instance = 0; instance < mRtScene->getNumInstances(); ++instance) {
-            auto &hitVars = mRtBindings->getHitVars(rayType, instance);
-            hitVars->appendHeapRanges(mRtScene->getModel(instance)->getVertexBufferSrvHandle().ptr);
-            hitVars->appendHeapRanges(mRtScene->getModel(instance)->getIndexBufferSrvHandle().ptr);
-            hitVars->append32BitConstants((void*)&mMaterials[instance].params, SizeOfInUint32(MaterialParams));
+    // Every instance writes only its own hit records
+    mRtContext->getJobSystem()->parallelFor(0, mRtScene->getNumInstances(), 64, [&](UINT begin, UINT end) {
+        for (UINT instance = begin; instance < end; ++instance) {
+            auto model = mRtScene->getModel(instance);
+            for (UINT rayType = 0; rayType < program->getHitProgramCount(); ++rayType) {
+                auto &hitVars = mRtBindings->getHitVars(rayType, instance);
+                hitVars->appendHeapRanges(model->getVertexBufferSrvHandle().ptr);
+                hitVars->appendHeapRanges(model->getIndexBufferSrvHandle().ptr);
+                hitVars->append32BitConstants((void*)&mMaterials[instance].params, SizeOfInUint32(MaterialParams));
+            }
+        }
+    });
+
+    // Blocks only if the background texture loads have not finished yet
+    if (mTextures.empty()) {
+        for (auto &pending : mPendingTextures) {
+            mTextures.push_back(pending.get());
         }
     }
 
     for (UINT rayType = 0; rayType < program->getMissProgramCount(); ++rayType) {
         auto &missVars = mRtBindings->getMissVars(rayType);
-        missVars->appendHeapRanges(mTextureSrvGpuHandles[0].ptr);
-        missVars->appendHeapRanges(mTextureSrvGpuHandles[1].ptr);
+        missVars->appendHeapRanges(mTextures[0]->srvGpuHandle.ptr);
+        missVars->appendHeapRanges(mTextures[1]->srvGpuHandle.ptr);
     }
 
     mRtBindings->apply(mRtContext, mRtState);
@@ -225,13 +491,68 @@ void RealtimeRaytracingPipeline::render(ID3D12GraphicsCommandList *commandList,
     commandList->SetComputeRootSignature(program->getGlobalRootSignature());
     commandList->SetComputeRootConstantBufferView(GlobalRootSignatureParams::PerFrameConstantsSlot, mConstantBuffer.GpuVirtualAddress(frameIndex));
     commandList->SetComputeRootDescriptorTable(GlobalRootSignatureParams::OutputViewSlot, mOutputUavGpuHandle[0]);
+    commandList->SetComputeRootDescriptorTable(GlobalRootSignatureParams::EnvironmentIrradianceSlot, mTextures[2]->srvGpuHandle);
+    commandList->SetComputeRootDescriptorTable(GlobalRootSignatureParams::ReservoirsSlot, mReservoirUavGpuHandle);
+    commandList->SetComputeRootDescriptorTable(GlobalRootSignatureParams::LightTreeNodesSlot, mLightTreeNodesSrvGpuHandle);
+    commandList->SetComputeRootDescriptorTable(GlobalRootSignatureParams::LightTreeLightsSlot, mLightTreeLightsSrvGpuHandle);
+    commandList->SetComputeRoot32BitConstant(GlobalRootSignatureParams::RestirPassSlot, 0 /* RESTIR_PASS_PRIMARY */, 0);
+    commandList->SetComputeRootDescriptorTable(GlobalRootSignatureParams::AovViewSlot, mAovUavGpuHandle[mHistoryIndex]);
     mRtContext->getFallbackCommandList()->SetTopLevelAccelerationStructure(GlobalRootSignatureParams::AccelerationStructureSlot, mRtScene->getTlasWrappedPtr());
 
-    mRtContext->raytrace(mRtBindings, mRtState, width, height, 3);
+    // One thread per pixel, the passes read and write the pixel's reservoir
+    mRtContext->raytrace(mRtBindings, mRtState, width, height, 1);
 
     for (int i = 0; i < kNumOutputResources; ++i) {
         mRtContext->insertUAVBarrier(mOutputResource[i].Get());
     }
+
+    // Spatial reuse reads the neighbours' reservoirs of the first pass and adds to its direct lighting,
+    // with a depth of one as it accumulates into the output
+    if (mManyLightSampling) {
+        mRtContext->insertUAVBarrier(mReservoirResource[0].Get());
+        commandList->SetComputeRoot32BitConstant(GlobalRootSignatureParams::RestirPassSlot, 1 /* RESTIR_PASS_SPATIAL */, 0);
+        mRtContext->raytrace(mRtBindings, mRtState, width, height, 1);
+
+        mRtContext->insertUAVBarrier(mOutputResource[0].Get());
+        mRtContext->insertUAVBarrier(mReservoirResource[1].Get());
+    }
+
+    mAovsWritten = mConstantBuffer->options.aovMask;
+
+    // Blends the samples with the reprojected accumulation of the last frame, the history is valid
+    // again from the next frame on once it has been written
+    mOutputsAccumulated = mTemporalAccumulation;
+    if (mTemporalAccumulation) {
+        UINT previous = mHistoryIndex ^ 1;
+        for (UINT set = 0; set < 2; ++set) {
+            mRtContext->transitionResource(mAovResource[set][AOV_DEPTH].Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+            mRtContext->transitionResource(mAovResource[set][AOV_NORMAL].Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        }
+
+        commandList->SetComputeRootSignature(mTemporalRootSignature.Get());
+        commandList->SetPipelineState(mTemporalState.Get());
+        commandList->SetComputeRootDescriptorTable(TemporalAccumulationParams::SampleViewSlot, mOutputUavGpuHandle[0]);
+        commandList->SetComputeRootDescriptorTable(TemporalAccumulationParams::AccumulatedViewSlot, mAccumulationUavGpuHandle[mHistoryIndex][0]);
+        commandList->SetComputeRootDescriptorTable(TemporalAccumulationParams::HistoryViewSlot, mAccumulationUavGpuHandle[previous][0]);
+        commandList->SetComputeRootDescriptorTable(TemporalAccumulationParams::AovSlot, mAovSrvGpuHandle[mHistoryIndex][AOV_DEPTH]);
+        commandList->SetComputeRootDescriptorTable(TemporalAccumulationParams::PreviousAovSlot, mAovSrvGpuHandle[previous][AOV_DEPTH]);
+        commandList->SetComputeRootDescriptorTable(TemporalAccumulationParams::MomentsViewSlot, mMomentsUavGpuHandle[mHistoryIndex]);
+        commandList->SetComputeRootDescriptorTable(TemporalAccumulationParams::HistoryMomentsViewSlot, mMomentsUavGpuHandle[previous]);
+        commandList->SetComputeRootDescriptorTable(TemporalAccumulationParams::VarianceViewSlot, mVarianceUavGpuHandle);
+        commandList->SetComputeRootConstantBufferView(TemporalAccumulationParams::PerFrameConstantsSlot, mConstantBuffer.GpuVirtualAddress(frameIndex));
+        commandList->Dispatch(Math::DivideByMultiple(width, TemporalGroupSize), Math::DivideByMultiple(height, TemporalGroupSize), 1);
+
+        for (int i = 0; i < kNumOutputResources; ++i) {
+            mRtContext->insertUAVBarrier(mAccumulationResource[mHistoryIndex][i].Get());
+        }
+        mRtContext->insertUAVBarrier(mMomentsResource[mHistoryIndex].Get());
+        mRtContext->insertUAVBarrier(mVarianceResource.Get());
+        for (UINT set = 0; set < 2; ++set) {
+            mRtContext->transitionResource(mAovResource[set][AOV_DEPTH].Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            mRtContext->transitionResource(mAovResource[set][AOV_NORMAL].Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        }
+    }
+    mHistoryValid = mTemporalAccumulation;
 }
 
 void RealtimeRaytracingPipeline::userInterface()
@@ -240,6 +561,18 @@ void RealtimeRaytracingPipeline::userInterface()
     {
         ui::ColorPicker4("Point Light", (float*)&pointLightColor);
         ui::ColorPicker4("Directional Light", (float*)&dirLightColor);
+
+        // Candidates of reservoir resampling, one candidate without reuse is plain light sampling
+        const char *manyLightModes[] = { "Off", "Uniform", "Light Tree" };
+        ui::Combo("Many Lights", &mManyLightSampling, manyLightModes, ARRAYSIZE(manyLightModes));
+        if (mManyLightSampling) {
+            ui::SliderInt("ReSTIR Candidates", &mRestirCandidates, 1, 32);
+            ui::Checkbox("ReSTIR Temporal Reuse", &mRestirTemporalReuse);
+            ui::SliderFloat("ReSTIR History Limit", &mRestirHistoryLimit, 1.0f, 50.0f);
+            ui::SliderInt("ReSTIR Spatial Samples", &mRestirSpatialSamples, 0, 8);
+            ui::SliderFloat("ReSTIR Spatial Radius", &mRestirSpatialRadius, 1.0f, 64.0f);
+            ui::Text("%u lights, %u nodes, built in %.1f ms", UINT(mLightTree->getLights().size()), UINT(mLightTree->getNodes().size()), mLightTreeBuildTimeMs);
+        }
     }
     ui::End();
 
@@ -254,7 +587,35 @@ void RealtimeRaytracingPipeline::userInterface()
 
     ui::Begin("Realtime Raytracing");
     {
+        ui::Checkbox("Prefiltered Environment Misses", &mPrefilteredEnvironmentMisses);
+        const char *ambientModes[] = { "None", "SH Irradiance", "Irradiance Cubemap" };
+        ui::Combo("Environment Ambient", &mEnvironmentIrradiance, ambientModes, ARRAYSIZE(ambientModes));
+        if (!mTextures.empty() && mTextures[1]->prefilteredMipCount > 0) {
+            ui::Text("%u GGX mips and SH, prefiltered in %.1f ms", mTextures[1]->prefilteredMipCount, mTextures[1]->prefilterTimeMs);
+        }
 
+        ui::Checkbox("Temporal Accumulation", &mTemporalAccumulation);
+        if (mTemporalAccumulation) {
+            ui::SliderFloat("Temporal Min Alpha", &mTemporalMinAlpha, 0.02f, 1.0f);
+            ui::SliderFloat("Temporal Clamp Gamma", &mTemporalClampGamma, 0.0f, 4.0f);
+        }
+
+        // Traffic of every AOV a frame, written once by the ray generation and, for depth and normal, read
+        // for this frame and the last by temporal accumulation. Taps of neighbouring pixels are assumed to
+        // hit the cache.
+        if (ui::CollapsingHeader("AOVs")) {
+            UINT aovMask = mAovMask | (mTemporalAccumulation ? AOV_TEMPORAL_MASK : 0);
+            double totalBytes = 0.0;
+            for (UINT aov = 0; aov < AOV_COUNT; ++aov) {
+                ui::CheckboxFlags(Aov::kAovNames[aov], &mAovMask, AOV_BIT(aov));
+                double bytes = (aovMask & AOV_BIT(aov)) ? double(Aov::kAovBytesPerPixel[aov]) * mOutputPixelCount : 0.0;
+                double readBytes = mTemporalAccumulation && aovHasHistory(aov) ? 2.0 * bytes : 0.0;
+                ui::SameLine(120.0f);
+                ui::Text("%u B/px, %.2f MB written, %.2f MB read", Aov::kAovBytesPerPixel[aov], bytes / 1.0e+6, readBytes / 1.0e+6);
+                totalBytes += bytes + readBytes;
+            }
+            ui::Text("%.2f MB a frame, %.2f GB/s", totalBytes / 1.0e+6, totalBytes * ui::GetIO().Framerate / 1.0e+9);
+        }
     }
     ui::End();
 }
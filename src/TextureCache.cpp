@@ -0,0 +1,308 @@
+#include "pch.h"
+#include "TextureCache.h"
+#include "WICTextureLoader.h"
+#include "DDSTextureLoader.h"
+#include "ResourceUploadBatch.h"
+#include "RtEnvironmentPrefilter.h"
+#include <DirectXPackedVector.h>
+#include <chrono>
+
+using namespace DirectX;
+using namespace DXRFramework;
+
+TextureCache::TextureCache(RtContext::SharedPtr context, ID3D12CommandQueue *mipGenerationQueue)
+    : mRtContext(context), mMipGenerationQueue(mipGenerationQueue)
+{
+}
+
+// Features that need texels on the CPU fall back when they cannot get them, which is easy to miss
+static void logFallback(const std::wstring &path, const wchar_t *message)
+{
+    OutputDebugStringW((L"TextureCache: " + path + L" " + message + L"\n").c_str());
+}
+
+// Offline converted textures (see tools/TextureConverter) live next to their source as "<name>.bc.dds"
+// and are used when they are at least as new as the source file. Their block compressed texels are
+// not decoded on the CPU, so loads that need a CPU copy keep the source.
+static std::wstring findConvertedTexture(const std::wstring &path, UINT flags)
+{
+    size_t dot = path.find_last_of(L'.');
+    if (dot == std::wstring::npos) {
+        return path;
+    }
+    std::wstring convertedPath = path.substr(0, dot) + L".bc.dds";
+
+    WIN32_FILE_ATTRIBUTE_DATA source, converted;
+    if (!GetFileAttributesExW(convertedPath.c_str(), GetFileExInfoStandard, &converted)) {
+        return path;
+    }
+    if (GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &source) && CompareFileTime(&converted.ftLastWriteTime, &source.ftLastWriteTime) < 0) {
+        return path;
+    }
+    if (flags & (TextureCache::KeepCpuCopy | TextureCache::PrefilterEnvironment)) {
+        logFallback(convertedPath, L"is ignored, the load needs a CPU copy");
+        return path;
+    }
+    return convertedPath;
+}
+
+// Decodes the top mip of every array slice of the uncompressed formats the loaders produce
+static void copyToCpu(TextureCache::Texture &texture, const std::vector<D3D12_SUBRESOURCE_DATA> &subresources)
+{
+    D3D12_RESOURCE_DESC desc = texture.resource->GetDesc();
+    UINT width = static_cast<UINT>(desc.Width);
+    UINT slices = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D ? desc.DepthOrArraySize : 1;
+
+    bool supported = desc.Format == DXGI_FORMAT_R32G32B32A32_FLOAT || desc.Format == DXGI_FORMAT_R16G16B16A16_FLOAT ||
+                     desc.Format == DXGI_FORMAT_R8G8B8A8_UNORM || desc.Format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+    if (!supported || subresources.size() < size_t(slices) * desc.MipLevels) {
+        return;
+    }
+
+    texture.cpuWidth = width;
+    texture.cpuHeight = desc.Height;
+    texture.cpuTexels.resize(size_t(slices) * width * desc.Height);
+    auto *texel = texture.cpuTexels.data();
+    for (UINT slice = 0; slice < slices; ++slice) {
+        const D3D12_SUBRESOURCE_DATA &subresource = subresources[slice * desc.MipLevels];
+        for (UINT y = 0; y < desc.Height; ++y) {
+            auto *row = static_cast<const uint8_t *>(subresource.pData) + y * subresource.RowPitch;
+            for (UINT x = 0; x < width; ++x, ++texel) {
+                switch (desc.Format) {
+                case DXGI_FORMAT_R32G32B32A32_FLOAT:
+                    memcpy(texel, row + x * 16, 16);
+                    break;
+                case DXGI_FORMAT_R16G16B16A16_FLOAT: {
+                    auto *half = reinterpret_cast<const PackedVector::HALF *>(row + x * 8);
+                    *texel = { PackedVector::XMConvertHalfToFloat(half[0]), PackedVector::XMConvertHalfToFloat(half[1]),
+                               PackedVector::XMConvertHalfToFloat(half[2]), PackedVector::XMConvertHalfToFloat(half[3]) };
+                    break;
+                }
+                default: {
+                    // Radiance is wanted in linear space
+                    const uint8_t *rgba = row + x * 4;
+                    bool srgb = desc.Format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+                    auto toLinear = [srgb](uint8_t value) { float c = value / 255.0f; return srgb ? std::pow(c, 2.2f) : c; };
+                    *texel = { toLinear(rgba[0]), toLinear(rgba[1]), toLinear(rgba[2]), rgba[3] / 255.0f };
+                    break;
+                }
+                }
+            }
+        }
+    }
+}
+
+// Replaces mips from 1 on of a float cubemap with the GGX prefiltered chain of its top mip. The new
+// mips are kept in storage until the upload is done, the subresources point into it.
+static void prefilterEnvironment(TextureCache::Texture &texture, std::vector<D3D12_SUBRESOURCE_DATA> &subresources,
+                                 std::vector<std::vector<uint8_t>> &storage, RtJobSystem *jobSystem)
+{
+    D3D12_RESOURCE_DESC desc = texture.resource->GetDesc();
+    bool half = desc.Format == DXGI_FORMAT_R16G16B16A16_FLOAT;
+    if ((!half && desc.Format != DXGI_FORMAT_R32G32B32A32_FLOAT) || desc.DepthOrArraySize != 6 || texture.cpuWidth != texture.cpuHeight) {
+        return;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto prefilter = RtEnvironmentPrefilter::build(texture.cpuTexels.data(), texture.cpuWidth, desc.MipLevels, jobSystem);
+    UINT texelBytes = half ? 8 : 16;
+    for (UINT mip = 1; mip < prefilter->getMipCount(); ++mip) {
+        UINT mipSize = prefilter->getMipSize(mip);
+        for (UINT face = 0; face < 6; ++face) {
+            const CpuMath::float4 *texels = &prefilter->getMip(mip)[size_t(face) * mipSize * mipSize];
+            storage.emplace_back(size_t(mipSize) * mipSize * texelBytes);
+            uint8_t *target = storage.back().data();
+            if (half) {
+                PackedVector::XMConvertFloatToHalfStream(reinterpret_cast<PackedVector::HALF *>(target), sizeof(PackedVector::HALF),
+                                                         &texels->x, sizeof(float), size_t(mipSize) * mipSize * 4);
+            } else {
+                memcpy(target, texels, storage.back().size());
+            }
+
+            D3D12_SUBRESOURCE_DATA &subresource = subresources[face * desc.MipLevels + mip];
+            subresource.pData = target;
+            subresource.RowPitch = LONG_PTR(mipSize) * texelBytes;
+            subresource.SlicePitch = subresource.RowPitch * mipSize;
+        }
+    }
+
+    texture.prefilteredMipCount = prefilter->getMipCount();
+    for (UINT i = 0; i < 9; ++i) {
+        CpuMath::float3 c = prefilter->getIrradianceCoefficients()[i];
+        texture.irradianceSH[i] = XMFLOAT4(c.x, c.y, c.z, 0.0f);
+    }
+    texture.prefilterTimeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+TextureCache::PendingTexture TextureCache::loadAsync(const std::wstring &path, UINT flags)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = mEntries.find(path);
+    if (it != mEntries.end()) {
+        it->second.requests++;
+        return it->second.texture;
+    }
+
+    // The slot is reserved here rather than on the worker, so that the descriptor tables the render
+    // thread allocates meanwhile stay contiguous
+    UINT srvHeapIndex = UINT_MAX;
+    if (!mFreeSrvHeapIndices.empty()) {
+        srvHeapIndex = mFreeSrvHeapIndices.back();
+        mFreeSrvHeapIndices.pop_back();
+    } else {
+        D3D12_CPU_DESCRIPTOR_HANDLE srvCpuHandle;
+        srvHeapIndex = mRtContext->allocateDescriptor(&srvCpuHandle);
+    }
+
+    Entry entry;
+    entry.texture = std::async(std::launch::async, [this, path, flags, srvHeapIndex] {
+        return loadTexture(path, flags, srvHeapIndex);
+    }).share();
+    entry.requests = 1;
+    mEntries[path] = entry;
+    return entry.texture;
+}
+
+TextureCache::TextureHandle TextureCache::loadTexture(const std::wstring &path, UINT flags, UINT srvHeapIndex)
+{
+    // WIC decoders are COM objects, make sure this worker thread is in the MTA
+    HRESULT comInitialized = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto device = mRtContext->getDevice();
+    auto texture = std::make_shared<Texture>();
+
+    std::wstring filePath = findConvertedTexture(path, flags);
+    texture->converted = filePath != path;
+
+    // Converted files carry a precomputed mip chain
+    bool generateMips = (flags & GenerateMips) != 0 && !texture->converted;
+    bool isDDS = filePath.size() >= 4 && _wcsicmp(filePath.c_str() + filePath.size() - 4, L".dds") == 0;
+
+    if (generateMips) {
+        // Mip generation runs a compute shader, which the copy queue cannot execute
+        if (flags & (KeepCpuCopy | PrefilterEnvironment)) {
+            logFallback(filePath, L"has no CPU copy, its mips are generated on the GPU");
+        }
+        ResourceUploadBatch resourceUpload(device);
+        resourceUpload.Begin();
+        if (isDDS) {
+            ThrowIfFailed(CreateDDSTextureFromFile(device, resourceUpload, filePath.c_str(), &texture->resource, true));
+        } else {
+            ThrowIfFailed(CreateWICTextureFromFile(device, resourceUpload, filePath.c_str(), &texture->resource, true));
+        }
+        auto uploadResourcesFinished = resourceUpload.End(mMipGenerationQueue);
+        uploadResourcesFinished.wait();
+    } else {
+        std::unique_ptr<uint8_t[]> data;
+        std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+        if (isDDS) {
+            ThrowIfFailed(LoadDDSTextureFromFile(device, filePath.c_str(), &texture->resource, data, subresources));
+        } else {
+            subresources.resize(1);
+            ThrowIfFailed(LoadWICTextureFromFile(device, filePath.c_str(), &texture->resource, data, subresources[0]));
+        }
+
+        std::vector<std::vector<uint8_t>> prefilteredMips;
+        if (flags & (KeepCpuCopy | PrefilterEnvironment)) {
+            copyToCpu(*texture, subresources);
+            if (texture->cpuTexels.empty()) {
+                logFallback(filePath, L"has no CPU copy, its format is not decoded");
+            }
+            if ((flags & PrefilterEnvironment) && (flags & Cubemap) && !texture->cpuTexels.empty()) {
+                prefilterEnvironment(*texture, subresources, prefilteredMips, mRtContext->getJobSystem().get());
+            }
+            if ((flags & PrefilterEnvironment) && texture->prefilteredMipCount == 0) {
+                logFallback(filePath, L"is not prefiltered, only square float cubemaps are");
+            }
+            if (!(flags & KeepCpuCopy)) {
+                texture->cpuTexels = {};
+            }
+        }
+
+        // Only this worker blocks on the copy; the decoded data has to stay alive until then
+        auto uploadQueue = mRtContext->getUploadQueue();
+        UINT64 fenceValue = uploadQueue->uploadTexture(texture->resource.Get(), subresources.data(), static_cast<UINT>(subresources.size()));
+        uploadQueue->waitOnCpu(fenceValue);
+    }
+
+    texture->srvHeapIndex = srvHeapIndex;
+    texture->srvGpuHandle = mRtContext->createTextureSRVHandle(texture->resource.Get(), (flags & Cubemap) != 0, texture->srvHeapIndex);
+
+    D3D12_RESOURCE_DESC desc = texture->resource->GetDesc();
+    texture->sizeInBytes = device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+    texture->loadTimeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    if (SUCCEEDED(comInitialized)) {
+        CoUninitialize();
+    }
+    return texture;
+}
+
+void TextureCache::releaseUnused()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for (auto it = mEntries.begin(); it != mEntries.end();) {
+        auto &pending = it->second.texture;
+        bool ready = pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+
+        // The shared state of the future holds the only remaining reference
+        if (ready && pending.get().use_count() == 1) {
+            mFreeSrvHeapIndices.push_back(pending.get()->srvHeapIndex);
+            it = mEntries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+UINT64 TextureCache::getResidentBytes() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    UINT64 bytes = 0;
+    for (auto &it : mEntries) {
+        auto &pending = it.second.texture;
+        if (pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            bytes += pending.get()->sizeInBytes;
+        }
+    }
+    return bytes;
+}
+
+std::string TextureCache::report() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    const double MB = 1024.0 * 1024.0;
+    UINT64 residentBytes = 0;
+    UINT64 avoidedBytes = 0;
+    double avoidedMs = 0.0;
+
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(1);
+    for (auto &it : mEntries) {
+        std::wstring filename = it.first.substr(it.first.find_last_of(L"\\/") + 1);
+        stream << std::string(filename.begin(), filename.end()) << ": ";
+
+        auto &pending = it.second.texture;
+        if (pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            stream << "loading, " << it.second.requests << " requests\n";
+            continue;
+        }
+
+        auto &texture = pending.get();
+        UINT duplicates = it.second.requests - 1;
+        residentBytes += texture->sizeInBytes;
+        avoidedBytes += duplicates * texture->sizeInBytes;
+        avoidedMs += duplicates * texture->loadTimeMs;
+
+        stream << (texture->converted ? "converted, " : "") << texture->sizeInBytes / MB << " MB, loaded in " << texture->loadTimeMs << " ms, "
+               << it.second.requests << " requests, " << texture.use_count() - 1 << " holders\n";
+    }
+    stream << "resident " << residentBytes / MB << " MB, duplicate uploads avoided "
+           << avoidedBytes / MB << " MB / " << avoidedMs << " ms\n";
+    return stream.str();
+}
@@ -0,0 +1,186 @@
+#include "pch.h"
+#include "TaskGraph.h"
+#include "RtJobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+
+TaskGraph::TaskGraph() : mOrigin(Clock::now())
+{
+}
+
+TaskGraph::TaskId TaskGraph::addTask(const std::string &name, std::function<void()> function, std::vector<TaskId> dependencies)
+{
+    TaskId id = mTasks.size();
+    for (auto dependency : dependencies) {
+        ThrowIfFalse(dependency < id, L"TaskGraph dependencies must be added before their dependents");
+        mTasks[dependency].dependents.push_back(id);
+    }
+
+    Task task;
+    task.name = name;
+    task.function = function;
+    task.dependencies = std::move(dependencies);
+    mTasks.emplace_back(std::move(task));
+    return id;
+}
+
+void TaskGraph::recordExternal(const std::string &name, Clock::time_point start, Clock::time_point end)
+{
+    Task task;
+    task.name = name;
+    task.start = start;
+    task.end = end;
+    task.external = true;
+    mTasks.emplace_back(std::move(task));
+}
+
+void TaskGraph::run(DXRFramework::RtJobSystem &jobSystem)
+{
+    std::vector<std::atomic<UINT>> remainingDependencies(mTasks.size());
+    std::vector<std::atomic<bool>> skipped(mTasks.size());
+    std::mutex exceptionMutex;
+    std::exception_ptr firstException;
+    DXRFramework::RtTaskGroup group(jobSystem);
+
+    std::function<void(TaskId)> runTask = [&](TaskId id) {
+        Task &task = mTasks[id];
+        if (!skipped[id]) {
+            task.threadIndex = jobSystem.getCurrentThreadIndex();
+            task.start = Clock::now();
+            try {
+                task.function();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(exceptionMutex);
+                if (!firstException) {
+                    firstException = std::current_exception();
+                }
+                skipped[id] = true;
+            }
+            task.end = Clock::now();
+        } else {
+            task.start = task.end = Clock::now();
+        }
+
+        // The last dependency to finish starts the dependent
+        for (auto dependent : task.dependents) {
+            if (skipped[id]) {
+                skipped[dependent] = true;
+            }
+            if (--remainingDependencies[dependent] == 0) {
+                group.run([&runTask, dependent] { runTask(dependent); });
+            }
+        }
+    };
+
+    std::vector<TaskId> readyTasks;
+    for (TaskId id = 0; id < mTasks.size(); ++id) {
+        skipped[id] = false;
+        remainingDependencies[id] = static_cast<UINT>(mTasks[id].dependencies.size());
+        if (!mTasks[id].external && mTasks[id].function && mTasks[id].dependencies.empty()) {
+            readyTasks.push_back(id);
+        }
+    }
+    for (auto id : readyTasks) {
+        group.run([&runTask, id] { runTask(id); });
+    }
+    // The calling thread runs tasks as well while it waits
+    group.wait();
+
+    if (firstException) {
+        std::rethrow_exception(firstException);
+    }
+}
+
+void TaskGraph::run(UINT maxWorkerThreads)
+{
+    auto jobSystem = DXRFramework::RtJobSystem::create(maxWorkerThreads);
+    run(*jobSystem);
+}
+
+std::vector<TaskGraph::TaskId> TaskGraph::computeCriticalPath(double *lengthMs) const
+{
+    // Longest path through the dependency DAG, weighted by measured task duration.
+    // Tasks are stored in topological order since dependencies must be added first.
+    std::vector<double> finish(mTasks.size(), 0.0);
+    std::vector<TaskId> predecessor(mTasks.size(), SIZE_MAX);
+    TaskId last = SIZE_MAX;
+    double longest = 0.0;
+
+    for (TaskId id = 0; id < mTasks.size(); ++id) {
+        const Task &task = mTasks[id];
+        double earliest = 0.0;
+        for (auto dependency : task.dependencies) {
+            if (finish[dependency] > earliest) {
+                earliest = finish[dependency];
+                predecessor[id] = dependency;
+            }
+        }
+        finish[id] = earliest + std::chrono::duration<double, std::milli>(task.end - task.start).count();
+        if (finish[id] > longest) {
+            longest = finish[id];
+            last = id;
+        }
+    }
+
+    std::vector<TaskId> path;
+    for (TaskId id = last; id != SIZE_MAX; id = predecessor[id]) {
+        path.push_back(id);
+    }
+    std::reverse(path.begin(), path.end());
+
+    if (lengthMs) {
+        *lengthMs = longest;
+    }
+    return path;
+}
+
+double TaskGraph::getWallTimeMs() const
+{
+    Clock::time_point end = mOrigin;
+    for (auto &task : mTasks) {
+        end = std::max(end, task.end);
+    }
+    return toMs(end);
+}
+
+double TaskGraph::getCriticalPathMs() const
+{
+    double length;
+    computeCriticalPath(&length);
+    return length;
+}
+
+std::string TaskGraph::report() const
+{
+    double criticalPathMs;
+    auto criticalPath = computeCriticalPath(&criticalPathMs);
+
+    std::vector<TaskId> order(mTasks.size());
+    for (TaskId id = 0; id < mTasks.size(); ++id) {
+        order[id] = id;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](TaskId a, TaskId b) { return mTasks[a].start < mTasks[b].start; });
+
+    double serialMs = 0.0;
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(1);
+    stream << "  start(ms)    dur(ms)  thread  task\n";
+    for (auto id : order) {
+        const Task &task = mTasks[id];
+        double durationMs = std::chrono::duration<double, std::milli>(task.end - task.start).count();
+        bool critical = std::find(criticalPath.begin(), criticalPath.end(), id) != criticalPath.end();
+        serialMs += durationMs;
+
+        stream << std::setw(11) << toMs(task.start) << std::setw(11) << durationMs << "  ";
+        if (task.external) {
+            stream << "  main";
+        } else {
+            stream << std::setw(6) << task.threadIndex;
+        }
+        stream << (critical ? " * " : "   ") << task.name << "\n";
+    }
+    stream << "wall time " << getWallTimeMs() << " ms, critical path " << criticalPathMs << " ms, serial sum " << serialMs << " ms\n";
+    return stream.str();
+}
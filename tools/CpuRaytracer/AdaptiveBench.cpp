@@ -0,0 +1,130 @@
+#include "CpuRaytracer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace DXRFramework;
+using namespace DXRFramework::CpuMath;
+
+namespace CpuRaytracer
+{
+    // Error against a high sample count reference of adaptive and uniform sampling at equal ray counts.
+    // The adaptive run goes on until every tile has converged; a render after that must trace nothing,
+    // and the wavefront path must skip the same tiles as the recursive shaders.
+    int adaptiveBench(const Options &options)
+    {
+        const uint32_t size = 256;
+        const uint32_t referenceSamples = 512;
+        const uint32_t maxSamples = 256;
+        auto context = CpuContext::create(options.threads);
+
+        struct BenchScene
+        {
+            const char *name;
+            CpuScene::SharedPtr scene;
+            CpuTexture::SharedPtr environment;
+        };
+        double buildSeconds;
+        BenchScene scenes[] = {
+            { "susanne, environment", loadScene({ "assets/models/susanne.obj" }, false, buildSeconds), loadEnvironment("assets/textures/CathedralRadiance.dds") },
+            { "cornell", loadScene({ "assets/models/cornell.obj" }, false, buildSeconds), nullptr },
+        };
+
+        printf("%u threads, %ux%u, threshold %.3f, reference %u spp\n", context->getThreadCount(), size, size, options.adaptiveThreshold, referenceSamples);
+        bool passed = true;
+        for (const BenchScene &benchScene : scenes) {
+            auto createPipeline = [&](bool adaptive, bool wavefront) {
+                auto pipeline = std::make_shared<ProgressiveRaytracing>(context, benchScene.scene, std::vector<MaterialParams>{ defaultMaterial() });
+                pipeline->resize(size, size);
+                pipeline->setCamera(frameScene(benchScene.scene->getBounds()));
+                pipeline->setEnvironment(benchScene.environment);
+                pipeline->getOptions().adaptiveSampling = adaptive;
+                pipeline->getOptions().adaptiveErrorThreshold = options.adaptiveThreshold;
+                pipeline->setWavefront(wavefront);
+                return pipeline;
+            };
+
+            // The reference skips the seeds of the compared runs, so its noise is independent of theirs
+            auto referencePipeline = createPipeline(false, false);
+            for (uint32_t i = 0; i < maxSamples; ++i) {
+                referencePipeline->render();
+            }
+            referencePipeline->resetAccumulation();
+            for (uint32_t i = 0; i < referenceSamples; ++i) {
+                referencePipeline->render();
+            }
+            auto reference = copyImage(*referencePipeline->getOutput());
+
+            struct Pass
+            {
+                uint32_t activeTiles;
+                uint64_t rays;
+                double error;
+            };
+            std::vector<Pass> uniformPasses, adaptivePasses;
+            auto uniform = createPipeline(false, false);
+            auto adaptive = createPipeline(true, false);
+            uint64_t uniformRays = 0, adaptiveRays = 0;
+            for (uint32_t i = 0; i < maxSamples && !adaptive->isConverged(); ++i) {
+                uniform->render();
+                uniformRays += lastSampleRays(*uniform, *context);
+                uniformPasses.push_back({ 0, uniformRays, relativeError(*uniform->getOutput(), *reference) });
+
+                uint32_t activeTiles = i < adaptive->getOptions().adaptiveMinSamples ? static_cast<uint32_t>(adaptive->getTileErrors().size()) : adaptive->getActiveTileCount();
+                adaptive->render();
+                adaptiveRays += lastSampleRays(*adaptive, *context);
+                adaptivePasses.push_back({ activeTiles, adaptiveRays, relativeError(*adaptive->getOutput(), *reference) });
+            }
+
+            printf("%s\n%8s %8s %12s %10s %12s\n", benchScene.name, "sample", "tiles", "rays", "adaptive", "uniform");
+            for (size_t i = 0; i < adaptivePasses.size(); ++i) {
+                if ((i & (i + 1)) != 0 && i + 1 != adaptivePasses.size()) {
+                    continue;
+                }
+                // Uniform error at the same number of rays
+                size_t j = 0;
+                while (j + 1 < uniformPasses.size() && uniformPasses[j + 1].rays <= adaptivePasses[i].rays) {
+                    ++j;
+                }
+                printf("%8zu %8u %12llu %10.4f %12.4f\n", i + 1, adaptivePasses[i].activeTiles, static_cast<unsigned long long>(adaptivePasses[i].rays),
+                       adaptivePasses[i].error, uniformPasses[j].error);
+            }
+
+            if (adaptive->isConverged()) {
+                auto converged = copyImage(*adaptive->getOutput());
+                bool complete = adaptive->render();
+                bool unchanged = complete && imagesEqual(*converged, *adaptive->getOutput());
+                printf("converged after %zu samples, %.1f%% of the rays of uniform sampling%s\n", adaptivePasses.size(),
+                       100.0 * adaptiveRays / uniformRays, unchanged ? "" : ", rendered after convergence  FAILED");
+                passed &= unchanged;
+            } else {
+                printf("not converged after %u samples, %u tiles active\n", maxSamples, adaptive->getActiveTileCount());
+            }
+
+            // Same samples and tile states through the wavefront stages
+            auto recursive = createPipeline(true, false);
+            auto wavefront = createPipeline(true, true);
+            uint32_t comparedSamples = (std::min)(static_cast<uint32_t>(adaptivePasses.size()), 2 * recursive->getOptions().adaptiveMinSamples);
+            bool sameTiles = true;
+            for (uint32_t i = 0; i < comparedSamples; ++i) {
+                recursive->render();
+                wavefront->render();
+                sameTiles &= recursive->getActiveTileCount() == wavefront->getActiveTileCount();
+            }
+            double maxDifference = 0.0;
+            for (uint32_t y = 0; y < size; ++y) {
+                for (uint32_t x = 0; x < size; ++x) {
+                    float3 a = recursive->getOutput()->load(x, y).rgb(), b = wavefront->getOutput()->load(x, y).rgb();
+                    for (int i = 0; i < 3; ++i) {
+                        maxDifference = (std::max)(maxDifference, double(std::fabs(a[i] - b[i]) / (std::max)(1.0f, (std::max)(std::fabs(a[i]), std::fabs(b[i])))));
+                    }
+                }
+            }
+            bool match = sameTiles && maxDifference < 1e-3;
+            printf("wavefront after %u samples: %u active tiles, max difference %.2e%s\n", comparedSamples, wavefront->getActiveTileCount(), maxDifference,
+                   match ? "" : "  FAILED");
+            passed &= match;
+        }
+        return passed ? 0 : 1;
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+// C++ port of assets/shaders/AdaptiveSampling.hlsli and the tile reduction of AdaptiveSampling.hlsl.
+// Keep them in sync so the CPU backend converges the same tiles as the GPU pipeline.
+
+#include "Cpu/CpuContext.h"
+#include "Cpu/CpuTexture.h"
+
+namespace AdaptiveSampling
+{
+    using namespace DXRFramework::CpuMath;
+
+    const uint32_t ADAPTIVE_TILE_SIZE = 16;
+    const float ADAPTIVE_ERROR_BIAS = 0.05f;
+
+    static_assert(ADAPTIVE_TILE_SIZE == DXRFramework::CpuContext::kTileSize, "tiles are dispatched and skipped as a whole");
+
+    inline float adaptiveLuminance(const float3 &color)
+    {
+        return dot(color, float3(0.2126f, 0.7152f, 0.0722f));
+    }
+
+    inline float4 accumulateMoments(const float4 &moments, const float3 &color)
+    {
+        float luminance = adaptiveLuminance(color);
+        float n = moments.z + 1.0f;
+        float delta = luminance - moments.x;
+        float mean = moments.x + delta / n;
+        return float4(mean, moments.y + delta * (luminance - mean), n, 0.0f);
+    }
+
+    inline float estimatePixelError(const float4 &moments)
+    {
+        float n = moments.z;
+        if (n < 2.0f) {
+            return 1.0e+6f;
+        }
+        float variance = moments.y / (n - 1.0f);
+        return std::sqrt(variance / n) / (moments.x + ADAPTIVE_ERROR_BIAS);
+    }
+
+    // Root mean square of the pixel errors of a tile
+    inline float estimateTileError(const DXRFramework::CpuTileBuffer &moments, uint32_t tileX, uint32_t tileY)
+    {
+        uint32_t x0 = tileX * ADAPTIVE_TILE_SIZE, y0 = tileY * ADAPTIVE_TILE_SIZE;
+        uint32_t x1 = (std::min)(x0 + ADAPTIVE_TILE_SIZE, moments.getWidth());
+        uint32_t y1 = (std::min)(y0 + ADAPTIVE_TILE_SIZE, moments.getHeight());
+        float squaredErrors = 0.0f;
+        for (uint32_t y = y0; y < y1; ++y) {
+            for (uint32_t x = x0; x < x1; ++x) {
+                float error = estimatePixelError(moments.at(x, y));
+                squaredErrors += error * error;
+            }
+        }
+        return std::sqrt(squaredErrors / float((x1 - x0) * (y1 - y0)));
+    }
+}
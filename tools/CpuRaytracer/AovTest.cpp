@@ -0,0 +1,83 @@
+#include "CpuRaytracer.h"
+#include "TestScene.h"
+#include "RaytracingUtils.h"
+#include "TemporalAccumulationHlslCompat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace DXRFramework;
+using namespace DXRFramework::CpuMath;
+
+namespace CpuRaytracer
+{
+    // Checks that the AOV formats of AovHlslCompat.h keep the precision temporal accumulation and the
+    // denoiser compare against, and lists what the AOVs cost a 1920x1080 frame next to the RGBA16F guide
+    // the depth and normal AOVs replace
+    int aovTest(const Options &)
+    {
+        bool passed = true;
+
+        // Octahedral normals in two snorm16 channels, over random directions and the axes where the
+        // octahedron folds. The angle comes from the cross product, acos of a float dot is too coarse.
+        const float3 axes[] = { float3(1.0f, 0.0f, 0.0f), float3(-1.0f, 0.0f, 0.0f), float3(0.0f, 1.0f, 0.0f),
+                                float3(0.0f, -1.0f, 0.0f), float3(0.0f, 0.0f, 1.0f), float3(0.0f, 0.0f, -1.0f) };
+        const uint32_t normalCount = 1000000;
+        double maxAngle = 0.0;
+        uint32_t seed = RaytracingUtils::initRand(7, 11);
+        for (uint32_t i = 0; i < normalCount; ++i) {
+            float3 normal;
+            if (i < 6) {
+                normal = axes[i];
+            } else {
+                float z = 1.0f - 2.0f * RaytracingUtils::nextRand(seed);
+                float phi = 2.0f * 3.14159265f * RaytracingUtils::nextRand(seed);
+                float r = std::sqrt((std::max)(0.0f, 1.0f - z * z));
+                normal = float3(r * std::cos(phi), r * std::sin(phi), z);
+            }
+            float3 decoded = quantizeAovNormal(normal);
+            double cx = double(normal.y) * decoded.z - double(normal.z) * decoded.y;
+            double cy = double(normal.z) * decoded.x - double(normal.x) * decoded.z;
+            double cz = double(normal.x) * decoded.y - double(normal.y) * decoded.x;
+            double dotProduct = double(normal.x) * decoded.x + double(normal.y) * decoded.y + double(normal.z) * decoded.z;
+            maxAngle = (std::max)(maxAngle, std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), dotProduct));
+        }
+        maxAngle *= 180.0 / 3.14159265358979;
+        bool normalPassed = maxAngle < 0.01;
+        printf("Normals:  %u directions, at most %.4f degrees off through R16G16_SNORM\n", normalCount, maxAngle);
+        passed &= normalPassed;
+
+        // View depth in a half, from a centimetre to the largest finite half
+        const uint32_t depthCount = 100000;
+        const float minDepth = 0.01f, maxDepth = 65504.0f;
+        double maxDepthError = 0.0;
+        for (uint32_t i = 0; i < depthCount; ++i) {
+            float depth = minDepth * std::pow(maxDepth / minDepth, float(i) / (depthCount - 1));
+            maxDepthError = (std::max)(maxDepthError, std::fabs(double(quantizeAovDepth(depth)) - depth) / depth);
+        }
+        bool depthPassed = maxDepthError < 0.1 * TEMPORAL_DEPTH_TOLERANCE;
+        printf("Depth:    at most %.2e relative error through R16_FLOAT between %g and %g, %.0fx under the reprojection's tolerance\n",
+               maxDepthError, minDepth, maxDepth, TEMPORAL_DEPTH_TOLERANCE / maxDepthError);
+        passed &= depthPassed;
+
+        // Written by the ray generation, depth and normal read again for this frame and the last by
+        // temporal accumulation, see the AOVs section of RealtimeRaytracingPipeline::userInterface
+        const uint32_t width = 1920, height = 1080;
+        const double pixelCount = double(width) * height;
+        printf("\n%ux%u       B/px  MB written     MB read\n", width, height);
+        double totalBytes = 0.0;
+        for (uint32_t aov = 0; aov < AOV_COUNT; ++aov) {
+            double bytes = Aov::kAovBytesPerPixel[aov] * pixelCount;
+            double readBytes = (AOV_TEMPORAL_MASK & AOV_BIT(aov)) ? 2.0 * bytes : 0.0;
+            printf("%-12s %8u %11.2f %11.2f\n", Aov::kAovNames[aov], Aov::kAovBytesPerPixel[aov], bytes / 1.0e+6, readBytes / 1.0e+6);
+            totalBytes += bytes + readBytes;
+        }
+        double temporalBytes = 3.0 * (Aov::kAovBytesPerPixel[AOV_DEPTH] + Aov::kAovBytesPerPixel[AOV_NORMAL]) * pixelCount;
+        double guideBytes = 3.0 * 8.0 * pixelCount;
+        printf("All AOVs %.2f MB a frame, %.2f GB/s at 60 Hz\n", totalBytes / 1.0e+6, totalBytes * 60.0 / 1.0e+9);
+        printf("Depth and normal %.2f MB a frame, the RGBA16F guide %.2f MB\n", temporalBytes / 1.0e+6, guideBytes / 1.0e+6);
+
+        printf("\n%s\n", passed ? "All AOV tests passed" : "AOV tests FAILED");
+        return passed ? 0 : 1;
+    }
+}
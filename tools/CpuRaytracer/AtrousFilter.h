@@ -0,0 +1,112 @@
+#pragma once
+
+// C++ port of the a-trous iterations of assets/shaders/DenoiseCompositorAtrous.hlsl for one signal.
+// Keep them in sync so the headless tests check the filter the denoiser runs.
+
+#include "AtrousHlslCompat.h"
+#include <algorithm>
+#include <vector>
+
+namespace Atrous
+{
+    struct FilterParams
+    {
+        uint32_t iterations = ATROUS_MAX_ITERATIONS;
+        float phiNormal = 128.0f;
+        float phiDepth = 1.0f;
+        float phiLuminance = 4.0f;
+    };
+
+    // AOVs of the primary hits that guide the filter. Empty albedo or instance IDs turn off the
+    // demodulation and the instance edges like gDemodulateAlbedo and gInstanceEdges of the shader.
+    struct Guides
+    {
+        std::vector<float4> normalDepth; // negative depth for misses
+        std::vector<float3> albedo;
+        std::vector<uint16_t> instanceIds;
+    };
+
+    // Filters the color with the variance in alpha in place
+    inline void atrousFilter(std::vector<float4> &signal, const Guides &guides, uint32_t width, uint32_t height, const FilterParams &params)
+    {
+        const std::vector<float4> &guide = guides.normalDepth;
+        bool demodulate = !guides.albedo.empty() && params.iterations > 0;
+        bool instanceEdges = !guides.instanceIds.empty();
+        auto clampedAt = [&](const std::vector<float4> &image, int x, int y) -> const float4 & {
+            x = (std::min)((std::max)(x, 0), int(width) - 1);
+            y = (std::min)((std::max)(y, 0), int(height) - 1);
+            return image[y * width + x];
+        };
+
+        // The first iteration divides by the albedo and the last multiplies it back in
+        if (demodulate) {
+            for (size_t pixel = 0; pixel < signal.size(); ++pixel) {
+                float3 factor = atrousDemodulationFactor(guides.albedo[pixel]);
+                float luminanceFactor = atrousLuminance(factor);
+                signal[pixel] = float4(signal[pixel].rgb() / factor, signal[pixel].w / (luminanceFactor * luminanceFactor));
+            }
+        }
+
+        std::vector<float4> filtered(signal.size());
+        for (uint32_t iteration = 0; iteration < params.iterations; ++iteration) {
+            int step = 1 << iteration;
+            for (int y = 0; y < int(height); ++y) {
+                for (int x = 0; x < int(width); ++x) {
+                    const float4 &center = signal[y * width + x];
+                    const float4 &centerGuide = guide[y * width + x];
+                    if (centerGuide.w <= 0.0f) {
+                        filtered[y * width + x] = center;
+                        continue;
+                    }
+
+                    float smoothedVariance = 0.0f;
+                    for (int vy = -1; vy <= 1; ++vy) {
+                        for (int vx = -1; vx <= 1; ++vx) {
+                            smoothedVariance += atrousVarianceKernelWeight(vx, vy) * clampedAt(signal, x + vx, y + vy).w;
+                        }
+                    }
+                    float luminanceSigma = sqrt(smoothedVariance);
+
+                    float depth = centerGuide.w;
+                    float depthGradient = (std::max)((std::min)(abs(clampedAt(guide, x + 1, y).w - depth), abs(depth - clampedAt(guide, x - 1, y).w)),
+                                                     (std::min)(abs(clampedAt(guide, x, y + 1).w - depth), abs(depth - clampedAt(guide, x, y - 1).w)));
+
+                    float luminance = atrousLuminance(center.rgb());
+                    float3 colorSum(0.0f);
+                    float weightSum = 0.0f, varianceSum = 0.0f;
+                    for (int ky = -ATROUS_KERNEL_RADIUS; ky <= ATROUS_KERNEL_RADIUS; ++ky) {
+                        for (int kx = -ATROUS_KERNEL_RADIUS; kx <= ATROUS_KERNEL_RADIUS; ++kx) {
+                            int tx = x + kx * step, ty = y + ky * step;
+                            if (tx < 0 || ty < 0 || tx >= int(width) || ty >= int(height)) {
+                                continue;
+                            }
+                            const float4 &tapGuide = guide[ty * width + tx];
+                            if (tapGuide.w <= 0.0f || (instanceEdges && guides.instanceIds[ty * width + tx] != guides.instanceIds[y * width + x])) {
+                                continue;
+                            }
+                            const float4 &tap = signal[ty * width + tx];
+
+                            float offsetLength = std::sqrt(float(kx * kx + ky * ky)) * step;
+                            float weight = atrousKernelWeight(kx) * atrousKernelWeight(ky) *
+                                           atrousEdgeWeight(centerGuide.xyz(), tapGuide.xyz(), depth, tapGuide.w, depthGradient, offsetLength,
+                                                            luminance, atrousLuminance(tap.rgb()), luminanceSigma, params.phiNormal, params.phiDepth, params.phiLuminance);
+                            colorSum += tap.rgb() * weight;
+                            weightSum += weight;
+                            varianceSum += tap.w * weight * weight;
+                        }
+                    }
+                    filtered[y * width + x] = float4(colorSum / weightSum, varianceSum / (weightSum * weightSum));
+                }
+            }
+            signal.swap(filtered);
+        }
+
+        if (demodulate) {
+            for (size_t pixel = 0; pixel < signal.size(); ++pixel) {
+                float3 factor = atrousDemodulationFactor(guides.albedo[pixel]);
+                float luminanceFactor = atrousLuminance(factor);
+                signal[pixel] = float4(signal[pixel].rgb() * factor, signal[pixel].w * luminanceFactor * luminanceFactor);
+            }
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#include "CpuRaytracer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace DXRFramework;
+using namespace DXRFramework::CpuMath;
+
+namespace CpuRaytracer
+{
+    // Time per sample against error for paths of fixed depth and for paths ended by Russian roulette.
+    // Fixed depths converge to less light than there is, the reference is the limit of
+    // MAX_RADIANCE_RAY_DEPTH bounces, which the deepest fixed depth and the roulette both converge to.
+    // Exits with an error if the path length histogram does not count exactly one path per pixel and sample.
+    int bounceBench(const Options &options)
+    {
+        bool passed = true;
+        struct Config
+        {
+            const char *name;
+            uint32_t maxBounces;
+            uint32_t russianRouletteDepth; // 0 without the roulette
+        };
+        const Config configs[] = {
+            { "1 bounce", 1, 0 },
+            { "2 bounces", 2, 0 },
+            { "4 bounces", 4, 0 },
+            { "8 bounces", MAX_RADIANCE_RAY_DEPTH, 0 },
+            { "8, roulette from 2", MAX_RADIANCE_RAY_DEPTH, 2 },
+            { "8, roulette from 3", MAX_RADIANCE_RAY_DEPTH, 3 },
+        };
+        const uint32_t configCount = sizeof(configs) / sizeof(configs[0]);
+        const uint32_t fixedDepthConfig = 3;
+        const uint32_t referenceConfig = 4;
+
+        const uint32_t size = 96;
+        const uint32_t referenceSamples = 256;
+        const uint32_t maxSamples = 32;
+        auto context = CpuContext::create(options.threads);
+        auto jobSystem = RtJobSystem::create(options.threads);
+        auto environment = loadEnvironment("assets/textures/CathedralRadiance.dds");
+        double samplerSeconds;
+        auto sampler = buildEnvironmentSampler(*environment, jobSystem.get(), samplerSeconds);
+
+        struct BenchScene
+        {
+            const char *name;
+            CpuScene::SharedPtr scene;
+            CpuTexture::SharedPtr environment;
+        };
+        double buildSeconds;
+        BenchScene scenes[] = {
+            { "assets/models/cornell.obj", loadScene({ "assets/models/cornell.obj" }, false, buildSeconds), nullptr },
+            { "assets/models/susanne.obj, CathedralRadiance.dds", loadScene({ "assets/models/susanne.obj" }, false, buildSeconds), environment },
+        };
+
+        printf("%u threads, %ux%u, RMSE against a reference of 2 x %u samples of %s\n\n", context->getThreadCount(), size, size, referenceSamples,
+               configs[referenceConfig].name);
+        for (const BenchScene &benchScene : scenes) {
+            auto createPipeline = [&](const Config &config, uint32_t sequence) {
+                auto pipeline = std::make_shared<ProgressiveRaytracing>(context, benchScene.scene, std::vector<MaterialParams>{ defaultMaterial() });
+                pipeline->resize(size, size);
+                pipeline->setCamera(frameScene(benchScene.scene->getBounds()));
+                pipeline->setEnvironment(benchScene.environment, benchScene.environment ? sampler : nullptr);
+                pipeline->getOptions().sampleSequence = sequence;
+                pipeline->getOptions().maxBounces = config.maxBounces;
+                pipeline->getOptions().russianRoulette = config.russianRouletteDepth > 0;
+                pipeline->getOptions().russianRouletteDepth = config.russianRouletteDepth;
+                pipeline->getOptions().pathLengthHistogram = true;
+                return pipeline;
+            };
+
+            auto referencePipeline = createPipeline(configs[referenceConfig], SAMPLE_SEQUENCE_RANDOM);
+            CpuTexture::SharedPtr halves[2];
+            for (auto &half : halves) {
+                referencePipeline->resetAccumulation();
+                for (uint32_t i = 0; i < referenceSamples; ++i) {
+                    referencePipeline->render();
+                }
+                half = copyImage(*referencePipeline->getOutput());
+            }
+            auto reference = CpuTexture::create(size, size);
+            for (uint32_t y = 0; y < size; ++y) {
+                for (uint32_t x = 0; x < size; ++x) {
+                    reference->getData()[size_t(y) * size + x] = (halves[0]->load(x, y) + halves[1]->load(x, y)) * 0.5f;
+                }
+            }
+            double referenceNoise = meanSquaredError(*halves[0], *halves[1]) / 4.0;
+
+            std::vector<double> errors[configCount];
+            double seconds[configCount] = {};
+            uint64_t rays[configCount] = {};
+            std::vector<uint64_t> pathLengths[configCount];
+            for (uint32_t c = 0; c < configCount; ++c) {
+                auto pipeline = createPipeline(configs[c], options.sampleSequence);
+                for (uint32_t i = 0; i < maxSamples; ++i) {
+                    pipeline->render();
+                    seconds[c] += context->getLastDispatchStats().seconds;
+                    rays[c] += context->getLastDispatchStats().rays;
+                    errors[c].push_back(std::sqrt((std::max)(0.0, meanSquaredError(*pipeline->getOutput(), *reference) - referenceNoise)));
+                }
+                pathLengths[c] = pipeline->getPathLengthHistogram();
+            }
+
+            // Efficiency is the inverse of squared error times time, relative to the deepest fixed depth
+            printf("%s, reference noise %.5f\n%-20s %10s %12s %10s %12s %12s %12s\n", benchScene.name, std::sqrt(referenceNoise), "paths", "ms/sample",
+                   "rays/pixel", "hits", "RMSE 4 spp", "RMSE 32 spp", "efficiency");
+            auto efficiency = [&](uint32_t c) { return 1.0 / (errors[c][maxSamples - 1] * errors[c][maxSamples - 1] * seconds[c]); };
+            for (uint32_t c = 0; c < configCount; ++c) {
+                printf("%-20s %10.2f %12.1f %10.2f %12.5f %12.5f %12.2f\n", configs[c].name, seconds[c] / maxSamples * 1000.0,
+                       double(rays[c]) / (double(size) * size * maxSamples), meanPathLength(pathLengths[c]), errors[c][3], errors[c][maxSamples - 1],
+                       efficiency(c) / efficiency(fixedDepthConfig));
+            }
+            for (uint32_t c = fixedDepthConfig; c < configCount; ++c) {
+                printf("%-20s ", configs[c].name);
+                printPathLengthHistogram(pathLengths[c]);
+            }
+            for (uint32_t c = 0; c < configCount; ++c) {
+                uint64_t paths = 0;
+                for (uint64_t count : pathLengths[c]) {
+                    paths += count;
+                }
+                if (paths != uint64_t(size) * size * maxSamples) {
+                    printf("%-20s %llu paths in the histogram, %llu pixel samples  FAILED\n", configs[c].name,
+                           static_cast<unsigned long long>(paths), static_cast<unsigned long long>(uint64_t(size) * size * maxSamples));
+                    passed = false;
+                }
+            }
+            printf("\n");
+        }
+        return passed ? 0 : 1;
+    }
+}
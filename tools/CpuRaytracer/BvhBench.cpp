@@ -0,0 +1,390 @@
+#include "CpuRaytracer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+using namespace DXRFramework;
+using namespace DXRFramework::CpuMath;
+using namespace CpuRaytracer;
+
+namespace
+{
+    // Bumpy surface of long thin triangles running diagonally, whose bounds overlap badly like those of
+    // ground.fbx. Faces the benchmark camera.
+    RtGeometry::SharedPtr createSliverMesh(uint32_t strips, uint32_t segments)
+    {
+        auto geometry = std::make_shared<RtGeometry>();
+        for (uint32_t j = 0; j <= strips; ++j) {
+            for (uint32_t i = 0; i <= segments; ++i) {
+                float u = static_cast<float>(i) / segments, v = static_cast<float>(j) / strips;
+                float height = 0.05f * std::sin(9.0f * u) * std::sin(31.0f * v);
+                geometry->vertices.push_back({ float3(u - v, u + v - 1.0f, height), float3(0.0f, 0.0f, 1.0f) });
+            }
+        }
+        for (uint32_t j = 0; j < strips; ++j) {
+            for (uint32_t i = 0; i < segments; ++i) {
+                uint32_t v0 = j * (segments + 1) + i, v1 = v0 + 1, v2 = v0 + segments + 1, v3 = v2 + 1;
+                geometry->indices.insert(geometry->indices.end(), { v0, v1, v2, v1, v3, v2 });
+            }
+        }
+        return geometry;
+    }
+
+    struct TraversalCounts
+    {
+        double nodes = 0.0;
+        double triangles = 0.0;
+    };
+
+    // Front to back traversal of the subtree of a binary hierarchy that counts the nodes it visits.
+    // intersectPrimitive(primitiveIndex, tMax) may shorten tMax and returns true to end the traversal.
+    template <typename IntersectPrimitive>
+    uint64_t countNodes(const CpuBvh &bvh, const CpuRay &ray, uint32_t rootIndex, float &tMax, bool &ended, IntersectPrimitive &&intersectPrimitive)
+    {
+        const auto &nodes = bvh.getNodes();
+        const auto &primitiveIndices = bvh.getPrimitiveIndices();
+        CpuRayTraversal traversal(ray);
+        float tEntry;
+        std::vector<uint32_t> stack;
+        if (traversal.intersect(nodes[rootIndex].bounds, ray.tMin, tMax, tEntry)) {
+            stack.push_back(rootIndex);
+        }
+        uint64_t nodeCount = 0;
+        while (!stack.empty() && !ended) {
+            const CpuBvh::Node &node = nodes[stack.back()];
+            stack.pop_back();
+            if (!traversal.intersect(node.bounds, ray.tMin, tMax, tEntry)) {
+                continue;
+            }
+            nodeCount++;
+            if (node.isLeaf()) {
+                for (uint32_t i = 0; i < node.count && !ended; ++i) {
+                    ended = intersectPrimitive(primitiveIndices[node.offset + i], tMax);
+                }
+            } else {
+                float tLeft, tRight;
+                bool hitLeft = traversal.intersect(nodes[node.offset].bounds, ray.tMin, tMax, tLeft);
+                bool hitRight = traversal.intersect(nodes[node.offset + 1].bounds, ray.tMin, tMax, tRight);
+                bool leftFirst = !hitRight || (hitLeft && tLeft <= tRight);
+                if (hitLeft && hitRight) {
+                    stack.push_back(node.offset + (leftFirst ? 1 : 0));
+                }
+                if (hitLeft || hitRight) {
+                    stack.push_back(node.offset + (leftFirst ? 0 : 1));
+                }
+            }
+        }
+        return nodeCount;
+    }
+
+    // Triangle test for countNodes on a model built with CpuBvhLayout::Binary
+    bool countTriangle(const CpuModel &model, const CpuRay &ray, uint32_t flags, uint32_t triangle, float &tMax, uint64_t &triangleCount)
+    {
+        const RtGeometry &geometry = *model.getGeometry();
+        CpuHit hit;
+        triangleCount++;
+        if (intersectTriangle(ray, geometry.vertices[geometry.indices[triangle * 3]].position, geometry.vertices[geometry.indices[triangle * 3 + 1]].position,
+                              geometry.vertices[geometry.indices[triangle * 3 + 2]].position, flags, tMax, hit)) {
+            tMax = hit.t;
+            return (flags & CpuRayFlagAcceptFirstHitAndEndSearch) != 0;
+        }
+        return false;
+    }
+
+    // Average nodes visited and triangles tested per ray by a front to back traversal of the binary
+    // hierarchy, which must have been built with CpuBvhLayout::Binary
+    TraversalCounts countTraversal(const CpuModel &model, bool randomRays)
+    {
+        std::vector<CpuRay> rays = createTraversalRays(model.getBounds(), randomRays);
+        uint32_t flags = randomRays ? CpuRayFlagAcceptFirstHitAndEndSearch : CpuRayFlagNone;
+
+        uint64_t nodeCount = 0, triangleCount = 0;
+        for (const CpuRay &ray : rays) {
+            float tMax = ray.tMax;
+            bool ended = false;
+            nodeCount += countNodes(model.getBvh(), ray, 0, tMax, ended, [&](uint32_t triangle, float &t) {
+                return countTriangle(model, ray, flags, triangle, t, triangleCount);
+            });
+        }
+        TraversalCounts counts;
+        counts.nodes = static_cast<double>(nodeCount) / rays.size();
+        counts.triangles = static_cast<double>(triangleCount) / rays.size();
+        return counts;
+    }
+
+    // Scale by shape times a random factor, then a random rotation about a random axis and the translation
+    float3x4 randomTransform(std::function<float()> &random, const float3 &shape, float minScale, float maxScale, const float3 &translation)
+    {
+        float3 axis = normalize(float3(random() - 0.5f, random() - 0.5f, random() - 0.5f) + float3(1e-3f, 0.0f, 0.0f));
+        float angle = 2.0f * 3.14159265f * random();
+        float scale = minScale + (maxScale - minScale) * random();
+        float c = std::cos(angle), s = std::sin(angle), t = 1.0f - c;
+        const float rotation[3][3] = {
+            { t * axis.x * axis.x + c, t * axis.x * axis.y - s * axis.z, t * axis.x * axis.z + s * axis.y },
+            { t * axis.x * axis.y + s * axis.z, t * axis.y * axis.y + c, t * axis.y * axis.z - s * axis.x },
+            { t * axis.x * axis.z - s * axis.y, t * axis.y * axis.z + s * axis.x, t * axis.z * axis.z + c },
+        };
+        float3x4 transform;
+        for (int row = 0; row < 3; ++row) {
+            for (int column = 0; column < 3; ++column) {
+                transform.m[row][column] = rotation[row][column] * shape[column] * scale;
+            }
+            transform.m[row][3] = translation[row];
+        }
+        return transform;
+    }
+
+    struct SceneTraversalCounts
+    {
+        double tlasNodes = 0.0;
+        double instances = 0.0; // top level references entered, each one a ray transform
+        double blasNodes = 0.0;
+        double triangles = 0.0;
+    };
+
+    // Average visits per ray in each level of the scene's hierarchies, whose models must have been built
+    // with CpuBvhLayout::Binary. Rays are created for the given bounds, since rebraiding can tighten
+    // the scene's.
+    SceneTraversalCounts countSceneTraversal(const CpuScene &scene, const CpuAabb &bounds, bool randomRays)
+    {
+        std::vector<CpuRay> rays = createTraversalRays(bounds, randomRays);
+        uint32_t flags = randomRays ? CpuRayFlagAcceptFirstHitAndEndSearch : CpuRayFlagNone;
+
+        uint64_t tlasNodes = 0, instances = 0, blasNodes = 0, triangles = 0;
+        for (const CpuRay &ray : rays) {
+            float tMax = ray.tMax;
+            bool ended = false;
+            tlasNodes += countNodes(scene.getTlas(), ray, 0, tMax, ended, [&](uint32_t refIndex, float &t) {
+                const CpuScene::InstanceRef &ref = scene.getInstanceRefs()[refIndex];
+                const CpuScene::Instance &instance = scene.getInstance(ref.instanceIndex);
+                CpuRay objectRay = ray;
+                objectRay.origin = instance.worldToObject.transformPoint(ray.origin);
+                objectRay.direction = instance.worldToObject.transformVector(ray.direction);
+                instances++;
+                bool blasEnded = false;
+                blasNodes += countNodes(instance.model->getBvh(), objectRay, ref.node, t, blasEnded, [&](uint32_t triangle, float &tTriangle) {
+                    return countTriangle(*instance.model, objectRay, flags, triangle, tTriangle, triangles);
+                });
+                return blasEnded;
+            });
+        }
+        SceneTraversalCounts counts;
+        counts.tlasNodes = static_cast<double>(tlasNodes) / rays.size();
+        counts.instances = static_cast<double>(instances) / rays.size();
+        counts.blasNodes = static_cast<double>(blasNodes) / rays.size();
+        counts.triangles = static_cast<double>(triangles) / rays.size();
+        return counts;
+    }
+
+    // Mrays/s of CpuScene::traceRay on one thread, with the rays of countSceneTraversal
+    double measureSceneTraversal(const CpuScene &scene, const CpuAabb &bounds, bool randomRays)
+    {
+        std::vector<CpuRay> rays = createTraversalRays(bounds, randomRays);
+        uint32_t flags = randomRays ? CpuRayFlagAcceptFirstHitAndEndSearch : CpuRayFlagNone;
+        uint32_t hits = 0;
+        double bestSeconds = 1e30;
+        for (int run = 0; run < 3; ++run) {
+            hits = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (const CpuRay &ray : rays) {
+                CpuHit hit;
+                hits += scene.traceRay(ray, flags, hit) ? 1 : 0;
+            }
+            bestSeconds = (std::min)(bestSeconds, secondsSince(start));
+        }
+        if (hits > rays.size()) {
+            printf("unreachable\n");
+        }
+        return rays.size() / bestSeconds * 1e-6;
+    }
+}
+
+namespace CpuRaytracer
+{
+    // Build time and quality of the bottom level hierarchy for each split method, then the cost and speed
+    // of the node layouts
+    int bvhBench(const Options &options)
+    {
+        uint32_t threadCount = options.threads ? options.threads : (std::max)(1u, std::thread::hardware_concurrency());
+        std::vector<std::pair<std::string, RtGeometry::SharedPtr>> meshes = {
+            { "susanne.obj", RtGeometry::import("assets/models/susanne.obj") },
+            { "cornell.obj", RtGeometry::import("assets/models/cornell.obj") },
+            { "synthetic 2M", createSyntheticMesh(1024) }
+        };
+        struct Config { const char *name; CpuBvh::SplitMethod method; uint32_t threads; };
+        const Config configs[] = {
+            { "median", CpuBvh::SplitMethod::Median, 1 },
+            { "binned SAH", CpuBvh::SplitMethod::BinnedSah, 1 },
+            { "binned SAH", CpuBvh::SplitMethod::BinnedSah, threadCount },
+        };
+
+        printf("%-14s %10s %-12s %8s %10s %10s %8s %10s\n", "mesh", "triangles", "method", "threads", "build ms", "nodes", "depth", "SAH cost");
+        for (const auto &mesh : meshes) {
+            auto model = CpuModel::create(mesh.second);
+            for (const Config &config : configs) {
+                CpuBvh::BuildOptions buildOptions;
+                buildOptions.splitMethod = config.method;
+                buildOptions.threadCount = config.threads;
+
+                // Best of a few runs, the small meshes build in microseconds
+                const int runs = mesh.second->getTriangleCount() > 100000 ? 1 : 20;
+                double bestSeconds = 1e30;
+                for (int run = 0; run < runs; ++run) {
+                    auto start = std::chrono::high_resolution_clock::now();
+                    model->build(buildOptions, CpuBvhLayout::Binary);
+                    bestSeconds = (std::min)(bestSeconds, secondsSince(start));
+                }
+
+                const CpuBvh &bvh = model->getBvh();
+                printf("%-14s %10u %-12s %8u %10.2f %10zu %8u %10.2f\n", mesh.first.c_str(), model->getTriangleCount(), config.name, config.threads,
+                       bestSeconds * 1000.0, bvh.getNodes().size(), bvh.getMaxDepth(), bvh.getSahCost());
+            }
+        }
+
+        // Memory and single thread traversal speed of the node layouts, on the same binned SAH hierarchy.
+        // Camera rays look for the closest hit, random rays between points in the bounds stop at any hit
+        // like shadow rays do.
+        printf("\n%-14s %-8s %10s %10s %14s %14s\n", "mesh", "layout", "KB", "bytes/tri", "camera Mrays/s", "random Mrays/s");
+        struct Layout { const char *name; CpuBvhLayout layout; };
+        const Layout layouts[] = { { "binary", CpuBvhLayout::Binary }, { "BVH4", CpuBvhLayout::Wide4 }, { "BVH8", CpuBvhLayout::Wide8 } };
+        for (const auto &mesh : meshes) {
+            auto model = CpuModel::create(mesh.second);
+            for (const Layout &layout : layouts) {
+                model->build(CpuBvh::BuildOptions(), layout.layout);
+                size_t memory = model->getBvhMemoryUsage();
+                printf("%-14s %-8s %10.1f %10.2f %14.2f %14.2f\n", mesh.first.c_str(), layout.name, memory / 1024.0,
+                       static_cast<double>(memory) / model->getTriangleCount(), measureTraversal(*model, false), measureTraversal(*model, true));
+            }
+        }
+        return 0;
+    }
+
+    // Quality of spatial split hierarchies against plain binned SAH: build time, references added, SAH
+    // cost, sibling overlap, nodes and triangles visited per ray and the resulting BVH4 speed on one thread
+    int bvhReport(const Options &)
+    {
+        std::vector<std::pair<std::string, RtGeometry::SharedPtr>> meshes = {
+            { "susanne.obj", RtGeometry::import("assets/models/susanne.obj") },
+            { "cornell.obj", RtGeometry::import("assets/models/cornell.obj") },
+            { "ground.fbx", RtGeometry::import("assets/models/ground.fbx") },
+            { "slivers", createSliverMesh(2048, 4) },
+            { "synthetic 2M", createSyntheticMesh(1024) }
+        };
+        struct Config { const char *name; CpuBvh::SplitMethod method; float budget; };
+        const Config configs[] = {
+            { "binned SAH", CpuBvh::SplitMethod::BinnedSah, 0.0f },
+            { "SBVH 10%", CpuBvh::SplitMethod::SpatialSah, 0.1f },
+            { "SBVH 30%", CpuBvh::SplitMethod::SpatialSah, 0.3f },
+        };
+
+        printf("%-14s %-11s %9s %8s %8s %8s | %-17s | %-17s | %-15s\n", "", "", "", "", "", "", "  camera rays", "  random rays", " BVH4 Mrays/s");
+        printf("%-14s %-11s %9s %8s %8s %8s | %8s %8s | %8s %8s | %7s %7s\n", "mesh", "method", "build ms", "refs", "SAH", "overlap",
+               "nodes", "tris", "nodes", "tris", "camera", "random");
+        for (const auto &mesh : meshes) {
+            // The sandbox importer only reads OBJ files
+            if (mesh.second->getTriangleCount() <= 1) {
+                continue;
+            }
+            auto model = CpuModel::create(mesh.second);
+            for (const Config &config : configs) {
+                CpuBvh::BuildOptions buildOptions;
+                buildOptions.splitMethod = config.method;
+                buildOptions.spatialSplitBudget = config.budget;
+
+                auto start = std::chrono::high_resolution_clock::now();
+                model->build(buildOptions, CpuBvhLayout::Binary);
+                double buildSeconds = secondsSince(start);
+
+                const CpuBvh &bvh = model->getBvh();
+                double references = static_cast<double>(bvh.getPrimitiveIndices().size()) / model->getTriangleCount();
+                TraversalCounts camera = countTraversal(*model, false);
+                TraversalCounts random = countTraversal(*model, true);
+                printf("%-14s %-11s %9.1f %7.1f%% %8.2f %8.2f | %8.1f %8.1f | %8.1f %8.1f |", mesh.first.c_str(), config.name, buildSeconds * 1000.0,
+                       (references - 1.0) * 100.0, bvh.getSahCost(), bvh.getOverlap(), camera.nodes, camera.triangles, random.nodes, random.triangles);
+
+                model->build(buildOptions, CpuBvhLayout::Wide4);
+                printf(" %7.2f %7.2f\n", measureTraversal(*model, false), measureTraversal(*model, true));
+            }
+        }
+        return 0;
+    }
+
+    // Top level hierarchies with and without rebraiding on instanced scenes: references, visits per ray
+    // in each level, and the BVH4 speed on one thread. The needles are stretched spheres whose upper
+    // nodes split them lengthwise, which the area heuristic keeps closed, and the grid of separate
+    // instances is the control.
+    int tlasReport(const Options &)
+    {
+        uint32_t state = 7;
+        std::function<float()> random = [&state]() { state = state * 1664525u + 1013904223u; return (state >> 8) * (1.0f / 16777216.0f); };
+        auto susanne = CpuModel::create("assets/models/susanne.obj");
+        auto slivers = CpuModel::create(createSliverMesh(256, 16));
+
+        std::vector<std::pair<std::string, CpuScene::SharedPtr>> scenes;
+        auto overlapping = CpuScene::create();
+        for (int i = 0; i < 64; ++i) {
+            float3 position = float3(random(), random(), random()) * 4.0f;
+            overlapping->addModel(susanne, randomTransform(random, float3(1.0f), 0.5f, 2.0f, position));
+        }
+        scenes.push_back({ "susanne x64", overlapping });
+        auto crossing = CpuScene::create();
+        for (int i = 0; i < 32; ++i) {
+            float3 position(random(), random(), random());
+            crossing->addModel(slivers, randomTransform(random, float3(1.0f), 1.0f, 2.0f, position));
+        }
+        scenes.push_back({ "slivers x32", crossing });
+        auto needles = CpuScene::create();
+        auto sphere = CpuModel::create(createSyntheticMesh(64));
+        for (int i = 0; i < 64; ++i) {
+            float3 position = float3(random(), random(), random()) * 4.0f;
+            needles->addModel(sphere, randomTransform(random, float3(4.0f, 0.1f, 0.1f), 0.5f, 1.0f, position));
+        }
+        scenes.push_back({ "needles x64", needles });
+        auto grid = CpuScene::create();
+        for (int i = 0; i < 64; ++i) {
+            float3x4 transform = float3x4::identity();
+            transform.m[0][3] = 3.0f * (i % 8);
+            transform.m[1][3] = 3.0f * (i / 8);
+            grid->addModel(susanne, transform);
+        }
+        scenes.push_back({ "susanne grid", grid });
+
+        struct Config { const char *name; bool rebraid; float budget; };
+        const Config configs[] = { { "plain", false, 0.0f }, { "rebraid 2", true, 2.0f }, { "rebraid 4", true, 4.0f }, { "rebraid 8", true, 8.0f } };
+
+        printf("%-13s %-10s %6s | %-31s | %-31s | %-15s\n", "", "", "", "  camera rays", "  random rays", " BVH4 Mrays/s");
+        printf("%-13s %-10s %6s | %7s %7s %7s %7s | %7s %7s %7s %7s | %7s %7s\n", "scene", "tlas", "refs",
+               "tlas", "inst", "blas", "tris", "tlas", "inst", "blas", "tris", "camera", "random");
+        for (const auto &scene : scenes) {
+            CpuAabb bounds;
+            for (const Config &config : configs) {
+                CpuScene::BuildOptions buildOptions;
+                buildOptions.rebraid = config.rebraid;
+                buildOptions.rebraidBudget = config.budget;
+
+                // Node handles depend on the layout, so the scene is built again for each one
+                for (uint32_t i = 0; i < scene.second->getNumInstances(); ++i) {
+                    scene.second->getModel(i)->build(CpuBvh::BuildOptions(), CpuBvhLayout::Binary);
+                }
+                scene.second->build(1, buildOptions);
+                if (!config.rebraid) {
+                    bounds = scene.second->getBounds();
+                }
+                SceneTraversalCounts camera = countSceneTraversal(*scene.second, bounds, false);
+                SceneTraversalCounts random = countSceneTraversal(*scene.second, bounds, true);
+                printf("%-13s %-10s %6zu | %7.1f %7.2f %7.1f %7.1f | %7.1f %7.2f %7.1f %7.1f |", scene.first.c_str(), config.name,
+                       scene.second->getInstanceRefs().size(), camera.tlasNodes, camera.instances, camera.blasNodes, camera.triangles,
+                       random.tlasNodes, random.instances, random.blasNodes, random.triangles);
+
+                for (uint32_t i = 0; i < scene.second->getNumInstances(); ++i) {
+                    scene.second->getModel(i)->build(CpuBvh::BuildOptions(), CpuBvhLayout::Wide4);
+                }
+                scene.second->build(1, buildOptions);
+                printf(" %7.2f %7.2f\n", measureSceneTraversal(*scene.second, bounds, false), measureSceneTraversal(*scene.second, bounds, true));
+            }
+        }
+        return 0;
+    }
+}
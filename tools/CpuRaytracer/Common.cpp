@@ -0,0 +1,314 @@
+#include "CpuRaytracer.h"
+#include "AdaptiveSampling.h"
+#include "Image.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace DXRFramework;
+using namespace DXRFramework::CpuMath;
+
+namespace CpuRaytracer
+{
+    double secondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // Same material as the app's default material
+    MaterialParams defaultMaterial()
+    {
+        MaterialParams material = {};
+        material.albedo = XMFLOAT4(0.95f, 0.05f, 0.0f, 1.0f);
+        material.specular = XMFLOAT4(0.58f, 0.58f, 0.58f, 1.0f);
+        material.roughness = 0.5f;
+        material.reflectivity = 0.7f;
+        material.type = 1;
+        return material;
+    }
+
+    // Looks at the scene from the front, slightly above, with the whole bounding sphere in view
+    ProgressiveRaytracing::Camera frameScene(const CpuAabb &bounds)
+    {
+        ProgressiveRaytracing::Camera camera;
+        camera.fovY = 0.785398f;
+        camera.up = float3(0.0f, 1.0f, 0.0f);
+        camera.target = bounds.center();
+        float radius = 0.5f * length(bounds.extent());
+        camera.eye = camera.target + normalize(float3(0.0f, 0.25f, 1.0f)) * (radius / std::sin(0.5f * camera.fovY));
+        return camera;
+    }
+
+    // Lights scattered through the scene just inside its bounds, in total about as bright as the point
+    // light at the scale of the scene
+    std::vector<RtLightTree::Light> scatterLights(const CpuAabb &bounds, uint32_t count)
+    {
+        float3 margin = bounds.extent() * 0.05f;
+        float radius = 0.5f * length(bounds.extent());
+        return RtLightTree::scatter(count, bounds.lower + margin, bounds.upper - margin, 2.0f * radius * radius, 1);
+    }
+
+    // mipCount receives the mip count of the file, the chain the GPU path prefilters
+    CpuTexture::SharedPtr loadEnvironment(const std::string &path, uint32_t *mipCount)
+    {
+        TextureConverter::Texture texture = TextureConverter::readTexture(path);
+        const TextureConverter::Image &top = texture.faces[0][0];
+        if (mipCount) {
+            *mipCount = static_cast<uint32_t>(texture.faces[0].size());
+        }
+        auto environment = CpuTexture::create(top.width, top.height, texture.cubemap);
+        for (uint32_t face = 0; face < texture.faces.size(); ++face) {
+            memcpy(environment->getData(face), texture.faces[face][0].pixels.data(), size_t(top.width) * top.height * sizeof(float4));
+        }
+        return environment;
+    }
+
+    RtEnvironmentSampler::SharedPtr buildEnvironmentSampler(const CpuTexture &environment, RtJobSystem *jobSystem, double &buildSeconds)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        auto sampler = RtEnvironmentSampler::build(environment.getData(), environment.getWidth(), environment.getHeight(), environment.isCubemap(), jobSystem);
+        buildSeconds = secondsSince(start);
+        return sampler;
+    }
+
+    // Null for lat-long maps, which the GPU path does not prefilter either
+    RtEnvironmentPrefilter::SharedPtr buildEnvironmentPrefilter(const CpuTexture &environment, uint32_t mipCount, RtJobSystem *jobSystem, double &buildSeconds)
+    {
+        if (!environment.isCubemap()) {
+            return nullptr;
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+        auto prefilter = RtEnvironmentPrefilter::build(environment.getData(), environment.getWidth(), mipCount, jobSystem);
+        buildSeconds = secondsSince(start);
+        return prefilter;
+    }
+
+    void writeImage(const CpuTexture &image, const std::string &path)
+    {
+        uint32_t width = image.getWidth(), height = image.getHeight();
+        FILE *file = fopen(path.c_str(), "wb");
+        if (!file) {
+            throw std::runtime_error("cannot open " + path);
+        }
+
+        bool pfm = path.size() > 4 && path.compare(path.size() - 4, 4, ".pfm") == 0;
+        if (pfm) {
+            // Linear radiance, rows stored bottom to top
+            fprintf(file, "PF\n%u %u\n-1.0\n", width, height);
+            for (uint32_t y = height; y-- > 0;) {
+                for (uint32_t x = 0; x < width; ++x) {
+                    float3 c = image.load(x, y).rgb();
+                    fwrite(&c, sizeof(float), 3, file);
+                }
+            }
+        } else {
+            // The swap chain is sRGB, so apply the same encoding
+            fprintf(file, "P6\n%u %u\n255\n", width, height);
+            for (uint32_t y = 0; y < height; ++y) {
+                for (uint32_t x = 0; x < width; ++x) {
+                    float3 c = saturate(image.load(x, y).rgb());
+                    for (int i = 0; i < 3; ++i) {
+                        float s = c[i] <= 0.0031308f ? c[i] * 12.92f : 1.055f * std::pow(c[i], 1.0f / 2.4f) - 0.055f;
+                        fputc(static_cast<int>(s * 255.0f + 0.5f), file);
+                    }
+                }
+            }
+        }
+        fclose(file);
+    }
+
+    CpuScene::SharedPtr loadScene(const std::vector<std::string> &models, bool spatialSplits, double &buildSeconds)
+    {
+        auto scene = CpuScene::create();
+        for (const auto &path : models) {
+            // The importer substitutes a placeholder triangle for unreadable files, which would skew benchmarks
+            FILE *file = fopen(path.c_str(), "rb");
+            if (!file) {
+                throw std::runtime_error("cannot open " + path);
+            }
+            fclose(file);
+            scene->addModel(CpuModel::create(path), float3x4::identity());
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        CpuBvh::BuildOptions buildOptions;
+        buildOptions.splitMethod = spatialSplits ? CpuBvh::SplitMethod::SpatialSah : CpuBvh::SplitMethod::BinnedSah;
+        for (uint32_t i = 0; i < scene->getNumInstances(); ++i) {
+            scene->getModel(i)->build(buildOptions);
+        }
+        scene->build(ProgressiveRaytracing::getHitProgramCount());
+        buildSeconds = secondsSince(start);
+        return scene;
+    }
+
+    double meanPathLength(const std::vector<uint64_t> &counts)
+    {
+        uint64_t samples = 0, hits = 0;
+        for (size_t length = 0; length < counts.size(); ++length) {
+            samples += counts[length];
+            hits += counts[length] * length;
+        }
+        return samples > 0 ? double(hits) / double(samples) : 0.0;
+    }
+
+    // Share of the samples per path length, and their mean length
+    void printPathLengthHistogram(const std::vector<uint64_t> &counts)
+    {
+        uint64_t samples = 0;
+        for (uint64_t count : counts) {
+            samples += count;
+        }
+        printf("Surface hits along the longest branch of the path:");
+        for (size_t length = 0; length < counts.size(); ++length) {
+            printf(" %zu: %.1f%%", length, samples > 0 ? 100.0 * counts[length] / samples : 0.0);
+        }
+        printf(", %.2f per sample\n", meanPathLength(counts));
+    }
+
+    // Value below which the given fraction of the samples lies
+    double percentile(std::vector<double> values, double fraction)
+    {
+        std::sort(values.begin(), values.end());
+        size_t index = (std::min)(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+        return values[index];
+    }
+
+    bool imagesEqual(const CpuTexture &a, const CpuTexture &b)
+    {
+        return memcmp(a.getData(), b.getData(), size_t(a.getWidth()) * a.getHeight() * sizeof(float4)) == 0;
+    }
+
+    uint64_t lastSampleRays(ProgressiveRaytracing &pipeline, CpuContext &context)
+    {
+        if (pipeline.getWavefront() && WavefrontRaytracing::supports(pipeline.getOptions())) {
+            return pipeline.getWavefront()->getLastStats().rays;
+        }
+        return context.getLastDispatchStats().rays;
+    }
+
+    // Relative RMS error of the luminance against a reference, the measure the adaptive sampler bounds per tile
+    double relativeError(const CpuTexture &image, const CpuTexture &reference)
+    {
+        double sum = 0.0;
+        for (uint32_t y = 0; y < image.getHeight(); ++y) {
+            for (uint32_t x = 0; x < image.getWidth(); ++x) {
+                float value = AdaptiveSampling::adaptiveLuminance(image.load(x, y).rgb());
+                float expected = AdaptiveSampling::adaptiveLuminance(reference.load(x, y).rgb());
+                double error = (value - expected) / (expected + AdaptiveSampling::ADAPTIVE_ERROR_BIAS);
+                sum += error * error;
+            }
+        }
+        return std::sqrt(sum / (double(image.getWidth()) * image.getHeight()));
+    }
+
+    CpuTexture::SharedPtr copyImage(const CpuTexture &image)
+    {
+        auto copy = CpuTexture::create(image.getWidth(), image.getHeight());
+        memcpy(copy->getData(), image.getData(), size_t(image.getWidth()) * image.getHeight() * sizeof(float4));
+        return copy;
+    }
+
+    double meanSquaredError(const CpuTexture &image, const CpuTexture &reference, uint32_t blurRadius)
+    {
+        // With a blur radius the error is averaged over a box first, which keeps its low frequencies only
+        int width = image.getWidth(), height = image.getHeight(), radius = blurRadius;
+        std::vector<float3> error(size_t(width) * height);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                error[size_t(y) * width + x] = image.load(x, y).rgb() - reference.load(x, y).rgb();
+            }
+        }
+        double sum = 0.0;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                float3 blurred(0.0f);
+                for (int dy = -radius; dy <= radius; ++dy) {
+                    for (int dx = -radius; dx <= radius; ++dx) {
+                        blurred += error[size_t((y + dy + height) % height) * width + (x + dx + width) % width];
+                    }
+                }
+                blurred = blurred / float((2 * radius + 1) * (2 * radius + 1));
+                sum += dot(blurred, blurred) / 3.0;
+            }
+        }
+        return sum / (double(width) * height);
+    }
+
+    // Sphere with a bumpy surface, tessellated into 2 * segments^2 triangles of varying size and orientation
+    RtGeometry::SharedPtr createSyntheticMesh(uint32_t segments)
+    {
+        auto geometry = std::make_shared<RtGeometry>();
+        for (uint32_t j = 0; j <= segments; ++j) {
+            for (uint32_t i = 0; i <= segments; ++i) {
+                float theta = 3.14159265f * j / segments;
+                float phi = 2.0f * 3.14159265f * i / segments;
+                float3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+                float radius = 1.0f + 0.05f * std::sin(23.0f * theta) * std::sin(17.0f * phi) + 0.02f * std::sin(71.0f * phi + 5.0f * theta);
+                geometry->vertices.push_back({ normal * radius, normal });
+            }
+        }
+        for (uint32_t j = 0; j < segments; ++j) {
+            for (uint32_t i = 0; i < segments; ++i) {
+                uint32_t v0 = j * (segments + 1) + i, v1 = v0 + 1, v2 = v0 + segments + 1, v3 = v2 + 1;
+                geometry->indices.insert(geometry->indices.end(), { v0, v1, v2, v1, v3, v2 });
+            }
+        }
+        return geometry;
+    }
+
+    // A 512x512 grid of camera rays looking at the bounds, or as many random segments between points inside them
+    std::vector<CpuRay> createTraversalRays(const CpuAabb &bounds, bool randomRays)
+    {
+        const uint32_t size = 512;
+        float radius = length(bounds.extent()) * 0.5f;
+        float3 center = bounds.center();
+
+        std::vector<CpuRay> rays(size * size);
+        uint32_t state = 1;
+        auto random = [&state]() { state = state * 1664525u + 1013904223u; return (state >> 8) * (1.0f / 16777216.0f); };
+        for (uint32_t i = 0; i < rays.size(); ++i) {
+            CpuRay &ray = rays[i];
+            if (randomRays) {
+                float3 from = bounds.lower + bounds.extent() * float3(random(), random(), random());
+                float3 to = bounds.lower + bounds.extent() * float3(random(), random(), random());
+                ray.origin = from;
+                ray.direction = to - from;
+                ray.tMin = 0.0f;
+                ray.tMax = 1.0f;
+            } else {
+                float u = ((i % size) + 0.5f) / size * 2.0f - 1.0f;
+                float v = ((i / size) + 0.5f) / size * 2.0f - 1.0f;
+                ray.origin = center + float3(0.0f, 0.0f, 2.5f * radius);
+                ray.direction = normalize(float3(u * 0.45f, -v * 0.45f, -1.0f));
+                ray.tMin = 0.0f;
+                ray.tMax = 1e30f;
+            }
+        }
+        return rays;
+    }
+
+    // Mrays/s of CpuModel::intersect on one thread. Camera rays look for the closest hit, random segments
+    // stop at any hit like shadow rays do.
+    double measureTraversal(const CpuModel &model, bool randomRays)
+    {
+        std::vector<CpuRay> rays = createTraversalRays(model.getBounds(), randomRays);
+        uint32_t flags = randomRays ? CpuRayFlagAcceptFirstHitAndEndSearch : CpuRayFlagNone;
+        uint32_t hits = 0;
+        double bestSeconds = 1e30;
+        for (int run = 0; run < 3; ++run) {
+            hits = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (const CpuRay &ray : rays) {
+                CpuHit hit;
+                hits += model.intersect(ray, flags, hit) ? 1 : 0;
+            }
+            bestSeconds = (std::min)(bestSeconds, secondsSince(start));
+        }
+        // Keeps the loop from being optimized away
+        if (hits > rays.size()) {
+            printf("unreachable\n");
+        }
+        return rays.size() / bestSeconds * 1e-6;
+    }
+}
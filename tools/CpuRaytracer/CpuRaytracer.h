@@ -0,0 +1,98 @@
+#pragma once
+
+#include "ProgressiveRaytracing.h"
+#include "RtJobSystem.h"
+#include "SamplingHlslCompat.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Modes of the headless renderer and the helpers they share. Every bench and test lives in the source
+// file of its feature next to this header and takes the parsed command line, see main.cpp. They return
+// the exit code of the process, tests return 1 when a check fails.
+namespace CpuRaytracer
+{
+    struct Options
+    {
+        uint32_t width = 512;
+        uint32_t height = 512;
+        uint32_t samplesPerPixel = 16;
+        uint32_t threads = 0;
+        bool ambientOcclusion = false;
+        bool spatialSplits = false;
+        bool wavefront = false;
+        bool adaptive = false;
+        float adaptiveThreshold = 0.05f;
+        uint32_t sampleSequence = SAMPLE_SEQUENCE_BLUE_NOISE_SOBOL;
+        bool environmentSampling = true;
+        bool prefilteredMisses = false;
+        uint32_t maxBounces = 1;
+        uint32_t russianRouletteDepth = 2; // 0 disables it
+        bool pathLengths = false;
+        uint32_t lightCount = 0;
+        bool uniformLights = false;
+        std::string environment;
+        std::string output = "output.ppm";
+        std::vector<std::string> models;
+    };
+
+    using Mode = int (*)(const Options &options);
+
+    // Render.cpp
+    int render(const Options &options);
+    int bench(const Options &options);
+    // PassBench.cpp
+    int passBench(const Options &options);
+    // WavefrontBench.cpp
+    int wavefrontBench(const Options &options);
+    // AdaptiveBench.cpp
+    int adaptiveBench(const Options &options);
+    // SequenceBench.cpp
+    int sequenceBench(const Options &options);
+    // EnvironmentBench.cpp
+    int environmentBench(const Options &options);
+    int prefilterBench(const Options &options);
+    // BounceBench.cpp
+    int bounceBench(const Options &options);
+    // LightBench.cpp
+    int lightBench(const Options &options);
+    // ReservoirTest.cpp
+    int reservoirTest(const Options &options);
+    // TemporalTest.cpp, DenoiseTest.cpp and AovTest.cpp
+    int temporalTest(const Options &options);
+    int denoiseTest(const Options &options);
+    int aovTest(const Options &options);
+    // StagingTest.cpp
+    int stagingTest(const Options &options);
+    // BvhBench.cpp
+    int bvhBench(const Options &options);
+    int bvhReport(const Options &options);
+    int tlasReport(const Options &options);
+    // PacketBench.cpp
+    int packetBench(const Options &options);
+    // TriangleTests.cpp
+    int triangleBench(const Options &options);
+    int triangleTest(const Options &options);
+
+    // Common.cpp
+    double secondsSince(std::chrono::high_resolution_clock::time_point start);
+    MaterialParams defaultMaterial();
+    ProgressiveRaytracing::Camera frameScene(const DXRFramework::CpuAabb &bounds);
+    std::vector<DXRFramework::RtLightTree::Light> scatterLights(const DXRFramework::CpuAabb &bounds, uint32_t count);
+    DXRFramework::CpuTexture::SharedPtr loadEnvironment(const std::string &path, uint32_t *mipCount = nullptr);
+    DXRFramework::RtEnvironmentSampler::SharedPtr buildEnvironmentSampler(const DXRFramework::CpuTexture &environment, DXRFramework::RtJobSystem *jobSystem, double &buildSeconds);
+    DXRFramework::RtEnvironmentPrefilter::SharedPtr buildEnvironmentPrefilter(const DXRFramework::CpuTexture &environment, uint32_t mipCount, DXRFramework::RtJobSystem *jobSystem, double &buildSeconds);
+    void writeImage(const DXRFramework::CpuTexture &image, const std::string &path);
+    DXRFramework::CpuScene::SharedPtr loadScene(const std::vector<std::string> &models, bool spatialSplits, double &buildSeconds);
+    double meanPathLength(const std::vector<uint64_t> &counts);
+    void printPathLengthHistogram(const std::vector<uint64_t> &counts);
+    double percentile(std::vector<double> values, double fraction);
+    bool imagesEqual(const DXRFramework::CpuTexture &a, const DXRFramework::CpuTexture &b);
+    uint64_t lastSampleRays(ProgressiveRaytracing &pipeline, DXRFramework::CpuContext &context);
+    double relativeError(const DXRFramework::CpuTexture &image, const DXRFramework::CpuTexture &reference);
+    DXRFramework::CpuTexture::SharedPtr copyImage(const DXRFramework::CpuTexture &image);
+    double meanSquaredError(const DXRFramework::CpuTexture &image, const DXRFramework::CpuTexture &reference, uint32_t blurRadius = 0);
+    DXRFramework::RtGeometry::SharedPtr createSyntheticMesh(uint32_t segments);
+    std::vector<DXRFramework::CpuRay> createTraversalRays(const DXRFramework::CpuAabb &bounds, bool randomRays);
+    double measureTraversal(const DXRFramework::CpuModel &model, bool randomRays);
+}
@@ -0,0 +1,185 @@
+#include "CpuRaytracer.h"
+#include "TestScene.h"
+#include "AtrousFilter.h"
+#include "RaytracingUtils.h"
+#include "TemporalAccumulationHlslCompat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace DXRFramework;
+using namespace DXRFramework::CpuMath;
+
+namespace CpuRaytracer
+{
+    // Accumulates noisy samples of the temporal test's scene from a static camera for a few frames like
+    // TemporalAccumulation.hlsl, then runs the a-trous filter of DenoiseCompositorAtrous.hlsl on the result
+    // and compares it with the analytic image, over the whole frame and around the panel's silhouette.
+    // The guides go through the AOV formats first. Without the albedo the filter blurs the wall's texture
+    // in the temporal test as if it were noise, so the plain filter is only gated on a slowly lit wall and
+    // the textured wall is gated with the albedo divided out.
+    int denoiseTest(const Options &)
+    {
+        using namespace Atrous;
+        bool passed = true;
+
+        const uint32_t width = 96, height = 64;
+        const float fov = 0.8f;
+        const float aspect = float(width) / height;
+        const uint32_t frames = 8;
+        const float minAlpha = 0.1f;
+        TestCamera camera(float3(0.0f), fov, aspect);
+
+        struct Variant
+        {
+            const char *name;
+            FilterParams params;
+        };
+        FilterParams box;
+        box.phiNormal = 0.0f;
+        box.phiDepth = 1.0e+6f;
+        box.phiLuminance = 1.0e+6f;
+        FilterParams oneIteration;
+        oneIteration.iterations = 1;
+        FilterParams noFilter;
+        noFilter.iterations = 0;
+        const Variant variants[] = {
+            { "accumulated", noFilter },
+            { "no edges", box },
+            { "1 iteration", oneIteration },
+            { "5 iterations", FilterParams() },
+            { "albedo, IDs", FilterParams() },
+        };
+        const uint32_t variantCount = sizeof(variants) / sizeof(variants[0]);
+
+        struct Scene
+        {
+            const char *name;
+            float wallFrequency;
+        };
+        const Scene scenes[] = {
+            { "slowly lit wall", 0.25f },
+            { "textured wall", 1.5f },
+        };
+
+        printf("%ux%u pixels, %u frames of samples with 80%% noise\n", width, height, frames);
+        for (uint32_t s = 0; s < 2; ++s) {
+            // The wall is a diffuse texture under even light, its albedo is its radiance
+            Guides guides;
+            guides.normalDepth.resize(width * height);
+            guides.albedo.resize(width * height);
+            guides.instanceIds.resize(width * height);
+            std::vector<float> exact(width * height);
+            std::vector<uint8_t> panel(width * height);
+            for (uint32_t y = 0; y < height; ++y) {
+                for (uint32_t x = 0; x < width; ++x) {
+                    uint32_t pixel = y * width + x;
+                    float3 position;
+                    bool hitPanel;
+                    traceTestScene(camera.eye, camera.rayDirection(x, y, width, height), position, hitPanel);
+                    exact[pixel] = testSceneRadiance(position, hitPanel, scenes[s].wallFrequency);
+                    panel[pixel] = hitPanel;
+                    guides.normalDepth[pixel] = float4(quantizeAovNormal(float3(0.0f, 0.0f, 1.0f)), quantizeAovDepth(transform(float4(position, 1.0f), camera.viewProj).w));
+                    guides.albedo[pixel] = float3(hitPanel || s == 0 ? 1.0f : exact[pixel]);
+                    guides.instanceIds[pixel] = hitPanel ? 1 : 0;
+                }
+            }
+
+            // Pixels within two of the silhouette, where filtering across the depth edge shows
+            std::vector<uint8_t> edge(width * height);
+            for (int y = 0; y < int(height); ++y) {
+                for (int x = 0; x < int(width); ++x) {
+                    for (int dy = -2; dy <= 2; ++dy) {
+                        for (int dx = -2; dx <= 2; ++dx) {
+                            int tx = (std::min)((std::max)(x + dx, 0), int(width) - 1);
+                            int ty = (std::min)((std::max)(y + dy, 0), int(height) - 1);
+                            edge[y * width + x] |= panel[ty * width + tx] != panel[y * width + x];
+                        }
+                    }
+                }
+            }
+
+            // TemporalAccumulation.hlsl with the history at the same pixel, the variance from the luminance
+            // moments, spatial ones while the history is short
+            std::vector<float4> accumulated(width * height, float4(0.0f)), moments(width * height, float4(0.0f));
+            std::vector<float3> samples(width * height);
+            std::vector<float> variance(width * height);
+            uint32_t seed = RaytracingUtils::initRand(3, 5);
+            for (uint32_t frame = 0; frame < frames; ++frame) {
+                for (uint32_t pixel = 0; pixel < width * height; ++pixel) {
+                    samples[pixel] = float3(exact[pixel] * (1.0f + 1.6f * (RaytracingUtils::nextRand(seed) - 0.5f)));
+                }
+                for (int y = 0; y < int(height); ++y) {
+                    for (int x = 0; x < int(width); ++x) {
+                        uint32_t pixel = y * width + x;
+                        float4 spatialMoments(0.0f);
+                        for (int dy = -1; dy <= 1; ++dy) {
+                            for (int dx = -1; dx <= 1; ++dx) {
+                                int tx = (std::min)((std::max)(x + dx, 0), int(width) - 1);
+                                int ty = (std::min)((std::max)(y + dy, 0), int(height) - 1);
+                                float luminance = atrousLuminance(samples[ty * width + tx]);
+                                spatialMoments = spatialMoments + float4(luminance, luminance * luminance, 0.0f, 0.0f) / 9.0f;
+                            }
+                        }
+
+                        float historyLength = accumulated[pixel].w;
+                        float3 color;
+                        float length = TemporalAccumulation::blendHistory(color, accumulated[pixel].rgb(), samples[pixel], historyLength, minAlpha);
+                        float luminance = atrousLuminance(samples[pixel]);
+                        moments[pixel] = TemporalAccumulation::blendMoments(moments[pixel], float4(luminance, luminance * luminance, 0.0f, 0.0f), historyLength, minAlpha);
+                        accumulated[pixel] = float4(color, length);
+
+                        const float4 &varianceMoments = length < TEMPORAL_MIN_MOMENTS_LENGTH ? spatialMoments : moments[pixel];
+                        variance[pixel] = TemporalAccumulation::accumulatedVariance(varianceFromMoments(varianceMoments.x, varianceMoments.y), length);
+                    }
+                }
+            }
+
+            printf("\n%-16s %10s %10s %12s\n", scenes[s].name, "rel. RMSE", "edges", "variance");
+            double results[variantCount][2];
+            for (uint32_t v = 0; v < variantCount; ++v) {
+                std::vector<float4> signal(width * height);
+                for (uint32_t pixel = 0; pixel < width * height; ++pixel) {
+                    signal[pixel] = float4(accumulated[pixel].rgb(), variance[pixel]);
+                }
+                Guides variantGuides;
+                variantGuides.normalDepth = guides.normalDepth;
+                if (v == variantCount - 1) {
+                    variantGuides.albedo = guides.albedo;
+                    variantGuides.instanceIds = guides.instanceIds;
+                }
+                atrousFilter(signal, variantGuides, width, height, variants[v].params);
+
+                double squaredError = 0.0, edgeSquaredError = 0.0, varianceSum = 0.0;
+                uint32_t edgeCount = 0;
+                for (uint32_t pixel = 0; pixel < width * height; ++pixel) {
+                    double error = (signal[pixel].x - exact[pixel]) / exact[pixel];
+                    squaredError += error * error;
+                    varianceSum += signal[pixel].w;
+                    if (edge[pixel]) {
+                        edgeSquaredError += error * error;
+                        ++edgeCount;
+                    }
+                }
+                results[v][0] = std::sqrt(squaredError / (width * height));
+                results[v][1] = std::sqrt(edgeSquaredError / edgeCount);
+                printf("%-16s %10.4f %10.4f %12.2e\n", variants[v].name, results[v][0], results[v][1], varianceSum / (width * height));
+            }
+
+            // The filter cuts the noise left after accumulation, more with every iteration, and the edge
+            // stopping keeps the panel and the wall apart where a plain blur mixes them
+            if (s == 0) {
+                bool filterPassed = results[3][0] < 0.5 * results[0][0] && results[3][0] < results[2][0] && results[3][1] < 0.5 * results[1][1];
+                passed &= filterPassed;
+            }
+            // Divided by the albedo the textured wall is as smooth as the slowly lit one
+            if (s == 1) {
+                bool demodulationPassed = results[4][0] < 0.5 * results[0][0] && results[4][0] < 0.5 * results[3][0];
+                passed &= demodulationPassed;
+            }
+        }
+
+        printf("\n%s\n", passed ? "All denoise tests passed" : "Denoise tests FAILED");
+        return passed ? 0 : 1;
+    }
+}
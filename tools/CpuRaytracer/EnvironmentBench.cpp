@@ -0,0 +1,292 @@
+#include "CpuRaytracer.h"
+#include "EnvironmentSampling.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace DXRFramework;
+using namespace DXRFramework::CpuMath;
+
+namespace CpuRaytracer
+{
+    // Times the alias table builds of the bundled environments on one and on all threads, then compares
+    // the error of indirect diffuse with and without environment sampling for 1 to 256 samples per pixel.
+    // Also checks that the wavefront renderer weights the environment samples like the recursive shaders.
+    int environmentBench(const Options &options)
+    {
+        auto jobSystem = RtJobSystem::create(options.threads);
+        const char *environmentPaths[] = { "assets/textures/CathedralRadiance.dds", "assets/textures/HdrStudioProductNightStyx001_JPG_8K.jpg" };
+        CpuTexture::SharedPtr environments[2];
+        RtEnvironmentSampler::SharedPtr samplers[2];
+
+        char threads[32];
+        snprintf(threads, sizeof(threads), "%u threads ms", jobSystem->getThreadCount());
+        printf("%-44s %12s %12s %14s %14s\n", "environment", "texels", "table", "1 thread ms", threads);
+        for (int e = 0; e < 2; ++e) {
+            environments[e] = loadEnvironment(environmentPaths[e]);
+            const CpuTexture &environment = *environments[e];
+            double bestSeconds[2] = { 1e30, 1e30 };
+            for (int run = 0; run < 3; ++run) {
+                double seconds;
+                buildEnvironmentSampler(environment, nullptr, seconds);
+                bestSeconds[0] = (std::min)(bestSeconds[0], seconds);
+                samplers[e] = buildEnvironmentSampler(environment, jobSystem.get(), seconds);
+                bestSeconds[1] = (std::min)(bestSeconds[1], seconds);
+            }
+            char texels[32], table[32];
+            snprintf(texels, sizeof(texels), "%ux%u%s", environment.getWidth(), environment.getHeight(), environment.isCubemap() ? "x6" : "");
+            snprintf(table, sizeof(table), "%ux%u", samplers[e]->getWidth(), samplers[e]->getHeight());
+            printf("%-44s %12s %12s %14.2f %14.2f\n", environmentPaths[e], texels, table, bestSeconds[0] * 1000.0, bestSeconds[1] * 1000.0);
+        }
+
+        const uint32_t size = 128;
+        const uint32_t referenceSamples = 1024;
+        const uint32_t maxSamples = 256;
+        auto context = CpuContext::create(options.threads);
+        double buildSeconds;
+        auto scene = loadScene({ "assets/models/susanne.obj" }, false, buildSeconds);
+
+        bool passed = true;
+        printf("\n%u threads, %ux%u, indirect diffuse only, RMSE against a reference of 2 x %u samples\n", context->getThreadCount(), size, size, referenceSamples);
+        for (int e = 0; e < 2; ++e) {
+            auto createPipeline = [&](bool environmentSampling, uint32_t sequence) {
+                auto pipeline = std::make_shared<ProgressiveRaytracing>(context, scene, std::vector<MaterialParams>{ defaultMaterial() });
+                pipeline->resize(size, size);
+                pipeline->setCamera(frameScene(scene->getBounds()));
+                pipeline->setEnvironment(environments[e], samplers[e]);
+                pipeline->getOptions().environmentImportanceSampling = environmentSampling;
+                pipeline->getOptions().showIndirectDiffuseOnly = true;
+                pipeline->getOptions().sampleSequence = sequence;
+                return pipeline;
+            };
+
+            // Both strategies converge to the same image, the reference uses the one with less noise. Its
+            // halves are random samples, independent of each other and of the compared runs.
+            auto referencePipeline = createPipeline(true, SAMPLE_SEQUENCE_RANDOM);
+            CpuTexture::SharedPtr halves[2];
+            for (auto &half : halves) {
+                referencePipeline->resetAccumulation();
+                for (uint32_t i = 0; i < referenceSamples; ++i) {
+                    referencePipeline->render();
+                }
+                half = copyImage(*referencePipeline->getOutput());
+            }
+            auto reference = CpuTexture::create(size, size);
+            for (uint32_t y = 0; y < size; ++y) {
+                for (uint32_t x = 0; x < size; ++x) {
+                    reference->getData()[size_t(y) * size + x] = (halves[0]->load(x, y) + halves[1]->load(x, y)) * 0.5f;
+                }
+            }
+            double referenceNoise = meanSquaredError(*halves[0], *halves[1]) / 4.0;
+
+            std::vector<double> errors[2];
+            double seconds[2] = {};
+            for (int s = 0; s < 2; ++s) {
+                auto pipeline = createPipeline(s == 1, options.sampleSequence);
+                for (uint32_t i = 0; i < maxSamples; ++i) {
+                    pipeline->render();
+                    seconds[s] += context->getLastDispatchStats().seconds;
+                    errors[s].push_back(std::sqrt((std::max)(0.0, meanSquaredError(*pipeline->getOutput(), *reference) - referenceNoise)));
+                }
+            }
+
+            printf("%s, reference noise %.5f\n%8s %12s %12s %8s\n", environmentPaths[e], std::sqrt(referenceNoise), "spp", "BSDF only", "with MIS", "ratio");
+            for (uint32_t spp = 1; spp <= maxSamples; spp *= 2) {
+                printf("%8u %12.5f %12.5f %8.2f\n", spp, errors[0][spp - 1], errors[1][spp - 1], errors[0][spp - 1] / (std::max)(errors[1][spp - 1], 1e-12));
+            }
+            uint32_t samples = 0;
+            while (samples < maxSamples && errors[1][samples] > errors[0][maxSamples - 1]) {
+                ++samples;
+            }
+            printf("with MIS reaches the error of %u BSDF samples after %u samples, %.2f s against %.2f s for %u samples\n", maxSamples, samples + 1,
+                   seconds[1] / maxSamples * (samples + 1), seconds[0], maxSamples);
+
+            // Same samples through the wavefront renderer, the full shading this time
+            auto recursive = createPipeline(true, options.sampleSequence);
+            auto wavefront = createPipeline(true, options.sampleSequence);
+            recursive->getOptions().showIndirectDiffuseOnly = false;
+            wavefront->getOptions().showIndirectDiffuseOnly = false;
+            wavefront->setWavefront(true);
+            for (uint32_t i = 0; i < 4; ++i) {
+                recursive->render();
+                wavefront->render();
+            }
+            float maxDifference = 0.0f;
+            for (uint32_t y = 0; y < size; ++y) {
+                for (uint32_t x = 0; x < size; ++x) {
+                    float3 difference = abs(recursive->getOutput()->load(x, y).rgb() - wavefront->getOutput()->load(x, y).rgb());
+                    maxDifference = (std::max)(maxDifference, (std::max)(difference.x, (std::max)(difference.y, difference.z)));
+                }
+            }
+            bool matches = maxDifference < 1e-3f;
+            passed &= matches;
+            printf("wavefront against recursive, max difference %g%s\n\n", maxDifference, matches ? "" : "  FAILED");
+        }
+        return passed ? 0 : 1;
+    }
+
+    // Times the GGX prefilter of the cathedral cubemap and its SH projection with and without SSE, and
+    // compares the SH irradiance with the bundled CathedralIrradiance.dds. Then compares the error of
+    // rough reflections whose misses read the top mip with the one of misses that read the prefiltered
+    // mips, and checks that the wavefront renderer picks the same mips as the recursive shaders.
+    int prefilterBench(const Options &options)
+    {
+        auto jobSystem = RtJobSystem::create(options.threads);
+        uint32_t mipCount;
+        auto environment = loadEnvironment("assets/textures/CathedralRadiance.dds", &mipCount);
+        uint32_t faceSize = environment->getWidth();
+
+        RtEnvironmentPrefilter::SharedPtr prefilter;
+        double prefilterSeconds[2] = { 1e30, 1e30 };
+        for (int run = 0; run < 3; ++run) {
+            double seconds;
+            buildEnvironmentPrefilter(*environment, mipCount, nullptr, seconds);
+            prefilterSeconds[0] = (std::min)(prefilterSeconds[0], seconds);
+            prefilter = buildEnvironmentPrefilter(*environment, mipCount, jobSystem.get(), seconds);
+            prefilterSeconds[1] = (std::min)(prefilterSeconds[1], seconds);
+        }
+
+        // Scalar, SSE, and SSE over the faces in parallel
+        float3 coefficients[3][9];
+        double projectionSeconds[3] = { 1e30, 1e30, 1e30 };
+        for (int run = 0; run < 10; ++run) {
+            for (int variant = 0; variant < 3; ++variant) {
+                auto start = std::chrono::high_resolution_clock::now();
+                RtEnvironmentPrefilter::projectIrradiance(environment->getData(), faceSize, coefficients[variant], variant == 2 ? jobSystem.get() : nullptr, variant > 0);
+                projectionSeconds[variant] = (std::min)(projectionSeconds[variant], secondsSince(start));
+            }
+        }
+        float coefficientDifference = 0.0f;
+        for (uint32_t i = 0; i < 9; ++i) {
+            for (int variant = 1; variant < 3; ++variant) {
+                coefficientDifference = (std::max)(coefficientDifference, maxComponent(abs(coefficients[variant][i] - coefficients[0][i])));
+            }
+        }
+
+        printf("assets/textures/CathedralRadiance.dds, %ux%ux6, %u mips, %u GGX samples per texel\n", faceSize, faceSize, prefilter->getMipCount(), RtEnvironmentPrefilter::kSampleCount);
+        printf("%-36s %12s %14.2f\n", "GGX mips and SH, 1 thread", "ms", prefilterSeconds[0] * 1000.0);
+        printf("%-36s %12s %14.2f\n", ("GGX mips and SH, " + std::to_string(jobSystem->getThreadCount()) + " threads").c_str(), "ms", prefilterSeconds[1] * 1000.0);
+        printf("%-36s %12s %14.3f\n", "SH projection, scalar", "ms", projectionSeconds[0] * 1000.0);
+        printf("%-36s %12s %14.3f  %.2fx\n", "SH projection, SSE", "ms", projectionSeconds[1] * 1000.0, projectionSeconds[0] / projectionSeconds[1]);
+        printf("%-36s %12s %14.3f  %.2fx\n", ("SH projection, SSE, " + std::to_string(jobSystem->getThreadCount()) + " threads").c_str(), "ms",
+               projectionSeconds[2] * 1000.0, projectionSeconds[0] / projectionSeconds[2]);
+        bool passed = coefficientDifference < 1e-3f;
+        printf("SSE against scalar coefficients, max difference %g%s\n", coefficientDifference, passed ? "" : "  FAILED");
+
+        // The irradiance map holds irradiance divided by pi, the radiance of a white Lambertian surface,
+        // at an exposure of its own. Compared over a Fibonacci sphere of directions after fitting that.
+        auto irradianceMap = loadEnvironment("assets/textures/CathedralIrradiance.dds");
+        const uint32_t directionCount = 4096;
+        double mapDotSH = 0.0, shDotSH = 0.0, mapDotMap = 0.0;
+        std::vector<std::pair<float3, float3>> pairs;
+        for (uint32_t i = 0; i < directionCount; ++i) {
+            float y = 1.0f - 2.0f * (i + 0.5f) / directionCount;
+            float r = std::sqrt((std::max)(1.0f - y * y, 0.0f));
+            float phi = 2.39996323f * i;
+            float3 direction(r * std::cos(phi), y, r * std::sin(phi));
+            float3 sh = prefilter->evaluateIrradiance(direction) / 3.14159265f;
+            float3 map = irradianceMap->sampleCube(direction).rgb();
+            mapDotSH += dot(map, sh);
+            shDotSH += dot(sh, sh);
+            mapDotMap += dot(map, map);
+            pairs.push_back({ sh, map });
+        }
+        double scale = mapDotSH / shDotSH;
+        double fittedError = 0.0, unscaledError = 0.0;
+        for (auto &pair : pairs) {
+            float3 unscaled = pair.second - pair.first;
+            float3 fitted = pair.second - pair.first * float(scale);
+            unscaledError += dot(unscaled, unscaled);
+            fittedError += dot(fitted, fitted);
+        }
+        printf("SH irradiance / pi against CathedralIrradiance.dds: relative RMS error %.3f as is, %.3f at the map's exposure of %.3f\n\n",
+               std::sqrt(unscaledError / mapDotMap), std::sqrt(fittedError / mapDotMap), scale);
+
+        const uint32_t size = 128;
+        const uint32_t referenceSamples = 512;
+        const uint32_t maxSamples = 64;
+        auto context = CpuContext::create(options.threads);
+        double buildSeconds;
+        auto scene = loadScene({ "assets/models/susanne.obj" }, false, buildSeconds);
+
+        printf("%u threads, %ux%u, indirect specular only, RMSE against a top mip reference of 2 x %u samples\n", context->getThreadCount(), size, size, referenceSamples);
+        for (float roughness : { 0.5f, 0.8f, 1.0f }) {
+            auto createPipeline = [&](bool prefilteredMisses, uint32_t sequence) {
+                MaterialParams material = defaultMaterial();
+                material.roughness = roughness;
+                auto pipeline = std::make_shared<ProgressiveRaytracing>(context, scene, std::vector<MaterialParams>{ material });
+                pipeline->resize(size, size);
+                pipeline->setCamera(frameScene(scene->getBounds()));
+                pipeline->setEnvironment(environment, nullptr, prefilter);
+                pipeline->getOptions().prefilteredEnvironmentMisses = prefilteredMisses;
+                pipeline->getOptions().showIndirectSpecularOnly = true;
+                pipeline->getOptions().sampleSequence = sequence;
+                return pipeline;
+            };
+
+            auto referencePipeline = createPipeline(false, SAMPLE_SEQUENCE_RANDOM);
+            CpuTexture::SharedPtr halves[2];
+            for (auto &half : halves) {
+                referencePipeline->resetAccumulation();
+                for (uint32_t i = 0; i < referenceSamples; ++i) {
+                    referencePipeline->render();
+                }
+                half = copyImage(*referencePipeline->getOutput());
+            }
+            auto reference = CpuTexture::create(size, size);
+            for (uint32_t y = 0; y < size; ++y) {
+                for (uint32_t x = 0; x < size; ++x) {
+                    reference->getData()[size_t(y) * size + x] = (halves[0]->load(x, y) + halves[1]->load(x, y)) * 0.5f;
+                }
+            }
+            double referenceNoise = meanSquaredError(*halves[0], *halves[1]) / 4.0;
+
+            std::vector<double> errors[2];
+            double seconds[2] = {};
+            for (int s = 0; s < 2; ++s) {
+                auto pipeline = createPipeline(s == 1, options.sampleSequence);
+                for (uint32_t i = 0; i < maxSamples; ++i) {
+                    pipeline->render();
+                    seconds[s] += context->getLastDispatchStats().seconds;
+                    errors[s].push_back(std::sqrt((std::max)(0.0, meanSquaredError(*pipeline->getOutput(), *reference) - referenceNoise)));
+                }
+            }
+
+            float exponent = std::exp((1.0f - roughness) * 12.0f);
+            float lod = EnvironmentSampling::phongLobeEnvironmentRoughness(exponent) * (prefilter->getMipCount() - 1);
+            printf("roughness %.1f, misses read mip %.2f, reference noise %.5f\n%8s %12s %12s %8s\n", roughness, lod, std::sqrt(referenceNoise), "spp", "top mip", "prefiltered", "ratio");
+            for (uint32_t spp = 1; spp <= maxSamples; spp *= 2) {
+                printf("%8u %12.5f %12.5f %8.2f\n", spp, errors[0][spp - 1], errors[1][spp - 1], errors[0][spp - 1] / (std::max)(errors[1][spp - 1], 1e-12));
+            }
+            printf("%.2f ms per sample with top mip misses, %.2f ms prefiltered\n\n", seconds[0] / maxSamples * 1000.0, seconds[1] / maxSamples * 1000.0);
+        }
+
+        // Both renderers with the full shading, prefiltered misses also apply to secondary diffuse rays
+        auto createFullPipeline = [&] {
+            auto pipeline = std::make_shared<ProgressiveRaytracing>(context, scene, std::vector<MaterialParams>{ defaultMaterial() });
+            pipeline->resize(size, size);
+            pipeline->setCamera(frameScene(scene->getBounds()));
+            pipeline->setEnvironment(environment, nullptr, prefilter);
+            pipeline->getOptions().prefilteredEnvironmentMisses = true;
+            pipeline->getOptions().sampleSequence = options.sampleSequence;
+            return pipeline;
+        };
+        auto recursive = createFullPipeline();
+        auto wavefront = createFullPipeline();
+        wavefront->setWavefront(true);
+        for (uint32_t i = 0; i < 4; ++i) {
+            recursive->render();
+            wavefront->render();
+        }
+        float maxDifference = 0.0f;
+        for (uint32_t y = 0; y < size; ++y) {
+            for (uint32_t x = 0; x < size; ++x) {
+                maxDifference = (std::max)(maxDifference, maxComponent(abs(recursive->getOutput()->load(x, y).rgb() - wavefront->getOutput()->load(x, y).rgb())));
+            }
+        }
+        bool matches = maxDifference < 1e-3f;
+        passed &= matches;
+        printf("wavefront against recursive with prefiltered misses, max difference %g%s\n", maxDifference, matches ? "" : "  FAILED");
+        return passed ? 0 : 1;
+    }
+}
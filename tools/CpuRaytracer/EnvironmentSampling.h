@@ -0,0 +1,34 @@
+#pragma once
+
+// C++ port of the parts of assets/shaders/EnvironmentSampling.hlsli that RtEnvironmentSampler does not
+// already provide, and of the prefiltered environment lookups of RaytracingCommon.hlsli. Keep them in
+// sync so both backends weight and filter the environment alike.
+
+#include "Cpu/CpuMath.h"
+#include "RaytracingHlslCompat.h"
+#include <cmath>
+
+namespace EnvironmentSampling
+{
+    // Weight of a sample drawn with pdf against another strategy that could have drawn it with otherPdf
+    inline float powerHeuristic(float pdf, float otherPdf)
+    {
+        float pdf2 = pdf * pdf;
+        return pdf2 > 0.0f ? pdf2 / (pdf2 + otherPdf * otherPdf) : 0.0f;
+    }
+
+    inline float phongLobeEnvironmentRoughness(float exponent)
+    {
+        return std::sqrt(std::sqrt(2.0f / (4.0f * exponent + 2.0f)));
+    }
+
+    inline float environmentLod(const PerFrameConstants &constants, float lobeRoughness, uint32_t depth)
+    {
+        uint32_t mipCount = constants.environmentLighting.radianceMipCount;
+        if (!constants.options.prefilteredEnvironmentMisses || mipCount < 2) {
+            return 0.0f;
+        }
+        float roughness = (std::max)(lobeRoughness, (std::min)((std::max)(0.5f * (float(depth) - 1.0f), 0.0f), 1.0f));
+        return roughness * float(mipCount - 1);
+    }
+}
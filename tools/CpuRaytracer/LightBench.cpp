@@ -0,0 +1,184 @@
+#include "CpuRaytracer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using namespace DXRFramework;
+using namespace DXRFramework::CpuMath;
+
+namespace CpuRaytracer
+{
+    // Build time, depth and sampling cost of the light tree from 1 to 100k lights, against drawing from
+    // the importance of every light, with a check of the pdfs of all lights. Then direct lighting from
+    // many lights in the Cornell box with one light drawn uniformly or by the tree.
+    int lightBench(const Options &options)
+    {
+        auto jobSystem = RtJobSystem::create(options.threads);
+        double buildSeconds;
+        auto scene = loadScene({ "assets/models/cornell.obj" }, false, buildSeconds);
+        const CpuAabb &bounds = scene->getBounds();
+
+        // Shading points inside the box facing random directions
+        struct ShadingPoint
+        {
+            float3 position;
+            float3 normal;
+        };
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> dist;
+        std::vector<ShadingPoint> points(4096);
+        for (ShadingPoint &point : points) {
+            point.position = bounds.lower + bounds.extent() * float3(dist(rng), dist(rng), dist(rng));
+            float z = 1.0f - 2.0f * dist(rng);
+            float phi = 2.0f * 3.14159265f * dist(rng);
+            float r = std::sqrt((std::max)(1.0f - z * z, 0.0f));
+            point.normal = float3(r * std::cos(phi), r * std::sin(phi), z);
+        }
+
+        printf("assets/models/cornell.obj bounds, %zu shading points, %u threads\n", points.size(), jobSystem->getThreadCount());
+        printf("%8s %8s %6s %12s %12s %10s %14s %10s\n", "lights", "nodes", "depth", "build 1t ms", ("build " + std::to_string(jobSystem->getThreadCount()) + "t ms").c_str(),
+               "tree ns", "all lights ns", "no light");
+        bool passed = true;
+        for (uint32_t lightCount : { 1u, 10u, 100u, 1000u, 10000u, 100000u }) {
+            auto lights = scatterLights(bounds, lightCount);
+
+            double buildTimes[2] = { 1e30, 1e30 };
+            RtLightTree::SharedPtr tree;
+            for (int run = 0; run < 3; ++run) {
+                for (int threaded = 0; threaded < 2; ++threaded) {
+                    auto start = std::chrono::high_resolution_clock::now();
+                    tree = RtLightTree::build(lights, threaded ? jobSystem.get() : nullptr);
+                    buildTimes[threaded] = (std::min)(buildTimes[threaded], secondsSince(start));
+                }
+            }
+
+            // u is spread evenly over the points so every run draws the same lights
+            float pdfSum = 0.0f;
+            auto start = std::chrono::high_resolution_clock::now();
+            const uint32_t rounds = 16;
+            for (uint32_t round = 0; round < rounds; ++round) {
+                for (size_t i = 0; i < points.size(); ++i) {
+                    float pdf;
+                    tree->sample(points[i].position, points[i].normal, (float(i) + round / float(rounds)) / float(points.size()), pdf);
+                    pdfSum += pdf;
+                }
+            }
+            double treeNs = secondsSince(start) * 1e9 / (double(rounds) * points.size());
+
+            // The same importance for every light, drawn from their running sum, as many points as take
+            // about as long as the tree
+            const auto &leafLights = tree->getLights();
+            const auto &nodes = tree->getNodes();
+            std::vector<uint32_t> leaves;
+            for (uint32_t node = 0; node < nodes.size(); ++node) {
+                if (nodes[node].lightCount == 1) {
+                    leaves.push_back(node);
+                }
+            }
+            size_t linearPoints = (std::min)(points.size(), (std::max)(size_t(16), size_t(4000000) / lightCount));
+            std::vector<float> cdf(lightCount);
+            uint32_t drawn = 0;
+            start = std::chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < linearPoints; ++i) {
+                float sum = 0.0f;
+                for (uint32_t light = 0; light < lightCount; ++light) {
+                    sum += RtLightTree::importance(nodes[leaves[light]], points[i].position, points[i].normal);
+                    cdf[light] = sum;
+                }
+                float u = (float(i) + 0.5f) / float(linearPoints) * sum;
+                drawn += uint32_t(std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+            }
+            double linearNs = secondsSince(start) * 1e9 / double(linearPoints);
+
+            // The bounds of a node are looser than those of its children, so the pdfs of all lights add up
+            // to at most 1, the rest is the chance of drawing no light. Every light that reaches the
+            // point has to be drawn with its pdf for the estimate to be unbiased.
+            size_t checkPoints = lightCount > 10000 ? 4 : 32;
+            double missed = 0.0;
+            uint32_t errorCount = 0;
+            for (size_t i = 0; i < checkPoints; ++i) {
+                const ShadingPoint &point = points[i];
+                double sum = 0.0;
+                for (uint32_t light = 0; light < lightCount; ++light) {
+                    float pdf = tree->evaluatePdf(point.position, point.normal, light);
+                    errorCount += pdf <= 0.0f && RtLightTree::importance(nodes[leaves[light]], point.position, point.normal) > 0.0f ? 1 : 0;
+                    sum += pdf;
+                }
+                errorCount += sum > 1.0 + 1e-4 ? 1 : 0;
+                missed += (std::max)(1.0 - sum, 0.0);
+
+                float pdf;
+                uint32_t light = tree->sample(point.position, point.normal, 0.37f, pdf);
+                if (light != UINT32_MAX) {
+                    errorCount += std::fabs(pdf - tree->evaluatePdf(point.position, point.normal, light)) > 1e-4f * pdf ? 1 : 0;
+                }
+            }
+            passed &= errorCount == 0;
+
+            printf("%8u %8zu %6u %12.3f %12.3f %10.1f %14.1f %10.3f%s\n", lightCount, nodes.size(), tree->getDepth(), buildTimes[0] * 1000.0, buildTimes[1] * 1000.0,
+                   treeNs, linearNs, missed / checkPoints, errorCount == 0 ? "" : "  FAILED");
+            // Keeps the loops from being optimized away
+            if (pdfSum < 0.0f || drawn > lightCount * linearPoints || leafLights.size() != lightCount) {
+                printf("unreachable\n");
+            }
+        }
+
+        const uint32_t size = 96;
+        const uint32_t referenceSamples = 256;
+        const uint32_t maxSamples = 32;
+        auto context = CpuContext::create(options.threads);
+        printf("\n%u threads, %ux%u, direct lighting only, RMSE against a reference of 2 x %u samples of the light tree\n", context->getThreadCount(), size, size, referenceSamples);
+        printf("%8s %-12s %10s %12s %12s %12s\n", "lights", "selection", "ms/sample", "RMSE 4 spp", "RMSE 32 spp", "efficiency");
+        for (uint32_t lightCount : { 1000u, 100000u }) {
+            auto tree = RtLightTree::build(scatterLights(bounds, lightCount), jobSystem.get());
+            auto createPipeline = [&](uint32_t manyLightSampling, uint32_t sequence) {
+                auto pipeline = std::make_shared<ProgressiveRaytracing>(context, scene, std::vector<MaterialParams>{ defaultMaterial() });
+                pipeline->resize(size, size);
+                pipeline->setCamera(frameScene(bounds));
+                pipeline->setLights(tree);
+                pipeline->getOptions().manyLightSampling = manyLightSampling;
+                pipeline->getOptions().showDirectLightingOnly = true;
+                pipeline->getOptions().sampleSequence = sequence;
+                return pipeline;
+            };
+
+            auto referencePipeline = createPipeline(2, SAMPLE_SEQUENCE_RANDOM);
+            CpuTexture::SharedPtr halves[2];
+            for (auto &half : halves) {
+                referencePipeline->resetAccumulation();
+                for (uint32_t i = 0; i < referenceSamples; ++i) {
+                    referencePipeline->render();
+                }
+                half = copyImage(*referencePipeline->getOutput());
+            }
+            auto reference = CpuTexture::create(size, size);
+            for (uint32_t y = 0; y < size; ++y) {
+                for (uint32_t x = 0; x < size; ++x) {
+                    reference->getData()[size_t(y) * size + x] = (halves[0]->load(x, y) + halves[1]->load(x, y)) * 0.5f;
+                }
+            }
+            double referenceNoise = meanSquaredError(*halves[0], *halves[1]) / 4.0;
+
+            const char *names[] = { "uniform", "light tree" };
+            std::vector<double> errors[2];
+            double seconds[2] = {};
+            for (int s = 0; s < 2; ++s) {
+                auto pipeline = createPipeline(s + 1, options.sampleSequence);
+                for (uint32_t i = 0; i < maxSamples; ++i) {
+                    pipeline->render();
+                    seconds[s] += context->getLastDispatchStats().seconds;
+                    errors[s].push_back(std::sqrt((std::max)(0.0, meanSquaredError(*pipeline->getOutput(), *reference) - referenceNoise)));
+                }
+            }
+
+            // Efficiency is the inverse of squared error times time, relative to uniform selection
+            auto efficiency = [&](int s) { return 1.0 / (errors[s][maxSamples - 1] * errors[s][maxSamples - 1] * seconds[s]); };
+            for (int s = 0; s < 2; ++s) {
+                printf("%8u %-12s %10.2f %12.5f %12.5f %12.2f\n", lightCount, names[s], seconds[s] / maxSamples * 1000.0, errors[s][3], errors[s][maxSamples - 1],
+                       efficiency(s) / efficiency(0));
+            }
+        }
+        return passed ? 0 : 1;
+    }
+}
@@ -0,0 +1,181 @@
+#include "CpuRaytracer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace DXRFramework;
+using namespace DXRFramework::CpuMath;
+using namespace CpuRaytracer;
+
+namespace
+{
+    // One kind of ray for every pixel of an image, ordered by 4x4 pixel blocks with Morton order inside
+    // a block, so that any aligned run of 4, 8 or 16 rays covers a 2x2, 4x2 or 4x4 block
+    struct RayBatch
+    {
+        const char *name;
+        uint32_t flags;
+        std::vector<CpuRay> rays;
+        std::vector<uint8_t> valid; // pixels whose camera ray missed have no shadow or secondary ray
+    };
+
+    std::vector<RayBatch> createRayBatches(const CpuScene &scene, uint32_t size)
+    {
+        ProgressiveRaytracing::Camera camera = frameScene(scene.getBounds());
+        float3 forward = normalize(camera.target - camera.eye);
+        float3 right = normalize(cross(forward, camera.up));
+        float3 up = cross(right, forward);
+        float tanHalfFov = std::tan(0.5f * camera.fovY);
+        float3 lightDirection = normalize(float3(0.5f, 1.0f, 0.3f));
+        float epsilon = 1e-4f * length(scene.getBounds().extent());
+
+        std::vector<RayBatch> batches(3);
+        batches[0] = { "camera", CpuRayFlagCullBackFacingTriangles, {}, {} };
+        batches[1] = { "shadow", CpuRayFlagAcceptFirstHitAndEndSearch | CpuRayFlagSkipClosestHitShader, {}, {} };
+        batches[2] = { "diffuse", CpuRayFlagNone, {}, {} };
+        for (RayBatch &batch : batches) {
+            batch.rays.resize(size * size);
+            batch.valid.resize(size * size, 0);
+        }
+
+        uint32_t state = 1;
+        auto random = [&state]() { state = state * 1664525u + 1013904223u; return (state >> 8) * (1.0f / 16777216.0f); };
+        for (uint32_t i = 0; i < size * size; ++i) {
+            uint32_t block = i / 16, local = i % 16;
+            uint32_t x = (block % (size / 4)) * 4 + (local & 1) + ((local >> 1) & 2);
+            uint32_t y = (block / (size / 4)) * 4 + ((local >> 1) & 1) + ((local >> 2) & 2);
+            float u = (x + 0.5f) / size * 2.0f - 1.0f;
+            float v = 1.0f - (y + 0.5f) / size * 2.0f;
+
+            CpuRay &ray = batches[0].rays[i];
+            ray.origin = camera.eye;
+            ray.direction = normalize(forward + right * (u * tanHalfFov) + up * (v * tanHalfFov));
+            ray.tMin = 0.0f;
+            ray.tMax = 1e30f;
+            batches[0].valid[i] = 1;
+
+            CpuHit hit;
+            if (!scene.traceRay(ray, batches[0].flags, hit)) {
+                continue;
+            }
+            const CpuScene::Instance &instance = scene.getInstance(hit.instanceIndex);
+            const RtGeometry &geometry = *instance.model->getGeometry();
+            const float3 &v0 = geometry.vertices[geometry.indices[hit.primitiveIndex * 3 + 0]].position;
+            const float3 &v1 = geometry.vertices[geometry.indices[hit.primitiveIndex * 3 + 1]].position;
+            const float3 &v2 = geometry.vertices[geometry.indices[hit.primitiveIndex * 3 + 2]].position;
+            float3 normal = normalize(instance.objectToWorld.transformVector(cross(v1 - v0, v2 - v0)));
+            if (dot(normal, ray.direction) > 0.0f) {
+                normal = -normal;
+            }
+            float3 position = ray.origin + ray.direction * hit.t + normal * epsilon;
+
+            batches[1].rays[i] = { position, 0.0f, lightDirection, 1e30f };
+            batches[1].valid[i] = 1;
+
+            // Cosine distributed around the normal
+            float3 tangent = normalize(std::fabs(normal.x) > 0.5f ? cross(normal, float3(0.0f, 1.0f, 0.0f)) : cross(normal, float3(1.0f, 0.0f, 0.0f)));
+            float3 bitangent = cross(normal, tangent);
+            float r = std::sqrt(random()), phi = 2.0f * 3.14159265f * random();
+            float3 direction = tangent * (r * std::cos(phi)) + bitangent * (r * std::sin(phi)) + normal * std::sqrt((std::max)(0.0f, 1.0f - r * r));
+            batches[2].rays[i] = { position, 0.0f, direction, 1e30f };
+            batches[2].valid[i] = 1;
+        }
+        return batches;
+    }
+
+    // Traces a batch in packets of Size rays, Size 1 traces single rays. Returns the best of three runs
+    // and the number of hits.
+    template <uint32_t Size>
+    double tracePackets(const CpuScene &scene, const RayBatch &batch, uint32_t minActiveLanes, uint32_t &hitCount)
+    {
+        double bestSeconds = 1e30;
+        for (int run = 0; run < 3; ++run) {
+            auto start = std::chrono::high_resolution_clock::now();
+            hitCount = 0;
+            for (size_t first = 0; first < batch.rays.size(); first += Size) {
+                CpuRayPacket<Size> packet = {};
+                for (uint32_t lane = 0; lane < Size; ++lane) {
+                    if (batch.valid[first + lane]) {
+                        packet.setRay(lane, batch.rays[first + lane]);
+                        packet.activeMask |= 1u << lane;
+                    }
+                }
+                CpuHit hits[Size];
+                hitCount += countbits(scene.tracePacket(packet, batch.flags, hits, minActiveLanes));
+            }
+            bestSeconds = (std::min)(bestSeconds, secondsSince(start));
+        }
+        return bestSeconds;
+    }
+
+    double traceSingle(const CpuScene &scene, const RayBatch &batch, uint32_t &hitCount)
+    {
+        double bestSeconds = 1e30;
+        for (int run = 0; run < 3; ++run) {
+            auto start = std::chrono::high_resolution_clock::now();
+            hitCount = 0;
+            for (size_t i = 0; i < batch.rays.size(); ++i) {
+                CpuHit hit;
+                hitCount += batch.valid[i] && scene.traceRay(batch.rays[i], batch.flags, hit) ? 1 : 0;
+            }
+            bestSeconds = (std::min)(bestSeconds, secondsSince(start));
+        }
+        return bestSeconds;
+    }
+}
+
+namespace CpuRaytracer
+{
+    // Single thread Mrays/s of each ray type traced one at a time and in packets, for the binary and
+    // the 4-wide node layout
+    int packetBench(const Options &)
+    {
+        const uint32_t size = 512;
+        std::vector<std::pair<std::string, std::vector<RtGeometry::SharedPtr>>> meshes = {
+            { "susanne.obj", { RtGeometry::import("assets/models/susanne.obj") } },
+            { "cornell.obj", { RtGeometry::import("assets/models/cornell.obj") } },
+            { "synthetic 2M", { createSyntheticMesh(1024) } }
+        };
+        struct Layout { const char *name; CpuBvhLayout layout; };
+        const Layout layouts[] = { { "binary", CpuBvhLayout::Binary }, { "BVH4", CpuBvhLayout::Wide4 } };
+
+        printf("%ux%u rays per type, Mrays/s on one thread\n", size, size);
+        printf("%-14s %-8s %-8s %10s %10s %10s %10s %14s\n", "scene", "layout", "rays", "single", "packet 4", "packet 8", "packet 16", "16 always");
+        for (const auto &mesh : meshes) {
+            for (const Layout &layout : layouts) {
+                auto scene = CpuScene::create();
+                for (const auto &geometry : mesh.second) {
+                    auto model = CpuModel::create(geometry);
+                    model->build(CpuBvh::BuildOptions(), layout.layout);
+                    scene->addModel(model, float3x4::identity());
+                }
+                scene->build(ProgressiveRaytracing::getHitProgramCount());
+
+                for (const RayBatch &batch : createRayBatches(*scene, size)) {
+                    uint32_t rayCount = 0, singleHits = 0;
+                    for (uint8_t valid : batch.valid) {
+                        rayCount += valid;
+                    }
+                    double single = traceSingle(*scene, batch, singleHits);
+
+                    // The last column never falls back to single rays, however few lanes stay active
+                    uint32_t hits[4];
+                    double packet4 = tracePackets<4>(*scene, batch, CpuRayPacket<4>::kDefaultMinActiveLanes, hits[0]);
+                    double packet8 = tracePackets<8>(*scene, batch, CpuRayPacket<8>::kDefaultMinActiveLanes, hits[1]);
+                    double packet16 = tracePackets<16>(*scene, batch, CpuRayPacket<16>::kDefaultMinActiveLanes, hits[2]);
+                    double always16 = tracePackets<16>(*scene, batch, 0, hits[3]);
+                    for (uint32_t h : hits) {
+                        if (h != singleHits) {
+                            fprintf(stderr, "%s %s: %u packet hits, %u single ray hits\n", mesh.first.c_str(), batch.name, h, singleHits);
+                        }
+                    }
+
+                    double mrays = rayCount * 1e-6;
+                    printf("%-14s %-8s %-8s %10.2f %10.2f %10.2f %10.2f %14.2f\n", mesh.first.c_str(), layout.name, batch.name,
+                           mrays / single, mrays / packet4, mrays / packet8, mrays / packet16, mrays / always16);
+                }
+            }
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,118 @@
+#include "CpuRaytracer.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+using namespace DXRFramework;
+using namespace DXRFramework::CpuMath;
+
+namespace CpuRaytracer
+{
+    // Progressive passes on the tile scheduler: full pass throughput and tail latency for 1 to N
+    // threads, passes with a time budget and cancellation latency
+    int passBench(const Options &options)
+    {
+        const uint32_t size = 512;
+        const uint32_t samples = 8;
+        const double budget = 0.016;
+        uint32_t maxThreads = options.threads ? options.threads : (std::max)(1u, std::thread::hardware_concurrency());
+
+        double buildSeconds;
+        auto scene = loadScene({ "assets/models/susanne.obj" }, options.spatialSplits, buildSeconds);
+        auto camera = frameScene(scene->getBounds());
+        bool passed = true;
+
+        printf("%ux%u, %u samples per test\n", size, size, samples);
+        printf("%-8s %10s %8s %10s %10s %10s %10s\n", "threads", "Mrays/s", "speedup", "pass ms", "p95 ms", "max ms", "tail ms");
+        CpuTexture::SharedPtr reference;
+        double baseRate = 0.0;
+        for (uint32_t threads = 1;; threads = (std::min)(threads * 2, maxThreads)) {
+            auto context = CpuContext::create(threads);
+            ProgressiveRaytracing pipeline(context, scene, { defaultMaterial() });
+            pipeline.resize(size, size);
+            pipeline.setCamera(camera);
+
+            std::vector<double> passSeconds;
+            double tailSeconds = 0.0;
+            uint64_t rays = 0;
+            for (uint32_t i = 0; i < samples; ++i) {
+                pipeline.render();
+                const CpuContext::Stats &stats = context->getLastDispatchStats();
+                passSeconds.push_back(stats.seconds);
+                tailSeconds += stats.tailSeconds;
+                rays += stats.rays;
+            }
+            double seconds = 0.0;
+            for (double passSecond : passSeconds) {
+                seconds += passSecond;
+            }
+            double rate = rays / seconds;
+            baseRate = threads == 1 ? rate : baseRate;
+            printf("%-8u %10.2f %8.2f %10.1f %10.1f %10.1f %10.2f\n", threads, rate * 1e-6, rate / baseRate, seconds / samples * 1000.0,
+                   percentile(passSeconds, 0.95) * 1000.0, percentile(passSeconds, 1.0) * 1000.0, tailSeconds / samples * 1000.0);
+
+            // The image must not depend on the thread count
+            if (!reference) {
+                reference = CpuTexture::create(size, size);
+                memcpy(reference->getData(), pipeline.getOutput()->getData(), size_t(size) * size * sizeof(float4));
+            } else if (!imagesEqual(*reference, *pipeline.getOutput())) {
+                printf("  FAILED: image differs from the single thread one\n");
+                passed = false;
+            }
+            if (threads == maxThreads) {
+                break;
+            }
+        }
+
+        auto context = CpuContext::create(maxThreads);
+        ProgressiveRaytracing pipeline(context, scene, { defaultMaterial() });
+        pipeline.resize(size, size);
+        pipeline.setCamera(camera);
+
+        // Samples split over passes of a fixed budget accumulate to the same image
+        std::vector<double> passSeconds;
+        uint32_t passes = 0;
+        for (uint32_t completed = 0; completed < samples; ++passes) {
+            completed += pipeline.render(budget) ? 1 : 0;
+            passSeconds.push_back(context->getLastDispatchStats().seconds);
+        }
+        printf("%.0f ms budget on %u threads: %u passes for %u samples, pass p50 %.1f ms, p99 %.1f ms, max %.1f ms\n", budget * 1000.0, maxThreads,
+               passes, samples, percentile(passSeconds, 0.5) * 1000.0, percentile(passSeconds, 0.99) * 1000.0, percentile(passSeconds, 1.0) * 1000.0);
+        if (!imagesEqual(*reference, *pipeline.getOutput())) {
+            printf("  FAILED: budgeted passes differ from full passes\n");
+            passed = false;
+        }
+
+        // A second thread moves the camera some time into the pass, the pass polls for it per tile
+        std::vector<double> latencies;
+        for (uint32_t trial = 0; trial < 16; ++trial) {
+            ProgressiveRaytracing::Camera movedCamera = camera;
+            movedCamera.eye.x += 0.01f * (trial + 1);
+            std::atomic<bool> moved(false);
+            std::chrono::high_resolution_clock::time_point moveTime;
+            std::thread input([&] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2 + trial));
+                moveTime = std::chrono::high_resolution_clock::now();
+                moved = true;
+            });
+            pipeline.render(0.0, [&] { return moved.load(); });
+            auto returnTime = std::chrono::high_resolution_clock::now();
+            input.join();
+
+            const CpuContext::Stats &stats = context->getLastDispatchStats();
+            if (stats.cancelled) {
+                latencies.push_back(std::chrono::duration<double>(returnTime - moveTime).count());
+            }
+            pipeline.setCamera(movedCamera);
+        }
+        if (latencies.empty()) {
+            printf("cancellation: every pass finished before the camera moved\n");
+        } else {
+            printf("cancellation on %u threads: %zu of 16 passes cancelled, latency p50 %.2f ms, max %.2f ms\n", maxThreads, latencies.size(),
+                   percentile(latencies, 0.5) * 1000.0, percentile(latencies, 1.0) * 1000.0);
+        }
+
+        return passed ? 0 : 1;
+    }
+}
@@ -0,0 +1,701 @@
+#include "ProgressiveRaytracing.h"
+#include "RaytracingUtils.h"
+#include "AdaptiveSampling.h"
+#include "EnvironmentSampling.h"
+#include "Sampling.h"
+
+using namespace DXRFramework;
+using namespace RaytracingUtils;
+using namespace AdaptiveSampling;
+using namespace EnvironmentSampling;
+using namespace Sampling;
+
+static XMFLOAT4 pointLightColor = XMFLOAT4(0.2f, 0.8f, 0.6f, 2.0f);
+static XMFLOAT4 dirLightColor = XMFLOAT4(0.9f, 0.9f, 0.9f, 1.0f);
+
+// RaytracingCommon.hlsli
+namespace
+{
+    const float RAY_MAX_T = 1.0e+38f;
+    const float RAY_EPSILON = 0.0001f;
+
+    struct SimplePayload
+    {
+        float4 colorAndDistance;
+        UINT depth;
+        float lobeRoughness;
+        float throughput;
+        UINT pathLength;
+    };
+
+    const PerFrameConstants &perFrameConstants(const CpuShaderContext &context)
+    {
+        return context.getGlobalVars().getConstants<PerFrameConstants>();
+    }
+
+    const MaterialParams &materialParams(const CpuShaderContext &context)
+    {
+        return context.getLocalVars().getConstants<MaterialParams>();
+    }
+
+    float3 HitWorldPosition(const CpuShaderContext &context)
+    {
+        return context.worldRayOrigin() + context.rayTCurrent() * context.worldRayDirection();
+    }
+
+    void interpolateVertexAttributes(const CpuShaderContext &context, float2 bary, float3 &vertPosition, float3 &vertNormal)
+    {
+        float3 barycentrics(1.0f - bary.x - bary.y, bary.x, bary.y);
+
+        const RtGeometry &geometry = *context.getLocalVars().getResource<RtGeometry>(0);
+        uint32_t baseIndex = context.primitiveIndex() * 3;
+
+        vertPosition = float3(0.0f);
+        vertNormal = float3(0.0f);
+        for (int i = 0; i < 3; ++i) {
+            const RtGeometry::Vertex &vertex = geometry.vertices[geometry.indices[baseIndex + i]];
+            vertPosition += vertex.position * barycentrics[i];
+            vertNormal += vertex.normal * barycentrics[i];
+        }
+    }
+
+    float shootShadowRay(CpuShaderContext &context, float3 orig, float3 dir, float minT, float maxT, uint32_t currentDepth)
+    {
+        if (currentDepth >= MAX_SHADOW_RAY_DEPTH) {
+            return 1.0f;
+        }
+
+        CpuRay ray = { orig, minT, dir, maxT };
+
+        ShadowPayload payload = { 0.0f };
+
+        context.traceRay(CpuRayFlagAcceptFirstHitAndEndSearch | CpuRayFlagSkipClosestHitShader, 0xFF, 1, 0, 1, ray, payload);
+        return payload.lightVisibility;
+    }
+
+    float evaluateAO(CpuShaderContext &context, float3 position, float3 normal)
+    {
+        const PerFrameConstants &constants = perFrameConstants(context);
+        float visibility = 0.0f;
+        const int aoRayCount = 4;
+
+        uint2 pixIdx = context.dispatchRaysIndex();
+        uint2 numPix = context.dispatchRaysDimensions();
+        SampleGenerator sampleGenerator = initSampleGenerator(constants.options.sampleSequence, pixIdx, numPix, constants.cameraParams.frameCount,
+                                                              constants.cameraParams.accumCount, SAMPLE_DIMENSION_FIRST_BOUNCE);
+
+        for (int i = 0; i < aoRayCount; ++i) {
+            float3 sampleDir;
+            float NoL;
+            float pdf;
+            if (constants.options.cosineHemisphereSampling) {
+                sampleDir = getCosHemisphereSample(nextSample2D(sampleGenerator), normal);
+                NoL = saturate(dot(normal, sampleDir));
+                pdf = NoL / M_PI_F;
+            } else {
+                sampleDir = getUniformHemisphereSample(nextSample2D(sampleGenerator), normal);
+                NoL = saturate(dot(normal, sampleDir));
+                pdf = 1.0f / (2.0f * M_PI_F);
+            }
+            visibility += shootShadowRay(context, position, sampleDir, RAY_EPSILON, 10.0f, 1) * NoL / pdf;
+        }
+
+        return visibility / float(aoRayCount);
+    }
+
+    float3 evaluateDirectionalLight(CpuShaderContext &context, float3 position, float3 normal, uint32_t currentDepth)
+    {
+        const DirectionalLightParams &light = perFrameConstants(context).directionalLight;
+        float3 L = normalize(-float3(light.forwardDir));
+        float NoL = saturate(dot(normal, L));
+
+        float visible = shootShadowRay(context, position, L, RAY_EPSILON, RAY_MAX_T, currentDepth);
+
+        return float3(light.color) * light.color.w * NoL * visible;
+    }
+
+    float3 evaluatePointLight(CpuShaderContext &context, float3 position, float3 normal, uint32_t currentDepth)
+    {
+        const PointLightParams &light = perFrameConstants(context).pointLight;
+        float3 lightPath = float3(light.worldPos) - position;
+        float lightDistance = length(lightPath);
+        float3 L = normalize(lightPath);
+        float NoL = saturate(dot(normal, L));
+
+        float visible = shootShadowRay(context, position, L, RAY_EPSILON, lightDistance - RAY_EPSILON, currentDepth);
+
+        float falloff = 1.0f / (2.0f * M_PI_F * lightDistance * lightDistance);
+        return float3(light.color) * light.color.w * NoL * visible * falloff;
+    }
+
+    // gLightTreeNodes and gLightTreeLights are global resource 2, the tree itself
+    float3 evaluateManyLights(CpuShaderContext &context, float3 position, float3 normal, uint32_t currentDepth, float u)
+    {
+        const PerFrameConstants &constants = perFrameConstants(context);
+        const RtLightTree *lightTree = context.getGlobalVars().getResource<RtLightTree>(2);
+        uint32_t lightCount = constants.lightTree.lightCount;
+        uint32_t index;
+        float pdf;
+        if (constants.options.manyLightSampling == 2) {
+            index = lightTree->sample(position, normal, u, pdf);
+        } else {
+            index = (std::min)(uint32_t(u * float(lightCount)), lightCount - 1);
+            pdf = 1.0f / float(lightCount);
+        }
+        if (pdf <= 0.0f) {
+            return float3(0.0f);
+        }
+
+        const RtLightTree::Light &light = lightTree->getLights()[index];
+        float3 lightPath = light.position - position;
+        float lightDistance = length(lightPath);
+        float3 L = lightPath / lightDistance;
+        float NoL = saturate(dot(normal, L));
+        float emission = light.type == RtLightTree::CosineLight ? saturate(dot(light.direction, -L)) : 1.0f;
+        float3 intensity = light.intensity * emission;
+        // No shadow ray for lights facing away
+        if (NoL <= 0.0f || maxComponent(intensity) <= 0.0f) {
+            return float3(0.0f);
+        }
+
+        float visible = shootShadowRay(context, position, L, RAY_EPSILON, lightDistance - RAY_EPSILON, currentDepth);
+
+        float falloff = 1.0f / (2.0f * M_PI_F * lightDistance * lightDistance);
+        return intensity * (NoL * visible * falloff / pdf);
+    }
+
+    // The prefiltered mips stand in for the mip chain of the cubemap, CpuTexture has the top mip only
+    float3 evaluateEnvironment(const CpuShaderContext &context, const CpuTexture *environment, const RtEnvironmentPrefilter *prefilter,
+                               const float3 &direction, float lod)
+    {
+        float4 envSample(1.0f);
+        if (prefilter && lod > 0.0f) {
+            envSample = prefilter->sample(direction, lod);
+        } else if (environment && environment->isCubemap()) {
+            envSample = environment->sampleCube(direction);
+        } else if (environment) {
+            envSample = environment->sample(wsVectorToLatLong(direction));
+        }
+        return envSample.rgb() * perFrameConstants(context).options.environmentStrength;
+    }
+
+    float3 sampleEnvironment(const CpuShaderContext &context, float lod)
+    {
+        const CpuParams &missVars = context.getLocalVars();
+        return evaluateEnvironment(context, missVars.getResource<CpuTexture>(0), missVars.getResource<RtEnvironmentPrefilter>(1), context.worldRayDirection(), lod);
+    }
+}
+
+// ProgressiveRaytracing.hlsl
+namespace
+{
+    float russianRoulette(const CpuShaderContext &context, float throughput, uint32_t depth, SampleGenerator &sampleGenerator)
+    {
+        const DebugOptions &options = perFrameConstants(context).options;
+        if (!options.russianRoulette || depth < options.russianRouletteDepth) {
+            return 1.0f;
+        }
+        float survival = (std::min)((std::max)(throughput, 0.05f), 1.0f);
+        return throughput > 0.0f && nextSample1D(sampleGenerator) < survival ? 1.0f / survival : 0.0f;
+    }
+
+    float4 traceSecondaryRay(CpuShaderContext &context, float3 orig, float3 dir, float minT, uint32_t currentDepth, float lobeRoughness, float throughput,
+                             SampleGenerator &sampleGenerator, uint32_t &pathLength)
+    {
+        if (currentDepth >= perFrameConstants(context).options.maxBounces) {
+            return float4(0.0f);
+        }
+
+        float survivorWeight = russianRoulette(context, throughput, currentDepth + 1, sampleGenerator);
+        if (survivorWeight == 0.0f) {
+            return float4(0.0f);
+        }
+
+        CpuRay ray = { orig, minT, dir, RAY_MAX_T };
+
+        SimplePayload payload;
+        payload.colorAndDistance = float4(0.0f);
+        payload.depth = currentDepth + 1;
+        payload.lobeRoughness = lobeRoughness;
+        payload.throughput = throughput * survivorWeight;
+        payload.pathLength = 0;
+
+        context.traceRay(CpuRayFlagNone, 0xFF, 0, 0, 0, ray, payload);
+        pathLength = (std::max)(pathLength, payload.pathLength);
+        return float4(payload.colorAndDistance.rgb() * survivorWeight, payload.colorAndDistance.w);
+    }
+
+    float3 shootSecondaryRay(CpuShaderContext &context, float3 orig, float3 dir, float minT, uint32_t currentDepth, float lobeRoughness, float throughput,
+                             SampleGenerator &sampleGenerator, uint32_t &pathLength)
+    {
+        return traceSecondaryRay(context, orig, dir, minT, currentDepth, lobeRoughness, throughput, sampleGenerator, pathLength).rgb();
+    }
+
+    // gEnvironmentAliasTable and gEnvironmentCubemap are global resources 0 and 1
+    float3 evaluateIndirectDiffuse(CpuShaderContext &context, float3 position, float3 normal, SampleGenerator &sampleGenerator, uint32_t currentDepth,
+                                   float throughput, uint32_t &pathLength)
+    {
+        const PerFrameConstants &constants = perFrameConstants(context);
+        float3 color(0.0f);
+        const int rayCount = 1;
+
+        const RtEnvironmentSampler *environmentSampler = context.getGlobalVars().getResource<RtEnvironmentSampler>(0);
+        bool environmentSampling = constants.options.environmentImportanceSampling && environmentSampler && constants.environmentSampling.tableWidth > 0;
+
+        for (int i = 0; i < rayCount; ++i) {
+            float3 sampleDir;
+            float pdf;
+            float weight;
+            if (constants.options.cosineHemisphereSampling) {
+                sampleDir = getCosHemisphereSample(nextSample2D(sampleGenerator), normal);
+                pdf = saturate(dot(normal, sampleDir)) / M_PI_F;
+                weight = M_PI_F; // NoL / pdf, term canceled
+            } else {
+                sampleDir = getUniformHemisphereSample(nextSample2D(sampleGenerator), normal);
+                pdf = 1.0f / (2.0f * M_PI_F);
+                weight = saturate(dot(normal, sampleDir)) / pdf;
+            }
+
+            float4 radiance = traceSecondaryRay(context, position, sampleDir, RAY_EPSILON, currentDepth, 0.0f, throughput * weight, sampleGenerator, pathLength);
+            if (environmentSampling && radiance.w < 0.0f) {
+                weight *= powerHeuristic(pdf, environmentSampler->evaluatePdf(sampleDir));
+            }
+            color += radiance.rgb() * weight;
+
+            if (environmentSampling) {
+                float envPdf;
+                float3 envDir = environmentSampler->sample(nextSample2D(sampleGenerator), envPdf);
+                float NoL = dot(normal, envDir);
+                if (NoL > 0.0f && envPdf > 0.0f) {
+                    float bsdfPdf = constants.options.cosineHemisphereSampling ? NoL / M_PI_F : 1.0f / (2.0f * M_PI_F);
+                    float visible = shootShadowRay(context, position, envDir, RAY_EPSILON, RAY_MAX_T, currentDepth);
+                    const CpuTexture *environment = context.getGlobalVars().getResource<CpuTexture>(1);
+                    color += visible * evaluateEnvironment(context, environment, nullptr, envDir, 0.0f) * NoL / envPdf * powerHeuristic(envPdf, bsdfPdf);
+                }
+            }
+        }
+
+        return color / float(rayCount);
+    }
+
+    float3 shade(CpuShaderContext &context, float3 position, float3 normal, uint32_t currentDepth, float throughput, uint32_t &pathLength)
+    {
+        const PerFrameConstants &constants = perFrameConstants(context);
+        const MaterialParams &material = materialParams(context);
+
+        if (constants.options.showAmbientOcclusionOnly) {
+            return float3(evaluateAO(context, position, normal));
+        }
+
+        // Set up the sample sequence, every bounce draws its own dimensions
+        uint2 pixIdx = context.dispatchRaysIndex();
+        uint2 numPix = context.dispatchRaysDimensions();
+        SampleGenerator sampleGenerator = initSampleGenerator(constants.options.sampleSequence, pixIdx, numPix, constants.cameraParams.frameCount,
+                                                              constants.cameraParams.accumCount, SAMPLE_DIMENSION_FIRST_BOUNCE + currentDepth * SAMPLE_DIMENSIONS_PER_BOUNCE);
+
+        // Calculate direct diffuse lighting
+        float3 directContrib(0.0f);
+        if (constants.options.debug == 2) {
+            const int numLights = 2;
+            // Select light to evaluate in this iteration
+            if (nextSample1D(sampleGenerator) < 0.5f) {
+                directContrib += evaluateDirectionalLight(context, position, normal, currentDepth) * float(numLights);
+            } else {
+                directContrib += evaluatePointLight(context, position, normal, currentDepth) * float(numLights);
+            }
+        } else {
+            directContrib += evaluateDirectionalLight(context, position, normal, currentDepth);
+            directContrib += evaluatePointLight(context, position, normal, currentDepth);
+        }
+        if (constants.options.manyLightSampling && constants.lightTree.lightCount > 0) {
+            directContrib += evaluateManyLights(context, position, normal, currentDepth, nextSample1D(sampleGenerator));
+        }
+
+        // Calculate indirect diffuse
+        float3 indirectContrib(0.0f);
+        if (currentDepth < constants.options.maxBounces && !constants.options.noIndirectDiffuse) {
+            float diffuseThroughput = throughput * maxComponent(float3(material.albedo)) / M_PI_F;
+            indirectContrib += evaluateIndirectDiffuse(context, position, normal, sampleGenerator, currentDepth, diffuseThroughput, pathLength);
+        }
+
+        float3 diffuseComponent = (directContrib + indirectContrib) / M_PI_F;
+
+        // Accumulate indirect specular
+        float3 fresnel(0.0f);
+        float3 specularComponent(0.0f);
+        if (material.type == 1 || material.type == 2) {
+            if (material.reflectivity > 0.001f) {
+                float exponent = std::exp((1.0f - material.roughness) * 12.0f);
+                float pdf;
+                float brdf;
+                float3 mirrorDir = reflect(context.worldRayDirection(), normal);
+                float3 sampleDir = samplePhongLobe(nextSample2D(sampleGenerator), mirrorDir, exponent, pdf, brdf);
+
+                fresnel = FresnelReflectanceSchlick(context.worldRayDirection(), normal, float3(material.specular));
+
+                // The lobe sample for a random number of 0 underflows both terms to 0
+                float reflectionThroughput = pdf > 0.0f ? throughput * material.reflectivity * maxComponent(fresnel) * brdf / pdf : 0.0f;
+                float3 reflectionColor = shootSecondaryRay(context, position, sampleDir, RAY_EPSILON, currentDepth, phongLobeEnvironmentRoughness(exponent),
+                                                           reflectionThroughput, sampleGenerator, pathLength);
+                if (pdf > 0.0f) {
+                    specularComponent += reflectionColor * brdf / pdf;
+                }
+            }
+        }
+
+        float3 albedo(material.albedo);
+
+        // Debug visualization
+        if (currentDepth == 0) {
+            if (constants.options.showIndirectDiffuseOnly) {
+                return albedo * indirectContrib / M_PI_F;
+            } else if (constants.options.showIndirectSpecularOnly) {
+                return material.reflectivity * specularComponent * fresnel;
+            } else if (constants.options.showFresnelTerm) {
+                return fresnel;
+            } else if (constants.options.showGBufferAlbedoOnly) {
+                return albedo;
+            } else if (constants.options.showDirectLightingOnly) {
+                return albedo * directContrib / M_PI_F;
+            }
+        }
+
+        return float3(material.emissive) * material.emissive.w + albedo * diffuseComponent + material.reflectivity * specularComponent * fresnel;
+    }
+
+    // gOutput is a tile buffer here, the texture is resolved from it when it is read. Tiles that
+    // gTileActive marks as converged are skipped by the dispatch, see ProgressiveRaytracing::render.
+    void RayGen(CpuShaderContext &context, CpuTileBuffer &gOutput, CpuTileBuffer &gMoments, std::atomic<uint64_t> *gPathLengthHistogram)
+    {
+        const PerFrameConstants &constants = perFrameConstants(context);
+        if (constants.cameraParams.accumCount >= constants.options.maxIterations) {
+            return;
+        }
+
+        uint2 launchIndex = context.dispatchRaysIndex();
+        uint2 dims = context.dispatchRaysDimensions();
+        float2 d((launchIndex.x + 0.5f) / dims.x * 2.0f - 1.0f, (launchIndex.y + 0.5f) / dims.y * 2.0f - 1.0f);
+
+        SimplePayload payload;
+        payload.colorAndDistance = float4(0.0f);
+        payload.depth = 0;
+        payload.lobeRoughness = 0.0f;
+        payload.throughput = 1.0f;
+        payload.pathLength = 0;
+
+        float2 jitter = float2(constants.cameraParams.jitters.x, constants.cameraParams.jitters.y) * 30.0f;
+
+        CpuRay ray;
+        ray.origin = float3(constants.cameraParams.worldEyePos) + float3(jitter.x, jitter.y, 0.0f);
+        ray.direction = normalize(d.x * float3(constants.cameraParams.U) + (-d.y) * float3(constants.cameraParams.V) + float3(constants.cameraParams.W));
+        ray.tMin = 0.0f;
+        ray.tMax = RAY_MAX_T;
+
+        context.traceRay(CpuRayFlagCullBackFacingTriangles, 0xFF, 0, 0, 0, ray, payload);
+
+        // Pixels of skipped tiles have fewer samples than accumCount
+        float4 &moments = gMoments.at(launchIndex.x, launchIndex.y);
+        if (constants.cameraParams.accumCount == 0) {
+            moments = float4(0.0f);
+        }
+        float sampleCount = moments.z;
+
+        float4 &output = gOutput.at(launchIndex.x, launchIndex.y);
+        float4 curColor((max)(payload.colorAndDistance.rgb(), 0.0f), 1.0f);
+        output = (output * sampleCount + curColor) / (sampleCount + 1.0f);
+        moments = accumulateMoments(moments, curColor.rgb());
+
+        if (constants.options.pathLengthHistogram) {
+            gPathLengthHistogram[(std::min)(payload.pathLength, uint32_t(PATH_LENGTH_HISTOGRAM_SIZE - 1))].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void PrimaryClosestHit(CpuShaderContext &context, SimplePayload &payload, const CpuHit &attrib)
+    {
+        float3 vertPosition, vertNormal;
+        interpolateVertexAttributes(context, attrib.bary, vertPosition, vertNormal);
+
+        // Normals are stored in object space, rotate them like the vertices
+        float3 worldNormal = context.getInstance().objectToWorld.transformVector(vertNormal);
+
+        uint32_t pathLength = payload.depth + 1;
+        float3 color = shade(context, HitWorldPosition(context), normalize(worldNormal), payload.depth, payload.throughput, pathLength);
+        payload.colorAndDistance = float4(color, context.rayTCurrent());
+        payload.pathLength = pathLength;
+    }
+
+    void PrimaryMiss(CpuShaderContext &context, SimplePayload &payload)
+    {
+        float lod = environmentLod(perFrameConstants(context), payload.lobeRoughness, payload.depth);
+        payload.colorAndDistance = float4(sampleEnvironment(context, lod), -1.0f);
+        payload.pathLength = payload.depth;
+    }
+
+    void ShadowMiss(CpuShaderContext &, ShadowPayload &payload)
+    {
+        payload.lightVisibility = 1.0f;
+    }
+}
+
+ProgressiveRaytracing::ProgressiveRaytracing(CpuContext::SharedPtr context, CpuScene::SharedPtr scene, const std::vector<MaterialParams> &materials)
+    : mContext(context), mScene(scene), mMaterials(materials), mElapsedTime(142.0f), mAccumCount(0), mFrameCount(0), mNextTile(0), mActiveTileCount(0), mConverged(false), mRng(1234u)
+{
+    CpuProgram::Desc programDesc;
+    programDesc.setRayGen([this](CpuShaderContext &context) {
+        RayGen(context, *mAccumulation, *mMoments, mPathLengthCounts);
+    });
+    programDesc.addHitGroup(0, [](CpuShaderContext &context, void *payload, const CpuHit &hit) {
+        PrimaryClosestHit(context, *static_cast<SimplePayload*>(payload), hit);
+    });
+    programDesc.addMiss(0, [](CpuShaderContext &context, void *payload) {
+        PrimaryMiss(context, *static_cast<SimplePayload*>(payload));
+    });
+    // The shadow hit group has no closest hit shader, it is always skipped
+    programDesc.addHitGroup(1, nullptr);
+    programDesc.addMiss(1, [](CpuShaderContext &context, void *payload) {
+        ShadowMiss(context, *static_cast<ShadowPayload*>(payload));
+    });
+    mProgram = CpuProgram::create(programDesc);
+    mBindings = CpuBindings::create(mProgram, scene);
+
+    for (uint32_t rayType = 0; rayType < mProgram->getHitProgramCount(); ++rayType) {
+        for (uint32_t instance = 0; instance < scene->getNumInstances(); ++instance) {
+            auto &hitVars = mBindings->getHitVars(rayType, instance);
+            hitVars->appendResource(scene->getModel(instance)->getGeometry());
+            hitVars->append32BitConstants(&materials[instance % materials.size()], sizeof(MaterialParams) / 4);
+        }
+    }
+    setEnvironment(nullptr);
+
+    mOptions.maxIterations = 1024;
+    mOptions.cosineHemisphereSampling = true;
+    mOptions.showIndirectDiffuseOnly = false;
+    mOptions.showIndirectSpecularOnly = false;
+    mOptions.showAmbientOcclusionOnly = false;
+    mOptions.showGBufferAlbedoOnly = false;
+    mOptions.showDirectLightingOnly = false;
+    mOptions.showFresnelTerm = false;
+    mOptions.noIndirectDiffuse = false;
+    mOptions.environmentStrength = 1.0f;
+    mOptions.debug = 0;
+    mOptions.adaptiveSampling = false;
+    mOptions.adaptiveMinSamples = 16;
+    mOptions.adaptiveErrorThreshold = 0.01f;
+    mOptions.sampleSequence = SAMPLE_SEQUENCE_BLUE_NOISE_SOBOL;
+    mOptions.environmentImportanceSampling = true;
+    mOptions.prefilteredEnvironmentMisses = false;
+    mOptions.environmentIrradiance = 0;
+    mOptions.maxBounces = 1;
+    mOptions.russianRoulette = true;
+    mOptions.russianRouletteDepth = 2;
+    mOptions.pathLengthHistogram = false;
+    mOptions.manyLightSampling = 0;
+
+    mCamera.eye = float3(0.0f, 0.0f, 3.0f);
+    mCamera.target = float3(0.0f);
+    mCamera.up = float3(0.0f, 1.0f, 0.0f);
+    mCamera.fovY = 0.785398f;
+}
+
+void ProgressiveRaytracing::setEnvironment(CpuTexture::SharedPtr environment, RtEnvironmentSampler::SharedPtr sampler, RtEnvironmentPrefilter::SharedPtr prefilter)
+{
+    auto &missVars = mBindings->getMissVars(0);
+    missVars->clear();
+    missVars->appendResource(environment);
+    missVars->appendResource(prefilter);
+    mEnvironment = environment;
+    mEnvironmentSampler = sampler;
+    mEnvironmentPrefilter = prefilter;
+    resetAccumulation();
+}
+
+void ProgressiveRaytracing::setLights(RtLightTree::SharedPtr lightTree)
+{
+    mLightTree = lightTree;
+    resetAccumulation();
+}
+
+void ProgressiveRaytracing::setCamera(const Camera &camera)
+{
+    if (hasCameraMoved(camera)) {
+        mCamera = camera;
+        resetAccumulation();
+    }
+}
+
+void ProgressiveRaytracing::setWavefront(bool enabled)
+{
+    if (enabled && !mWavefront) {
+        mWavefront.reset(new WavefrontRaytracing(mContext, mScene, mMaterials));
+    } else if (!enabled) {
+        mWavefront.reset();
+    }
+}
+
+void ProgressiveRaytracing::resetAccumulation()
+{
+    mAccumCount = 0;
+    mNextTile = 0;
+    mConverged = false;
+    for (auto &count : mPathLengthCounts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::vector<uint64_t> ProgressiveRaytracing::getPathLengthHistogram() const
+{
+    std::vector<uint64_t> counts;
+    for (const auto &count : mPathLengthCounts) {
+        counts.push_back(count.load(std::memory_order_relaxed));
+    }
+    return counts;
+}
+
+bool ProgressiveRaytracing::hasCameraMoved(const Camera &camera) const
+{
+    auto equal = [](const float3 &a, const float3 &b) { return a.x == b.x && a.y == b.y && a.z == b.z; };
+    return !equal(camera.eye, mCamera.eye) || !equal(camera.target, mCamera.target) || !equal(camera.up, mCamera.up) || camera.fovY != mCamera.fovY;
+}
+
+void ProgressiveRaytracing::resize(uint32_t width, uint32_t height)
+{
+    mOutput = CpuTexture::create(width, height);
+    mAccumulation = CpuTileBuffer::create(width, height, CpuContext::kTileSize);
+    mMoments = CpuTileBuffer::create(width, height, CpuContext::kTileSize);
+    uint32_t tileCount = ((width + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE) * ((height + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE);
+    mTileMask.assign(tileCount, 1);
+    mTileErrors.assign(tileCount, 0.0f);
+    resetAccumulation();
+}
+
+CpuTexture::SharedPtr ProgressiveRaytracing::getOutput()
+{
+    mAccumulation->resolve(*mOutput);
+    return mOutput;
+}
+
+void ProgressiveRaytracing::updateConstants()
+{
+    PerFrameConstants constants;
+
+    // Same as calculateCameraVariables, the forward vector has unit length
+    CameraParams &cameraParams = constants.cameraParams;
+    float aspectRatio = float(mOutput->getWidth()) / float(mOutput->getHeight());
+    float3 w = normalize(mCamera.target - mCamera.eye);
+    float3 u = normalize(cross(w, mCamera.up));
+    float3 v = normalize(cross(u, w));
+    float vlen = std::tan(0.5f * mCamera.fovY);
+    u = u * (vlen * aspectRatio);
+    v = v * vlen;
+    cameraParams.worldEyePos = XMFLOAT4(mCamera.eye.x, mCamera.eye.y, mCamera.eye.z, 1.0f);
+    cameraParams.U = XMFLOAT4(u.x, u.y, u.z, 0.0f);
+    cameraParams.V = XMFLOAT4(v.x, v.y, v.z, 0.0f);
+    cameraParams.W = XMFLOAT4(w.x, w.y, w.z, 0.0f);
+    float xJitter, yJitter;
+    if (mOptions.sampleSequence == SAMPLE_SEQUENCE_RANDOM) {
+        xJitter = (mRngDist(mRng) - 0.5f) / float(mOutput->getWidth());
+        yJitter = (mRngDist(mRng) - 0.5f) / float(mOutput->getHeight());
+    } else {
+        // The camera dimensions of the sequence, shared by all pixels
+        xJitter = (sampleToUnitFloat(sobolOwen(mAccumCount, SAMPLE_DIMENSION_CAMERA, 0)) - 0.5f) / float(mOutput->getWidth());
+        yJitter = (sampleToUnitFloat(sobolOwen(mAccumCount, SAMPLE_DIMENSION_CAMERA + 1, 0)) - 0.5f) / float(mOutput->getHeight());
+    }
+    cameraParams.jitters = XMFLOAT2(xJitter, yJitter);
+    cameraParams.frameCount = mFrameCount++;
+    cameraParams.accumCount = mAccumCount++;
+
+    // XMMatrixRotationY applied to a row vector
+    float angle = std::sin(mElapsedTime * 0.2f) * 3.14f * 0.5f;
+    float3 dirLight(0.3f, -0.2f, -1.0f);
+    float3 rotated(dirLight.x * std::cos(angle) + dirLight.z * std::sin(angle), dirLight.y, -dirLight.x * std::sin(angle) + dirLight.z * std::cos(angle));
+    constants.directionalLight.forwardDir = XMFLOAT4(rotated.x, rotated.y, rotated.z, 0.0f);
+    constants.directionalLight.color = dirLightColor;
+
+    constants.pointLight.worldPos = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+    constants.pointLight.color = pointLightColor;
+
+    constants.environmentSampling.tableWidth = mEnvironmentSampler ? mEnvironmentSampler->getWidth() : 0;
+    constants.environmentSampling.tableHeight = mEnvironmentSampler ? mEnvironmentSampler->getHeight() : 0;
+    constants.environmentLighting = {};
+    if (mEnvironmentPrefilter) {
+        constants.environmentLighting.radianceMipCount = mEnvironmentPrefilter->getMipCount();
+        for (uint32_t i = 0; i < 9; ++i) {
+            float3 c = mEnvironmentPrefilter->getIrradianceCoefficients()[i];
+            constants.environmentLighting.irradianceSH[i] = XMFLOAT4(c.x, c.y, c.z, 0.0f);
+        }
+    }
+    constants.lightTree.lightCount = mLightTree ? uint32_t(mLightTree->getLights().size()) : 0;
+    constants.lightTree.nodeCount = mLightTree ? uint32_t(mLightTree->getNodes().size()) : 0;
+    constants.lightTree.padding = XMFLOAT2(0.0f, 0.0f);
+    constants.options = mOptions;
+
+    auto &globalVars = mBindings->getGlobalVars();
+    globalVars->clear();
+    globalVars->append32BitConstants(&constants, sizeof(PerFrameConstants) / 4);
+    globalVars->appendResource(mEnvironmentSampler);
+    globalVars->appendResource(mEnvironment);
+    globalVars->appendResource(mLightTree);
+}
+
+bool ProgressiveRaytracing::render(double timeBudget)
+{
+    return render(timeBudget, nullptr);
+}
+
+bool ProgressiveRaytracing::render(double timeBudget, const std::function<bool()> &cancel)
+{
+    // The constants of an unfinished sample are kept so its remaining tiles match the others
+    if (mNextTile == 0) {
+        if (mConverged) {
+            return true;
+        }
+        updateConstants();
+    }
+    const PerFrameConstants &constants = mBindings->getGlobalVars()->getConstants<PerFrameConstants>();
+
+    CpuContext::DispatchOptions options;
+    options.firstTile = mNextTile;
+    options.timeBudget = timeBudget;
+    options.cancel = cancel;
+    // The tile states are used once every pixel has enough samples for its error estimate
+    if (constants.options.adaptiveSampling && constants.cameraParams.accumCount >= constants.options.adaptiveMinSamples) {
+        options.tileMask = mTileMask;
+    }
+
+    bool complete;
+
+    if (mWavefront && WavefrontRaytracing::supports(mOptions)) {
+        uint32_t tilesX = (mOutput->getWidth() + CpuContext::kTileSize - 1) / CpuContext::kTileSize;
+        uint32_t tilesY = (mOutput->getHeight() + CpuContext::kTileSize - 1) / CpuContext::kTileSize;
+        uint32_t nextTile = mWavefront->render(constants, mEnvironment.get(), mEnvironmentSampler.get(), mEnvironmentPrefilter.get(), *mAccumulation, *mMoments, options);
+        complete = nextTile == tilesX * tilesY;
+        mNextTile = complete ? 0 : nextTile;
+    } else {
+        complete = mContext->raytrace(mBindings, mOutput->getWidth(), mOutput->getHeight(), 1, options);
+        mNextTile = complete ? 0 : mContext->getLastDispatchStats().nextTile;
+    }
+
+    if (complete && constants.options.adaptiveSampling && constants.cameraParams.accumCount < constants.options.maxIterations) {
+        updateTileStates(constants);
+    }
+    return complete;
+}
+
+// AdaptiveSampling.hlsl, run after every complete sample like the compute pass after every frame
+void ProgressiveRaytracing::updateTileStates(const PerFrameConstants &constants)
+{
+    uint32_t tilesX = (mOutput->getWidth() + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE;
+    mContext->parallelFor(static_cast<uint32_t>(mTileMask.size()), 16, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t tile = begin; tile < end; ++tile) {
+            mTileErrors[tile] = estimateTileError(*mMoments, tile % tilesX, tile / tilesX);
+            mTileMask[tile] = mTileErrors[tile] > constants.options.adaptiveErrorThreshold ? 1 : 0;
+        }
+    });
+
+    mActiveTileCount = 0;
+    for (uint8_t active : mTileMask) {
+        mActiveTileCount += active;
+    }
+    // The states of this sample are used from the next one on, if that has adaptiveMinSamples samples
+    mConverged = constants.cameraParams.accumCount + 1 >= constants.options.adaptiveMinSamples && mActiveTileCount == 0;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Cpu/CpuContext.h"
+#include "Cpu/CpuTexture.h"
+#include "RaytracingHlslCompat.h"
+#include "RtEnvironmentPrefilter.h"
+#include "RtEnvironmentSampler.h"
+#include "RtLightTree.h"
+#include "WavefrontRaytracing.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <random>
+
+// CPU port of ProgressiveRaytracingPipeline and ProgressiveRaytracing.hlsl. The shaders run on the
+// CPU backend with the same constants, bindings and random sequences as the GPU version, so the
+// accumulated images converge to the same result.
+class ProgressiveRaytracing
+{
+public:
+    struct Camera
+    {
+        DXRFramework::CpuMath::float3 eye;
+        DXRFramework::CpuMath::float3 target;
+        DXRFramework::CpuMath::float3 up;
+        float fovY; // radians
+    };
+
+    // The scene has to be built with getHitProgramCount() hit groups. materials holds one entry per instance.
+    ProgressiveRaytracing(DXRFramework::CpuContext::SharedPtr context, DXRFramework::CpuScene::SharedPtr scene, const std::vector<MaterialParams> &materials);
+
+    static uint32_t getHitProgramCount() { return 2; }
+
+    // A cubemap, or a lat-long 2D map. Without one the environment is uniformly white. With a sampler
+    // built from the same texture, indirect diffuse also samples the environment by its radiance. A
+    // prefilter of a cubemap stands in for its mip chain, for DebugOptions::prefilteredEnvironmentMisses.
+    void setEnvironment(DXRFramework::CpuTexture::SharedPtr environment, DXRFramework::RtEnvironmentSampler::SharedPtr sampler = nullptr,
+                        DXRFramework::RtEnvironmentPrefilter::SharedPtr prefilter = nullptr);
+    // Lights sampled one per shading point with DebugOptions::manyLightSampling, on top of the
+    // directional and point light. Null for none.
+    void setLights(DXRFramework::RtLightTree::SharedPtr lightTree);
+    // Restarts accumulation when the camera differs from the current one, like the GPU pipeline
+    void setCamera(const Camera &camera);
+    bool hasCameraMoved(const Camera &camera) const;
+    void setElapsedTime(float elapsedTime) { mElapsedTime = elapsedTime; resetAccumulation(); }
+    DebugOptions &getOptions() { return mOptions; }
+
+    void resize(uint32_t width, uint32_t height);
+
+    // Traces one sample per pixel and blends it into the output, like one frame of the GPU pipeline.
+    // A pass with a time budget may stop before every tile has its sample, the next pass then
+    // finishes the sample before starting a new one. Returns true when the sample is complete.
+    bool render(double timeBudget = 0.0);
+
+    // Same with a cancel function polled before every tile, e.g. checking whether the camera moved
+    // on the thread that handles input. A cancelled pass is resumed like one that ran out of time,
+    // unless setCamera restarts accumulation first.
+    bool render(double timeBudget, const std::function<bool()> &cancel);
+
+    void resetAccumulation();
+
+    // With DebugOptions::adaptiveSampling, tiles whose error estimate is below the threshold are
+    // skipped from adaptiveMinSamples samples on. Once every tile has converged render() traces nothing.
+    bool isConverged() const { return mConverged; }
+    uint32_t getActiveTileCount() const { return mActiveTileCount; }
+    // Error estimate of every tile after the last complete sample, numbered y * tilesX + x
+    const std::vector<float> &getTileErrors() const { return mTileErrors; }
+
+    // With DebugOptions::pathLengthHistogram, the samples since accumulation restarted counted by the
+    // surface hits along the longest branch of their path, PATH_LENGTH_HISTOGRAM_SIZE entries
+    std::vector<uint64_t> getPathLengthHistogram() const;
+
+    // Renders with WavefrontRaytracing instead of the recursive shaders, except for the debug views it
+    // does not support. Both produce the same samples, the accumulation carries over when switching.
+    void setWavefront(bool enabled);
+    // The wavefront renderer, null unless enabled
+    const WavefrontRaytracing *getWavefront() const { return mWavefront.get(); }
+
+    // Resolves the tiles accumulated so far into the output texture
+    DXRFramework::CpuTexture::SharedPtr getOutput();
+    uint32_t getAccumCount() const { return mAccumCount; }
+
+private:
+    void updateConstants();
+    void updateTileStates(const PerFrameConstants &constants);
+
+    DXRFramework::CpuContext::SharedPtr mContext;
+    DXRFramework::CpuScene::SharedPtr mScene;
+    DXRFramework::CpuProgram::SharedPtr mProgram;
+    DXRFramework::CpuBindings::SharedPtr mBindings;
+    DXRFramework::CpuTexture::SharedPtr mOutput;
+    // Samples are blended tile by tile, a tile is written by one thread at a time
+    DXRFramework::CpuTileBuffer::SharedPtr mAccumulation;
+    // Luminance moments per pixel, see AdaptiveSampling.h
+    DXRFramework::CpuTileBuffer::SharedPtr mMoments;
+    DXRFramework::CpuTexture::SharedPtr mEnvironment;
+    DXRFramework::RtEnvironmentSampler::SharedPtr mEnvironmentSampler;
+    DXRFramework::RtEnvironmentPrefilter::SharedPtr mEnvironmentPrefilter;
+    DXRFramework::RtLightTree::SharedPtr mLightTree;
+    std::vector<MaterialParams> mMaterials;
+    std::unique_ptr<WavefrontRaytracing> mWavefront;
+
+    Camera mCamera;
+    DebugOptions mOptions;
+    float mElapsedTime;
+    uint32_t mAccumCount;
+    uint32_t mFrameCount;
+    uint32_t mNextTile;
+
+    std::vector<uint8_t> mTileMask;
+    std::vector<float> mTileErrors;
+    uint32_t mActiveTileCount;
+    bool mConverged;
+    // Counted by every thread that runs the ray generation shader, like InterlockedAdd on the GPU
+    std::atomic<uint64_t> mPathLengthCounts[PATH_LENGTH_HISTOGRAM_SIZE];
+
+    std::mt19937 mRng;
+    std::uniform_real_distribution<float> mRngDist;
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+// C++ port of assets/shaders/RaytracingUtils.hlsli. Keep the two in sync so the CPU backend
+// produces the same sample sequences as the GPU shaders.
+
+#include "Cpu/CpuMath.h"
+
+namespace RaytracingUtils
+{
+    using namespace DXRFramework::CpuMath;
+
+    const float M_PI_F = 3.1415927f;
+    const float M_1_PI_F = 1.0f / M_PI_F;
+
+    // Generates a seed for a random number generator from 2 inputs plus a backoff
+    inline uint32_t initRand(uint32_t val0, uint32_t val1, uint32_t backoff = 16)
+    {
+        uint32_t v0 = val0, v1 = val1, s0 = 0;
+        for (uint32_t n = 0; n < backoff; n++) {
+            s0 += 0x9e3779b9;
+            v0 += ((v1 << 4) + 0xa341316c) ^ (v1 + s0) ^ ((v1 >> 5) + 0xc8013ea4);
+            v1 += ((v0 << 4) + 0xad90777d) ^ (v0 + s0) ^ ((v0 >> 5) + 0x7e95761e);
+        }
+        return v0;
+    }
+
+    // Takes our seed, updates it, and returns a pseudorandom float in [0..1]
+    inline float nextRand(uint32_t &s)
+    {
+        s = (1664525u * s + 1013904223u);
+        return float(s & 0x00FFFFFF) / float(0x01000000);
+    }
+
+    inline float3 getPerpendicularVector(const float3 &u)
+    {
+        float3 a = abs(u);
+        uint32_t xm = ((a.x - a.y) < 0 && (a.x - a.z) < 0) ? 1 : 0;
+        uint32_t ym = (a.y - a.z) < 0 ? (1 ^ xm) : 0;
+        uint32_t zm = 1 ^ (xm | ym);
+        return cross(u, float3(float(xm), float(ym), float(zm)));
+    }
+
+    inline float3 getCosHemisphereSample(const float2 &randVal, const float3 &hitNorm)
+    {
+        float3 bitangent = getPerpendicularVector(hitNorm);
+        float3 tangent = cross(bitangent, hitNorm);
+
+        float r = std::sqrt(randVal.x);
+        float phi = 2.0f * 3.14159265f * randVal.y;
+
+        float x = r * std::cos(phi);
+        float z = r * std::sin(phi);
+        float y = std::sqrt(1.0f - randVal.x);
+        return x * tangent + y * hitNorm + z * bitangent;
+    }
+
+    inline float3 getUniformHemisphereSample(const float2 &randVal, const float3 &hitNorm)
+    {
+        float3 bitangent = getPerpendicularVector(hitNorm);
+        float3 tangent = cross(bitangent, hitNorm);
+
+        float cosTheta = randVal.x;
+        float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+        float phi = 2.0f * 3.14159265f * randVal.y;
+
+        float x = sinTheta * std::cos(phi);
+        float z = sinTheta * std::sin(phi);
+        float y = cosTheta;
+        return x * tangent + y * hitNorm + z * bitangent;
+    }
+
+    inline float3 samplePhongLobe(const float2 &randVal, const float3 &mirrorDir, float exponent, float &pdf, float &brdf)
+    {
+        const float pi = 3.14159265f;
+
+        float3 bitangent = getPerpendicularVector(mirrorDir);
+        float3 tangent = cross(bitangent, mirrorDir);
+
+        float cosTheta = std::pow(randVal.x, 1.0f / (exponent + 1.0f));
+        float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+        float phi = 2.0f * pi * randVal.y;
+
+        float poweredCos = std::pow(cosTheta, exponent);
+        pdf = (exponent + 1.0f) / (2.0f * pi) * poweredCos;
+        brdf = (exponent + 2.0f) / (2.0f * pi) * poweredCos;
+
+        float x = sinTheta * std::cos(phi);
+        float z = sinTheta * std::sin(phi);
+        float y = cosTheta;
+        return x * tangent + y * mirrorDir + z * bitangent;
+    }
+
+    inline float3 FresnelReflectanceSchlick(const float3 &I, const float3 &N, const float3 &f0)
+    {
+        float cosi = saturate(dot(-I, N));
+        return f0 + (float3(1.0f) - f0) * std::pow(1.0f - cosi, 5.0f);
+    }
+
+    inline float2 wsVectorToLatLong(const float3 &dir)
+    {
+        float3 p = normalize(dir);
+        float u = (1.0f + std::atan2(p.x, -p.z) * M_1_PI_F) * 0.5f;
+        float v = std::acos(p.y) * M_1_PI_F;
+        return float2(u, v);
+    }
+}
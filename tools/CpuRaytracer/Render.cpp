@@ -0,0 +1,123 @@
+#include "CpuRaytracer.h"
+#include <cstdio>
+
+using namespace DXRFramework;
+using namespace DXRFramework::CpuMath;
+
+namespace CpuRaytracer
+{
+    int render(const Options &options)
+    {
+        double buildSeconds;
+        auto scene = loadScene(options.models, options.spatialSplits, buildSeconds);
+        uint32_t triangles = 0;
+        for (uint32_t i = 0; i < scene->getNumInstances(); ++i) {
+            triangles += scene->getModel(i)->getTriangleCount();
+        }
+        printf("%u triangles, BVH built in %.1f ms\n", triangles, buildSeconds * 1000.0);
+
+        auto context = CpuContext::create(options.threads);
+        ProgressiveRaytracing pipeline(context, scene, { defaultMaterial() });
+        pipeline.resize(options.width, options.height);
+        pipeline.setCamera(frameScene(scene->getBounds()));
+        pipeline.getOptions().showAmbientOcclusionOnly = options.ambientOcclusion;
+        pipeline.getOptions().adaptiveSampling = options.adaptive;
+        pipeline.getOptions().adaptiveErrorThreshold = options.adaptiveThreshold;
+        pipeline.getOptions().sampleSequence = options.sampleSequence;
+        pipeline.getOptions().maxBounces = options.maxBounces;
+        pipeline.getOptions().russianRoulette = options.russianRouletteDepth > 0;
+        pipeline.getOptions().russianRouletteDepth = options.russianRouletteDepth;
+        pipeline.getOptions().pathLengthHistogram = options.pathLengths;
+        pipeline.setWavefront(options.wavefront);
+        if (options.lightCount > 0) {
+            auto jobSystem = RtJobSystem::create(options.threads);
+            auto start = std::chrono::high_resolution_clock::now();
+            auto lightTree = RtLightTree::build(scatterLights(scene->getBounds(), options.lightCount), jobSystem.get());
+            printf("Light tree over %u lights built in %.1f ms, depth %u\n", options.lightCount, secondsSince(start) * 1000.0, lightTree->getDepth());
+            pipeline.setLights(lightTree);
+            pipeline.getOptions().manyLightSampling = options.uniformLights ? 1 : 2;
+        }
+        if (!options.environment.empty()) {
+            uint32_t mipCount;
+            auto environment = loadEnvironment(options.environment, &mipCount);
+            auto jobSystem = RtJobSystem::create(options.threads);
+            RtEnvironmentSampler::SharedPtr sampler;
+            if (options.environmentSampling) {
+                double samplerSeconds;
+                sampler = buildEnvironmentSampler(*environment, jobSystem.get(), samplerSeconds);
+                if (sampler) {
+                    printf("Environment alias table %ux%u built in %.1f ms\n", sampler->getWidth(), sampler->getHeight(), samplerSeconds * 1000.0);
+                }
+            }
+            RtEnvironmentPrefilter::SharedPtr prefilter;
+            if (options.prefilteredMisses) {
+                double prefilterSeconds;
+                prefilter = buildEnvironmentPrefilter(*environment, mipCount, jobSystem.get(), prefilterSeconds);
+                if (prefilter) {
+                    printf("Environment prefiltered into %u mips in %.1f ms\n", prefilter->getMipCount(), prefilterSeconds * 1000.0);
+                }
+                pipeline.getOptions().prefilteredEnvironmentMisses = true;
+            }
+            pipeline.setEnvironment(environment, sampler, prefilter);
+        }
+
+        uint64_t rays = 0;
+        double seconds = 0.0;
+        uint32_t samples = 0;
+        for (; samples < options.samplesPerPixel; ++samples) {
+            if (pipeline.isConverged()) {
+                printf("Converged after %u samples\n", samples);
+                break;
+            }
+            pipeline.render();
+            if (options.wavefront && WavefrontRaytracing::supports(pipeline.getOptions())) {
+                rays += pipeline.getWavefront()->getLastStats().rays;
+                seconds += pipeline.getWavefront()->getLastStats().getSeconds();
+            } else {
+                rays += context->getLastDispatchStats().rays;
+                seconds += context->getLastDispatchStats().seconds;
+            }
+        }
+        printf("%u spp at %ux%u on %u threads: %.2f s, %.2f Mrays/s\n", samples, options.width, options.height,
+               context->getThreadCount(), seconds, rays / seconds * 1e-6);
+        if (options.pathLengths) {
+            printPathLengthHistogram(pipeline.getPathLengthHistogram());
+        }
+
+        writeImage(*pipeline.getOutput(), options.output);
+        printf("Wrote %s\n", options.output.c_str());
+        return 0;
+    }
+
+    // Rays/sec of the full progressive shading workload (camera, shadow, indirect and reflection rays)
+    int bench(const Options &options)
+    {
+        const char *models[] = { "assets/models/susanne.obj", "assets/models/cornell.obj", "assets/models/ground.fbx" };
+        const uint32_t size = 256;
+        const uint32_t passes = 8;
+
+        auto context = CpuContext::create(options.threads);
+        printf("%u threads, %ux%u, %u passes\n", context->getThreadCount(), size, size, passes);
+        printf("%-28s %10s %10s %10s %10s %10s\n", "model", "triangles", "build ms", "rays", "seconds", "Mrays/s");
+
+        for (const char *model : models) {
+            double buildSeconds;
+            auto scene = loadScene({ model }, options.spatialSplits, buildSeconds);
+
+            ProgressiveRaytracing pipeline(context, scene, { defaultMaterial() });
+            pipeline.resize(size, size);
+            pipeline.setCamera(frameScene(scene->getBounds()));
+
+            uint64_t rays = 0;
+            double seconds = 0.0;
+            for (uint32_t i = 0; i < passes; ++i) {
+                pipeline.render();
+                rays += context->getLastDispatchStats().rays;
+                seconds += context->getLastDispatchStats().seconds;
+            }
+            printf("%-28s %10u %10.1f %10llu %10.3f %10.2f\n", model, scene->getModel(0)->getTriangleCount(), buildSeconds * 1000.0,
+                   static_cast<unsigned long long>(rays), seconds, rays / seconds * 1e-6);
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,266 @@
+#include "CpuRaytracer.h"
+#include "RaytracingUtils.h"
+#include "ReservoirHlslCompat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace DXRFramework;
+using namespace DXRFramework::CpuMath;
+using namespace CpuRaytracer;
+
+namespace
+{
+    // Unshadowed contribution of a light tree light to a diffuse surface, up to its albedo, like
+    // evaluateManyLights, and the target pdf of reservoir resampling for it
+    float lightContribution(const RtLightTree::Light &light, const float3 &position, const float3 &normal)
+    {
+        float3 lightPath = light.position - position;
+        float distance2 = dot(lightPath, lightPath);
+        float3 L = lightPath / std::sqrt(distance2);
+        float emission = light.type == RtLightTree::CosineLight ? saturate(dot(light.direction, -L)) : 1.0f;
+        return luminance(light.intensity * emission) * (std::max)(dot(normal, L), 0.0f) / (2.0f * 3.14159265f * distance2);
+    }
+
+    float reservoirTargetPdf(const RtLightTree::Light &light, const float3 &position, const float3 &normal)
+    {
+        float3 lightPath = light.position - position;
+        float distance2 = dot(lightPath, lightPath);
+        float3 L = lightPath / std::sqrt(distance2);
+        float emission = light.type == RtLightTree::CosineLight ? saturate(dot(light.direction, -L)) : 1.0f;
+        return Reservoirs::reservoirTargetPdf(luminance(light.intensity * emission), dot(normal, L), distance2);
+    }
+}
+
+namespace CpuRaytracer
+{
+    // Checks the reservoirs of ReservoirHlslCompat.h, then renders the direct lighting of many lights on a
+    // plane with the passes of RealtimeRaytracing.hlsl, less their shadow rays, and compares the error of
+    // light sampling, resampling and reuse against the exact sum over all lights
+    int reservoirTest(const Options &options)
+    {
+        using namespace Reservoirs;
+        bool passed = true;
+
+        // A stream keeps every candidate in proportion to its weight, whatever the order of the stream
+        const float weights[] = { 0.5f, 3.0f, 0.0f, 1.0f, 2.5f, 0.25f, 4.0f, 0.75f };
+        const uint32_t candidateCount = uint32_t(sizeof(weights) / sizeof(weights[0]));
+        const uint32_t trials = 400000;
+        float weightSum = 0.0f;
+        for (float weight : weights) {
+            weightSum += weight;
+        }
+        std::vector<uint32_t> kept(candidateCount);
+        std::vector<uint32_t> keptMerged(candidateCount);
+        uint32_t seed = RaytracingUtils::initRand(1, 2);
+        float maxWeightSumError = 0.0f;
+        for (uint32_t trial = 0; trial < trials; ++trial) {
+            Reservoir r = emptyReservoir();
+            for (uint32_t i = 0; i < candidateCount; ++i) {
+                updateReservoir(r, i, weights[i], 1.0f, RaytracingUtils::nextRand(seed));
+            }
+            ++kept[r.lightIndex];
+
+            // Two halves of a surface with the weights as its target pdf, as for lights drawn uniformly
+            Reservoir halves[2] = { emptyReservoir(), emptyReservoir() };
+            for (uint32_t i = 0; i < candidateCount; ++i) {
+                updateReservoir(halves[i % 2], i, weights[i], 1.0f, RaytracingUtils::nextRand(seed));
+            }
+            Reservoir merged = emptyReservoir();
+            for (Reservoir &half : halves) {
+                float targetPdf = weights[half.lightIndex];
+                finalizeReservoir(half, targetPdf);
+                float misWeight = reservoirMisWeight(half.M, targetPdf, (halves[0].M + halves[1].M) * targetPdf);
+                mergeReservoir(merged, half, targetPdf, misWeight, RaytracingUtils::nextRand(seed));
+            }
+            finalizeMergedReservoir(merged, weights[merged.lightIndex]);
+            finalizeReservoir(r, weights[r.lightIndex]);
+            ++keptMerged[merged.lightIndex];
+            // Both estimate the weight sum over the candidate count as W times the target pdf
+            float mergedEstimate = merged.W * weights[merged.lightIndex];
+            float estimate = r.W * weights[r.lightIndex];
+            maxWeightSumError = (std::max)(maxWeightSumError, std::fabs(mergedEstimate - estimate) / estimate);
+            passed &= merged.M == r.M;
+        }
+
+        // Binomial standard deviation of the frequencies is below 1e-3
+        float maxError = 0.0f;
+        float maxMergedError = 0.0f;
+        for (uint32_t i = 0; i < candidateCount; ++i) {
+            maxError = (std::max)(maxError, std::fabs(kept[i] / float(trials) - weights[i] / weightSum));
+            maxMergedError = (std::max)(maxMergedError, std::fabs(keptMerged[i] / float(trials) - weights[i] / weightSum));
+        }
+        bool streamPassed = maxError < 5e-3f && maxMergedError < 5e-3f && maxWeightSumError < 1e-5f && kept[2] == 0 && keptMerged[2] == 0;
+        printf("Stream of %u candidates, %u trials: frequency error %.2e, merged halves %.2e, weight sum error %.1e%s\n",
+               candidateCount, trials, maxError, maxMergedError, maxWeightSumError, streamPassed ? "" : "  FAILED");
+        passed &= streamPassed;
+
+        // A limited reservoir stands for fewer candidates with the same contribution weight
+        Reservoir limited = emptyReservoir();
+        for (uint32_t i = 0; i < candidateCount; ++i) {
+            updateReservoir(limited, i, weights[i], 1.0f, 0.5f);
+        }
+        finalizeReservoir(limited, weights[limited.lightIndex]);
+        float W = limited.W;
+        limitReservoir(limited, 2.0f);
+        finalizeReservoir(limited, weights[limited.lightIndex]);
+        passed &= limited.M == 2.0f && std::fabs(limited.W - W) < 1e-6f * W;
+
+        // A 64x64 screen over a floor under many lights, like Machines.fbx, static for temporal reuse
+        auto jobSystem = RtJobSystem::create(options.threads);
+        const uint32_t lightCount = 1000;
+        auto tree = RtLightTree::build(RtLightTree::scatter(lightCount, float3(-12.0f, 0.2f, -12.0f), float3(12.0f, 6.0f, 12.0f), 100.0f, 1), jobSystem.get());
+        const auto &lights = tree->getLights();
+        const uint32_t size = 64;
+        const uint32_t frames = 24;
+        const float3 normal(0.0f, 1.0f, 0.0f);
+        std::vector<float3> positions(size * size);
+        std::vector<double> exact(size * size);
+        double exactMean = 0.0;
+        for (uint32_t y = 0; y < size; ++y) {
+            for (uint32_t x = 0; x < size; ++x) {
+                uint32_t pixel = y * size + x;
+                positions[pixel] = float3(-8.0f + 16.0f * (x + 0.5f) / size, 0.0f, -8.0f + 16.0f * (y + 0.5f) / size);
+                for (const RtLightTree::Light &light : lights) {
+                    exact[pixel] += lightContribution(light, positions[pixel], normal);
+                }
+                exactMean += exact[pixel] / (size * size);
+            }
+        }
+
+        struct Variant
+        {
+            const char *name;
+            uint32_t candidates;
+            bool temporal;
+            uint32_t spatialSamples;
+        };
+        const Variant variants[] = {
+            { "light tree", 1, false, 0 },
+            { "8 candidates", 8, false, 0 },
+            { "+ temporal", 8, true, 0 },
+            { "+ spatial", 8, true, 5 },
+        };
+        // The defaults of the realtime pipeline, the radius scaled to the share of the screen 30 pixels
+        // are at 1080p
+        const float spatialRadius = 2.0f;
+        const float historyLimit = 20.0f;
+
+        printf("\n%u lights, %ux%u pixels, %u frames, error of the last %u frames against the sum over all lights\n", lightCount, size, size, frames, frames / 2);
+        printf("%-14s %10s %10s %12s\n", "", "rel. RMSE", "bias", "ns/pixel");
+        double lastError = 1e30;
+        for (const Variant &variant : variants) {
+            std::vector<Reservoir> current(size * size);
+            std::vector<Reservoir> history(size * size, emptyReservoir());
+            double squaredError = 0.0;
+            double estimateMean = 0.0;
+            double seconds = 0.0;
+            for (uint32_t frame = 0; frame < frames; ++frame) {
+                auto start = std::chrono::high_resolution_clock::now();
+                jobSystem->parallelFor(0, size * size, 64, [&](uint32_t begin, uint32_t end) {
+                    for (uint32_t pixel = begin; pixel < end; ++pixel) {
+                        uint32_t seed = RaytracingUtils::initRand(pixel, frame * 2);
+                        const float3 &position = positions[pixel];
+                        Reservoir r = emptyReservoir();
+                        float targetPdf = 0.0f;
+                        for (uint32_t i = 0; i < variant.candidates; ++i) {
+                            float pdf;
+                            uint32_t light = tree->sample(position, normal, RaytracingUtils::nextRand(seed), pdf);
+                            float candidateTargetPdf = pdf > 0.0f ? reservoirTargetPdf(lights[light], position, normal) : 0.0f;
+                            if (updateReservoir(r, light, pdf > 0.0f ? candidateTargetPdf / pdf : 0.0f, 1.0f, RaytracingUtils::nextRand(seed))) {
+                                targetPdf = candidateTargetPdf;
+                            }
+                        }
+                        finalizeReservoir(r, targetPdf);
+
+                        // The surface of the previous frame is the same, its MIS weights are by candidate counts
+                        if (variant.temporal && history[pixel].M > 0.0f) {
+                            Reservoir previous = history[pixel];
+                            limitReservoir(previous, historyLimit * variant.candidates);
+                            float count = r.M + previous.M;
+                            Reservoir combined = emptyReservoir();
+                            float combinedTargetPdf = 0.0f;
+                            if (mergeReservoir(combined, r, targetPdf, r.M / count, RaytracingUtils::nextRand(seed))) {
+                                combinedTargetPdf = targetPdf;
+                            }
+                            float previousTargetPdf = previous.lightIndex != RESERVOIR_INVALID_LIGHT ? reservoirTargetPdf(lights[previous.lightIndex], position, normal) : 0.0f;
+                            if (mergeReservoir(combined, previous, previousTargetPdf, previous.M / count, RaytracingUtils::nextRand(seed))) {
+                                combinedTargetPdf = previousTargetPdf;
+                            }
+                            finalizeMergedReservoir(combined, combinedTargetPdf);
+                            r = combined;
+                        }
+                        current[pixel] = r;
+                    }
+                });
+
+                std::vector<double> estimates(size * size);
+                jobSystem->parallelFor(0, size * size, 64, [&](uint32_t begin, uint32_t end) {
+                    for (uint32_t pixel = begin; pixel < end; ++pixel) {
+                        uint32_t seed = RaytracingUtils::initRand(pixel, frame * 2 + 1);
+                        const float3 &position = positions[pixel];
+                        int x = int(pixel % size);
+                        int y = int(pixel / size);
+                        uint32_t domains[9] = { pixel };
+                        uint32_t domainCount = 1;
+                        for (uint32_t i = 0; i < variant.spatialSamples; ++i) {
+                            float radius = spatialRadius * std::sqrt(RaytracingUtils::nextRand(seed));
+                            float angle = 2.0f * 3.14159265f * RaytracingUtils::nextRand(seed);
+                            int nx = x + int(std::round(std::cos(angle) * radius));
+                            int ny = y + int(std::round(std::sin(angle) * radius));
+                            if (nx >= 0 && ny >= 0 && nx < int(size) && ny < int(size) && (nx != x || ny != y)) {
+                                domains[domainCount++] = uint32_t(ny * size + nx);
+                            }
+                        }
+
+                        Reservoir combined = emptyReservoir();
+                        float combinedTargetPdf = 0.0f;
+                        for (uint32_t i = 0; i < domainCount; ++i) {
+                            const Reservoir &other = current[domains[i]];
+                            if (other.lightIndex == RESERVOIR_INVALID_LIGHT) {
+                                combined.M += other.M;
+                                continue;
+                            }
+                            float weightedTargetPdfSum = 0.0f;
+                            float otherTargetPdf = 0.0f;
+                            for (uint32_t j = 0; j < domainCount; ++j) {
+                                float domainTargetPdf = reservoirTargetPdf(lights[other.lightIndex], positions[domains[j]], normal);
+                                weightedTargetPdfSum += current[domains[j]].M * domainTargetPdf;
+                                otherTargetPdf = i == j ? domainTargetPdf : otherTargetPdf;
+                            }
+                            float targetPdf = reservoirTargetPdf(lights[other.lightIndex], position, normal);
+                            float misWeight = reservoirMisWeight(other.M, otherTargetPdf, weightedTargetPdfSum);
+                            if (mergeReservoir(combined, other, targetPdf, misWeight, RaytracingUtils::nextRand(seed))) {
+                                combinedTargetPdf = targetPdf;
+                            }
+                        }
+                        finalizeMergedReservoir(combined, combinedTargetPdf);
+                        history[pixel] = combined;
+                        estimates[pixel] = combined.W > 0.0f ? lightContribution(lights[combined.lightIndex], position, normal) * combined.W : 0.0;
+                    }
+                });
+                seconds += secondsSince(start);
+
+                if (frame >= frames / 2) {
+                    for (uint32_t pixel = 0; pixel < size * size; ++pixel) {
+                        double error = (estimates[pixel] - exact[pixel]) / exact[pixel];
+                        squaredError += error * error;
+                        estimateMean += estimates[pixel];
+                    }
+                }
+            }
+
+            double samples = double(size * size) * (frames - frames / 2);
+            double error = std::sqrt(squaredError / samples);
+            double bias = estimateMean / samples / exactMean - 1.0;
+            // Unbiased without visibility, the bias is the noise of the mean
+            bool variantPassed = error < lastError && std::fabs(bias) < 0.02;
+            printf("%-14s %10.4f %+10.4f %12.1f%s\n", variant.name, error, bias, seconds * 1e9 / (double(size * size) * frames), variantPassed ? "" : "  FAILED");
+            passed &= variantPassed;
+            lastError = error;
+        }
+
+        printf("\n%s\n", passed ? "All reservoir tests passed" : "Reservoir tests FAILED");
+        return passed ? 0 : 1;
+    }
+}
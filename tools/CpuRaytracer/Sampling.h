@@ -0,0 +1,64 @@
+#pragma once
+
+// C++ port of assets/shaders/Sampling.hlsli. The sequences themselves are shared with the shaders
+// through SamplingHlslCompat.h.
+
+#include "RaytracingUtils.h"
+#include "SamplingHlslCompat.h"
+
+namespace Sampling
+{
+    using namespace DXRFramework::CpuMath;
+
+    struct SampleGenerator
+    {
+        uint32_t sequence;
+        uint32_t index;
+        uint32_t dimension;
+        // Owen scrambling seed, or the state of nextRand for SAMPLE_SEQUENCE_RANDOM
+        uint32_t seed;
+        uint2 pixel;
+    };
+
+    inline SampleGenerator initSampleGenerator(uint32_t sequence, uint2 pixel, uint2 dims, uint32_t frameCount, uint32_t sampleIndex, uint32_t firstDimension)
+    {
+        SampleGenerator generator;
+        generator.sequence = sequence;
+        generator.index = sampleIndex;
+        generator.dimension = firstDimension;
+        generator.pixel = pixel;
+        if (sequence == SAMPLE_SEQUENCE_RANDOM) {
+            generator.seed = RaytracingUtils::initRand(pixel.x + pixel.y * dims.x, frameCount);
+            // The first two bounces share the seed as they always did, deeper ones would repeat their directions
+            if (firstDimension >= SAMPLE_DIMENSION_FIRST_BOUNCE + 2 * SAMPLE_DIMENSIONS_PER_BOUNCE) {
+                generator.seed = RaytracingUtils::initRand(generator.seed, (firstDimension - SAMPLE_DIMENSION_FIRST_BOUNCE) / SAMPLE_DIMENSIONS_PER_BOUNCE);
+            }
+        } else {
+            generator.seed = sampleSequenceSeed(sequence, pixel.x, pixel.y);
+        }
+        return generator;
+    }
+
+    inline float2 nextSample2D(SampleGenerator &generator)
+    {
+        if (generator.sequence == SAMPLE_SEQUENCE_RANDOM) {
+            float x = RaytracingUtils::nextRand(generator.seed);
+            float y = RaytracingUtils::nextRand(generator.seed);
+            return float2(x, y);
+        }
+
+        float2 value;
+        value.x = sampleSequenceDimension(generator.sequence, generator.index, generator.dimension, generator.seed, generator.pixel.x, generator.pixel.y);
+        value.y = sampleSequenceDimension(generator.sequence, generator.index, generator.dimension + 1, generator.seed, generator.pixel.x, generator.pixel.y);
+        generator.dimension += 2;
+        return value;
+    }
+
+    inline float nextSample1D(SampleGenerator &generator)
+    {
+        if (generator.sequence == SAMPLE_SEQUENCE_RANDOM) {
+            return RaytracingUtils::nextRand(generator.seed);
+        }
+        return nextSample2D(generator).x;
+    }
+}
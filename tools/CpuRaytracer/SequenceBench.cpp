@@ -0,0 +1,145 @@
+#include "CpuRaytracer.h"
+#include "Sampling.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace DXRFramework;
+using namespace DXRFramework::CpuMath;
+using namespace CpuRaytracer;
+
+namespace
+{
+    // Every elementary interval of area 2^-k, 2^a by 2^(k - a) strata, must hold exactly one of the
+    // first 2^k points of a (0, 2)-sequence
+    bool isZeroTwoNet(const std::vector<uint32_t> &xs, const std::vector<uint32_t> &ys, uint32_t log2Count)
+    {
+        std::vector<uint8_t> hits(size_t(1) << log2Count);
+        for (uint32_t a = 0; a <= log2Count; ++a) {
+            std::fill(hits.begin(), hits.end(), 0);
+            for (size_t i = 0; i < hits.size(); ++i) {
+                uint32_t cellX = a == 0 ? 0 : xs[i] >> (32 - a);
+                uint32_t cellY = a == log2Count ? 0 : ys[i] >> (32 - (log2Count - a));
+                uint8_t &hit = hits[(size_t(cellY) << a) | cellX];
+                if (hit++) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+namespace CpuRaytracer
+{
+    // Checks that the Owen-scrambled Sobol patterns stay (0, 2)-sequences, then measures the error of
+    // each sample sequence against a reference for 1 to 256 samples per pixel.
+    int sequenceBench(const Options &options)
+    {
+        bool passed = true;
+        uint32_t netChecks = 0;
+        for (uint32_t seed = 0; seed < 8; ++seed) {
+            for (uint32_t dimension = 0; dimension < 16; dimension += 2) {
+                uint32_t sequenceSeed = Sampling::sampleSequenceSeed(SAMPLE_SEQUENCE_SOBOL, seed * 97, seed * 13);
+                std::vector<uint32_t> xs, ys;
+                for (uint32_t index = 0; index < 4096; ++index) {
+                    xs.push_back(Sampling::sobolOwen(index, dimension, sequenceSeed));
+                    ys.push_back(Sampling::sobolOwen(index, dimension + 1, sequenceSeed));
+                }
+                // Every power of two prefix is a net, so is every aligned block after the first
+                for (uint32_t log2Count = 0; log2Count <= 12; ++log2Count) {
+                    passed &= isZeroTwoNet(xs, ys, log2Count);
+                    std::vector<uint32_t> blockX(xs.begin() + (xs.size() >> 1), xs.end()), blockY(ys.begin() + (ys.size() >> 1), ys.end());
+                    passed &= log2Count == 12 || isZeroTwoNet(blockX, blockY, log2Count);
+                    netChecks += 2;
+                }
+            }
+        }
+        printf("(0, 2)-net checks: %u%s\n", netChecks, passed ? ", passed" : "  FAILED");
+
+        const uint32_t size = 128;
+        const uint32_t referenceSamples = 2048;
+        const uint32_t maxSamples = 256;
+        auto context = CpuContext::create(options.threads);
+
+        struct BenchScene
+        {
+            const char *name;
+            CpuScene::SharedPtr scene;
+            CpuTexture::SharedPtr environment;
+        };
+        double buildSeconds;
+        BenchScene scenes[] = {
+            { "susanne, environment", loadScene({ "assets/models/susanne.obj" }, false, buildSeconds), loadEnvironment("assets/textures/CathedralRadiance.dds") },
+            { "cornell", loadScene({ "assets/models/cornell.obj" }, false, buildSeconds), nullptr },
+        };
+        const uint32_t sequences[] = { SAMPLE_SEQUENCE_RANDOM, SAMPLE_SEQUENCE_SOBOL, SAMPLE_SEQUENCE_BLUE_NOISE_SOBOL };
+
+        printf("%u threads, %ux%u, RMSE against a reference of 2 x %u random samples\n", context->getThreadCount(), size, size, referenceSamples);
+        for (const BenchScene &benchScene : scenes) {
+            auto createPipeline = [&](uint32_t sequence) {
+                auto pipeline = std::make_shared<ProgressiveRaytracing>(context, benchScene.scene, std::vector<MaterialParams>{ defaultMaterial() });
+                pipeline->resize(size, size);
+                pipeline->setCamera(frameScene(benchScene.scene->getBounds()));
+                pipeline->setEnvironment(benchScene.environment);
+                pipeline->getOptions().sampleSequence = sequence;
+                return pipeline;
+            };
+
+            // Two halves on frame counts after those of the compared random run. Their difference gives
+            // the noise left in the reference, which is taken out of the measured errors.
+            auto referencePipeline = createPipeline(SAMPLE_SEQUENCE_RANDOM);
+            for (uint32_t i = 0; i < maxSamples; ++i) {
+                referencePipeline->render();
+            }
+            CpuTexture::SharedPtr halves[2];
+            for (auto &half : halves) {
+                referencePipeline->resetAccumulation();
+                for (uint32_t i = 0; i < referenceSamples; ++i) {
+                    referencePipeline->render();
+                }
+                half = copyImage(*referencePipeline->getOutput());
+            }
+            auto reference = CpuTexture::create(size, size);
+            for (uint32_t y = 0; y < size; ++y) {
+                for (uint32_t x = 0; x < size; ++x) {
+                    reference->getData()[size_t(y) * size + x] = (halves[0]->load(x, y) + halves[1]->load(x, y)) * 0.5f;
+                }
+            }
+            double referenceNoise = meanSquaredError(*halves[0], *halves[1]) / 4.0;
+            double referenceBlurredNoise = meanSquaredError(*halves[0], *halves[1], 1) / 4.0;
+
+            // Errors after every sample, and of the error blurred over 3x3 pixels
+            std::vector<double> errors[3], blurredErrors[3];
+            for (int s = 0; s < 3; ++s) {
+                auto pipeline = createPipeline(sequences[s]);
+                for (uint32_t i = 0; i < maxSamples; ++i) {
+                    pipeline->render();
+                    errors[s].push_back(std::sqrt((std::max)(0.0, meanSquaredError(*pipeline->getOutput(), *reference) - referenceNoise)));
+                    if (i < 16) {
+                        blurredErrors[s].push_back(std::sqrt((std::max)(0.0, meanSquaredError(*pipeline->getOutput(), *reference, 1) - referenceBlurredNoise)));
+                    }
+                }
+            }
+
+            printf("%s, reference noise %.5f\n%8s %10s %10s %10s %16s %16s\n", benchScene.name, std::sqrt(referenceNoise), "spp", "random", "sobol",
+                   "blue noise", "sobol blurred", "blue n. blurred");
+            for (uint32_t spp = 1; spp <= maxSamples; spp *= 2) {
+                printf("%8u %10.5f %10.5f %10.5f", spp, errors[0][spp - 1], errors[1][spp - 1], errors[2][spp - 1]);
+                if (spp <= blurredErrors[0].size()) {
+                    printf(" %16.5f %16.5f", blurredErrors[1][spp - 1], blurredErrors[2][spp - 1]);
+                }
+                printf("\n");
+            }
+            // Samples the low-discrepancy sequences need to match the error of random sampling at maxSamples
+            for (int s = 1; s < 3; ++s) {
+                uint32_t samples = 0;
+                while (samples < maxSamples && errors[s][samples] > errors[0][maxSamples - 1]) {
+                    ++samples;
+                }
+                printf("%-10s reaches the error of %u random samples after %u samples\n", s == 1 ? "sobol" : "blue noise", maxSamples, samples + 1);
+            }
+        }
+        return passed ? 0 : 1;
+    }
+}
@@ -0,0 +1,170 @@
+#include "CpuRaytracer.h"
+#include "RaytracingUtils.h"
+#include "RtStagingPlanner.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace DXRFramework;
+
+namespace
+{
+    // Stands in for the copy queue of RtUploadQueue. Batches only complete when the planner waits for
+    // them, or when the test lets the GPU catch up, so every stall shows up in waits.
+    class MockQueue : public RtStagingPlanner::Queue
+    {
+    public:
+        uint64_t submitBatch() override { return ++submitted; }
+        uint64_t getCompletedValue() override { return completed; }
+        void waitForValue(uint64_t fenceValue) override
+        {
+            if (fenceValue > submitted) {
+                throw std::logic_error("waited for a batch that was never submitted");
+            }
+            waits.push_back(fenceValue);
+            completed = std::max(completed, fenceValue);
+        }
+
+        uint64_t submitted = 0;
+        uint64_t completed = 0;
+        std::vector<uint64_t> waits;
+    };
+
+    struct Region
+    {
+        uint64_t offset;
+        uint64_t size;
+        uint64_t fenceValue;
+    };
+
+    bool check(bool condition, const char *name)
+    {
+        printf("%-56s %s\n", name, condition ? "ok" : "FAILED");
+        return condition;
+    }
+}
+
+namespace CpuRaytracer
+{
+    // Drives RtStagingPlanner against a mock queue: allocations wrap around the end of the ring, a full
+    // ring submits the open batch and stalls on the oldest one, copies larger than the ring are split
+    // into row chunks, and no allocation ever overlaps staging memory a pending copy still reads
+    int stagingTest(const Options &)
+    {
+        bool passed = true;
+
+        {
+            // The third allocation does not fit behind the second, the 224 bytes left at the end are
+            // skipped and charged to its batch
+            MockQueue queue;
+            RtStagingPlanner planner(queue, 1024);
+            uint64_t first = planner.allocate(400, 1);
+            planner.submit();
+            uint64_t second = planner.allocate(400, 1);
+            planner.submit();
+            queue.completed = 1;
+            uint64_t third = planner.allocate(400, 1);
+            passed &= check(first == 0 && second == 400 && third == 0, "wrap-around restarts at the beginning of the ring");
+            passed &= check(planner.getBytesInFlight() == 1024 && queue.waits.empty(), "wrap-around charges the skipped bytes, no stall");
+            queue.completed = planner.submit();
+            planner.allocate(1, 1);
+            passed &= check(planner.getBytesInFlight() == 1, "skipped bytes are reclaimed with their batch");
+
+            uint64_t aligned = planner.allocate(100, 256);
+            passed &= check(aligned % 256 == 0, "aligned allocations");
+        }
+
+        {
+            // Nothing was submitted when the ring fills up, the planner has to submit before it can wait
+            MockQueue queue;
+            RtStagingPlanner planner(queue, 1024);
+            planner.allocate(600, 1);
+            uint64_t offset = planner.allocate(600, 1);
+            passed &= check(queue.submitted == 1 && queue.waits == std::vector<uint64_t>{ 1 }, "full ring submits the open batch and waits for it");
+            passed &= check(offset == 0 && planner.getStats().stalls == 1 && planner.getPendingFenceValue() == 2, "the stalled allocation lands in the next batch");
+
+            bool threw = false;
+            try {
+                planner.allocate(1025, 1);
+            } catch (const std::length_error &) {
+                threw = true;
+            }
+            passed &= check(threw, "allocations larger than the ring are rejected");
+        }
+
+        {
+            // 40 rows of 256 bytes through a 4 KB ring, half of which an earlier batch still holds
+            MockQueue queue;
+            RtStagingPlanner planner(queue, 4096);
+            planner.allocate(2048, 1);
+            planner.submit();
+
+            uint32_t nextRow = 0;
+            bool contiguous = true;
+            bool fits = true;
+            uint32_t chunks = 0;
+            uint32_t firstChunkRows = 0;
+            uint64_t firstChunkOffset = 0;
+            size_t firstChunkWaits = 0;
+            uint64_t lastFence = planner.planRows(40, 256, 512, [&](uint32_t firstRow, uint32_t rowCount, uint64_t stagingOffset) {
+                contiguous &= firstRow == nextRow && rowCount > 0;
+                fits &= stagingOffset % 512 == 0 && stagingOffset + rowCount * 256 <= 4096;
+                if (chunks++ == 0) {
+                    firstChunkRows = rowCount;
+                    firstChunkOffset = stagingOffset;
+                    firstChunkWaits = queue.waits.size();
+                }
+                nextRow = firstRow + rowCount;
+            });
+            printf("%u rows in %u chunks, %llu stalls\n", nextRow, chunks, static_cast<unsigned long long>(planner.getStats().stalls));
+            passed &= check(nextRow == 40 && contiguous && chunks >= 3, "rows are split into chunks in order");
+            passed &= check(fits, "chunks are aligned and fit the ring");
+            passed &= check(firstChunkRows == 8 && firstChunkOffset == 2048 && firstChunkWaits == 0, "first chunk takes the free half without stalling");
+            passed &= check(!queue.waits.empty() && queue.waits.front() == 1, "later chunks stall on the oldest batch");
+            passed &= check(lastFence == planner.getPendingFenceValue() && planner.submit() == lastFence, "returned fence covers the last chunk");
+
+            bool threw = false;
+            try {
+                planner.planRows(1, 4096, 512, [](uint32_t, uint32_t, uint64_t) {});
+            } catch (const std::length_error &) {
+                threw = true;
+            }
+            passed &= check(threw, "rows larger than the ring are rejected");
+        }
+
+        {
+            // Random sizes, alignments and submissions while the GPU completes batches at random. Every
+            // allocation is checked against the regions of batches that have not completed yet.
+            MockQueue queue;
+            RtStagingPlanner planner(queue, 64 * 1024);
+            std::vector<Region> live;
+            uint32_t seed = RaytracingUtils::initRand(3, 5);
+            bool disjoint = true;
+            for (uint32_t i = 0; i < 100000; ++i) {
+                float r = RaytracingUtils::nextRand(seed);
+                if (r < 0.3f && queue.completed < queue.submitted) {
+                    queue.completed++;
+                } else if (r < 0.4f) {
+                    planner.submit();
+                }
+
+                uint64_t size = 1 + static_cast<uint64_t>(RaytracingUtils::nextRand(seed) * 16 * 1024);
+                uint64_t alignment = uint64_t(1) << static_cast<uint32_t>(RaytracingUtils::nextRand(seed) * 10);
+                uint64_t offset = planner.allocate(size, alignment);
+                live.erase(std::remove_if(live.begin(), live.end(), [&](const Region &region) { return region.fenceValue <= queue.completed; }), live.end());
+                for (const Region &region : live) {
+                    disjoint &= offset + size <= region.offset || region.offset + region.size <= offset;
+                }
+                disjoint &= offset % alignment == 0 && offset + size <= planner.getCapacity();
+                live.push_back({ offset, size, planner.getPendingFenceValue() });
+            }
+            const auto &stats = planner.getStats();
+            printf("%llu chunks in %llu batches, %llu stalls\n", static_cast<unsigned long long>(stats.chunks),
+                   static_cast<unsigned long long>(stats.batches), static_cast<unsigned long long>(stats.stalls));
+            passed &= check(disjoint, "allocations never overlap pending copies");
+        }
+
+        printf("\n%s\n", passed ? "All staging tests passed" : "Staging tests FAILED");
+        return passed ? 0 : 1;
+    }
+}
@@ -0,0 +1,203 @@
+#include "CpuRaytracer.h"
+#include "TestScene.h"
+#include "RaytracingUtils.h"
+#include "TemporalAccumulationHlslCompat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace DXRFramework;
+using namespace DXRFramework::CpuMath;
+
+namespace CpuRaytracer
+{
+    // Checks the reprojection of TemporalAccumulationHlslCompat.h against direct projection, then runs
+    // TemporalAccumulation.hlsl on noisy samples of a wall behind a panel while the camera pans, and
+    // compares the error of the samples and of the accumulation with and without its surface test and
+    // neighbourhood clamping
+    int temporalTest(const Options &)
+    {
+        using namespace TemporalAccumulation;
+        bool passed = true;
+
+        const uint32_t width = 96, height = 64;
+        const float2 dims = float2(float(width), float(height));
+        const float fov = 0.8f;
+        const float aspect = float(width) / height;
+
+        // A pixel's camera ray lands on its own centre, and the reprojected clip position on the pixel
+        // the previous camera projects the surface to
+        {
+            TestCamera previous(float3(0.3f, -0.2f, 0.5f), fov, aspect);
+            TestCamera current(float3(-0.4f, 0.1f, 0.0f), fov, aspect);
+            TestMatrix reprojection = multiply(invert(current.viewProj), previous.viewProj);
+            float maxRayError = 0.0f, maxReprojectionError = 0.0f;
+            for (uint32_t y = 0; y < height; y += 7) {
+                for (uint32_t x = 0; x < width; x += 5) {
+                    float3 position = current.eye + current.rayDirection(x, y, width, height) * (5.0f + 0.1f * (x + y));
+                    float4 clip = transform(float4(position, 1.0f), current.viewProj);
+                    float2 pixel = clipToPixel(clip, dims);
+                    maxRayError = (std::max)(maxRayError, (std::max)(std::fabs(pixel.x - x - 0.5f), std::fabs(pixel.y - y - 0.5f)));
+
+                    float2 reprojected = clipToPixel(reprojectClip(clip, reprojection.rows[0], reprojection.rows[1], reprojection.rows[2], reprojection.rows[3]), dims);
+                    float2 expected = clipToPixel(transform(float4(position, 1.0f), previous.viewProj), dims);
+                    maxReprojectionError = (std::max)(maxReprojectionError, (std::max)(std::fabs(reprojected.x - expected.x), std::fabs(reprojected.y - expected.y)));
+                }
+            }
+            bool reprojectionPassed = maxRayError < 1e-3f && maxReprojectionError < 1e-2f;
+            printf("Camera rays land %.1e pixels from their centres, reprojection is %.1e pixels from projection%s\n",
+                   maxRayError, maxReprojectionError, reprojectionPassed ? "" : "  FAILED");
+            passed &= reprojectionPassed;
+        }
+
+        struct Variant
+        {
+            const char *name;
+            bool accumulate;
+            bool surfaceTest;
+            float clampGamma;
+        };
+        const Variant variants[] = {
+            { "samples", false, false, 0.0f },
+            { "no surface test", true, false, 0.0f },
+            { "no clamping", true, true, 0.0f },
+            { "clamp 1.25", true, true, 1.25f },
+        };
+        const uint32_t frames = 48;
+        const uint32_t lightingStep = 32;
+        const float minAlpha = 0.1f;
+
+        printf("\n%ux%u pixels, %u frames panning 0.06 units per frame, lighting doubles at frame %u\n", width, height, frames, lightingStep);
+        printf("%-16s %10s %14s %12s\n", "", "rel. RMSE", "disoccluded", "lag");
+        double results[4][3];
+        for (uint32_t v = 0; v < 4; ++v) {
+            const Variant &variant = variants[v];
+            std::vector<float4> guide(width * height), previousGuide(width * height, float4(0.0f, 0.0f, 0.0f, -1.0f));
+            std::vector<float4> accumulated(width * height), history(width * height, float4(0.0f));
+            std::vector<float3> samples(width * height);
+            std::vector<float> exact(width * height);
+            std::vector<uint8_t> disoccluded(width * height);
+            uint32_t seed = RaytracingUtils::initRand(7, 11);
+
+            double squaredError = 0.0, disoccludedError = 0.0, lag = 0.0;
+            uint32_t errorCount = 0, disoccludedCount = 0, lagCount = 0;
+            TestCamera previousCamera(float3(0.0f), fov, aspect);
+            for (uint32_t frame = 0; frame < frames; ++frame) {
+                TestCamera camera(float3(-1.5f + 0.06f * frame, 0.0f, 0.0f), fov, aspect);
+                TestMatrix reprojection = multiply(invert(camera.viewProj), previousCamera.viewProj);
+                float scale = frame >= lightingStep ? 2.0f : 1.0f;
+
+                // The ray generation shader: a sample with 80% noise and the guide of every pixel
+                for (uint32_t y = 0; y < height; ++y) {
+                    for (uint32_t x = 0; x < width; ++x) {
+                        uint32_t pixel = y * width + x;
+                        float3 position;
+                        bool panel;
+                        traceTestScene(camera.eye, camera.rayDirection(x, y, width, height), position, panel);
+                        exact[pixel] = testSceneRadiance(position, panel) * scale;
+                        samples[pixel] = float3(exact[pixel] * (1.0f + 1.6f * (RaytracingUtils::nextRand(seed) - 0.5f)));
+                        guide[pixel] = float4(quantizeAovNormal(float3(0.0f, 0.0f, 1.0f)), quantizeAovDepth(transform(float4(position, 1.0f), camera.viewProj).w));
+
+                        // Seen behind the panel from the previous camera
+                        float3 previousPosition;
+                        bool previousPanel;
+                        traceTestScene(previousCamera.eye, normalize(position - previousCamera.eye), previousPosition, previousPanel);
+                        disoccluded[pixel] = frame > 0 && !panel && previousPanel;
+                    }
+                }
+
+                // TemporalAccumulation.hlsl
+                for (uint32_t y = 0; y < height && variant.accumulate; ++y) {
+                    for (uint32_t x = 0; x < width; ++x) {
+                        uint32_t pixel = y * width + x;
+                        float3 mean(0.0f), meanOfSquares(0.0f);
+                        for (int dy = -1; dy <= 1; ++dy) {
+                            for (int dx = -1; dx <= 1; ++dx) {
+                                int tx = (std::min)((std::max)(int(x) + dx, 0), int(width) - 1);
+                                int ty = (std::min)((std::max)(int(y) + dy, 0), int(height) - 1);
+                                const float3 &tap = samples[ty * width + tx];
+                                mean += tap / 9.0f;
+                                meanOfSquares += tap * tap / 9.0f;
+                            }
+                        }
+
+                        float historyLength = 0.0f;
+                        float3 historyColor(0.0f);
+                        if (frame > 0) {
+                            float3 direction = camera.rayDirection(x, y, width, height);
+                            float3 position = camera.eye + direction * (guide[pixel].w / dot(direction, normalize(camera.W)));
+                            float4 clip = transform(float4(position, 1.0f), camera.viewProj);
+                            float4 previousClip = reprojectClip(clip, reprojection.rows[0], reprojection.rows[1], reprojection.rows[2], reprojection.rows[3]);
+                            float2 previousPixel = clipToPixel(previousClip, dims) - float2(0.5f, 0.5f);
+                            int baseX = int(std::floor(previousPixel.x)), baseY = int(std::floor(previousPixel.y));
+                            float4 weights = temporalBilinearWeights(float2(previousPixel.x - baseX, previousPixel.y - baseY));
+                            const float tapWeights[4] = { weights.x, weights.y, weights.z, weights.w };
+
+                            float weightSum = 0.0f;
+                            for (int i = 0; i < 4; ++i) {
+                                int tx = baseX + (i & 1), ty = baseY + (i >> 1);
+                                if (tx < 0 || ty < 0 || tx >= int(width) || ty >= int(height)) {
+                                    continue;
+                                }
+                                const float4 &tapGuide = previousGuide[ty * width + tx];
+                                if (!variant.surfaceTest || temporalSurfaceMatches(guide[pixel].xyz(), tapGuide.xyz(), previousClip.w, tapGuide.w)) {
+                                    const float4 &tap = history[ty * width + tx];
+                                    historyColor += tap.rgb() * tapWeights[i];
+                                    historyLength += tap.w * tapWeights[i];
+                                    weightSum += tapWeights[i];
+                                }
+                            }
+                            if (weightSum > 0.01f) {
+                                historyColor = historyColor / weightSum;
+                                historyLength /= weightSum;
+                            } else {
+                                historyLength = 0.0f;
+                            }
+                        }
+
+                        if (variant.clampGamma > 0.0f) {
+                            historyColor = clampToNeighbourhood(historyColor, mean, meanOfSquares, variant.clampGamma);
+                        }
+                        float3 color;
+                        float length = blendHistory(color, historyColor, samples[pixel], historyLength, minAlpha);
+                        accumulated[pixel] = float4(color, length);
+                    }
+                }
+
+                for (uint32_t pixel = 0; pixel < width * height; ++pixel) {
+                    float estimate = variant.accumulate ? accumulated[pixel].x : samples[pixel].x;
+                    float error = (estimate - exact[pixel]) / exact[pixel];
+                    if (frame >= lightingStep / 2 && frame < lightingStep) {
+                        squaredError += error * error;
+                        ++errorCount;
+                    }
+                    if (frame >= lightingStep / 2 && disoccluded[pixel]) {
+                        disoccludedError += std::fabs(error);
+                        ++disoccludedCount;
+                    }
+                    if (frame >= lightingStep && frame < lightingStep + 4) {
+                        lag += error;
+                        ++lagCount;
+                    }
+                }
+
+                std::swap(guide, previousGuide);
+                std::swap(accumulated, history);
+                previousCamera = camera;
+            }
+
+            results[v][0] = std::sqrt(squaredError / errorCount);
+            results[v][1] = disoccludedError / (std::max)(disoccludedCount, 1u);
+            results[v][2] = std::fabs(lag / lagCount);
+            printf("%-16s %10.4f %14.4f %12.4f\n", variant.name, results[v][0], results[v][1], results[v][2]);
+        }
+
+        // Accumulation cuts the noise, the surface test keeps the panel out of the revealed wall and
+        // clamping catches up with the lighting faster
+        bool accumulationPassed = results[3][0] < 0.5 * results[0][0] && results[2][1] < 0.5 * results[1][1] && results[3][2] < results[2][2];
+        passed &= accumulationPassed;
+
+        printf("\n%s\n", passed ? "All temporal accumulation tests passed" : "Temporal accumulation tests FAILED");
+        return passed ? 0 : 1;
+    }
+}
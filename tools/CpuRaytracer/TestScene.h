@@ -0,0 +1,132 @@
+#pragma once
+
+#include "AovHlslCompat.h"
+#include "Image.h"
+#include "Cpu/CpuMath.h"
+#include <cmath>
+
+// Camera and scene shared by the temporal, denoise and AOV tests
+namespace CpuRaytracer
+{
+    using namespace DXRFramework::CpuMath;
+
+    // Row vector 4x4 matrix of the temporal test, like the DirectXMath matrices of Math::Camera
+    struct TestMatrix
+    {
+        float4 rows[4];
+    };
+
+    inline TestMatrix multiply(const TestMatrix &a, const TestMatrix &b)
+    {
+        TestMatrix m;
+        for (int i = 0; i < 4; ++i) {
+            const float4 &r = a.rows[i];
+            m.rows[i] = b.rows[0] * r.x + b.rows[1] * r.y + b.rows[2] * r.z + b.rows[3] * r.w;
+        }
+        return m;
+    }
+
+    // Gauss-Jordan elimination with partial pivoting in double precision
+    inline TestMatrix invert(const TestMatrix &m)
+    {
+        double a[4][8];
+        for (int i = 0; i < 4; ++i) {
+            const float *row = &m.rows[i].x;
+            for (int j = 0; j < 4; ++j) {
+                a[i][j] = row[j];
+                a[i][j + 4] = i == j ? 1.0 : 0.0;
+            }
+        }
+        for (int column = 0; column < 4; ++column) {
+            int pivot = column;
+            for (int i = column + 1; i < 4; ++i) {
+                pivot = std::fabs(a[i][column]) > std::fabs(a[pivot][column]) ? i : pivot;
+            }
+            std::swap(a[column], a[pivot]);
+            double scale = 1.0 / a[column][column];
+            for (int j = 0; j < 8; ++j) {
+                a[column][j] *= scale;
+            }
+            for (int i = 0; i < 4; ++i) {
+                double factor = a[i][column];
+                for (int j = 0; j < 8 && i != column; ++j) {
+                    a[i][j] -= factor * a[column][j];
+                }
+            }
+        }
+        TestMatrix inverse;
+        for (int i = 0; i < 4; ++i) {
+            inverse.rows[i] = float4(float(a[i][4]), float(a[i][5]), float(a[i][6]), float(a[i][7]));
+        }
+        return inverse;
+    }
+
+    inline float4 transform(const float4 &v, const TestMatrix &m)
+    {
+        return m.rows[0] * v.x + m.rows[1] * v.y + m.rows[2] * v.z + m.rows[3] * v.w;
+    }
+
+    // Camera of the temporal test looking down -z, with the view projection of Math::Camera and the ray
+    // basis of the realtime pipeline's calculateCameraVariables
+    struct TestCamera
+    {
+        float3 eye, U, V, W;
+        TestMatrix viewProj;
+
+        TestCamera(const float3 &eye, float fov, float aspect) : eye(eye)
+        {
+            float tanHalfFov = std::tan(0.5f * fov);
+            U = float3(tanHalfFov * aspect, 0.0f, 0.0f);
+            V = float3(0.0f, tanHalfFov, 0.0f);
+            W = float3(0.0f, 0.0f, -1.0f);
+
+            const float nearZ = 1.0f, farZ = 1000.0f;
+            TestMatrix view = { { float4(1.0f, 0.0f, 0.0f, 0.0f), float4(0.0f, 1.0f, 0.0f, 0.0f), float4(0.0f, 0.0f, 1.0f, 0.0f), float4(-eye.x, -eye.y, -eye.z, 1.0f) } };
+            TestMatrix projection = { { float4(1.0f / (tanHalfFov * aspect), 0.0f, 0.0f, 0.0f), float4(0.0f, 1.0f / tanHalfFov, 0.0f, 0.0f),
+                                        float4(0.0f, 0.0f, farZ / (nearZ - farZ), -1.0f), float4(0.0f, 0.0f, nearZ * farZ / (nearZ - farZ), 0.0f) } };
+            viewProj = multiply(view, projection);
+        }
+
+        float3 rayDirection(uint32_t x, uint32_t y, uint32_t width, uint32_t height) const
+        {
+            float dx = (x + 0.5f) / width * 2.0f - 1.0f;
+            float dy = (y + 0.5f) / height * 2.0f - 1.0f;
+            return normalize(U * dx - V * dy + W);
+        }
+    };
+
+    // Round trips through the AOV formats of AovHlslCompat.h, R16_FLOAT depth and R16G16_SNORM normals
+    inline float quantizeSnorm16(float value)
+    {
+        return std::round((std::min)((std::max)(value, -1.0f), 1.0f) * 32767.0f) / 32767.0f;
+    }
+
+    inline float3 quantizeAovNormal(const float3 &normal)
+    {
+        float2 encoded = Aov::aovEncodeNormal(normal);
+        return Aov::aovDecodeNormal(float2(quantizeSnorm16(encoded.x), quantizeSnorm16(encoded.y)));
+    }
+
+    inline float quantizeAovDepth(float depth)
+    {
+        return TextureConverter::halfToFloat(TextureConverter::floatToHalf(depth));
+    }
+
+    // Scene of the temporal and denoise tests, a textured wall at z = -20 and a bright panel at z = -10 in
+    // front of it, lit from the camera side
+    inline float testSceneRadiance(const float3 &position, bool panel, float wallFrequency = 1.5f)
+    {
+        return panel ? 2.0f : 0.5f + 0.4f * std::sin(position.x * wallFrequency) * std::cos(position.y * wallFrequency);
+    }
+
+    inline void traceTestScene(const float3 &eye, const float3 &direction, float3 &position, bool &panel)
+    {
+        float t = (-10.0f - eye.z) / direction.z;
+        position = eye + direction * t;
+        panel = std::fabs(position.x) < 2.0f && std::fabs(position.y) < 2.0f;
+        if (!panel) {
+            t = (-20.0f - eye.z) / direction.z;
+            position = eye + direction * t;
+        }
+    }
+}
@@ -0,0 +1,363 @@
+#include "CpuRaytracer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace DXRFramework;
+using namespace DXRFramework::CpuMath;
+using namespace CpuRaytracer;
+
+namespace
+{
+    struct TriangleSet
+    {
+        std::vector<float3> vertices; // three per triangle
+        std::vector<CpuTriangle4> triangles;
+        std::vector<CpuTriangleVertices4> triangleVertices;
+
+        void add(const float3 &p0, const float3 &p1, const float3 &p2)
+        {
+            uint32_t index = static_cast<uint32_t>(vertices.size() / 3);
+            if (index % 4 == 0) {
+                triangles.push_back(CpuTriangle4());
+                triangleVertices.push_back(CpuTriangleVertices4());
+            }
+            triangles.back().set(index % 4, p0, p1, p2);
+            triangleVertices.back().set(index % 4, p0, p1, p2);
+            vertices.insert(vertices.end(), { p0, p1, p2 });
+        }
+
+        uint32_t getCount() const { return static_cast<uint32_t>(vertices.size() / 3); }
+    };
+
+    enum TriangleKernel
+    {
+        ReferenceKernel,
+        MollerTrumboreKernel,
+        WatertightKernel,
+        PacketKernel,
+        KernelCount
+    };
+
+    const char *kKernelNames[KernelCount] = { "reference", "MT 1x4", "watertight 1x4", "packet 4x1" };
+
+    // Closest hit of one ray among all triangles of the set with the given kernel, the packet kernel
+    // traces the ray in the given lane of a packet whose other lanes are zero
+    bool intersectTriangleSet(const TriangleSet &set, TriangleKernel kernel, const CpuRay &ray, uint32_t flags, CpuHit &hit, uint32_t packetLane = 0)
+    {
+        float tMax = ray.tMax;
+        bool found = false;
+        if (kernel == ReferenceKernel) {
+            for (uint32_t i = 0; i < set.getCount(); ++i) {
+                if (intersectTriangle(ray, set.vertices[i * 3], set.vertices[i * 3 + 1], set.vertices[i * 3 + 2], flags, tMax, hit)) {
+                    hit.primitiveIndex = i;
+                    tMax = hit.t;
+                    found = true;
+                }
+            }
+            return found;
+        }
+
+        CpuWatertightRay watertightRay(ray);
+        CpuRayPacket<4> packet = {};
+        packet.setRay(packetLane, ray);
+        packet.activeMask = 1u << packetLane;
+        for (uint32_t block = 0; block * 4 < set.getCount(); ++block) {
+            uint32_t laneMask = set.getCount() - block * 4 >= 4 ? 0xfu : (1u << (set.getCount() - block * 4)) - 1;
+            CpuTriangleHit4 blockHit;
+            if (kernel == PacketKernel) {
+                for (uint32_t lane = 0; lane < 4 && (laneMask >> lane) & 1; ++lane) {
+                    float packetTMax[4] = {};
+                    packetTMax[packetLane] = tMax;
+                    if (intersectTriangle(packet, 0, set.triangles[block], lane, flags, packetTMax, blockHit) & packet.activeMask) {
+                        blockHit.getHit(packetLane, hit);
+                        hit.primitiveIndex = block * 4 + lane;
+                        tMax = hit.t;
+                        found = true;
+                    }
+                }
+                continue;
+            }
+            uint32_t hits = kernel == WatertightKernel ? intersectTriangles(set.triangleVertices[block], watertightRay, flags, tMax, laneMask, blockHit)
+                                                       : intersectTriangles(set.triangles[block], ray, flags, tMax, laneMask, blockHit);
+            if (hits) {
+                uint32_t lane = blockHit.closest(hits);
+                blockHit.getHit(lane, hit);
+                hit.primitiveIndex = block * 4 + lane;
+                tMax = hit.t;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    float randomFloat(uint32_t &state)
+    {
+        state = state * 1664525u + 1013904223u;
+        return (state >> 8) * (1.0f / 16777216.0f);
+    }
+
+    float3 randomPoint(uint32_t &state, float scale)
+    {
+        float x = randomFloat(state), y = randomFloat(state), z = randomFloat(state);
+        return float3(x * 2.0f - 1.0f, y * 2.0f - 1.0f, z * 2.0f - 1.0f) * scale;
+    }
+
+    // Triangles of random size and orientation around the origin, and rays through the same region
+    // that mostly aim at one of them
+    void createRandomTriangles(uint32_t triangleCount, uint32_t rayCount, TriangleSet &set, std::vector<CpuRay> &rays)
+    {
+        uint32_t state = 7;
+        while (set.getCount() < triangleCount) {
+            float3 center = randomPoint(state, 1.0f);
+            float size = 0.02f + 0.3f * randomFloat(state);
+            float3 p0 = center + randomPoint(state, size), p1 = center + randomPoint(state, size), p2 = center + randomPoint(state, size);
+            // No slivers, their barycentrics are too ill-conditioned to compare
+            float perimeter = length(p1 - p0) + length(p2 - p1) + length(p0 - p2);
+            if (length(cross(p1 - p0, p2 - p0)) > 0.05f * perimeter * perimeter) {
+                set.add(p0, p1, p2);
+            }
+        }
+        for (uint32_t i = 0; i < rayCount; ++i) {
+            uint32_t triangle = static_cast<uint32_t>(randomFloat(state) * triangleCount) % triangleCount;
+            float a = randomFloat(state), b = randomFloat(state);
+            float3 target = set.vertices[triangle * 3] + (set.vertices[triangle * 3 + 1] - set.vertices[triangle * 3]) * (a * 1.2f - 0.1f) +
+                            (set.vertices[triangle * 3 + 2] - set.vertices[triangle * 3]) * (b * 1.2f - 0.1f) * (1.0f - a);
+            CpuRay ray;
+            ray.origin = randomPoint(state, 2.0f);
+            ray.direction = target - ray.origin;
+            ray.tMin = 0.0f;
+            ray.tMax = 1e30f;
+            rays.push_back(ray);
+        }
+    }
+
+    // Height field of size^2 quads with alternating diagonals, slightly rotated so no edge is axis aligned
+    RtGeometry::SharedPtr createGridMesh(uint32_t size)
+    {
+        auto geometry = std::make_shared<RtGeometry>();
+        float angle = 0.3f, c = std::cos(angle), s = std::sin(angle);
+        for (uint32_t j = 0; j <= size; ++j) {
+            for (uint32_t i = 0; i <= size; ++i) {
+                float x = static_cast<float>(i) - 0.5f * size, z = static_cast<float>(j) - 0.5f * size;
+                float y = 0.25f * std::sin(0.7f * i) * std::cos(1.3f * j);
+                geometry->vertices.push_back({ float3(c * x - s * z, y, s * x + c * z), float3(0.0f, 1.0f, 0.0f) });
+            }
+        }
+        for (uint32_t j = 0; j < size; ++j) {
+            for (uint32_t i = 0; i < size; ++i) {
+                uint32_t v0 = j * (size + 1) + i, v1 = v0 + 1, v2 = v0 + size + 1, v3 = v2 + 1;
+                if ((i + j) & 1) {
+                    geometry->indices.insert(geometry->indices.end(), { v0, v2, v1, v1, v2, v3 });
+                } else {
+                    geometry->indices.insert(geometry->indices.end(), { v0, v2, v3, v0, v3, v1 });
+                }
+            }
+        }
+        return geometry;
+    }
+}
+
+namespace CpuRaytracer
+{
+    // Tests per second of the triangle kernels on one thread, then what they make of a full traversal
+    int triangleBench(const Options &)
+    {
+        TriangleSet set;
+        std::vector<CpuRay> rays;
+        createRandomTriangles(256, 4096, set, rays);
+
+        printf("%u rays against %u triangles, Mtests/s on one thread\n", static_cast<uint32_t>(rays.size()), set.getCount());
+        printf("%-16s %10s %10s\n", "kernel", "Mtests/s", "hits");
+        for (int kernel = 0; kernel < KernelCount; ++kernel) {
+            double bestSeconds = 1e30;
+            uint32_t hitCount = 0;
+            for (int run = 0; run < 3; ++run) {
+                hitCount = 0;
+                auto start = std::chrono::high_resolution_clock::now();
+                if (kernel == PacketKernel) {
+                    // Four rays per packet instead of the single ray intersectTriangleSet traces
+                    for (size_t first = 0; first < rays.size(); first += 4) {
+                        CpuRayPacket<4> packet = {};
+                        float tMax[4];
+                        for (uint32_t lane = 0; lane < 4; ++lane) {
+                            packet.setRay(lane, rays[first + lane]);
+                            tMax[lane] = rays[first + lane].tMax;
+                        }
+                        uint32_t found = 0;
+                        for (uint32_t i = 0; i < set.getCount(); ++i) {
+                            CpuTriangleHit4 hit;
+                            uint32_t hits = intersectTriangle(packet, 0, set.triangles[i / 4], i % 4, CpuRayFlagNone, tMax, hit);
+                            for (uint32_t bits = hits; bits; bits &= bits - 1) {
+                                uint32_t lane = firstbitlow(bits);
+                                tMax[lane] = hit.t[lane];
+                            }
+                            found |= hits;
+                        }
+                        hitCount += countbits(found);
+                    }
+                } else {
+                    for (const CpuRay &ray : rays) {
+                        CpuHit hit;
+                        hitCount += intersectTriangleSet(set, static_cast<TriangleKernel>(kernel), ray, CpuRayFlagNone, hit) ? 1 : 0;
+                    }
+                }
+                bestSeconds = (std::min)(bestSeconds, secondsSince(start));
+            }
+            printf("%-16s %10.1f %10u\n", kKernelNames[kernel], rays.size() * set.getCount() / bestSeconds * 1e-6, hitCount);
+        }
+
+        std::vector<std::pair<std::string, RtGeometry::SharedPtr>> meshes = {
+            { "susanne.obj", RtGeometry::import("assets/models/susanne.obj") },
+            { "cornell.obj", RtGeometry::import("assets/models/cornell.obj") },
+            { "synthetic 2M", createSyntheticMesh(1024) }
+        };
+        struct Config { const char *name; CpuBvhLayout layout; CpuTriangleTest test; };
+        const Config configs[] = {
+            { "binary, reference", CpuBvhLayout::Binary, CpuTriangleTest::MollerTrumbore },
+            { "BVH4, MT", CpuBvhLayout::Wide4, CpuTriangleTest::MollerTrumbore },
+            { "BVH4, watertight", CpuBvhLayout::Wide4, CpuTriangleTest::Watertight },
+            { "BVH8, MT", CpuBvhLayout::Wide8, CpuTriangleTest::MollerTrumbore },
+            { "BVH8, watertight", CpuBvhLayout::Wide8, CpuTriangleTest::Watertight },
+        };
+        printf("\n%-14s %-18s %12s %14s %14s\n", "mesh", "layout, test", "triangle KB", "camera Mrays/s", "random Mrays/s");
+        for (const auto &mesh : meshes) {
+            auto model = CpuModel::create(mesh.second);
+            for (const Config &config : configs) {
+                model->build(CpuBvh::BuildOptions(), config.layout, config.test);
+                printf("%-14s %-18s %12.1f %14.2f %14.2f\n", mesh.first.c_str(), config.name, model->getTriangleMemoryUsage() / 1024.0,
+                       measureTraversal(*model, false), measureTraversal(*model, true));
+            }
+        }
+        return 0;
+    }
+
+    // Robustness of the triangle kernels, exits with an error if a check fails:
+    //  - rays aimed exactly at the shared vertices and edges of a closed grid, which the watertight test
+    //    must never let through, on its own and behind the wide hierarchies
+    //  - random rays, where the wide kernels must agree with the reference on hits, t and barycentrics
+    //  - the barycentrics must reconstruct the hit point and the culling flags must follow frontFace
+    int triangleTest(const Options &)
+    {
+        bool passed = true;
+
+        // Shared vertices and edges
+        {
+            const uint32_t gridSize = 16;
+            RtGeometry::SharedPtr grid = createGridMesh(gridSize);
+            TriangleSet set;
+            for (uint32_t i = 0; i < grid->getTriangleCount(); ++i) {
+                set.add(grid->vertices[grid->indices[i * 3]].position, grid->vertices[grid->indices[i * 3 + 1]].position, grid->vertices[grid->indices[i * 3 + 2]].position);
+            }
+
+            // Interior vertices, the midpoints of the edges around them and the vertices' own positions
+            // nudged by one ulp
+            std::vector<float3> targets;
+            for (uint32_t j = 1; j < gridSize; ++j) {
+                for (uint32_t i = 1; i < gridSize; ++i) {
+                    const float3 &p = grid->vertices[j * (gridSize + 1) + i].position;
+                    targets.push_back(p);
+                    targets.push_back((p + grid->vertices[j * (gridSize + 1) + i + 1].position) * 0.5f);
+                    targets.push_back((p + grid->vertices[(j + 1) * (gridSize + 1) + i].position) * 0.5f);
+                    targets.push_back((p + grid->vertices[(j + 1) * (gridSize + 1) + i + 1].position) * 0.5f);
+                    targets.push_back(float3(std::nextafter(p.x, 1e30f), p.y, std::nextafter(p.z, -1e30f)));
+                }
+            }
+
+            std::vector<CpuRay> rays;
+            uint32_t state = 3;
+            for (const float3 &target : targets) {
+                for (int i = 0; i < 8; ++i) {
+                    CpuRay ray;
+                    ray.origin = target + float3(randomFloat(state) * 8.0f - 4.0f, 2.0f + randomFloat(state) * 6.0f, randomFloat(state) * 8.0f - 4.0f);
+                    ray.direction = target - ray.origin;
+                    ray.tMin = 0.0f;
+                    ray.tMax = 1e30f;
+                    rays.push_back(ray);
+                    // The same ray from below, which sees the back faces
+                    ray.origin = target * 2.0f - ray.origin;
+                    ray.direction = target - ray.origin;
+                    rays.push_back(ray);
+                }
+            }
+
+            printf("%u rays through shared vertices and edges of a %ux%u grid\n", static_cast<uint32_t>(rays.size()), gridSize, gridSize);
+            printf("%-26s %10s\n", "kernel", "misses");
+            for (int kernel = 0; kernel < KernelCount; ++kernel) {
+                uint32_t misses = 0;
+                for (const CpuRay &ray : rays) {
+                    CpuHit hit;
+                    misses += intersectTriangleSet(set, static_cast<TriangleKernel>(kernel), ray, CpuRayFlagNone, hit) ? 0 : 1;
+                }
+                printf("%-26s %10u\n", kKernelNames[kernel], misses);
+                passed &= kernel != WatertightKernel || misses == 0;
+            }
+
+            struct Config { const char *name; CpuBvhLayout layout; };
+            const Config configs[] = { { "BVH4, watertight", CpuBvhLayout::Wide4 }, { "BVH8, watertight", CpuBvhLayout::Wide8 } };
+            auto model = CpuModel::create(grid);
+            for (const Config &config : configs) {
+                model->build(CpuBvh::BuildOptions(), config.layout, CpuTriangleTest::Watertight);
+                uint32_t misses = 0;
+                for (const CpuRay &ray : rays) {
+                    CpuHit hit;
+                    misses += model->intersect(ray, CpuRayFlagNone, hit) ? 0 : 1;
+                }
+                printf("%-26s %10u\n", config.name, misses);
+                passed &= misses == 0;
+            }
+        }
+
+        // Agreement with the reference. Rays that graze an edge may fall on either side of it.
+        {
+            TriangleSet set;
+            std::vector<CpuRay> rays;
+            createRandomTriangles(64, 20000, set, rays);
+            const uint32_t flagSets[] = { CpuRayFlagNone, CpuRayFlagCullBackFacingTriangles, CpuRayFlagCullFrontFacingTriangles };
+
+            printf("\n%u random rays against %u triangles, each with no culling, back face and front face culling\n", static_cast<uint32_t>(rays.size()), set.getCount());
+            printf("%-16s %10s %10s %10s %10s\n", "kernel", "hits", "mismatches", "max dt", "max dbary");
+            for (int kernel = MollerTrumboreKernel; kernel < KernelCount; ++kernel) {
+                uint32_t hitCount = 0, mismatches = 0;
+                float maxDt = 0.0f, maxDbary = 0.0f;
+                for (uint32_t flags : flagSets) {
+                    for (size_t i = 0; i < rays.size(); ++i) {
+                        const CpuRay &ray = rays[i];
+                        CpuHit reference, hit;
+                        bool referenceFound = intersectTriangleSet(set, ReferenceKernel, ray, flags, reference);
+                        bool found = intersectTriangleSet(set, static_cast<TriangleKernel>(kernel), ray, flags, hit, static_cast<uint32_t>(i % 4));
+                        hitCount += found ? 1 : 0;
+                        if (found != referenceFound || (found && hit.primitiveIndex != reference.primitiveIndex)) {
+                            ++mismatches;
+                            continue;
+                        }
+                        if (!found) {
+                            continue;
+                        }
+
+                        // The barycentrics weight the second and third vertex
+                        uint32_t p = hit.primitiveIndex * 3;
+                        float3 normal = cross(set.vertices[p + 1] - set.vertices[p], set.vertices[p + 2] - set.vertices[p]);
+                        // Grazing hits are too ill-conditioned for the kernels to agree on
+                        if (std::fabs(dot(normal, ray.direction)) > 0.01f * length(normal) * length(ray.direction)) {
+                            maxDt = (std::max)(maxDt, std::fabs(hit.t - reference.t) / reference.t);
+                            maxDbary = (std::max)(maxDbary, (std::max)(std::fabs(hit.bary.x - reference.bary.x), std::fabs(hit.bary.y - reference.bary.y)));
+                        }
+                        float3 point = ray.origin + ray.direction * hit.t;
+                        float3 interpolated = set.vertices[p] * (1.0f - hit.bary.x - hit.bary.y) + set.vertices[p + 1] * hit.bary.x + set.vertices[p + 2] * hit.bary.y;
+                        bool culled = ((flags & CpuRayFlagCullBackFacingTriangles) && !hit.frontFace) || ((flags & CpuRayFlagCullFrontFacingTriangles) && hit.frontFace);
+                        if (length(point - interpolated) > 1e-4f || hit.frontFace != reference.frontFace || culled) {
+                            ++mismatches;
+                        }
+                    }
+                }
+                printf("%-16s %10u %10u %10.2e %10.2e\n", kKernelNames[kernel], hitCount, mismatches, maxDt, maxDbary);
+                // Rays aimed at the edges of random triangles: a handful may fall on the other side
+                passed &= mismatches * 1000 <= rays.size() * 3 && maxDt < 1e-4f && maxDbary < 1e-3f;
+            }
+        }
+
+        printf("\n%s\n", passed ? "All triangle tests passed" : "Triangle tests FAILED");
+        return passed ? 0 : 1;
+    }
+}
@@ -0,0 +1,115 @@
+#include "CpuRaytracer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace DXRFramework;
+using namespace DXRFramework::CpuMath;
+
+namespace CpuRaytracer
+{
+    // Time per sample of the recursive shaders against the wavefront stages, on the same seeds. Both
+    // trace the same rays and only sum the terms in a different order, so the images must agree.
+    int wavefrontBench(const Options &options)
+    {
+        const uint32_t size = 256;
+        const uint32_t samples = 8;
+        auto context = CpuContext::create(options.threads);
+
+        struct BenchScene
+        {
+            const char *name;
+            CpuScene::SharedPtr scene;
+            std::vector<MaterialParams> materials;
+            CpuTexture::SharedPtr environment;
+        };
+        std::vector<BenchScene> scenes;
+        double buildSeconds;
+        scenes.push_back({ "susanne, environment", loadScene({ "assets/models/susanne.obj" }, false, buildSeconds), { defaultMaterial() },
+                           loadEnvironment("assets/textures/CathedralRadiance.dds") });
+        scenes.push_back({ "cornell", loadScene({ "assets/models/cornell.obj" }, false, buildSeconds), { defaultMaterial() }, nullptr });
+
+        // Diffuse, glossy and mirror instances side by side, so neighbouring pixels need different shading
+        auto susanne = CpuModel::create("assets/models/susanne.obj");
+        auto grid = CpuScene::create();
+        std::vector<MaterialParams> materials;
+        for (int i = 0; i < 16; ++i) {
+            float3x4 transform = float3x4::identity();
+            transform.m[0][3] = 2.5f * (i % 4);
+            transform.m[1][3] = 2.5f * (i / 4);
+            grid->addModel(susanne, transform);
+
+            MaterialParams material = defaultMaterial();
+            material.type = i % 3;
+            material.albedo = XMFLOAT4(0.2f + 0.2f * (i % 4), 0.8f - 0.2f * (i / 4), 0.5f, 1.0f);
+            material.roughness = material.type == 2 ? 0.0f : 0.5f;
+            material.reflectivity = material.type == 0 ? 0.0f : 0.9f;
+            materials.push_back(material);
+        }
+        grid->build(ProgressiveRaytracing::getHitProgramCount());
+        scenes.push_back({ "mixed materials x16", grid, materials, loadEnvironment("assets/textures/CathedralRadiance.dds") });
+
+        printf("%u threads, %ux%u, %u samples, times in ms per sample\n", context->getThreadCount(), size, size, samples);
+        printf("%-21s %-10s %9s %8s %10s %8s %8s %8s %8s %8s\n", "scene", "mode", "sample", "Mrays/s", "rays", "generate", "extend", "shade", "shadow", "resolve");
+        bool passed = true;
+        for (const BenchScene &benchScene : scenes) {
+            CpuTexture::SharedPtr images[2];
+            for (int wavefront = 0; wavefront < 2; ++wavefront) {
+                ProgressiveRaytracing pipeline(context, benchScene.scene, benchScene.materials);
+                pipeline.resize(size, size);
+                pipeline.setCamera(frameScene(benchScene.scene->getBounds()));
+                pipeline.setEnvironment(benchScene.environment);
+                pipeline.setWavefront(wavefront != 0);
+
+                uint64_t rays = 0;
+                double seconds = 0.0;
+                WavefrontRaytracing::Stats stages;
+                for (uint32_t i = 0; i < samples; ++i) {
+                    pipeline.render();
+                    if (wavefront) {
+                        const WavefrontRaytracing::Stats &stats = pipeline.getWavefront()->getLastStats();
+                        rays += stats.rays;
+                        seconds += stats.getSeconds();
+                        stages.generateSeconds += stats.generateSeconds;
+                        stages.extendSeconds += stats.extendSeconds;
+                        stages.shadeSeconds += stats.shadeSeconds;
+                        stages.shadowSeconds += stats.shadowSeconds;
+                        stages.resolveSeconds += stats.resolveSeconds;
+                    } else {
+                        rays += context->getLastDispatchStats().rays;
+                        seconds += context->getLastDispatchStats().seconds;
+                    }
+                }
+
+                printf("%-21s %-10s %9.2f %8.2f %10llu", benchScene.name, wavefront ? "wavefront" : "recursive", seconds / samples * 1000.0,
+                       rays / seconds * 1e-6, static_cast<unsigned long long>(rays));
+                if (wavefront) {
+                    printf(" %8.2f %8.2f %8.2f %8.2f %8.2f\n", stages.generateSeconds / samples * 1000.0, stages.extendSeconds / samples * 1000.0,
+                           stages.shadeSeconds / samples * 1000.0, stages.shadowSeconds / samples * 1000.0, stages.resolveSeconds / samples * 1000.0);
+                } else {
+                    printf("\n");
+                }
+
+                images[wavefront] = CpuTexture::create(size, size);
+                memcpy(images[wavefront]->getData(), pipeline.getOutput()->getData(), size_t(size) * size * sizeof(float4));
+            }
+
+            // Differences relative to the brighter of the two values, from the order of the sums only
+            double maxDifference = 0.0, meanDifference = 0.0;
+            for (uint32_t y = 0; y < size; ++y) {
+                for (uint32_t x = 0; x < size; ++x) {
+                    float3 a = images[0]->load(x, y).rgb(), b = images[1]->load(x, y).rgb();
+                    for (int i = 0; i < 3; ++i) {
+                        double difference = std::fabs(a[i] - b[i]) / (std::max)(1.0f, (std::max)(std::fabs(a[i]), std::fabs(b[i])));
+                        maxDifference = (std::max)(maxDifference, difference);
+                        meanDifference += difference / (size * size * 3);
+                    }
+                }
+            }
+            bool match = maxDifference < 1e-3;
+            printf("%-21s max difference %.2e, mean %.2e%s\n", "", maxDifference, meanDifference, match ? "" : "  FAILED");
+            passed &= match;
+        }
+        return passed ? 0 : 1;
+    }
+}
@@ -0,0 +1,467 @@
+#include "WavefrontRaytracing.h"
+#include "RaytracingUtils.h"
+#include "AdaptiveSampling.h"
+#include "EnvironmentSampling.h"
+#include "Sampling.h"
+#include <chrono>
+#include <cmath>
+
+using namespace DXRFramework;
+using namespace RaytracingUtils;
+using namespace AdaptiveSampling;
+using namespace EnvironmentSampling;
+using namespace Sampling;
+
+namespace
+{
+    // RaytracingCommon.hlsli
+    const float RAY_MAX_T = 1.0e+38f;
+    const float RAY_EPSILON = 0.0001f;
+
+    // Work items per range handed to the thread pool
+    const uint32_t kGrainSize = 256;
+    const uint32_t kCompactionGrainSize = 4096;
+
+    // Materials are shaded grouped by MaterialParams.type, misses first
+    const uint32_t kMaterialKeyCount = 4;
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    double secondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    float3 sampleEnvironment(const CpuTexture *environment, const RtEnvironmentPrefilter *prefilter, const float3 &direction, float lod, float strength)
+    {
+        float4 envSample(1.0f);
+        if (prefilter && lod > 0.0f) {
+            envSample = prefilter->sample(direction, lod);
+        } else if (environment && environment->isCubemap()) {
+            envSample = environment->sampleCube(direction);
+        } else if (environment) {
+            envSample = environment->sample(wsVectorToLatLong(direction));
+        }
+        return envSample.rgb() * strength;
+    }
+}
+
+void WavefrontRaytracing::RayQueue::reserve(size_t capacity)
+{
+    if (target.size() < capacity) {
+        for (auto *component : { &originX, &originY, &originZ, &directionX, &directionY, &directionZ, &tMin, &tMax }) {
+            component->resize(capacity);
+        }
+        target.resize(capacity);
+    }
+}
+
+CpuRay WavefrontRaytracing::RayQueue::getRay(uint32_t index) const
+{
+    CpuRay ray;
+    ray.origin = float3(originX[index], originY[index], originZ[index]);
+    ray.direction = float3(directionX[index], directionY[index], directionZ[index]);
+    ray.tMin = tMin[index];
+    ray.tMax = tMax[index];
+    return ray;
+}
+
+void WavefrontRaytracing::RayQueue::setRay(uint32_t index, const CpuRay &ray, uint32_t rayTarget)
+{
+    originX[index] = ray.origin.x;
+    originY[index] = ray.origin.y;
+    originZ[index] = ray.origin.z;
+    directionX[index] = ray.direction.x;
+    directionY[index] = ray.direction.y;
+    directionZ[index] = ray.direction.z;
+    tMin[index] = ray.tMin;
+    tMax[index] = ray.tMax;
+    target[index] = rayTarget;
+}
+
+WavefrontRaytracing::WavefrontRaytracing(CpuContext::SharedPtr context, CpuScene::SharedPtr scene, const std::vector<MaterialParams> &materials)
+    : mContext(context), mScene(scene), mMaterials(materials), mWidth(0), mHeight(0), mPixelCount(0)
+{
+}
+
+bool WavefrontRaytracing::supports(const DebugOptions &options)
+{
+    return !options.showIndirectDiffuseOnly && !options.showIndirectSpecularOnly && !options.showAmbientOcclusionOnly &&
+           !options.showGBufferAlbedoOnly && !options.showDirectLightingOnly && !options.showFresnelTerm &&
+           options.maxBounces == 1 && (!options.russianRoulette || options.russianRouletteDepth > 1) && !options.pathLengthHistogram &&
+           !options.manyLightSampling;
+}
+
+uint32_t WavefrontRaytracing::render(const PerFrameConstants &constants, const CpuTexture *environment, const RtEnvironmentSampler *environmentSampler,
+                                     const RtEnvironmentPrefilter *environmentPrefilter, CpuTileBuffer &output, CpuTileBuffer &moments, const CpuDispatchOptions &options)
+{
+    mStats = Stats();
+    mWidth = output.getWidth();
+    mHeight = output.getHeight();
+    uint32_t tilesX = (output.getWidth() + CpuContext::kTileSize - 1) / CpuContext::kTileSize;
+    uint32_t tilesY = (output.getHeight() + CpuContext::kTileSize - 1) / CpuContext::kTileSize;
+    uint32_t tileCount = tilesX * tilesY;
+    if (constants.cameraParams.accumCount >= constants.options.maxIterations) {
+        return tileCount;
+    }
+    const std::vector<uint32_t> &tileOrder = mContext->getTileOrder(tilesX, tilesY);
+
+    auto start = Clock::now();
+    uint32_t tile = (std::min)(options.firstTile, tileCount);
+    while (tile < tileCount) {
+        if ((options.timeBudget > 0.0 && secondsSince(start) >= options.timeBudget) || (options.cancel && options.cancel())) {
+            break;
+        }
+        uint32_t endTile = (std::min)(tile + kTilesPerWave, tileCount);
+
+        auto stageStart = Clock::now();
+        generate(constants, tileOrder, options.tileMask, tile, endTile);
+        mStats.generateSeconds += secondsSince(stageStart);
+
+        // Camera rays, then the indirect diffuse and reflection rays of the camera hits
+        for (uint32_t depth = 0; depth < 2; ++depth) {
+            stageStart = Clock::now();
+            extend(depth == 0 ? CpuRayFlagCullBackFacingTriangles : CpuRayFlagNone);
+            mStats.extendSeconds += secondsSince(stageStart);
+
+            stageStart = Clock::now();
+            sortByMaterial();
+            shade(constants, environment, environmentSampler, environmentPrefilter, depth);
+            if (depth == 0) {
+                compact(mExtensionSlots, mPixelCount * kPathsPerPixel, mExtendQueue);
+            }
+            mStats.shadeSeconds += secondsSince(stageStart);
+        }
+
+        stageStart = Clock::now();
+        compact(mShadowSlots, mPixelCount * kPathsPerPixel * kShadowRaysPerPath, mShadowQueue);
+        traceShadows();
+        mStats.shadowSeconds += secondsSince(stageStart);
+
+        stageStart = Clock::now();
+        resolve(constants, output, moments);
+        mStats.resolveSeconds += secondsSince(stageStart);
+
+        tile = endTile;
+    }
+    return tile;
+}
+
+void WavefrontRaytracing::generate(const PerFrameConstants &constants, const std::vector<uint32_t> &tileOrder, const std::vector<uint8_t> &tileMask,
+                                   uint32_t firstTile, uint32_t endTile)
+{
+    const CameraParams &camera = constants.cameraParams;
+    uint32_t tilesX = (mWidth + CpuContext::kTileSize - 1) / CpuContext::kTileSize;
+
+    // Pixels tile by tile, so neighbouring queue entries start as coherent camera rays
+    mPixels.clear();
+    for (uint32_t t = firstTile; t < endTile; ++t) {
+        if (!tileMask.empty() && !tileMask[tileOrder[t]]) {
+            continue;
+        }
+        uint32_t x0 = tileOrder[t] % tilesX * CpuContext::kTileSize;
+        uint32_t y0 = tileOrder[t] / tilesX * CpuContext::kTileSize;
+        uint32_t x1 = (std::min)(x0 + CpuContext::kTileSize, mWidth);
+        uint32_t y1 = (std::min)(y0 + CpuContext::kTileSize, mHeight);
+        for (uint32_t y = y0; y < y1; ++y) {
+            for (uint32_t x = x0; x < x1; ++x) {
+                mPixels.push_back(uint2(x, y));
+            }
+        }
+    }
+    mPixelCount = static_cast<uint32_t>(mPixels.size());
+
+    uint32_t pathCount = mPixelCount * kPathsPerPixel;
+    uint32_t shadowCount = pathCount * kShadowRaysPerPath;
+    mPathWeights.resize(pathCount);
+    mPathRadiance.resize(pathCount);
+    mPathMisPdf.resize(pathCount);
+    mPathLobeRoughness.resize(pathCount);
+    mExtensionSlots.rays.resize(pathCount);
+    mExtensionSlots.valid.resize(pathCount);
+    mShadowSlots.rays.resize(shadowCount);
+    mShadowSlots.valid.resize(shadowCount);
+    mShadowWeights.resize(shadowCount);
+    mShadowVisible.resize(shadowCount);
+    mExtendQueue.reserve(pathCount);
+    mShadowQueue.reserve(shadowCount);
+    mHits.resize(pathCount);
+    mHitFound.resize(pathCount);
+    mShadeOrder.resize(pathCount);
+
+    float2 jitter = float2(camera.jitters.x, camera.jitters.y) * 30.0f;
+    float3 origin = float3(camera.worldEyePos) + float3(jitter.x, jitter.y, 0.0f);
+
+    mContext->parallelFor(mPixelCount, kGrainSize, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            uint32_t path = i * kPathsPerPixel;
+            for (uint32_t branch = 0; branch < kPathsPerPixel; ++branch) {
+                mPathWeights[path + branch] = float3(branch == CameraPath ? 1.0f : 0.0f);
+                mPathRadiance[path + branch] = float3(0.0f);
+                mPathMisPdf[path + branch] = -1.0f;
+                mPathLobeRoughness[path + branch] = 0.0f;
+                mExtensionSlots.valid[path + branch] = 0;
+                for (uint32_t k = 0; k < kShadowRaysPerPath; ++k) {
+                    mShadowSlots.valid[(path + branch) * kShadowRaysPerPath + k] = 0;
+                }
+            }
+
+            // Same as RayGen
+            uint2 launchIndex = mPixels[i];
+            float2 d((launchIndex.x + 0.5f) / mWidth * 2.0f - 1.0f, (launchIndex.y + 0.5f) / mHeight * 2.0f - 1.0f);
+            CpuRay ray;
+            ray.origin = origin;
+            ray.direction = normalize(d.x * float3(camera.U) + (-d.y) * float3(camera.V) + float3(camera.W));
+            ray.tMin = 0.0f;
+            ray.tMax = RAY_MAX_T;
+            mExtendQueue.setRay(i, ray, path + CameraPath);
+        }
+    });
+    mExtendQueue.size = mPixelCount;
+}
+
+void WavefrontRaytracing::extend(uint32_t rayFlags)
+{
+    mContext->parallelFor(mExtendQueue.size, kGrainSize, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            mHitFound[i] = mScene->traceRay(mExtendQueue.getRay(i), rayFlags, mHits[i]) ? 1 : 0;
+        }
+    });
+    mStats.rays += mExtendQueue.size;
+}
+
+void WavefrontRaytracing::sortByMaterial()
+{
+    // Counting sort, stable so rays of one material keep their screen order
+    auto materialKey = [&](uint32_t i) -> uint32_t {
+        if (!mHitFound[i]) {
+            return 0;
+        }
+        const MaterialParams &material = mMaterials[mHits[i].instanceIndex % mMaterials.size()];
+        return 1 + (std::min)(material.type, kMaterialKeyCount - 2);
+    };
+
+    uint32_t offsets[kMaterialKeyCount] = {};
+    for (uint32_t i = 0; i < mExtendQueue.size; ++i) {
+        ++offsets[materialKey(i)];
+    }
+    for (uint32_t key = 0, sum = 0; key < kMaterialKeyCount; ++key) {
+        uint32_t count = offsets[key];
+        offsets[key] = sum;
+        sum += count;
+    }
+    for (uint32_t i = 0; i < mExtendQueue.size; ++i) {
+        mShadeOrder[offsets[materialKey(i)]++] = i;
+    }
+}
+
+void WavefrontRaytracing::shade(const PerFrameConstants &constants, const CpuTexture *environment, const RtEnvironmentSampler *environmentSampler,
+                                const RtEnvironmentPrefilter *environmentPrefilter, uint32_t depth)
+{
+    bool environmentSampling = constants.options.environmentImportanceSampling && environmentSampler && constants.environmentSampling.tableWidth > 0;
+
+    mContext->parallelFor(mExtendQueue.size, kGrainSize, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t o = begin; o < end; ++o) {
+            uint32_t index = mShadeOrder[o];
+            uint32_t path = mExtendQueue.target[index];
+            CpuRay ray = mExtendQueue.getRay(index);
+
+            if (!mHitFound[index]) {
+                float lod = environmentLod(constants, mPathLobeRoughness[path], depth);
+                float3 radiance = sampleEnvironment(environment, environmentPrefilter, ray.direction, lod, constants.options.environmentStrength);
+                if (mPathMisPdf[path] >= 0.0f) {
+                    radiance = radiance * powerHeuristic(mPathMisPdf[path], environmentSampler->evaluatePdf(ray.direction));
+                }
+                mPathRadiance[path] += radiance;
+                continue;
+            }
+
+            // PrimaryClosestHit
+            const CpuHit &hit = mHits[index];
+            const CpuScene::Instance &instance = mScene->getInstance(hit.instanceIndex);
+            const MaterialParams &material = mMaterials[hit.instanceIndex % mMaterials.size()];
+            const RtGeometry &geometry = *instance.model->getGeometry();
+
+            float3 barycentrics(1.0f - hit.bary.x - hit.bary.y, hit.bary.x, hit.bary.y);
+            float3 vertNormal(0.0f);
+            for (int i = 0; i < 3; ++i) {
+                vertNormal += geometry.vertices[geometry.indices[hit.primitiveIndex * 3 + i]].normal * barycentrics[i];
+            }
+            float3 normal = normalize(instance.objectToWorld.transformVector(vertNormal));
+            float3 position = ray.origin + hit.t * ray.direction;
+
+            // shade(), with the traced terms deferred to the shadow and extension rays
+            uint2 pixIdx = mPixels[path / kPathsPerPixel];
+            SampleGenerator sampleGenerator = initSampleGenerator(constants.options.sampleSequence, pixIdx, uint2(mWidth, mHeight), constants.cameraParams.frameCount,
+                                                                  constants.cameraParams.accumCount, SAMPLE_DIMENSION_FIRST_BOUNCE + depth * SAMPLE_DIMENSIONS_PER_BOUNCE);
+
+            float3 albedo(material.albedo);
+            mPathRadiance[path] += float3(material.emissive) * material.emissive.w;
+
+            auto addShadowRay = [&](uint32_t k, const float3 &L, float maxT, const float3 &lightContrib) {
+                uint32_t slot = path * kShadowRaysPerPath + k;
+                mShadowSlots.rays[slot] = { position, RAY_EPSILON, L, maxT };
+                mShadowSlots.valid[slot] = 1;
+                mShadowWeights[slot] = albedo * lightContrib / M_PI_F;
+            };
+            auto addDirectionalLight = [&](uint32_t k, float scale) {
+                const DirectionalLightParams &light = constants.directionalLight;
+                float3 L = normalize(-float3(light.forwardDir));
+                float NoL = saturate(dot(normal, L));
+                addShadowRay(k, L, RAY_MAX_T, float3(light.color) * light.color.w * NoL * scale);
+            };
+            auto addPointLight = [&](uint32_t k, float scale) {
+                const PointLightParams &light = constants.pointLight;
+                float3 lightPath = float3(light.worldPos) - position;
+                float lightDistance = length(lightPath);
+                float3 L = normalize(lightPath);
+                float NoL = saturate(dot(normal, L));
+                float falloff = 1.0f / (2.0f * M_PI_F * lightDistance * lightDistance);
+                addShadowRay(k, L, lightDistance - RAY_EPSILON, float3(light.color) * light.color.w * NoL * falloff * scale);
+            };
+
+            if (constants.options.debug == 2) {
+                const int numLights = 2;
+                if (nextSample1D(sampleGenerator) < 0.5f) {
+                    addDirectionalLight(0, float(numLights));
+                } else {
+                    addPointLight(1, float(numLights));
+                }
+            } else {
+                addDirectionalLight(0, 1.0f);
+                addPointLight(1, 1.0f);
+            }
+
+            // Secondary rays leave from camera hits only, supports() requires a single bounce
+            if (depth > 0) {
+                continue;
+            }
+            const float3 &weight = mPathWeights[path];
+
+            if (!constants.options.noIndirectDiffuse) {
+                float3 sampleDir;
+                float pdf;
+                float factor;
+                if (constants.options.cosineHemisphereSampling) {
+                    sampleDir = getCosHemisphereSample(nextSample2D(sampleGenerator), normal);
+                    pdf = saturate(dot(normal, sampleDir)) / M_PI_F;
+                    factor = M_PI_F; // term canceled
+                } else {
+                    sampleDir = getUniformHemisphereSample(nextSample2D(sampleGenerator), normal);
+                    pdf = 1.0f / (2.0f * M_PI_F);
+                    factor = saturate(dot(normal, sampleDir)) / pdf;
+                }
+                uint32_t child = path + IndirectDiffusePath;
+                mExtensionSlots.rays[child] = { position, RAY_EPSILON, sampleDir, RAY_MAX_T };
+                mExtensionSlots.valid[child] = 1;
+                mPathWeights[child] = weight * albedo * factor / M_PI_F;
+
+                // The environment sample is a shadow ray of this path, weighted like the recursive version
+                if (environmentSampling) {
+                    mPathMisPdf[child] = pdf;
+
+                    float envPdf;
+                    float3 envDir = environmentSampler->sample(nextSample2D(sampleGenerator), envPdf);
+                    float NoL = dot(normal, envDir);
+                    if (NoL > 0.0f && envPdf > 0.0f) {
+                        float bsdfPdf = constants.options.cosineHemisphereSampling ? NoL / M_PI_F : 1.0f / (2.0f * M_PI_F);
+                        float3 envRadiance = sampleEnvironment(environment, nullptr, envDir, 0.0f, constants.options.environmentStrength);
+                        addShadowRay(2, envDir, RAY_MAX_T, envRadiance * (NoL / envPdf * powerHeuristic(envPdf, bsdfPdf)));
+                    }
+                }
+            }
+
+            if ((material.type == 1 || material.type == 2) && material.reflectivity > 0.001f) {
+                float exponent = std::exp((1.0f - material.roughness) * 12.0f);
+                float pdf;
+                float brdf;
+                float3 mirrorDir = reflect(ray.direction, normal);
+                float3 sampleDir = samplePhongLobe(nextSample2D(sampleGenerator), mirrorDir, exponent, pdf, brdf);
+                float3 fresnel = FresnelReflectanceSchlick(ray.direction, normal, float3(material.specular));
+
+                uint32_t child = path + ReflectionPath;
+                mExtensionSlots.rays[child] = { position, RAY_EPSILON, sampleDir, RAY_MAX_T };
+                mExtensionSlots.valid[child] = 1;
+                mPathWeights[child] = weight * material.reflectivity * (pdf > 0.0f ? brdf / pdf : 0.0f) * fresnel;
+                mPathLobeRoughness[child] = phongLobeEnvironmentRoughness(exponent);
+            }
+        }
+    });
+}
+
+void WavefrontRaytracing::compact(const RaySlots &slots, uint32_t slotCount, RayQueue &queue)
+{
+    // Count per chunk, scan the counts, then every chunk writes its rays from its offset on
+    uint32_t chunkCount = (slotCount + kCompactionGrainSize - 1) / kCompactionGrainSize;
+    mCompactionOffsets.assign(chunkCount + 1, 0);
+
+    mContext->parallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t chunk = begin; chunk < end; ++chunk) {
+            uint32_t slotEnd = (std::min)((chunk + 1) * kCompactionGrainSize, slotCount);
+            uint32_t count = 0;
+            for (uint32_t slot = chunk * kCompactionGrainSize; slot < slotEnd; ++slot) {
+                count += slots.valid[slot];
+            }
+            mCompactionOffsets[chunk + 1] = count;
+        }
+    });
+    for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+        mCompactionOffsets[chunk + 1] += mCompactionOffsets[chunk];
+    }
+
+    mContext->parallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t chunk = begin; chunk < end; ++chunk) {
+            uint32_t slotEnd = (std::min)((chunk + 1) * kCompactionGrainSize, slotCount);
+            uint32_t index = mCompactionOffsets[chunk];
+            for (uint32_t slot = chunk * kCompactionGrainSize; slot < slotEnd; ++slot) {
+                if (slots.valid[slot]) {
+                    queue.setRay(index++, slots.rays[slot], slot);
+                }
+            }
+        }
+    });
+    queue.size = mCompactionOffsets[chunkCount];
+}
+
+void WavefrontRaytracing::traceShadows()
+{
+    uint32_t rayFlags = CpuRayFlagAcceptFirstHitAndEndSearch | CpuRayFlagSkipClosestHitShader;
+    mContext->parallelFor(mShadowQueue.size, kGrainSize, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            CpuHit hit;
+            mShadowVisible[mShadowQueue.target[i]] = mScene->traceRay(mShadowQueue.getRay(i), rayFlags, hit) ? 0 : 1;
+        }
+    });
+    mStats.rays += mShadowQueue.size;
+}
+
+void WavefrontRaytracing::resolve(const PerFrameConstants &constants, CpuTileBuffer &output, CpuTileBuffer &moments)
+{
+    uint32_t accumCount = constants.cameraParams.accumCount;
+    mContext->parallelFor(mPixelCount, kGrainSize, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            float3 color(0.0f);
+            for (uint32_t path = i * kPathsPerPixel; path < (i + 1) * kPathsPerPixel; ++path) {
+                float3 radiance = mPathRadiance[path];
+                for (uint32_t slot = path * kShadowRaysPerPath; slot < (path + 1) * kShadowRaysPerPath; ++slot) {
+                    if (mShadowSlots.valid[slot] && mShadowVisible[slot]) {
+                        radiance += mShadowWeights[slot];
+                    }
+                }
+                color += mPathWeights[path] * radiance;
+            }
+
+            // Same as RayGen
+            float4 &pixelMoments = moments.at(mPixels[i].x, mPixels[i].y);
+            if (accumCount == 0) {
+                pixelMoments = float4(0.0f);
+            }
+            float sampleCount = pixelMoments.z;
+
+            float4 &out = output.at(mPixels[i].x, mPixels[i].y);
+            float4 curColor((max)(color, 0.0f), 1.0f);
+            out = (out * sampleCount + curColor) / (sampleCount + 1.0f);
+            pixelMoments = accumulateMoments(pixelMoments, curColor.rgb());
+        }
+    });
+}
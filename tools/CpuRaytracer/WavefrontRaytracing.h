@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Cpu/CpuContext.h"
+#include "Cpu/CpuTexture.h"
+#include "RaytracingHlslCompat.h"
+#include "RtEnvironmentPrefilter.h"
+#include "RtEnvironmentSampler.h"
+
+// Wavefront formulation of ProgressiveRaytracing.hlsl. Instead of tracing secondary and shadow rays
+// recursively from the closest hit shader, a wave of pixels goes through separate stages: camera ray
+// generation, extension of every live path, shading grouped by MaterialParams.type, and one pass over
+// all shadow rays at the end. Each stage runs over a compacted queue of rays stored as structure of
+// arrays. The shading is linear in the traced results, so every ray carries the weight of its
+// contribution to the pixel and the sum is formed once its shadow rays are resolved. Sample sequences
+// and seeds are those of the recursive shaders, only the order of the floating point sums differs.
+class WavefrontRaytracing
+{
+public:
+    struct Stats
+    {
+        uint64_t rays = 0;
+        double generateSeconds = 0.0;
+        double extendSeconds = 0.0;
+        double shadeSeconds = 0.0; // including the material sort and the queue compaction
+        double shadowSeconds = 0.0;
+        double resolveSeconds = 0.0;
+
+        double getSeconds() const { return generateSeconds + extendSeconds + shadeSeconds + shadowSeconds + resolveSeconds; }
+    };
+
+    // materials holds one entry per instance, like for ProgressiveRaytracing
+    WavefrontRaytracing(DXRFramework::CpuContext::SharedPtr context, DXRFramework::CpuScene::SharedPtr scene, const std::vector<MaterialParams> &materials);
+
+    // The debug views are left to the recursive shaders, only the light selection of debug 2 is supported.
+    // So are paths of more than one bounce, Russian roulette, the path length histogram and many light sampling.
+    static bool supports(const DebugOptions &options);
+
+    // Traces one sample for the tiles from options.firstTile on in the context's tile order and blends
+    // it into output, updating the luminance moments of AdaptiveSampling.h. Tiles masked out by
+    // options.tileMask are skipped. The budget and cancel function are checked before every wave of
+    // tiles. Returns the tile the next call continues at, the tile count once the sample is complete.
+    // environmentSampler and environmentPrefilter may be null, see ProgressiveRaytracing::setEnvironment.
+    uint32_t render(const PerFrameConstants &constants, const DXRFramework::CpuTexture *environment, const DXRFramework::RtEnvironmentSampler *environmentSampler,
+                    const DXRFramework::RtEnvironmentPrefilter *environmentPrefilter, DXRFramework::CpuTileBuffer &output, DXRFramework::CpuTileBuffer &moments, const DXRFramework::CpuDispatchOptions &options);
+
+    const Stats &getLastStats() const { return mStats; }
+
+    static const uint32_t kTilesPerWave = 64;
+
+private:
+    // Every pixel owns a path for the camera ray and one for each of its two secondary rays
+    enum PathBranch
+    {
+        CameraPath,
+        IndirectDiffusePath,
+        ReflectionPath,
+        kPathsPerPixel
+    };
+    // The two lights and the environment sample of the indirect diffuse
+    static const uint32_t kShadowRaysPerPath = 3;
+
+    struct RayQueue
+    {
+        std::vector<float> originX, originY, originZ;
+        std::vector<float> directionX, directionY, directionZ;
+        std::vector<float> tMin, tMax;
+        // Path a ray extends, or shadow slot it resolves
+        std::vector<uint32_t> target;
+        uint32_t size = 0;
+
+        void reserve(size_t capacity);
+        DXRFramework::CpuRay getRay(uint32_t index) const;
+        void setRay(uint32_t index, const DXRFramework::CpuRay &ray, uint32_t rayTarget);
+    };
+
+    // Rays written by the shading stage to fixed slots, before they are compacted into a queue
+    struct RaySlots
+    {
+        std::vector<DXRFramework::CpuRay> rays;
+        std::vector<uint8_t> valid;
+    };
+
+    void generate(const PerFrameConstants &constants, const std::vector<uint32_t> &tileOrder, const std::vector<uint8_t> &tileMask,
+                  uint32_t firstTile, uint32_t endTile);
+    void extend(uint32_t rayFlags);
+    void sortByMaterial();
+    void shade(const PerFrameConstants &constants, const DXRFramework::CpuTexture *environment, const DXRFramework::RtEnvironmentSampler *environmentSampler,
+               const DXRFramework::RtEnvironmentPrefilter *environmentPrefilter, uint32_t depth);
+    void compact(const RaySlots &slots, uint32_t slotCount, RayQueue &queue);
+    void traceShadows();
+    void resolve(const PerFrameConstants &constants, DXRFramework::CpuTileBuffer &output, DXRFramework::CpuTileBuffer &moments);
+
+    DXRFramework::CpuContext::SharedPtr mContext;
+    DXRFramework::CpuScene::SharedPtr mScene;
+    std::vector<MaterialParams> mMaterials;
+    uint32_t mWidth;
+    uint32_t mHeight;
+    Stats mStats;
+
+    // Current wave
+    uint32_t mPixelCount;
+    std::vector<DXRFramework::CpuMath::uint2> mPixels;
+    std::vector<DXRFramework::CpuMath::float3> mPathWeights;
+    std::vector<DXRFramework::CpuMath::float3> mPathRadiance;
+    // BSDF pdf of paths whose escape to the environment is weighted against environment sampling, negative for the others
+    std::vector<float> mPathMisPdf;
+    // Prefiltered environment roughness of the lobe a path was drawn from, see environmentLod
+    std::vector<float> mPathLobeRoughness;
+
+    RayQueue mExtendQueue;
+    std::vector<DXRFramework::CpuHit> mHits;
+    std::vector<uint8_t> mHitFound;
+    std::vector<uint32_t> mShadeOrder;
+
+    RaySlots mExtensionSlots;
+    RaySlots mShadowSlots;
+    std::vector<DXRFramework::CpuMath::float3> mShadowWeights;
+    std::vector<uint8_t> mShadowVisible;
+    RayQueue mShadowQueue;
+    std::vector<uint32_t> mCompactionOffsets;
+};
@@ -0,0 +1,142 @@
+// Headless renderer for the CPU ray tracing backend. Renders models with the progressive pipeline
+// shaders and writes the accumulated image, or benchmarks ray throughput on the bundled models.
+//
+// Build it with
+//     g++ -std=c++14 -O2 -pthread -Ilibs/DXRFramework -Iassets/shaders -Ilibs/assimp/include -Itools/TextureConverter tools/CpuRaytracer/*.cpp libs/DXRFramework/Cpu/*.cpp libs/DXRFramework/RtGeometry.cpp libs/DXRFramework/RtJobSystem.cpp libs/DXRFramework/RtEnvironmentSampler.cpp libs/DXRFramework/RtEnvironmentPrefilter.cpp libs/DXRFramework/RtLightTree.cpp libs/DXRFramework/RtStagingPlanner.cpp tools/TextureConverter/{Image,DdsFile,JpegReader,PngReader}.cpp -lassimp -o CpuRaytracer
+//
+// Usage: CpuRaytracer [--size WxH] [--spp N] [--threads N] [--env <texture>] [--no-environment-sampling] [--prefiltered-misses] [--bounces N] [--roulette-depth N] [--path-lengths] [--lights N] [--uniform-lights] [--ao] [--sbvh] [--wavefront] [--adaptive <threshold>] [--sequence random|sobol|blue-noise] [--out <image.ppm|image.pfm>] <model>...
+//        CpuRaytracer --bench [--threads N] [--sbvh]
+//        CpuRaytracer --bvh-bench [--threads N]
+//        CpuRaytracer --bvh-report
+//        CpuRaytracer --tlas-report
+//        CpuRaytracer --packet-bench
+//        CpuRaytracer --triangle-bench
+//        CpuRaytracer --triangle-test
+//        CpuRaytracer --pass-bench [--threads N] [--sbvh]
+//        CpuRaytracer --wavefront-bench [--threads N]
+//        CpuRaytracer --adaptive-bench [--threads N] [--adaptive <threshold>]
+//        CpuRaytracer --sequence-bench [--threads N]
+//        CpuRaytracer --environment-bench [--threads N]
+//        CpuRaytracer --prefilter-bench [--threads N]
+//        CpuRaytracer --bounce-bench [--threads N]
+//        CpuRaytracer --light-bench [--threads N]
+//        CpuRaytracer --reservoir-test [--threads N]
+//        CpuRaytracer --temporal-test
+//        CpuRaytracer --denoise-test
+//        CpuRaytracer --aov-test
+//        CpuRaytracer --staging-test
+//
+// Run it from the repository root, the benchmark loads the models from assets/models. The benches and
+// tests live in the source files of their features, see CpuRaytracer.h.
+#include "CpuRaytracer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+using namespace CpuRaytracer;
+
+namespace
+{
+    struct ModeFlag
+    {
+        const char *flag;
+        const char *arguments;
+        Mode mode;
+    };
+
+    const ModeFlag kModes[] = {
+        { "--bench", " [--threads N] [--sbvh]", bench },
+        { "--bvh-bench", " [--threads N]", bvhBench },
+        { "--bvh-report", "", bvhReport },
+        { "--tlas-report", "", tlasReport },
+        { "--packet-bench", "", packetBench },
+        { "--triangle-bench", "", triangleBench },
+        { "--triangle-test", "", triangleTest },
+        { "--pass-bench", " [--threads N] [--sbvh]", passBench },
+        { "--wavefront-bench", " [--threads N]", wavefrontBench },
+        { "--adaptive-bench", " [--threads N] [--adaptive <threshold>]", adaptiveBench },
+        { "--sequence-bench", " [--threads N]", sequenceBench },
+        { "--environment-bench", " [--threads N]", environmentBench },
+        { "--prefilter-bench", " [--threads N]", prefilterBench },
+        { "--bounce-bench", " [--threads N]", bounceBench },
+        { "--light-bench", " [--threads N]", lightBench },
+        { "--reservoir-test", " [--threads N]", reservoirTest },
+        { "--temporal-test", "", temporalTest },
+        { "--denoise-test", "", denoiseTest },
+        { "--aov-test", "", aovTest },
+        { "--staging-test", "", stagingTest },
+    };
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    Mode mode = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        auto modeFlag = std::find_if(std::begin(kModes), std::end(kModes), [&](const ModeFlag &m) { return !strcmp(argv[i], m.flag); });
+        if (modeFlag != std::end(kModes)) {
+            mode = modeFlag->mode;
+        } else if (!strcmp(argv[i], "--size") && i + 1 < argc) {
+            sscanf(argv[++i], "%ux%u", &options.width, &options.height);
+        } else if (!strcmp(argv[i], "--spp") && i + 1 < argc) {
+            options.samplesPerPixel = static_cast<uint32_t>(atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            options.threads = static_cast<uint32_t>(atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--env") && i + 1 < argc) {
+            options.environment = argv[++i];
+        } else if (!strcmp(argv[i], "--out") && i + 1 < argc) {
+            options.output = argv[++i];
+        } else if (!strcmp(argv[i], "--ao")) {
+            options.ambientOcclusion = true;
+        } else if (!strcmp(argv[i], "--sbvh")) {
+            options.spatialSplits = true;
+        } else if (!strcmp(argv[i], "--wavefront")) {
+            options.wavefront = true;
+        } else if (!strcmp(argv[i], "--adaptive") && i + 1 < argc) {
+            options.adaptive = true;
+            options.adaptiveThreshold = static_cast<float>(atof(argv[++i]));
+        } else if (!strcmp(argv[i], "--sequence") && i + 1 < argc) {
+            ++i;
+            if (!strcmp(argv[i], "random")) {
+                options.sampleSequence = SAMPLE_SEQUENCE_RANDOM;
+            } else if (!strcmp(argv[i], "sobol")) {
+                options.sampleSequence = SAMPLE_SEQUENCE_SOBOL;
+            } else {
+                options.sampleSequence = SAMPLE_SEQUENCE_BLUE_NOISE_SOBOL;
+            }
+        } else if (!strcmp(argv[i], "--no-environment-sampling")) {
+            options.environmentSampling = false;
+        } else if (!strcmp(argv[i], "--prefiltered-misses")) {
+            options.prefilteredMisses = true;
+        } else if (!strcmp(argv[i], "--bounces") && i + 1 < argc) {
+            options.maxBounces = (std::min)((std::max)(static_cast<uint32_t>(atoi(argv[++i])), 1u), uint32_t(MAX_RADIANCE_RAY_DEPTH));
+        } else if (!strcmp(argv[i], "--roulette-depth") && i + 1 < argc) {
+            options.russianRouletteDepth = static_cast<uint32_t>(atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--path-lengths")) {
+            options.pathLengths = true;
+        } else if (!strcmp(argv[i], "--lights") && i + 1 < argc) {
+            options.lightCount = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--uniform-lights")) {
+            options.uniformLights = true;
+        } else {
+            options.models.push_back(argv[i]);
+        }
+    }
+
+    if (!mode && options.models.empty()) {
+        fprintf(stderr, "Usage: CpuRaytracer [--size WxH] [--spp N] [--threads N] [--env <texture>] [--no-environment-sampling] [--prefiltered-misses] [--bounces N] [--roulette-depth N] [--path-lengths] [--lights N] [--uniform-lights] [--ao] [--sbvh] [--wavefront] [--adaptive <threshold>] [--sequence random|sobol|blue-noise] [--out <image.ppm|image.pfm>] <model>...\n");
+        for (const ModeFlag &modeFlag : kModes) {
+            fprintf(stderr, "       CpuRaytracer %s%s\n", modeFlag.flag, modeFlag.arguments);
+        }
+        return 1;
+    }
+
+    try {
+        return mode ? mode(options) : render(options);
+    } catch (const std::exception &e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,200 @@
+// Microbenchmarks of RtJobSystem: the cost of a job, work stealing on a recursive task tree, parallel
+// for scaling and continuation latency, for pools of 1 to 64 threads. Every benchmark checks its
+// result, the tool exits with an error if one is wrong.
+//
+// The job system has no platform dependencies. Build it with
+//     g++ -std=c++14 -O2 -pthread -Ilibs/DXRFramework tools/JobSystemBench/main.cpp libs/DXRFramework/RtJobSystem.cpp -o JobSystemBench
+//     cl /std:c++14 /O2 /EHsc /Ilibs\DXRFramework tools\JobSystemBench\main.cpp libs\DXRFramework\RtJobSystem.cpp /Fe:JobSystemBench.exe
+//
+// Usage: JobSystemBench [--max-threads N]
+#include "RtJobSystem.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+using namespace DXRFramework;
+
+namespace
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    double secondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void check(bool condition, const char *what)
+    {
+        if (!condition) {
+            throw std::runtime_error(what);
+        }
+    }
+
+    // Best of a few runs of the function, in seconds
+    template <typename Function>
+    double measure(int runs, const Function &function)
+    {
+        double best = 1e30;
+        for (int run = 0; run < runs; ++run) {
+            auto start = Clock::now();
+            function();
+            best = (std::min)(best, secondsSince(start));
+        }
+        return best;
+    }
+
+    // Empty jobs pushed from the calling thread into one group, which is then waited on
+    double emptyJobs(RtJobSystem &jobSystem, uint32_t count)
+    {
+        std::atomic<uint32_t> executed(0);
+        double seconds = measure(3, [&] {
+            executed = 0;
+            RtTaskGroup group(jobSystem);
+            for (uint32_t i = 0; i < count; ++i) {
+                group.run([&executed] { executed.fetch_add(1, std::memory_order_relaxed); });
+            }
+            group.wait();
+        });
+        check(executed == count, "empty jobs: not every job ran");
+        return seconds / count * 1e9;
+    }
+
+    uint64_t serialFib(uint32_t n)
+    {
+        return n < 2 ? n : serialFib(n - 1) + serialFib(n - 2);
+    }
+
+    // Every call above the cutoff runs one branch as a job and waits for it, so most jobs are spawned
+    // by workers and the tree only spreads over the pool by stealing
+    uint64_t parallelFib(RtJobSystem &jobSystem, uint32_t n, uint32_t cutoff)
+    {
+        if (n < cutoff) {
+            return serialFib(n);
+        }
+        uint64_t left = 0;
+        RtTaskGroup group(jobSystem);
+        group.run([&] { left = parallelFib(jobSystem, n - 1, cutoff); });
+        uint64_t right = parallelFib(jobSystem, n - 2, cutoff);
+        group.wait();
+        return left + right;
+    }
+
+    double sumRange(const std::vector<float> &values, uint32_t begin, uint32_t end)
+    {
+        double sum = 0.0;
+        for (uint32_t i = begin; i < end; ++i) {
+            sum += std::sqrt(values[i]) * std::sin(values[i]);
+        }
+        return sum;
+    }
+
+    // A continuation that adds the next one, so every link waits for the previous to finish
+    double continuationChain(RtJobSystem &jobSystem, uint32_t length)
+    {
+        uint32_t links = 0;
+        double seconds = measure(3, [&] {
+            links = 0;
+            RtTaskGroup group(jobSystem);
+            std::function<void()> link = [&] {
+                if (++links < length) {
+                    group.then(link);
+                }
+            };
+            group.then(link);
+            group.wait();
+        });
+        check(links == length, "continuations: chain cut short");
+        return seconds / length * 1e9;
+    }
+
+    // std::async with a thread per job, the baseline the job system replaces
+    double asyncJobs(uint32_t count)
+    {
+        std::atomic<uint32_t> executed(0);
+        double seconds = measure(3, [&] {
+            executed = 0;
+            std::vector<std::future<void>> futures;
+            for (uint32_t i = 0; i < count; ++i) {
+                futures.push_back(std::async(std::launch::async, [&executed] { executed.fetch_add(1); }));
+            }
+            for (auto &future : futures) {
+                future.get();
+            }
+        });
+        check(executed == count, "std::async: not every job ran");
+        return seconds / count * 1e9;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t maxThreads = 64;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--max-threads") && i + 1 < argc) {
+            maxThreads = static_cast<uint32_t>(atoi(argv[++i]));
+        } else {
+            fprintf(stderr, "Usage: JobSystemBench [--max-threads N]\n");
+            return 1;
+        }
+    }
+
+    try {
+        const uint32_t emptyJobCount = 100000;
+        const uint32_t fibN = 34, fibCutoff = 16;
+        const uint32_t forCount = 1 << 22, forGrain = 4096;
+        const uint32_t chainLength = 10000;
+
+        std::vector<float> values(forCount);
+        for (uint32_t i = 0; i < forCount; ++i) {
+            values[i] = static_cast<float>(i % 1000) * 0.01f;
+        }
+        uint64_t expectedFib = serialFib(fibN);
+        double expectedSum = 0.0;
+        double serialForSeconds = measure(3, [&] { expectedSum = sumRange(values, 0, forCount); });
+        double serialFibSeconds = measure(1, [&] { check(serialFib(fibN) == expectedFib, "fib"); });
+
+        printf("%u hardware threads; serial fib(%u) %.1f ms, serial loop %.1f ms, std::async %.0f ns/job\n", std::thread::hardware_concurrency(),
+               fibN, serialFibSeconds * 1000.0, serialForSeconds * 1000.0, asyncJobs(2000));
+        printf("%8s | %12s | %9s %8s %9s %8s | %9s %8s | %12s\n", "threads", "empty ns/job", "fib ms", "speedup", "jobs", "stolen",
+               "for ms", "speedup", "then ns/link");
+
+        for (uint32_t threads = 1; threads <= maxThreads; threads *= 2) {
+            auto jobSystem = RtJobSystem::create(threads);
+            check(jobSystem->getThreadCount() == threads, "thread count");
+            double emptyNs = emptyJobs(*jobSystem, emptyJobCount);
+
+            RtJobSystem::Stats before = jobSystem->getStats();
+            uint64_t fib = 0;
+            double fibSeconds = measure(3, [&] { fib = parallelFib(*jobSystem, fibN, fibCutoff); });
+            RtJobSystem::Stats after = jobSystem->getStats();
+            check(fib == expectedFib, "fib: wrong result");
+
+            double sum = 0.0;
+            double forSeconds = measure(3, [&] {
+                std::vector<double> partial((forCount + forGrain - 1) / forGrain, 0.0);
+                jobSystem->parallelFor(0, forCount, forGrain, [&](uint32_t begin, uint32_t end) {
+                    partial[begin / forGrain] = sumRange(values, begin, end);
+                });
+                sum = 0.0;
+                for (double p : partial) {
+                    sum += p;
+                }
+            });
+            check(std::fabs(sum - expectedSum) <= 1e-9 * std::fabs(expectedSum) + 1e-6, "parallel for: wrong sum");
+
+            double chainNs = continuationChain(*jobSystem, chainLength);
+            printf("%8u | %12.0f | %9.1f %8.2f %9.0f %7.1f%% | %9.1f %8.2f | %12.0f\n", threads, emptyNs, fibSeconds * 1000.0, serialFibSeconds / fibSeconds,
+                   (after.jobs - before.jobs) / 3.0, 100.0 * (after.steals - before.steals) / (std::max)(uint64_t(1), after.jobs - before.jobs),
+                   forSeconds * 1000.0, serialForSeconds / forSeconds, chainNs);
+        }
+    } catch (const std::exception &e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
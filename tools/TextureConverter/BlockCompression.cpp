@@ -0,0 +1,466 @@
+#include "BlockCompression.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace TextureConverter
+{
+    namespace
+    {
+        const int kWeights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        class BitWriter
+        {
+        public:
+            explicit BitWriter(uint8_t block[16]) : mBlock(block) { std::memset(mBlock, 0, 16); }
+
+            void write(uint32_t value, int count)
+            {
+                for (int i = 0; i < count; ++i, ++mPosition) {
+                    mBlock[mPosition >> 3] |= uint8_t(((value >> i) & 1) << (mPosition & 7));
+                }
+            }
+
+        private:
+            uint8_t *mBlock;
+            int mPosition = 0;
+        };
+
+        class BitReader
+        {
+        public:
+            explicit BitReader(const uint8_t block[16]) : mBlock(block) {}
+
+            uint32_t read(int count)
+            {
+                uint32_t value = 0;
+                for (int i = 0; i < count; ++i, ++mPosition) {
+                    value |= uint32_t((mBlock[mPosition >> 3] >> (mPosition & 7)) & 1) << i;
+                }
+                return value;
+            }
+
+        private:
+            const uint8_t *mBlock;
+            int mPosition = 0;
+        };
+
+        // Endpoint quantization rules of one block mode. Values live in an integer "working space"
+        // where the hardware interpolates: 8-bit unorm for BC7, pre-scale half bits for BC6H.
+        struct BC7Mode6
+        {
+            static const int kChannels = 4;
+            static const int kVariants = 4; // p-bit combinations
+
+            // Returns the dequantized endpoint closest to value, and its quantized form
+            static int quantize(float value, int variant, int endpoint, int *quantized)
+            {
+                int pbit = (variant >> endpoint) & 1;
+                int q = int(std::lround((value - pbit) * 0.5f));
+                q = std::min(127, std::max(0, q));
+                *quantized = q;
+                return (q << 1) | pbit;
+            }
+
+            static float toWorking(float value) { return std::min(1.0f, std::max(0.0f, value)) * 255.0f; }
+            static float interpolate(int a, int b, int weight) { return float(((64 - weight) * a + weight * b + 32) >> 6); }
+        };
+
+        struct BC6HMode11
+        {
+            static const int kChannels = 3;
+            static const int kVariants = 1;
+
+            static int unquantize(int q)
+            {
+                if (q == 0) return 0;
+                if (q == 1023) return 0xFFFF;
+                return ((q << 16) + 0x8000) >> 10;
+            }
+
+            static int quantize(float value, int, int, int *quantized)
+            {
+                int guess = int(std::lround((value - 32.0f) / 64.0f));
+                int best = 0;
+                float bestError = 1e30f;
+                for (int q = std::max(0, guess - 1); q <= std::min(1023, guess + 1); ++q) {
+                    float error = std::fabs(unquantize(q) - value);
+                    if (error < bestError) {
+                        bestError = error;
+                        best = q;
+                    }
+                }
+                *quantized = best;
+                return unquantize(best);
+            }
+
+            // Unsigned half bit pattern rescaled to the interpolation range, roughly logarithmic in radiance
+            static float toWorking(float value)
+            {
+                if (!(value > 0.0f)) {
+                    return 0.0f;
+                }
+                return floatToHalf(std::min(value, 65504.0f)) * (64.0f / 31.0f);
+            }
+
+            static float interpolate(int a, int b, int weight)
+            {
+                int interpolated = ((64 - weight) * a + weight * b + 32) >> 6;
+                return ((interpolated * 31) >> 6) * (64.0f / 31.0f);
+            }
+        };
+
+        template <typename Mode>
+        struct Candidate
+        {
+            int endpoints[2][4];
+            int quantized[2][4];
+            int variant;
+            uint8_t indices[16];
+            float error;
+        };
+
+        template <typename Mode>
+        void quantizeEndpoints(const float endpoints[2][4], int variant, Candidate<Mode> &candidate)
+        {
+            candidate.variant = variant;
+            for (int e = 0; e < 2; ++e) {
+                for (int c = 0; c < Mode::kChannels; ++c) {
+                    candidate.endpoints[e][c] = Mode::quantize(endpoints[e][c], variant, e, &candidate.quantized[e][c]);
+                }
+            }
+        }
+
+        template <typename Mode>
+        void assignIndices(const float texels[16][4], Candidate<Mode> &candidate)
+        {
+            float palette[16][4];
+            for (int i = 0; i < 16; ++i) {
+                for (int c = 0; c < Mode::kChannels; ++c) {
+                    palette[i][c] = Mode::interpolate(candidate.endpoints[0][c], candidate.endpoints[1][c], kWeights4[i]);
+                }
+            }
+
+            candidate.error = 0.0f;
+            for (int t = 0; t < 16; ++t) {
+                float bestError = 1e30f;
+                int best = 0;
+                for (int i = 0; i < 16; ++i) {
+                    float error = 0.0f;
+                    for (int c = 0; c < Mode::kChannels; ++c) {
+                        float d = palette[i][c] - texels[t][c];
+                        error += d * d;
+                    }
+                    if (error < bestError) {
+                        bestError = error;
+                        best = i;
+                    }
+                }
+                candidate.indices[t] = uint8_t(best);
+                candidate.error += bestError;
+            }
+        }
+
+        // Least squares endpoints for fixed indices; returns false when the system is degenerate
+        template <typename Mode>
+        bool solveEndpoints(const float texels[16][4], const uint8_t indices[16], float endpoints[2][4])
+        {
+            float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+            float ax[4] = {}, bx[4] = {};
+            for (int t = 0; t < 16; ++t) {
+                float w = kWeights4[indices[t]] / 64.0f;
+                aa += (1.0f - w) * (1.0f - w);
+                ab += (1.0f - w) * w;
+                bb += w * w;
+                for (int c = 0; c < Mode::kChannels; ++c) {
+                    ax[c] += (1.0f - w) * texels[t][c];
+                    bx[c] += w * texels[t][c];
+                }
+            }
+
+            float determinant = aa * bb - ab * ab;
+            if (std::fabs(determinant) < 1e-6f) {
+                return false;
+            }
+            for (int c = 0; c < Mode::kChannels; ++c) {
+                endpoints[0][c] = (ax[c] * bb - bx[c] * ab) / determinant;
+                endpoints[1][c] = (bx[c] * aa - ax[c] * ab) / determinant;
+            }
+            return true;
+        }
+
+        template <typename Mode>
+        Candidate<Mode> encodeBlock(const float input[16][4])
+        {
+            const int channels = Mode::kChannels;
+
+            float texels[16][4] = {};
+            float mean[4] = {};
+            for (int t = 0; t < 16; ++t) {
+                for (int c = 0; c < channels; ++c) {
+                    texels[t][c] = Mode::toWorking(input[t][c]);
+                    mean[c] += texels[t][c] / 16.0f;
+                }
+            }
+
+            // Principal axis by power iteration on the covariance matrix
+            float covariance[4][4] = {};
+            for (int t = 0; t < 16; ++t) {
+                for (int i = 0; i < channels; ++i) {
+                    for (int j = 0; j < channels; ++j) {
+                        covariance[i][j] += (texels[t][i] - mean[i]) * (texels[t][j] - mean[j]);
+                    }
+                }
+            }
+            float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+            for (int iteration = 0; iteration < 8; ++iteration) {
+                float next[4] = {};
+                float length = 0.0f;
+                for (int i = 0; i < channels; ++i) {
+                    for (int j = 0; j < channels; ++j) {
+                        next[i] += covariance[i][j] * axis[j];
+                    }
+                    length += next[i] * next[i];
+                }
+                if (length < 1e-12f) {
+                    break;
+                }
+                length = std::sqrt(length);
+                for (int i = 0; i < channels; ++i) {
+                    axis[i] = next[i] / length;
+                }
+            }
+
+            float tMin = 0.0f, tMax = 0.0f;
+            for (int t = 0; t < 16; ++t) {
+                float projection = 0.0f;
+                for (int c = 0; c < channels; ++c) {
+                    projection += (texels[t][c] - mean[c]) * axis[c];
+                }
+                tMin = std::min(tMin, projection);
+                tMax = std::max(tMax, projection);
+            }
+
+            float endpoints[2][4] = {};
+            for (int c = 0; c < channels; ++c) {
+                endpoints[0][c] = mean[c] + tMin * axis[c];
+                endpoints[1][c] = mean[c] + tMax * axis[c];
+            }
+
+            Candidate<Mode> best;
+            best.error = 1e30f;
+            for (int variant = 0; variant < Mode::kVariants; ++variant) {
+                Candidate<Mode> candidate;
+                quantizeEndpoints(endpoints, variant, candidate);
+                assignIndices(texels, candidate);
+
+                for (int refinement = 0; refinement < 2 && candidate.error > 0.0f; ++refinement) {
+                    float refined[2][4] = {};
+                    if (!solveEndpoints<Mode>(texels, candidate.indices, refined)) {
+                        break;
+                    }
+                    Candidate<Mode> next;
+                    quantizeEndpoints(refined, variant, next);
+                    assignIndices(texels, next);
+                    if (next.error >= candidate.error) {
+                        break;
+                    }
+                    candidate = next;
+                }
+
+                if (candidate.error < best.error) {
+                    best = candidate;
+                }
+            }
+
+            // The anchor index is stored without its most significant bit
+            if (best.indices[0] & 8) {
+                for (int c = 0; c < 4; ++c) {
+                    std::swap(best.endpoints[0][c], best.endpoints[1][c]);
+                    std::swap(best.quantized[0][c], best.quantized[1][c]);
+                }
+                int low = best.variant & 1, high = (best.variant >> 1) & 1;
+                best.variant = (low << 1) | high;
+                for (int t = 0; t < 16; ++t) {
+                    best.indices[t] = uint8_t(15 - best.indices[t]);
+                }
+            }
+            return best;
+        }
+
+        void writeIndices(BitWriter &writer, const uint8_t indices[16])
+        {
+            writer.write(indices[0], 3);
+            for (int t = 1; t < 16; ++t) {
+                writer.write(indices[t], 4);
+            }
+        }
+
+        void readIndices(BitReader &reader, uint8_t indices[16])
+        {
+            indices[0] = uint8_t(reader.read(3));
+            for (int t = 1; t < 16; ++t) {
+                indices[t] = uint8_t(reader.read(4));
+            }
+        }
+
+        uint32_t blockCount(uint32_t size) { return (size + 3) / 4; }
+    }
+
+    void encodeBC7Block(const float texels[16][4], uint8_t block[16])
+    {
+        Candidate<BC7Mode6> encoded = encodeBlock<BC7Mode6>(texels);
+
+        BitWriter writer(block);
+        writer.write(1 << 6, 7);
+        for (int c = 0; c < 4; ++c) {
+            writer.write(encoded.quantized[0][c], 7);
+            writer.write(encoded.quantized[1][c], 7);
+        }
+        writer.write(encoded.variant & 1, 1);
+        writer.write((encoded.variant >> 1) & 1, 1);
+        writeIndices(writer, encoded.indices);
+    }
+
+    void encodeBC6HBlock(const float texels[16][4], uint8_t block[16])
+    {
+        Candidate<BC6HMode11> encoded = encodeBlock<BC6HMode11>(texels);
+
+        BitWriter writer(block);
+        writer.write(0x03, 5);
+        for (int e = 0; e < 2; ++e) {
+            for (int c = 0; c < 3; ++c) {
+                writer.write(encoded.quantized[e][c], 10);
+            }
+        }
+        writeIndices(writer, encoded.indices);
+    }
+
+    void decodeBC7Block(const uint8_t block[16], float texels[16][4])
+    {
+        BitReader reader(block);
+        if (reader.read(7) != (1 << 6)) {
+            throw std::runtime_error("bc7: only mode 6 blocks can be decoded");
+        }
+
+        int endpoints[2][4];
+        for (int c = 0; c < 4; ++c) {
+            endpoints[0][c] = int(reader.read(7)) << 1;
+            endpoints[1][c] = int(reader.read(7)) << 1;
+        }
+        int p0 = int(reader.read(1)), p1 = int(reader.read(1));
+        uint8_t indices[16];
+        readIndices(reader, indices);
+
+        for (int t = 0; t < 16; ++t) {
+            for (int c = 0; c < 4; ++c) {
+                texels[t][c] = BC7Mode6::interpolate(endpoints[0][c] | p0, endpoints[1][c] | p1, kWeights4[indices[t]]) / 255.0f;
+            }
+        }
+    }
+
+    void decodeBC6HBlock(const uint8_t block[16], float texels[16][4])
+    {
+        BitReader reader(block);
+        if (reader.read(5) != 0x03) {
+            throw std::runtime_error("bc6h: only mode 11 blocks can be decoded");
+        }
+
+        int endpoints[2][3];
+        for (int e = 0; e < 2; ++e) {
+            for (int c = 0; c < 3; ++c) {
+                endpoints[e][c] = BC6HMode11::unquantize(int(reader.read(10)));
+            }
+        }
+        uint8_t indices[16];
+        readIndices(reader, indices);
+
+        for (int t = 0; t < 16; ++t) {
+            for (int c = 0; c < 3; ++c) {
+                int weight = kWeights4[indices[t]];
+                int interpolated = ((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6;
+                texels[t][c] = halfToFloat(uint16_t((interpolated * 31) >> 6));
+            }
+            texels[t][3] = 1.0f;
+        }
+    }
+
+    CompressedTexture compressTexture(const Texture &texture, uint32_t format, uint32_t threadCount)
+    {
+        if (format != DXGI_FORMAT_BC7_UNORM && format != DXGI_FORMAT_BC6H_UF16) {
+            throw std::runtime_error("unsupported block compression format");
+        }
+        auto encode = (format == DXGI_FORMAT_BC7_UNORM) ? encodeBC7Block : encodeBC6HBlock;
+
+        CompressedTexture result;
+        result.format = format;
+        result.width = texture.faces[0][0].width;
+        result.height = texture.faces[0][0].height;
+        result.mipCount = texture.getMipCount();
+        result.cubemap = texture.cubemap;
+
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        for (auto &face : texture.faces) {
+            for (auto &image : face) {
+                uint32_t blocksX = blockCount(image.width), blocksY = blockCount(image.height);
+                std::vector<uint8_t> blocks(size_t(blocksX) * blocksY * 16);
+
+                // Block rows are handed out to the workers through a shared counter
+                std::atomic<uint32_t> nextRow(0);
+                auto worker = [&]() {
+                    float texels[16][4];
+                    for (uint32_t by = nextRow++; by < blocksY; by = nextRow++) {
+                        for (uint32_t bx = 0; bx < blocksX; ++bx) {
+                            for (uint32_t t = 0; t < 16; ++t) {
+                                // Edge texels are replicated into partial blocks
+                                uint32_t x = std::min(bx * 4 + t % 4, image.width - 1);
+                                uint32_t y = std::min(by * 4 + t / 4, image.height - 1);
+                                std::memcpy(texels[t], image.at(x, y), sizeof(texels[t]));
+                            }
+                            encode(texels, &blocks[(size_t(by) * blocksX + bx) * 16]);
+                        }
+                    }
+                };
+
+                std::vector<std::thread> threads;
+                for (uint32_t i = 1; i < std::min(threadCount, blocksY); ++i) {
+                    threads.emplace_back(worker);
+                }
+                worker();
+                for (auto &thread : threads) {
+                    thread.join();
+                }
+
+                result.subresources.push_back(std::move(blocks));
+            }
+        }
+        return result;
+    }
+
+    Image decompressImage(const std::vector<uint8_t> &blocks, uint32_t format, uint32_t width, uint32_t height)
+    {
+        auto decode = (format == DXGI_FORMAT_BC7_UNORM) ? decodeBC7Block : decodeBC6HBlock;
+        uint32_t blocksX = blockCount(width), blocksY = blockCount(height);
+
+        Image image(width, height);
+        float texels[16][4];
+        for (uint32_t by = 0; by < blocksY; ++by) {
+            for (uint32_t bx = 0; bx < blocksX; ++bx) {
+                decode(&blocks[(size_t(by) * blocksX + bx) * 16], texels);
+                for (uint32_t t = 0; t < 16; ++t) {
+                    uint32_t x = bx * 4 + t % 4, y = by * 4 + t / 4;
+                    if (x < width && y < height) {
+                        std::memcpy(image.at(x, y), texels[t], sizeof(texels[t]));
+                    }
+                }
+            }
+        }
+        return image;
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Image.h"
+#include "DdsFile.h"
+
+namespace TextureConverter
+{
+    // Block encoders operate on 4x4 texels in row-major order.
+    //
+    // BC7 uses mode 6 (one subset, 7-bit RGBA endpoints with per-endpoint p-bits, 4-bit indices).
+    // BC6H uses mode 11 (one region, 10-bit unsigned endpoints, 4-bit indices) and ignores alpha.
+    // Endpoints start from the principal axis of the block and are refined by least squares
+    // against the chosen indices, so quality is comparable to the "fast" presets of common encoders.
+    void encodeBC7Block(const float texels[16][4], uint8_t block[16]);
+    void encodeBC6HBlock(const float texels[16][4], uint8_t block[16]);
+
+    // Decoders only understand the modes emitted above and throw otherwise; they back the quality report.
+    void decodeBC7Block(const uint8_t block[16], float texels[16][4]);
+    void decodeBC6HBlock(const uint8_t block[16], float texels[16][4]);
+
+    // Compresses every face and mip of the texture using all available threads (threadCount 0).
+    CompressedTexture compressTexture(const Texture &texture, uint32_t format, uint32_t threadCount = 0);
+
+    // Decodes one subresource back to floats, cropped to the original dimensions.
+    Image decompressImage(const std::vector<uint8_t> &blocks, uint32_t format, uint32_t width, uint32_t height);
+}
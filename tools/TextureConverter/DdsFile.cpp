@@ -0,0 +1,182 @@
+#include "Image.h"
+#include "DdsFile.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace TextureConverter
+{
+    namespace
+    {
+        const uint32_t kDdsMagic = 0x20534444; // "DDS "
+        const uint32_t kFourCCDX10 = 0x30315844; // "DX10"
+
+        const uint32_t DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PIXELFORMAT = 0x1000;
+        const uint32_t DDSD_MIPMAPCOUNT = 0x20000, DDSD_LINEARSIZE = 0x80000;
+        const uint32_t DDPF_FOURCC = 0x4;
+        const uint32_t DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000;
+        const uint32_t DDSCAPS2_CUBEMAP_ALLFACES = 0xFE00;
+        const uint32_t RESOURCE_DIMENSION_TEXTURE2D = 3;
+        const uint32_t RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+        // Legacy D3DFMT values stored in the FourCC field
+        const uint32_t D3DFMT_A16B16G16R16F = 113, D3DFMT_A32B32G32R32F = 116;
+
+#pragma pack(push, 1)
+        struct PixelFormat
+        {
+            uint32_t size, flags, fourCC, rgbBitCount, rMask, gMask, bMask, aMask;
+        };
+
+        struct Header
+        {
+            uint32_t size, flags, height, width, pitchOrLinearSize, depth, mipMapCount;
+            uint32_t reserved1[11];
+            PixelFormat pixelFormat;
+            uint32_t caps, caps2, caps3, caps4, reserved2;
+        };
+
+        struct HeaderDX10
+        {
+            uint32_t dxgiFormat, resourceDimension, miscFlag, arraySize, miscFlags2;
+        };
+#pragma pack(pop)
+
+        uint32_t bytesPerPixel(uint32_t format)
+        {
+            switch (format) {
+            case DXGI_FORMAT_R32G32B32A32_FLOAT: return 16;
+            case DXGI_FORMAT_R16G16B16A16_FLOAT: return 8;
+            case DXGI_FORMAT_R8G8B8A8_UNORM:
+            case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB: return 4;
+            default: return 0;
+            }
+        }
+
+        float readChannel(const uint8_t *texel, uint32_t format, int channel)
+        {
+            switch (format) {
+            case DXGI_FORMAT_R32G32B32A32_FLOAT:
+                {
+                    float value;
+                    std::memcpy(&value, texel + channel * 4, 4);
+                    return value;
+                }
+            case DXGI_FORMAT_R16G16B16A16_FLOAT:
+                {
+                    uint16_t value;
+                    std::memcpy(&value, texel + channel * 2, 2);
+                    return halfToFloat(value);
+                }
+            default:
+                return texel[channel] / 255.0f;
+            }
+        }
+    }
+
+    Texture readDds(const std::string &path)
+    {
+        std::vector<uint8_t> data = readFile(path);
+        if (data.size() < 4 + sizeof(Header)) {
+            throw std::runtime_error("dds: file too small: " + path);
+        }
+
+        uint32_t magic;
+        Header header;
+        std::memcpy(&magic, data.data(), 4);
+        std::memcpy(&header, data.data() + 4, sizeof(Header));
+        if (magic != kDdsMagic || header.size != sizeof(Header)) {
+            throw std::runtime_error("dds: bad header in " + path);
+        }
+
+        size_t offset = 4 + sizeof(Header);
+        uint32_t format = 0;
+        bool cubemap = (header.caps2 & DDSCAPS2_CUBEMAP_ALLFACES) == DDSCAPS2_CUBEMAP_ALLFACES;
+
+        if ((header.pixelFormat.flags & DDPF_FOURCC) && header.pixelFormat.fourCC == kFourCCDX10) {
+            HeaderDX10 dx10;
+            std::memcpy(&dx10, data.data() + offset, sizeof(dx10));
+            offset += sizeof(dx10);
+            format = dx10.dxgiFormat;
+            cubemap = (dx10.miscFlag & RESOURCE_MISC_TEXTURECUBE) != 0;
+            if (dx10.resourceDimension != RESOURCE_DIMENSION_TEXTURE2D || dx10.arraySize != 1) {
+                throw std::runtime_error("dds: only single 2D textures and cubemaps are supported in " + path);
+            }
+        } else if (header.pixelFormat.flags & DDPF_FOURCC) {
+            if (header.pixelFormat.fourCC == D3DFMT_A16B16G16R16F) {
+                format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+            } else if (header.pixelFormat.fourCC == D3DFMT_A32B32G32R32F) {
+                format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+            }
+        } else if (header.pixelFormat.rgbBitCount == 32 && header.pixelFormat.rMask == 0xFF && header.pixelFormat.aMask == 0xFF000000) {
+            format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        }
+
+        uint32_t pixelSize = bytesPerPixel(format);
+        if (!pixelSize) {
+            throw std::runtime_error("dds: unsupported pixel format in " + path);
+        }
+
+        Texture texture;
+        texture.hdr = format == DXGI_FORMAT_R32G32B32A32_FLOAT || format == DXGI_FORMAT_R16G16B16A16_FLOAT;
+        texture.cubemap = cubemap;
+        texture.faces.resize(cubemap ? 6 : 1);
+
+        uint32_t mipCount = (header.flags & DDSD_MIPMAPCOUNT) ? std::max(1u, header.mipMapCount) : 1;
+        for (auto &face : texture.faces) {
+            uint32_t width = header.width, height = header.height;
+            for (uint32_t mip = 0; mip < mipCount; ++mip) {
+                size_t size = size_t(width) * height * pixelSize;
+                if (offset + size > data.size()) {
+                    throw std::runtime_error("dds: truncated image data in " + path);
+                }
+
+                Image image(width, height);
+                for (size_t i = 0; i < size_t(width) * height; ++i) {
+                    for (int c = 0; c < 4; ++c) {
+                        image.pixels[i * 4 + c] = readChannel(&data[offset + i * pixelSize], format, c);
+                    }
+                }
+                face.push_back(std::move(image));
+
+                offset += size;
+                width = std::max(1u, width / 2);
+                height = std::max(1u, height / 2);
+            }
+        }
+        return texture;
+    }
+
+    std::vector<uint8_t> writeDds(const CompressedTexture &texture)
+    {
+        Header header = {};
+        header.size = sizeof(Header);
+        header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+        header.width = texture.width;
+        header.height = texture.height;
+        header.pitchOrLinearSize = static_cast<uint32_t>(texture.subresources[0].size());
+        header.mipMapCount = texture.mipCount;
+        header.pixelFormat.size = sizeof(PixelFormat);
+        header.pixelFormat.flags = DDPF_FOURCC;
+        header.pixelFormat.fourCC = kFourCCDX10;
+        header.caps = DDSCAPS_TEXTURE | (texture.mipCount > 1 ? DDSCAPS_MIPMAP | DDSCAPS_COMPLEX : 0) | (texture.cubemap ? DDSCAPS_COMPLEX : 0);
+        header.caps2 = texture.cubemap ? DDSCAPS2_CUBEMAP_ALLFACES : 0;
+
+        HeaderDX10 dx10 = {};
+        dx10.dxgiFormat = texture.format;
+        dx10.resourceDimension = RESOURCE_DIMENSION_TEXTURE2D;
+        dx10.miscFlag = texture.cubemap ? RESOURCE_MISC_TEXTURECUBE : 0;
+        dx10.arraySize = 1;
+
+        std::vector<uint8_t> file(4 + sizeof(Header) + sizeof(HeaderDX10));
+        std::memcpy(&file[0], &kDdsMagic, 4);
+        std::memcpy(&file[4], &header, sizeof(Header));
+        std::memcpy(&file[4 + sizeof(Header)], &dx10, sizeof(HeaderDX10));
+
+        // Subresources are stored face by face, each face with its full mip chain
+        for (auto &subresource : texture.subresources) {
+            file.insert(file.end(), subresource.begin(), subresource.end());
+        }
+        return file;
+    }
+}
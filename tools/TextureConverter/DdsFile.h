@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace TextureConverter
+{
+    // DXGI_FORMAT values used by the converter, kept here so the tool does not depend on the Windows SDK
+    enum : uint32_t
+    {
+        DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+        DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+        DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+        DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+        DXGI_FORMAT_BC6H_UF16 = 95,
+        DXGI_FORMAT_BC7_UNORM = 98
+    };
+
+    struct CompressedTexture
+    {
+        uint32_t format = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mipCount = 0;
+        bool cubemap = false;
+        // One entry per face and mip, in D3D12 subresource order
+        std::vector<std::vector<uint8_t>> subresources;
+    };
+
+    std::vector<uint8_t> writeDds(const CompressedTexture &texture);
+}
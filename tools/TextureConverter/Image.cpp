@@ -0,0 +1,169 @@
+#include "Image.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace TextureConverter
+{
+    Image downsample(const Image &source)
+    {
+        uint32_t width = std::max(1u, source.width / 2);
+        uint32_t height = std::max(1u, source.height / 2);
+        Image result(width, height);
+
+        for (uint32_t y = 0; y < height; ++y) {
+            uint32_t y0 = std::min(y * 2, source.height - 1);
+            uint32_t y1 = (y == height - 1) ? source.height - 1 : std::min(y * 2 + 1, source.height - 1);
+
+            for (uint32_t x = 0; x < width; ++x) {
+                uint32_t x0 = std::min(x * 2, source.width - 1);
+                uint32_t x1 = (x == width - 1) ? source.width - 1 : std::min(x * 2 + 1, source.width - 1);
+
+                float sum[4] = {};
+                uint32_t count = 0;
+                for (uint32_t sy = y0; sy <= y1; ++sy) {
+                    for (uint32_t sx = x0; sx <= x1; ++sx) {
+                        const float *texel = source.at(sx, sy);
+                        for (int c = 0; c < 4; ++c) {
+                            sum[c] += texel[c];
+                        }
+                        ++count;
+                    }
+                }
+
+                float *out = result.at(x, y);
+                for (int c = 0; c < 4; ++c) {
+                    out[c] = sum[c] / count;
+                }
+            }
+        }
+        return result;
+    }
+
+    void generateMipChain(Texture &texture)
+    {
+        for (auto &face : texture.faces) {
+            while (face.back().width > 1 || face.back().height > 1) {
+                face.push_back(downsample(face.back()));
+            }
+        }
+    }
+
+    float halfToFloat(uint16_t h)
+    {
+        uint32_t sign = uint32_t(h & 0x8000) << 16;
+        uint32_t exponent = (h >> 10) & 0x1F;
+        uint32_t mantissa = h & 0x3FF;
+        uint32_t bits;
+
+        if (exponent == 0) {
+            if (mantissa == 0) {
+                bits = sign;
+            } else {
+                // Denormal, renormalize
+                exponent = 127 - 15 + 1;
+                while (!(mantissa & 0x400)) {
+                    mantissa <<= 1;
+                    --exponent;
+                }
+                mantissa &= 0x3FF;
+                bits = sign | (exponent << 23) | (mantissa << 13);
+            }
+        } else if (exponent == 31) {
+            bits = sign | 0x7F800000 | (mantissa << 13);
+        } else {
+            bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+        }
+
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+
+    uint16_t floatToHalf(float f)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+
+        uint16_t sign = uint16_t((bits >> 16) & 0x8000);
+        int32_t exponent = int32_t((bits >> 23) & 0xFF) - 127 + 15;
+        uint32_t mantissa = bits & 0x7FFFFF;
+
+        if (((bits >> 23) & 0xFF) == 0xFF) {
+            return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+        }
+        if (exponent >= 31) {
+            return sign | 0x7BFF;
+        }
+        uint32_t value, remainder, halfway;
+        if (exponent <= 0) {
+            if (exponent < -10) {
+                return sign;
+            }
+            // Denormal half
+            mantissa |= 0x800000;
+            uint32_t shift = uint32_t(14 - exponent);
+            value = mantissa >> shift;
+            remainder = mantissa & ((1u << shift) - 1);
+            halfway = 1u << (shift - 1);
+        } else {
+            value = (uint32_t(exponent) << 10) | (mantissa >> 13);
+            remainder = mantissa & 0x1FFF;
+            halfway = 0x1000;
+        }
+
+        // Round to nearest even, a carry into the exponent is handled by the addition
+        if (remainder > halfway || (remainder == halfway && (value & 1))) {
+            ++value;
+        }
+        return sign | uint16_t(std::min(value, 0x7BFFu));
+    }
+
+    static std::string extensionOf(const std::string &path)
+    {
+        size_t dot = path.find_last_of('.');
+        std::string extension = (dot == std::string::npos) ? "" : path.substr(dot + 1);
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return char(::tolower(c)); });
+        return extension;
+    }
+
+    Texture readTexture(const std::string &path)
+    {
+        std::string extension = extensionOf(path);
+        if (extension == "dds") {
+            return readDds(path);
+        }
+
+        Texture texture;
+        texture.faces.resize(1);
+        if (extension == "jpg" || extension == "jpeg") {
+            texture.faces[0].push_back(readJpeg(path));
+        } else if (extension == "png") {
+            texture.faces[0].push_back(readPng(path));
+        } else {
+            throw std::runtime_error("unsupported file type: " + path);
+        }
+        return texture;
+    }
+
+    std::vector<uint8_t> readFile(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        return std::vector<uint8_t>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    void writeFile(const std::string &path, const std::vector<uint8_t> &data)
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("cannot write " + path);
+        }
+        file.write(reinterpret_cast<const char *>(data.data()), data.size());
+    }
+}
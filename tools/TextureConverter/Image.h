@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace TextureConverter
+{
+    // RGBA float image. LDR sources are stored normalized to [0, 1], HDR sources in linear radiance.
+    struct Image
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<float> pixels;
+
+        Image() = default;
+        Image(uint32_t w, uint32_t h) : width(w), height(h), pixels(size_t(w) * h * 4, 0.0f) {}
+
+        float *at(uint32_t x, uint32_t y) { return &pixels[(size_t(y) * width + x) * 4]; }
+        const float *at(uint32_t x, uint32_t y) const { return &pixels[(size_t(y) * width + x) * 4]; }
+    };
+
+    // A texture is a set of faces (1, or 6 for cubemaps), each with its own mip chain.
+    struct Texture
+    {
+        bool hdr = false;
+        bool cubemap = false;
+        std::vector<std::vector<Image>> faces;
+
+        uint32_t getMipCount() const { return faces.empty() ? 0 : static_cast<uint32_t>(faces[0].size()); }
+    };
+
+    // Half the resolution with a box filter. Odd dimensions fold the last row/column into the previous texel.
+    Image downsample(const Image &source);
+
+    // Appends mips to every face until the last level is 1x1.
+    void generateMipChain(Texture &texture);
+
+    float halfToFloat(uint16_t h);
+    uint16_t floatToHalf(float f);
+
+    // Readers throw std::runtime_error on malformed or unsupported input.
+    Image readJpeg(const std::string &path);
+    Image readPng(const std::string &path);
+    Texture readDds(const std::string &path);
+    Texture readTexture(const std::string &path);
+
+    std::vector<uint8_t> readFile(const std::string &path);
+    void writeFile(const std::string &path, const std::vector<uint8_t> &data);
+}
@@ -0,0 +1,395 @@
+// Baseline (sequential, Huffman coded, 8-bit) JPEG decoder. Progressive and arithmetic coded files are rejected.
+#include "Image.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace TextureConverter
+{
+    namespace
+    {
+        const uint8_t kZigZag[64] = {
+             0,  1,  8, 16,  9,  2,  3, 10,
+            17, 24, 32, 25, 18, 11,  4,  5,
+            12, 19, 26, 33, 40, 48, 41, 34,
+            27, 20, 13,  6,  7, 14, 21, 28,
+            35, 42, 49, 56, 57, 50, 43, 36,
+            29, 22, 15, 23, 30, 37, 44, 51,
+            58, 59, 52, 45, 38, 31, 39, 46,
+            53, 60, 61, 54, 47, 55, 62, 63
+        };
+
+        struct HuffmanTable
+        {
+            // Canonical decoding tables indexed by code length (JPEG spec F.2.2.3)
+            int32_t maxCode[18];
+            int32_t valueOffset[17];
+            std::vector<uint8_t> values;
+            bool defined = false;
+
+            void build(const uint8_t counts[16], const uint8_t *symbols)
+            {
+                int total = 0;
+                for (int i = 0; i < 16; ++i) {
+                    total += counts[i];
+                }
+                values.assign(symbols, symbols + total);
+
+                int32_t code = 0;
+                int k = 0;
+                for (int length = 1; length <= 16; ++length) {
+                    valueOffset[length] = k - code;
+                    code += counts[length - 1];
+                    k += counts[length - 1];
+                    maxCode[length] = counts[length - 1] ? code - 1 : -1;
+                    code <<= 1;
+                }
+                maxCode[17] = INT32_MAX;
+                defined = true;
+            }
+        };
+
+        struct Component
+        {
+            uint8_t id;
+            uint8_t h, v;
+            uint8_t quantTable;
+            uint8_t dcTable = 0, acTable = 0;
+            int32_t dcPredictor = 0;
+            uint32_t blocksPerLine, blocksPerColumn;
+            std::vector<uint8_t> plane;
+        };
+
+        class BitReader
+        {
+        public:
+            BitReader(const uint8_t *data, size_t size) : mData(data), mSize(size) {}
+
+            uint32_t readBit()
+            {
+                if (mBitCount == 0) {
+                    fill();
+                }
+                --mBitCount;
+                return (mBuffer >> mBitCount) & 1;
+            }
+
+            int32_t receive(int length)
+            {
+                int32_t value = 0;
+                for (int i = 0; i < length; ++i) {
+                    value = (value << 1) | int32_t(readBit());
+                }
+                return value;
+            }
+
+            uint8_t decode(const HuffmanTable &table)
+            {
+                int32_t code = 0;
+                for (int length = 1; length <= 16; ++length) {
+                    code = (code << 1) | int32_t(readBit());
+                    if (code <= table.maxCode[length]) {
+                        return table.values[code + table.valueOffset[length]];
+                    }
+                }
+                throw std::runtime_error("jpeg: corrupt Huffman code");
+            }
+
+            // Skips to the byte following the next RSTn marker
+            void restart()
+            {
+                mBitCount = 0;
+                while (mPosition + 1 < mSize && !(mData[mPosition] == 0xFF && mData[mPosition + 1] >= 0xD0 && mData[mPosition + 1] <= 0xD7)) {
+                    ++mPosition;
+                }
+                mPosition += 2;
+            }
+
+            size_t position() const { return mPosition; }
+
+        private:
+            void fill()
+            {
+                uint8_t byte = 0;
+                if (mPosition < mSize) {
+                    byte = mData[mPosition];
+                    if (byte == 0xFF) {
+                        uint8_t next = mPosition + 1 < mSize ? mData[mPosition + 1] : 0;
+                        if (next == 0x00) {
+                            mPosition += 2;
+                        } else {
+                            // Hit a marker, feed zeros until the caller resynchronizes
+                            byte = 0;
+                        }
+                    } else {
+                        ++mPosition;
+                    }
+                }
+                mBuffer = byte;
+                mBitCount = 8;
+            }
+
+            const uint8_t *mData;
+            size_t mSize;
+            size_t mPosition = 0;
+            uint32_t mBuffer = 0;
+            int mBitCount = 0;
+        };
+
+        int32_t extend(int32_t value, int length)
+        {
+            return value < (1 << (length - 1)) ? value - (1 << length) + 1 : value;
+        }
+
+        struct InverseDct
+        {
+            float cosTable[8][8];
+
+            InverseDct()
+            {
+                const float pi = 3.14159265358979f;
+                for (int x = 0; x < 8; ++x) {
+                    for (int u = 0; u < 8; ++u) {
+                        float cu = (u == 0) ? std::sqrt(0.5f) : 1.0f;
+                        cosTable[x][u] = 0.5f * cu * std::cos((2 * x + 1) * u * pi / 16.0f);
+                    }
+                }
+            }
+
+            void transform(const int32_t coefficients[64], uint8_t *out, size_t stride) const
+            {
+                float rows[64];
+                for (int v = 0; v < 8; ++v) {
+                    for (int x = 0; x < 8; ++x) {
+                        float sum = 0.0f;
+                        for (int u = 0; u < 8; ++u) {
+                            sum += cosTable[x][u] * coefficients[v * 8 + u];
+                        }
+                        rows[v * 8 + x] = sum;
+                    }
+                }
+                for (int x = 0; x < 8; ++x) {
+                    for (int y = 0; y < 8; ++y) {
+                        float sum = 0.0f;
+                        for (int v = 0; v < 8; ++v) {
+                            sum += cosTable[y][v] * rows[v * 8 + x];
+                        }
+                        int value = int(std::lround(sum + 128.0f));
+                        out[y * stride + x] = uint8_t(std::min(255, std::max(0, value)));
+                    }
+                }
+            }
+        };
+    }
+
+    Image readJpeg(const std::string &path)
+    {
+        std::vector<uint8_t> data = readFile(path);
+        if (data.size() < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+            throw std::runtime_error("jpeg: missing SOI marker in " + path);
+        }
+
+        uint16_t quantTables[4][64] = {};
+        HuffmanTable dcTables[4], acTables[4];
+        std::vector<Component> components;
+        uint32_t width = 0, height = 0;
+        uint32_t restartInterval = 0;
+        uint8_t hMax = 1, vMax = 1;
+        bool frameDecoded = false;
+        InverseDct idct;
+
+        size_t pos = 2;
+        while (pos + 4 <= data.size() && !frameDecoded) {
+            if (data[pos] != 0xFF) {
+                throw std::runtime_error("jpeg: expected marker in " + path);
+            }
+            uint8_t marker = data[pos + 1];
+            if (marker == 0xFF) {
+                ++pos;
+                continue;
+            }
+            if (marker == 0xD9) {
+                break;
+            }
+            uint32_t length = (data[pos + 2] << 8) | data[pos + 3];
+            const uint8_t *segment = &data[pos + 4];
+            size_t segmentSize = length - 2;
+            if (pos + 2 + length > data.size()) {
+                throw std::runtime_error("jpeg: truncated segment in " + path);
+            }
+
+            switch (marker) {
+            case 0xDB: // DQT
+                for (size_t i = 0; i < segmentSize;) {
+                    uint8_t precision = segment[i] >> 4;
+                    uint8_t id = segment[i] & 3;
+                    ++i;
+                    for (int k = 0; k < 64; ++k) {
+                        quantTables[id][kZigZag[k]] = precision ? uint16_t((segment[i + 2 * k] << 8) | segment[i + 2 * k + 1]) : segment[i + k];
+                    }
+                    i += precision ? 128 : 64;
+                }
+                break;
+            case 0xC4: // DHT
+                for (size_t i = 0; i < segmentSize;) {
+                    uint8_t tableClass = segment[i] >> 4;
+                    uint8_t id = segment[i] & 3;
+                    const uint8_t *counts = &segment[i + 1];
+                    int total = 0;
+                    for (int k = 0; k < 16; ++k) {
+                        total += counts[k];
+                    }
+                    (tableClass ? acTables[id] : dcTables[id]).build(counts, &segment[i + 17]);
+                    i += 17 + total;
+                }
+                break;
+            case 0xDD: // DRI
+                restartInterval = (segment[0] << 8) | segment[1];
+                break;
+            case 0xC0: // SOF0 baseline
+            case 0xC1: // SOF1 extended sequential, Huffman
+                {
+                    if (segment[0] != 8) {
+                        throw std::runtime_error("jpeg: only 8-bit samples are supported in " + path);
+                    }
+                    height = (segment[1] << 8) | segment[2];
+                    width = (segment[3] << 8) | segment[4];
+                    components.resize(segment[5]);
+                    for (size_t c = 0; c < components.size(); ++c) {
+                        components[c].id = segment[6 + c * 3];
+                        components[c].h = segment[7 + c * 3] >> 4;
+                        components[c].v = segment[7 + c * 3] & 15;
+                        components[c].quantTable = segment[8 + c * 3] & 3;
+                        hMax = std::max(hMax, components[c].h);
+                        vMax = std::max(vMax, components[c].v);
+                    }
+                }
+                break;
+            case 0xC2: case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+            case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+                throw std::runtime_error("jpeg: only baseline sequential files are supported, convert " + path);
+            case 0xDA: // SOS
+                {
+                    if (components.empty()) {
+                        throw std::runtime_error("jpeg: scan before frame header in " + path);
+                    }
+                    uint8_t scanComponentCount = segment[0];
+                    if (scanComponentCount != components.size()) {
+                        throw std::runtime_error("jpeg: non-interleaved scans are not supported in " + path);
+                    }
+                    for (uint8_t s = 0; s < scanComponentCount; ++s) {
+                        for (auto &component : components) {
+                            if (component.id == segment[1 + s * 2]) {
+                                component.dcTable = segment[2 + s * 2] >> 4;
+                                component.acTable = segment[2 + s * 2] & 15;
+                            }
+                        }
+                    }
+
+                    uint32_t mcuWidth = 8 * hMax, mcuHeight = 8 * vMax;
+                    uint32_t mcusPerLine = (width + mcuWidth - 1) / mcuWidth;
+                    uint32_t mcusPerColumn = (height + mcuHeight - 1) / mcuHeight;
+                    for (auto &component : components) {
+                        component.blocksPerLine = mcusPerLine * component.h;
+                        component.blocksPerColumn = mcusPerColumn * component.v;
+                        component.plane.assign(size_t(component.blocksPerLine) * 8 * component.blocksPerColumn * 8, 0);
+                    }
+
+                    size_t scanStart = pos + 2 + length;
+                    BitReader reader(&data[scanStart], data.size() - scanStart);
+                    int32_t coefficients[64];
+                    uint32_t mcuCount = mcusPerLine * mcusPerColumn;
+
+                    for (uint32_t mcu = 0; mcu < mcuCount; ++mcu) {
+                        if (restartInterval && mcu && mcu % restartInterval == 0) {
+                            reader.restart();
+                            for (auto &component : components) {
+                                component.dcPredictor = 0;
+                            }
+                        }
+
+                        uint32_t mcuX = mcu % mcusPerLine, mcuY = mcu / mcusPerLine;
+                        for (auto &component : components) {
+                            const HuffmanTable &dc = dcTables[component.dcTable];
+                            const HuffmanTable &ac = acTables[component.acTable];
+                            const uint16_t *quant = quantTables[component.quantTable];
+                            size_t stride = size_t(component.blocksPerLine) * 8;
+
+                            for (uint32_t by = 0; by < component.v; ++by) {
+                                for (uint32_t bx = 0; bx < component.h; ++bx) {
+                                    std::memset(coefficients, 0, sizeof(coefficients));
+
+                                    uint8_t category = reader.decode(dc);
+                                    int32_t diff = category ? extend(reader.receive(category), category) : 0;
+                                    component.dcPredictor += diff;
+                                    coefficients[0] = component.dcPredictor * quant[0];
+
+                                    for (int k = 1; k < 64;) {
+                                        uint8_t symbol = reader.decode(ac);
+                                        uint8_t run = symbol >> 4, size = symbol & 15;
+                                        if (size == 0) {
+                                            if (run != 15) {
+                                                break; // EOB
+                                            }
+                                            k += 16;
+                                            continue;
+                                        }
+                                        k += run;
+                                        if (k > 63) {
+                                            throw std::runtime_error("jpeg: coefficient index out of range in " + path);
+                                        }
+                                        coefficients[kZigZag[k]] = extend(reader.receive(size), size) * quant[kZigZag[k]];
+                                        ++k;
+                                    }
+
+                                    size_t blockX = (mcuX * component.h + bx) * 8;
+                                    size_t blockY = (mcuY * component.v + by) * 8;
+                                    idct.transform(coefficients, &component.plane[blockY * stride + blockX], stride);
+                                }
+                            }
+                        }
+                    }
+                    frameDecoded = true;
+                }
+                break;
+            default:
+                break;
+            }
+            pos += 2 + length;
+        }
+
+        if (!frameDecoded) {
+            throw std::runtime_error("jpeg: no image data in " + path);
+        }
+
+        // Upsample chroma by replication and convert JFIF YCbCr to RGB
+        Image image(width, height);
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                float samples[3] = {};
+                for (size_t c = 0; c < components.size() && c < 3; ++c) {
+                    const Component &component = components[c];
+                    uint32_t sx = x * component.h / hMax;
+                    uint32_t sy = y * component.v / vMax;
+                    samples[c] = component.plane[size_t(sy) * component.blocksPerLine * 8 + sx];
+                }
+
+                float *out = image.at(x, y);
+                if (components.size() >= 3) {
+                    float Y = samples[0], cb = samples[1] - 128.0f, cr = samples[2] - 128.0f;
+                    out[0] = Y + 1.402f * cr;
+                    out[1] = Y - 0.344136f * cb - 0.714136f * cr;
+                    out[2] = Y + 1.772f * cb;
+                } else {
+                    out[0] = out[1] = out[2] = samples[0];
+                }
+                for (int c = 0; c < 3; ++c) {
+                    out[c] = std::min(255.0f, std::max(0.0f, std::round(out[c]))) / 255.0f;
+                }
+                out[3] = 1.0f;
+            }
+        }
+        return image;
+    }
+}
@@ -0,0 +1,359 @@
+// Non-interlaced PNG decoder with a self-contained inflate. Supports 8 and 16-bit gray, RGB, palette and alpha variants.
+#include "Image.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace TextureConverter
+{
+    namespace
+    {
+        class Inflater
+        {
+        public:
+            Inflater(const uint8_t *data, size_t size) : mData(data), mSize(size) {}
+
+            std::vector<uint8_t> run()
+            {
+                // zlib header: CM = 8, no preset dictionary
+                if (mSize < 2 || (mData[0] & 15) != 8 || (mData[1] & 0x20)) {
+                    throw std::runtime_error("png: unsupported zlib stream");
+                }
+                mPosition = 2;
+
+                bool last = false;
+                while (!last) {
+                    last = readBits(1) != 0;
+                    uint32_t type = readBits(2);
+                    if (type == 0) {
+                        storedBlock();
+                    } else if (type == 1) {
+                        fixedTables();
+                        compressedBlock();
+                    } else if (type == 2) {
+                        dynamicTables();
+                        compressedBlock();
+                    } else {
+                        throw std::runtime_error("png: invalid deflate block");
+                    }
+                }
+                return std::move(mOutput);
+            }
+
+        private:
+            struct Huffman
+            {
+                uint16_t counts[16];
+                uint16_t symbols[288];
+
+                void build(const uint8_t *lengths, int count)
+                {
+                    std::fill(counts, counts + 16, uint16_t(0));
+                    for (int i = 0; i < count; ++i) {
+                        counts[lengths[i]]++;
+                    }
+                    counts[0] = 0;
+
+                    uint16_t offsets[16];
+                    offsets[1] = 0;
+                    for (int i = 1; i < 15; ++i) {
+                        offsets[i + 1] = offsets[i] + counts[i];
+                    }
+                    for (int i = 0; i < count; ++i) {
+                        if (lengths[i]) {
+                            symbols[offsets[lengths[i]]++] = uint16_t(i);
+                        }
+                    }
+                }
+            };
+
+            uint32_t readBits(int count)
+            {
+                while (mBitCount < count) {
+                    if (mPosition >= mSize) {
+                        throw std::runtime_error("png: truncated deflate stream");
+                    }
+                    mBitBuffer |= uint32_t(mData[mPosition++]) << mBitCount;
+                    mBitCount += 8;
+                }
+                uint32_t value = mBitBuffer & ((1u << count) - 1);
+                mBitBuffer >>= count;
+                mBitCount -= count;
+                return value;
+            }
+
+            int decode(const Huffman &table)
+            {
+                // Canonical codes are stored MSB first, read one bit at a time
+                int code = 0, first = 0, index = 0;
+                for (int length = 1; length < 16; ++length) {
+                    code |= int(readBits(1));
+                    int count = table.counts[length];
+                    if (code - count < first) {
+                        return table.symbols[index + (code - first)];
+                    }
+                    index += count;
+                    first += count;
+                    first <<= 1;
+                    code <<= 1;
+                }
+                throw std::runtime_error("png: corrupt Huffman code");
+            }
+
+            void storedBlock()
+            {
+                mBitBuffer = 0;
+                mBitCount = 0;
+                if (mPosition + 4 > mSize) {
+                    throw std::runtime_error("png: truncated stored block");
+                }
+                uint32_t length = mData[mPosition] | (mData[mPosition + 1] << 8);
+                mPosition += 4;
+                if (mPosition + length > mSize) {
+                    throw std::runtime_error("png: truncated stored block");
+                }
+                mOutput.insert(mOutput.end(), mData + mPosition, mData + mPosition + length);
+                mPosition += length;
+            }
+
+            void fixedTables()
+            {
+                uint8_t lengths[288];
+                int i = 0;
+                for (; i < 144; ++i) lengths[i] = 8;
+                for (; i < 256; ++i) lengths[i] = 9;
+                for (; i < 280; ++i) lengths[i] = 7;
+                for (; i < 288; ++i) lengths[i] = 8;
+                mLiteralTable.build(lengths, 288);
+
+                for (i = 0; i < 30; ++i) lengths[i] = 5;
+                mDistanceTable.build(lengths, 30);
+            }
+
+            void dynamicTables()
+            {
+                static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+                int literalCount = int(readBits(5)) + 257;
+                int distanceCount = int(readBits(5)) + 1;
+                int codeLengthCount = int(readBits(4)) + 4;
+
+                uint8_t codeLengths[19] = {};
+                for (int i = 0; i < codeLengthCount; ++i) {
+                    codeLengths[order[i]] = uint8_t(readBits(3));
+                }
+                Huffman codeLengthTable;
+                codeLengthTable.build(codeLengths, 19);
+
+                uint8_t lengths[288 + 32] = {};
+                for (int i = 0; i < literalCount + distanceCount;) {
+                    int symbol = decode(codeLengthTable);
+                    if (symbol < 16) {
+                        lengths[i++] = uint8_t(symbol);
+                        continue;
+                    }
+                    int repeat = 0;
+                    uint8_t value = 0;
+                    if (symbol == 16) {
+                        if (i == 0) {
+                            throw std::runtime_error("png: invalid code length repeat");
+                        }
+                        value = lengths[i - 1];
+                        repeat = 3 + int(readBits(2));
+                    } else if (symbol == 17) {
+                        repeat = 3 + int(readBits(3));
+                    } else {
+                        repeat = 11 + int(readBits(7));
+                    }
+                    if (i + repeat > literalCount + distanceCount) {
+                        throw std::runtime_error("png: code lengths overflow");
+                    }
+                    std::fill(lengths + i, lengths + i + repeat, value);
+                    i += repeat;
+                }
+
+                mLiteralTable.build(lengths, literalCount);
+                mDistanceTable.build(lengths + literalCount, distanceCount);
+            }
+
+            void compressedBlock()
+            {
+                static const uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+                static const uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+                static const uint16_t distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+                static const uint8_t distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+                while (true) {
+                    int symbol = decode(mLiteralTable);
+                    if (symbol < 256) {
+                        mOutput.push_back(uint8_t(symbol));
+                        continue;
+                    }
+                    if (symbol == 256) {
+                        return;
+                    }
+                    symbol -= 257;
+                    if (symbol >= 29) {
+                        throw std::runtime_error("png: invalid length symbol");
+                    }
+                    size_t length = lengthBase[symbol] + readBits(lengthExtra[symbol]);
+                    int distanceSymbol = decode(mDistanceTable);
+                    if (distanceSymbol >= 30) {
+                        throw std::runtime_error("png: invalid distance symbol");
+                    }
+                    size_t distance = distanceBase[distanceSymbol] + readBits(distanceExtra[distanceSymbol]);
+                    if (distance > mOutput.size()) {
+                        throw std::runtime_error("png: distance too far back");
+                    }
+                    size_t from = mOutput.size() - distance;
+                    for (size_t i = 0; i < length; ++i) {
+                        mOutput.push_back(mOutput[from + i]);
+                    }
+                }
+            }
+
+            const uint8_t *mData;
+            size_t mSize;
+            size_t mPosition = 0;
+            uint32_t mBitBuffer = 0;
+            int mBitCount = 0;
+            Huffman mLiteralTable, mDistanceTable;
+            std::vector<uint8_t> mOutput;
+        };
+
+        uint32_t readBigEndian(const uint8_t *p)
+        {
+            return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+        }
+
+        uint8_t paeth(int a, int b, int c)
+        {
+            int p = a + b - c;
+            int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+            if (pa <= pb && pa <= pc) return uint8_t(a);
+            if (pb <= pc) return uint8_t(b);
+            return uint8_t(c);
+        }
+    }
+
+    Image readPng(const std::string &path)
+    {
+        static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+        std::vector<uint8_t> data = readFile(path);
+        if (data.size() < 8 || !std::equal(signature, signature + 8, data.begin())) {
+            throw std::runtime_error("png: bad signature in " + path);
+        }
+
+        uint32_t width = 0, height = 0;
+        uint8_t bitDepth = 0, colorType = 0, interlace = 0;
+        std::vector<uint8_t> palette, compressed;
+
+        for (size_t pos = 8; pos + 12 <= data.size();) {
+            uint32_t length = readBigEndian(&data[pos]);
+            std::string type(reinterpret_cast<const char *>(&data[pos + 4]), 4);
+            const uint8_t *chunk = &data[pos + 8];
+            if (pos + 12 + length > data.size()) {
+                throw std::runtime_error("png: truncated chunk in " + path);
+            }
+
+            if (type == "IHDR") {
+                width = readBigEndian(chunk);
+                height = readBigEndian(chunk + 4);
+                bitDepth = chunk[8];
+                colorType = chunk[9];
+                interlace = chunk[12];
+            } else if (type == "PLTE") {
+                palette.assign(chunk, chunk + length);
+            } else if (type == "IDAT") {
+                compressed.insert(compressed.end(), chunk, chunk + length);
+            } else if (type == "IEND") {
+                break;
+            }
+            pos += 12 + length;
+        }
+
+        if (interlace) {
+            throw std::runtime_error("png: interlaced images are not supported in " + path);
+        }
+        if (bitDepth != 8 && bitDepth != 16) {
+            throw std::runtime_error("png: only 8 and 16-bit images are supported in " + path);
+        }
+
+        uint32_t channels;
+        switch (colorType) {
+        case 0: channels = 1; break;
+        case 2: channels = 3; break;
+        case 3: channels = 1; break;
+        case 4: channels = 2; break;
+        case 6: channels = 4; break;
+        default: throw std::runtime_error("png: invalid color type in " + path);
+        }
+        if (colorType == 3 && bitDepth != 8) {
+            throw std::runtime_error("png: 16-bit palette images are invalid in " + path);
+        }
+
+        std::vector<uint8_t> raw = Inflater(compressed.data(), compressed.size()).run();
+        size_t bytesPerPixel = channels * bitDepth / 8;
+        size_t stride = size_t(width) * bytesPerPixel;
+        if (raw.size() < (stride + 1) * height) {
+            throw std::runtime_error("png: not enough image data in " + path);
+        }
+
+        // Undo the per-scanline filters in place
+        std::vector<uint8_t> pixels(stride * height);
+        for (uint32_t y = 0; y < height; ++y) {
+            uint8_t filter = raw[y * (stride + 1)];
+            const uint8_t *in = &raw[y * (stride + 1) + 1];
+            uint8_t *out = &pixels[y * stride];
+            const uint8_t *previous = y ? &pixels[(y - 1) * stride] : nullptr;
+
+            for (size_t i = 0; i < stride; ++i) {
+                int a = i >= bytesPerPixel ? out[i - bytesPerPixel] : 0;
+                int b = previous ? previous[i] : 0;
+                int c = (previous && i >= bytesPerPixel) ? previous[i - bytesPerPixel] : 0;
+                switch (filter) {
+                case 0: out[i] = in[i]; break;
+                case 1: out[i] = uint8_t(in[i] + a); break;
+                case 2: out[i] = uint8_t(in[i] + b); break;
+                case 3: out[i] = uint8_t(in[i] + ((a + b) >> 1)); break;
+                case 4: out[i] = uint8_t(in[i] + paeth(a, b, c)); break;
+                default: throw std::runtime_error("png: invalid filter type in " + path);
+                }
+            }
+        }
+
+        Image image(width, height);
+        float maxValue = bitDepth == 16 ? 65535.0f : 255.0f;
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                const uint8_t *p = &pixels[y * stride + x * bytesPerPixel];
+                float values[4];
+                for (uint32_t c = 0; c < channels; ++c) {
+                    values[c] = (bitDepth == 16 ? float((p[c * 2] << 8) | p[c * 2 + 1]) : float(p[c])) / maxValue;
+                }
+
+                float *out = image.at(x, y);
+                switch (colorType) {
+                case 0: out[0] = out[1] = out[2] = values[0]; out[3] = 1.0f; break;
+                case 2: out[0] = values[0]; out[1] = values[1]; out[2] = values[2]; out[3] = 1.0f; break;
+                case 4: out[0] = out[1] = out[2] = values[0]; out[3] = values[1]; break;
+                case 6: std::copy(values, values + 4, out); break;
+                case 3:
+                    {
+                        size_t index = p[0];
+                        if (index * 3 + 2 >= palette.size()) {
+                            throw std::runtime_error("png: palette index out of range in " + path);
+                        }
+                        for (int c = 0; c < 3; ++c) {
+                            out[c] = palette[index * 3 + c] / 255.0f;
+                        }
+                        out[3] = 1.0f;
+                    }
+                    break;
+                }
+            }
+        }
+        return image;
+    }
+}
@@ -0,0 +1,172 @@
+// Offline converter from source textures (JPG, PNG, uncompressed DDS) to GPU-ready block compressed DDS files.
+//
+// LDR images become BC7 with a generated box-filtered mip chain. Floating point DDS files become BC6H;
+// their authored mip chain (e.g. prefiltered radiance) is kept, a full chain is generated only when the
+// source has a single level. The output is written next to the source as "<name>.bc.dds", which
+// TextureCache picks up in place of the source when it is at least as new.
+//
+// The tool has no platform dependencies. Build it with
+//     g++ -std=c++14 -O2 -pthread tools/TextureConverter/*.cpp -o TextureConverter
+//     cl /std:c++14 /O2 /EHsc tools\TextureConverter\*.cpp /Fe:TextureConverter.exe
+//
+// Usage: TextureConverter [--threads N] [--no-verify] <input>...
+#include "Image.h"
+#include "DdsFile.h"
+#include "BlockCompression.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+using namespace TextureConverter;
+
+namespace
+{
+    struct Quality
+    {
+        double sumSquaredError = 0.0;
+        double sumSquaredLogError = 0.0;
+        double maxError = 0.0;
+        size_t samples = 0;
+    };
+
+    void accumulateQuality(const Image &reference, const Image &decoded, bool hdr, Quality &quality)
+    {
+        int channels = hdr ? 3 : 4;
+        for (size_t i = 0; i < size_t(reference.width) * reference.height; ++i) {
+            for (int c = 0; c < channels; ++c) {
+                double expected = reference.pixels[i * 4 + c];
+                double actual = decoded.pixels[i * 4 + c];
+                if (!hdr) {
+                    // Compare against the 8-bit values the GPU would otherwise sample
+                    expected = std::round(std::min(1.0, std::max(0.0, expected)) * 255.0);
+                    actual = std::round(actual * 255.0);
+                }
+                double error = std::fabs(expected - actual);
+                double logError = std::log2(1.0 + std::max(0.0, expected)) - std::log2(1.0 + std::max(0.0, actual));
+                quality.sumSquaredError += error * error;
+                quality.sumSquaredLogError += logError * logError;
+                quality.maxError = std::max(quality.maxError, error);
+                quality.samples++;
+            }
+        }
+    }
+
+    std::string convertedPathFor(const std::string &path)
+    {
+        size_t dot = path.find_last_of('.');
+        size_t slash = path.find_last_of("\\/");
+        std::string stem = (dot == std::string::npos || (slash != std::string::npos && dot < slash)) ? path : path.substr(0, dot);
+        return stem + ".bc.dds";
+    }
+
+    double megabytes(double bytes) { return bytes / (1024.0 * 1024.0); }
+
+    void convert(const std::string &path, uint32_t threadCount, bool verify)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        auto elapsedMs = [&start]() {
+            return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        };
+
+        Texture texture = readTexture(path);
+        double decodeMs = elapsedMs();
+
+        bool generatedMips = texture.getMipCount() == 1;
+        if (generatedMips) {
+            generateMipChain(texture);
+        }
+        double mipMs = elapsedMs() - decodeMs;
+
+        uint32_t format = texture.hdr ? DXGI_FORMAT_BC6H_UF16 : DXGI_FORMAT_BC7_UNORM;
+        CompressedTexture compressed = compressTexture(texture, format, threadCount);
+        double encodeMs = elapsedMs() - decodeMs - mipMs;
+
+        std::string outputPath = convertedPathFor(path);
+        std::vector<uint8_t> file = writeDds(compressed);
+        writeFile(outputPath, file);
+
+        // Size of the uncompressed texture the runtime would otherwise create (RGBA8 or RGBA16F)
+        double uncompressedBytes = 0.0;
+        for (auto &face : texture.faces) {
+            for (auto &image : face) {
+                uncompressedBytes += double(image.width) * image.height * (texture.hdr ? 8 : 4);
+            }
+        }
+
+        const Image &top = texture.faces[0][0];
+        std::printf("%s -> %s\n", path.c_str(), outputPath.c_str());
+        std::printf("  %ux%u%s, %u mips%s, %s\n", top.width, top.height, texture.cubemap ? " cube" : "",
+            texture.getMipCount(), generatedMips ? " (generated)" : " (from source)", texture.hdr ? "BC6H_UF16" : "BC7_UNORM");
+        std::printf("  size: source file %.2f MB, uncompressed %.2f MB, converted %.2f MB (%.1f:1)\n",
+            megabytes(double(readFile(path).size())), megabytes(uncompressedBytes), megabytes(double(file.size())), uncompressedBytes / file.size());
+        std::printf("  time: decode %.0f ms, mips %.0f ms, encode %.0f ms\n", decodeMs, mipMs, encodeMs);
+
+        if (!verify) {
+            return;
+        }
+
+        size_t subresource = 0;
+        Quality total;
+        for (auto &face : texture.faces) {
+            for (uint32_t mip = 0; mip < face.size(); ++mip) {
+                const Image &reference = face[mip];
+                Image decoded = decompressImage(compressed.subresources[subresource++], format, reference.width, reference.height);
+                Quality quality;
+                accumulateQuality(reference, decoded, texture.hdr, quality);
+                accumulateQuality(reference, decoded, texture.hdr, total);
+
+                if (&face == &texture.faces[0] && mip < 3) {
+                    double mse = quality.sumSquaredError / quality.samples;
+                    if (texture.hdr) {
+                        std::printf("  mip %u: RMSE %.4f, log2 RMSE %.4f, max error %.3f\n", mip, std::sqrt(mse), std::sqrt(quality.sumSquaredLogError / quality.samples), quality.maxError);
+                    } else {
+                        std::printf("  mip %u: PSNR %.2f dB, max error %.0f\n", mip, 10.0 * std::log10(255.0 * 255.0 / std::max(mse, 1e-10)), quality.maxError);
+                    }
+                }
+            }
+        }
+
+        double mse = total.sumSquaredError / total.samples;
+        if (texture.hdr) {
+            std::printf("  all subresources: RMSE %.4f, log2 RMSE %.4f\n", std::sqrt(mse), std::sqrt(total.sumSquaredLogError / total.samples));
+        } else {
+            std::printf("  all subresources: PSNR %.2f dB\n", 10.0 * std::log10(255.0 * 255.0 / std::max(mse, 1e-10)));
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t threadCount = 0;
+    bool verify = true;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) {
+            threadCount = uint32_t(std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--no-verify")) {
+            verify = false;
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+
+    if (inputs.empty()) {
+        std::fprintf(stderr, "usage: TextureConverter [--threads N] [--no-verify] <input>...\n");
+        return 1;
+    }
+
+    int failures = 0;
+    for (auto &input : inputs) {
+        try {
+            convert(input, threadCount, verify);
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "error: %s\n", e.what());
+            ++failures;
+        }
+    }
+    return failures ? 1 : 0;
+}